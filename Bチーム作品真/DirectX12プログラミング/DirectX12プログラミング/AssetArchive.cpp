@@ -0,0 +1,130 @@
+﻿#include "AssetArchive.h"
+#include <string>
+#include <cstdio>
+#include <cassert>
+
+// 静的メンバ変数の実体を宣言
+HANDLE AssetArchive::s_fileHandle = INVALID_HANDLE_VALUE;
+HANDLE AssetArchive::s_mappingHandle = nullptr;
+const uint8_t* AssetArchive::s_mappedView = nullptr;
+uint64_t AssetArchive::s_archiveSize = 0;
+std::atomic<uint32_t> AssetArchive::s_findCount(0);
+std::atomic<uint32_t> AssetArchive::s_hitCount(0);
+std::atomic<uint64_t> AssetArchive::s_hitBytes(0);
+
+
+bool AssetArchive::Mount(const wchar_t* archiveFilePath)
+{
+    Unmount();
+
+    s_fileHandle = CreateFileW(archiveFilePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (s_fileHandle == INVALID_HANDLE_VALUE)
+    {
+        printf("[情報] アセットアーカイブが無いので、個別のファイルから読み込みます (%ls)\n", archiveFilePath);
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(s_fileHandle, &fileSize) || (fileSize.QuadPart == 0))
+    {
+        printf("[警告] アセットアーカイブのサイズを取得できませんでした (%ls)\n", archiveFilePath);
+        Unmount();
+        return false;
+    }
+    s_archiveSize = (uint64_t)fileSize.QuadPart;
+
+    // アーカイブ全体を読み取り専用でマップする (中身はページに触れたときに読み込まれる)
+    s_mappingHandle = CreateFileMappingW(s_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (s_mappingHandle)
+    {
+        s_mappedView = (const uint8_t*)MapViewOfFile(s_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (!s_mappedView)
+    {
+        printf("[警告] アセットアーカイブをメモリマップできませんでした (%ls)\n", archiveFilePath);
+        Unmount();
+        return false;
+    }
+
+    if (!AssetArchiveFormat::Validate(s_mappedView, s_archiveSize))
+    {
+        printf("[警告] アセットアーカイブが壊れているか、形式が古いので使用しません (%ls)\n", archiveFilePath);
+        Unmount();
+        return false;
+    }
+
+    const AssetArchiveHeader* header = (const AssetArchiveHeader*)s_mappedView;
+    printf("[成功] アセットアーカイブのマウント (%ls, %u 個, %llu バイト)\n", archiveFilePath, header->entryCount, (unsigned long long)s_archiveSize);
+    return true;
+}
+
+
+void AssetArchive::Unmount()
+{
+    if (s_mappedView)
+    {
+        UnmapViewOfFile(s_mappedView);
+        s_mappedView = nullptr;
+    }
+    if (s_mappingHandle)
+    {
+        CloseHandle(s_mappingHandle);
+        s_mappingHandle = nullptr;
+    }
+    if (s_fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(s_fileHandle);
+        s_fileHandle = INVALID_HANDLE_VALUE;
+    }
+    s_archiveSize = 0;
+}
+
+
+std::span<const std::byte> AssetArchive::Find(const wchar_t* path)
+{
+    if (!s_mappedView)
+    {
+        return {};
+    }
+    s_findCount++;
+
+    // アーカイブのパスはUTF-8なので変換してから正規化する
+    const int utf8Length = WideCharToMultiByte(CP_UTF8, 0, path, -1, nullptr, 0, nullptr, nullptr);
+    if (utf8Length <= 0)
+    {
+        return {};
+    }
+    std::string utf8Path((size_t)utf8Length, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, path, -1, utf8Path.data(), utf8Length, nullptr, nullptr);
+    utf8Path.resize((size_t)utf8Length - 1);
+
+    const AssetArchiveEntry* entry = AssetArchiveFormat::FindEntry(s_mappedView, AssetArchiveFormat::NormalizePath(utf8Path));
+    if (!entry)
+    {
+        return {};
+    }
+
+    s_hitCount++;
+    s_hitBytes += entry->size;
+    return std::span<const std::byte>((const std::byte*)(s_mappedView + entry->offset), (size_t)entry->size);
+}
+
+
+AssetArchiveStats AssetArchive::GetStats()
+{
+    AssetArchiveStats stats;
+    stats.entryCount = s_mappedView ? ((const AssetArchiveHeader*)s_mappedView)->entryCount : 0;
+    stats.archiveBytes = s_archiveSize;
+    stats.findCount = s_findCount.load();
+    stats.hitCount = s_hitCount.load();
+    stats.hitBytes = s_hitBytes.load();
+    return stats;
+}
+
+
+void AssetArchive::PrintStats()
+{
+    const AssetArchiveStats stats = GetStats();
+    printf("[情報] アセットアーカイブ : %u 個 (%.2f MB) / 検索 %u 回 / ヒット %u 回 (%.2f MB)\n",
+        stats.entryCount, stats.archiveBytes / (1024.0 * 1024.0), stats.findCount, stats.hitCount, stats.hitBytes / (1024.0 * 1024.0));
+}
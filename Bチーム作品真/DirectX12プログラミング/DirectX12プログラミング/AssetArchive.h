@@ -0,0 +1,63 @@
+﻿#pragma once
+#include "AssetArchiveFormat.h"
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <atomic>
+
+// アセットアーカイブの統計情報
+struct AssetArchiveStats
+{
+    uint32_t entryCount;                // アーカイブに入っているファイルの数
+    uint64_t archiveBytes;              // アーカイブファイルのサイズ (単位はバイト)
+    uint32_t findCount;                 // Find() を呼び出した回数
+    uint32_t hitCount;                  // アーカイブに見つかった回数
+    uint64_t hitBytes;                  // 見つかったファイルのサイズの合計 (単位はバイト)
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// アセットアーカイブクラス
+//
+//      ・アセットパッカー(Tools/AssetPacker)で1つにまとめたアセットアーカイブをメモリマップして、中のファイルを読み出すクラス。
+//      ・Find() はアーカイブをマップしたメモリをそのまま指す std::span を返す。 (ファイルを開かず、コピーもしない)
+//        実際の読み込みは、返されたメモリに初めて触れたときにOSがページ単位で行う。
+//      ・パスの正規化と検索の方法は AssetArchiveFormat.h を参照。
+//      ・Find() はどのスレッドからでも呼び出せる。 Mount() と Unmount() はメインスレッドから、ロード中でないときに呼び出す。
+//      ・モノステートパターンで実装されている(全てのメンバがstatic)。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class AssetArchive
+{
+private:
+    static HANDLE s_fileHandle;                     // アーカイブファイルのハンドル
+    static HANDLE s_mappingHandle;                  // ファイルマッピングオブジェクトのハンドル
+    static const uint8_t* s_mappedView;             // アーカイブ全体をマップしたアドレス (マウントしていない場合は nullptr)
+    static uint64_t s_archiveSize;                  // アーカイブファイルのサイズ (単位はバイト)
+    static std::atomic<uint32_t> s_findCount;       // Find() を呼び出した回数
+    static std::atomic<uint32_t> s_hitCount;        // アーカイブに見つかった回数
+    static std::atomic<uint64_t> s_hitBytes;        // 見つかったファイルのサイズの合計
+
+public:
+    // アーカイブファイルをメモリマップします。 (既にマウントしている場合は、先にアンマウントします)
+    //       戻り値 : 成否を表すbool型の値 (ファイルが無い場合や壊れている場合は false を返し、Find() は常に空を返します)
+    static bool Mount(const wchar_t* archiveFilePath);
+
+    // アーカイブファイルのマップを解除します。
+    //   ・Find() で受け取ったメモリは使えなくなるので、それを読んでいるロードが全て完了してから呼び出してください。
+    static void Unmount();
+
+    // マウントしている場合は true を返します。
+    static bool IsMounted() { return s_mappedView != nullptr; }
+
+    // アーカイブからファイルを探します。
+    //       戻り値 : ファイルの中身を指すメモリ (見つからない場合やマウントしていない場合は空)
+    static std::span<const std::byte> Find(const wchar_t* path);
+
+    // 統計情報を取得します。
+    static AssetArchiveStats GetStats();
+
+    // 統計情報をコンソールに出力します。
+    static void PrintStats();
+};
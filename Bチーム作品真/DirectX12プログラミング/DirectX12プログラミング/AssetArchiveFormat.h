@@ -0,0 +1,161 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ※注意
+//
+//  このヘッダーはゲーム本体とアセットパッカー(Tools/AssetPacker)の両方から使われる。
+//  Windows や D3D12 のヘッダーに依存しないこと。 (標準ライブラリのみを使用する)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// アセットアーカイブファイルの先頭に置かれるヘッダー
+struct AssetArchiveHeader
+{
+    uint32_t magic;                     // ファイル識別子 (AssetArchiveFormat::FileMagic)
+    uint32_t version;                   // ファイル形式のバージョン (AssetArchiveFormat::FileVersion)
+    uint32_t entryCount;                // 目次の項目数
+    uint32_t reserved;                  // 予約 (0)
+    uint64_t tocOffset;                 // 目次(AssetArchiveEntry の配列)のファイル先頭からの位置
+    uint64_t pathTableOffset;           // パス文字列表(正規化したパスを連結したもの)のファイル先頭からの位置
+    uint64_t pathTableSize;             // パス文字列表のサイズ (単位はバイト)
+    uint64_t fileSize;                  // アーカイブファイル全体のサイズ (途中で切れたファイルの検出用)
+};
+
+
+// 目次の項目 (パスのハッシュ値の昇順に並ぶ)
+struct AssetArchiveEntry
+{
+    uint64_t pathHash;                  // 正規化したパスのハッシュ値
+    uint64_t offset;                    // ファイルの中身のファイル先頭からの位置 (AssetArchiveFormat::DataAlignment の倍数)
+    uint64_t size;                      // ファイルの中身のサイズ (単位はバイト)
+    uint32_t pathOffset;                // パス文字列表内での、正規化したパスの位置
+    uint32_t pathLength;                // 正規化したパスの長さ (単位はバイト。 終端文字を含まない)
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// アセットアーカイブ形式クラス
+//
+//      ・アセットアーカイブのファイル形式(ヘッダー → 目次 → パス文字列表 → ファイルの中身)と、パスの検索方法を定義するクラス。
+//      ・パスはUTF-8で扱い、区切り文字を '/' に揃え、"." や ".." を取り除き、英字を小文字にしてからハッシュ値(FNV-1a 64ビット)を計算する。
+//        (Windowsのパスは大文字小文字を区別しない為)
+//      ・ファイルの中身は4KiB境界に置くので、マップしたアドレスからそのままページ単位で読み込まれる。
+//      ・目次はハッシュ値で二分探索し、ハッシュ値が同じ項目はパス文字列を比べて確かめる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class AssetArchiveFormat
+{
+public:
+    static constexpr uint32_t FileMagic = 0x4B415041;   // 'A' 'P' 'A' 'K'
+    static constexpr uint32_t FileVersion = 1;
+    static constexpr uint64_t DataAlignment = 4096;     // ファイルの中身のアラインメント (単位はバイト)
+
+public:
+    // UTF-8のパスを正規化します。
+    static std::string NormalizePath(const std::string& path)
+    {
+        std::vector<std::string> segments;
+        std::string segment;
+        for (size_t i = 0; i <= path.size(); i++)
+        {
+            const char c = (i < path.size()) ? path[i] : '/';
+            if (c != '/' && c != '\\')
+            {
+                segment += ((c >= 'A') && (c <= 'Z')) ? (char)(c - 'A' + 'a') : c;
+                continue;
+            }
+
+            if (segment == "..")
+            {
+                if (!segments.empty())
+                {
+                    segments.pop_back();
+                }
+            }
+            else if (!segment.empty() && (segment != "."))
+            {
+                segments.push_back(segment);
+            }
+            segment.clear();
+        }
+
+        std::string normalizedPath;
+        for (const std::string& s : segments)
+        {
+            if (!normalizedPath.empty())
+            {
+                normalizedPath += '/';
+            }
+            normalizedPath += s;
+        }
+        return normalizedPath;
+    }
+
+    // 正規化したパスのハッシュ値を計算します。
+    static uint64_t ComputePathHash(const std::string& normalizedPath)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (const char c : normalizedPath)
+        {
+            hash ^= (uint8_t)c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // アーカイブ全体のヘッダーと目次が正しいか確かめます。 (マップした直後に1回だけ呼び出してください)
+    //       戻り値 : 正しい場合は true
+    static bool Validate(const uint8_t* archive, uint64_t archiveSize)
+    {
+        if (archiveSize < sizeof(AssetArchiveHeader))
+        {
+            return false;
+        }
+
+        const AssetArchiveHeader* header = (const AssetArchiveHeader*)archive;
+        if ((header->magic != FileMagic) || (header->version != FileVersion) || (header->fileSize != archiveSize) ||
+            (header->tocOffset + (uint64_t)header->entryCount * sizeof(AssetArchiveEntry) > archiveSize) ||
+            (header->pathTableOffset + header->pathTableSize > archiveSize))
+        {
+            return false;
+        }
+
+        const AssetArchiveEntry* entries = (const AssetArchiveEntry*)(archive + header->tocOffset);
+        for (uint32_t i = 0; i < header->entryCount; i++)
+        {
+            const AssetArchiveEntry& entry = entries[i];
+            if ((entry.offset + entry.size > archiveSize) || ((uint64_t)entry.pathOffset + entry.pathLength > header->pathTableSize) ||
+                ((i > 0) && (entries[i - 1].pathHash > entry.pathHash)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 正規化したパスの項目を目次から探します。 (Validate() で確かめたアーカイブに対して呼び出してください)
+    //       戻り値 : 見つかった項目 (見つからない場合は nullptr)
+    static const AssetArchiveEntry* FindEntry(const uint8_t* archive, const std::string& normalizedPath)
+    {
+        const AssetArchiveHeader* header = (const AssetArchiveHeader*)archive;
+        const AssetArchiveEntry* first = (const AssetArchiveEntry*)(archive + header->tocOffset);
+        const AssetArchiveEntry* last = first + header->entryCount;
+        const char* pathTable = (const char*)(archive + header->pathTableOffset);
+
+        const uint64_t pathHash = ComputePathHash(normalizedPath);
+        const AssetArchiveEntry* entry = std::lower_bound(first, last, pathHash,
+            [](const AssetArchiveEntry& e, uint64_t hash) { return e.pathHash < hash; });
+        for (; (entry != last) && (entry->pathHash == pathHash); entry++)
+        {
+            if ((entry->pathLength == normalizedPath.size()) && (normalizedPath.compare(0, std::string::npos, pathTable + entry->pathOffset, entry->pathLength) == 0))
+            {
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+};
@@ -0,0 +1,92 @@
+﻿#include "AssetCache.h"
+#include "Texture2D.h"
+#include "GraphicsEngine.h"
+#include <filesystem>
+#include <chrono>
+#include <cwctype>
+#include <cstdio>
+#include <cassert>
+
+// 静的メンバ変数の実体を宣言
+AssetCacheTable<Texture2D> AssetCache::s_table;
+
+
+std::wstring AssetCache::MakeKey(const wchar_t* path, const wchar_t* assetType)
+{
+    std::wstring key = std::filesystem::path(path).lexically_normal().generic_wstring();
+    for (wchar_t& c : key)
+    {
+        c = (wchar_t)towlower(c);
+    }
+
+    // 同じファイルでも、アセットの種類が違えば別の項目にする
+    key += L'|';
+    key += assetType;
+    return key;
+}
+
+
+Texture2D* AssetCache::LoadTexture2D(const wchar_t* textureFilePath)
+{
+    // キャッシュに見つかった場合と、他のスレッドのロードが失敗した場合はそのまま返す
+    const std::wstring key = MakeKey(textureFilePath, L"Texture2D");
+    bool isLoader = false;
+    Texture2D* cachedTexture = s_table.Acquire(key, isLoader);
+    if (!isLoader)
+    {
+        return cachedTexture;
+    }
+
+    // ロックを持たずにロードする (同じアセットを要求した他のスレッドは Publish() まで待つ)
+    const auto startTime = std::chrono::steady_clock::now();
+    Texture2D* texture = Texture2D::LoadFromFile(textureFilePath);
+    const auto endTime = std::chrono::steady_clock::now();
+
+    // テクスチャリソースが実際に使用しているGPUメモリを調べる
+    uint64_t residentBytes = 0;
+    if (texture)
+    {
+        const D3D12_RESOURCE_DESC desc = ((ID3D12Resource*)texture->GetNativeTexturePtr())->GetDesc();
+        residentBytes = GraphicsEngine::Instance().GetD3D12Device()->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+
+        // 他のスレッドに渡る前に印を付けておく (最後の Release() でキャッシュに未使用を通知する)
+        texture->m_isCached = true;
+    }
+
+    // キャッシュの参照とは別に、呼び出し元の参照を1つ増やして渡される
+    s_table.Publish(key, texture, residentBytes, std::chrono::duration<double, std::milli>(endTime - startTime).count());
+    return texture;
+}
+
+
+void AssetCache::OnTextureUnused(const Texture2D* texture)
+{
+    s_table.OnAssetUnused(texture);
+}
+
+
+void AssetCache::SetMemoryBudget(uint64_t bytes)
+{
+    s_table.SetMemoryBudget(bytes);
+}
+
+
+void AssetCache::Clear()
+{
+    s_table.Clear();
+}
+
+
+AssetCacheStats AssetCache::GetStats()
+{
+    return s_table.GetStats();
+}
+
+
+void AssetCache::PrintStats()
+{
+    const AssetCacheStats stats = GetStats();
+    printf("[情報] アセットキャッシュ : ヒット %u 回 / ミス %u 回 / 追い出し %u 回\n", stats.hitCount, stats.missCount, stats.evictionCount);
+    printf("[情報] アセットキャッシュ : %u 個 (未使用 %u 個) / %.2f MB 常駐\n", stats.entryCount, stats.unusedEntryCount, stats.residentBytes / (1024.0 * 1024.0));
+    printf("[情報] アセットキャッシュ : ロード時間 %.2f ms / キャッシュで省いたロード時間 %.2f ms\n", stats.decodeMilliseconds, stats.savedDecodeMilliseconds);
+}
@@ -0,0 +1,54 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include "AssetCacheTable.h"
+
+// 前方宣言
+class Texture2D;
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// アセットキャッシュクラス
+//
+//      ・ファイルからロードしたアセットを「正規化したパス + アセットの種類」をキーにして共有するクラス。
+//      ・キャッシュに見つかった場合は、参照カウントを1増やして既存のアセットを返す。
+//      ・キャッシュ自身もアセットの参照を1つ持つ。キャッシュ以外の参照が全て Release() されると「未使用」になる。
+//      ・未使用のアセットは、メモリ予算を超えている間、最後に使われたのが古い順(LRU)に追い出される。
+//        (メモリ予算が 0 の場合は、最後の Release() の時点ですぐに追い出される)
+//      ・別々のスレッドから同じアセットを同時に要求された場合、ロードは1回だけ行い、他のスレッドはその完了を待つ。
+//      ・項目の管理と追い出しは AssetCacheTable が行い、このクラスはキーの作成とテクスチャのロードを行う。
+//      ・モノステートパターンで実装されている(全てのメンバがstatic)。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class AssetCache
+{
+private:
+    static AssetCacheTable<Texture2D> s_table;      // キーとアセットの組 (ロックと統計情報もこちらが持つ)
+    friend class Texture2D;                         // Texture2Dクラスは友達
+
+private:
+    // パスを正規化して、キャッシュのキーを作成します。
+    //   ・区切り文字を '/' に揃え、"." や ".." を取り除き、英字を小文字にします。 (Windowsのパスは大文字小文字を区別しない為)
+    static std::wstring MakeKey(const wchar_t* path, const wchar_t* assetType);
+
+    // 参照カウントが1(キャッシュの参照のみ)になったテクスチャを未使用にします。 (Texture2D::Release()から呼ばれます)
+    static void OnTextureUnused(const Texture2D* texture);
+
+public:
+    // 画像ファイルからテクスチャをロードします。
+    //   ・既にロード済みの場合は、参照カウントを1増やしてそれを返します。
+    //   ・呼び出し元は、受け取ったテクスチャが不要になったら Release() してください。
+    static Texture2D* LoadTexture2D(const wchar_t* textureFilePath);
+
+    // 未使用のアセットを残しておけるメモリ予算(単位はバイト)を設定します。 (既定値は 0)
+    static void SetMemoryBudget(uint64_t bytes);
+
+    // 未使用のアセットを全て追い出します。
+    static void Clear();
+
+    // 統計情報を取得します。
+    static AssetCacheStats GetStats();
+
+    // 統計情報をコンソールに出力します。
+    static void PrintStats();
+};
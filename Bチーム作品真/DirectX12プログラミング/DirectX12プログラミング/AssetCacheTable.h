@@ -0,0 +1,275 @@
+﻿#pragma once
+#include <cstdint>
+#include <cassert>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ※注意
+//
+//  アセットキャッシュのうち、項目の登録と検索、未使用の項目の追い出し(LRU)だけを取り出したもの。
+//  アセットの種類には依存しないので、GPUが無い環境でも偽物のアセットでヒット数や追い出しの順番を確かめられる。
+//  このヘッダーは Windows や D3D12 のヘッダーに依存しないこと。 (標準ライブラリのみを使用する)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// アセットキャッシュの統計情報
+struct AssetCacheStats
+{
+    uint32_t hitCount;                  // キャッシュに見つかった回数
+    uint32_t missCount;                 // キャッシュに無かったのでロードした回数
+    uint32_t evictionCount;             // キャッシュから追い出した回数
+    uint32_t entryCount;                // キャッシュに入っているアセットの数
+    uint32_t unusedEntryCount;          // キャッシュ以外から参照されていないアセットの数
+    uint64_t residentBytes;             // キャッシュに入っているアセットが使用しているGPUメモリ (単位はバイト)
+    double decodeMilliseconds;          // ロード(ヘッダーの読み込みとテクスチャの作成。 デコードとアップロードは非同期)に掛かった時間の合計 (単位はミリ秒)
+    double savedDecodeMilliseconds;     // キャッシュに見つかったことで省けたロード時間の合計 (単位はミリ秒)
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// アセットキャッシュテーブルクラス
+//
+//      ・キーとアセットの組を管理し、アセットの参照カウントでキャッシュ以外から使われているかを判断するクラス。
+//      ・Asset は AddRef()、Release()、GetReferenceCount() を持つ型であること。
+//        (参照カウントは別々のスレッドから増減されるので、アトミックに増減すること)
+//      ・テーブル自身もアセットの参照を1つ持つ。キャッシュ以外の参照が全て Release() されたら、
+//        アセット側から OnAssetUnused() を呼び出して「未使用」にする。
+//      ・未使用のアセットは、メモリ予算を超えている間、最後に使われたのが古い順(LRU)に追い出される。
+//        (メモリ予算が 0 の場合は、最後の Release() の時点ですぐに追い出される)
+//      ・別々のスレッドから同じキーを同時に要求された場合、ロードは最初のスレッドだけが行い、他のスレッドはその完了を待つ。
+//      ・全てのメンバ関数は、別々のスレッドから同時に呼び出せる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+template<typename Asset>
+class AssetCacheTable
+{
+private:
+    // キャッシュの項目
+    struct Entry
+    {
+        std::wstring key;                           // キャッシュのキー
+        Asset* asset;                               // アセット (ロード中は nullptr)
+        bool isLoading;                             // ロード中の場合は true
+        bool isUnused;                              // キャッシュ以外から参照されていない場合は true
+        uint32_t waiterCount;                       // ロードの完了を待っているスレッドの数
+        uint64_t residentBytes;                     // アセットが使用しているGPUメモリ (単位はバイト)
+        double decodeMilliseconds;                  // ロードに掛かった時間 (単位はミリ秒)
+        typename std::list<Entry*>::iterator unusedIterator;    // 未使用リスト内での位置 (isUnused が true の場合のみ有効)
+    };
+
+    std::unordered_map<std::wstring, Entry*> m_entries;         // キー → キャッシュの項目
+    std::unordered_map<const Asset*, Entry*> m_assetEntries;    // アセット → キャッシュの項目
+    std::list<Entry*> m_unusedEntries;              // 未使用の項目のリスト (先頭ほど最近使われた)
+    uint64_t m_memoryBudget;                        // 未使用のアセットを残しておけるメモリ予算 (単位はバイト)
+    AssetCacheStats m_stats;                        // 統計情報
+    std::mutex m_mutex;                             // 全てのメンバを保護する
+    std::condition_variable m_loadCompleted;        // ロードの完了を待つ為の条件変数
+
+private:
+    // メモリ予算を超えている間、未使用の項目を古い順に追い出します。 (m_mutex をロックした状態で呼び出してください)
+    void Trim()
+    {
+        // 最後に使われたのが古い順(リストの末尾)から追い出す
+        while (!m_unusedEntries.empty() && (m_stats.residentBytes > m_memoryBudget))
+        {
+            Evict(m_unusedEntries.back());
+        }
+    }
+
+    // 項目を追い出し、テーブルが持つ参照を解放します。 (m_mutex をロックした状態で呼び出してください)
+    void Evict(Entry* entry)
+    {
+        assert(entry->isUnused);
+        m_unusedEntries.erase(entry->unusedIterator);
+        m_entries.erase(entry->key);
+        m_assetEntries.erase(entry->asset);
+
+        m_stats.evictionCount++;
+        m_stats.entryCount--;
+        m_stats.unusedEntryCount--;
+        m_stats.residentBytes -= entry->residentBytes;
+
+        // キャッシュ以外の参照は無いので、ここでアセットが破棄される
+        entry->asset->Release();
+        delete entry;
+    }
+
+public:
+    // コンストラクタ
+    AssetCacheTable()
+        : m_memoryBudget(0)
+        , m_stats()
+    {
+    }
+
+    // コピーは禁止
+    AssetCacheTable(const AssetCacheTable&) = delete;
+    AssetCacheTable& operator=(const AssetCacheTable&) = delete;
+
+    // デストラクタ
+    //   ・アセットの参照は解放しません。 (プログラムの終了時にはグラフィックスエンジンが先に破棄されている場合がある為)
+    //     アセットを破棄したい場合は、全ての参照を Release() してから Clear() してください。
+    ~AssetCacheTable()
+    {
+        for (auto& pair : m_entries)
+        {
+            delete pair.second;
+        }
+    }
+
+    // キーに対応するアセットを取得します。
+    //   ・見つかった場合は、参照カウントを1増やしてそれを返します。 (isLoader は false)
+    //   ・見つからなかった場合は、ロード中の項目を登録して nullptr を返します。 (isLoader は true)
+    //     呼び出し元はアセットをロードして、成功しても失敗しても必ず Publish() してください。
+    //   ・他のスレッドがロード中の場合は完了を待ちます。 ロードに失敗した場合は nullptr を返します。 (isLoader は false)
+    //      第1引数 : [in] キャッシュのキー
+    //      第2引数 : [out] 呼び出し元がロードする必要がある場合は true
+    Asset* Acquire(const std::wstring& key, bool& isLoader)
+    {
+        isLoader = false;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end())
+        {
+            // 他のスレッドがロード中の場合は完了を待つ
+            Entry* entry = it->second;
+            if (entry->isLoading)
+            {
+                entry->waiterCount++;
+                m_loadCompleted.wait(lock, [entry]() { return !entry->isLoading; });
+                entry->waiterCount--;
+
+                // ロードに失敗した項目はキャッシュから取り除かれているので、最後に待っていたスレッドが破棄する
+                if (!entry->asset)
+                {
+                    if (entry->waiterCount == 0)
+                    {
+                        delete entry;
+                    }
+                    return nullptr;
+                }
+            }
+
+            // 未使用だった場合は、未使用リストから外す
+            if (entry->isUnused)
+            {
+                m_unusedEntries.erase(entry->unusedIterator);
+                entry->isUnused = false;
+                m_stats.unusedEntryCount--;
+            }
+
+            m_stats.hitCount++;
+            m_stats.savedDecodeMilliseconds += entry->decodeMilliseconds;
+            entry->asset->AddRef();
+            return entry->asset;
+        }
+
+        // ロード中の項目を登録してからロックを外し、同じアセットを要求した他のスレッドを待たせる
+        Entry* entry = new Entry();
+        entry->key = key;
+        entry->asset = nullptr;
+        entry->isLoading = true;
+        entry->isUnused = false;
+        entry->waiterCount = 0;
+        entry->residentBytes = 0;
+        entry->decodeMilliseconds = 0.0;
+        m_entries.emplace(key, entry);
+        isLoader = true;
+        return nullptr;
+    }
+
+    // Acquire() でロードを任されたアセットのロード結果を登録し、完了を待っているスレッドを起こします。
+    //   ・成功した場合は、アセットの参照(ロードした時の1つ)をテーブルが持ち、呼び出し元の参照を1つ増やします。
+    //   ・失敗した場合は項目を取り除くので、次に要求された時にロードをやり直します。
+    //      第1引数 : [in] キャッシュのキー
+    //      第2引数 : [in] ロードしたアセット (失敗した場合は nullptr)
+    //      第3引数 : [in] アセットが使用しているGPUメモリ (単位はバイト)
+    //      第4引数 : [in] ロードに掛かった時間 (単位はミリ秒)
+    void Publish(const std::wstring& key, Asset* asset, uint64_t residentBytes, double decodeMilliseconds)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(key);
+        assert((it != m_entries.end()) && it->second->isLoading);
+        Entry* entry = it->second;
+        entry->isLoading = false;
+        if (!asset)
+        {
+            // 待っているスレッドがいる場合は、そちらが項目を破棄する
+            m_entries.erase(it);
+            m_loadCompleted.notify_all();
+            if (entry->waiterCount == 0)
+            {
+                delete entry;
+            }
+            return;
+        }
+
+        entry->asset = asset;
+        entry->residentBytes = residentBytes;
+        entry->decodeMilliseconds = decodeMilliseconds;
+        m_assetEntries.emplace(asset, entry);
+
+        m_stats.missCount++;
+        m_stats.entryCount++;
+        m_stats.residentBytes += residentBytes;
+        m_stats.decodeMilliseconds += decodeMilliseconds;
+        m_loadCompleted.notify_all();
+
+        // テーブルの参照とは別に、呼び出し元の参照を1つ増やして渡す
+        asset->AddRef();
+    }
+
+    // 参照カウントが1(テーブルの参照のみ)になったアセットを未使用にします。 (アセットの Release() から呼び出してください)
+    //   ・ロックを取るまでの間に他のスレッドが参照を増やしていた場合や、既に未使用の場合は何もしません。
+    void OnAssetUnused(const Asset* asset)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_assetEntries.find(asset);
+        if ((it == m_assetEntries.end()) || it->second->isUnused)
+        {
+            return;
+        }
+
+        // 1ならテーブルの参照しか残っていない (ロックを持たずに参照を増やせる他の持ち主もいない)
+        if (asset->GetReferenceCount() != 1)
+        {
+            return;
+        }
+
+        Entry* entry = it->second;
+        entry->isUnused = true;
+        entry->unusedIterator = m_unusedEntries.insert(m_unusedEntries.begin(), entry);
+        m_stats.unusedEntryCount++;
+        Trim();
+    }
+
+    // 未使用のアセットを残しておけるメモリ予算(単位はバイト)を設定します。 (既定値は 0)
+    void SetMemoryBudget(uint64_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_memoryBudget = bytes;
+        Trim();
+    }
+
+    // 未使用のアセットを全て追い出します。
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (!m_unusedEntries.empty())
+        {
+            Evict(m_unusedEntries.back());
+        }
+    }
+
+    // 統計情報を取得します。
+    AssetCacheStats GetStats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+};
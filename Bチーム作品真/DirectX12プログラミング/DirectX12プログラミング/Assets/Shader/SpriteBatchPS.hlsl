@@ -0,0 +1,33 @@
+#include "SpriteRenderer.hlsli"
+
+// LfBXNv^q[v̉ïɕłSẴeNX` (VF[_[\[XWX^0Ԃ)
+Texture2D<float4> _Textures[] : register(t0);
+
+// Tv[Xe[g (Tv[WX^0ԂɃoCh)
+SamplerState _MainTexSampler : register(s0);
+
+// o̓sNZ
+struct PSOutput
+{
+	float4 target0   : SV_TARGET0;		// _[^[Qbg[0]ւ̏o͒l
+};
+
+
+//----------------------------------------------------------------------------------------------------------------------
+// sNZVF[_[̃Gg[|Cg֐
+//----------------------------------------------------------------------------------------------------------------------
+PSOutput main(in SpriteBatchVSOutput input)
+{
+	// 1̃h[R[ɈقȂeNX`̃XvCĝŁAY͔lƂĈ
+	const float4 texelColor = _Textures[NonUniformResourceIndex(input.textureIndex)].Sample(_MainTexSampler, input.texcoord);
+
+	// o͗pϐ
+	PSOutput output = (PSOutput)0;
+#if PREMULTIPLIED_ALPHA
+	// eNX`̐F̓At@Zς݂Ȃ̂ŁA_J[At@Zς݂ɂĂ|
+	output.target0 = texelColor * float4(input.color.rgb * input.color.a, input.color.a);
+#else
+	output.target0 = texelColor * input.color;
+#endif
+	return output;
+}
@@ -0,0 +1,40 @@
+#include "SpriteRenderer.hlsli"
+
+// t[萔obt@
+struct Frame
+{
+	matrix viewMatrix;	// r[ϊs
+	matrix projMatrix;	// vWFNVϊs
+};
+ConstantBuffer<Frame> cFrame : register(b0);
+
+
+// ͒_ (XvCgob`CPUŃ[hԂɕϊς)
+struct VSInput
+{
+	float3 positionWS	: POSITION;		// [hԍW(x, y, z)
+	float4 color		: VCOLOR;		// XvCgJ[
+	float2 texcoord		: TEXCOORD;		// eNX`W(u, v)
+	uint textureIndex	: TEXINDEX;		// eNX`z̓Y (LfBXNv^q[vłSRV̔ԍ)
+};
+
+
+//----------------------------------------------------------------------------------------------------------------------
+// _VF[_[̃Gg[|Cg֐
+//----------------------------------------------------------------------------------------------------------------------
+SpriteBatchVSOutput main(in VSInput input)
+{
+	// Wϊ ([hϊ͒_CPUōς܂Ă)
+	const float4 positionWS = float4(input.positionWS, 1);
+	const float4 positionVS = mul(positionWS, cFrame.viewMatrix);	// r[ԍW = [hԍW ~ r[ϊs
+	const float4 positionCS = mul(positionVS, cFrame.projMatrix);	// vWFNVԍW = r[ԍW ~ vWFNVϊs
+
+	// o͗pϐ
+	SpriteBatchVSOutput output = (SpriteBatchVSOutput)0;
+	output.positionCS = positionCS;
+	output.color = input.color;
+	output.texcoord = input.texcoord;
+	output.textureIndex = input.textureIndex;
+
+	return output;
+}
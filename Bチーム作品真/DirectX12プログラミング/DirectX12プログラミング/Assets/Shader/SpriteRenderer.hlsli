@@ -6,3 +6,13 @@ struct VSOutput
 	float2 texcoord		: TEXCOORD;		// eNX`W
 };
 
+
+// XvCgob`p (eNX`z̓Y𒸓_Ɏ)
+struct SpriteBatchVSOutput
+{
+	float4 positionCS				: SV_POSITION;	// vWFNVԍW
+	float4 color					: COLOR;		// J[
+	float2 texcoord					: TEXCOORD;		// eNX`W
+	nointerpolation uint textureIndex	: TEXINDEX;		// eNX`z̓Y (ԂȂ)
+};
+
@@ -1,12 +1,11 @@
 ﻿#include "AxisRenderer.h"
 #include "VertexBuffer.h"
-#include "ConstantBuffer.h"
 #include "Vector3.h"
 #include "GameObject.h"
 #include "Transform.h"
 #include "Mathf.h"
 #include "GraphicsEngine.h"
-#include "FrameResources.h"
+#include "D3D12Rhi.h"
 
 
 AxisStyle::AxisStyle()
@@ -48,6 +47,20 @@ AxisRenderer::AxisRenderer()
 }
 
 
+AxisRenderer::AxisRenderer(const AxisRenderer& original)
+	: Renderer(original)
+	, m_xStyle(original.m_xStyle)
+	, m_yStyle(original.m_yStyle)
+	, m_zStyle(original.m_zStyle)
+	, m_vertexBuffer(nullptr)
+	, m_vertexCount(0)
+	, m_pipelineState(original.m_pipelineState)
+	, m_isGeometryDirty(true)
+{
+
+}
+
+
 AxisRenderer::~AxisRenderer()
 {
 
@@ -113,11 +126,6 @@ void AxisRenderer::UploadGeometryData()
 			}
 		}
 
-		if (!m_constantBuffer)
-		{
-			m_constantBuffer = new ConstantBuffer(sizeof(ConstantBufferLayout));
-		}
-
 		m_isGeometryDirty = false;
 	}
 }
@@ -151,29 +159,25 @@ void AxisRenderer::Render()
 	DirectX::XMFLOAT4X4 localToWorldMatrixTransposed;
 	Mathf::Transpose(localToWorldMatrixTransposed, localToWorldMatrix);
 
-	// 定数バッファに「(転置した)ワールド変換行列」と「スプライトカラー」を書き込む
-	ConstantBufferLayout* mapped = (ConstantBufferLayout*)m_constantBuffer->Map();
-	mapped->world = localToWorldMatrixTransposed;
-	m_constantBuffer->Unmap();
+	// 現フレーム用のコマンドコンテキストを取得する
+	RhiCommandContext* commandContext = GraphicsEngine::Instance().GetCurrentCommandContext();
 
-	// 現フレーム用のリソースセットを取得する
-	FrameResources* frameResources = GraphicsEngine::Instance().GetCurrentFrameResources();
+	// 現フレーム用の定数バッファを切り出して「(転置した)ワールド変換行列」を書き込む
+	const RhiUploadAllocation allocation = commandContext->AllocateUploadMemory(sizeof(ConstantBufferLayout));
+	ConstantBufferLayout* mapped = (ConstantBufferLayout*)allocation.cpuAddress;
+	mapped->world = localToWorldMatrixTransposed;
 
 	// 現フレーム用のコマンドリストを取得する
-	ID3D12GraphicsCommandList* commandList = frameResources->GetCommandList();
+	RhiCommandList* commandList = commandContext->GetCommandList();
 
-	// 頂点バッファビュー配列を設定する
-	const D3D12_VERTEX_BUFFER_VIEW vertexBufferViews[] =
-	{
-		m_vertexBuffer->GetVertexBufferView(),
-	};
-	commandList->IASetVertexBuffers(0, _countof(vertexBufferViews), vertexBufferViews);
+	// 頂点バッファビューを設定する
+	commandList->IASetVertexBuffer(0, ToRhi(m_vertexBuffer->GetVertexBufferView()));
 
 	// プリミティブトポロジーを設定する
-	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_LINELIST);
+	commandList->IASetPrimitiveTopology(RhiPrimitiveTopology::LineList);
 
 	// ルートパラメーターに従って定数バッファを設定する
-	commandList->SetGraphicsRootConstantBufferView(1, m_constantBuffer->GetNativeResource()->GetGPUVirtualAddress());
+	commandList->SetGraphicsRootConstantBufferView(1, allocation.gpuAddress);
 
 //	ID3D12DescriptorHeap* const DesciptorHeaps[] = { m_sprite->GetTexture()->GetDescriptorHeap() };
 //	commandList->SetDescriptorHeaps(_countof(DesciptorHeaps), DesciptorHeaps);
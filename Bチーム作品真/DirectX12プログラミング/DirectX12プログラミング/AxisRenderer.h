@@ -55,7 +55,6 @@ public:
 
 // 前方宣言
 class VertexBuffer;
-class ConstantBuffer;
 class PipelineState;
 
 // XYZ軸レンダラー
@@ -67,7 +66,6 @@ private:
     AxisStyle       m_zStyle;           // Z軸のスタイル
     VertexBuffer*   m_vertexBuffer;     // 頂点バッファ
     uint32_t        m_vertexCount;      // 有効な頂点数
-    ConstantBuffer* m_constantBuffer;   // 定数バッファ
     PipelineState*  m_pipelineState;    // パイプラインステート
     bool            m_isGeometryDirty;  // ジオメトリを更新する必要がある場合は true
 
@@ -79,6 +77,9 @@ private:
     // コンストラクタ
     AxisRenderer();
 
+    // コピーコンストラクタ (軸のスタイルだけを複製し、GPUリソースは最初の描画時に作成します)
+    AxisRenderer(const AxisRenderer& original);
+
     // 仮想デストラクタ
     virtual ~AxisRenderer();
 
@@ -98,6 +99,12 @@ public:
     // このインスタンスのデータ型の情報を返します。
     virtual const TypeInfo& GetTypeInfoOfInstance() const { return GetTypeInfo(); }
 
+    // GameObjectのコンポーネントテーブル内での、このデータ型の添え字
+    static constexpr ComponentTypeIndex TypeIndex = ComponentTypeIndex::AxisRenderer;
+
+    // このデータ型と全ての基底クラスを表すビットマスク
+    static constexpr uint32_t TypeMask = Renderer::TypeMask | ToComponentTypeMask(TypeIndex);
+
     // X軸のスタイルを設定します。
     void SetXAxisStyle(const AxisStyle& style) { m_xStyle = style; m_isGeometryDirty = true; }
 
@@ -28,6 +28,12 @@ public:
 	// このインスタンスのデータ型の情報を返します。
 	virtual const TypeInfo& GetTypeInfoOfInstance() const { return GetTypeInfo(); }
 
+	// GameObjectのコンポーネントテーブル内での、このデータ型の添え字
+	static constexpr ComponentTypeIndex TypeIndex = ComponentTypeIndex::Behaviour;
+
+	// このデータ型と全ての基底クラスを表すビットマスク
+	static constexpr uint32_t TypeMask = Component::TypeMask | ToComponentTypeMask(TypeIndex);
+
 	// このスクリプトを有効にする場合は true、無効にする場合は false を指定します。
 	void SetEnabled(bool enabled) { m_enabled = enabled; }
 
@@ -0,0 +1,48 @@
+﻿#pragma once
+#include "Vector3.h"
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// バウンディングボックスクラス
+// 
+//      ・各軸に平行な直方体(AABB: Axis-Aligned Bounding Box)を表現できる。
+//      ・中心と、中心から各面までの距離(サイズの半分)で表す。
+//      ・レンダラーがカメラに映るかどうかの判定(カリング)などに用いられる。
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class Bounds
+{
+public:
+    Vector3 center;     // 中心
+    Vector3 extents;    // 中心から各面までの距離 (常にサイズの半分)
+
+public:
+    // デフォルトコンストラクタ (中心が原点で、大きさが0のボックスになる)
+    Bounds();
+
+    // 引数付きコンストラクタ
+    Bounds(const Vector3& center, const Vector3& size);
+
+    // ボックスの最小の点を取得します。 (center - extents)
+    Vector3 GetMin() const;
+
+    // ボックスの最大の点を取得します。 (center + extents)
+    Vector3 GetMax() const;
+
+    // ボックスのサイズを取得します。 (extents * 2)
+    Vector3 GetSize() const;
+
+    // 最小の点と最大の点からボックスを設定します。
+    void SetMinMax(const Vector3& min, const Vector3& max);
+
+    // 指定した点を含むようにボックスを広げます。
+    void Encapsulate(const Vector3& point);
+
+    // 指定した点がボックスの中にある場合は true を返します。
+    bool Contains(const Vector3& point) const;
+
+    // 他のボックスと重なっている場合は true を返します。
+    bool Intersects(const Bounds& other) const;
+};
+
+
+// インライン実装ファイル
+#include "Bounds.inl"
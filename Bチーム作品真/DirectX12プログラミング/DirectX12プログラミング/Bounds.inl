@@ -0,0 +1,70 @@
+﻿#include "Bounds.h"
+#include <cmath>
+
+
+inline Bounds::Bounds()
+    : center(0.0f, 0.0f, 0.0f)
+    , extents(0.0f, 0.0f, 0.0f)
+{
+
+}
+
+
+inline Bounds::Bounds(const Vector3& center, const Vector3& size)
+    : center(center)
+    , extents(size.x * 0.5f, size.y * 0.5f, size.z * 0.5f)
+{
+
+}
+
+
+inline Vector3 Bounds::GetMin() const
+{
+    return Vector3(center.x - extents.x, center.y - extents.y, center.z - extents.z);
+}
+
+
+inline Vector3 Bounds::GetMax() const
+{
+    return Vector3(center.x + extents.x, center.y + extents.y, center.z + extents.z);
+}
+
+
+inline Vector3 Bounds::GetSize() const
+{
+    return Vector3(extents.x * 2.0f, extents.y * 2.0f, extents.z * 2.0f);
+}
+
+
+inline void Bounds::SetMinMax(const Vector3& min, const Vector3& max)
+{
+    extents = Vector3((max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f, (max.z - min.z) * 0.5f);
+    center = Vector3(min.x + extents.x, min.y + extents.y, min.z + extents.z);
+}
+
+
+inline void Bounds::Encapsulate(const Vector3& point)
+{
+    const Vector3 min = GetMin();
+    const Vector3 max = GetMax();
+    SetMinMax(
+        Vector3(fminf(min.x, point.x), fminf(min.y, point.y), fminf(min.z, point.z)),
+        Vector3(fmaxf(max.x, point.x), fmaxf(max.y, point.y), fmaxf(max.z, point.z)));
+}
+
+
+inline bool Bounds::Contains(const Vector3& point) const
+{
+    return (fabsf(point.x - center.x) <= extents.x)
+        && (fabsf(point.y - center.y) <= extents.y)
+        && (fabsf(point.z - center.z) <= extents.z);
+}
+
+
+inline bool Bounds::Intersects(const Bounds& other) const
+{
+    // 中心間の距離が、各軸で「お互いの半分のサイズの和」以下なら重なっている
+    return (fabsf(center.x - other.center.x) <= extents.x + other.extents.x)
+        && (fabsf(center.y - other.center.y) <= extents.y + other.extents.y)
+        && (fabsf(center.z - other.center.z) <= extents.z + other.extents.z);
+}
@@ -38,8 +38,16 @@
 //--------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 
+// 静的メンバ変数の実体を宣言
+BufferResourceStats BufferResource::s_stats = {};
+std::mutex BufferResource::s_statsMutex;
+
+
 BufferResource::BufferResource()
-    : m_type(BufferResourceType::Unspecified)
+    : m_defaultHeapBuffer(nullptr)
+    , m_uploadHeapBuffer(nullptr)
+    , m_defaultHeapBufferState(D3D12_RESOURCE_STATE_COPY_DEST)
+    , m_type(BufferResourceType::Unspecified)
     , m_byteWidth(0)
 {
 }
@@ -48,16 +56,58 @@ BufferResource::BufferResource()
 BufferResource::~BufferResource()
 {
     if (m_uploadHeapBuffer)
+    {
         m_uploadHeapBuffer->Release();
+        CountResource(m_byteWidth, -1);
+    }
 
     if (m_defaultHeapBuffer != m_uploadHeapBuffer)
     {
         if (m_defaultHeapBuffer)
+        {
             m_defaultHeapBuffer->Release();
+            CountResource(m_byteWidth, -1);
+        }
+    }
+}
+
+
+void BufferResource::CountResource(uint64_t byteWidth, int delta)
+{
+    const uint64_t alignedBytes = (byteWidth + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) & ~(uint64_t)(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1);
+
+    std::lock_guard<std::mutex> lock(s_statsMutex);
+    if (delta > 0)
+    {
+        s_stats.createdCount++;
+        s_stats.liveCount++;
+        s_stats.liveBytes += alignedBytes;
+        s_stats.peakCount = (s_stats.liveCount > s_stats.peakCount) ? s_stats.liveCount : s_stats.peakCount;
+        s_stats.peakBytes = (s_stats.liveBytes > s_stats.peakBytes) ? s_stats.liveBytes : s_stats.peakBytes;
+    }
+    else
+    {
+        s_stats.liveCount--;
+        s_stats.liveBytes -= alignedBytes;
     }
 }
 
 
+BufferResourceStats BufferResource::GetStats()
+{
+    std::lock_guard<std::mutex> lock(s_statsMutex);
+    return s_stats;
+}
+
+
+void BufferResource::PrintStats()
+{
+    const BufferResourceStats stats = GetStats();
+    printf("[情報] バッファリソース : 作成 %u 個 / 最大 %u 個 (%.2f MB) / 未解放 %u 個 (%.2f MB)\n",
+        stats.createdCount, stats.peakCount, stats.peakBytes / (1024.0 * 1024.0), stats.liveCount, stats.liveBytes / (1024.0 * 1024.0));
+}
+
+
 ID3D12Resource* BufferResource::CreateUploadHeapBuffer(BufferResourceType bufferResourceType, uint64_t byteWidth, const void* initialData)
 {
     // ヒープ詳細情報 (ここで指定したメモリ上にリソースが作成される)
@@ -108,6 +158,7 @@ ID3D12Resource* BufferResource::CreateUploadHeapBuffer(BufferResourceType buffer
         assert(0);
     }
     printf("[成功] アップロードヒープバッファの作成 (アドレス: 0x%p)\n", uploadHeapBuffer);
+    CountResource(byteWidth, +1);
 
 
     // 初期データが指定されている場合
@@ -182,16 +233,17 @@ ID3D12Resource* BufferResource::CreateDefaultHeapBuffer(BufferResourceType buffe
         assert(0);
     }
     printf("[成功] デフォルトヒープバッファの作成 (アドレス: 0x%p)\n", defaultHeapBuffer);
+    CountResource(byteWidth, +1);
 
     return defaultHeapBuffer;
 }
 
 
-void BufferResource::Upload(BufferResourceType bufferResourceType, ID3D12GraphicsCommandList* commandList)
+void BufferResource::Upload(BufferResourceType bufferResourceType, ID3D12GraphicsCommandList* commandList, const MapRange* mapRange)
 {
     if (!commandList)
     {
-        commandList = GraphicsEngine::Instance().GetCurrentFrameResources()->GetCommandList();
+        commandList = GraphicsEngine::Instance().GetCurrentFrameResources()->GetD3D12CommandList();
     }
 
     // リソースバリアで適切なステートに遷移させる
@@ -215,8 +267,17 @@ void BufferResource::Upload(BufferResourceType bufferResourceType, ID3D12Graphic
             break;
     }
 
-    commandList->CopyResource(m_defaultHeapBuffer, m_uploadHeapBuffer);
+    // 範囲が指定されている場合はその範囲だけをコピーする (同じオフセットの位置に)
+    if (mapRange && mapRange->end > mapRange->begin)
+    {
+        commandList->CopyBufferRegion(m_defaultHeapBuffer, mapRange->begin, m_uploadHeapBuffer, mapRange->begin, mapRange->end - mapRange->begin);
+    }
+    else
+    {
+        commandList->CopyResource(m_defaultHeapBuffer, m_uploadHeapBuffer);
+    }
     commandList->ResourceBarrier(1, &barrier);
+    m_defaultHeapBufferState = barrier.Transition.StateAfter;
 }
 
 
@@ -229,7 +290,10 @@ bool BufferResource::CreateResource(BufferResourceType bufferResourceType, uint6
     switch (bufferResourceType)
     {
         // 定数バッファはMap前提なのでアップロードヒープバッファのみ作成
+        // (毎フレーム書き換える頂点バッファやインデックスバッファも同様。デフォルトヒープへのコピーを省く)
         case BufferResourceType::ConstantBuffer:
+        case BufferResourceType::DynamicVertexBuffer:
+        case BufferResourceType::DynamicIndexBuffer:
             m_uploadHeapBuffer = CreateUploadHeapBuffer(bufferResourceType, m_byteWidth, initialData);
             m_defaultHeapBuffer = m_uploadHeapBuffer;
             break;
@@ -299,19 +363,25 @@ void BufferResource::Unmap(const MapRange* mapRange, ID3D12GraphicsCommandList*
     {
         if (!commandList)
         {
-            commandList = GraphicsEngine::Instance().GetCurrentFrameResources()->GetCommandList();
+            commandList = GraphicsEngine::Instance().GetCurrentFrameResources()->GetD3D12CommandList();
         }
 
-        D3D12_RESOURCE_BARRIER barrier;
-        memset(&barrier, 0, sizeof(barrier));
-        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-        barrier.Transition.pResource = m_defaultHeapBuffer;
-        barrier.Transition.Subresource = 0;
-        barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
-        barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-        commandList->ResourceBarrier(1, &barrier);
+        // 初期データ無しで作成した直後はまだコピー先のステートのまま
+        if (m_defaultHeapBufferState != D3D12_RESOURCE_STATE_COPY_DEST)
+        {
+            D3D12_RESOURCE_BARRIER barrier;
+            memset(&barrier, 0, sizeof(barrier));
+            barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+            barrier.Transition.pResource = m_defaultHeapBuffer;
+            barrier.Transition.Subresource = 0;
+            barrier.Transition.StateBefore = m_defaultHeapBufferState;
+            barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
+            barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            commandList->ResourceBarrier(1, &barrier);
+            m_defaultHeapBufferState = D3D12_RESOURCE_STATE_COPY_DEST;
+        }
 
-        Upload(m_type, commandList);
+        Upload(m_type, commandList, mapRange);
     }
 }
 
@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include <d3d12.h>
 #include <cstdint>
+#include <mutex>
 #include "ReferenceCounter.h"
 
 
@@ -11,6 +12,8 @@ enum class BufferResourceType
     ConstantBuffer,
     VertexBuffer,
     IndexBuffer,
+    DynamicVertexBuffer,    // CPUから毎フレーム書き換える頂点バッファ
+    DynamicIndexBuffer,     // CPUから毎フレーム書き換えるインデックスバッファ
 };
 
 
@@ -23,12 +26,28 @@ struct MapRange
 };
 
 
+// バッファリソースの統計情報
+//   ・コミット済みリソースは最低でも64KiB単位で確保されるので、メモリはバッファサイズを64KiBに切り上げて数える。
+struct BufferResourceStats
+{
+    uint32_t createdCount;              // 作成したコミット済みリソースの数 (累計)
+    uint32_t liveCount;                 // 現在のコミット済みリソースの数
+    uint32_t peakCount;                 // コミット済みリソースの数の最大値
+    uint64_t liveBytes;                 // 現在のコミット済みリソースのメモリ (単位はバイト)
+    uint64_t peakBytes;                 // コミット済みリソースのメモリの最大値 (単位はバイト)
+};
+
+
 // バッファリソースクラス
 class BufferResource : public ReferenceCounter
 {
 private:
+    static BufferResourceStats s_stats;                 // 全てのバッファリソースの統計情報
+    static std::mutex          s_statsMutex;            // s_stats を保護する
+
     ID3D12Resource*         m_defaultHeapBuffer;        // デフォルトヒープバッファ
     ID3D12Resource*         m_uploadHeapBuffer;         // アップロードヒープバッファ
+    D3D12_RESOURCE_STATES   m_defaultHeapBufferState;   // デフォルトヒープバッファの現在のステート
     BufferResourceType      m_type;                     // バッファタイプ
     uint64_t                m_byteWidth;                // バッファサイズ (単位はバイト)
 
@@ -55,11 +74,19 @@ public:
     void* Map(const MapRange* mapRange = nullptr);
 
     // アップロードヒープバッファをアンマップします。
+    //   ・デフォルトヒープバッファを持つ場合は、その内容をデフォルトヒープバッファにコピーするコマンドを記録します。
+    //   ・範囲を指定した場合は、その範囲だけをコピーします。 (大きなバッファの一部だけを書き換える場合に使います)
     void Unmap(const MapRange* mapRange = nullptr, ID3D12GraphicsCommandList* commandList = nullptr);
 
     /// Direct3D12リソースオブジェクトを取得します。
     ID3D12Resource* GetNativeResource() const { return m_defaultHeapBuffer; }
 
+    // 全てのバッファリソースの統計情報を取得します。
+    static BufferResourceStats GetStats();
+
+    // 統計情報をコンソールに出力します。
+    static void PrintStats();
+
 private:
     // アップロードヒープバッファを作成します。
     //      第1引数 : [in] バッファの種類を識別する列挙型の値
@@ -77,7 +104,13 @@ private:
     // アップロードヒープバッファの内容をデフォルトヒープバッファにコピーします。
     //      第1引数 : [in] バッファの種類を識別する列挙型の値
     //      第2引数 : [in] コピー時に使用されるコマンドリスト
-    void Upload(BufferResourceType bufferResourceType, ID3D12GraphicsCommandList* commandList = nullptr);
+    //      第3引数 : [in] コピーする範囲 (nullptr の場合はバッファ全体)
+    void Upload(BufferResourceType bufferResourceType, ID3D12GraphicsCommandList* commandList = nullptr, const MapRange* mapRange = nullptr);
+
+    // コミット済みリソースの作成と解放を統計情報に数えます。
+    //      第1引数 : [in] バッファサイズ (単位はバイト)
+    //      第2引数 : [in] 作成した場合は +1、解放した場合は -1
+    static void CountResource(uint64_t byteWidth, int delta);
 };
 
 
@@ -2,10 +2,14 @@
 #include "GameObject.h"
 #include "Transform.h"
 #include "Vector2.h"
-#include "GraphicsEngine.h"
-#include "FrameResources.h"
-#include "DepthStencil.h"
 #include "Scene.h"
+#include "Renderer.h"
+#include "SpatialGrid.h"
+#include "SpriteRendererBatch.h"
+#include "CameraViewport.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
 
 using namespace DirectX;
 
@@ -38,6 +42,13 @@ void Camera::OnAttach()
 }
 
 
+void Camera::OnDetach()
+{
+	// ゲームオブジェクトの所属するシーンからこのカメラを削除します。
+	GetGameObject()->GetScene()->RemoveCamera(this);
+}
+
+
 const DirectX::XMFLOAT4X4& Camera::GetViewMatrix() const
 {
 	// このカメラの所有者であるゲームオブジェクトを取得
@@ -79,7 +90,28 @@ const DirectX::XMFLOAT4X4& Camera::GetProjMatrix() const
 
 
 
-void Camera::SetViewport(ID3D12GraphicsCommandList* commandList)
+RhiViewport Camera::ComputeViewport(const RhiCommandContext* commandContext) const
+{
+	// 描画先のテクスチャがある場合は、その全体に描画する
+	if (m_targetTexture)
+	{
+		return CameraViewport::ComputeViewport(m_targetTexture->GetWidth(), m_targetTexture->GetHeight(), Rect(0.0f, 0.0f, 1.0f, 1.0f));
+	}
+	return CameraViewport::ComputeViewport(commandContext->GetRenderTargetWidth(), commandContext->GetRenderTargetHeight(), m_rect);
+}
+
+
+RhiRect Camera::ComputeScissorRect(const RhiCommandContext* commandContext) const
+{
+	if (m_targetTexture)
+	{
+		return CameraViewport::ComputeScissorRect(m_targetTexture->GetWidth(), m_targetTexture->GetHeight(), Rect(0.0f, 0.0f, 1.0f, 1.0f));
+	}
+	return CameraViewport::ComputeScissorRect(commandContext->GetRenderTargetWidth(), commandContext->GetRenderTargetHeight(), m_rect);
+}
+
+
+void Camera::SetViewport(const RhiCommandContext* commandContext, RhiCommandList* commandList) const
 {
     //---------------------------------------------------------------------------------------------------------------------------------------------
 	// 「ビューポート配列の設定」コマンドをコマンドリストに追加する。
@@ -88,64 +120,22 @@ void Camera::SetViewport(ID3D12GraphicsCommandList* commandList)
 	// 画面分割型ゲームを開発する際などに便利。
 	//---------------------------------------------------------------------------------------------------------------------------------------------
 
-	D3D12_VIEWPORT viewports[1];
-	memset(viewports, 0, sizeof(viewports));
-	viewports[0].MinDepth = 0.0f;
-	viewports[0].MaxDepth = 1.0f;
-
-	if (m_targetTexture)
-	{
-		viewports[0].TopLeftX = 0.0f;
-		viewports[0].TopLeftY = 0.0f;
-		viewports[0].Width = (float)m_targetTexture->GetWidth();
-		viewports[0].Height = (float)m_targetTexture->GetHeight();
-	}
-	else
-	{
-		const auto& swapChainDesc = GraphicsEngine::Instance().GetSwapChainDesc();
-		viewports[0].TopLeftX = swapChainDesc.Width * m_rect.x;
-		viewports[0].TopLeftY = swapChainDesc.Height * m_rect.y;
-		viewports[0].Width = swapChainDesc.Width * m_rect.width;
-		viewports[0].Height = swapChainDesc.Height * m_rect.height;
-	}
-
-	commandList->RSSetViewports(_countof(viewports), viewports);
+	commandList->RSSetViewport(ComputeViewport(commandContext));
 }
 
 
-void Camera::SetScissorRects(ID3D12GraphicsCommandList* commandList)
+void Camera::SetScissorRects(const RhiCommandContext* commandContext, RhiCommandList* commandList) const
 {
 	//---------------------------------------------------------------------------------------------------------------------------------------------
 	// 「シザー矩形配列の設定」コマンドをコマンドリストに追加する。
 	//---------------------------------------------------------------------------------------------------------------------------------------------
-	D3D12_RECT scissorRects[1];
-	memset(scissorRects, 0, sizeof(scissorRects));
-
-	if (m_targetTexture)
-	{
-		scissorRects[0].left   = 0;
-		scissorRects[0].top    = 0;
-		scissorRects[0].right  = m_targetTexture->GetWidth();
-		scissorRects[0].bottom = m_targetTexture->GetHeight();
-	}
-	else
-	{
-		const DXGI_SWAP_CHAIN_DESC1& swapChainDesc = GraphicsEngine::Instance().GetSwapChainDesc();
-		scissorRects[0].left   = (LONG)(swapChainDesc.Width  * m_rect.x);
-		scissorRects[0].top    = (LONG)(swapChainDesc.Height * m_rect.y);
-		scissorRects[0].right  = (LONG)(swapChainDesc.Width  * m_rect.width);
-		scissorRects[0].bottom = (LONG)(swapChainDesc.Height * m_rect.height);
-	}
-
-	commandList->RSSetScissorRects(_countof(scissorRects), scissorRects);
+	commandList->RSSetScissorRect(ComputeScissorRect(commandContext));
 }
 
 
 
-void Camera::ClearRenderTarget(ID3D12GraphicsCommandList* commandList)
+void Camera::ClearRenderTarget(const RhiCommandContext* commandContext, RhiCommandList* commandList)
 {
-	FrameResources* currentFrameResources = GraphicsEngine::Instance().GetCurrentFrameResources();
-
 	if (m_targetTexture)
 	{
 
@@ -157,36 +147,37 @@ void Camera::ClearRenderTarget(ID3D12GraphicsCommandList* commandList)
 	}
 
 	// 「レンダーターゲットをクリアする(単色で塗りつぶす)」コマンドをコマンドリストに追加する。
-	commandList->ClearRenderTargetView(currentFrameResources->GetCPUDescriptorHandleForRTV(), m_backgroundColor.components, 0, nullptr);
+	commandList->ClearRenderTargetView(commandContext->GetRenderTargetView(), m_backgroundColor.components);
 
 	// 「深度ステンシルをクリアする(指定した深度値で塗りつぶす)」コマンドをコマンドリストに追加する。
 	//      深度は 1.0f の値でクリアするのが一般的。
 	//      ステンシルは 0 の値でクリアするのが一般的。
-	const DepthStencil* defaultDepthStencil = GraphicsEngine::Instance().GetDepthStencil();
-	commandList->ClearDepthStencilView(defaultDepthStencil->GetCPUDescriptorHandle(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+	commandList->ClearDepthStencilView(commandContext->GetDepthStencilView(), 1.0f, 0);
 }
 
 
 
-void Camera::Render(FrameResources* currentFrameResources)
+void Camera::Render(RhiCommandContext* commandContext, uint64_t cameraConstantBuffer)
 {
-	static const std::function<void(MonoBehaviour*)> OnPreCullFunction = [](MonoBehaviour* monoBehaviour) { monoBehaviour->OnPreRender(); };
-	static const std::function<void(MonoBehaviour*)> OnPreRenderFunction = [](MonoBehaviour* monoBehaviour) { monoBehaviour->OnPostRender(); };
-	static const std::function<void(MonoBehaviour*)> OnPostRenderFunction = [](MonoBehaviour* monoBehaviour) { monoBehaviour->OnPreCull(); };
+	Scene* scene = GetGameObject()->GetScene();
+	SendCallback(scene->m_onPreCullBehaviours, &MonoBehaviour::OnPreCull);
 
-	GameObject* gameObject = GetGameObject();
-	gameObject->BroadcastMessage(OnPreCullFunction);
+	// OnPreCull()の中でゲームオブジェクトが動かされたかもしれないので、バウンディングボックスを更新し直す
+	if (!scene->m_onPreCullBehaviours.empty())
+	{
+		scene->UpdateRendererBounds();
+	}
 
-	//
-	// TODO: ここでフラスタムカリング
-	//
+	// 視錐台カリング
+	std::vector<Renderer*>& visibleRenderers = scene->m_visibleRenderers;
+	Cull(visibleRenderers);
 
-	gameObject->BroadcastMessage(OnPreRenderFunction);
+	SendCallback(scene->m_onPreRenderBehaviours, &MonoBehaviour::OnPreRender);
 
-	ID3D12GraphicsCommandList* commandList = currentFrameResources->GetCommandList();
-	SetViewport(commandList);
-	SetScissorRects(commandList);
-	ClearRenderTarget(commandList);
+	RhiCommandList* commandList = commandContext->GetCommandList();
+	SetViewport(commandContext, commandList);
+	SetScissorRects(commandContext, commandList);
+	ClearRenderTarget(commandContext, commandList);
 
 	// 「プリミティブトポロジーを設定」コマンドをコマンドリストに追加する。
 	//      点リスト          D3D_PRIMITIVE_TOPOLOGY_POINTLIST
@@ -194,19 +185,120 @@ void Camera::Render(FrameResources* currentFrameResources)
 	//      線ストリップ      D3D_PRIMITIVE_TOPOLOGY_LINESTRIP
 	//      三角形リスト      D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST
 	//      三角形ストリップ  D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP
-	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	commandList->IASetPrimitiveTopology(RhiPrimitiveTopology::TriangleList);
 
 	// 「レンダーターゲットと深度ステンシルの設定」コマンドをコマンドリストに追加する。
-	const D3D12_CPU_DESCRIPTOR_HANDLE rtvHandles[] = { currentFrameResources->GetCPUDescriptorHandleForRTV(), };
-	const D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = GraphicsEngine::Instance().GetDepthStencil()->GetCPUDescriptorHandle();
-	commandList->OMSetRenderTargets(_countof(rtvHandles), rtvHandles, FALSE, &dsvHandle);
+	commandList->OMSetRenderTarget(commandContext->GetRenderTargetView(), commandContext->GetDepthStencilView());
 
-	// ここでゲームオブジェクトを描画する。
-	const std::list<GameObject*>& rootGameObjects = GetGameObject()->GetScene()->GetRootGameObjects();
-	for (GameObject* rootGameObject : rootGameObjects)
+	// ここでカメラに映るレンダラーだけを階層順に描画する。
+	// (スプライトレンダラーはスプライトバッチに積まれるだけなので、最後にまとめて描画する)
+	for (Renderer* renderer : visibleRenderers)
 	{
-		rootGameObject->Render();
+		renderer->Render();
 	}
+	SpriteRendererBatch::Render(commandContext, this, cameraConstantBuffer);
+
+	SendCallback(scene->m_onPostRenderBehaviours, &MonoBehaviour::OnPostRender);
+}
+
+
+void Camera::SendCallback(const std::vector<MonoBehaviour*>& behaviours, void (MonoBehaviour::*callback)()) const
+{
+	// リストにはオーバーライドしているスクリプトしか入っていないので、殆どの場合は空
+	const Transform* cameraTransform = GetTransform();
+	for (MonoBehaviour* monoBehaviour : behaviours)
+	{
+		// このカメラのゲームオブジェクトか、その子孫に付いているスクリプトだけが対象
+		const Transform* current = monoBehaviour->GetTransform();
+		while (current && (current != cameraTransform))
+		{
+			current = current->GetParent();
+		}
+
+		if (current)
+		{
+			(monoBehaviour->*callback)();
+		}
+	}
+}
 
-	gameObject->BroadcastMessage(OnPostRenderFunction);
+
+void Camera::Cull(std::vector<Renderer*>& visibleRenderers) const
+{
+	Scene* scene = GetGameObject()->GetScene();
+	visibleRenderers.clear();
+
+	// ワールド空間 → クリップ空間の変換行列
+	const XMMATRIX viewProjMatrix = XMMatrixMultiply(XMLoadFloat4x4(&GetViewMatrix()), XMLoadFloat4x4(&GetProjMatrix()));
+
+	// 視錐台の8つの角をワールド空間に戻して、それを包むボックスを空間グリッドの検索範囲にする
+	const XMMATRIX inverseViewProjMatrix = XMMatrixInverse(nullptr, viewProjMatrix);
+	XMVECTOR minCorner = XMVectorReplicate(FLT_MAX);
+	XMVECTOR maxCorner = XMVectorReplicate(-FLT_MAX);
+	for (int i = 0; i < 8; i++)
+	{
+		const XMVECTOR clipCorner = XMVectorSet((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : 0.0f, 1.0f);
+		const XMVECTOR worldCorner = XMVector3TransformCoord(clipCorner, inverseViewProjMatrix);
+		minCorner = XMVectorMin(minCorner, worldCorner);
+		maxCorner = XMVectorMax(maxCorner, worldCorner);
+	}
+	XMFLOAT3 min, max;
+	XMStoreFloat3(&min, minCorner);
+	XMStoreFloat3(&max, maxCorner);
+	Bounds area;
+	area.SetMinMax(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
+
+	// 視錐台の6平面 (ax + by + cz + d >= 0 が内側)
+	// クリップ空間で -w <= x <= w, -w <= y <= w, 0 <= z <= w を満たす範囲が視錐台の内側になる。
+	// (行ベクトル × 行列なので、転置した行列の各行が元の行列の各列になる)
+	const XMMATRIX m = XMMatrixTranspose(viewProjMatrix);
+	XMFLOAT4 planes[6];
+	XMStoreFloat4(&planes[0], XMVectorAdd(m.r[3], m.r[0]));			// 左
+	XMStoreFloat4(&planes[1], XMVectorSubtract(m.r[3], m.r[0]));	// 右
+	XMStoreFloat4(&planes[2], XMVectorAdd(m.r[3], m.r[1]));			// 下
+	XMStoreFloat4(&planes[3], XMVectorSubtract(m.r[3], m.r[1]));	// 上
+	XMStoreFloat4(&planes[4], m.r[2]);								// 前方
+	XMStoreFloat4(&planes[5], XMVectorSubtract(m.r[3], m.r[2]));	// 後方
+
+	// ブロードフェーズ: 空間グリッドで、視錐台を包むボックスと重なるレンダラーだけに絞り込む
+	const SpatialGrid* grid = scene->m_rendererGrid;
+	grid->Query(area, visibleRenderers);
+
+	// ナローフェーズ: バウンディングボックスが完全にいずれかの平面の外側にあるレンダラーを取り除く
+	auto isOutside = [&planes](const Renderer* renderer)
+	{
+		const Vector3& c = renderer->m_gridEntry.bounds.center;
+		const Vector3& e = renderer->m_gridEntry.bounds.extents;
+		for (const XMFLOAT4& p : planes)
+		{
+			// 平面からボックスの中心までの距離と、平面の法線方向へのボックスの半径を比べる
+			const float distance = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+			const float radius = fabsf(p.x) * e.x + fabsf(p.y) * e.y + fabsf(p.z) * e.z;
+			if (distance + radius < 0.0f)
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+	visibleRenderers.erase(std::remove_if(visibleRenderers.begin(), visibleRenderers.end(), isOutside), visibleRenderers.end());
+
+	// バウンディングボックスを持たないレンダラーは常に描画する
+	for (const SpatialGridEntry* entry : grid->GetUnboundedEntries())
+	{
+		visibleRenderers.push_back(entry->renderer);
+	}
+
+	// 今回の描画でカメラに映ったことを記録する
+	const uint32_t renderFrameCount = scene->GetRenderFrameCount();
+	for (Renderer* renderer : visibleRenderers)
+	{
+		renderer->m_visibleFrameCount = renderFrameCount;
+	}
+
+	// 空間グリッドから取り出した順番はバラバラなので、カリング前と同じ階層順に並べ直す
+	std::sort(visibleRenderers.begin(), visibleRenderers.end(), [](const Renderer* a, const Renderer* b)
+	{
+		return a->m_renderOrder < b->m_renderOrder;
+	});
 }
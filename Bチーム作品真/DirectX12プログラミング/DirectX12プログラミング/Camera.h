@@ -1,11 +1,13 @@
 ﻿#pragma once
 #include "Behaviour.h"
+#include "MonoBehaviour.h"
 #include "RenderTexture.h"
 #include "Color.h"
 #include "Rect.h"
-#include <d3d12.h>
+#include "Rhi.h"
+#include <vector>
 
-class FrameResources;
+class Renderer;
 
 // カメラがどのようにレンダーターゲットをクリアするか。
 enum class CameraClearFlags
@@ -43,6 +45,12 @@ protected:
 	virtual ~Camera();
 
 public:
+	// GameObjectのコンポーネントテーブル内での、このデータ型の添え字
+	static constexpr ComponentTypeIndex TypeIndex = ComponentTypeIndex::Camera;
+
+	// このデータ型と全ての基底クラスを表すビットマスク
+	static constexpr uint32_t TypeMask = Behaviour::TypeMask | ToComponentTypeMask(TypeIndex);
+
 	// レンダリング先となるテクスチャを取得します。
 	RenderTexture* GetTargetTexture() const { return m_targetTexture; }
 
@@ -116,16 +124,41 @@ public:
 	// Component::OnAttach()をオーバーライドします。
 	void OnAttach() override;
 
+	// Component::OnDetach()をオーバーライドします。
+	void OnDetach() override;
+
 	// Component::Render()をオーバーライドします。
 	void Render() override {  }
 
 	// このカメラが所属するシーン内の全てのゲームオブジェクトをレンダリングします。
 	// このメンバ関数はシーンクラスから呼び出されます。
-	void Render(FrameResources* currentFrameResources);
+	//   ・cameraConstantBuffer はルートパラメーター0番にバインド済みのカメラの定数バッファです。
+	//     (スプライトを並列記録する場合は、新しいコマンドリストにもバインドし直す為に使います)
+	void Render(RhiCommandContext* commandContext, uint64_t cameraConstantBuffer);
+
+	// 描画先の大きさとビューポート矩形から、ビューポートを計算します。
+	RhiViewport ComputeViewport(const RhiCommandContext* commandContext) const;
+
+	// 描画先の大きさとビューポート矩形から、シザー矩形を計算します。
+	RhiRect ComputeScissorRect(const RhiCommandContext* commandContext) const;
+
+	// 描画先の大きさとビューポート矩形から、ビューポートを設定します。
+	void SetViewport(const RhiCommandContext* commandContext, RhiCommandList* commandList) const;
+
+	// 描画先の大きさとビューポート矩形から、シザー矩形を設定します。
+	void SetScissorRects(const RhiCommandContext* commandContext, RhiCommandList* commandList) const;
+
+	// 描画先のレンダーターゲットと深度ステンシルをクリアします。
+	void ClearRenderTarget(const RhiCommandContext* commandContext, RhiCommandList* commandList);
+
+private:
+	// このカメラの視錐台の中にあるレンダラーを階層順に visibleRenderers に集めます。
+	//   ・シーンの空間グリッドで候補を絞り込んでから、視錐台の6平面と判定します。
+	//   ・バウンディングボックスを持たないレンダラーは常に含まれます。
+	void Cull(std::vector<Renderer*>& visibleRenderers) const;
 
-	void SetViewport(ID3D12GraphicsCommandList* commandList);
-	void SetScissorRects(ID3D12GraphicsCommandList* commandList);
-	void ClearRenderTarget(ID3D12GraphicsCommandList* commandList);
+	// 呼び出しリスト内の、このカメラのゲームオブジェクト(子孫を含む)に付いているスクリプトの callback を呼び出します。
+	void SendCallback(const std::vector<MonoBehaviour*>& behaviours, void (MonoBehaviour::*callback)()) const;
 };
 
 
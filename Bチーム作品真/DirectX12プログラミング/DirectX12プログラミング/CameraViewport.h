@@ -0,0 +1,47 @@
+﻿#pragma once
+#include <cstdint>
+#include "Rect.h"
+#include "Rhi.h"
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ※注意
+//
+//  カメラのビューポートとシザー矩形の計算だけを取り出したもの。
+//  スプライトバッチなどの記録をヌルRHIで確かめる時にも、カメラと同じ値を使えるようにする。
+//  このヘッダーは Windows や D3D12 のヘッダーに依存しないこと。 (標準ライブラリのみを使用する)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class CameraViewport
+{
+public:
+    // 描画先の大きさと正規化されたビューポート矩形から、ビューポートを計算します。
+    //      第1引数 : [in] 描画先の幅 (単位はピクセル)
+    //      第2引数 : [in] 描画先の高さ (単位はピクセル)
+    //      第3引数 : [in] 正規化されたビューポート矩形 (0.0f ～ 1.0f)
+    static RhiViewport ComputeViewport(uint32_t width, uint32_t height, const Rect& normalizedRect)
+    {
+        RhiViewport viewport;
+        viewport.x = width * normalizedRect.x;
+        viewport.y = height * normalizedRect.y;
+        viewport.width = width * normalizedRect.width;
+        viewport.height = height * normalizedRect.height;
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        return viewport;
+    }
+
+    // 描画先の大きさと正規化されたビューポート矩形から、ビューポートと同じ範囲のシザー矩形を計算します。
+    //   ・right と bottom は右下隅の座標なので、左上隅の位置に幅と高さを足したものになります。
+    //      第1引数 : [in] 描画先の幅 (単位はピクセル)
+    //      第2引数 : [in] 描画先の高さ (単位はピクセル)
+    //      第3引数 : [in] 正規化されたビューポート矩形 (0.0f ～ 1.0f)
+    static RhiRect ComputeScissorRect(uint32_t width, uint32_t height, const Rect& normalizedRect)
+    {
+        RhiRect scissorRect;
+        scissorRect.left   = (int32_t)(width  * normalizedRect.x);
+        scissorRect.top    = (int32_t)(height * normalizedRect.y);
+        scissorRect.right  = (int32_t)(width  * (normalizedRect.x + normalizedRect.width));
+        scissorRect.bottom = (int32_t)(height * (normalizedRect.y + normalizedRect.height));
+        return scissorRect;
+    }
+};
@@ -1,5 +1,9 @@
 ﻿#include "Component.h"
 #include "GameObject.h"
+#include "MemoryPool.h"
+#include "Scene.h"
+#include <algorithm>
+#include <cassert>
 
 const TypeInfo& Component::GetTypeInfo()
 {
@@ -9,6 +13,10 @@ const TypeInfo& Component::GetTypeInfo()
 
 Component::Component()
     : m_owner(nullptr)
+    , m_typeMask(0)
+    , m_cloneFunction(nullptr)
+    , m_callbackFlags(0)
+    , m_allowsParallelUpdate(false)
 {
 }
 
@@ -16,6 +24,23 @@ Component::~Component()
 {
 }
 
+void* Component::operator new(size_t size, MemoryPool& pool)
+{
+    assert(size <= pool.GetBlockSize());
+    return pool.Allocate();
+}
+
+void Component::operator delete(void* p, MemoryPool& pool)
+{
+    pool.Free(p);
+}
+
+void Component::operator delete(void* p)
+{
+    // 確保したメモリプールはアドレスから逆引きできる
+    MemoryPool::FromPointer(p)->Free(p);
+}
+
 void Component::OnAttach()
 {
     // 何もしない
@@ -36,6 +61,33 @@ void Component::OnDetach()
     // 何もしない
 }
 
+Object* Component::Clone(const Vector3* position, const Quaternion* rotation, Transform* parent, bool instantiateInWorldSpace) const
+{
+    // 所有者ごと複製する
+    GameObject* clone = static_cast<GameObject*>(m_owner->Clone(position, rotation, parent, instantiateInWorldSpace));
+
+    // コンポーネントは同じ順番で複製されるので、同じ位置にあるものが自分の複製
+    const std::vector<Component*>& components = m_owner->m_components;
+    const size_t index = std::find(components.begin(), components.end(), this) - components.begin();
+    assert(index < components.size());
+    return clone->m_components[index];
+}
+
+void Component::Destroy(float time)
+{
+    m_owner->GetScene()->ScheduleDestroy(this, time);
+}
+
+void Component::DestroyImmediate(bool allowDestroyingAssets)
+{
+    m_owner->RemoveComponent(this);
+}
+
+void Component::DontDestroyOnLoad()
+{
+    m_owner->DontDestroyOnLoad();
+}
+
 Transform* Component::GetTransform() const
 {
     return m_owner->GetTransform();
@@ -5,6 +5,8 @@
 class GameObject;
 class Transform;
 class MonoBehaviour;
+class MemoryPool;
+class Scene;
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // コンポーネントクラス
@@ -17,8 +19,13 @@ class MonoBehaviour;
 class Component : public Object
 {
 private:
-    GameObject* m_owner;        // このコンポーネントを所有するゲームオブジェクトへの参照
-    friend class GameObject;    // ゲームオブジェクトクラスは友達
+    GameObject* m_owner;            // このコンポーネントを所有するゲームオブジェクトへの参照
+    uint32_t m_typeMask;            // このコンポーネントのデータ型(基底クラスを含む)を表すビットマスク
+    Component* (*m_cloneFunction)(const Component& original, Scene& scene);    // 同じデータ型の複製を生成する関数
+    uint32_t m_callbackFlags;       // オーバーライドされているコールバック関数 (MonoBehaviour::OnPreCullCallback など)
+    bool m_allowsParallelUpdate;    // 更新処理をワーカースレッドで並列に実行してもよい場合は true
+    friend class GameObject;        // ゲームオブジェクトクラスは友達
+    friend class Scene;             // シーンクラスは友達
 
 protected:
     // コンストラクタ
@@ -34,18 +41,40 @@ protected:
     virtual void OnDetach();
 
     // 更新処理を行う関数です。
-    //   ・この関数は1秒間に約60回の頻度で所有者であるゲームオブジェクトから呼び出されます。
+    //   ・この関数は1秒間に約60回の頻度で所属するシーンから呼び出されます。
     //   ・この関数はダミーなので何もしません。
     //     必要であれば継承先のクラスでオーバーライドしてください。
     virtual void Update();
 
     // 描画処理を行う関数です。
-    //   ・この関数は1秒間に約60回の頻度で所有者であるゲームオブジェクトから呼び出されます。
+    //   ・この関数はレンダラーがカメラに映っている間、1秒間に約60回の頻度でカメラから呼び出されます。
     //   ・この関数はダミーなので何もしません。
     //     必要であれば継承先のクラスでオーバーライドしてください。
     virtual void Render();
 
+    // Object::Clone()をオーバーライドします。 (所有者ごと複製して、複製されたコンポーネントを返します)
+    Object* Clone(const Vector3* position, const Quaternion* rotation, Transform* parent, bool instantiateInWorldSpace) const override;
+
+    // Object::Destroy()をオーバーライドします。 (所有者と同じシーンで破棄を予約します)
+    void Destroy(float time) override;
+
+    // Object::DestroyImmediate()をオーバーライドします。 (所有者から取り外して破棄します)
+    void DestroyImmediate(bool allowDestroyingAssets) override;
+
+    // Object::DontDestroyOnLoad()をオーバーライドします。 (所有者のゲームオブジェクトを対象にします)
+    void DontDestroyOnLoad() override;
+
+    // メモリを確保したメモリプールに返却します。
+    static void operator delete(void* p);
+
 private:
+    // シーンが持つデータ型専用のメモリプールからメモリを確保します。
+    //   ・コンポーネントは GameObject::AddComponent() 以外の方法で作成することはできません。
+    static void* operator new(size_t size, MemoryPool& pool);
+
+    // コンストラクタが例外を投げた場合にメモリプールに返却します。
+    static void operator delete(void* p, MemoryPool& pool);
+
     // このコンポーネントを所有するゲームオブジェクトを設定します。
     void SetGameObject(GameObject* owner) { m_owner = owner; }
 
@@ -56,6 +85,12 @@ public:
     // このインスタンスのデータ型の情報を返します。
     virtual const TypeInfo& GetTypeInfoOfInstance() const { return GetTypeInfo(); }
 
+    // GameObjectのコンポーネントテーブル内での、このデータ型の添え字
+    static constexpr ComponentTypeIndex TypeIndex = ComponentTypeIndex::Component;
+
+    // このデータ型と全ての基底クラスを表すビットマスク
+    static constexpr uint32_t TypeMask = ToComponentTypeMask(TypeIndex);
+
     // このコンポーネントを所有するゲームオブジェクトを取得します。
     GameObject* GetGameObject() const { return m_owner; }
 
@@ -73,5 +108,11 @@ public:
 
     // 同一コンポーネントの重複を禁止する場合は true を返します。
     static bool DisallowMultipleComponent() { return false; }
+
+    // 更新処理(Update)をワーカースレッドで並列に実行してもよい場合は true を返します。
+    //   ・true を返すコンポーネントのUpdate()は、他のコンポーネントのUpdate()と同時に実行されます。
+    //   ・他のコンポーネントが読み書きするデータを変更してはいけません。
+    //   ・ゲームオブジェクトやコンポーネントの作成、親子関係の変更を行ってはいけません。
+    static bool AllowParallelUpdate() { return false; }
 };
 
@@ -0,0 +1,336 @@
+﻿#include "D3D12Rhi.h"
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+
+
+// プリミティブトポロジーを D3D12 の値に変換する
+static D3D12_PRIMITIVE_TOPOLOGY ToD3D12(RhiPrimitiveTopology primitiveTopology)
+{
+    switch (primitiveTopology)
+    {
+    case RhiPrimitiveTopology::PointList:       return D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
+    case RhiPrimitiveTopology::LineList:        return D3D_PRIMITIVE_TOPOLOGY_LINELIST;
+    case RhiPrimitiveTopology::LineStrip:       return D3D_PRIMITIVE_TOPOLOGY_LINESTRIP;
+    case RhiPrimitiveTopology::TriangleList:    return D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    case RhiPrimitiveTopology::TriangleStrip:   return D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+    }
+    assert(0);
+    return D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+}
+
+
+// リソースの状態を D3D12 の値に変換する
+static D3D12_RESOURCE_STATES ToD3D12(RhiResourceState state)
+{
+    switch (state)
+    {
+    case RhiResourceState::Common:                  return D3D12_RESOURCE_STATE_COMMON;
+    case RhiResourceState::Present:                 return D3D12_RESOURCE_STATE_PRESENT;
+    case RhiResourceState::RenderTarget:            return D3D12_RESOURCE_STATE_RENDER_TARGET;
+    case RhiResourceState::DepthWrite:              return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+    case RhiResourceState::CopySource:              return D3D12_RESOURCE_STATE_COPY_SOURCE;
+    case RhiResourceState::CopyDestination:         return D3D12_RESOURCE_STATE_COPY_DEST;
+    case RhiResourceState::VertexAndConstantBuffer: return D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+    case RhiResourceState::IndexBuffer:             return D3D12_RESOURCE_STATE_INDEX_BUFFER;
+    case RhiResourceState::PixelShaderResource:     return D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    }
+    assert(0);
+    return D3D12_RESOURCE_STATE_COMMON;
+}
+
+
+// CPUから見えるディスクリプタを D3D12 の値に変換する
+static D3D12_CPU_DESCRIPTOR_HANDLE ToD3D12(RhiCpuDescriptor descriptor)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE handle;
+    handle.ptr = (SIZE_T)descriptor.ptr;
+    return handle;
+}
+
+
+void D3D12RhiCommandList::SetPipelineState(RhiPipelineState* pipelineState)
+{
+    m_commandList->SetPipelineState((ID3D12PipelineState*)pipelineState);
+}
+
+
+void D3D12RhiCommandList::SetGraphicsRootSignature(RhiRootSignature* rootSignature)
+{
+    m_commandList->SetGraphicsRootSignature((ID3D12RootSignature*)rootSignature);
+}
+
+
+void D3D12RhiCommandList::SetDescriptorHeap(RhiDescriptorHeap* descriptorHeap)
+{
+    ID3D12DescriptorHeap* const descriptorHeaps[] = { (ID3D12DescriptorHeap*)descriptorHeap };
+    m_commandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+}
+
+
+void D3D12RhiCommandList::SetGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t gpuAddress)
+{
+    m_commandList->SetGraphicsRootConstantBufferView(rootParameterIndex, gpuAddress);
+}
+
+
+void D3D12RhiCommandList::SetGraphicsRootDescriptorTable(uint32_t rootParameterIndex, RhiGpuDescriptor baseDescriptor)
+{
+    D3D12_GPU_DESCRIPTOR_HANDLE handle;
+    handle.ptr = baseDescriptor.ptr;
+    m_commandList->SetGraphicsRootDescriptorTable(rootParameterIndex, handle);
+}
+
+
+void D3D12RhiCommandList::IASetPrimitiveTopology(RhiPrimitiveTopology primitiveTopology)
+{
+    m_commandList->IASetPrimitiveTopology(ToD3D12(primitiveTopology));
+}
+
+
+void D3D12RhiCommandList::IASetVertexBuffer(uint32_t slot, const RhiVertexBufferView& view)
+{
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+    vertexBufferView.BufferLocation = view.gpuAddress;
+    vertexBufferView.SizeInBytes = view.sizeInBytes;
+    vertexBufferView.StrideInBytes = view.strideInBytes;
+    m_commandList->IASetVertexBuffers(slot, 1, &vertexBufferView);
+}
+
+
+void D3D12RhiCommandList::IASetIndexBuffer(const RhiIndexBufferView& view)
+{
+    D3D12_INDEX_BUFFER_VIEW indexBufferView;
+    indexBufferView.BufferLocation = view.gpuAddress;
+    indexBufferView.SizeInBytes = view.sizeInBytes;
+    indexBufferView.Format = view.is32Bit ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+    m_commandList->IASetIndexBuffer(&indexBufferView);
+}
+
+
+void D3D12RhiCommandList::RSSetViewport(const RhiViewport& viewport)
+{
+    D3D12_VIEWPORT d3d12Viewport;
+    d3d12Viewport.TopLeftX = viewport.x;
+    d3d12Viewport.TopLeftY = viewport.y;
+    d3d12Viewport.Width = viewport.width;
+    d3d12Viewport.Height = viewport.height;
+    d3d12Viewport.MinDepth = viewport.minDepth;
+    d3d12Viewport.MaxDepth = viewport.maxDepth;
+    m_commandList->RSSetViewports(1, &d3d12Viewport);
+}
+
+
+void D3D12RhiCommandList::RSSetScissorRect(const RhiRect& rect)
+{
+    D3D12_RECT d3d12Rect;
+    d3d12Rect.left = rect.left;
+    d3d12Rect.top = rect.top;
+    d3d12Rect.right = rect.right;
+    d3d12Rect.bottom = rect.bottom;
+    m_commandList->RSSetScissorRects(1, &d3d12Rect);
+}
+
+
+void D3D12RhiCommandList::OMSetRenderTarget(RhiCpuDescriptor renderTargetView, RhiCpuDescriptor depthStencilView)
+{
+    const D3D12_CPU_DESCRIPTOR_HANDLE rtvHandles[] = { ToD3D12(renderTargetView), };
+    const D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = ToD3D12(depthStencilView);
+    m_commandList->OMSetRenderTargets(_countof(rtvHandles), rtvHandles, FALSE, &dsvHandle);
+}
+
+
+void D3D12RhiCommandList::ClearRenderTargetView(RhiCpuDescriptor renderTargetView, const float color[4])
+{
+    m_commandList->ClearRenderTargetView(ToD3D12(renderTargetView), color, 0, nullptr);
+}
+
+
+void D3D12RhiCommandList::ClearDepthStencilView(RhiCpuDescriptor depthStencilView, float depth, uint8_t stencil)
+{
+    m_commandList->ClearDepthStencilView(ToD3D12(depthStencilView), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, depth, stencil, 0, nullptr);
+}
+
+
+void D3D12RhiCommandList::DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation)
+{
+    m_commandList->DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
+}
+
+
+void D3D12RhiCommandList::DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+{
+    m_commandList->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+}
+
+
+void D3D12RhiCommandList::ResourceBarrier(RhiResource* resource, RhiResourceState stateBefore, RhiResourceState stateAfter)
+{
+    D3D12_RESOURCE_BARRIER resourceBarrier;
+    memset(&resourceBarrier, 0, sizeof(resourceBarrier));
+    resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    resourceBarrier.Transition.pResource = (ID3D12Resource*)resource;
+    resourceBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    resourceBarrier.Transition.StateBefore = ToD3D12(stateBefore);
+    resourceBarrier.Transition.StateAfter = ToD3D12(stateAfter);
+    resourceBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    m_commandList->ResourceBarrier(1, &resourceBarrier);
+}
+
+
+void D3D12RhiCommandList::CopyBufferRegion(RhiResource* destination, uint64_t destinationOffset, RhiResource* source, uint64_t sourceOffset, uint64_t numBytes)
+{
+    m_commandList->CopyBufferRegion((ID3D12Resource*)destination, destinationOffset, (ID3D12Resource*)source, sourceOffset, numBytes);
+}
+
+
+void D3D12RhiCommandList::CopyBufferToTexture(RhiResource* destination, uint32_t destinationSubresource, uint32_t destinationY, RhiResource* source, const RhiPlacedFootprint& footprint)
+{
+    // コピー先 (テクスチャのサブリソース)
+    D3D12_TEXTURE_COPY_LOCATION destinationLocation;
+    destinationLocation.pResource = (ID3D12Resource*)destination;
+    destinationLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    destinationLocation.SubresourceIndex = destinationSubresource;
+
+    // コピー元 (バッファに配置したピクセルデータ)
+    D3D12_TEXTURE_COPY_LOCATION sourceLocation;
+    sourceLocation.pResource = (ID3D12Resource*)source;
+    sourceLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+    sourceLocation.PlacedFootprint.Offset = footprint.offset;
+    sourceLocation.PlacedFootprint.Footprint.Format = (DXGI_FORMAT)footprint.format;
+    sourceLocation.PlacedFootprint.Footprint.Width = footprint.width;
+    sourceLocation.PlacedFootprint.Footprint.Height = footprint.height;
+    sourceLocation.PlacedFootprint.Footprint.Depth = footprint.depth;
+    sourceLocation.PlacedFootprint.Footprint.RowPitch = footprint.rowPitch;
+
+    m_commandList->CopyTextureRegion(&destinationLocation, 0, destinationY, 0, &sourceLocation, nullptr);
+}
+
+
+D3D12RhiCopyQueue::D3D12RhiCopyQueue(ID3D12Device* d3d12Device)
+    : m_d3d12Device(d3d12Device)
+    , m_commandQueue(nullptr)
+    , m_fence(nullptr)
+    , m_fenceEvent(nullptr)
+    , m_timeline(nullptr)
+    , m_commandList(nullptr)
+    , m_rhiCommandList(nullptr)
+    , m_currentCommandAllocator(nullptr)
+    , m_isRecording(false)
+{
+    // コピーキュー (コピーエンジンはGPUの描画と並行して動く)
+    D3D12_COMMAND_QUEUE_DESC commandQueueDesc;
+    memset(&commandQueueDesc, 0, sizeof(commandQueueDesc));
+    commandQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+    commandQueueDesc.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
+    commandQueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    commandQueueDesc.NodeMask = 0;
+    if (FAILED(d3d12Device->CreateCommandQueue(&commandQueueDesc, IID_ID3D12CommandQueue, (void**)&m_commandQueue)))
+    {
+        printf("[失敗] コピーキューの作成\n");
+        assert(0);
+    }
+    printf("[成功] コピーキューの作成 (アドレス: 0x%p)\n", m_commandQueue);
+
+    // フェンスとフェンスイベント
+    if (FAILED(d3d12Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_ID3D12Fence, (void**)&m_fence)))
+    {
+        printf("[失敗] コピーキュー用のフェンスの作成\n");
+        assert(0);
+    }
+    m_fenceEvent = ::CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (!m_fenceEvent)
+    {
+        printf("[失敗] コピーキュー用のイベントオブジェクトの作成\n");
+        assert(0);
+    }
+    m_timeline = new D3D12GpuTimeline(m_commandQueue, m_fence, m_fenceEvent);
+
+    // コマンドリストは最初のコマンドアロケーターで作成し、記録を始めるまで閉じておく
+    PooledCommandAllocator pooled;
+    pooled.fenceValue = 0;
+    if (FAILED(d3d12Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_ID3D12CommandAllocator, (void**)&pooled.commandAllocator)))
+    {
+        printf("[失敗] コピー用のコマンドアロケーターの作成\n");
+        assert(0);
+    }
+    m_pooledCommandAllocators.push_back(pooled);
+
+    if (FAILED(d3d12Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, pooled.commandAllocator, nullptr, IID_ID3D12GraphicsCommandList, (void**)&m_commandList)))
+    {
+        printf("[失敗] コピー用のコマンドリストの作成\n");
+        assert(0);
+    }
+    m_commandList->Close();
+    m_rhiCommandList = new D3D12RhiCommandList(m_commandList);
+}
+
+
+D3D12RhiCopyQueue::~D3D12RhiCopyQueue()
+{
+    // 記録途中のコマンドも送ってから、全ての完了を待つ
+    if (m_isRecording)
+    {
+        Submit();
+    }
+    m_timeline->WaitForValue(m_timeline->Signal());
+
+    delete m_rhiCommandList;
+    m_commandList->Release();
+    for (const PooledCommandAllocator& pooled : m_pooledCommandAllocators)
+    {
+        pooled.commandAllocator->Release();
+    }
+    delete m_timeline;
+    CloseHandle(m_fenceEvent);
+    m_fence->Release();
+    m_commandQueue->Release();
+}
+
+
+RhiCommandList* D3D12RhiCopyQueue::GetCommandList()
+{
+    if (m_isRecording)
+    {
+        return m_rhiCommandList;
+    }
+
+    // 一番古いコマンドアロケーターをGPUが使い終わっていれば再利用し、まだなら新しく作成する
+    // (送った順に並んでいるので、先頭だけを調べればよい)
+    const PooledCommandAllocator& oldest = m_pooledCommandAllocators.front();
+    if (oldest.fenceValue <= m_timeline->GetCompletedValue())
+    {
+        m_currentCommandAllocator = oldest.commandAllocator;
+        m_pooledCommandAllocators.erase(m_pooledCommandAllocators.begin());
+        m_currentCommandAllocator->Reset();
+    }
+    else
+    {
+        if (FAILED(m_d3d12Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_ID3D12CommandAllocator, (void**)&m_currentCommandAllocator)))
+        {
+            printf("[失敗] コピー用のコマンドアロケーターの作成\n");
+            assert(0);
+        }
+    }
+
+    m_commandList->Reset(m_currentCommandAllocator, nullptr);
+    m_isRecording = true;
+    return m_rhiCommandList;
+}
+
+
+uint64_t D3D12RhiCopyQueue::Submit()
+{
+    assert(m_isRecording);
+
+    m_commandList->Close();
+    ID3D12CommandList* const commandLists[] = { m_commandList };
+    m_commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+    const uint64_t fenceValue = m_timeline->Signal();
+
+    // コマンドアロケーターはこのフェンス値の完了後に再利用する
+    m_pooledCommandAllocators.push_back({ m_currentCommandAllocator, fenceValue });
+    m_currentCommandAllocator = nullptr;
+    m_isRecording = false;
+    return fenceValue;
+}
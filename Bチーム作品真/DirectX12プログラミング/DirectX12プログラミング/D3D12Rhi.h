@@ -0,0 +1,108 @@
+﻿#pragma once
+#include "Rhi.h"
+#include "GpuTimeline.h"
+#include <d3d12.h>
+#include <cstdint>
+#include <vector>
+
+// D3D12 のオブジェクトを RHI のハンドルに変換します。
+// (D3D12 の実装では、ハンドルは D3D12 のオブジェクトへのポインタをそのまま使う)
+inline RhiPipelineState* ToRhi(ID3D12PipelineState* pipelineState) { return (RhiPipelineState*)pipelineState; }
+inline RhiRootSignature* ToRhi(ID3D12RootSignature* rootSignature) { return (RhiRootSignature*)rootSignature; }
+inline RhiDescriptorHeap* ToRhi(ID3D12DescriptorHeap* descriptorHeap) { return (RhiDescriptorHeap*)descriptorHeap; }
+inline RhiResource* ToRhi(ID3D12Resource* resource) { return (RhiResource*)resource; }
+inline RhiCpuDescriptor ToRhi(D3D12_CPU_DESCRIPTOR_HANDLE handle) { return { (uint64_t)handle.ptr }; }
+inline RhiGpuDescriptor ToRhi(D3D12_GPU_DESCRIPTOR_HANDLE handle) { return { (uint64_t)handle.ptr }; }
+inline RhiVertexBufferView ToRhi(const D3D12_VERTEX_BUFFER_VIEW& view) { return { view.BufferLocation, view.SizeInBytes, view.StrideInBytes }; }
+inline RhiIndexBufferView ToRhi(const D3D12_INDEX_BUFFER_VIEW& view) { return { view.BufferLocation, view.SizeInBytes, view.Format == DXGI_FORMAT_R32_UINT }; }
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// D3D12 RHIコマンドリストクラス
+//
+//      ・ID3D12GraphicsCommandList による RHIコマンドリストの実装。
+//      ・コマンドリストは所有しない。(作成した側が解放すること)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class D3D12RhiCommandList : public RhiCommandList
+{
+private:
+    ID3D12GraphicsCommandList* m_commandList;   // コマンドを記録するコマンドリスト
+
+public:
+    // コンストラクタ
+    explicit D3D12RhiCommandList(ID3D12GraphicsCommandList* commandList) : m_commandList(commandList) { }
+
+    // コマンドリストを取得します。
+    ID3D12GraphicsCommandList* GetD3D12CommandList() const { return m_commandList; }
+
+    // RhiCommandList の実装
+    void SetPipelineState(RhiPipelineState* pipelineState) override;
+    void SetGraphicsRootSignature(RhiRootSignature* rootSignature) override;
+    void SetDescriptorHeap(RhiDescriptorHeap* descriptorHeap) override;
+    void SetGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t gpuAddress) override;
+    void SetGraphicsRootDescriptorTable(uint32_t rootParameterIndex, RhiGpuDescriptor baseDescriptor) override;
+    void IASetPrimitiveTopology(RhiPrimitiveTopology primitiveTopology) override;
+    void IASetVertexBuffer(uint32_t slot, const RhiVertexBufferView& view) override;
+    void IASetIndexBuffer(const RhiIndexBufferView& view) override;
+    void RSSetViewport(const RhiViewport& viewport) override;
+    void RSSetScissorRect(const RhiRect& rect) override;
+    void OMSetRenderTarget(RhiCpuDescriptor renderTargetView, RhiCpuDescriptor depthStencilView) override;
+    void ClearRenderTargetView(RhiCpuDescriptor renderTargetView, const float color[4]) override;
+    void ClearDepthStencilView(RhiCpuDescriptor depthStencilView, float depth, uint8_t stencil) override;
+    void DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) override;
+    void DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) override;
+    void ResourceBarrier(RhiResource* resource, RhiResourceState stateBefore, RhiResourceState stateAfter) override;
+    void CopyBufferRegion(RhiResource* destination, uint64_t destinationOffset, RhiResource* source, uint64_t sourceOffset, uint64_t numBytes) override;
+    void CopyBufferToTexture(RhiResource* destination, uint32_t destinationSubresource, uint32_t destinationY, RhiResource* source, const RhiPlacedFootprint& footprint) override;
+    void NotifyUpload(uint64_t numBytes) override { }
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// D3D12 RHIコピーキュークラス
+//
+//      ・D3D12_COMMAND_LIST_TYPE_COPY のコマンドキュー、フェンス、コマンドリストを持つRHIコピーキューの実装。
+//      ・コマンドアロケーターは送った時のフェンス値と組にしてプールし、GPUが使い終わったものから再利用する。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class D3D12RhiCopyQueue : public RhiCopyQueue
+{
+private:
+    // プールしたコマンドアロケーター
+    struct PooledCommandAllocator
+    {
+        ID3D12CommandAllocator* commandAllocator;   // コマンドアロケーター
+        uint64_t fenceValue;                        // 最後に使ったコマンドリストの完了を表すフェンス値
+    };
+
+    ID3D12Device* m_d3d12Device;                                    // コマンドアロケーターを作成するデバイス
+    ID3D12CommandQueue* m_commandQueue;                             // コピーキュー
+    ID3D12Fence* m_fence;                                           // フェンス
+    HANDLE m_fenceEvent;                                            // フェンスイベント
+    D3D12GpuTimeline* m_timeline;                                   // コピーキューとフェンスのGPUタイムライン
+    ID3D12GraphicsCommandList* m_commandList;                       // コピー用のコマンドリスト (記録中以外は閉じておく)
+    D3D12RhiCommandList* m_rhiCommandList;                          // m_commandList のRHIコマンドリスト
+    std::vector<PooledCommandAllocator> m_pooledCommandAllocators;  // 送った順に並んだコマンドアロケーター
+    ID3D12CommandAllocator* m_currentCommandAllocator;              // 記録中のコマンドリストが使っているコマンドアロケーター
+    bool m_isRecording;                                             // コマンドリストが記録中の場合は true
+
+public:
+    // コンストラクタ
+    explicit D3D12RhiCopyQueue(ID3D12Device* d3d12Device);
+
+    // デストラクタ (キューに送った処理の完了を待ってから解放します)
+    ~D3D12RhiCopyQueue() override;
+
+    // コピーは禁止
+    D3D12RhiCopyQueue(const D3D12RhiCopyQueue&) = delete;
+    D3D12RhiCopyQueue& operator=(const D3D12RhiCopyQueue&) = delete;
+
+    // コピーキューを取得します。
+    ID3D12CommandQueue* GetD3D12CommandQueue() const { return m_commandQueue; }
+
+    // RhiCopyQueue の実装
+    RhiCommandList* GetCommandList() override;
+    uint64_t Submit() override;
+    GpuTimeline* GetTimeline() override { return m_timeline; }
+};
@@ -0,0 +1,42 @@
+﻿#include "DescriptorAllocator.h"
+#include <cstdio>
+#include <cassert>
+
+
+DescriptorAllocator::DescriptorAllocator(ID3D12Device* d3d12Device, uint32_t numPersistentDescriptors, uint32_t numTransientDescriptors, uint32_t numFrames)
+    : m_descriptorHeap(nullptr)
+    , m_cpuHandleForHeapStart{ 0 }
+    , m_gpuHandleForHeapStart{ 0 }
+    , m_descriptorSize(0)
+    , m_indexAllocator(numPersistentDescriptors, numTransientDescriptors, numFrames)
+{
+    if (!d3d12Device)
+    {
+        return;
+    }
+
+    // ヒープの並び : [永続領域][フレーム0の一時領域][フレーム1の一時領域]...
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc;
+    memset(&heapDesc, 0, sizeof(heapDesc));
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.NumDescriptors = m_indexAllocator.GetNumDescriptors();
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    heapDesc.NodeMask = 0;
+    if (FAILED(d3d12Device->CreateDescriptorHeap(&heapDesc, IID_ID3D12DescriptorHeap, (void**)&m_descriptorHeap)))
+    {
+        printf("[失敗] シェーダーから見えるディスクリプタヒープの作成\n");
+        assert(0);
+    }
+    printf("[成功] シェーダーから見えるディスクリプタヒープの作成 (アドレス: 0x%p)\n", m_descriptorHeap);
+
+    m_cpuHandleForHeapStart = m_descriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    m_gpuHandleForHeapStart = m_descriptorHeap->GetGPUDescriptorHandleForHeapStart();
+    m_descriptorSize = d3d12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+    if (m_descriptorHeap)
+        m_descriptorHeap->Release();
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+#include <d3d12.h>
+#include <cassert>
+#include <cstdint>
+#include "DescriptorIndexAllocator.h"
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ディスクリプタアロケータークラス
+//
+//      ・シェーダーから見える大きな CBV/SRV/UAV ディスクリプタヒープを1つだけ持ち、その中のディスクリプタを配るクラス。
+//      ・ヒープは「永続領域」と「一時領域」に分かれている。
+//          永続領域 : テクスチャのSRVなど、寿命の長いディスクリプタ用。フリーリストで管理し、解放された番号を再利用する。
+//          一時領域 : 1フレームの間だけ使うディスクリプタ用。フレームリソース毎の区画を先頭から順番に切り出す。
+//      ・永続領域の番号はヒープの先頭からの位置そのものなので、シェーダーからはディスクリプタ配列の添え字として使える。(バインドレス)
+//      ・解放された番号は、そのフレームのGPU処理が完了するまで再利用しない。
+//        (GPUが読んでいる最中のディスクリプタを上書きしてしまわないようにする)
+//      ・ヒープが1つなので、SetDescriptorHeaps() はフレームの先頭で1回呼ぶだけでよい。
+//      ・番号の管理は DescriptorIndexAllocator が行い、このクラスはヒープとハンドルの計算だけを受け持つ。
+//      ・永続領域が一杯の場合は InvalidIndex を返すので、呼び出し側で必ず確かめること。(リリースビルドでも確かめる)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class DescriptorAllocator
+{
+public:
+    static constexpr uint32_t DefaultNumPersistentDescriptors = 4096;       // 既定の永続領域のディスクリプタ数 (ソートキーのテクスチャ番号(12ビット)に収まる数)
+    static constexpr uint32_t DefaultNumTransientDescriptors = 1024;        // 既定の一時領域の1フレームあたりのディスクリプタ数
+    static constexpr uint32_t InvalidIndex = DescriptorIndexAllocator::InvalidIndex; // 無効なディスクリプタ番号
+
+private:
+    ID3D12DescriptorHeap* m_descriptorHeap;                     // シェーダーから見えるディスクリプタヒープ
+    D3D12_CPU_DESCRIPTOR_HANDLE m_cpuHandleForHeapStart;        // ヒープの先頭のCPUディスクリプタハンドル
+    D3D12_GPU_DESCRIPTOR_HANDLE m_gpuHandleForHeapStart;        // ヒープの先頭のGPUディスクリプタハンドル
+    uint32_t m_descriptorSize;                                  // ディスクリプタ1個あたりのサイズ (単位はバイト)
+    DescriptorIndexAllocator m_indexAllocator;                  // ヒープ内の番号の管理
+
+public:
+    // コンストラクタ
+    //   ・D3D12デバイスに nullptr を指定した場合は、ヒープを作成せずに番号の管理だけを行います。(GPUが無い環境で確かめる為)
+    //      第1引数 : [in] D3D12デバイス
+    //      第2引数 : [in] 永続領域のディスクリプタ数
+    //      第3引数 : [in] 一時領域の1フレームあたりのディスクリプタ数
+    //      第4引数 : [in] フレーム数 (一時領域をいくつの区画に分けるか)
+    DescriptorAllocator(ID3D12Device* d3d12Device, uint32_t numPersistentDescriptors, uint32_t numTransientDescriptors, uint32_t numFrames);
+
+    // デストラクタ
+    ~DescriptorAllocator();
+
+    // コピーは禁止
+    DescriptorAllocator(const DescriptorAllocator&) = delete;
+    DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+    // 永続領域からディスクリプタを1つ確保し、その番号を返します。 (空きが無い場合は InvalidIndex を返します)
+    uint32_t AllocatePersistent() { return m_indexAllocator.AllocatePersistent(); }
+
+    // 永続領域のディスクリプタを解放します。
+    //   ・番号は現在のフレームのGPU処理が完了した後(次に同じフレームが BeginFrame() された時)に再利用されます。
+    void FreePersistent(uint32_t index) { m_indexAllocator.FreePersistent(index); }
+
+    // 現在のフレームの一時領域から、連続したディスクリプタを確保し、先頭の番号を返します。
+    //   ・確保したディスクリプタは、次に同じフレームが BeginFrame() されるまで有効です。 (空きが無い場合は InvalidIndex を返します)
+    uint32_t AllocateTransient(uint32_t count) { return m_indexAllocator.AllocateTransient(count); }
+
+    // フレームを開始します。
+    //   ・指定したフレームの前回のGPU処理が完了した後に呼び出してください。
+    //   ・そのフレームの一時領域を空にし、そのフレームで解放された永続領域の番号を再利用できるようにします。
+    void BeginFrame(uint32_t frameIndex) { m_indexAllocator.BeginFrame(frameIndex); }
+
+    // ディスクリプタヒープを取得します。
+    ID3D12DescriptorHeap* GetDescriptorHeap() const { return m_descriptorHeap; }
+
+    // 指定した番号のCPUディスクリプタハンドルを取得します。 (ディスクリプタの作成に使います。InvalidIndex を渡さないこと)
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(uint32_t index) const { assert(index < m_indexAllocator.GetNumDescriptors()); return D3D12_CPU_DESCRIPTOR_HANDLE{ m_cpuHandleForHeapStart.ptr + (SIZE_T)index * m_descriptorSize }; }
+
+    // 指定した番号のGPUディスクリプタハンドルを取得します。 (ディスクリプタテーブルの設定に使います)
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(uint32_t index) const { assert(index < m_indexAllocator.GetNumDescriptors()); return D3D12_GPU_DESCRIPTOR_HANDLE{ m_gpuHandleForHeapStart.ptr + (UINT64)index * m_descriptorSize }; }
+
+    // 永続領域のディスクリプタ数を取得します。
+    uint32_t GetNumPersistentDescriptors() const { return m_indexAllocator.GetNumPersistentDescriptors(); }
+
+    // 永続領域で使用中のディスクリプタ数を取得します。 (解放済みでGPU処理の完了を待っているものを含みます)
+    uint32_t GetNumUsedPersistentDescriptors() const { return m_indexAllocator.GetNumUsedPersistentDescriptors(); }
+
+    // 現在のフレームの一時領域で使用中のディスクリプタ数を取得します。
+    uint32_t GetNumUsedTransientDescriptors() const { return m_indexAllocator.GetNumUsedTransientDescriptors(); }
+};
@@ -0,0 +1,88 @@
+﻿#include "DescriptorIndexAllocator.h"
+#include <cstdio>
+#include <cassert>
+
+
+DescriptorIndexAllocator::DescriptorIndexAllocator(uint32_t numPersistentDescriptors, uint32_t numTransientDescriptors, uint32_t numFrames)
+    : m_numPersistentDescriptors(numPersistentDescriptors)
+    , m_numTransientDescriptors(numTransientDescriptors)
+    , m_numFrames(numFrames)
+    , m_frameIndex(0)
+    , m_transientOffset(0)
+{
+    assert(numFrames > 0);
+
+    // 小さい番号から順番に取り出されるように、大きい番号から積んでおく
+    m_freeIndices.reserve(numPersistentDescriptors);
+    for (uint32_t i = numPersistentDescriptors; i > 0; i--)
+    {
+        m_freeIndices.push_back(i - 1);
+    }
+    m_pendingFreeIndices.resize(numFrames);
+}
+
+
+uint32_t DescriptorIndexAllocator::AllocatePersistent()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_freeIndices.empty())
+    {
+        printf("[失敗] ディスクリプタヒープの永続領域の容量不足 (%u 個)\n", m_numPersistentDescriptors);
+        return InvalidIndex;
+    }
+
+    const uint32_t index = m_freeIndices.back();
+    m_freeIndices.pop_back();
+    return index;
+}
+
+
+void DescriptorIndexAllocator::FreePersistent(uint32_t index)
+{
+    if (index == InvalidIndex)
+    {
+        return;
+    }
+    assert(index < m_numPersistentDescriptors);
+
+    // GPUが現在のフレームでまだ使っているかもしれないので、すぐには再利用しない
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pendingFreeIndices[m_frameIndex].push_back(index);
+}
+
+
+uint32_t DescriptorIndexAllocator::AllocateTransient(uint32_t count)
+{
+    if (m_transientOffset + count > m_numTransientDescriptors)
+    {
+        printf("[失敗] ディスクリプタヒープの一時領域の容量不足 (要求: %u 個, 使用中: %u / %u 個)\n", count, m_transientOffset, m_numTransientDescriptors);
+        return InvalidIndex;
+    }
+
+    // 一時領域は永続領域の後ろに、フレーム毎の区画が並んでいる
+    const uint32_t index = m_numPersistentDescriptors + m_frameIndex * m_numTransientDescriptors + m_transientOffset;
+    m_transientOffset += count;
+    return index;
+}
+
+
+void DescriptorIndexAllocator::BeginFrame(uint32_t frameIndex)
+{
+    assert(frameIndex < m_numFrames);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frameIndex = frameIndex;
+    m_transientOffset = 0;
+
+    // 前回このフレームで解放された番号は、GPUが使い終わったので再利用できる
+    std::vector<uint32_t>& pendingFreeIndices = m_pendingFreeIndices[frameIndex];
+    m_freeIndices.insert(m_freeIndices.end(), pendingFreeIndices.begin(), pendingFreeIndices.end());
+    pendingFreeIndices.clear();
+}
+
+
+uint32_t DescriptorIndexAllocator::GetNumUsedPersistentDescriptors() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numPersistentDescriptors - (uint32_t)m_freeIndices.size();
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include <mutex>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ディスクリプタ番号アロケータークラス
+//
+//      ・DescriptorAllocator のディスクリプタヒープ内の番号だけを管理するクラス。
+//        (ヒープの並び : [永続領域][フレーム0の一時領域][フレーム1の一時領域]...)
+//      ・永続領域はフリーリストで管理し、解放された番号はそのフレームが次に BeginFrame() されるまで再利用しない。
+//      ・一時領域はフレーム毎の区画を先頭から順番に切り出す。
+//      ・番号を管理するだけで、ディスクリプタヒープそのものは持たない。(GPUの無い環境でも動かせる)
+//      ・このヘッダーは Windows や D3D12 のヘッダーに依存しないこと。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class DescriptorIndexAllocator
+{
+public:
+    static constexpr uint32_t InvalidIndex = UINT32_MAX;                    // 無効なディスクリプタ番号
+
+private:
+    uint32_t m_numPersistentDescriptors;                        // 永続領域のディスクリプタ数
+    uint32_t m_numTransientDescriptors;                         // 一時領域の1フレームあたりのディスクリプタ数
+    uint32_t m_numFrames;                                       // 一時領域の区画数 (フレームリソース数)
+    std::vector<uint32_t> m_freeIndices;                        // 永続領域の未使用の番号 (末尾から取り出す)
+    std::vector<std::vector<uint32_t>> m_pendingFreeIndices;    // 解放されたが、GPU処理の完了を待っている番号 (フレーム毎)
+    uint32_t m_frameIndex;                                      // 現在のフレームの番号
+    uint32_t m_transientOffset;                                 // 現在のフレームの区画内で、次に切り出す位置
+    mutable std::mutex m_mutex;                                 // 永続領域の確保と解放を保護する
+
+public:
+    // コンストラクタ
+    //      第1引数 : [in] 永続領域のディスクリプタ数
+    //      第2引数 : [in] 一時領域の1フレームあたりのディスクリプタ数
+    //      第3引数 : [in] フレーム数 (一時領域をいくつの区画に分けるか)
+    DescriptorIndexAllocator(uint32_t numPersistentDescriptors, uint32_t numTransientDescriptors, uint32_t numFrames);
+
+    // コピーは禁止
+    DescriptorIndexAllocator(const DescriptorIndexAllocator&) = delete;
+    DescriptorIndexAllocator& operator=(const DescriptorIndexAllocator&) = delete;
+
+    // 永続領域から番号を1つ確保します。 (空きが無い場合は InvalidIndex を返します)
+    uint32_t AllocatePersistent();
+
+    // 永続領域の番号を解放します。 (次に同じフレームが BeginFrame() された時に再利用されます)
+    void FreePersistent(uint32_t index);
+
+    // 現在のフレームの一時領域から連続した番号を確保し、先頭の番号を返します。 (空きが無い場合は InvalidIndex を返します)
+    uint32_t AllocateTransient(uint32_t count);
+
+    // フレームを開始します。 (そのフレームの一時領域を空にし、そのフレームで解放された永続領域の番号を再利用できるようにします)
+    void BeginFrame(uint32_t frameIndex);
+
+    // ヒープ全体のディスクリプタ数を取得します。
+    uint32_t GetNumDescriptors() const { return m_numPersistentDescriptors + m_numTransientDescriptors * m_numFrames; }
+
+    // 永続領域のディスクリプタ数を取得します。
+    uint32_t GetNumPersistentDescriptors() const { return m_numPersistentDescriptors; }
+
+    // 永続領域で使用中のディスクリプタ数を取得します。 (解放済みでGPU処理の完了を待っているものを含みます)
+    uint32_t GetNumUsedPersistentDescriptors() const;
+
+    // 現在のフレームの一時領域で使用中のディスクリプタ数を取得します。
+    uint32_t GetNumUsedTransientDescriptors() const { return m_transientOffset; }
+};
@@ -0,0 +1,11 @@
+﻿#include "DestroyQueue.h"
+
+
+void DestroyQueue::Schedule(const Handle<Object>& object, double destroyTime)
+{
+    Request request;
+    request.destroyTime = destroyTime;
+    request.object = object;
+    m_requests.push_back(request);
+    std::push_heap(m_requests.begin(), m_requests.end(), Request::IsLater);
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+#include "Handle.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// 破棄予約キュークラス
+//
+//      ・Object::Destroy() で予約されたオブジェクトを、破棄する時刻が早い順に取り出すクラス。
+//      ・予約はハンドルで持つので、予約後に親ごと破棄された場合や、重複して予約された場合は、取り出した時に無効になっている。
+//      ・破棄する時刻が最も早い予約が先頭に来るヒープで管理するので、予約と取り出しは O(log n) で済む。
+//      ・破棄そのものは呼び出し元に任せる。 (Object の中身を知らないので、Toolsのテストでもビルドできる)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class DestroyQueue
+{
+private:
+    // 破棄の予約
+    struct Request
+    {
+        double destroyTime;                         // 破棄する時刻 (シーン作成からの経過秒数)
+        Handle<Object> object;                      // 破棄するオブジェクト (予約後に破棄済みの場合は無効になる)
+
+        // 破棄する時刻が遅い方を「小さい」とみなす (std::push_heap()で最も早い予約が先頭に来る)
+        static bool IsLater(const Request& a, const Request& b) { return a.destroyTime > b.destroyTime; }
+    };
+
+    std::vector<Request> m_requests;                // 破棄予約リスト (破棄する時刻が最も早いものが先頭に来るヒープ)
+
+public:
+    // 指定した時刻に破棄するように予約します。
+    void Schedule(const Handle<Object>& object, double destroyTime);
+
+    // 破棄する時刻を過ぎた予約を早い順に取り出し、まだ生存しているオブジェクトを destroy(Object&) で破棄します。
+    //      ・破棄したオブジェクトの数を返します。 (既に破棄されていた予約は数えません)
+    //      ・destroy() の中で新しく予約しても構いません。 (時刻を過ぎていれば、同じ呼び出しの中で破棄されます)
+    template<typename DestroyFunction>
+    uint32_t Process(double now, DestroyFunction&& destroy);
+
+    // 条件に合う予約を取り除きます。 (別のシーンに移動したオブジェクトの予約を引き継ぐ時に使います)
+    //      ・predicate(Object&, double destroyTime) が true を返した予約を取り除きます。 (既に破棄されていた予約も取り除きます)
+    template<typename Predicate>
+    void RemoveIf(Predicate&& predicate);
+
+    // 全ての予約を取り消します。
+    void Clear() { m_requests.clear(); }
+
+    // 予約の数を取得します。 (既に破棄されたオブジェクトの予約も含みます)
+    uint32_t GetCount() const { return (uint32_t)m_requests.size(); }
+};
+
+
+template<typename DestroyFunction>
+uint32_t DestroyQueue::Process(double now, DestroyFunction&& destroy)
+{
+    uint32_t destroyedCount = 0;
+    while (!m_requests.empty() && (m_requests.front().destroyTime <= now))
+    {
+        std::pop_heap(m_requests.begin(), m_requests.end(), Request::IsLater);
+        const Handle<Object> handle = m_requests.back().object;
+        m_requests.pop_back();
+
+        // 親ごと破棄された場合や、重複して予約された場合は既に破棄されている
+        if (Object* object = handle.Get())
+        {
+            destroy(*object);
+            destroyedCount++;
+        }
+    }
+    return destroyedCount;
+}
+
+
+template<typename Predicate>
+void DestroyQueue::RemoveIf(Predicate&& predicate)
+{
+    auto end = std::remove_if(m_requests.begin(), m_requests.end(), [&predicate](const Request& request)
+    {
+        Object* object = request.object.Get();
+        return !object || predicate(*object, request.destroyTime);
+    });
+    m_requests.erase(end, m_requests.end());
+    std::make_heap(m_requests.begin(), m_requests.end(), Request::IsLater);
+}
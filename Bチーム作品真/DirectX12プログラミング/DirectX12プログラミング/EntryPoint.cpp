@@ -1,6 +1,12 @@
 ﻿
 #include"GameScene.h"
 #include"Save.h"
+#include "SpriteRendererBatch.h"
+#include "NullRhi.h"
+#include <chrono>
+#include <random>
+#include <thread>
+#include <algorithm>
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // 「ヘッダーファイル」だけでは関数を呼び出せないので「ライブラリファイル」をリンクする必要がある
 //---------------------------------------------------------------------------------------------------------------------------------------------
@@ -111,6 +117,141 @@ LRESULT __stdcall WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 
 
 
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ヌルRHIベンチマーク
+// 
+//    ・描画コマンドをGPUに送らずにヌルRHIに記録させながら、シーンの更新と描画を指定したフレーム数だけ繰り返す。
+//    ・GPUの速さに左右されない、描画処理のCPU側の時間とドローコール数などを計測できる。
+//    ・コマンドライン引数に「-nullrhi-benchmark フレーム数」を指定した場合だけ実行し、終わったらアプリを終了する。
+// 
+//    第1引数 : [in] 計測するシーン
+//    第2引数 : [in] 計測するフレーム数
+// 
+//---------------------------------------------------------------------------------------------------------------------------------------------
+static void RunNullRhiBenchmark(Scene* scene, uint32_t numFrames)
+{
+    GraphicsEngine& graphicsEngine = GraphicsEngine::Instance();
+
+    // スプライトバッチのリングバッファはGPUメモリのままなので、GPU処理が全て完了してから差し替える
+    graphicsEngine.WaitForCompletion();
+
+    // 通常のフレームリソースと同じ描画先の大きさ、アップロード用のメモリの大きさ、デフォルトのグラフィックスステートにしておく
+    const DXGI_SWAP_CHAIN_DESC1& swapChainDesc = graphicsEngine.GetSwapChainDesc();
+    NullRhiCommandContext commandContext(swapChainDesc.Width, swapChainDesc.Height, UploadAllocator::DefaultCapacity);
+    commandContext.SetDefaultGraphicsState(ToRhi(graphicsEngine.GetDefaultPipelineState()), ToRhi(graphicsEngine.GetDefaultRootSignature()), ToRhi(graphicsEngine.GetDescriptorAllocator()->GetDescriptorHeap()));
+    graphicsEngine.SetCommandContextOverride(&commandContext);
+
+    double updateMilliseconds = 0.0;
+    double renderMilliseconds = 0.0;
+    for (uint32_t frame = 0; frame < numFrames; frame++)
+    {
+        commandContext.BeginFrame();
+
+        const auto updateStartTime = std::chrono::high_resolution_clock::now();
+        scene->Update();
+        const auto renderStartTime = std::chrono::high_resolution_clock::now();
+
+        // ゲームループと同じく、フレームの先頭でデフォルトのグラフィックスステートを設定してから描画する
+        RhiCommandList* commandList = commandContext.GetCommandList();
+        commandContext.ApplyDefaultGraphicsState(commandList);
+        scene->Render();
+        const auto renderEndTime = std::chrono::high_resolution_clock::now();
+
+        updateMilliseconds += std::chrono::duration<double, std::milli>(renderStartTime - updateStartTime).count();
+        renderMilliseconds += std::chrono::duration<double, std::milli>(renderEndTime - renderStartTime).count();
+    }
+
+    graphicsEngine.SetCommandContextOverride(nullptr);
+
+    // 統計情報は最後のフレームのもの
+    printf("[情報] ヌルRHIベンチマーク : %u フレーム / 更新 平均 %.3f ms / 描画 平均 %.3f ms\n",
+        numFrames, updateMilliseconds / numFrames, renderMilliseconds / numFrames);
+    NullRhiCommandContext::PrintStats(commandContext.GetStats());
+}
+
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// スプライトを増やしたヌルRHIベンチマーク (並列記録のスレッド数による描画時間の変化)
+// 
+//    ・カメラに映る範囲に指定した数のスプライトを追加し、ジョブシステムのスレッド数を 1, 2, 4, ... 論理コア数 と変えながら、
+//      描画の記録を指定したフレーム数ずつ繰り返して、1フレームの平均時間を出力する。
+//    ・シーンの更新は最初に1回だけ行う。 (描画の記録にかかる時間だけを比べる)
+//    ・コマンドライン引数に「-nullrhi-benchmark フレーム数 -sprites スプライト数」を指定した場合だけ実行する。
+//      (スプライトバッチのリングバッファは、追加するスプライトが1フレームに収まる大きさで作成しておくこと)
+// 
+//    第1引数 : [in] 計測するシーン
+//    第2引数 : [in] スレッド数毎に計測するフレーム数
+//    第3引数 : [in] 追加するスプライトの数
+// 
+//---------------------------------------------------------------------------------------------------------------------------------------------
+static void RunSpriteScalingBenchmark(Scene* scene, uint32_t numFrames, uint32_t numSprites)
+{
+    GraphicsEngine& graphicsEngine = GraphicsEngine::Instance();
+
+    // スプライトバッチのリングバッファはGPUメモリのままなので、GPU処理が全て完了してから差し替える
+    graphicsEngine.WaitForCompletion();
+
+    // カメラ(1920x1080 の範囲を映す)に収まる位置に、32x32 のスプライトを散らばらせる (毎回同じ配置になるように乱数の種は固定)
+    Texture2D* texture = Texture2D::FromFile(L"Assets/Player(B)/3022856.png");
+    std::mt19937 random(12345);
+    std::uniform_real_distribution<float> randomX(0.0f, 1920.0f - 32.0f);
+    std::uniform_real_distribution<float> randomY(0.0f, 1080.0f - 32.0f);
+    std::uniform_real_distribution<float> randomZ(0.0f, 50.0f);
+    for (uint32_t i = 0; i < numSprites; i++)
+    {
+        const Vector3 position(randomX(random), randomY(random), randomZ(random));
+        GameObject::CreateWithSprite("ベンチマーク用スプライト", texture, Rect(0, 0, 108, 108), Vector2(0.0f, 0.0f), 108.0f / 32.0f, position);
+    }
+    texture->Release();
+
+    const DXGI_SWAP_CHAIN_DESC1& swapChainDesc = graphicsEngine.GetSwapChainDesc();
+    NullRhiCommandContext commandContext(swapChainDesc.Width, swapChainDesc.Height, UploadAllocator::DefaultCapacity);
+    commandContext.SetDefaultGraphicsState(ToRhi(graphicsEngine.GetDefaultPipelineState()), ToRhi(graphicsEngine.GetDefaultRootSignature()), ToRhi(graphicsEngine.GetDescriptorAllocator()->GetDescriptorHeap()));
+    graphicsEngine.SetCommandContextOverride(&commandContext);
+
+    commandContext.BeginFrame();
+    scene->Update();
+
+    const uint32_t maxNumThreads = (std::max)(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t numThreads = 1; ; numThreads = (std::min)(numThreads * 2, maxNumThreads))
+    {
+        // ジョブシステムはフレームの間は何も実行していないので、スレッド数を変えて作り直せる
+        JobSystem::DestroySingletonInstance();
+        JobSystem::CreateSingletonInstance(numThreads);
+
+        double renderMilliseconds = 0.0;
+        for (uint32_t frame = 0; frame < numFrames; frame++)
+        {
+            commandContext.BeginFrame();
+
+            const auto renderStartTime = std::chrono::high_resolution_clock::now();
+            RhiCommandList* commandList = commandContext.GetCommandList();
+            commandContext.ApplyDefaultGraphicsState(commandList);
+            scene->Render();
+            const auto renderEndTime = std::chrono::high_resolution_clock::now();
+            renderMilliseconds += std::chrono::duration<double, std::milli>(renderEndTime - renderStartTime).count();
+        }
+
+        const NullRhiStats stats = commandContext.GetStats();
+        printf("[情報] スプライト %u 個 / スレッド %u 個 : 描画 平均 %.3f ms (コマンドリスト %u 個 / ドローコール %u 回)\n",
+            numSprites, numThreads, renderMilliseconds / numFrames, stats.commandListCount, stats.drawCount);
+
+        if (numThreads == maxNumThreads)
+        {
+            break;
+        }
+    }
+
+    // ジョブシステムを論理コア数のスレッドに戻す
+    JobSystem::DestroySingletonInstance();
+    JobSystem::CreateSingletonInstance();
+
+    graphicsEngine.SetCommandContextOverride(nullptr);
+}
+
+
+
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // Windowsアプリケーションのエントリーポイント関数
 // 
@@ -128,7 +269,6 @@ int WINAPI _tWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPTSTR lpszCm
 {
     // 未使用の仮引数たち (警告の抑制)
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpszCmdLine);
     UNREFERENCED_PARAMETER(nCmdShow);
 
     //---------------------------------------------------------------------------------------------------------------------------------------------
@@ -343,27 +483,52 @@ int WINAPI _tWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPTSTR lpszCm
     Keyboard::Initialize();
 
 
+    //---------------------------------------------------------------------------------------------------------------------------------------------
+    // ジョブシステムの初期化 (論理コア数と同じ数のスレッドでジョブを実行する)
+    //---------------------------------------------------------------------------------------------------------------------------------------------
+    JobSystem::CreateSingletonInstance();
+
+
+    //---------------------------------------------------------------------------------------------------------------------------------------------
+    // アセットアーカイブのマウント (無い場合は個別のファイルから読み込む)
+    //---------------------------------------------------------------------------------------------------------------------------------------------
+    AssetArchive::Mount(L"Assets.pak");
+
+
     //---------------------------------------------------------------------------------------------------------------------------------------------
     // 2D/3Dグラフィックスエンジンの初期化
     //---------------------------------------------------------------------------------------------------------------------------------------------
     GraphicsEngine::CreateSingletonInstance(hWnd, GameScreenResolutionWidth, GameScreenResolutionHeight);
 
+    // 前回の起動時に作成したパイプラインステートをキャッシュファイルから読み込む
+    PipelineStateCache::Load(L"PipelineStateCache.bin");
+
     //---------------------------------------------------------------------------------------------------------------------------------------------
     // プログラマブルシェーダーの作成
     //---------------------------------------------------------------------------------------------------------------------------------------------
 
-    // 頂点シェーダーの作成 (頂点シェーダープロファイル 5.1 でコンパイル)
-    ShaderBytecode* vertexShader = new ShaderBytecode(L"Assets/Shader/SpriteRendererVS.hlsl", "vs_5_1", "main");
-
-    // ピクセルシェーダーの作成 (ピクセルシェーダープロファイル 5.1 でコンパイル)
-    ShaderBytecode* pixelShader = new ShaderBytecode(L"Assets/Shader/SpriteRendererPS.hlsl", "ps_5_1", "main");
+    // 頂点シェーダーとピクセルシェーダーの読み込み (シェーダープロファイル 5.1)
+    // (シェーダーキャッシュに無いものだけを並列にコンパイルする)
+    static const ShaderRequest shaderRequests[] =
+    {
+        { L"Assets/Shader/SpriteRendererVS.hlsl", "vs_5_1", "main", nullptr },
+        { L"Assets/Shader/SpriteRendererPS.hlsl", "ps_5_1", "main", nullptr },
+    };
+    ShaderBytecode* shaders[_countof(shaderRequests)];
+    ShaderCache::LoadInParallel(_countof(shaderRequests), shaderRequests, shaders);
+    ShaderBytecode* vertexShader = shaders[0];
+    ShaderBytecode* pixelShader = shaders[1];
 
     //---------------------------------------------------------------------------------------------------------------------------------------------
     // ルートシグネチャの作成
+    //
+    //  テクスチャのディスクリプタテーブルは、共有ディスクリプタヒープの永続領域全体を t0 から並べたものにする。
+    //  (バインドレス。まだSRVが作られていない番号もあるので、ディスクリプタは volatile 扱いにする)
     //---------------------------------------------------------------------------------------------------------------------------------------------
     static const DescriptorRange descriptorRange[] =
     {
-        DescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 1, 0, D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND),
+        DescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, DescriptorAllocator::DefaultNumPersistentDescriptors, 0, D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND,
+            D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE),
     };
 
     ID3D12RootSignature* d3d12RootSignature;
@@ -419,21 +584,51 @@ int WINAPI _tWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPTSTR lpszCm
     }
     pipelineStateBuilder.End(&d3d12PipelineState);
 
+    // コマンドリストの先頭で設定するデフォルトのグラフィックスステートとして登録する
+    // (並列記録で新しく記録を始めるコマンドリストにも同じものが設定される)
+    GraphicsEngine::Instance().SetDefaultGraphicsState(d3d12RootSignature, d3d12PipelineState);
+
+    // コマンドライン引数に「-sprites スプライト数」が指定されていれば、ベンチマーク用に追加するスプライトも1フレームに収まるようにする
+    uint32_t numBenchmarkSprites = 0;
+    if (const TCHAR* spritesOption = _tcsstr(lpszCmdLine, _T("-sprites")))
+    {
+        const int numSprites = _ttoi(spritesOption + _tcslen(_T("-sprites")));
+        numBenchmarkSprites = (numSprites > 0) ? (uint32_t)numSprites : 0;
+    }
+
+    // スプライトバッチの初期化 (スプライト1個は頂点4個)
+    SpriteRendererBatch::LoadAssets(SpriteRendererBatch::DefaultMaxVerticesPerFrame + numBenchmarkSprites * 4);
+
     //---------------------------------------------------------------------------------------------------------------------------------------------
     // 
     //---------------------------------------------------------------------------------------------------------------------------------------------
     // ぷよぷよ「メイン画面」の作成
     MatumotoGame::GameScene* A = new MatumotoGame:: GameScene();
 
-    // ぷよぷよ「メイン画面」をアクティブなシーンとして設定する
-    SceneManager::SetActiveScene(A);
-
-    // ぷよぷよ「メイン画面」のアセットをロードする
-    A->LoadAssets();
-    
+    // ぷよぷよ「メイン画面」をアクティブなシーンとして設定し、アセットをロードする
+    SceneManager::LoadScene(A);
     
-    // ウィンドウを可視状態に変更する
-    ::ShowWindow(hWnd, SW_SHOW);
+    // コマンドライン引数に「-nullrhi-benchmark フレーム数」が指定されていれば、ヌルRHIで計測してから終了する
+    // (「-sprites スプライト数」も指定されていれば、スプライトを追加してスレッド数毎に計測する)
+    // (ゲームループは WM_QUIT を受け取ってすぐに抜けるので、そのまま終了処理に進む)
+    if (const TCHAR* benchmarkOption = _tcsstr(lpszCmdLine, _T("-nullrhi-benchmark")))
+    {
+        const int numFrames = _ttoi(benchmarkOption + _tcslen(_T("-nullrhi-benchmark")));
+        if (numBenchmarkSprites > 0)
+        {
+            RunSpriteScalingBenchmark(A, (numFrames > 0) ? (uint32_t)numFrames : 100, numBenchmarkSprites);
+        }
+        else
+        {
+            RunNullRhiBenchmark(A, (numFrames > 0) ? (uint32_t)numFrames : 600);
+        }
+        PostQuitMessage(0);
+    }
+    else
+    {
+        // ウィンドウを可視状態に変更する
+        ::ShowWindow(hWnd, SW_SHOW);
+    }
 
     // タイマー分解能を最小にする
     timeBeginPeriod(1);
@@ -510,29 +705,17 @@ int WINAPI _tWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPTSTR lpszCm
             FrameResources* currentFrameResources = GraphicsEngine::Instance().GetCurrentFrameResources();
 
             // コマンドリストの取得
-            ID3D12GraphicsCommandList* currentCommandList = currentFrameResources->GetCommandList();
-
-            // 「パイプラインステートオブジェクトを設定」コマンドをコマンドリストに追加する。
-            currentCommandList->SetPipelineState(d3d12PipelineState);
+            RhiCommandList* currentCommandList = currentFrameResources->GetCommandList();
 
-            // 「グラフィックスパイプライン用ルートシグネチャを設定」コマンドをコマンドリストに追加する。
-            currentCommandList->SetGraphicsRootSignature(d3d12RootSignature);
-
-            // リソースバリア詳細情報
-            D3D12_RESOURCE_BARRIER resourceBarrier;
-            memset(&resourceBarrier, 0, sizeof(resourceBarrier));
+            // 「パイプラインステートオブジェクトを設定」「グラフィックスパイプライン用ルートシグネチャを設定」
+            // 「ディスクリプタヒープを設定」コマンドをコマンドリストに追加する。
+            GraphicsEngine::Instance().ApplyDefaultGraphicsState(currentCommandList);
 
             // 「リソースバリア」コマンドをコマンドリストに追加する。
             // 
             //  レンダーターゲット(バックバッファ)のリソース状態を遷移させる。
             // 【プレゼント可能状態】⇒【レンダーターゲット状態】
-            resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-            resourceBarrier.Transition.pResource = currentFrameResources->GetBackBuffer();
-            resourceBarrier.Transition.Subresource = 0;
-            resourceBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
-            resourceBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
-            resourceBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-            currentCommandList->ResourceBarrier(1, &resourceBarrier);
+            currentCommandList->ResourceBarrier(ToRhi(currentFrameResources->GetBackBuffer()), RhiResourceState::Present, RhiResourceState::RenderTarget);
 
             // シーンのレンダリング
             if (SceneManager::GetActiveScene())
@@ -540,23 +723,17 @@ int WINAPI _tWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPTSTR lpszCm
                 SceneManager::GetActiveScene()->Render();
             }
 
+            // スプライトの並列記録でメインスレッドのコマンドリストが切り替わっているかもしれないので、取得し直す
+            currentCommandList = currentFrameResources->GetCommandList();
+
             // 「リソースバリア」コマンドをコマンドリストに追加する。
             // 
             //  レンダーターゲット(バックバッファ)のリソース状態を遷移させる。
             // 【レンダーターゲット状態】⇒【プレゼント可能状態】
-            resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-            resourceBarrier.Transition.pResource = currentFrameResources->GetBackBuffer();
-            resourceBarrier.Transition.Subresource = 0;
-            resourceBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-            resourceBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
-            resourceBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-            currentCommandList->ResourceBarrier(1, &resourceBarrier);
-
-            // コマンドリストを閉じる。
-            if (FAILED(currentCommandList->Close()))
-            {
-                assert(0);
-            }
+            currentCommandList->ResourceBarrier(ToRhi(currentFrameResources->GetBackBuffer()), RhiResourceState::RenderTarget, RhiResourceState::Present);
+
+            // このフレームの全てのコマンドリストを閉じる。
+            const std::vector<ID3D12CommandList*>& commandLists = currentFrameResources->CloseCommandLists();
 
             //---------------------------------------------------------------------------------------------------------------------------------------------
             // コマンドリスト内のコマンドを解釈してGPUコマンドを発行する。
@@ -565,31 +742,16 @@ int WINAPI _tWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPTSTR lpszCm
             // コマンドキューを取得
             ID3D12CommandQueue* commandQueue = GraphicsEngine::Instance().GetDefaultCommandQueue();
 
-            // コマンドリスト配列をコマンドキューに渡してGPUにコマンドを送信する
-            ID3D12CommandList* const commandLists[] =
-            {
-                currentCommandList,
-            };
-            commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
-
-            // フェンスを使ってGPU側の完了を待つ。
-            currentFrameResources->WaitForCompletion(commandQueue);
-
-            // コマンドアロケーターのリセット
-            ID3D12CommandAllocator* currentCommandAllocator = currentFrameResources->GetCommandAllocator();
-            if (FAILED(currentCommandAllocator->Reset()))
-            {
-                assert(0);
-            }
-
-            // コマンドリストのリセット
-            if (FAILED(currentCommandList->Reset(currentCommandAllocator, nullptr)))
-            {
-                assert(0);
-            }
+            // コマンドリスト配列を記録した順番のままコマンドキューに渡して、1回でGPUにコマンドを送信する
+            commandQueue->ExecuteCommandLists((UINT)commandLists.size(), commandLists.data());
 
             // 現在のバックバッファをフロントバッファとし、ディスプレイへの転送を開始する。
+            // (GPU側の完了は待たずに、次のフレームリソースに進む)
             GraphicsEngine::Instance().Present();
+
+            // 次のフレームリソースを使い始める。
+            // (そのフレームリソースを前回使ったGPU処理の完了だけを待ち、コマンドリストなどをリセットする)
+            GraphicsEngine::Instance().BeginFrame();
         }
     }
 
@@ -598,13 +760,49 @@ int WINAPI _tWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPTSTR lpszCm
     // GPU処理の完了を待つ
     GraphicsEngine::Instance().WaitForCompletion();
 
+    // シーンの破棄 (シーン内の全てのゲームオブジェクトとコンポーネントがメモリプールごとまとめて解放される)
+    if (Scene* activeScene = SceneManager::GetActiveScene())
+    {
+        activeScene->UnloadAssets();
+        SceneManager::SetActiveScene(nullptr);
+        delete activeScene;
+    }
+
+    // 読み込み中のテクスチャのアップロードの完了を待ち、テクスチャストリーマーの統計情報を出力する
+    GraphicsEngine::Instance().GetTextureStreamer()->WaitForAll();
+    GraphicsEngine::Instance().GetTextureStreamer()->PrintStats();
+
+    // アセットキャッシュの統計情報を出力して、未使用のアセットを解放する
+    AssetCache::PrintStats();
+    AssetCache::Clear();
+
     // グラフィックスリソースの解放
+    SpriteRendererBatch::UnloadAssets();
     d3d12PipelineState->Release();
     d3d12RootSignature->Release();
     vertexShader->Release();
     pixelShader->Release();
+
+    // バッファリソースの統計情報を出力する (実行中の最大値と、ここまでに解放されなかったもの)
+    BufferResource::PrintStats();
+
+    // シェーダーキャッシュの統計情報を出力して、キャッシュを解放する
+    ShaderCache::PrintStats();
+    ShaderCache::Clear();
+
+    // 新しく作成したパイプラインステートをキャッシュファイルに書き出して、キャッシュを解放する
+    PipelineStateCache::PrintStats();
+    PipelineStateCache::Save();
+    PipelineStateCache::Clear();
     GraphicsEngine::DestroySingletonInstance();
 
+    // アセットアーカイブの統計情報を出力して、マップを解除する (アーカイブを読むロードは全て完了している)
+    AssetArchive::PrintStats();
+    AssetArchive::Unmount();
+
+    // ジョブシステムの終了処理
+    JobSystem::DestroySingletonInstance();
+
     // タイマー分解能の復帰
     timeEndPeriod(1);
 
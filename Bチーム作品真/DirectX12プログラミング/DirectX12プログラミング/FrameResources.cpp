@@ -1,4 +1,8 @@
 ﻿#include "FrameResources.h"
+#include "UploadAllocator.h"
+#include "GraphicsEngine.h"
+#include "DepthStencil.h"
+#include <cstdio>
 #include <cassert>
 
 
@@ -7,32 +11,149 @@ FrameResources::FrameResources()
     , m_backBufferResource(nullptr)
     , m_commandAllocator(nullptr)
     , m_commandList(nullptr)
-    , m_fence(nullptr)
-    , m_fenceEvent(nullptr)
+    , m_rhiCommandList(nullptr)
+    , m_uploadAllocator(nullptr)
+    , m_numUsedPooledCommandLists(0)
+    , m_currentCommandList(nullptr)
+    , m_frameNumber(0)
 {
 }
 
 
-void FrameResources::WaitForCompletion(ID3D12CommandQueue* commandQueue)
+FrameResources::~FrameResources()
 {
-    // 今回の目標となるフェンス値 = 前回のフェンス値 + 1
-    const UINT64 completionValue = m_fence->GetCompletedValue() + 1;
+    ReleaseDeferredObjects();
+    delete m_uploadAllocator;
+    delete m_rhiCommandList;
 
-    // GPUにシグナルコマンドを送信する。
-    // GPU処理がこのコマンドまで到達した場合はフェンス値が第2引数の値に更新される。
-    if (FAILED(commandQueue->Signal(m_fence, completionValue)))
+    for (D3D12RhiCommandList* rhiCommandList : m_pooledRhiCommandLists)
+    {
+        delete rhiCommandList;
+    }
+    for (ID3D12GraphicsCommandList* commandList : m_pooledCommandLists)
+    {
+        commandList->Release();
+    }
+    for (ID3D12CommandAllocator* commandAllocator : m_pooledCommandAllocators)
+    {
+        commandAllocator->Release();
+    }
+}
+
+
+void FrameResources::ReleaseDeferredObjects()
+{
+    for (IUnknown* object : m_deferredReleases)
+    {
+        object->Release();
+    }
+    m_deferredReleases.clear();
+}
+
+
+RhiCommandList* FrameResources::AcquireCommandList()
+{
+    // 足りない場合はプールに追加する (閉じた状態にしておき、下で記録を始める)
+    if (m_numUsedPooledCommandLists == m_pooledCommandLists.size())
+    {
+        ID3D12Device* d3d12Device = GraphicsEngine::Instance().GetD3D12Device();
+
+        ID3D12CommandAllocator* commandAllocator;
+        if (FAILED(d3d12Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_ID3D12CommandAllocator, (void**)&commandAllocator)))
+        {
+            printf("[失敗] 追加のコマンドアロケーターの作成\n");
+            assert(0);
+        }
+
+        ID3D12GraphicsCommandList* commandList;
+        if (FAILED(d3d12Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator, nullptr, IID_ID3D12GraphicsCommandList, (void**)&commandList)))
+        {
+            printf("[失敗] 追加のコマンドリストの作成\n");
+            assert(0);
+        }
+        commandList->Close();
+
+        m_pooledCommandAllocators.push_back(commandAllocator);
+        m_pooledCommandLists.push_back(commandList);
+        m_pooledRhiCommandLists.push_back(new D3D12RhiCommandList(commandList));
+    }
+
+    // このフレームのGPU処理は BeginFrame() で待っているので、アロケーターごとリセットしてよい
+    ID3D12CommandAllocator* commandAllocator = m_pooledCommandAllocators[m_numUsedPooledCommandLists];
+    ID3D12GraphicsCommandList* commandList = m_pooledCommandLists[m_numUsedPooledCommandLists];
+    m_numUsedPooledCommandLists++;
+    if (FAILED(commandAllocator->Reset()) || FAILED(commandList->Reset(commandAllocator, nullptr)))
     {
         assert(0);
     }
 
-    // GPUがまだ処理を完了していない場合は・・・
-    if (m_fence->GetCompletedValue() < completionValue)
+    m_submitCommandLists.push_back(commandList);
+    return m_pooledRhiCommandLists[m_numUsedPooledCommandLists - 1];
+}
+
+
+RhiCommandList* FrameResources::ContinueCommandList()
+{
+    m_currentCommandList = (D3D12RhiCommandList*)AcquireCommandList();
+    ApplyDefaultGraphicsState(m_currentCommandList);
+    return m_currentCommandList;
+}
+
+
+void FrameResources::ApplyDefaultGraphicsState(RhiCommandList* commandList) const
+{
+    GraphicsEngine::Instance().ApplyDefaultGraphicsState(commandList);
+}
+
+
+RhiUploadAllocation FrameResources::AllocateUploadMemory(uint64_t size)
+{
+    const UploadAllocator::Allocation allocation = m_uploadAllocator->Allocate(size);
+    return RhiUploadAllocation{ allocation.cpuAddress, allocation.gpuAddress };
+}
+
+
+RhiCpuDescriptor FrameResources::GetDepthStencilView() const
+{
+    return ToRhi(GraphicsEngine::Instance().GetDepthStencil()->GetCPUDescriptorHandle());
+}
+
+
+uint32_t FrameResources::GetRenderTargetWidth() const
+{
+    return GraphicsEngine::Instance().GetSwapChainDesc().Width;
+}
+
+
+uint32_t FrameResources::GetRenderTargetHeight() const
+{
+    return GraphicsEngine::Instance().GetSwapChainDesc().Height;
+}
+
+
+const std::vector<ID3D12CommandList*>& FrameResources::CloseCommandLists()
+{
+    for (ID3D12CommandList* commandList : m_submitCommandLists)
     {
-        // 完了するまで永久に待つ
-        if (FAILED(m_fence->SetEventOnCompletion(completionValue, m_fenceEvent)))
+        if (FAILED(((ID3D12GraphicsCommandList*)commandList)->Close()))
         {
             assert(0);
         }
-        WaitForSingleObject(m_fenceEvent, INFINITE);
     }
+    return m_submitCommandLists;
+}
+
+
+void FrameResources::ResetCommandLists()
+{
+    if (FAILED(m_commandAllocator->Reset()) || FAILED(m_commandList->Reset(m_commandAllocator, nullptr)))
+    {
+        assert(0);
+    }
+
+    // 追加のコマンドリストは、次に取り出された時にリセットする
+    m_numUsedPooledCommandLists = 0;
+    m_submitCommandLists.clear();
+    m_submitCommandLists.push_back(m_commandList);
+    m_currentCommandList = m_rhiCommandList;
 }
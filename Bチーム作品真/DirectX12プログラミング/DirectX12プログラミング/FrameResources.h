@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include "D3D12Rhi.h"
 #include <cstdint>
 #include <d3d12.h>
 #include <dxgi1_6.h>
@@ -6,6 +7,7 @@
 
 // 前方宣言
 class GraphicsEngine;
+class UploadAllocator;
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // フレームリソースクラス
@@ -13,19 +15,27 @@ class GraphicsEngine;
 //      ・
 //      ・
 //      ・
-//      ・
+//      ・D3D12 のRHIコマンドコンテキストの実装。 (レンダラーはRHIのインターフェイス越しにコマンドを記録する)
 // 
 //---------------------------------------------------------------------------------------------------------------------------------------------
-class FrameResources
+class FrameResources : public RhiCommandContext
 {
 private:
     uint32_t                        m_backBufferIndex;      // レンダリング先となるバックバッファのインデックス
     ID3D12Resource*                 m_backBufferResource;   // レンダリング先となるバックバッファ
     ID3D12CommandAllocator*         m_commandAllocator;     // このフレームで使用するコマンドアロケーター
     ID3D12GraphicsCommandList*      m_commandList;          // このフレームで使用するコマンドリスト
-    ID3D12Fence*                    m_fence;                // このフレームで使用するフェンス
-    HANDLE                          m_fenceEvent;           // このフレームで使用するフェンスイベント
+    D3D12RhiCommandList*            m_rhiCommandList;       // m_commandList のRHIコマンドリスト
     D3D12_CPU_DESCRIPTOR_HANDLE     m_descHandleForRTV;     // このフレームでレンダーターゲットビュー(RTV)ディスクリプタへのポインタ
+    UploadAllocator*                m_uploadAllocator;      // このフレームで使用する定数データなどの確保先
+    std::vector<IUnknown*>          m_deferredReleases;     // このフレームのGPU処理が完了した後に解放するオブジェクト
+    std::vector<ID3D12CommandAllocator*>    m_pooledCommandAllocators;  // 追加のコマンドリスト用のコマンドアロケーター (コマンドリスト毎に1つ)
+    std::vector<ID3D12GraphicsCommandList*> m_pooledCommandLists;       // 追加のコマンドリスト (並列記録用。使っていない間は閉じておく)
+    std::vector<D3D12RhiCommandList*>       m_pooledRhiCommandLists;    // 追加のコマンドリストのRHIコマンドリスト
+    uint32_t                                m_numUsedPooledCommandLists;// このフレームで使用中の追加のコマンドリストの数
+    std::vector<ID3D12CommandList*>         m_submitCommandLists;       // このフレームでキューに送るコマンドリスト (送る順番に並ぶ)
+    D3D12RhiCommandList*                    m_currentCommandList;       // メインスレッドが現在記録しているコマンドリスト
+    uint64_t                                m_frameNumber;              // このフレームリソースで記録中のフレームの通し番号
     friend class GraphicsEngine;                            // GraphicsEngineクラスは友達
 
 public:
@@ -33,7 +43,7 @@ public:
     FrameResources();
 
     // デストラクタ
-    ~FrameResources() = default;
+    ~FrameResources() override;
 
     // バックバッファを取得します。
     ID3D12Resource* GetBackBuffer() const { return m_backBufferResource; }
@@ -41,19 +51,62 @@ public:
     // コマンドアロケーターを取得します。
     ID3D12CommandAllocator* GetCommandAllocator() const { return m_commandAllocator; }
 
-    // コマンドリストを取得します。
-    ID3D12GraphicsCommandList* GetCommandList() const { return m_commandList; }
-
-    // フェンスを取得します。
-    ID3D12Fence* GetFence() const { return m_fence; }
+    // メインスレッドが現在記録しているコマンドリストを取得します。
+    //   ・並列記録の後は ContinueCommandList() で新しいコマンドリストに切り替わるので、使う度に取得し直してください。
+    RhiCommandList* GetCommandList() override { return m_currentCommandList; }
 
-    // フェンスイベントを取得します。
-    HANDLE GetFenceEvent() const { return m_fenceEvent; }
+    // メインスレッドが現在記録しているコマンドリストを D3D12 のまま取得します。
+    //   ・RHIに無いコマンド(テクスチャのコピーなど)を記録する場合にだけ使ってください。
+    ID3D12GraphicsCommandList* GetD3D12CommandList() const { return m_currentCommandList->GetD3D12CommandList(); }
 
     // レンダーターゲットビューを取得します。
     const D3D12_CPU_DESCRIPTOR_HANDLE& GetCPUDescriptorHandleForRTV() const { return m_descHandleForRTV; }
 
-    // 前回のフレーム処理が完了するまで待機します。
-    void WaitForCompletion(ID3D12CommandQueue* commandQueue);
+    // このフレームで使用するアップロードアロケーターを取得します。
+    //   ・確保した領域はこのフレームのGPU処理が完了するまで有効です。
+    UploadAllocator* GetUploadAllocator() const { return m_uploadAllocator; }
+
+    // このフレームのGPU処理が完了した後に解放するオブジェクトを登録します。
+    void AddDeferredRelease(IUnknown* object) { m_deferredReleases.push_back(object); }
+
+    // 登録されたオブジェクトを全て解放します。 (このフレームのGPU処理が完了した後に呼び出してください)
+    void ReleaseDeferredObjects();
+
+    // 追加のコマンドリストを1つ取り出し、記録できる状態にして、キューに送る順番の末尾に加えます。
+    //   ・取り出しはメインスレッドで行い、記録は別のスレッドで行ってもかまいません。
+    //   ・取り出した順番にキューに送られるので、スレッドの完了順に関係なく結果は同じになります。
+    RhiCommandList* AcquireCommandList() override;
+
+    // 追加のコマンドリストを1つ取り出し、メインスレッドのコマンドリストをそれに切り替えます。
+    //   ・並列記録したコマンドリストの後ろに、メインスレッドの記録を続ける為に使います。
+    //   ・デフォルトのグラフィックスステートは設定済みの状態で返します。
+    RhiCommandList* ContinueCommandList() override;
+
+    // コマンドリストにデフォルトのグラフィックスステートを設定します。
+    void ApplyDefaultGraphicsState(RhiCommandList* commandList) const override;
+
+    // このフレームで使用するアップロードアロケーターから領域を切り出します。
+    RhiUploadAllocation AllocateUploadMemory(uint64_t size) override;
+
+    // レンダーターゲットビュー(バックバッファ)を取得します。
+    RhiCpuDescriptor GetRenderTargetView() const override { return ToRhi(m_descHandleForRTV); }
+
+    // 深度ステンシルビュー(デフォルト深度ステンシル)を取得します。
+    RhiCpuDescriptor GetDepthStencilView() const override;
+
+    // 描画先(バックバッファ)の幅を取得します。
+    uint32_t GetRenderTargetWidth() const override;
+
+    // 描画先(バックバッファ)の高さを取得します。
+    uint32_t GetRenderTargetHeight() const override;
+
+    // 記録中のフレームの通し番号を取得します。
+    uint64_t GetFrameNumber() const override { return m_frameNumber; }
+
+    // このフレームの全てのコマンドリストを閉じて、キューに送る順番に並んだ配列を返します。
+    const std::vector<ID3D12CommandList*>& CloseCommandLists();
+
+    // 全てのコマンドリストを記録し直せる状態に戻します。 (このフレームのGPU処理が完了した後に呼び出してください)
+    void ResetCommandLists();
 };
 
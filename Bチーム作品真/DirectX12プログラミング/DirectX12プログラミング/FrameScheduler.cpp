@@ -0,0 +1,48 @@
+﻿#include "FrameScheduler.h"
+#include "Rhi.h"
+#include <cassert>
+
+
+FrameScheduler::FrameScheduler(GpuTimeline* timeline, uint32_t numFramesInFlight)
+    : m_timeline(timeline)
+    , m_frameFenceValues(numFramesInFlight, 0)
+    , m_frameIndex(0)
+    , m_frameCount(0)
+    , m_stallCount(0)
+{
+    assert(timeline);
+    assert(numFramesInFlight > 0);
+}
+
+
+bool FrameScheduler::BeginFrame()
+{
+    // まだ一度も使っていないフレームリソースは待つ必要が無い
+    const uint64_t fenceValue = m_frameFenceValues[m_frameIndex];
+    if (fenceValue == 0)
+    {
+        return false;
+    }
+
+    // このフレームリソースを前回使ったGPU処理だけを待つ
+    if (m_timeline->GetCompletedValue() < fenceValue)
+    {
+        m_stallCount++;
+        m_timeline->WaitForValue(fenceValue);
+    }
+    return true;
+}
+
+
+void FrameScheduler::EndFrame()
+{
+    m_frameFenceValues[m_frameIndex] = m_timeline->Signal();
+    m_frameIndex = (m_frameIndex + 1) % (uint32_t)m_frameFenceValues.size();
+    m_frameCount++;
+}
+
+
+void FrameScheduler::WaitForIdle()
+{
+    m_timeline->WaitForValue(m_timeline->Signal());
+}
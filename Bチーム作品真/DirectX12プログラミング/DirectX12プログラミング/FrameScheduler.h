@@ -0,0 +1,56 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+// 前方宣言
+class GpuTimeline;
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// フレームスケジューラークラス
+//
+//      ・最大 N フレーム分のGPU処理を完了を待たずに積んでおき、CPUとGPUを並行して動かすクラス。
+//      ・フレームリソースの番号毎に、そのフレームの最後にシグナルしたフェンス値を覚えておく。
+//      ・フレームリソースを再利用する前に、そのフレームリソースの前回のフェンス値だけを待つ。
+//        (N フレーム前の処理が終わっていれば、CPUは待たずに次のフレームを記録できる)
+//      ・GPUとはGPUタイムライン越しに同期するので、GPUに直接は依存しない。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class FrameScheduler
+{
+private:
+    GpuTimeline* m_timeline;                    // 同期に使うGPUタイムライン (所有しない)
+    std::vector<uint64_t> m_frameFenceValues;   // フレームリソース毎の、前回シグナルしたフェンス値 (まだ使っていない場合は 0)
+    uint32_t m_frameIndex;                      // 現在のフレームリソースの番号
+    uint64_t m_frameCount;                      // これまでに終了したフレーム数
+    uint64_t m_stallCount;                      // フレームの開始時にGPUを待った回数
+
+public:
+    // コンストラクタ
+    //      第1引数 : [in] 同期に使うGPUタイムライン
+    //      第2引数 : [in] 同時に処理中にできるフレーム数 (フレームリソース数)
+    FrameScheduler(GpuTimeline* timeline, uint32_t numFramesInFlight);
+
+    // 現在のフレームリソースを使い始めます。
+    //   ・そのフレームリソースを前回使ったGPU処理が完了していない場合は、完了するまで待ちます。
+    //   ・前回使ったことがある(コマンドアロケーターなどのリセットが必要な)場合は true を返します。
+    bool BeginFrame();
+
+    // 現在のフレームの処理をキューに送り終えたことを記録し、次のフレームリソースに進みます。
+    //   ・ExecuteCommandLists() と Present() の後に呼び出してください。
+    void EndFrame();
+
+    // キューに送った全ての処理が完了するまで待ちます。
+    void WaitForIdle();
+
+    // 現在のフレームリソースの番号を取得します。
+    uint32_t GetFrameIndex() const { return m_frameIndex; }
+
+    // 同時に処理中にできるフレーム数を取得します。
+    uint32_t GetNumFramesInFlight() const { return (uint32_t)m_frameFenceValues.size(); }
+
+    // これまでに終了したフレーム数を取得します。
+    uint64_t GetFrameCount() const { return m_frameCount; }
+
+    // フレームの開始時にGPUを待った回数を取得します。 (GPUが律速になっているかの目安)
+    uint64_t GetStallCount() const { return m_stallCount; }
+};
@@ -4,6 +4,11 @@
 #include "Sprite.h"
 #include "SpriteRenderer.h"
 #include "Scene.h"
+#include "MemoryPool.h"
+#include "Quaternion.h"
+#include "NameTable.h"
+#include <algorithm>
+#include <cstdio>
 
 const TypeInfo& GameObject::GetTypeInfo()
 {
@@ -45,11 +50,13 @@ GameObject::GameObject(const char* name)
     : m_isActiveSelf(true)
     , m_scene(nullptr)
     , m_transform(nullptr)
+    , m_componentMask(0)
+    , m_isInNameIndex(false)
 {
-    if (name)
-    {
-        SetName(name);
-    }
+    memset(m_componentSlots, 0, sizeof(m_componentSlots));
+
+    // 名前が無い場合も空の名前として登録しておく
+    SetName(name ? name : "");
 
     // 所属するシーン
     m_scene = SceneManager::GetActiveScene();
@@ -61,6 +68,35 @@ GameObject::GameObject(const char* name)
 }
 
 
+GameObject::GameObject(const GameObject& original)
+    : Object(original)
+    , m_isActiveSelf(original.m_isActiveSelf)
+    , m_scene(SceneManager::GetActiveScene())
+    , m_name(original.m_name)
+    , m_nameID(original.m_nameID)
+    , m_transform(nullptr)
+    , m_componentMask(0)
+    , m_isInNameIndex(false)
+{
+    memset(m_componentSlots, 0, sizeof(m_componentSlots));
+}
+
+
+void* GameObject::operator new(size_t size)
+{
+    // コンストラクタと同じく、現在アクティブなシーンに所属する
+    MemoryPool* gameObjectPool = SceneManager::GetActiveScene()->m_gameObjectPool;
+    assert(size <= gameObjectPool->GetBlockSize());
+    return gameObjectPool->Allocate();
+}
+
+
+void GameObject::operator delete(void* p)
+{
+    MemoryPool::FromPointer(p)->Free(p);
+}
+
+
 bool GameObject::IsActiveInHierarchy() const
 {
     // 自身と全ての親を走査する
@@ -76,73 +112,263 @@ bool GameObject::IsActiveInHierarchy() const
 }
 
 
+void GameObject::SetName(const std::string& name)
+{
+    // 索引に登録済みの場合は、新しい名前で登録し直す
+    const bool isInNameIndex = m_isInNameIndex;
+    if (isInNameIndex)
+    {
+        m_scene->RemoveFromNameIndex(this);
+    }
+
+    m_name = name;
+    m_nameID = NameTable::Intern(m_name);
+
+    if (isInNameIndex)
+    {
+        m_scene->AddToNameIndex(this);
+    }
+}
+
+
 GameObject* GameObject::Find(const char* name)
 {
+    Scene* scene = SceneManager::GetActiveScene();
+    if (!scene || !name)
+    {
+        return nullptr;
+    }
+
+    // 先頭が '/' の場合はルートゲームオブジェクトだけが最初の名前の候補になる
+    const bool isAbsolutePath = (name[0] == '/');
+
+    // 最初の名前を取り出す
+    const char* rest = name;
+    std::string_view firstName;
+    if (!Transform::NextPathToken(rest, firstName))
+    {
+        return nullptr;
+    }
+
+    // 一度も使われたことのない名前であれば、索引を引くまでもない
+    const uint32_t firstNameID = NameTable::Find(firstName);
+    if (firstNameID == NameTable::InvalidID)
+    {
+        return nullptr;
+    }
+
+    // 最初の名前を持つゲームオブジェクトから、残りのパスを辿る
+    auto range = scene->m_gameObjectsByName.equal_range(firstNameID);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        Transform* candidate = it->second->GetTransform();
+        if (isAbsolutePath && candidate->GetParent())
+        {
+            continue;
+        }
+
+        Transform* found = (*rest != '\0') ? candidate->FindDescendant(rest) : candidate;
+        if (found && found->GetGameObject()->IsActiveInHierarchy())
+        {
+            return found->GetGameObject();
+        }
+    }
     return nullptr;
 }
 
 
+Object* GameObject::Clone(const Vector3* position, const Quaternion* rotation, Transform* parent, bool instantiateInWorldSpace) const
+{
+    GameObject* clone = CloneHierarchy();
+    Transform* transform = clone->GetTransform();
+
+    if (parent)
+    {
+        transform->SetParent(parent, instantiateInWorldSpace);
+    }
+
+    // 位置と向きが指定された場合はワールド空間での値として扱う
+    // (親の子にした後で設定するので、親の位置や向きに関係なくワールド空間で指定した値になる)
+    if (position)
+    {
+        transform->SetPosition(DirectX::XMFLOAT3(position->x, position->y, position->z));
+    }
+    if (rotation)
+    {
+        transform->SetRotation(DirectX::XMFLOAT4(rotation->x, rotation->y, rotation->z, rotation->w));
+    }
+
+    return clone;
+}
+
+
+GameObject* GameObject::CloneHierarchy() const
+{
+    Scene* scene = SceneManager::GetActiveScene();
+    std::vector<std::pair<const Transform*, Transform*>>& cloneStack = scene->m_cloneStack;
+
+    // 原本の階層を深さ優先で走査しながら、1回の走査で全てのゲームオブジェクトを複製する。
+    // (親は必ず子よりも先に複製されるので、子は複製済みの親に直接繋ぐことができる)
+    GameObject* rootClone = nullptr;
+    cloneStack.push_back(std::make_pair(m_transform, (Transform*)nullptr));
+    while (!cloneStack.empty())
+    {
+        const Transform* originalTransform = cloneStack.back().first;
+        Transform* cloneParent = cloneStack.back().second;
+        cloneStack.pop_back();
+
+        const GameObject* original = originalTransform->GetGameObject();
+        GameObject* clone = new GameObject(*original);
+
+        // コンポーネントを追加された順番に複製する (先頭は必ずTransform)
+        for (Component* originalComponent : original->m_components)
+        {
+            Component* component = originalComponent->m_cloneFunction(*originalComponent, *scene);
+            component->SetGameObject(clone);
+            if (originalComponent == original->m_transform)
+            {
+                clone->m_transform = static_cast<Transform*>(component);
+            }
+
+            // OnAttach()ではシーンへの登録だけを行う (Transformのデータの格納場所の確保、カメラの登録など)
+            component->OnAttach();
+            clone->m_components.push_back(component);
+            clone->RegisterComponentSlots(component, component->m_typeMask);
+            clone->NotifyComponentAdded(component);
+        }
+
+        // トランスフォームシステムに確保されたデータを原本と同じ値にする
+        Transform* transform = clone->m_transform;
+        transform->SetLocalScale(originalTransform->GetLocalScale());
+        transform->SetLocalRotation(originalTransform->GetLocalRotation());
+        transform->SetLocalPosition(originalTransform->GetLocalPosition());
+
+        if (cloneParent)
+        {
+            // 複製済みの親の子として直接繋ぐ (親の方が先にトランスフォームシステムに追加されているので並べ替えは不要)
+            transform->LinkToParent(cloneParent);
+            scene->AddToNameIndex(clone);
+        }
+        else
+        {
+            scene->AddNewGameObject(clone);
+            rootClone = clone;
+        }
+
+        // 子リストの順番通りに複製されるように、逆順に積む
+        const std::list<Transform*>& children = originalTransform->GetChildren();
+        for (auto it = children.rbegin(); it != children.rend(); ++it)
+        {
+            cloneStack.push_back(std::make_pair((const Transform*)*it, transform));
+        }
+    }
+
+    return rootClone;
+}
+
+
 GameObject::~GameObject()
 {
     // 所有する全てのコンポーネントを解放
     for (auto& component : m_components)
     {
+        m_scene->OnComponentRemoved(component);
+        component->OnDetach();
         component->Release();
     }
     m_components.clear();
 }
 
 
-void GameObject::Update()
+void GameObject::Destroy(float time)
 {
-    // 全てのコンポーネントを走査する
-    for (Component* component : m_components)
+    m_scene->ScheduleDestroy(this, time);
+}
+
+
+void GameObject::DestroyImmediate(bool allowDestroyingAssets)
+{
+    m_scene->DestroyGameObjectImmediate(this);
+}
+
+
+void GameObject::DontDestroyOnLoad()
+{
+    // 子孫だけを別のシーンに移動することはできない
+    if (m_transform->GetParent())
     {
-        component->Update();
+        printf("[失敗] %s の DontDestroyOnLoad() (ルートゲームオブジェクトではありません)\n", m_name.c_str());
+        assert(0);
+        return;
     }
 
-    // 子Transformに伝播させる
-    std::list<Transform*> children = m_transform->GetChildren();
-    for (Transform* child : children)
+    SceneManager::AddDontDestroyOnLoad(this);
+}
+
+
+void GameObject::NotifyComponentAdded(Component* component)
+{
+    m_scene->OnComponentAdded(component);
+}
+
+
+void GameObject::RegisterComponentSlots(Component* component, uint32_t typeMask)
+{
+    for (size_t i = 0; i < (size_t)ComponentTypeIndex::MaxNumComponentTypes; i++)
     {
-        child->GetGameObject()->Update();
+        const uint32_t bit = 1u << i;
+
+        // 同じデータ型のコンポーネントを既に持っている場合は、先に追加された方を優先する
+        if ((typeMask & bit) && !(m_componentMask & bit))
+        {
+            m_componentSlots[i] = component;
+        }
     }
+
+    m_componentMask |= typeMask;
 }
 
 
-void GameObject::Render()
+void GameObject::RemoveComponent(Component* component)
 {
-    // 全てのコンポーネントを走査する
-    for (Component* component : m_components)
+    // Transformが無いゲームオブジェクトは存在できない
+    if (component == m_transform)
     {
-        component->Render();
+        printf("[失敗] Transformコンポーネントの破棄 (ゲームオブジェクトごと破棄してください)\n");
+        assert(0);
+        return;
     }
 
-    // 子Transformに伝播させる
-    const std::list<Transform*>& children = m_transform->GetChildren();
-    for (Transform* child : children)
+    auto it = std::find(m_components.begin(), m_components.end(), component);
+    assert(it != m_components.end());
+    m_components.erase(it);
+
+    // 取り外したコンポーネントの欄に別のコンポーネントが入るかもしれないので、コンポーネントテーブルを作り直す
+    m_componentMask = 0;
+    memset(m_componentSlots, 0, sizeof(m_componentSlots));
+    for (Component* remaining : m_components)
     {
-        child->GetGameObject()->Render();
+        RegisterComponentSlots(remaining, remaining->m_typeMask);
     }
+
+    m_scene->OnComponentRemoved(component);
+    component->OnDetach();
+    component->Release();
 }
 
 
-void GameObject::BroadcastMessage(const std::function<void(MonoBehaviour* monoBehaviour)>& clojure)
+void GameObject::Render()
 {
     // 全てのコンポーネントを走査する
     for (Component* component : m_components)
     {
-        // MonoBehaviourを継承したスクリプトの場合は
-        if (MonoBehaviour* monoBehaviour = component->AsMonoBehaviour())
-        {
-            clojure(monoBehaviour);
-        }
+        component->Render();
     }
 
     // 子Transformに伝播させる
     const std::list<Transform*>& children = m_transform->GetChildren();
     for (Transform* child : children)
     {
-        child->GetGameObject()->BroadcastMessage(clojure);
+        child->GetGameObject()->Render();
     }
 }
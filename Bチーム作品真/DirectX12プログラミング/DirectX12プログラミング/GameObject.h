@@ -1,5 +1,7 @@
 ﻿#pragma once
 #include <vector>
+#include <list>
+#include <unordered_map>
 #include <cassert>
 #include "Object.h"
 #include "Vector2.h"
@@ -29,10 +31,18 @@ private:
     bool m_isActiveSelf;                    // このゲームオブジェクトがアクティブな場合は true
     Scene* m_scene;                         // このゲームオブジェクトが所属するシーンへの参照
     std::string m_name;                     // このゲームオブジェクトの名前
+    uint32_t m_nameID;                      // 名前テーブルに登録された名前のID (大文字と小文字を区別しない)
     std::vector<Component*> m_components;   // コンポーネント配列
     Transform* m_transform;                 // Transformコンポーネントへのショートカット
+    uint32_t m_componentMask;               // 所有しているコンポーネントのデータ型(基底クラスを含む)を表すビットマスク
+    Component* m_componentSlots[(size_t)ComponentTypeIndex::MaxNumComponentTypes];  // データ型の連番毎に、最初に追加されたコンポーネント
+    std::list<GameObject*>::iterator m_rootIterator;    // ルートゲームオブジェクトリスト内での位置 (親を持たない場合のみ有効)
+    std::unordered_multimap<uint32_t, GameObject*>::iterator m_nameIterator;        // シーンの名前検索用の索引内での位置
+    std::unordered_multimap<uint64_t, Transform*>::iterator m_childNameIterator;    // シーンの子Transform検索用の索引内での位置
+    bool m_isInNameIndex;                   // シーンの名前検索用の索引に登録済みの場合は true
     friend class Scene;                     // Sceneクラスは友達
     friend class Camera;                    // Cameraクラスは友達
+    friend class Component;                 // Componentクラスは友達
 
 public:
     // このデータ型の情報を返します。
@@ -50,8 +60,14 @@ public:
     // 引数付きコンストラクタ
     GameObject(const char* name);
 
+    // 現在アクティブなシーンのメモリプールからメモリを確保します。
+    static void* operator new(size_t size);
+
+    // メモリを確保したメモリプールに返却します。
+    static void operator delete(void* p);
+
     // このオブジェクトの識別名を設定します。
-    void SetName(const std::string& name) override { m_name = name; }
+    void SetName(const std::string& name) override;
 
     // このオブジェクトの識別名を取得します。
     const std::string& GetName() const override { return m_name; }
@@ -74,13 +90,21 @@ public:
     ComponentType* AddComponent();
 
     // 指定したタイプと一致するコンポーネントを取得します。
+    //      ・基底クラスを指定した場合は、その派生クラスのコンポーネントも見つかります。 (例: Renderer を指定して SpriteRenderer を取得)
+    //      ・同じタイプのコンポーネントが複数ある場合は、最初に追加されたものを返します。
     template<typename ComponentType>
     ComponentType* GetComponent() const;
 
+    // 指定したタイプのコンポーネントを持っている場合は true を返します。
+    template<typename ComponentType>
+    bool HasComponent() const;
+
     // 指定した名前を持つゲームオブジェクトを検索します。
     //      ・複数のシーンが実行されている場合はそれら全てのシーン内を検索します。
     //      ・この関数はアクティブなゲームオブジェクトのみを返します。
     //      ・引数name に '/' の文字が含まれている場合は、パス名のように階層を走査します。
+    //        (先頭が '/' の場合は、ルートゲームオブジェクトから走査します)
+    //      ・名前は大文字と小文字(ASCIIのみ)を区別せずに、全体が一致するものを探します。
     //      ・ゲームオブジェクトが見つからない場合は nullptr を返します。
     //      ・子ゲームオブジェクトを検索する場合は Transform::Find()を使用した方が簡単です。
     static GameObject* Find(const char* name);
@@ -89,23 +113,55 @@ private:
     // デストラクタ
     ~GameObject();
 
+    // コピーコンストラクタ (名前とアクティブ状態だけをコピーします。 コンポーネントは CloneHierarchy() で複製されます)
+    GameObject(const GameObject& original);
+
+    // Object::Clone()をオーバーライドします。 (子孫とコンポーネントをまとめて複製します)
+    Object* Clone(const Vector3* position, const Quaternion* rotation, Transform* parent, bool instantiateInWorldSpace) const override;
+
+    // このゲームオブジェクトと子孫を、アクティブなシーンのルートゲームオブジェクトとして複製します。
+    //      ・コンポーネントはコピーコンストラクタで状態ごと複製され、Awake()やStart()は呼び出されません。
+    //      ・コンポーネントが持つポインターはそのままコピーされます。 (複製先の子孫を指すように付け替えられることはありません)
+    GameObject* CloneHierarchy() const;
+
+    // Object::Destroy()をオーバーライドします。 (所属するシーンで破棄を予約します)
+    void Destroy(float time) override;
+
+    // Object::DestroyImmediate()をオーバーライドします。 (子孫もまとめて破棄します)
+    void DestroyImmediate(bool allowDestroyingAssets) override;
+
+    // Object::DontDestroyOnLoad()をオーバーライドします。 (ルートゲームオブジェクトのみ、子孫ごと新しいシーンに移動されます)
+    void DontDestroyOnLoad() override;
+
     // このゲームオブジェクトにコンポーネントを追加します。 (内部専用バージョン)
     template<typename ComponentType>
     ComponentType* InternalAddComponent();
 
+    // ComponentType専用のメモリプールの番号を取得します。 (データ型毎に、最初の呼び出し時に割り当てられます)
+    template<typename ComponentType>
+    static uint32_t GetComponentPoolIndex();
+
+    // コピーコンストラクタで original の複製を生成します。 (Component::m_cloneFunction に設定されます)
+    template<typename ComponentType>
+    static Component* CloneComponent(const Component& original, Scene& scene);
+
     // 明示的特殊化によりTransformコンポーネントの追加を抑制する。
     // (クラス外部からTransformコンポーネントを追加されると困る)
     template<>
     Transform* AddComponent() { assert(0); return nullptr; }
 
-    // このゲームオブジェクトが所有する全てのコンポーネントに対して更新命令を出します。
-    void Update();
+    // コンポーネントが追加されたことを所属するシーンに通知します。
+    void NotifyComponentAdded(Component* component);
+
+    // 指定したデータ型(基底クラスを含む)の欄が空いていれば、コンポーネントテーブルに登録します。
+    void RegisterComponentSlots(Component* component, uint32_t typeMask);
+
+    // 指定したコンポーネントを取り外して破棄します。
+    //      ・Transformコンポーネントを取り外すことはできません。 (ゲームオブジェクトごと破棄してください)
+    void RemoveComponent(Component* component);
 
     // このゲームオブジェクトが所有する全てのコンポーネントに対して描画命令を出します。
     void Render();
-
-    // このゲームオブジェクトが所有する全ての MonoBehaviour に対してメッセージを送信します。
-    void BroadcastMessage(const std::function<void(MonoBehaviour*)>& clojure);
 };
 
 
@@ -117,6 +173,7 @@ private:
 
 
 #include "MonoBehaviour.h"
+#include "Scene.h"
 
 //--------------------------------------------------------------------------------------
 // ※注意
@@ -138,15 +195,32 @@ inline ComponentType* GameObject::InternalAddComponent()
 {
     // ComponentTypeは未知のデータ型であり、この関数の呼び出し時にデータ型が決定される。
     // ComponentTypeはComponentクラスを継承しているはず・・・
-    ComponentType* component = new ComponentType();
+    // (同じデータ型のコンポーネントは、シーンが持つ同じメモリプールから連続して確保される)
+    MemoryPool& componentPool = m_scene->GetComponentPool(GetComponentPoolIndex<ComponentType>(), sizeof(ComponentType), alignof(ComponentType));
+    ComponentType* component = new (componentPool) ComponentType();
 
     // コンポーネントの所有者として自分を設定する。
     component->SetGameObject(this);
+    component->m_typeMask = ComponentType::TypeMask;
+    component->m_cloneFunction = &GameObject::CloneComponent<ComponentType>;
+
+    // オーバーライドされているコールバック関数だけがシーンから呼び出されるように、コンパイル時に調べておく
+    if constexpr (std::is_base_of_v<MonoBehaviour, ComponentType>)
+    {
+        component->m_callbackFlags = MonoBehaviour::GetCallbackFlags<ComponentType>();
+    }
+    component->m_allowsParallelUpdate = ComponentType::AllowParallelUpdate();
     component->OnAttach();
 
     // ComponentTypeが何型かは不明だが可変長配列に格納しておく。
     m_components.push_back(component);
 
+    // 基底クラスのデータ型でも検索できるように、コンポーネントテーブルに登録しておく。
+    RegisterComponentSlots(component, ComponentType::TypeMask);
+
+    // シーンの更新対象に加えてもらう
+    NotifyComponentAdded(component);
+
     // MonoBehaviour派生コンポーネントの場合はこのタイミングで Awake()、Start() しておく。
     // (Unityとはシーンの仕様が異なる為)
     if (MonoBehaviour* monoBehaviour = component->AsMonoBehaviour())
@@ -159,29 +233,46 @@ inline ComponentType* GameObject::InternalAddComponent()
 }
 
 
+template<typename ComponentType>
+inline uint32_t GameObject::GetComponentPoolIndex()
+{
+    static const uint32_t componentPoolIndex = Scene::AllocateComponentPoolIndex();
+    return componentPoolIndex;
+}
+
+
+template<typename ComponentType>
+inline Component* GameObject::CloneComponent(const Component& original, Scene& scene)
+{
+    // 複製先のシーンが持つ、同じデータ型用のメモリプールから確保する
+    MemoryPool& componentPool = scene.GetComponentPool(GetComponentPoolIndex<ComponentType>(), sizeof(ComponentType), alignof(ComponentType));
+
+    // 通常のコンストラクタではなくコピーコンストラクタを使い、状態をまとめて複製する
+    return new (componentPool) ComponentType(static_cast<const ComponentType&>(original));
+}
+
+
 template<typename ComponentType>
 inline ComponentType* GameObject::GetComponent() const
 {
-    // 検索したいコンポーネントのデータ型IDを取得する
-    const TypeID searchTargetTypeID = ComponentType::GetTypeInfo().GetTypeID();
+    // 検索したいコンポーネントのデータ型の連番 (コンパイル時に決定される)
+    constexpr size_t typeIndex = (size_t)ComponentType::TypeIndex;
 
-    // コンポーネント配列内から同じデータ型IDを持つコンポーネントを検索する
-    // (コンポーネント数が多い場合、この検索方法はあまり効率的ではないかもしれない)
-    for (Component* component : m_components)
+    // 所有していなければ、コンポーネントテーブルを見るまでもない
+    if (!HasComponent<ComponentType>())
     {
-        // 現在列挙中のコンポーネントのデータ型IDを取得する
-        const TypeID currentTypeID = component->GetTypeInfoOfInstance().GetTypeID();
-
-        // データ型IDが一致するか？
-        if (currentTypeID == searchTargetTypeID)
-        {
-            // コンポーネントが見つかった！
-            return (ComponentType*)component;
-        }
+        return nullptr;
     }
 
-    // 見つからなかった…
-    return nullptr;
+    // コンポーネント数に関係なく、配列を1回参照するだけで見つかる
+    return static_cast<ComponentType*>(m_componentSlots[typeIndex]);
+}
+
+
+template<typename ComponentType>
+inline bool GameObject::HasComponent() const
+{
+    return (m_componentMask & ToComponentTypeMask(ComponentType::TypeIndex)) != 0;
 }
 
 
@@ -0,0 +1,42 @@
+﻿#include "GpuTimeline.h"
+#include <cstdio>
+#include <cassert>
+
+
+D3D12GpuTimeline::D3D12GpuTimeline(ID3D12CommandQueue* commandQueue, ID3D12Fence* fence, HANDLE fenceEvent)
+    : m_commandQueue(commandQueue)
+    , m_fence(fence)
+    , m_fenceEvent(fenceEvent)
+    , m_lastSignaledValue(fence->GetCompletedValue())
+{
+}
+
+
+uint64_t D3D12GpuTimeline::Signal()
+{
+    // フェンス値はキュー毎に単調増加させる
+    const uint64_t value = ++m_lastSignaledValue;
+    if (FAILED(m_commandQueue->Signal(m_fence, value)))
+    {
+        printf("[失敗] ID3D12CommandQueue::Signal()\n");
+        assert(0);
+    }
+    return value;
+}
+
+
+void D3D12GpuTimeline::WaitForValue(uint64_t value)
+{
+    // この時点で既に到達していることもあるので調べる
+    if (m_fence->GetCompletedValue() >= value)
+    {
+        return;
+    }
+
+    // 到達したら完了通知イベントがONになるようにして、ひたすら待つ
+    if (FAILED(m_fence->SetEventOnCompletion(value, m_fenceEvent)))
+    {
+        assert(0);
+    }
+    WaitForSingleObject(m_fenceEvent, INFINITE);
+}
@@ -0,0 +1,34 @@
+﻿#pragma once
+#include "Rhi.h"
+#include <d3d12.h>
+#include <windows.h>
+#include <cstdint>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// D3D12 GPUタイムラインクラス
+//
+//      ・ID3D12CommandQueue と ID3D12Fence によるGPUタイムラインの実装。
+//      ・コマンドキュー、フェンス、フェンスイベントは所有しない。(作成した側が解放すること)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class D3D12GpuTimeline : public GpuTimeline
+{
+private:
+    ID3D12CommandQueue* m_commandQueue;     // シグナルを追加するコマンドキュー
+    ID3D12Fence* m_fence;                   // フェンス
+    HANDLE m_fenceEvent;                    // フェンスイベント
+    uint64_t m_lastSignaledValue;           // 最後にシグナルしたフェンス値
+
+public:
+    // コンストラクタ
+    D3D12GpuTimeline(ID3D12CommandQueue* commandQueue, ID3D12Fence* fence, HANDLE fenceEvent);
+
+    // これまでにキューに送った処理の後ろにシグナルを追加し、そのフェンス値を返します。
+    uint64_t Signal() override;
+
+    // GPUが到達したフェンス値を取得します。
+    uint64_t GetCompletedValue() override { return m_fence->GetCompletedValue(); }
+
+    // GPUが指定したフェンス値に到達するまで、CPUを待機させます。
+    void WaitForValue(uint64_t value) override;
+};
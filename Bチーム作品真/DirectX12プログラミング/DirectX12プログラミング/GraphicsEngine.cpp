@@ -1,5 +1,10 @@
 ﻿#include "GraphicsEngine.h"
 #include "FrameResources.h"
+#include "UploadAllocator.h"
+#include "DescriptorAllocator.h"
+#include "TextureStreamer.h"
+#include "GpuTimeline.h"
+#include "FrameScheduler.h"
 #include "DepthStencil.h"
 #include <cstdio>
 #include <cassert>
@@ -33,7 +38,14 @@ GraphicsEngine::GraphicsEngine()
     , m_defaultFenceEvent(nullptr)
     , m_defaultDepthStencil(nullptr)
     , m_frameResourcesIndex(0)
+    , m_gpuTimeline(nullptr)
+    , m_frameScheduler(nullptr)
+    , m_defaultRootSignature(nullptr)
+    , m_defaultPipelineState(nullptr)
     , m_descHeapForRTVs(nullptr)
+    , m_descriptorAllocator(nullptr)
+    , m_textureStreamer(nullptr)
+    , m_commandContextOverride(nullptr)
 {
     memset(&m_dxgiSwapChainDesc, 0, sizeof(m_dxgiSwapChainDesc));
 }
@@ -41,6 +53,18 @@ GraphicsEngine::GraphicsEngine()
 
 GraphicsEngine::~GraphicsEngine()
 {
+    // 完了を待っているアップロードがテクスチャを解放するかもしれないので、フレームリソースより先に破棄する
+    delete m_textureStreamer;
+
+    for (FrameResources* frameResources : m_frameResourcesList)
+    {
+        delete frameResources;
+    }
+    m_frameResourcesList.clear();
+    delete m_descriptorAllocator;
+    delete m_frameScheduler;
+    delete m_gpuTimeline;
+
     CloseHandle(m_defaultFenceEvent);
     m_defaultFence->Release();
     m_defaultDepthStencil->Release();
@@ -60,6 +84,8 @@ void GraphicsEngine::Create(HWND hWnd, uint32_t backBufferWidth, uint32_t backBu
     m_defaultFence = CreateFence(m_d3d12Device, 1);
     CreateSwapChain(m_defaultCommandQueue, hWnd, backBufferWidth, backBufferHeight);
     CreateFrameResourcesList(NumFrameResources);
+    m_descriptorAllocator = new DescriptorAllocator(m_d3d12Device, DescriptorAllocator::DefaultNumPersistentDescriptors, DescriptorAllocator::DefaultNumTransientDescriptors, NumFrameResources);
+    m_textureStreamer = new TextureStreamer(m_d3d12Device);
 }
 
 
@@ -528,45 +554,102 @@ void GraphicsEngine::CreateFrameResourcesList(uint32_t numFrameResourcesSets)
         frameResources->m_descHandleForRTV = cpuDescriptorHandle;
         frameResources->m_commandAllocator = CreateDirectCommadAllocator(m_d3d12Device);
         frameResources->m_commandList = CreateDirectCommadList(m_d3d12Device, frameResources->m_commandAllocator);
-        frameResources->m_fence = CreateFence(m_d3d12Device, 1);
-        frameResources->m_fenceEvent = CreateFenceEvent();
+        frameResources->m_uploadAllocator = new UploadAllocator();
+        frameResources->m_rhiCommandList = new D3D12RhiCommandList(frameResources->m_commandList);
+        frameResources->m_currentCommandList = frameResources->m_rhiCommandList;
+        frameResources->m_submitCommandLists.push_back(frameResources->m_commandList);
         m_frameResourcesList.push_back(frameResources);
     }
+
+
+    //---------------------------------------------------------------------------------------------------------------------------------------------
+    // フレームスケジューラーの作成
+    //
+    //  フレームリソース毎に前回のフェンス値を覚えておき、再利用する前にその値だけを待つ。
+    //  フェンスはデフォルトフェンス1つを共有し、フェンス値はシグナルの度に1ずつ増やす。
+    //---------------------------------------------------------------------------------------------------------------------------------------------
+    m_defaultFenceEvent = CreateFenceEvent();
+    m_gpuTimeline = new D3D12GpuTimeline(m_defaultCommandQueue, m_defaultFence, m_defaultFenceEvent);
+    m_frameScheduler = new FrameScheduler(m_gpuTimeline, numFrameResourcesSets);
 }
 
 
 void GraphicsEngine::WaitForCompletion()
 {
-    // フェンスに書き込む値
-    const UINT64 completionValue = m_defaultFence->GetCompletedValue() + 1;
+    // これまでにキューに送った全ての処理の後ろにシグナルを追加して、その完了を待つ
+    m_frameScheduler->WaitForIdle();
+}
 
-    //---------------------------------------------------------------------------------------------------------------------------------------------
-    // コマンドキューにシグナルコマンドを追加します。
-    // 
-    //  ID3D12CommandQueue::Signal
-    //  (
-    //      第1引数 : [入力] フェンス
-    //      第2引数 : [入力] GPUの処理完了時にフェンスに書き込む値
-    //       戻り値 : 成否を表す整数値 (0未満の場合は失敗、0以上の場合は成功)
-    //  )
-    //---------------------------------------------------------------------------------------------------------------------------------------------
-    if (FAILED(m_defaultCommandQueue->Signal(m_defaultFence, completionValue)))
+
+void GraphicsEngine::SetDefaultGraphicsState(ID3D12RootSignature* rootSignature, ID3D12PipelineState* pipelineState)
+{
+    m_defaultRootSignature = rootSignature;
+    m_defaultPipelineState = pipelineState;
+}
+
+
+void GraphicsEngine::ApplyDefaultGraphicsState(RhiCommandList* commandList) const
+{
+    // 「パイプラインステートオブジェクトを設定」コマンドをコマンドリストに追加する。
+    commandList->SetPipelineState(ToRhi(m_defaultPipelineState));
+
+    // 「グラフィックスパイプライン用ルートシグネチャを設定」コマンドをコマンドリストに追加する。
+    commandList->SetGraphicsRootSignature(ToRhi(m_defaultRootSignature));
+
+    // 「ディスクリプタヒープを設定」コマンドをコマンドリストに追加する。
+    // (全てのテクスチャが同じヒープにあるので、コマンドリストの途中で切り替える必要はない)
+    commandList->SetDescriptorHeap(ToRhi(m_descriptorAllocator->GetDescriptorHeap()));
+}
+
+
+RhiCommandContext* GraphicsEngine::GetCurrentCommandContext() const
+{
+    if (m_commandContextOverride)
     {
-        assert(0);
+        return m_commandContextOverride;
     }
+    return GetCurrentFrameResources();
+}
 
-    // この時点でフェンスの現在値が完了値に到達していることもあるので調べる。
-    if (m_defaultFence->GetCompletedValue() < completionValue)
+
+void GraphicsEngine::SetCommandContextOverride(RhiCommandContext* commandContext)
+{
+    m_commandContextOverride = commandContext;
+}
+
+
+void GraphicsEngine::ReleaseAfterGpuCompletion(IUnknown* object)
+{
+    // 現在のフレームリソースが次に使われる時には、今までにキューに送った処理は全て完了している
+    GetCurrentFrameResources()->AddDeferredRelease(object);
+}
+
+
+void GraphicsEngine::BeginFrame()
+{
+    // このフレームリソースを前回使ったGPU処理の完了だけを待つ
+    // (N フレーム前の処理なので、GPUが遅れていなければ待たずに済む)
+    FrameResources* frameResources = GetCurrentFrameResources();
+    if (m_frameScheduler->BeginFrame())
     {
-        // まだ到達していないので完了通知イベントをONにする
-        if (FAILED(m_defaultFence->SetEventOnCompletion(completionValue, m_defaultFenceEvent)))
-        {
-            assert(0);
-        }
+        // コマンドアロケーターとコマンドリストのリセット (並列記録用の追加のコマンドリストも含む)
+        frameResources->ResetCommandLists();
+
+        // アップロードアロケーターのリセット (GPUが読み終わったので先頭から使い直せる)
+        frameResources->GetUploadAllocator()->Reset();
 
-        // 完了通知をひたすら待つ
-        WaitForSingleObject(m_defaultFenceEvent, INFINITE);
+        // 前回このフレームリソースで解放を待っていたオブジェクトを解放する
+        frameResources->ReleaseDeferredObjects();
     }
+
+    // これから記録するフレームの通し番号
+    frameResources->m_frameNumber = m_frameScheduler->GetFrameCount();
+
+    // 共有ディスクリプタヒープの、このフレームの一時領域と解放待ちの番号を使い直せるようにする
+    m_descriptorAllocator->BeginFrame(m_frameResourcesIndex);
+
+    // アップロードが完了したテクスチャを描画できるようにして、デコードが済んだテクスチャをコピーキューに送る
+    m_textureStreamer->Update();
 }
 
 
@@ -588,7 +671,8 @@ void GraphicsEngine::Present()
         assert(0);
     }
 
-    // 次のフレームの処理へ
-    m_frameResourcesIndex = (m_frameResourcesIndex + 1) % m_frameResourcesList.size();
+    // このフレームのフェンス値を記録して、次のフレームの処理へ (GPUの完了は待たない)
+    m_frameScheduler->EndFrame();
+    m_frameResourcesIndex = m_frameScheduler->GetFrameIndex();
 }
 
@@ -10,6 +10,12 @@
 // 前方宣言
 class DepthStencil;
 class FrameResources;
+class DescriptorAllocator;
+class TextureStreamer;
+class GpuTimeline;
+class FrameScheduler;
+class RhiCommandContext;
+class RhiCommandList;
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // グラフィックエンジンクラス
@@ -20,11 +26,16 @@ class FrameResources;
 //      ・Directコマンドキューを持つ。
 //      ・スワップチェーン情報を持つ。
 //      ・フレームリソース配列を持つ。
+//      ・フレームスケジューラーを持ち、最大でフレームリソース数分のフレームをGPUの完了を待たずに処理する。
 //      ・バックバッファと互換性のある深度ステンシルを持つ。
+//      ・全てのテクスチャが共有する、シェーダーから見えるディスクリプタヒープを持つ。
+//      ・テクスチャをコピーキューで非同期にアップロードする、テクスチャストリーマーを持つ。
+//      ・レンダラーが記録に使うRHIコマンドコンテキストを決める。(通常は現在のフレームリソース)
 // 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 class GraphicsEngine
 {
+public:
     static constexpr int NumBackBuffers = 2;                        // バックバッファ数
     static constexpr int NumFrameResources = NumBackBuffers * 2;    // フレームリソース数
 
@@ -39,7 +50,14 @@ private:
     DepthStencil*                   m_defaultDepthStencil;          // デフォルト深度ステンシル
     std::vector<FrameResources*>    m_frameResourcesList;           // フレームリソース配列
     uint32_t                        m_frameResourcesIndex;          // フレームリソースの現在のインデックス
+    GpuTimeline*                    m_gpuTimeline;                  // デフォルトコマンドキューとデフォルトフェンスのGPUタイムライン
+    FrameScheduler*                 m_frameScheduler;               // フレームスケジューラー
+    ID3D12RootSignature*            m_defaultRootSignature;         // コマンドリストの先頭で設定するルートシグネチャ
+    ID3D12PipelineState*            m_defaultPipelineState;         // コマンドリストの先頭で設定するパイプラインステート
     ID3D12DescriptorHeap*           m_descHeapForRTVs;              // レンダーターゲットビュー用ディスクリプタヒープ
+    DescriptorAllocator*            m_descriptorAllocator;          // シェーダーから見えるディスクリプタヒープ (CBV/SRV/UAV用)
+    TextureStreamer*                m_textureStreamer;              // テクスチャのデコードとアップロードを非同期に行う
+    RhiCommandContext*              m_commandContextOverride;       // フレームリソースの代わりに使うRHIコマンドコンテキスト (使わない場合は nullptr)
     friend class Application;                                       // アプリケーションクラスは友達
 
 private:
@@ -98,11 +116,55 @@ public:
     // 現在のフレームリソースセットを取得します。
     FrameResources* GetCurrentFrameResources() const { return m_frameResourcesList[m_frameResourcesIndex]; }
 
+    // レンダラーがコマンドを記録するRHIコマンドコンテキストを取得します。
+    //   ・SetCommandContextOverride() で差し替えていなければ、現在のフレームリソースを返します。
+    RhiCommandContext* GetCurrentCommandContext() const;
+
+    // レンダラーがコマンドを記録するRHIコマンドコンテキストを差し替えます。 (nullptr で元に戻します)
+    //   ・ヌルRHIでシーンの描画を計測する為に使います。
+    //   ・スプライトバッチのリングバッファは実際のGPUメモリのままなので、WaitForCompletion() でGPU処理の完了を待ってから差し替えてください。
+    void SetCommandContextOverride(RhiCommandContext* commandContext);
+
+    // 現在のフレームリソースセットのインデックスを取得します。
+    uint32_t GetCurrentFrameResourcesIndex() const { return m_frameResourcesIndex; }
+
+    // シェーダーから見えるディスクリプタヒープのアロケーターを取得します。
+    DescriptorAllocator* GetDescriptorAllocator() const { return m_descriptorAllocator; }
+
+    // テクスチャストリーマーを取得します。
+    TextureStreamer* GetTextureStreamer() const { return m_textureStreamer; }
+
+    // フレームスケジューラーを取得します。
+    FrameScheduler* GetFrameScheduler() const { return m_frameScheduler; }
+
     // GPU側の処理が完了するまで待機します。
     void WaitForCompletion();
 
+    // コマンドリストの先頭で設定するルートシグネチャとパイプラインステートを登録します。 (所有はしません)
+    void SetDefaultGraphicsState(ID3D12RootSignature* rootSignature, ID3D12PipelineState* pipelineState);
+
+    // コマンドリストの先頭で設定するルートシグネチャを取得します。
+    ID3D12RootSignature* GetDefaultRootSignature() const { return m_defaultRootSignature; }
+
+    // コマンドリストの先頭で設定するパイプラインステートを取得します。
+    ID3D12PipelineState* GetDefaultPipelineState() const { return m_defaultPipelineState; }
+
+    // デフォルトのパイプラインステート、ルートシグネチャ、共有ディスクリプタヒープをコマンドリストに設定します。
+    //   ・新しく記録を始めたコマンドリストは何も設定されていないので、最初に呼び出してください。
+    void ApplyDefaultGraphicsState(RhiCommandList* commandList) const;
+
+    // 処理中のフレームのGPU処理が全て完了した後に、オブジェクトを解放します。
+    //   ・GPUが読んでいるかもしれないリソース(テクスチャなど)は、すぐに Release() せずにこちらを使ってください。
+    void ReleaseAfterGpuCompletion(IUnknown* object);
+
+    // 現在のフレームリソースを使い始めます。
+    //   ・そのフレームリソースを前回使ったGPU処理の完了だけを待ち、コマンドアロケーターなどをリセットします。
+    //   ・Present() の直後、次のフレームの記録を始める前に呼び出してください。
+    void BeginFrame();
+
     // バックバッファへのレンダリングを終了してフロントバッファに指定します。
     // (これによりディスプレイへの転送が開始されます)
+    //   ・GPU処理の完了は待たずに、フェンス値を記録して次のフレームリソースに進みます。
     void Present();
 };
 
@@ -37,6 +37,21 @@ GridLinesRenderer::GridLinesRenderer()
 	, m_minorPerMajor(5)
 	, m_minorGridLineStyle(GridLineType::Solid, Color::Gray)
 	, m_isGeometryDirty(true)
+	, m_vertexBuffer(nullptr)
+{
+
+}
+
+
+GridLinesRenderer::GridLinesRenderer(const GridLinesRenderer& original)
+	: Renderer(original)
+	, m_majorGridLines(original.m_majorGridLines)
+	, m_majorGridLineStyle(original.m_majorGridLineStyle)
+	, m_majorGridLineInterval(original.m_majorGridLineInterval)
+	, m_minorPerMajor(original.m_minorPerMajor)
+	, m_minorGridLineStyle(original.m_minorGridLineStyle)
+	, m_isGeometryDirty(true)
+	, m_vertexBuffer(nullptr)
 {
 
 }
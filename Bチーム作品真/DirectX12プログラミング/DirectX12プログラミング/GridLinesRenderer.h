@@ -49,6 +49,12 @@ public:
     // このインスタンスのデータ型の情報を返します。
     virtual const TypeInfo& GetTypeInfoOfInstance() const { return GetTypeInfo(); }
 
+    // GameObjectのコンポーネントテーブル内での、このデータ型の添え字
+    static constexpr ComponentTypeIndex TypeIndex = ComponentTypeIndex::GridLinesRenderer;
+
+    // このデータ型と全ての基底クラスを表すビットマスク
+    static constexpr uint32_t TypeMask = Renderer::TypeMask | ToComponentTypeMask(TypeIndex);
+
     // 主線の本数を設定します。
     void SetMajorGridLines(uint32_t count) { m_majorGridLines = count; }
 
@@ -72,6 +78,9 @@ private:
     // コンストラクタ
     GridLinesRenderer();
 
+    // コピーコンストラクタ (グリッド線の設定だけを複製し、頂点バッファは最初の描画時に作成します)
+    GridLinesRenderer(const GridLinesRenderer& original);
+
     // 仮想デストラクタ
     virtual ~GridLinesRenderer();
 
@@ -0,0 +1,43 @@
+﻿#include "Handle.h"
+
+// 静的メンバ変数の実体を宣言
+std::vector<HandleTable::Slot> HandleTable::s_slots;
+uint32_t HandleTable::s_firstFreeIndex = UINT32_MAX;
+
+
+uint32_t HandleTable::Register(Object* object)
+{
+    // 空き格納位置が無い場合は末尾に追加する
+    if (s_firstFreeIndex == UINT32_MAX)
+    {
+        Slot slot;
+        slot.object = object;
+        slot.generation = 1;    // 0 はデフォルトコンストラクタで作成したハンドルと区別する為に使わない
+        slot.nextFreeIndex = UINT32_MAX;
+        s_slots.push_back(slot);
+        return (uint32_t)s_slots.size() - 1;
+    }
+
+    // 空き格納位置を再利用する
+    const uint32_t index = s_firstFreeIndex;
+    Slot& slot = s_slots[index];
+    s_firstFreeIndex = slot.nextFreeIndex;
+    slot.object = object;
+    slot.nextFreeIndex = UINT32_MAX;
+    return index;
+}
+
+
+void HandleTable::Unregister(uint32_t index)
+{
+    Slot& slot = s_slots[index];
+    assert(slot.object);
+
+    // 世代番号を進めて、古いハンドルから参照できないようにする
+    slot.object = nullptr;
+    slot.generation++;
+
+    // 空き格納位置として再利用できるようにする
+    slot.nextFreeIndex = s_firstFreeIndex;
+    s_firstFreeIndex = index;
+}
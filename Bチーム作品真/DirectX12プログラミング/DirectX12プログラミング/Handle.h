@@ -0,0 +1,114 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include <cassert>
+
+// 前方宣言
+class Object;
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ハンドルテーブルクラス
+//
+//      ・生存している全てのオブジェクトを「格納位置 + 世代番号」で管理するクラス。
+//      ・オブジェクトが破棄されると、その格納位置の世代番号が進む。
+//      ・古い世代番号を持つハンドルからは nullptr が返るので、破棄済みのオブジェクトを安全に検出できる。
+//      ・モノステートパターンで実装されている(全てのメンバがstatic)。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class HandleTable
+{
+private:
+    // 格納位置毎の情報
+    struct Slot
+    {
+        Object* object;             // 生存しているオブジェクト (空きの場合は nullptr)
+        uint32_t generation;        // 世代番号 (オブジェクトが破棄される度に増える)
+        uint32_t nextFreeIndex;     // 次の空き格納位置
+    };
+
+    static std::vector<Slot> s_slots;       // 格納位置の配列
+    static uint32_t s_firstFreeIndex;       // 最初の空き格納位置
+
+public:
+    // 空いている格納位置にオブジェクトを登録し、その格納位置を返します。
+    static uint32_t Register(Object* object);
+
+    // 指定した格納位置のオブジェクトの登録を解除します。 (世代番号が進みます)
+    static void Unregister(uint32_t index);
+
+    // 格納位置の数を取得します。 (これまでに同時に生存していたオブジェクトの最大数)
+    static uint32_t GetSlotCount() { return (uint32_t)s_slots.size(); }
+
+    // 指定した格納位置の現在の世代番号を取得します。
+    static uint32_t GetGeneration(uint32_t index) { return s_slots[index].generation; }
+
+    // 格納位置と世代番号が一致するオブジェクトを取得します。 (破棄済みの場合は nullptr を返します)
+    static Object* Resolve(uint32_t index, uint32_t generation)
+    {
+        if ((index < s_slots.size()) && (s_slots[index].generation == generation))
+        {
+            return s_slots[index].object;
+        }
+        return nullptr;
+    }
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ハンドルクラス
+//
+//      ・オブジェクトへの弱い参照。
+//      ・参照先が破棄されると Get() が nullptr を返すようになる。(ポインターのように宙ぶらりんにならない)
+//      ・中身は整数2つなので、コピーや比較は軽い。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+template<typename T>
+class Handle
+{
+private:
+    uint32_t m_index;           // ハンドルテーブル内での格納位置
+    uint32_t m_generation;      // 作成時の世代番号
+
+public:
+    // デフォルトコンストラクタ (何も参照していないハンドルになる)
+    Handle() : m_index(UINT32_MAX), m_generation(0) {}
+
+    // 指定したオブジェクトを参照するハンドルを作成します。
+    Handle(T* object);
+
+    // 参照先のオブジェクトを取得します。 (破棄済みの場合は nullptr を返します)
+    T* Get() const { return static_cast<T*>(HandleTable::Resolve(m_index, m_generation)); }
+
+    // 参照先のオブジェクトのメンバにアクセスします。
+    T* operator->() const { T* object = Get(); assert(object); return object; }
+
+    // 参照先のオブジェクトが生存している場合は true を返します。
+    explicit operator bool() const { return Get() != nullptr; }
+
+    // 同じオブジェクトを参照している場合は true を返します。
+    bool operator==(const Handle& other) const { return (m_index == other.m_index) && (m_generation == other.m_generation); }
+
+    // 異なるオブジェクトを参照している場合は true を返します。
+    bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+
+//--------------------------------------------------------------------------------------
+// ※注意
+//
+//  「クラステンプレート」や「関数テンプレート」の実装はソースファイル(.cpp)に記述してはいけない。
+//   それらの利用場所から見える場所に記述しよう。
+//
+//--------------------------------------------------------------------------------------
+
+template<typename T>
+inline Handle<T>::Handle(T* object)
+    : m_index(UINT32_MAX)
+    , m_generation(0)
+{
+    if (object)
+    {
+        m_index = object->GetHandleIndex();
+        m_generation = HandleTable::GetGeneration(m_index);
+    }
+}
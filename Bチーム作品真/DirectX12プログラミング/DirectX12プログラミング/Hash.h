@@ -0,0 +1,72 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstddef>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ハッシュ関数
+//
+//      ・FNV-1a (32bit) でバイト列や文字列のハッシュ値を計算する。
+//      ・暗号用途には使えないが、計算が軽くハッシュテーブルのキーとしては十分に散らばる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// FNV-1a (32bit) の初期値
+constexpr uint32_t FNV1aOffsetBasis32 = 2166136261u;
+
+// FNV-1a (32bit) の素数
+constexpr uint32_t FNV1aPrime32 = 16777619u;
+
+
+// ASCIIの大文字を小文字に変換します。
+//      ・1バイト文字専用です。 文字列を変換する場合は、Shift-JISの2バイト文字の2バイト目を渡さないでください。
+constexpr char ToLowerASCII(char c)
+{
+    return (('A' <= c) && (c <= 'Z')) ? (char)(c - 'A' + 'a') : c;
+}
+
+
+// Shift-JIS(CP932)の2バイト文字の1バイト目であれば true を返します。
+//      ・ソースコードは /utf-8 を指定せずにコンパイルしているので、文字列リテラルの日本語はCP932になります。
+//      ・2バイト目は 0x40～0x7E の範囲にもあり、ASCIIの英字('A'～'Z'は 0x41～0x5A)と重なるので、小文字に変換してはいけません。
+//        (例えば「ア」は 0x83 0x41 なので、2バイト目を変換すると「ャ」(0x83 0x61)と同じ名前になってしまう)
+constexpr bool IsShiftJISLeadByte(char c)
+{
+    return ((0x81 <= (uint8_t)c) && ((uint8_t)c <= 0x9F)) || ((0xE0 <= (uint8_t)c) && ((uint8_t)c <= 0xFC));
+}
+
+
+// バイト列のハッシュ値を計算します。
+inline uint32_t ComputeHash(const void* data, size_t size, uint32_t hash = FNV1aOffsetBasis32)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV1aPrime32;
+    }
+    return hash;
+}
+
+
+// 大文字と小文字(ASCIIのみ)を区別せずに、文字列のハッシュ値を計算します。
+//      ・Shift-JISの2バイト文字は、2バイトともそのままハッシュ値に加えます。
+constexpr uint32_t ComputeCaseInsensitiveHash(const char* str, size_t length)
+{
+    uint32_t hash = FNV1aOffsetBasis32;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (IsShiftJISLeadByte(str[i]) && (i + 1 < length))
+        {
+            hash ^= (uint8_t)str[i];
+            hash *= FNV1aPrime32;
+            i++;
+            hash ^= (uint8_t)str[i];
+            hash *= FNV1aPrime32;
+            continue;
+        }
+
+        hash ^= (uint8_t)ToLowerASCII(str[i]);
+        hash *= FNV1aPrime32;
+    }
+    return hash;
+}
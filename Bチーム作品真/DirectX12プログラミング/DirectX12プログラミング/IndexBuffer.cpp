@@ -2,7 +2,7 @@
 #include <cassert>
 
 
-IndexBuffer::IndexBuffer(IndexFormat indexFormat, uint32_t indexCount, const void* initialData, ID3D12GraphicsCommandList* commandList)
+IndexBuffer::IndexBuffer(IndexFormat indexFormat, uint32_t indexCount, const void* initialData, ID3D12GraphicsCommandList* commandList, bool isDynamic)
     : BufferResource()
     , m_format(indexFormat)
     , m_stride(0)
@@ -15,7 +15,8 @@ IndexBuffer::IndexBuffer(IndexFormat indexFormat, uint32_t indexCount, const voi
         default: assert(0); break;
     }
 
-    if (!CreateResource(BufferResourceType::IndexBuffer, (uint64_t)m_stride * m_count, initialData, commandList))
+    const BufferResourceType type = isDynamic ? BufferResourceType::DynamicIndexBuffer : BufferResourceType::IndexBuffer;
+    if (!CreateResource(type, (uint64_t)m_stride * m_count, initialData, commandList))
     {
         assert(0);
     }
@@ -25,7 +25,8 @@ public:
     //   第2引数 : [in] インデックス数
     //   第3引数 : [in] 初期化データ(不使用の場合は nullptr)
     //   第4引数 : [in] コピー時に使用されるコマンドリスト
-    IndexBuffer(IndexFormat indexFormat, uint32_t indexCount, const void* initialData = nullptr, ID3D12GraphicsCommandList* commandList = nullptr);
+    //   第5引数 : [in] CPUから毎フレーム書き換える場合は true (アップロードヒープ上に作成され、Map()で書き込んだ内容がそのままGPUから見える)
+    IndexBuffer(IndexFormat indexFormat, uint32_t indexCount, const void* initialData = nullptr, ID3D12GraphicsCommandList* commandList = nullptr, bool isDynamic = false);
 
     // 仮想デストラクタ
     virtual ~IndexBuffer();
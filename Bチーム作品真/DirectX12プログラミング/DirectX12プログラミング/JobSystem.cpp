@@ -0,0 +1,357 @@
+﻿#include "JobSystem.h"
+#include <cstdio>
+#include <cassert>
+
+
+// 静的メンバ変数の実体を宣言
+JobSystem* JobSystem::s_singletonInstance = nullptr;
+thread_local uint32_t JobSystem::s_workerIndex = 0;
+
+
+void JobSystem::CreateSingletonInstance(uint32_t numThreads)
+{
+    assert(!s_singletonInstance);
+
+    // スレッド数が指定されていない場合は論理コア数に合わせる
+    if (numThreads == 0)
+    {
+        numThreads = std::thread::hardware_concurrency();
+    }
+
+    // 論理コア数が取得できなかった場合でもメインスレッドだけは存在する
+    if (numThreads == 0)
+    {
+        numThreads = 1;
+    }
+
+    s_singletonInstance = new JobSystem(numThreads);
+}
+
+
+void JobSystem::DestroySingletonInstance()
+{
+    assert(s_singletonInstance);
+    delete s_singletonInstance;
+    s_singletonInstance = nullptr;
+}
+
+
+JobSystem::JobSystem(uint32_t numThreads)
+    : m_numThreads(numThreads)
+    , m_counters(nullptr)
+    , m_nextCounterIndex(0)
+    , m_numQueuedJobs(0)
+    , m_isRunning(true)
+{
+    // カウンター配列を作成
+    m_counters = new Counter[MaxNumCounters];
+    for (uint32_t i = 0; i < MaxNumCounters; i++)
+    {
+        m_counters[i].numPendingJobs = 0;
+        m_counters[i].generation = 0;
+        m_counters[i].numContinuations = 0;
+    }
+
+    // ワーカー毎のジョブキューを作成
+    for (uint32_t i = 0; i < m_numThreads; i++)
+    {
+        WorkerQueue* workerQueue = new WorkerQueue();
+        workerQueue->head = 0;
+        workerQueue->tail = 0;
+        m_workerQueues.push_back(workerQueue);
+    }
+
+    // メインスレッドは0番のワーカーとして振る舞う
+    s_workerIndex = 0;
+
+    // 1番以降のワーカースレッドを起動する
+    for (uint32_t i = 1; i < m_numThreads; i++)
+    {
+        m_workerThreads.emplace_back(&JobSystem::WorkerThreadMain, this, i);
+    }
+
+    printf("[成功] ジョブシステムの作成 (スレッド数: %u)\n", m_numThreads);
+}
+
+
+JobSystem::~JobSystem()
+{
+    // 全てのワーカースレッドを起こして終了させる
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_isRunning = false;
+    }
+    m_wakeUpCondition.notify_all();
+
+    for (std::thread& workerThread : m_workerThreads)
+    {
+        workerThread.join();
+    }
+    m_workerThreads.clear();
+
+    for (WorkerQueue* workerQueue : m_workerQueues)
+    {
+        delete workerQueue;
+    }
+    m_workerQueues.clear();
+
+    delete[] m_counters;
+    m_counters = nullptr;
+}
+
+
+void JobSystem::WorkerThreadMain(uint32_t workerIndex)
+{
+    s_workerIndex = workerIndex;
+
+    while (m_isRunning)
+    {
+        // 実行できるジョブがあれば実行する
+        Job job;
+        if (TryGetJob(&job))
+        {
+            ExecuteJob(job);
+            continue;
+        }
+
+        // どのキューも空の場合は、新しいジョブが積まれるまで眠る
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeUpCondition.wait(lock, [this]() { return !m_isRunning || (m_numQueuedJobs > 0); });
+    }
+}
+
+
+JobHandle JobSystem::AllocateCounter(uint32_t numPendingJobs)
+{
+    // カウンター配列をリングバッファとして先頭から順番に使う
+    const uint32_t index = m_nextCounterIndex.fetch_add(1) % MaxNumCounters;
+    Counter& counter = m_counters[index];
+
+    std::lock_guard<std::mutex> lock(counter.mutex);
+
+    // 使用中のカウンターを上書きしようとした場合は、同時に使用しているジョブが多すぎる
+    assert((counter.numPendingJobs == 0) && (counter.numContinuations == 0));
+
+    // 世代番号を進めることで、古いハンドルからは「完了済み」に見えるようになる
+    JobHandle handle;
+    handle.m_counterIndex = index;
+    handle.m_generation = counter.generation.fetch_add(1) + 1;
+    counter.numPendingJobs = numPendingJobs;
+    return handle;
+}
+
+
+JobHandle JobSystem::Schedule(JobFunction function, void* userData, const JobHandle& dependency)
+{
+    const JobHandle handle = AllocateCounter(1);
+
+    Job job;
+    job.function = function;
+    job.userData = userData;
+    job.begin = 0;
+    job.end = 1;
+    job.batchSize = 0;
+    job.counterIndex = handle.m_counterIndex;
+    SubmitJob(job, dependency);
+
+    return handle;
+}
+
+
+JobHandle JobSystem::ScheduleParallelFor(JobFunction function, void* userData, uint32_t count, uint32_t batchSize, const JobHandle& dependency)
+{
+    if (batchSize == 0)
+    {
+        batchSize = 1;
+    }
+
+    // 分割後のジョブの数だけ完了を待つ
+    const uint32_t numBatches = (count + batchSize - 1) / batchSize;
+    const JobHandle handle = AllocateCounter(numBatches);
+    if (numBatches == 0)
+    {
+        return handle;
+    }
+
+    // 範囲全体を1つのジョブとして登録する。
+    // (実行される時に、バッチサイズ以下になるまで分割される)
+    Job job;
+    job.function = function;
+    job.userData = userData;
+    job.begin = 0;
+    job.end = count;
+    job.batchSize = batchSize;
+    job.counterIndex = handle.m_counterIndex;
+    SubmitJob(job, dependency);
+
+    return handle;
+}
+
+
+bool JobSystem::IsCompleted(const JobHandle& handle) const
+{
+    if (!handle.IsValid())
+    {
+        return true;
+    }
+
+    // カウンターが再利用されている場合は、とっくに完了している
+    const Counter& counter = m_counters[handle.m_counterIndex];
+    return (counter.generation != handle.m_generation) || (counter.numPendingJobs == 0);
+}
+
+
+void JobSystem::Wait(const JobHandle& handle)
+{
+    // 待っている間も、このスレッドでジョブを実行する
+    while (!IsCompleted(handle))
+    {
+        Job job;
+        if (TryGetJob(&job))
+        {
+            ExecuteJob(job);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+void JobSystem::SubmitJob(const Job& job, const JobHandle& dependency)
+{
+    if (dependency.IsValid())
+    {
+        Counter& counter = m_counters[dependency.m_counterIndex];
+        std::lock_guard<std::mutex> lock(counter.mutex);
+
+        // 依存先がまだ完了していない場合は、依存先の完了時に実行してもらう
+        if ((counter.generation == dependency.m_generation) && (counter.numPendingJobs > 0))
+        {
+            assert(counter.numContinuations < MaxNumContinuations);
+            counter.continuations[counter.numContinuations++] = job;
+            return;
+        }
+    }
+
+    PushJob(job);
+}
+
+
+void JobSystem::PushJob(const Job& job)
+{
+    WorkerQueue& workerQueue = *m_workerQueues[s_workerIndex];
+
+    bool isPushed = false;
+    {
+        std::lock_guard<std::mutex> lock(workerQueue.mutex);
+        if (workerQueue.tail - workerQueue.head < MaxNumJobsPerWorker)
+        {
+            workerQueue.jobs[workerQueue.tail % MaxNumJobsPerWorker] = job;
+            workerQueue.tail++;
+            m_numQueuedJobs++;
+            isPushed = true;
+        }
+    }
+
+    // キューが満杯の場合は、その場で実行してしまう
+    if (!isPushed)
+    {
+        ExecuteJob(job);
+        return;
+    }
+
+    // 眠っているワーカースレッドを1つ起こす
+    // (ロックを取ってから通知しないと、眠る直前のスレッドが通知を取りこぼす)
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wakeUpCondition.notify_one();
+}
+
+
+bool JobSystem::TryGetJob(Job* job)
+{
+    const uint32_t workerIndex = s_workerIndex;
+
+    // 自分のキューの末尾から取り出す (最後に積んだジョブの方がキャッシュに残っている)
+    {
+        WorkerQueue& workerQueue = *m_workerQueues[workerIndex];
+        std::lock_guard<std::mutex> lock(workerQueue.mutex);
+        if (workerQueue.tail != workerQueue.head)
+        {
+            workerQueue.tail--;
+            *job = workerQueue.jobs[workerQueue.tail % MaxNumJobsPerWorker];
+            m_numQueuedJobs--;
+            return true;
+        }
+    }
+
+    // 自分のキューが空の場合は、他のワーカーのキューの先頭から盗む
+    for (uint32_t i = 1; i < m_numThreads; i++)
+    {
+        WorkerQueue& victimQueue = *m_workerQueues[(workerIndex + i) % m_numThreads];
+        std::lock_guard<std::mutex> lock(victimQueue.mutex);
+        if (victimQueue.tail != victimQueue.head)
+        {
+            *job = victimQueue.jobs[victimQueue.head % MaxNumJobsPerWorker];
+            victimQueue.head++;
+            m_numQueuedJobs--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void JobSystem::ExecuteJob(Job job)
+{
+    // 分割可能なジョブは、バッチサイズ以下になるまで半分に分割して後半を他のワーカーに譲る。
+    // (分割位置はバッチサイズの倍数に揃えるので、最終的なジョブの数は登録時に数えた数と一致する)
+    while ((job.batchSize > 0) && (job.end - job.begin > job.batchSize))
+    {
+        const uint32_t numBatches = (job.end - job.begin + job.batchSize - 1) / job.batchSize;
+        const uint32_t middle = job.begin + (numBatches / 2) * job.batchSize;
+
+        Job secondHalf = job;
+        secondHalf.begin = middle;
+        PushJob(secondHalf);
+
+        job.end = middle;
+    }
+
+    job.function(job.userData, job.begin, job.end);
+    FinishJob(job.counterIndex);
+}
+
+
+void JobSystem::FinishJob(uint32_t counterIndex)
+{
+    Counter& counter = m_counters[counterIndex];
+
+    // 最後のジョブでなければ何もしない
+    if (counter.numPendingJobs.fetch_sub(1) != 1)
+    {
+        return;
+    }
+
+    // 全てのジョブが完了したので、依存していたジョブを実行可能にする
+    Job continuations[MaxNumContinuations];
+    uint32_t numContinuations = 0;
+    {
+        std::lock_guard<std::mutex> lock(counter.mutex);
+        numContinuations = counter.numContinuations;
+        for (uint32_t i = 0; i < numContinuations; i++)
+        {
+            continuations[i] = counter.continuations[i];
+        }
+        counter.numContinuations = 0;
+    }
+
+    for (uint32_t i = 0; i < numContinuations; i++)
+    {
+        PushJob(continuations[i]);
+    }
+}
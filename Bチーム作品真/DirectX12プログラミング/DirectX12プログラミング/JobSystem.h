@@ -0,0 +1,182 @@
+﻿#pragma once
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <vector>
+
+// ジョブ関数
+//      ・userData はジョブ登録時に指定した任意のデータ。
+//      ・[begin, end) はこのジョブが処理する範囲。
+using JobFunction = void (*)(void* userData, uint32_t begin, uint32_t end);
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ジョブハンドル
+//
+//      ・登録したジョブの完了を待ったり、ジョブ同士の依存関係を指定する為の識別子。
+//      ・中身はジョブシステムが管理する「未完了ジョブ数カウンター」の格納位置と世代番号。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class JobHandle
+{
+private:
+    uint32_t m_counterIndex;    // カウンターの格納位置
+    uint32_t m_generation;      // カウンターの世代番号 (カウンターが再利用される度に増える)
+    friend class JobSystem;     // ジョブシステムクラスは友達
+
+public:
+    // デフォルトコンストラクタ (どのジョブも指していない無効なハンドルになる)
+    JobHandle() : m_counterIndex(UINT32_MAX), m_generation(0) {}
+
+    // 有効なジョブを指している場合は true を返します。
+    bool IsValid() const { return m_counterIndex != UINT32_MAX; }
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ジョブシステムクラス
+//
+//      ・このクラスはシングルトンパターンで実装されているため、
+//        作成関数と破棄関数を明示的に呼び出さなければならない。
+//      ・(スレッド数 - 1)個のワーカースレッドを起動し、メインスレッドと合わせて全てのスレッドでジョブを実行する。
+//      ・ワーカー毎にジョブキュー(両端キュー)を持つ。
+//        自分のキューは末尾から取り出し、空になったら他のワーカーのキューの先頭からジョブを盗む。(ワークスティーリング)
+//      ・ジョブは未完了ジョブ数カウンターを持ち、カウンターが0になったジョブに依存するジョブが実行可能になる。
+//      ・ジョブの登録と実行ではメモリ確保は発生しない。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class JobSystem
+{
+private:
+    static constexpr uint32_t MaxNumJobsPerWorker = 4096;   // ワーカー毎のジョブキューの容量
+    static constexpr uint32_t MaxNumCounters = 1024;        // 同時に使用できるカウンターの数
+    static constexpr uint32_t MaxNumContinuations = 8;      // 1つのジョブに依存できるジョブの数
+
+    // ジョブ
+    struct Job
+    {
+        JobFunction function;       // ジョブ関数
+        void* userData;             // ジョブ関数に渡す任意のデータ
+        uint32_t begin;             // 処理する範囲の先頭
+        uint32_t end;               // 処理する範囲の終端 (終端自体は含まない)
+        uint32_t batchSize;         // 0以外の場合は、この数以下になるまで範囲を分割してから実行する
+        uint32_t counterIndex;      // 完了時に減らすカウンターの格納位置
+    };
+
+    // 未完了ジョブ数カウンター
+    struct Counter
+    {
+        std::atomic<uint32_t> numPendingJobs;       // 未完了のジョブ数
+        std::atomic<uint32_t> generation;           // 世代番号
+        std::mutex mutex;                           // 依存ジョブ配列の排他制御
+        Job continuations[MaxNumContinuations];     // このカウンターが0になったら実行されるジョブ配列
+        uint32_t numContinuations;                  // 依存ジョブの数
+    };
+
+    // ワーカー毎のジョブキュー (リングバッファによる両端キュー)
+    struct WorkerQueue
+    {
+        std::mutex mutex;                   // 排他制御
+        Job jobs[MaxNumJobsPerWorker];      // ジョブ配列
+        uint32_t head;                      // 先頭 (他のワーカーが盗む側)
+        uint32_t tail;                      // 末尾 (持ち主のワーカーが出し入れする側)
+    };
+
+private:
+    static JobSystem*           s_singletonInstance;        // シングルトンインスタンス
+    static thread_local uint32_t s_workerIndex;             // 現在のスレッドのワーカー番号 (メインスレッドは0)
+    uint32_t                    m_numThreads;               // メインスレッドを含むスレッド数
+    std::vector<WorkerQueue*>   m_workerQueues;             // ワーカー毎のジョブキュー
+    std::vector<std::thread>    m_workerThreads;            // ワーカースレッド配列
+    Counter*                    m_counters;                 // カウンター配列
+    std::atomic<uint32_t>       m_nextCounterIndex;         // 次に使用するカウンターの格納位置
+    std::atomic<uint32_t>       m_numQueuedJobs;            // キューに積まれているジョブの数
+    std::atomic<bool>           m_isRunning;                // ワーカースレッドを終了させる場合は false
+    std::mutex                  m_sleepMutex;               // ワーカースレッドの休止用
+    std::condition_variable     m_wakeUpCondition;          // ワーカースレッドの起床用
+
+private:
+    // コンストラクタ
+    JobSystem(uint32_t numThreads);
+
+    // デストラクタ
+    ~JobSystem();
+
+    // ワーカースレッドのメイン関数です。
+    void WorkerThreadMain(uint32_t workerIndex);
+
+    // 指定した数の未完了ジョブを持つカウンターを確保します。
+    JobHandle AllocateCounter(uint32_t numPendingJobs);
+
+    // ジョブを実行可能な状態にします。 (依存先が未完了の場合は、完了した時に実行可能になります)
+    void SubmitJob(const Job& job, const JobHandle& dependency);
+
+    // ジョブを現在のスレッドのジョブキューに積みます。
+    void PushJob(const Job& job);
+
+    // 現在のスレッドのジョブキュー、または他のワーカーのジョブキューからジョブを取り出します。
+    bool TryGetJob(Job* job);
+
+    // ジョブを実行します。
+    void ExecuteJob(Job job);
+
+    // ジョブが1つ完了したことをカウンターに通知します。
+    void FinishJob(uint32_t counterIndex);
+
+public:
+    // シングルトンインスタンスを作成します。
+    //      ・numThreads はメインスレッドを含むスレッド数です。0 の場合は論理コア数になります。
+    static void CreateSingletonInstance(uint32_t numThreads = 0);
+
+    // シングルトンインスタンスを破棄します。
+    static void DestroySingletonInstance();
+
+    // シングルトンインスタンスを取得します。
+    static JobSystem& Instance() { return *s_singletonInstance; }
+
+    // メインスレッドを含むスレッド数を取得します。
+    uint32_t GetNumThreads() const { return m_numThreads; }
+
+    // ジョブを登録します。
+    //      ・dependency が有効な場合は、そのジョブが完了してから実行されます。
+    JobHandle Schedule(JobFunction function, void* userData, const JobHandle& dependency = JobHandle());
+
+    // [0, count) の範囲を batchSize 個ずつに分割して並列に処理するジョブを登録します。
+    //      ・dependency が有効な場合は、そのジョブが完了してから実行されます。
+    JobHandle ScheduleParallelFor(JobFunction function, void* userData, uint32_t count, uint32_t batchSize, const JobHandle& dependency = JobHandle());
+
+    // 指定したジョブが完了している場合は true を返します。
+    bool IsCompleted(const JobHandle& handle) const;
+
+    // 指定したジョブが完了するまで待機します。
+    //      ・待っている間は、このスレッドも他のジョブを実行します。
+    void Wait(const JobHandle& handle);
+
+    // [0, count) の範囲を batchSize 個ずつに分割して並列に処理し、全て完了するまで待機します。
+    //      ・function は void(uint32_t begin, uint32_t end) の形で呼び出せる関数オブジェクトです。
+    template<typename Function>
+    void ParallelFor(uint32_t count, uint32_t batchSize, const Function& function);
+};
+
+
+//--------------------------------------------------------------------------------------
+// ※注意
+//
+//  「クラステンプレート」や「関数テンプレート」の実装はソースファイル(.cpp)に記述してはいけない。
+//   それらの利用場所から見える場所に記述しよう。
+//
+//--------------------------------------------------------------------------------------
+
+template<typename Function>
+inline void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const Function& function)
+{
+    // 関数オブジェクトを呼び出すだけのジョブ関数
+    // (関数オブジェクトはこの関数から戻るまで生きているので、アドレスを渡すだけでよい)
+    const JobFunction jobFunction = [](void* userData, uint32_t begin, uint32_t end)
+    {
+        (*(const Function*)userData)(begin, end);
+    };
+
+    Wait(ScheduleParallelFor(jobFunction, (void*)&function, count, batchSize));
+}
@@ -0,0 +1,68 @@
+﻿#include "LinearPageAllocator.h"
+#include <cassert>
+
+
+LinearPageAllocator::LinearPageAllocator(uint64_t pageSize)
+    : m_pageSize(pageSize)
+    , m_pageCapacities(1, pageSize)
+    , m_currentPage(0)
+    , m_offset(0)
+    , m_usedBytes(0)
+{
+    assert(pageSize > 0);
+}
+
+
+LinearPageAllocator::Location LinearPageAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    // 今のページに収まるか？
+    const uint64_t start = (m_offset + alignment - 1) & ~(alignment - 1);
+    if (start + size <= m_pageCapacities[m_currentPage])
+    {
+        m_usedBytes += (start + size) - m_offset;
+        m_offset = start + size;
+        return Location{ m_currentPage, start };
+    }
+
+    // 今のページの残りは捨てて、収まる大きさの次のページを探す
+    m_usedBytes += m_pageCapacities[m_currentPage] - m_offset;
+    uint32_t pageIndex = m_currentPage + 1;
+    while (pageIndex < (uint32_t)m_pageCapacities.size() && m_pageCapacities[pageIndex] < size)
+    {
+        m_usedBytes += m_pageCapacities[pageIndex];
+        pageIndex++;
+    }
+
+    // 無ければページを追加する (ページより大きな要求は、ページサイズの倍数に切り上げた大きさにする)
+    if (pageIndex == (uint32_t)m_pageCapacities.size())
+    {
+        const uint64_t capacity = (size <= m_pageSize) ? m_pageSize : (size + m_pageSize - 1) / m_pageSize * m_pageSize;
+        m_pageCapacities.push_back(capacity);
+    }
+
+    m_currentPage = pageIndex;
+    m_offset = size;
+    m_usedBytes += size;
+    return Location{ pageIndex, 0 };
+}
+
+
+void LinearPageAllocator::Reset()
+{
+    m_currentPage = 0;
+    m_offset = 0;
+    m_usedBytes = 0;
+}
+
+
+uint64_t LinearPageAllocator::GetCapacity() const
+{
+    uint64_t capacity = 0;
+    for (uint64_t pageCapacity : m_pageCapacities)
+    {
+        capacity += pageCapacity;
+    }
+    return capacity;
+}
@@ -0,0 +1,63 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// 線形ページアロケータークラス
+//
+//      ・複数のページ(同じサイズのバッファ)を、先頭のページから順番に切り出していく線形アロケーター。
+//      ・今のページに収まらない場合は次のページに進み、ページが足りなければページを追加する。
+//        (ページより大きな要求には、そのサイズを収められる大きさのページを追加する)
+//      ・追加したページは Reset() の後も残して使い回すので、一度足りなくなった後は毎フレームの追加は起きない。
+//      ・オフセットを管理するだけで、メモリそのものは持たない。(GPUの無い環境でも動かせる)
+//        ページの実体は、GetNumPages() が増えたときに使う側で作成すること。
+//      ・このヘッダーは Windows や D3D12 のヘッダーに依存しないこと。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class LinearPageAllocator
+{
+public:
+    // 切り出した位置
+    struct Location
+    {
+        uint32_t pageIndex;             // ページの番号
+        uint64_t offset;                // ページの先頭からの位置 (単位はバイト)
+    };
+
+private:
+    uint64_t m_pageSize;                // 1ページのサイズ (単位はバイト)
+    std::vector<uint64_t> m_pageCapacities; // ページ毎のサイズ (単位はバイト)
+    uint32_t m_currentPage;             // 切り出し中のページの番号
+    uint64_t m_offset;                  // 切り出し中のページで、次に切り出す位置
+    uint64_t m_usedBytes;               // Reset() してから切り出したバイト数 (アラインメントの隙間を含む)
+
+public:
+    // コンストラクタ (最初の1ページを用意します)
+    //      第1引数 : [in] 1ページのサイズ (単位はバイト)
+    explicit LinearPageAllocator(uint64_t pageSize);
+
+    // 領域を切り出します。
+    //   ・今のページに収まらない場合は、次のページ(無ければ追加したページ)の先頭から切り出します。
+    //      第1引数 : [in] サイズ (単位はバイト)
+    //      第2引数 : [in] アラインメント (2のべき乗。ページの先頭はこの値に揃っていること)
+    //       戻り値 :      切り出した位置
+    Location Allocate(uint64_t size, uint64_t alignment);
+
+    // 全てのページを未使用に戻します。 (ページは解放しません)
+    void Reset();
+
+    // ページの数を取得します。
+    uint32_t GetNumPages() const { return (uint32_t)m_pageCapacities.size(); }
+
+    // 指定したページのサイズ(単位はバイト)を取得します。
+    uint64_t GetPageCapacity(uint32_t pageIndex) const { return m_pageCapacities[pageIndex]; }
+
+    // 1ページのサイズ(単位はバイト)を取得します。
+    uint64_t GetPageSize() const { return m_pageSize; }
+
+    // 全てのページのサイズの合計(単位はバイト)を取得します。
+    uint64_t GetCapacity() const;
+
+    // Reset() してから切り出したバイト数を取得します。
+    uint64_t GetUsedBytes() const { return m_usedBytes; }
+};
@@ -1,8 +1,33 @@
 ﻿#pragma once
 
+// マテリアルのレンダリングモード
+enum class RenderingMode
+{
+    Opaque,                 // 不透明。ブレンドせずに深度を書き込み、手前から順番に描画されます。
+    Transparent,            // 半透明。アルファブレンドし、奥から順番に描画されます。
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// マテリアルクラス
+//
+//      ・レンダラーが描画する時に使用する設定を保持するクラス。
+//      ・現在はレンダリングモード(不透明/半透明)のみを保持する。
+//      ・レンダラーは設定されたマテリアルを複製して保持するので、コピーできる必要がある。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
 class Material
 {
+private:
+    RenderingMode m_renderingMode;      // レンダリングモード
 
-};
+public:
+    // コンストラクタ (半透明のマテリアルになります)
+    Material() : m_renderingMode(RenderingMode::Transparent) {}
 
+    // レンダリングモードを設定します。
+    void SetRenderingMode(RenderingMode renderingMode) { m_renderingMode = renderingMode; }
 
+    // レンダリングモードを取得します。
+    RenderingMode GetRenderingMode() const { return m_renderingMode; }
+};
@@ -0,0 +1,141 @@
+﻿#include "MemoryPool.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+
+// テストはLinuxでもビルドするので、スラブの確保だけはプラットフォーム毎に切り替える
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+
+// スラブサイズ境界に揃えてスラブを確保する
+static void* AllocateAlignedSlab(size_t size)
+{
+#if defined(_WIN32)
+    // VirtualAlloc()で確保したメモリは必ず64KB境界(アロケーション粒度)に揃っている
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    return std::aligned_alloc(size, size);
+#endif
+}
+
+
+// AllocateAlignedSlab()で確保したスラブを解放する
+static void FreeAlignedSlab(void* slab)
+{
+#if defined(_WIN32)
+    VirtualFree(slab, 0, MEM_RELEASE);
+#else
+    std::free(slab);
+#endif
+}
+
+
+// 指定した値を alignment の倍数に切り上げる
+static size_t AlignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+
+MemoryPool::MemoryPool(size_t blockSize, size_t alignment)
+    : m_blockSize(0)
+    , m_firstBlockOffset(0)
+    , m_slabs(nullptr)
+    , m_freeBlocks(nullptr)
+    , m_numSlabs(0)
+    , m_numUsedBlocks(0)
+    , m_numAllocations(0)
+{
+    // 未使用ブロックの管理情報が収まるようにする
+    if (alignment < alignof(FreeBlock))
+    {
+        alignment = alignof(FreeBlock);
+    }
+    if (blockSize < sizeof(FreeBlock))
+    {
+        blockSize = sizeof(FreeBlock);
+    }
+
+    m_blockSize = AlignUp(blockSize, alignment);
+    m_firstBlockOffset = AlignUp(sizeof(SlabHeader), alignment);
+
+    // 1つのスラブに1つもブロックが入らない場合はエラー
+    assert(m_firstBlockOffset + m_blockSize <= SlabSize);
+}
+
+
+MemoryPool::~MemoryPool()
+{
+    // 全てのスラブをまとめて解放する
+    SlabHeader* slab = m_slabs;
+    while (slab)
+    {
+        SlabHeader* next = slab->next;
+        FreeAlignedSlab(slab);
+        slab = next;
+    }
+}
+
+
+void* MemoryPool::Allocate()
+{
+    if (!m_freeBlocks)
+    {
+        AllocateSlab();
+    }
+
+    FreeBlock* block = m_freeBlocks;
+    m_freeBlocks = block->next;
+
+    m_numUsedBlocks++;
+    m_numAllocations++;
+    return block;
+}
+
+
+void MemoryPool::Free(void* block)
+{
+    assert(FromPointer(block) == this);
+    assert(m_numUsedBlocks > 0);
+
+    FreeBlock* freeBlock = (FreeBlock*)block;
+    freeBlock->next = m_freeBlocks;
+    m_freeBlocks = freeBlock;
+
+    m_numUsedBlocks--;
+}
+
+
+MemoryPool* MemoryPool::FromPointer(void* block)
+{
+    // スラブはスラブサイズ境界に揃っているので、下位ビットを落とせばスラブの先頭になる
+    const SlabHeader* slab = (const SlabHeader*)((uintptr_t)block & ~(uintptr_t)(SlabSize - 1));
+    return slab->pool;
+}
+
+
+void MemoryPool::AllocateSlab()
+{
+    SlabHeader* slab = (SlabHeader*)AllocateAlignedSlab(SlabSize);
+    if (!slab)
+    {
+        printf("[失敗] メモリプールのスラブの確保\n");
+        assert(0);
+    }
+    slab->pool = this;
+    slab->next = m_slabs;
+    m_slabs = slab;
+    m_numSlabs++;
+
+    // アドレスの小さい順に取り出されるように、後ろのブロックから順番にリストに繋ぐ
+    const size_t numBlocks = (SlabSize - m_firstBlockOffset) / m_blockSize;
+    uint8_t* firstBlock = (uint8_t*)slab + m_firstBlockOffset;
+    for (size_t i = numBlocks; i > 0; i--)
+    {
+        FreeBlock* block = (FreeBlock*)(firstBlock + (i - 1) * m_blockSize);
+        block->next = m_freeBlocks;
+        m_freeBlocks = block;
+    }
+}
@@ -0,0 +1,77 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// メモリプールクラス
+//
+//      ・同じサイズのメモリブロックを、まとめて確保した大きなメモリ(スラブ)から切り出して配るクラス。
+//      ・解放されたブロックはフリーリストに繋いでおき、次の確保で再利用する。
+//      ・スラブはスラブサイズ境界に揃えて確保するので、ブロックのアドレスから所属するプールを逆引きできる。
+//      ・プールを破棄すると、全てのスラブがまとめて解放される。
+//        (ブロック上のオブジェクトのデストラクタは呼ばれないので、先に破棄しておくこと)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class MemoryPool
+{
+public:
+    static constexpr size_t SlabSize = 64 * 1024;   // スラブのサイズ (VirtualAlloc()のアロケーション粒度と同じ)
+
+private:
+    // スラブの先頭に置かれる管理情報
+    struct SlabHeader
+    {
+        MemoryPool* pool;       // このスラブを所有するプール
+        SlabHeader* next;       // 次のスラブ
+    };
+
+    // 未使用ブロックの先頭に置かれる管理情報
+    struct FreeBlock
+    {
+        FreeBlock* next;        // 次の未使用ブロック
+    };
+
+    size_t m_blockSize;                 // ブロックのサイズ
+    size_t m_firstBlockOffset;          // スラブの先頭から最初のブロックまでのオフセット
+    SlabHeader* m_slabs;                // 確保済みのスラブのリスト
+    FreeBlock* m_freeBlocks;            // 未使用ブロックのリスト
+    uint32_t m_numSlabs;                // 確保済みのスラブ数
+    uint32_t m_numUsedBlocks;           // 使用中のブロック数
+    uint32_t m_numAllocations;          // これまでにブロックを確保した回数
+
+public:
+    // コンストラクタ
+    MemoryPool(size_t blockSize, size_t alignment);
+
+    // デストラクタ (全てのスラブをまとめて解放します)
+    ~MemoryPool();
+
+    // コピーは禁止
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+
+    // ブロックを1つ確保します。
+    void* Allocate();
+
+    // ブロックをこのプールに返却します。
+    void Free(void* block);
+
+    // 指定したブロックを確保したプールを取得します。
+    static MemoryPool* FromPointer(void* block);
+
+    // ブロックのサイズを取得します。
+    size_t GetBlockSize() const { return m_blockSize; }
+
+    // 確保済みのスラブ数を取得します。
+    uint32_t GetNumSlabs() const { return m_numSlabs; }
+
+    // 使用中のブロック数を取得します。
+    uint32_t GetNumUsedBlocks() const { return m_numUsedBlocks; }
+
+    // これまでにブロックを確保した回数を取得します。
+    uint32_t GetNumAllocations() const { return m_numAllocations; }
+
+private:
+    // 新しいスラブを確保して、全てのブロックを未使用ブロックのリストに繋ぎます。
+    void AllocateSlab();
+};
@@ -1,5 +1,11 @@
 ﻿#pragma once
 #include "Behaviour.h"
+#include <type_traits>
+
+// 前方宣言
+template<typename T, typename = void> struct OverridesOnPreCull;
+template<typename T, typename = void> struct OverridesOnPreRender;
+template<typename T, typename = void> struct OverridesOnPostRender;
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // Monoビヘイビアクラス
@@ -14,6 +20,19 @@ class MonoBehaviour : public Behaviour
 private:
 	friend class Camera;		// カメラクラスは友達
 	friend class GameObject;	// ゲームオブジェクトクラスは友達
+	template<typename, typename> friend struct OverridesOnPreCull;		// 型特性は友達
+	template<typename, typename> friend struct OverridesOnPreRender;	// 型特性は友達
+	template<typename, typename> friend struct OverridesOnPostRender;	// 型特性は友達
+
+public:
+	// オーバーライドされているコールバック関数を表すフラグ (Component::m_callbackFlags)
+	static constexpr uint32_t OnPreCullCallback = 1 << 0;
+	static constexpr uint32_t OnPreRenderCallback = 1 << 1;
+	static constexpr uint32_t OnPostRenderCallback = 1 << 2;
+
+	// ScriptType がオーバーライドしているコールバック関数のフラグをコンパイル時に求めます。
+	template<typename ScriptType>
+	static constexpr uint32_t GetCallbackFlags();
 
 public:
 	// このデータ型の情報を返します。
@@ -22,6 +41,12 @@ public:
 	// このインスタンスのデータ型の情報を返します。
 	virtual const TypeInfo& GetTypeInfoOfInstance() const { return GetTypeInfo(); }
 
+	// GameObjectのコンポーネントテーブル内での、このデータ型の添え字
+	static constexpr ComponentTypeIndex TypeIndex = ComponentTypeIndex::MonoBehaviour;
+
+	// このデータ型と全ての基底クラスを表すビットマスク
+	static constexpr uint32_t TypeMask = Behaviour::TypeMask | ToComponentTypeMask(TypeIndex);
+
 	// このクラスの派生クラスである場合は有効なアドレスを返します。
 	// このクラスの派生クラスでない場合は nullptr を返します。
 	// (派生クラスでこの仮想関数をオーバーライドすることはできません)
@@ -55,3 +80,43 @@ protected:
 	// カメラがシーンをレンダリングした直後に呼び出されます。
 	virtual void OnPostRender() {  };
 };
+
+
+//--------------------------------------------------------------------------------------
+// ※注意
+// 
+//  「クラステンプレート」や「関数テンプレート」の実装はソースファイル(.cpp)に記述してはいけない。
+//   それらの利用場所から見える場所に記述しよう。
+// 
+//--------------------------------------------------------------------------------------
+
+// T がコールバック関数をオーバーライドしているかを判定する型特性。
+//      ・&T::OnPreCull の型が void (MonoBehaviour::*)() であれば、オーバーライドしていない。
+//      ・派生クラスで protected や private でオーバーライドされていると、&T::OnPreCull の取得に失敗する。
+//        (MonoBehaviour の関数であれば友達なので取得できるので、取得に失敗した場合もオーバーライドしていると判定できる)
+template<typename T, typename>
+struct OverridesOnPreCull : std::true_type {};
+
+template<typename T>
+struct OverridesOnPreCull<T, std::enable_if_t<std::is_same_v<decltype(&T::OnPreCull), void (MonoBehaviour::*)()>>> : std::false_type {};
+
+template<typename T, typename>
+struct OverridesOnPreRender : std::true_type {};
+
+template<typename T>
+struct OverridesOnPreRender<T, std::enable_if_t<std::is_same_v<decltype(&T::OnPreRender), void (MonoBehaviour::*)()>>> : std::false_type {};
+
+template<typename T, typename>
+struct OverridesOnPostRender : std::true_type {};
+
+template<typename T>
+struct OverridesOnPostRender<T, std::enable_if_t<std::is_same_v<decltype(&T::OnPostRender), void (MonoBehaviour::*)()>>> : std::false_type {};
+
+
+template<typename ScriptType>
+inline constexpr uint32_t MonoBehaviour::GetCallbackFlags()
+{
+	return (OverridesOnPreCull<ScriptType>::value ? OnPreCullCallback : 0)
+		| (OverridesOnPreRender<ScriptType>::value ? OnPreRenderCallback : 0)
+		| (OverridesOnPostRender<ScriptType>::value ? OnPostRenderCallback : 0);
+}
@@ -0,0 +1,70 @@
+﻿#include "NameTable.h"
+#include "Hash.h"
+#include <cassert>
+
+// 静的メンバ変数の実体を宣言
+std::vector<std::string> NameTable::s_names;
+std::unordered_multimap<uint32_t, uint32_t> NameTable::s_idsByHash;
+
+
+// 大文字と小文字(ASCIIのみ)を区別せずに2つの名前を比較する。
+// (_strnicmp()と違い、長さが異なれば一致しない)
+// (Shift-JISの2バイト文字は、2バイト目を英字とみなさずにそのまま比較する)
+static bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (IsShiftJISLeadByte(a[i]) && (i + 1 < a.size()))
+        {
+            // 1バイト目が同じなら、b[i] も2バイト文字の1バイト目
+            if ((a[i] != b[i]) || (a[i + 1] != b[i + 1]))
+            {
+                return false;
+            }
+            i++;
+            continue;
+        }
+
+        if (ToLowerASCII(a[i]) != ToLowerASCII(b[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+uint32_t NameTable::Intern(std::string_view name)
+{
+    const uint32_t id = Find(name);
+    if (id != InvalidID)
+    {
+        return id;
+    }
+
+    // 新しい名前として登録する
+    const uint32_t newID = (uint32_t)s_names.size();
+    s_names.emplace_back(name);
+    s_idsByHash.emplace(ComputeCaseInsensitiveHash(name.data(), name.size()), newID);
+    return newID;
+}
+
+
+uint32_t NameTable::Find(std::string_view name)
+{
+    // ハッシュ値が衝突している場合もあるので、文字列も比較して確かめる
+    auto range = s_idsByHash.equal_range(ComputeCaseInsensitiveHash(name.data(), name.size()));
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (EqualsIgnoreCase(s_names[it->second], name))
+        {
+            return it->second;
+        }
+    }
+    return InvalidID;
+}
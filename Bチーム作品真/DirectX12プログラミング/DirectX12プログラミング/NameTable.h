@@ -0,0 +1,39 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// 名前テーブルクラス
+//
+//      ・ゲームオブジェクトの名前を登録(インターン)して、名前毎に一意なIDを割り当てるクラス。
+//      ・大文字と小文字(ASCIIのみ)を区別しないので、"Player" と "player" は同じIDになる。
+//      ・名前はShift-JIS(CP932)として扱い、2バイト文字の2バイト目は英字とみなさない。 ("ア" と "ャ" は別のIDになる)
+//      ・同じ名前の文字列は1つしか保持しないので、名前の比較はIDの比較だけで済む。
+//      ・登録された名前は削除されない。 (種類はゲームオブジェクトの数よりずっと少ない)
+//      ・モノステートパターンで実装されている(全てのメンバがstatic)。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class NameTable
+{
+private:
+    static std::vector<std::string> s_names;                            // ID → 最初に登録された綴りの名前
+    static std::unordered_multimap<uint32_t, uint32_t> s_idsByHash;     // 名前のハッシュ値 → ID
+
+public:
+    // 無効なID (まだ登録されていない名前を検索した場合に返されます)
+    static constexpr uint32_t InvalidID = UINT32_MAX;
+
+    // 名前を登録して、そのIDを返します。 (既に登録済みの場合は同じIDを返します)
+    static uint32_t Intern(std::string_view name);
+
+    // 登録済みの名前のIDを検索します。
+    //      ・登録されていない場合は InvalidID を返します。 (その名前のゲームオブジェクトは存在しません)
+    //      ・新しい文字列を確保しないので、検索の度にメモリ確保は発生しません。
+    static uint32_t Find(std::string_view name);
+
+    // 指定したIDの名前を取得します。
+    static const std::string& GetName(uint32_t id) { return s_names[id]; }
+};
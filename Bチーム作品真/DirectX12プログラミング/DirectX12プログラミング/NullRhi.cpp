@@ -0,0 +1,501 @@
+﻿#include "NullRhi.h"
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+
+
+// 値を語の列として比較する (構造体の == の代わり。 構造体の隙間は memset で 0 にしておくこと)
+template<typename T>
+static bool IsSameValue(const T& a, const T& b)
+{
+    return memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+
+NullRhiCommandList::NullRhiCommandList()
+{
+    Reset();
+}
+
+
+void NullRhiCommandList::Reset()
+{
+    // 確保済みのメモリは残しておく (フレーム毎に確保し直さない)
+    m_stream.clear();
+    memset(&m_state, 0, sizeof(m_state));
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+void NullRhiCommandList::BeginCommand(NullRhiOpcode opcode, uint32_t payloadWords)
+{
+    m_stream.push_back((uint32_t)opcode | (payloadWords << 8));
+    m_stats.commandCount++;
+    m_stats.streamBytes += (1 + payloadWords) * sizeof(uint32_t);
+}
+
+
+void NullRhiCommandList::Write(uint64_t value)
+{
+    m_stream.push_back((uint32_t)value);
+    m_stream.push_back((uint32_t)(value >> 32));
+}
+
+
+void NullRhiCommandList::Write(float value)
+{
+    uint32_t word;
+    memcpy(&word, &value, sizeof(word));
+    m_stream.push_back(word);
+}
+
+
+void NullRhiCommandList::CountStateChange(bool isRedundant)
+{
+    m_stats.stateChangeCount++;
+    if (isRedundant)
+    {
+        m_stats.redundantStateChangeCount++;
+    }
+}
+
+
+void NullRhiCommandList::SetPipelineState(RhiPipelineState* pipelineState)
+{
+    const bool isRedundant = (m_state.pipelineState == pipelineState);
+    CountStateChange(isRedundant);
+    if (!isRedundant)
+    {
+        m_stats.pipelineStateChangeCount++;
+    }
+    m_state.pipelineState = pipelineState;
+
+    BeginCommand(NullRhiOpcode::SetPipelineState, 2);
+    Write((uint64_t)(uintptr_t)pipelineState);
+}
+
+
+void NullRhiCommandList::SetGraphicsRootSignature(RhiRootSignature* rootSignature)
+{
+    CountStateChange(m_state.rootSignature == rootSignature);
+
+    // ルートシグネチャを設定すると、ルートパラメーターは全て未設定に戻る
+    if (m_state.rootSignature != rootSignature)
+    {
+        memset(m_state.rootParameters, 0, sizeof(m_state.rootParameters));
+    }
+    m_state.rootSignature = rootSignature;
+
+    BeginCommand(NullRhiOpcode::SetGraphicsRootSignature, 2);
+    Write((uint64_t)(uintptr_t)rootSignature);
+}
+
+
+void NullRhiCommandList::SetDescriptorHeap(RhiDescriptorHeap* descriptorHeap)
+{
+    CountStateChange(m_state.descriptorHeap == descriptorHeap);
+    m_state.descriptorHeap = descriptorHeap;
+
+    BeginCommand(NullRhiOpcode::SetDescriptorHeap, 2);
+    Write((uint64_t)(uintptr_t)descriptorHeap);
+}
+
+
+void NullRhiCommandList::SetGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t gpuAddress)
+{
+    if (rootParameterIndex < MaxRootParameters)
+    {
+        CountStateChange(m_state.rootParameters[rootParameterIndex] == gpuAddress);
+        m_state.rootParameters[rootParameterIndex] = gpuAddress;
+    }
+    else
+    {
+        CountStateChange(false);
+    }
+
+    BeginCommand(NullRhiOpcode::SetGraphicsRootConstantBufferView, 3);
+    Write(rootParameterIndex);
+    Write(gpuAddress);
+}
+
+
+void NullRhiCommandList::SetGraphicsRootDescriptorTable(uint32_t rootParameterIndex, RhiGpuDescriptor baseDescriptor)
+{
+    if (rootParameterIndex < MaxRootParameters)
+    {
+        CountStateChange(m_state.rootParameters[rootParameterIndex] == baseDescriptor.ptr);
+        m_state.rootParameters[rootParameterIndex] = baseDescriptor.ptr;
+    }
+    else
+    {
+        CountStateChange(false);
+    }
+
+    BeginCommand(NullRhiOpcode::SetGraphicsRootDescriptorTable, 3);
+    Write(rootParameterIndex);
+    Write(baseDescriptor.ptr);
+}
+
+
+void NullRhiCommandList::IASetPrimitiveTopology(RhiPrimitiveTopology primitiveTopology)
+{
+    CountStateChange(m_state.hasPrimitiveTopology && (m_state.primitiveTopology == primitiveTopology));
+    m_state.primitiveTopology = primitiveTopology;
+    m_state.hasPrimitiveTopology = true;
+
+    BeginCommand(NullRhiOpcode::IASetPrimitiveTopology, 1);
+    Write((uint32_t)primitiveTopology);
+}
+
+
+void NullRhiCommandList::IASetVertexBuffer(uint32_t slot, const RhiVertexBufferView& view)
+{
+    // 冗長なステートの検出はスロット0番だけ行う
+    if (slot == 0)
+    {
+        RhiVertexBufferView vertexBuffer;
+        memset(&vertexBuffer, 0, sizeof(vertexBuffer));
+        vertexBuffer.gpuAddress = view.gpuAddress;
+        vertexBuffer.sizeInBytes = view.sizeInBytes;
+        vertexBuffer.strideInBytes = view.strideInBytes;
+        CountStateChange(m_state.hasVertexBuffer && IsSameValue(m_state.vertexBuffer, vertexBuffer));
+        m_state.vertexBuffer = vertexBuffer;
+        m_state.hasVertexBuffer = true;
+    }
+    else
+    {
+        CountStateChange(false);
+    }
+
+    BeginCommand(NullRhiOpcode::IASetVertexBuffer, 5);
+    Write(slot);
+    Write(view.gpuAddress);
+    Write(view.sizeInBytes);
+    Write(view.strideInBytes);
+}
+
+
+void NullRhiCommandList::IASetIndexBuffer(const RhiIndexBufferView& view)
+{
+    RhiIndexBufferView indexBuffer;
+    memset(&indexBuffer, 0, sizeof(indexBuffer));
+    indexBuffer.gpuAddress = view.gpuAddress;
+    indexBuffer.sizeInBytes = view.sizeInBytes;
+    indexBuffer.is32Bit = view.is32Bit;
+    CountStateChange(m_state.hasIndexBuffer && IsSameValue(m_state.indexBuffer, indexBuffer));
+    m_state.indexBuffer = indexBuffer;
+    m_state.hasIndexBuffer = true;
+
+    BeginCommand(NullRhiOpcode::IASetIndexBuffer, 4);
+    Write(view.gpuAddress);
+    Write(view.sizeInBytes);
+    Write((uint32_t)view.is32Bit);
+}
+
+
+void NullRhiCommandList::RSSetViewport(const RhiViewport& viewport)
+{
+    CountStateChange(m_state.hasViewport && IsSameValue(m_state.viewport, viewport));
+    m_state.viewport = viewport;
+    m_state.hasViewport = true;
+
+    BeginCommand(NullRhiOpcode::RSSetViewport, 6);
+    Write(viewport.x);
+    Write(viewport.y);
+    Write(viewport.width);
+    Write(viewport.height);
+    Write(viewport.minDepth);
+    Write(viewport.maxDepth);
+}
+
+
+void NullRhiCommandList::RSSetScissorRect(const RhiRect& rect)
+{
+    CountStateChange(m_state.hasScissorRect && IsSameValue(m_state.scissorRect, rect));
+    m_state.scissorRect = rect;
+    m_state.hasScissorRect = true;
+
+    BeginCommand(NullRhiOpcode::RSSetScissorRect, 4);
+    Write((uint32_t)rect.left);
+    Write((uint32_t)rect.top);
+    Write((uint32_t)rect.right);
+    Write((uint32_t)rect.bottom);
+}
+
+
+void NullRhiCommandList::OMSetRenderTarget(RhiCpuDescriptor renderTargetView, RhiCpuDescriptor depthStencilView)
+{
+    CountStateChange(m_state.hasRenderTarget && (m_state.renderTargetView.ptr == renderTargetView.ptr) && (m_state.depthStencilView.ptr == depthStencilView.ptr));
+    m_state.renderTargetView = renderTargetView;
+    m_state.depthStencilView = depthStencilView;
+    m_state.hasRenderTarget = true;
+
+    BeginCommand(NullRhiOpcode::OMSetRenderTarget, 4);
+    Write(renderTargetView.ptr);
+    Write(depthStencilView.ptr);
+}
+
+
+void NullRhiCommandList::ClearRenderTargetView(RhiCpuDescriptor renderTargetView, const float color[4])
+{
+    m_stats.clearCount++;
+
+    BeginCommand(NullRhiOpcode::ClearRenderTargetView, 6);
+    Write(renderTargetView.ptr);
+    Write(color[0]);
+    Write(color[1]);
+    Write(color[2]);
+    Write(color[3]);
+}
+
+
+void NullRhiCommandList::ClearDepthStencilView(RhiCpuDescriptor depthStencilView, float depth, uint8_t stencil)
+{
+    m_stats.clearCount++;
+
+    BeginCommand(NullRhiOpcode::ClearDepthStencilView, 4);
+    Write(depthStencilView.ptr);
+    Write(depth);
+    Write((uint32_t)stencil);
+}
+
+
+void NullRhiCommandList::DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation)
+{
+    m_stats.drawCount++;
+    m_stats.vertexCount += (uint64_t)vertexCountPerInstance * instanceCount;
+
+    BeginCommand(NullRhiOpcode::DrawInstanced, 4);
+    Write(vertexCountPerInstance);
+    Write(instanceCount);
+    Write(startVertexLocation);
+    Write(startInstanceLocation);
+}
+
+
+void NullRhiCommandList::DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+{
+    m_stats.drawCount++;
+    m_stats.vertexCount += (uint64_t)indexCountPerInstance * instanceCount;
+
+    BeginCommand(NullRhiOpcode::DrawIndexedInstanced, 5);
+    Write(indexCountPerInstance);
+    Write(instanceCount);
+    Write(startIndexLocation);
+    Write((uint32_t)baseVertexLocation);
+    Write(startInstanceLocation);
+}
+
+
+void NullRhiCommandList::ResourceBarrier(RhiResource* resource, RhiResourceState stateBefore, RhiResourceState stateAfter)
+{
+    m_stats.barrierCount++;
+
+    BeginCommand(NullRhiOpcode::ResourceBarrier, 3);
+    Write((uint64_t)(uintptr_t)resource);
+    Write((uint32_t)stateBefore | ((uint32_t)stateAfter << 8));
+}
+
+
+void NullRhiCommandList::CopyBufferRegion(RhiResource* destination, uint64_t destinationOffset, RhiResource* source, uint64_t sourceOffset, uint64_t numBytes)
+{
+    m_stats.copyCount++;
+    m_stats.copyBytes += numBytes;
+
+    BeginCommand(NullRhiOpcode::CopyBufferRegion, 10);
+    Write((uint64_t)(uintptr_t)destination);
+    Write(destinationOffset);
+    Write((uint64_t)(uintptr_t)source);
+    Write(sourceOffset);
+    Write(numBytes);
+}
+
+
+void NullRhiCommandList::CopyBufferToTexture(RhiResource* destination, uint32_t destinationSubresource, uint32_t destinationY, RhiResource* source, const RhiPlacedFootprint& footprint)
+{
+    m_stats.copyCount++;
+    m_stats.copyBytes += (uint64_t)footprint.rowPitch * footprint.height * footprint.depth;
+
+    BeginCommand(NullRhiOpcode::CopyBufferToTexture, 13);
+    Write((uint64_t)(uintptr_t)destination);
+    Write(destinationSubresource);
+    Write(destinationY);
+    Write((uint64_t)(uintptr_t)source);
+    Write(footprint.offset);
+    Write(footprint.format);
+    Write(footprint.width);
+    Write(footprint.height);
+    Write(footprint.depth);
+    Write(footprint.rowPitch);
+}
+
+
+NullRhiCommandContext::NullRhiCommandContext(uint32_t renderTargetWidth, uint32_t renderTargetHeight, uint64_t uploadCapacity)
+    : m_numUsedPooledCommandLists(0)
+    , m_currentCommandList(nullptr)
+    , m_uploadAllocator(uploadCapacity)
+    , m_uploadPages(1, std::vector<uint8_t>((size_t)uploadCapacity))
+    , m_allocatedUploadBytes(0)
+    , m_renderTargetWidth(renderTargetWidth)
+    , m_renderTargetHeight(renderTargetHeight)
+    , m_frameNumber(0)
+    , m_defaultPipelineState(nullptr)
+    , m_defaultRootSignature(nullptr)
+    , m_defaultDescriptorHeap(nullptr)
+{
+    BeginFrame();
+}
+
+
+void NullRhiCommandContext::SetDefaultGraphicsState(RhiPipelineState* pipelineState, RhiRootSignature* rootSignature, RhiDescriptorHeap* descriptorHeap)
+{
+    m_defaultPipelineState = pipelineState;
+    m_defaultRootSignature = rootSignature;
+    m_defaultDescriptorHeap = descriptorHeap;
+}
+
+
+void NullRhiCommandContext::BeginFrame()
+{
+    m_commandList.Reset();
+    for (uint32_t i = 0; i < m_numUsedPooledCommandLists; i++)
+    {
+        m_pooledCommandLists[i]->Reset();
+    }
+    m_numUsedPooledCommandLists = 0;
+    m_submitCommandLists.clear();
+    m_submitCommandLists.push_back(&m_commandList);
+    m_currentCommandList = &m_commandList;
+    m_uploadAllocator.Reset();
+    m_allocatedUploadBytes = 0;
+    m_frameNumber++;
+}
+
+
+RhiCommandList* NullRhiCommandContext::AcquireCommandList()
+{
+    if (m_numUsedPooledCommandLists == m_pooledCommandLists.size())
+    {
+        m_pooledCommandLists.push_back(std::make_unique<NullRhiCommandList>());
+    }
+
+    NullRhiCommandList* commandList = m_pooledCommandLists[m_numUsedPooledCommandLists].get();
+    m_numUsedPooledCommandLists++;
+    m_submitCommandLists.push_back(commandList);
+    return commandList;
+}
+
+
+RhiCommandList* NullRhiCommandContext::ContinueCommandList()
+{
+    m_currentCommandList = (NullRhiCommandList*)AcquireCommandList();
+    ApplyDefaultGraphicsState(m_currentCommandList);
+    return m_currentCommandList;
+}
+
+
+void NullRhiCommandContext::ApplyDefaultGraphicsState(RhiCommandList* commandList) const
+{
+    commandList->SetPipelineState(m_defaultPipelineState);
+    commandList->SetGraphicsRootSignature(m_defaultRootSignature);
+    commandList->SetDescriptorHeap(m_defaultDescriptorHeap);
+}
+
+
+RhiUploadAllocation NullRhiCommandContext::AllocateUploadMemory(uint64_t size)
+{
+    const LinearPageAllocator::Location location = m_uploadAllocator.Allocate(size, UploadAlignment);
+    while (m_uploadPages.size() < m_uploadAllocator.GetNumPages())
+    {
+        m_uploadPages.emplace_back((size_t)m_uploadAllocator.GetPageCapacity((uint32_t)m_uploadPages.size()));
+    }
+    m_allocatedUploadBytes += size;
+
+    // 見せかけのGPU仮想アドレスは、ページ毎に4GiBずつずらす
+    RhiUploadAllocation allocation;
+    allocation.cpuAddress = m_uploadPages[location.pageIndex].data() + location.offset;
+    allocation.gpuAddress = UploadGpuAddressBase + ((uint64_t)location.pageIndex << 32) + location.offset;
+    return allocation;
+}
+
+
+NullRhiStats NullRhiCommandContext::GetStats() const
+{
+    NullRhiStats total;
+    memset(&total, 0, sizeof(total));
+    total.commandListCount = (uint32_t)m_submitCommandLists.size();
+    total.uploadBytes = m_allocatedUploadBytes;
+
+    for (const NullRhiCommandList* commandList : m_submitCommandLists)
+    {
+        const NullRhiStats& stats = commandList->GetStats();
+        total.commandCount += stats.commandCount;
+        total.drawCount += stats.drawCount;
+        total.vertexCount += stats.vertexCount;
+        total.stateChangeCount += stats.stateChangeCount;
+        total.redundantStateChangeCount += stats.redundantStateChangeCount;
+        total.pipelineStateChangeCount += stats.pipelineStateChangeCount;
+        total.clearCount += stats.clearCount;
+        total.barrierCount += stats.barrierCount;
+        total.copyCount += stats.copyCount;
+        total.copyBytes += stats.copyBytes;
+        total.uploadBytes += stats.uploadBytes;
+        total.streamBytes += stats.streamBytes;
+    }
+    return total;
+}
+
+
+void NullRhiCommandContext::PrintStats(const NullRhiStats& stats)
+{
+    printf("[情報] ヌルRHI : コマンドリスト %u 個 / コマンド %u 個 (%llu バイト) / ドローコール %u 回 (%llu 頂点)\n",
+        stats.commandListCount, stats.commandCount, (unsigned long long)stats.streamBytes, stats.drawCount, (unsigned long long)stats.vertexCount);
+    printf("[情報] ヌルRHI : ステート設定 %u 回 (うち冗長 %u 回, パイプラインステートの切り替え %u 回) / クリア %u 回 / バリア %u 回\n",
+        stats.stateChangeCount, stats.redundantStateChangeCount, stats.pipelineStateChangeCount, stats.clearCount, stats.barrierCount);
+    printf("[情報] ヌルRHI : コピー %u 回 (%llu バイト) / アップロード %llu バイト\n",
+        stats.copyCount, (unsigned long long)stats.copyBytes, (unsigned long long)stats.uploadBytes);
+}
+
+
+uint64_t NullRhiCopyQueue::Timeline::GetCompletedValue()
+{
+    // 調べる度に、送った処理を1つずつ完了させる
+    const uint64_t completedValue = m_completedValue;
+    if (m_completedValue < m_lastSignaledValue)
+    {
+        m_completedValue++;
+    }
+    return completedValue;
+}
+
+
+void NullRhiCopyQueue::Timeline::WaitForValue(uint64_t value)
+{
+    assert(value <= m_lastSignaledValue);
+    if (m_completedValue < value)
+    {
+        m_completedValue = value;
+    }
+}
+
+
+NullRhiCopyQueue::NullRhiCopyQueue()
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+uint64_t NullRhiCopyQueue::Submit()
+{
+    const NullRhiStats& stats = m_commandList.GetStats();
+    m_stats.commandListCount++;
+    m_stats.commandCount += stats.commandCount;
+    m_stats.barrierCount += stats.barrierCount;
+    m_stats.copyCount += stats.copyCount;
+    m_stats.copyBytes += stats.copyBytes;
+    m_stats.uploadBytes += stats.uploadBytes;
+    m_stats.streamBytes += stats.streamBytes;
+    m_commandList.Reset();
+
+    return m_timeline.Signal();
+}
@@ -0,0 +1,293 @@
+﻿#pragma once
+#include "Rhi.h"
+#include "LinearPageAllocator.h"
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ※注意
+//
+//  ヌルRHIはGPUを使わずに、描画コマンドをメモリ上に記録して数えるだけのRHIの実装。
+//  描画処理のCPU側のコストやドローコール数を、GPUの無い環境でも計測できるようにする為に使う。
+//  このヘッダーは Windows や D3D12 のヘッダーに依存しないこと。 (標準ライブラリのみを使用する)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// ヌルRHIが記録するコマンドの種類
+enum class NullRhiOpcode : uint8_t
+{
+    SetPipelineState,
+    SetGraphicsRootSignature,
+    SetDescriptorHeap,
+    SetGraphicsRootConstantBufferView,
+    SetGraphicsRootDescriptorTable,
+    IASetPrimitiveTopology,
+    IASetVertexBuffer,
+    IASetIndexBuffer,
+    RSSetViewport,
+    RSSetScissorRect,
+    OMSetRenderTarget,
+    ClearRenderTargetView,
+    ClearDepthStencilView,
+    DrawInstanced,
+    DrawIndexedInstanced,
+    ResourceBarrier,
+    CopyBufferRegion,
+    CopyBufferToTexture,
+};
+
+
+// ヌルRHIの統計情報
+struct NullRhiStats
+{
+    uint32_t commandListCount;          // 記録に使ったコマンドリストの数
+    uint32_t commandCount;              // 記録したコマンドの数
+    uint32_t drawCount;                 // ドローコールの数
+    uint64_t vertexCount;               // 描画した頂点の数 (インデックスを使う場合はインデックスの数)
+    uint32_t stateChangeCount;          // ステートを設定したコマンドの数 (ドロー、クリア、バリア、コピー以外)
+    uint32_t redundantStateChangeCount; // そのうち、設定済みのステートと同じ値を設定した(省けた)コマンドの数
+    uint32_t pipelineStateChangeCount;  // パイプラインステートを切り替えた回数 (同じものを設定し直した回数は含まない)
+    uint32_t clearCount;                // レンダーターゲットと深度ステンシルをクリアした回数
+    uint32_t barrierCount;              // リソースバリアの数
+    uint32_t copyCount;                 // バッファとテクスチャのコピーの数
+    uint64_t copyBytes;                 // バッファとテクスチャのコピーで転送したバイト数
+    uint64_t uploadBytes;               // CPUからアップロード用のメモリに書き込んだバイト数
+    uint64_t streamBytes;               // 記録したコマンドストリームのサイズ (単位はバイト)
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ヌルRHIコマンドリストクラス
+//
+//      ・コマンドを32ビットの語の列(コマンドストリーム)に記録するRHIコマンドリストの実装。
+//      ・各コマンドは「種類 | 引数の語数 << 8」の1語に、引数の語が続く。
+//      ・記録しながらコマンドを種類毎に数え、設定済みのステートと同じ値を設定し直したコマンドも数える。
+//      ・1つのコマンドリストは1つのスレッドからだけ記録すること。(別々のコマンドリストなら同時に記録できる)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class NullRhiCommandList : public RhiCommandList
+{
+public:
+    static constexpr uint32_t MaxRootParameters = 16;   // 冗長なステートの検出で覚えておくルートパラメーターの数
+
+private:
+    // 記録中のコマンドリストに設定済みのステート (冗長なステートの検出用)
+    struct State
+    {
+        RhiPipelineState* pipelineState;
+        RhiRootSignature* rootSignature;
+        RhiDescriptorHeap* descriptorHeap;
+        uint64_t rootParameters[MaxRootParameters];
+        RhiPrimitiveTopology primitiveTopology;
+        bool hasPrimitiveTopology;
+        RhiVertexBufferView vertexBuffer;
+        bool hasVertexBuffer;
+        RhiIndexBufferView indexBuffer;
+        bool hasIndexBuffer;
+        RhiViewport viewport;
+        bool hasViewport;
+        RhiRect scissorRect;
+        bool hasScissorRect;
+        RhiCpuDescriptor renderTargetView;
+        RhiCpuDescriptor depthStencilView;
+        bool hasRenderTarget;
+    };
+
+    std::vector<uint32_t> m_stream;     // コマンドストリーム
+    State m_state;                      // 設定済みのステート
+    NullRhiStats m_stats;               // 統計情報
+
+private:
+    // コマンドの先頭の語を書き込みます。
+    void BeginCommand(NullRhiOpcode opcode, uint32_t payloadWords);
+
+    // 引数を書き込みます。
+    void Write(uint32_t value) { m_stream.push_back(value); }
+    void Write(uint64_t value);
+    void Write(float value);
+
+    // ステートを設定したコマンドを数えます。 (設定済みの値と同じ場合は冗長なものとしても数えます)
+    void CountStateChange(bool isRedundant);
+
+public:
+    // コンストラクタ
+    NullRhiCommandList();
+
+    // 記録したコマンドと統計情報を消して、何も設定されていない状態に戻します。
+    void Reset();
+
+    // コマンドストリームを取得します。
+    const std::vector<uint32_t>& GetStream() const { return m_stream; }
+
+    // 統計情報を取得します。
+    const NullRhiStats& GetStats() const { return m_stats; }
+
+    // RhiCommandList の実装
+    void SetPipelineState(RhiPipelineState* pipelineState) override;
+    void SetGraphicsRootSignature(RhiRootSignature* rootSignature) override;
+    void SetDescriptorHeap(RhiDescriptorHeap* descriptorHeap) override;
+    void SetGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t gpuAddress) override;
+    void SetGraphicsRootDescriptorTable(uint32_t rootParameterIndex, RhiGpuDescriptor baseDescriptor) override;
+    void IASetPrimitiveTopology(RhiPrimitiveTopology primitiveTopology) override;
+    void IASetVertexBuffer(uint32_t slot, const RhiVertexBufferView& view) override;
+    void IASetIndexBuffer(const RhiIndexBufferView& view) override;
+    void RSSetViewport(const RhiViewport& viewport) override;
+    void RSSetScissorRect(const RhiRect& rect) override;
+    void OMSetRenderTarget(RhiCpuDescriptor renderTargetView, RhiCpuDescriptor depthStencilView) override;
+    void ClearRenderTargetView(RhiCpuDescriptor renderTargetView, const float color[4]) override;
+    void ClearDepthStencilView(RhiCpuDescriptor depthStencilView, float depth, uint8_t stencil) override;
+    void DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) override;
+    void DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) override;
+    void ResourceBarrier(RhiResource* resource, RhiResourceState stateBefore, RhiResourceState stateAfter) override;
+    void CopyBufferRegion(RhiResource* destination, uint64_t destinationOffset, RhiResource* source, uint64_t sourceOffset, uint64_t numBytes) override;
+    void CopyBufferToTexture(RhiResource* destination, uint32_t destinationSubresource, uint32_t destinationY, RhiResource* source, const RhiPlacedFootprint& footprint) override;
+    void NotifyUpload(uint64_t numBytes) override { m_stats.uploadBytes += numBytes; }
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ヌルRHIコマンドコンテキストクラス
+//
+//      ・ヌルRHIコマンドリストのプールと、アップロード用のメモリ(CPUのメモリ)を持つRHIコマンドコンテキストの実装。
+//      ・アップロード用のメモリのGPU仮想アドレスは、実在しない(が区別できる)値になる。
+//        (アップロード用のメモリは UploadAllocator と同じくページ単位で、足りなければページを追加する)
+//      ・BeginFrame() から次の BeginFrame() までを1フレームとして、統計情報を集計する。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class NullRhiCommandContext : public RhiCommandContext
+{
+public:
+    static constexpr uint64_t DefaultUploadCapacity = 1024 * 1024;      // 既定のアップロード用のメモリのサイズ
+    static constexpr uint64_t UploadAlignment = 256;                    // アップロード用のメモリのアラインメント (定数バッファと同じ)
+    static constexpr uint64_t UploadGpuAddressBase = 0x100000000ULL;    // アップロード用のメモリの先頭の、見せかけのGPU仮想アドレス
+
+private:
+    NullRhiCommandList m_commandList;                                       // メインのコマンドリスト
+    std::vector<std::unique_ptr<NullRhiCommandList>> m_pooledCommandLists;  // 追加のコマンドリスト
+    uint32_t m_numUsedPooledCommandLists;                                   // このフレームで使用中の追加のコマンドリストの数
+    std::vector<NullRhiCommandList*> m_submitCommandLists;                  // このフレームで使ったコマンドリスト (記録した順番に並ぶ)
+    NullRhiCommandList* m_currentCommandList;                               // メインスレッドが現在記録しているコマンドリスト
+    LinearPageAllocator m_uploadAllocator;                                  // アップロード用のメモリのページ内の位置の管理
+    std::vector<std::vector<uint8_t>> m_uploadPages;                        // アップロード用のメモリのページ
+    uint64_t m_allocatedUploadBytes;                                        // このフレームで切り出したバイト数 (アラインメントの隙間は含まない)
+    uint32_t m_renderTargetWidth;                                           // 描画先の幅
+    uint32_t m_renderTargetHeight;                                          // 描画先の高さ
+    uint64_t m_frameNumber;                                                 // BeginFrame() を呼び出した回数
+    RhiPipelineState* m_defaultPipelineState;                               // デフォルトのパイプラインステート
+    RhiRootSignature* m_defaultRootSignature;                               // デフォルトのルートシグネチャ
+    RhiDescriptorHeap* m_defaultDescriptorHeap;                             // デフォルトのディスクリプタヒープ
+
+public:
+    // コンストラクタ
+    //      第1引数 : [in] 描画先の幅 (単位はピクセル)
+    //      第2引数 : [in] 描画先の高さ (単位はピクセル)
+    //      第3引数 : [in] 1フレームで使えるアップロード用のメモリのサイズ (単位はバイト)
+    NullRhiCommandContext(uint32_t renderTargetWidth, uint32_t renderTargetHeight, uint64_t uploadCapacity = DefaultUploadCapacity);
+
+    // コピーは禁止
+    NullRhiCommandContext(const NullRhiCommandContext&) = delete;
+    NullRhiCommandContext& operator=(const NullRhiCommandContext&) = delete;
+
+    // ApplyDefaultGraphicsState() で設定するステートを登録します。 (所有はしません)
+    void SetDefaultGraphicsState(RhiPipelineState* pipelineState, RhiRootSignature* rootSignature, RhiDescriptorHeap* descriptorHeap);
+
+    // 新しいフレームの記録を始めます。
+    //   ・全てのコマンドリストとアップロード用のメモリを空に戻し、統計情報を数え直します。
+    void BeginFrame();
+
+    // このフレームで使ったコマンドリストを、記録した順番に取得します。
+    const std::vector<NullRhiCommandList*>& GetSubmitCommandLists() const { return m_submitCommandLists; }
+
+    // このフレームの統計情報を集計します。
+    NullRhiStats GetStats() const;
+
+    // 統計情報をコンソールに出力します。
+    static void PrintStats(const NullRhiStats& stats);
+
+    // RhiCommandContext の実装
+    RhiCommandList* GetCommandList() override { return m_currentCommandList; }
+    RhiCommandList* AcquireCommandList() override;
+    RhiCommandList* ContinueCommandList() override;
+    void ApplyDefaultGraphicsState(RhiCommandList* commandList) const override;
+    RhiUploadAllocation AllocateUploadMemory(uint64_t size) override;
+    RhiCpuDescriptor GetRenderTargetView() const override { return { 1 }; }
+    RhiCpuDescriptor GetDepthStencilView() const override { return { 2 }; }
+    uint32_t GetRenderTargetWidth() const override { return m_renderTargetWidth; }
+    uint32_t GetRenderTargetHeight() const override { return m_renderTargetHeight; }
+    uint64_t GetFrameNumber() const override { return m_frameNumber; }
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ヌルGPUタイムラインクラス
+//
+//      ・シグナルした処理がすぐに完了するGPUタイムラインの実装。 (待機は一切しない)
+//      ・フレームスケジューラーをGPUの無い環境で動かす為に使う。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class NullGpuTimeline : public GpuTimeline
+{
+private:
+    uint64_t m_lastSignaledValue;       // 最後にシグナルしたフェンス値
+
+public:
+    // コンストラクタ
+    NullGpuTimeline() : m_lastSignaledValue(0) { }
+
+    // GpuTimeline の実装
+    uint64_t Signal() override { return ++m_lastSignaledValue; }
+    uint64_t GetCompletedValue() override { return m_lastSignaledValue; }
+    void WaitForValue(uint64_t) override { }
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ヌルRHIコピーキュークラス
+//
+//      ・ヌルRHIコマンドリストを1つ持つRHIコピーキューの実装。
+//      ・GPUタイムラインは、GetCompletedValue() で調べる度に、送った処理が1つずつ完了したことになる。
+//        (CPUが完了を調べている間にGPUが少しずつ進む様子を真似る。 すぐには完了しないので、完了待ちの処理を確かめられる)
+//        WaitForValue() は待機せずに、指定したフェンス値まで完了したことにする。
+//      ・Submit() の度にコマンドリストの統計情報を集計してから、コマンドリストを空に戻す。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class NullRhiCopyQueue : public RhiCopyQueue
+{
+private:
+    // 遅れて完了するGPUタイムライン
+    class Timeline : public GpuTimeline
+    {
+    private:
+        uint64_t m_lastSignaledValue;   // 最後にシグナルしたフェンス値
+        uint64_t m_completedValue;      // 完了したことにしたフェンス値
+
+    public:
+        Timeline() : m_lastSignaledValue(0), m_completedValue(0) { }
+
+        // GpuTimeline の実装
+        uint64_t Signal() override { return ++m_lastSignaledValue; }
+        uint64_t GetCompletedValue() override;
+        void WaitForValue(uint64_t value) override;
+    };
+
+    NullRhiCommandList m_commandList;   // コピー用のコマンドリスト
+    Timeline m_timeline;                // GPUタイムライン
+    NullRhiStats m_stats;               // これまでに送ったコマンドリストの統計情報の合計
+
+public:
+    // コンストラクタ
+    NullRhiCopyQueue();
+
+    // コピーは禁止
+    NullRhiCopyQueue(const NullRhiCopyQueue&) = delete;
+    NullRhiCopyQueue& operator=(const NullRhiCopyQueue&) = delete;
+
+    // これまでに送ったコマンドリストの統計情報を取得します。
+    const NullRhiStats& GetStats() const { return m_stats; }
+
+    // RhiCopyQueue の実装
+    RhiCommandList* GetCommandList() override { return &m_commandList; }
+    uint64_t Submit() override;
+    GpuTimeline* GetTimeline() override { return &m_timeline; }
+};
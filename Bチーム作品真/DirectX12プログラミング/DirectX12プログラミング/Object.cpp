@@ -1,4 +1,8 @@
 ﻿#include "Object.h"
+#include "Handle.h"
+#include "SceneManager.h"
+#include "Scene.h"
+#include <cstdio>
 #include <cassert>
 
 // 静的メンバ変数の実体を宣言
@@ -14,12 +18,23 @@ const TypeInfo& Object::GetTypeInfo()
 
 Object::Object()
     : m_instanceID(s_serialInstanceID++)
+    , m_handleIndex(HandleTable::Register(this))
+{
+}
+
+
+Object::Object(const Object& original)
+    : ReferenceCounter(original)
+    , m_instanceID(s_serialInstanceID++)
+    , m_handleIndex(HandleTable::Register(this))
 {
 }
 
 
 Object::~Object()
 {
+    // このオブジェクトを参照しているハンドルを無効にする
+    HandleTable::Unregister(m_handleIndex);
 }
 
 
@@ -31,20 +46,50 @@ uint64_t Object::GetInstanceID() const
 
 void Object::Destroy(Object& object, float t)
 {
-    assert(!"Object::Destroy() is not yet implemented.");
     object.Destroy(t);
 }
 
 
 void Object::DestroyImmediate(Object& object, bool allowDestroyingAssets)
 {
-    assert(!"Object::DestroyImmediate() is not yet implemented.");
     object.DestroyImmediate(allowDestroyingAssets);
 }
 
 
 void Object::DontDestroyOnLoad(Object& target)
 {
-    assert(!"Object::DontDestroyOnLoad() is not yet implemented.");
     target.DontDestroyOnLoad();
 }
+
+
+Object* Object::Clone(const Vector3* position, const Quaternion* rotation, Transform* parent, bool instantiateInWorldSpace) const
+{
+    printf("[失敗] %s の複製 (このデータ型は Instantiate() に対応していません)\n", GetTypeInfoOfInstance().GetTypeName().c_str());
+    assert(0);
+    return nullptr;
+}
+
+
+void Object::Destroy(float time)
+{
+    // アセットはアクティブなシーンのフレームの終わりに破棄する
+    Scene* scene = SceneManager::GetActiveScene();
+    assert(scene);
+    scene->ScheduleDestroy(this, time);
+}
+
+
+void Object::DestroyImmediate(bool allowDestroyingAssets)
+{
+    // アセットを誤って破棄しないように、明示的に許可された場合のみ破棄する
+    if (!allowDestroyingAssets)
+    {
+        printf("[失敗] アセットの破棄 (allowDestroyingAssets が false です)\n");
+        assert(0);
+        return;
+    }
+
+    // スプライトレンダラーやアセットキャッシュが参照していても破棄してしまわないように、呼び出し元の参照だけを解放する。
+    // (最後の参照が解放された時に破棄され、キャッシュに入っている場合は未使用としてキャッシュに任せる)
+    Release();
+}
@@ -21,11 +21,18 @@ class Object : public ReferenceCounter
 private:
     static uint64_t     s_serialInstanceID;     // オブジェクト生成時に割り当てられるID
     uint64_t            m_instanceID;           // 生成時ID
+    uint32_t            m_handleIndex;          // ハンドルテーブル内での格納位置
 
 protected:
     // コンストラクタ
     Object();
 
+    // コピーコンストラクタ (インスタンスIDとハンドルは新しく割り当てられます)
+    Object(const Object& original);
+
+    // コピー代入演算子は禁止 (インスタンスIDとハンドルが重複してしまう)
+    Object& operator=(const Object&) = delete;
+
     // 仮想デストラクタ
     virtual ~Object();
 
@@ -46,28 +53,51 @@ public:
     // インスタンスIDは常にユニークな値であることが保証されます。
     uint64_t GetInstanceID() const;
 
+    // ハンドルテーブル内での格納位置を返します。 (Handle<T>が使用します)
+    uint32_t GetHandleIndex() const { return m_handleIndex; }
+
     // ゲームオブジェクト、コンポーネントやアセットを破棄します。
+    //      ・実際の破棄は time 秒後のフレームの終わり(全てのUpdate()の後)に行われます。
+    //      ・ゲームオブジェクトを破棄すると、その子孫もまとめて破棄されます。
     static void Destroy(Object& object, float time = 0.0f);
 
-    // ゲームオブジェクト、コンポーネントやアセットを破棄します。
+    // ゲームオブジェクト、コンポーネントやアセットを即座に破棄します。
+    //      ・Update()の中では使用できません。代わりに Destroy() を使用してください。
+    //      ・アセットは参照カウントで寿命を管理しているので、呼び出し元が持つ参照を1つ Release() します。
+    //        (他の参照が残っている間は破棄されません。 アセットキャッシュに入っている場合は未使用になり、やがて追い出されます)
     static void DestroyImmediate(Object& object, bool allowDestroyingAssets = false);
 
-    // 新しいシーンのロード時に target オブジェクトを破棄しません。
+    // 新しいシーンのロード(SceneManager::LoadScene())時に target オブジェクトを破棄しません。
+    //      ・ルートゲームオブジェクトとその子孫が、新しいシーンにまとめて移動されます。
+    //      ・コンポーネントを指定した場合は、所有するゲームオブジェクトが対象になります。
+    //      ・アセットはシーンに所属しないので何もしません。
     static void DontDestroyOnLoad(Object& target);
 
     // originalを基にT型のインスタンスを生成します。
+    //      ・ゲームオブジェクトの場合は、子孫とコンポーネントをまとめて複製します。
+    //      ・コンポーネントの場合は、所有するゲームオブジェクトごと複製して、複製されたコンポーネントを返します。
+    //      ・複製はアクティブなシーンに追加されます。
+    //      ・(instantiateInWorldSpace == true)の場合、original の位置をワールド空間での位置として parent の子にします。
     template<typename T>
     static T* Instantiate(const T& original, const Transform* parent = nullptr, bool instantiateInWorldSpace = false);
 
     // originalを基にT型のインスタンスを生成します。
+    //      ・複製のワールド空間での位置と向きを指定します。
     template<typename T>
     static T* Instantiate(const T& original, const Vector3& position, const Quaternion& rotation, const Transform* parent = nullptr);
 
 protected:
-    // 
-    virtual Object* Instantiate(const Object& original, const Vector3* position, const Quaternion* rotation, const Transform* parent, bool instantiateInWorldSpace) { return nullptr; }
-    virtual void Destroy(float time) {}
-    virtual void DestroyImmediate(bool allowDestroyingAssets) {}
+    // このオブジェクトの複製を生成します。 (Instantiate()から呼び出されます)
+    //      ・複製をサポートするクラスでオーバーライドしてください。
+    virtual Object* Clone(const Vector3* position, const Quaternion* rotation, Transform* parent, bool instantiateInWorldSpace) const;
+
+    // time 秒後のフレームの終わりに破棄されるように予約します。
+    virtual void Destroy(float time);
+
+    // 即座に破棄します。
+    virtual void DestroyImmediate(bool allowDestroyingAssets);
+
+    // 新しいシーンのロード時に破棄しないようにします。 (アセットの場合は何もしません)
     virtual void DontDestroyOnLoad() {}
 };
 
@@ -75,12 +105,14 @@ protected:
 template<typename T>
 inline T* Object::Instantiate(const T& original, const Transform* parent, bool instantiateInWorldSpace)
 {
-    return (T*)Instantiate(original, nullptr, nullptr, parent, instantiateInWorldSpace);
+    const Object& object = original;
+    return static_cast<T*>(object.Clone(nullptr, nullptr, const_cast<Transform*>(parent), instantiateInWorldSpace));
 }
 
 
 template<typename T>
 inline T* Object::Instantiate(const T& original, const Vector3& position, const Quaternion& rotation, const Transform* parent)
 {
-    return (T*)Instantiate(original, &position, &rotation, parent, false);
+    const Object& object = original;
+    return static_cast<T*>(object.Clone(&position, &rotation, const_cast<Transform*>(parent), false));
 }
@@ -3,6 +3,7 @@
 #include "DepthStencilFormat.h"
 #include "GraphicsEngine.h"
 #include "ShaderBytecode.h"
+#include "PipelineStateCache.h"
 #include <d3d12.h>
 #include <cassert>
 
@@ -337,103 +338,106 @@ static D3D12_SHADER_BYTECODE ConvertFrom(ShaderBytecode* shaderBytecode)
 }
 
 
-void PipelineStateBuilder::End(ID3D12PipelineState** ppD3D12PipelineState)
+void PipelineStateBuilder::BuildDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* psoDesc) const
 {
-    assert(m_isBegun);
-
-    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
-    memset(&psoDesc, 0, sizeof(psoDesc));
+    memset(psoDesc, 0, sizeof(*psoDesc));
 
-    psoDesc.pRootSignature = m_rootSignature;
+    psoDesc->pRootSignature = m_rootSignature;
 
     // 入力アセンブラ (IA)
-    psoDesc.InputLayout.NumElements = m_numInputElementDescs;
-    psoDesc.InputLayout.pInputElementDescs = m_inputElementDescs;
-    psoDesc.PrimitiveTopologyType = ConvertFrom(m_primitiveTopology);
-    psoDesc.IBStripCutValue = ConvertFrom(m_indexBufferStripCutValue);
+    psoDesc->InputLayout.NumElements = m_numInputElementDescs;
+    psoDesc->InputLayout.pInputElementDescs = m_inputElementDescs;
+    psoDesc->PrimitiveTopologyType = ConvertFrom(m_primitiveTopology);
+    psoDesc->IBStripCutValue = ConvertFrom(m_indexBufferStripCutValue);
 
     // 各種シェーダー
-    psoDesc.VS = ConvertFrom(m_VS);
-    psoDesc.DS = ConvertFrom(m_DS);
-    psoDesc.HS = ConvertFrom(m_HS);
-    psoDesc.GS = ConvertFrom(m_GS);
-    psoDesc.PS = ConvertFrom(m_PS);
+    psoDesc->VS = ConvertFrom(m_VS);
+    psoDesc->DS = ConvertFrom(m_DS);
+    psoDesc->HS = ConvertFrom(m_HS);
+    psoDesc->GS = ConvertFrom(m_GS);
+    psoDesc->PS = ConvertFrom(m_PS);
 
     // ブレンドステート (BS)
-    psoDesc.BlendState.AlphaToCoverageEnable = m_alphaToCoverageEnable;
-    psoDesc.BlendState.IndependentBlendEnable = m_independentBlendEnable;
+    psoDesc->BlendState.AlphaToCoverageEnable = m_alphaToCoverageEnable;
+    psoDesc->BlendState.IndependentBlendEnable = m_independentBlendEnable;
     for (uint32_t i = 0; i < 8; i++)
     {
-        psoDesc.BlendState.RenderTarget[i].BlendEnable = m_renderTargetBlend[i].BlendEnable;
-        psoDesc.BlendState.RenderTarget[i].LogicOpEnable = m_renderTargetBlend[i].LogicOpEnable;
-        psoDesc.BlendState.RenderTarget[i].SrcBlend = ConvertFrom(m_renderTargetBlend[i].SrcBlend);
-        psoDesc.BlendState.RenderTarget[i].SrcBlendAlpha = ConvertFrom(m_renderTargetBlend[i].SrcBlendAlpha);
-        psoDesc.BlendState.RenderTarget[i].DestBlend = ConvertFrom(m_renderTargetBlend[i].DestBlend);
-        psoDesc.BlendState.RenderTarget[i].DestBlendAlpha = ConvertFrom(m_renderTargetBlend[i].DestBlendAlpha);
-        psoDesc.BlendState.RenderTarget[i].BlendOp = ConvertFrom(m_renderTargetBlend[i].BlendOp);
-        psoDesc.BlendState.RenderTarget[i].BlendOpAlpha = ConvertFrom(m_renderTargetBlend[i].BlendOpAlpha);
-        psoDesc.BlendState.RenderTarget[i].LogicOp = ConvertFrom(m_renderTargetBlend[i].LogicOp);
-        psoDesc.BlendState.RenderTarget[i].RenderTargetWriteMask = ConvertFrom(m_renderTargetBlend[i].RenderTargetWriteMask);
+        psoDesc->BlendState.RenderTarget[i].BlendEnable = m_renderTargetBlend[i].BlendEnable;
+        psoDesc->BlendState.RenderTarget[i].LogicOpEnable = m_renderTargetBlend[i].LogicOpEnable;
+        psoDesc->BlendState.RenderTarget[i].SrcBlend = ConvertFrom(m_renderTargetBlend[i].SrcBlend);
+        psoDesc->BlendState.RenderTarget[i].SrcBlendAlpha = ConvertFrom(m_renderTargetBlend[i].SrcBlendAlpha);
+        psoDesc->BlendState.RenderTarget[i].DestBlend = ConvertFrom(m_renderTargetBlend[i].DestBlend);
+        psoDesc->BlendState.RenderTarget[i].DestBlendAlpha = ConvertFrom(m_renderTargetBlend[i].DestBlendAlpha);
+        psoDesc->BlendState.RenderTarget[i].BlendOp = ConvertFrom(m_renderTargetBlend[i].BlendOp);
+        psoDesc->BlendState.RenderTarget[i].BlendOpAlpha = ConvertFrom(m_renderTargetBlend[i].BlendOpAlpha);
+        psoDesc->BlendState.RenderTarget[i].LogicOp = ConvertFrom(m_renderTargetBlend[i].LogicOp);
+        psoDesc->BlendState.RenderTarget[i].RenderTargetWriteMask = ConvertFrom(m_renderTargetBlend[i].RenderTargetWriteMask);
     }
 
     // ラスタライザーステート (RS)
-    psoDesc.RasterizerState.FillMode = ConvertFrom(m_fillMode);
-    psoDesc.RasterizerState.CullMode = ConvertFrom(m_cullMode);
-    psoDesc.RasterizerState.FrontCounterClockwise = m_frontCounterClockwise;
-    psoDesc.RasterizerState.DepthBias = m_depthBias;
-    psoDesc.RasterizerState.DepthBiasClamp = m_depthBiasClamp;
-    psoDesc.RasterizerState.SlopeScaledDepthBias = m_slopeScaledDepthBias;
-    psoDesc.RasterizerState.DepthClipEnable = m_depthClipEnable;
-    psoDesc.RasterizerState.MultisampleEnable = m_multisampleEnable;
-    psoDesc.RasterizerState.AntialiasedLineEnable = m_antialiasedLineEnable;
-    psoDesc.RasterizerState.ForcedSampleCount = m_forcedSampleCount;
-    psoDesc.RasterizerState.ConservativeRaster = ConvertCoservativeRasterizationFrom(m_conservativeRasterEnable);
+    psoDesc->RasterizerState.FillMode = ConvertFrom(m_fillMode);
+    psoDesc->RasterizerState.CullMode = ConvertFrom(m_cullMode);
+    psoDesc->RasterizerState.FrontCounterClockwise = m_frontCounterClockwise;
+    psoDesc->RasterizerState.DepthBias = m_depthBias;
+    psoDesc->RasterizerState.DepthBiasClamp = m_depthBiasClamp;
+    psoDesc->RasterizerState.SlopeScaledDepthBias = m_slopeScaledDepthBias;
+    psoDesc->RasterizerState.DepthClipEnable = m_depthClipEnable;
+    psoDesc->RasterizerState.MultisampleEnable = m_multisampleEnable;
+    psoDesc->RasterizerState.AntialiasedLineEnable = m_antialiasedLineEnable;
+    psoDesc->RasterizerState.ForcedSampleCount = m_forcedSampleCount;
+    psoDesc->RasterizerState.ConservativeRaster = ConvertCoservativeRasterizationFrom(m_conservativeRasterEnable);
 
     // デプスステンシルステート
-    psoDesc.DepthStencilState.DepthEnable = m_depthEnable;
-    psoDesc.DepthStencilState.DepthWriteMask = ConvertDepthWriteMastFrom(m_depthWriteEnable);
-    psoDesc.DepthStencilState.DepthFunc = ConvertFrom(m_depthFunc);
-    psoDesc.DepthStencilState.StencilEnable = m_stencilEnable;
-    psoDesc.DepthStencilState.StencilReadMask = m_stencilReadMask;
-    psoDesc.DepthStencilState.StencilWriteMask = m_stencilWriteMask;
-    psoDesc.DepthStencilState.FrontFace.StencilFailOp = ConvertFrom(m_frontFaceStencilFailOp);
-    psoDesc.DepthStencilState.FrontFace.StencilDepthFailOp = ConvertFrom(m_frontFaceStencilDepthFailOp);
-    psoDesc.DepthStencilState.FrontFace.StencilPassOp = ConvertFrom(m_frontFaceStencilPassOp);
-    psoDesc.DepthStencilState.FrontFace.StencilFunc = ConvertFrom(m_frontFaceStencilFunc);
-    psoDesc.DepthStencilState.BackFace.StencilFailOp = ConvertFrom(m_backFaceStencilFailOp);
-    psoDesc.DepthStencilState.BackFace.StencilDepthFailOp = ConvertFrom(m_backFaceStencilDepthFailOp);
-    psoDesc.DepthStencilState.BackFace.StencilPassOp = ConvertFrom(m_backFaceStencilPassOp);
-    psoDesc.DepthStencilState.BackFace.StencilFunc = ConvertFrom(m_backFaceStencilFunc);
+    psoDesc->DepthStencilState.DepthEnable = m_depthEnable;
+    psoDesc->DepthStencilState.DepthWriteMask = ConvertDepthWriteMastFrom(m_depthWriteEnable);
+    psoDesc->DepthStencilState.DepthFunc = ConvertFrom(m_depthFunc);
+    psoDesc->DepthStencilState.StencilEnable = m_stencilEnable;
+    psoDesc->DepthStencilState.StencilReadMask = m_stencilReadMask;
+    psoDesc->DepthStencilState.StencilWriteMask = m_stencilWriteMask;
+    psoDesc->DepthStencilState.FrontFace.StencilFailOp = ConvertFrom(m_frontFaceStencilFailOp);
+    psoDesc->DepthStencilState.FrontFace.StencilDepthFailOp = ConvertFrom(m_frontFaceStencilDepthFailOp);
+    psoDesc->DepthStencilState.FrontFace.StencilPassOp = ConvertFrom(m_frontFaceStencilPassOp);
+    psoDesc->DepthStencilState.FrontFace.StencilFunc = ConvertFrom(m_frontFaceStencilFunc);
+    psoDesc->DepthStencilState.BackFace.StencilFailOp = ConvertFrom(m_backFaceStencilFailOp);
+    psoDesc->DepthStencilState.BackFace.StencilDepthFailOp = ConvertFrom(m_backFaceStencilDepthFailOp);
+    psoDesc->DepthStencilState.BackFace.StencilPassOp = ConvertFrom(m_backFaceStencilPassOp);
+    psoDesc->DepthStencilState.BackFace.StencilFunc = ConvertFrom(m_backFaceStencilFunc);
 
     // 出力マージャー (OM)
-    psoDesc.NumRenderTargets = m_numRenderTargets;
-    memset(psoDesc.RTVFormats, 0, sizeof(psoDesc.RTVFormats));
-    for (UINT i = 0; i < psoDesc.NumRenderTargets; i++)
+    psoDesc->NumRenderTargets = m_numRenderTargets;
+    memset(psoDesc->RTVFormats, 0, sizeof(psoDesc->RTVFormats));
+    for (UINT i = 0; i < psoDesc->NumRenderTargets; i++)
     {
-        psoDesc.RTVFormats[i] = ConvertFrom(m_renderTargetFormats[i]);
+        psoDesc->RTVFormats[i] = ConvertFrom(m_renderTargetFormats[i]);
     }
-    psoDesc.DSVFormat = ConvertFrom(m_depthStencilFormat);
+    psoDesc->DSVFormat = ConvertFrom(m_depthStencilFormat);
 
     // その他
-    psoDesc.SampleDesc.Count = m_multiSampleCount;
-    psoDesc.SampleDesc.Quality = m_multiSampleQuality;
-    psoDesc.SampleMask = m_blendSampleMask;
-    psoDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
-
-
-    //---------------------------------------------------------------------------------------------------------------------------------------------
-    // パイプラインステートの作成
-    //      第1引数 : [in] 作成に関する詳細情報
-    //      第2引数 : [in] インターフェースID
-    //      第3引数 : [out] パイプラインステートを受け取る変数のアドレス
-    //       戻り値 : 成否を表す整数値 (0未満の場合は失敗、0以上の場合は成功)
-    //---------------------------------------------------------------------------------------------------------------------------------------------
-    if (FAILED(GraphicsEngine::Instance().GetD3D12Device()->CreateGraphicsPipelineState(&psoDesc, IID_ID3D12PipelineState, (void**)ppD3D12PipelineState)))
-    {
-        printf("[失敗] パイプラインステートの作成\n");
-        assert(0);
-    }
-    printf("[成功] パイプラインステートの作成 (アドレス: 0x%p)\n", *ppD3D12PipelineState);
+    psoDesc->SampleDesc.Count = m_multiSampleCount;
+    psoDesc->SampleDesc.Quality = m_multiSampleQuality;
+    psoDesc->SampleMask = m_blendSampleMask;
+    psoDesc->Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+
+}
+
+
+uint64_t PipelineStateBuilder::ComputeHash() const
+{
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
+    BuildDesc(&psoDesc);
+    return PipelineStateCache::ComputeHash(psoDesc);
+}
+
+
+void PipelineStateBuilder::End(ID3D12PipelineState** ppD3D12PipelineState)
+{
+    assert(m_isBegun);
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
+    BuildDesc(&psoDesc);
+
+    // 同じ詳細情報のパイプラインステートは共有する
+    *ppD3D12PipelineState = PipelineStateCache::GetOrCreate(psoDesc);
 
     m_isBegun = false;
 }
@@ -482,7 +482,15 @@ public:
     // サンプルカウントの強制値を取得します。
     uint32_t RSGetForcedSampleCount() const { return m_forcedSampleCount; }
 
-    // 内部ステートに従ってビルドし、新規パイプラインステートを作成します。
+    // 内部ステートからパイプラインステートを作成する為の詳細情報を作成します。
+    // (詳細情報は、このビルダーの入力要素詳細配列を参照します)
+    void BuildDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* psoDesc) const;
+
+    // 内部ステートからパイプラインステートキャッシュのハッシュ値を計算します。 (D3D12デバイスは使いません)
+    uint64_t ComputeHash() const;
+
+    // 内部ステートに従ってビルドし、パイプラインステートを取得します。
+    // 同じ内部ステートで作成済みの場合は、パイプラインステートキャッシュから既存のものを返します。
     void End(ID3D12PipelineState** ppD3D12PipelineState);
 };
 
@@ -0,0 +1,263 @@
+﻿#include "PipelineStateCache.h"
+#include "GraphicsEngine.h"
+#include <cstdio>
+#include <cwchar>
+#include <cassert>
+
+// 静的メンバ変数の実体を宣言
+PipelineStateCacheTable<ID3D12PipelineState> PipelineStateCache::s_table;
+std::unordered_map<const ID3D12RootSignature*, uint64_t> PipelineStateCache::s_rootSignatureHashes;
+ID3D12PipelineLibrary* PipelineStateCache::s_pipelineLibrary = nullptr;
+std::vector<uint8_t> PipelineStateCache::s_libraryData;
+std::wstring PipelineStateCache::s_cacheFilePath;
+bool PipelineStateCache::s_isLibraryDirty = false;
+std::mutex PipelineStateCache::s_mutex;
+
+
+uint64_t PipelineStateCache::ComputeHash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+    // ルートシグネチャ
+    // (登録されていない場合はアドレスで代用する。同じ実行中の重複は省けるが、キャッシュファイルからは読み込めない)
+    uint64_t rootSignatureHash;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        auto it = s_rootSignatureHashes.find(desc.pRootSignature);
+        rootSignatureHash = (it != s_rootSignatureHashes.end()) ? it->second : (uint64_t)(uintptr_t)desc.pRootSignature;
+    }
+    return PipelineStateHash::Compute(desc, rootSignatureHash);
+}
+
+
+void PipelineStateCache::RegisterRootSignature(const ID3D12RootSignature* rootSignature, const void* serializedData, size_t serializedSize)
+{
+    const uint64_t hash = PipelineStateHash::ComputeRootSignatureHash(serializedData, serializedSize);
+
+    // 解放されたルートシグネチャと同じアドレスに別のものが作られることがあるので、常に上書きする
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_rootSignatureHashes[rootSignature] = hash;
+}
+
+
+ID3D12PipelineState* PipelineStateCache::Find(uint64_t hash)
+{
+    return s_table.Find(hash);
+}
+
+
+void PipelineStateCache::Add(uint64_t hash, ID3D12PipelineState* pipelineState)
+{
+    s_table.Add(hash, pipelineState);
+}
+
+
+ID3D12PipelineState* PipelineStateCache::GetOrCreate(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+    const uint64_t hash = ComputeHash(desc);
+
+    // キャッシュに有ればそれを返す。 無ければ作成中の項目を予約して、ロックを外してから作成する
+    // (別のスレッドが同じものを作成中の場合は、完了を待つ。 作成に失敗して項目が消えた場合は、このスレッドが作成し直す)
+    bool isCreator;
+    if (ID3D12PipelineState* cachedPipelineState = s_table.Acquire(hash, isCreator))
+    {
+        return cachedPipelineState;
+    }
+    assert(isCreator);
+    ID3D12PipelineLibrary* pipelineLibrary;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        pipelineLibrary = s_pipelineLibrary;
+    }
+
+    // パイプラインライブラリ内での名前は、ハッシュ値の16進数表記にする
+    wchar_t name[17];
+    swprintf(name, _countof(name), L"%016llx", (unsigned long long)hash);
+
+    // パイプラインライブラリに保存済みの場合は、コンパイルせずに作成できる
+    // (詳細情報が保存時と一致しない場合は失敗するので、その場合は新しく作成する)
+    // (パイプラインライブラリはスレッドセーフだが、同じ名前の読み込みだけは同時に行えない。作成中の項目があるので重ならない)
+    ID3D12PipelineState* pipelineState = nullptr;
+    bool isLoadedFromLibrary = false;
+    bool isStoredToLibrary = false;
+    if (pipelineLibrary && SUCCEEDED(pipelineLibrary->LoadGraphicsPipeline(name, &desc, IID_ID3D12PipelineState, (void**)&pipelineState)))
+    {
+        isLoadedFromLibrary = true;
+        printf("[成功] パイプラインライブラリからパイプラインステートの読み込み (名前: %ls)\n", name);
+    }
+    else
+    {
+        //---------------------------------------------------------------------------------------------------------------------------------------------
+        // パイプラインステートの作成
+        //      第1引数 : [in] 作成に関する詳細情報
+        //      第2引数 : [in] インターフェースID
+        //      第3引数 : [out] パイプラインステートを受け取る変数のアドレス
+        //       戻り値 : 成否を表す整数値 (0未満の場合は失敗、0以上の場合は成功)
+        //---------------------------------------------------------------------------------------------------------------------------------------------
+        if (FAILED(GraphicsEngine::Instance().GetD3D12Device()->CreateGraphicsPipelineState(&desc, IID_ID3D12PipelineState, (void**)&pipelineState)))
+        {
+            printf("[失敗] パイプラインステートの作成\n");
+            assert(0);
+
+            // 予約した項目を消して、完了を待っているスレッドに作成し直させる
+            s_table.Publish(hash, nullptr, false);
+            return nullptr;
+        }
+        printf("[成功] パイプラインステートの作成 (アドレス: 0x%p)\n", pipelineState);
+
+        // 次回の起動時にコンパイルを省けるように、パイプラインライブラリに保存しておく
+        if (pipelineLibrary)
+        {
+            if (SUCCEEDED(pipelineLibrary->StorePipeline(name, pipelineState)))
+            {
+                isStoredToLibrary = true;
+            }
+            else
+            {
+                printf("[警告] パイプラインライブラリへのパイプラインステートの保存 (名前: %ls)\n", name);
+            }
+        }
+    }
+
+    if (isStoredToLibrary)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_isLibraryDirty = true;
+    }
+
+    // 予約した項目に作成したものを入れて、完了を待っているスレッドに知らせる (キャッシュも参照を1つ持つ)
+    s_table.Publish(hash, pipelineState, isLoadedFromLibrary);
+    return pipelineState;
+}
+
+
+void PipelineStateCache::Load(const wchar_t* cacheFilePath)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    assert(!s_pipelineLibrary);
+    s_cacheFilePath = cacheFilePath;
+
+    // パイプラインライブラリは ID3D12Device1 以降の機能
+    ID3D12Device1* d3d12Device1;
+    if (FAILED(GraphicsEngine::Instance().GetD3D12Device()->QueryInterface(IID_ID3D12Device1, (void**)&d3d12Device1)))
+    {
+        printf("[警告] パイプラインライブラリに未対応の為、キャッシュファイルは使用しません\n");
+        return;
+    }
+
+    // キャッシュファイルの中身を読み込む
+    s_libraryData.clear();
+    FILE* file;
+    if (_wfopen_s(&file, cacheFilePath, L"rb") == 0)
+    {
+        fseek(file, 0, SEEK_END);
+        const long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        if (size > 0)
+        {
+            s_libraryData.resize((size_t)size);
+            if (fread(s_libraryData.data(), 1, s_libraryData.size(), file) != s_libraryData.size())
+            {
+                s_libraryData.clear();
+            }
+        }
+        fclose(file);
+    }
+
+    //---------------------------------------------------------------------------------------------------------------------------------------------
+    // パイプラインライブラリの作成
+    //      第1引数 : [in] シリアライズされたパイプラインライブラリ (空のライブラリを作成する場合は nullptr)
+    //      第2引数 : [in] シリアライズされたパイプラインライブラリのサイズ(単位はバイト)
+    //      第3引数 : [in] インターフェースID
+    //      第4引数 : [out] パイプラインライブラリを受け取る変数のアドレス
+    //       戻り値 : 成否を表す整数値 (0未満の場合は失敗、0以上の場合は成功)
+    //
+    //  ※ドライバーやGPUが変わった場合は失敗するので、その場合は空のライブラリを作成し直す。
+    //---------------------------------------------------------------------------------------------------------------------------------------------
+    if (!s_libraryData.empty())
+    {
+        if (SUCCEEDED(d3d12Device1->CreatePipelineLibrary(s_libraryData.data(), s_libraryData.size(), IID_ID3D12PipelineLibrary, (void**)&s_pipelineLibrary)))
+        {
+            printf("[成功] キャッシュファイルからパイプラインライブラリの作成 (%zu バイト)\n", s_libraryData.size());
+        }
+        else
+        {
+            printf("[警告] キャッシュファイルが使用できない為、パイプラインライブラリを作成し直します\n");
+            s_libraryData.clear();
+        }
+    }
+    if (!s_pipelineLibrary)
+    {
+        if (FAILED(d3d12Device1->CreatePipelineLibrary(nullptr, 0, IID_ID3D12PipelineLibrary, (void**)&s_pipelineLibrary)))
+        {
+            printf("[警告] パイプラインライブラリの作成に失敗した為、キャッシュファイルは使用しません\n");
+            s_pipelineLibrary = nullptr;
+        }
+    }
+    d3d12Device1->Release();
+    s_isLibraryDirty = false;
+}
+
+
+void PipelineStateCache::Save()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!s_pipelineLibrary || !s_isLibraryDirty)
+    {
+        return;
+    }
+
+    std::vector<uint8_t> data(s_pipelineLibrary->GetSerializedSize());
+    if (FAILED(s_pipelineLibrary->Serialize(data.data(), data.size())))
+    {
+        printf("[警告] パイプラインライブラリのシリアライズ\n");
+        return;
+    }
+
+    FILE* file;
+    if (_wfopen_s(&file, s_cacheFilePath.c_str(), L"wb") != 0)
+    {
+        printf("[警告] キャッシュファイルを書き込み用に開けませんでした (%ls)\n", s_cacheFilePath.c_str());
+        return;
+    }
+    const size_t writtenSize = fwrite(data.data(), 1, data.size(), file);
+    fclose(file);
+    if (writtenSize != data.size())
+    {
+        printf("[警告] キャッシュファイルの書き込み (%ls)\n", s_cacheFilePath.c_str());
+        return;
+    }
+    printf("[成功] キャッシュファイルの書き込み (%ls, %zu バイト)\n", s_cacheFilePath.c_str(), data.size());
+    s_isLibraryDirty = false;
+}
+
+
+void PipelineStateCache::Clear()
+{
+    s_table.Clear();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_rootSignatureHashes.clear();
+
+    // パイプラインライブラリを解放してから、それが参照しているキャッシュファイルの中身を解放する
+    if (s_pipelineLibrary)
+    {
+        s_pipelineLibrary->Release();
+        s_pipelineLibrary = nullptr;
+    }
+    s_libraryData.clear();
+    s_libraryData.shrink_to_fit();
+    s_isLibraryDirty = false;
+}
+
+
+PipelineStateCacheStats PipelineStateCache::GetStats()
+{
+    return s_table.GetStats();
+}
+
+
+void PipelineStateCache::PrintStats()
+{
+    const PipelineStateCacheStats stats = GetStats();
+    printf("[情報] パイプラインステートキャッシュ : %u 個 / ヒット %u 回 / ライブラリから読み込み %u 回 / コンパイル %u 回\n",
+        stats.entryCount, stats.hitCount, stats.libraryHitCount, stats.compileCount);
+}
@@ -0,0 +1,73 @@
+﻿#pragma once
+#include "PipelineStateCacheTable.h"
+#include <d3d12.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// パイプラインステートキャッシュクラス
+//
+//      ・パイプラインステートを「作成に関する詳細情報から計算した64ビットのハッシュ値」をキーにして共有するクラス。
+//      ・同じ詳細情報で要求された場合は、参照カウントを1増やして既存のパイプラインステートを返す。
+//      ・ハッシュ値はポインターの値ではなく中身から計算するので、実行の度に同じ値になる。
+//          ・シェーダーはバイトコードの中身、入力レイアウトはセマンティック名の文字列から計算する。
+//          ・ルートシグネチャは RegisterRootSignature() で登録されたシリアライズ済みデータから計算する。
+//      ・Load() でキャッシュファイルを読み込んでおくと、ID3D12PipelineLibrary に保存済みのパイプラインステートはコンパイルせずに作成できる。
+//        新しく作成したものは Save() でキャッシュファイルに書き出される。
+//      ・ハッシュ値の計算と Find() / Add() はD3D12デバイスを使わない。 (PipelineStateCacheTable.h に分けてあり、Toolsのテストで確かめられる)
+//      ・作成(コンパイル)はロックを外して行うので、別々のパイプラインステートは複数のスレッドで同時に作成できる。
+//        同じハッシュ値を作成中のスレッドがあれば、重複して作成せずにその完了を待つ。
+//      ・モノステートパターンで実装されている(全てのメンバがstatic)。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class PipelineStateCache
+{
+private:
+    static PipelineStateCacheTable<ID3D12PipelineState> s_table;   // ハッシュ値 → パイプラインステート (作成中の項目を含む)
+    static std::unordered_map<const ID3D12RootSignature*, uint64_t> s_rootSignatureHashes; // ルートシグネチャ → ハッシュ値
+    static ID3D12PipelineLibrary* s_pipelineLibrary;    // パイプラインライブラリ (Load()していない場合は nullptr)
+    static std::vector<uint8_t> s_libraryData;          // キャッシュファイルの中身 (パイプラインライブラリが参照するので、解放するまで保持する)
+    static std::wstring s_cacheFilePath;                // キャッシュファイルへのパス
+    static bool s_isLibraryDirty;                       // パイプラインライブラリに新しく保存した場合は true
+    static std::mutex s_mutex;                          // s_table 以外のメンバを保護する (s_table は自身のロックで保護される)
+
+public:
+    // パイプラインステートを作成する為の詳細情報からハッシュ値を計算します。 (D3D12デバイスは使いません)
+    //   ・pRootSignature は RegisterRootSignature() で登録されている必要があります。
+    static uint64_t ComputeHash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+    // ルートシグネチャを、シリアライズ済みデータから計算したハッシュ値と関連付けます。 (RootSignatureBuilder::End()から呼ばれます)
+    static void RegisterRootSignature(const ID3D12RootSignature* rootSignature, const void* serializedData, size_t serializedSize);
+
+    // 指定したハッシュ値のパイプラインステートを取得します。
+    //   ・見つかった場合は参照カウントを1増やして返します。 見つからなかった場合(作成中の場合を含む)は nullptr を返します。
+    static ID3D12PipelineState* Find(uint64_t hash);
+
+    // パイプラインステートをキャッシュに追加します。 (キャッシュが参照を1つ持ちます)
+    static void Add(uint64_t hash, ID3D12PipelineState* pipelineState);
+
+    // パイプラインステートを取得します。
+    //   ・キャッシュに無い場合は、パイプラインライブラリから読み込むか、新しく作成してキャッシュに追加します。
+    //   ・別のスレッドが同じものを作成中の場合は、その完了を待って同じものを返します。
+    //   ・呼び出し元は、受け取ったパイプラインステートが不要になったら Release() してください。
+    static ID3D12PipelineState* GetOrCreate(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+    // キャッシュファイルを読み込んでパイプラインライブラリを作成します。
+    //   ・ファイルが無い場合や、ドライバーが更新されて使えない場合は、空のパイプラインライブラリを作成します。
+    static void Load(const wchar_t* cacheFilePath);
+
+    // パイプラインライブラリに新しく保存したものがあれば、キャッシュファイルに書き出します。
+    static void Save();
+
+    // キャッシュが持つ全ての参照とパイプラインライブラリを解放します。
+    static void Clear();
+
+    // 統計情報を取得します。
+    static PipelineStateCacheStats GetStats();
+
+    // 統計情報をコンソールに出力します。
+    static void PrintStats();
+};
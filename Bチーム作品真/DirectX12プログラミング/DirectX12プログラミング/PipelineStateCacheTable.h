@@ -0,0 +1,340 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ※注意
+//
+//  パイプラインステートキャッシュのうち、ハッシュ値の計算と、項目の予約・登録・検索(重複した作成の防止)だけを取り出したもの。
+//  D3D12 の型はテンプレート引数として受け取るので、GPUが無い環境でも同じ名前のメンバを持つ構造体で確かめられる。
+//  このヘッダーは Windows や D3D12 のヘッダーに依存しないこと。 (標準ライブラリのみを使用する)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// パイプラインステートキャッシュの統計情報
+struct PipelineStateCacheStats
+{
+    uint32_t hitCount;                  // キャッシュ(メモリ上)に見つかった回数
+    uint32_t libraryHitCount;           // パイプラインライブラリ(キャッシュファイル)から読み込めた回数
+    uint32_t compileCount;              // どちらにも無かったので新しく作成(コンパイル)した回数
+    uint32_t entryCount;                // キャッシュに入っているパイプラインステートの数 (作成中の項目は含まない)
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// パイプラインステートハッシュクラス
+//
+//      ・パイプラインステートを作成する為の詳細情報から、64ビットのハッシュ値(FNV-1a)を計算するクラス。
+//      ・ハッシュ値はポインターの値ではなく中身から計算するので、実行の度に同じ値になる。
+//          ・シェーダーはバイトコードの中身、入力レイアウトはセマンティック名の文字列から計算する。
+//          ・ルートシグネチャはシリアライズ済みデータから計算したハッシュ値を、呼び出し元から受け取る。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class PipelineStateHash
+{
+public:
+    // FNV-1a (64ビット) の定数
+    static constexpr uint64_t FnvOffsetBasis = 14695981039346656037ULL;
+    static constexpr uint64_t FnvPrime = 1099511628211ULL;
+
+    // バイト列をハッシュ値に混ぜます。
+    static uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= FnvPrime;
+        }
+        return hash;
+    }
+
+    // 値をハッシュ値に混ぜます。
+    // (パディングを含む構造体を渡すと、ゴミが混ざってしまうので、整数や列挙型だけを渡すこと)
+    template<typename T>
+    static uint64_t HashValue(uint64_t hash, const T& value)
+    {
+        return HashBytes(hash, &value, sizeof(value));
+    }
+
+    // 文字列の中身をハッシュ値に混ぜます。 (長さも混ぜるので、連結した結果が同じ文字列同士でも区別されます)
+    static uint64_t HashString(uint64_t hash, const char* string)
+    {
+        const size_t length = string ? strlen(string) : 0;
+        hash = HashValue(hash, (uint64_t)length);
+        return HashBytes(hash, string, length);
+    }
+
+    // シリアライズ済みのルートシグネチャからハッシュ値を計算します。
+    static uint64_t ComputeRootSignatureHash(const void* serializedData, size_t serializedSize)
+    {
+        return HashBytes(FnvOffsetBasis, serializedData, serializedSize);
+    }
+
+    // パイプラインステートを作成する為の詳細情報からハッシュ値を計算します。
+    //   ・Desc は D3D12_GRAPHICS_PIPELINE_STATE_DESC と同じ名前のメンバを持つ型であること。 (pRootSignature は使いません)
+    //      第1引数 : [in] 作成に関する詳細情報
+    //      第2引数 : [in] ルートシグネチャのハッシュ値
+    template<typename Desc>
+    static uint64_t Compute(const Desc& desc, uint64_t rootSignatureHash)
+    {
+        uint64_t hash = FnvOffsetBasis;
+
+        // ルートシグネチャ
+        hash = HashValue(hash, rootSignatureHash);
+
+        // 各種シェーダー
+        hash = HashShader(hash, desc.VS);
+        hash = HashShader(hash, desc.PS);
+        hash = HashShader(hash, desc.DS);
+        hash = HashShader(hash, desc.HS);
+        hash = HashShader(hash, desc.GS);
+
+        // 入力アセンブラ (IA)
+        hash = HashValue(hash, desc.InputLayout.NumElements);
+        for (uint32_t i = 0; i < desc.InputLayout.NumElements; i++)
+        {
+            const auto& element = desc.InputLayout.pInputElementDescs[i];
+            hash = HashString(hash, element.SemanticName);
+            hash = HashValue(hash, element.SemanticIndex);
+            hash = HashValue(hash, element.Format);
+            hash = HashValue(hash, element.InputSlot);
+            hash = HashValue(hash, element.AlignedByteOffset);
+            hash = HashValue(hash, element.InputSlotClass);
+            hash = HashValue(hash, element.InstanceDataStepRate);
+        }
+        hash = HashValue(hash, desc.IBStripCutValue);
+        hash = HashValue(hash, desc.PrimitiveTopologyType);
+
+        // ブレンドステート (BS)
+        // (レンダーターゲットごとのブレンド処理が無効な場合は、[0]の設定だけが使われる)
+        hash = HashValue(hash, desc.BlendState.AlphaToCoverageEnable);
+        hash = HashValue(hash, desc.BlendState.IndependentBlendEnable);
+        const uint32_t numRenderTargetBlends = desc.BlendState.IndependentBlendEnable ? 8 : 1;
+        for (uint32_t i = 0; i < numRenderTargetBlends; i++)
+        {
+            const auto& blend = desc.BlendState.RenderTarget[i];
+            hash = HashValue(hash, blend.BlendEnable);
+            hash = HashValue(hash, blend.LogicOpEnable);
+            hash = HashValue(hash, blend.SrcBlend);
+            hash = HashValue(hash, blend.DestBlend);
+            hash = HashValue(hash, blend.BlendOp);
+            hash = HashValue(hash, blend.SrcBlendAlpha);
+            hash = HashValue(hash, blend.DestBlendAlpha);
+            hash = HashValue(hash, blend.BlendOpAlpha);
+            hash = HashValue(hash, blend.LogicOp);
+            hash = HashValue(hash, blend.RenderTargetWriteMask);
+        }
+        hash = HashValue(hash, desc.SampleMask);
+
+        // ラスタライザーステート (RS)
+        hash = HashValue(hash, desc.RasterizerState.FillMode);
+        hash = HashValue(hash, desc.RasterizerState.CullMode);
+        hash = HashValue(hash, desc.RasterizerState.FrontCounterClockwise);
+        hash = HashValue(hash, desc.RasterizerState.DepthBias);
+        hash = HashValue(hash, desc.RasterizerState.DepthBiasClamp);
+        hash = HashValue(hash, desc.RasterizerState.SlopeScaledDepthBias);
+        hash = HashValue(hash, desc.RasterizerState.DepthClipEnable);
+        hash = HashValue(hash, desc.RasterizerState.MultisampleEnable);
+        hash = HashValue(hash, desc.RasterizerState.AntialiasedLineEnable);
+        hash = HashValue(hash, desc.RasterizerState.ForcedSampleCount);
+        hash = HashValue(hash, desc.RasterizerState.ConservativeRaster);
+
+        // デプスステンシルステート
+        hash = HashValue(hash, desc.DepthStencilState.DepthEnable);
+        hash = HashValue(hash, desc.DepthStencilState.DepthWriteMask);
+        hash = HashValue(hash, desc.DepthStencilState.DepthFunc);
+        hash = HashValue(hash, desc.DepthStencilState.StencilEnable);
+        hash = HashValue(hash, desc.DepthStencilState.StencilReadMask);
+        hash = HashValue(hash, desc.DepthStencilState.StencilWriteMask);
+        hash = HashStencilOp(hash, desc.DepthStencilState.FrontFace);
+        hash = HashStencilOp(hash, desc.DepthStencilState.BackFace);
+
+        // 出力マージャー (OM)
+        hash = HashValue(hash, desc.NumRenderTargets);
+        for (uint32_t i = 0; i < desc.NumRenderTargets; i++)
+        {
+            hash = HashValue(hash, desc.RTVFormats[i]);
+        }
+        hash = HashValue(hash, desc.DSVFormat);
+
+        // その他
+        hash = HashValue(hash, desc.SampleDesc.Count);
+        hash = HashValue(hash, desc.SampleDesc.Quality);
+        hash = HashValue(hash, desc.NodeMask);
+        hash = HashValue(hash, desc.Flags);
+        return hash;
+    }
+
+private:
+    // シェーダーバイトコードの中身をハッシュ値に混ぜます。
+    template<typename ShaderBytecode>
+    static uint64_t HashShader(uint64_t hash, const ShaderBytecode& shader)
+    {
+        hash = HashValue(hash, (uint64_t)shader.BytecodeLength);
+        return HashBytes(hash, shader.pShaderBytecode, shader.BytecodeLength);
+    }
+
+    // ステンシル処理の設定をハッシュ値に混ぜます。
+    template<typename StencilOpDesc>
+    static uint64_t HashStencilOp(uint64_t hash, const StencilOpDesc& desc)
+    {
+        hash = HashValue(hash, desc.StencilFailOp);
+        hash = HashValue(hash, desc.StencilDepthFailOp);
+        hash = HashValue(hash, desc.StencilPassOp);
+        hash = HashValue(hash, desc.StencilFunc);
+        return hash;
+    }
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// パイプラインステートキャッシュテーブルクラス
+//
+//      ・ハッシュ値とパイプラインステートの組を管理し、同じものを重複して作成しないようにするクラス。
+//      ・PipelineState は AddRef() と Release() を持つ型であること。 (テーブルも参照を1つ持つ)
+//      ・作成はテーブルの外で(ロックを持たずに)行う。 Acquire() で作成中の項目を予約し、作成が終わったら Publish() する。
+//        同じハッシュ値を作成中のスレッドがあれば、他のスレッドは作成せずに Publish() を待つ。
+//      ・全てのメンバ関数は、別々のスレッドから同時に呼び出せる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+template<typename PipelineState>
+class PipelineStateCacheTable
+{
+private:
+    std::unordered_map<uint64_t, PipelineState*> m_pipelineStates;     // ハッシュ値 → パイプラインステート (作成中の項目は nullptr)
+    uint32_t m_publishedCount;                  // 作成済みの項目の数
+    PipelineStateCacheStats m_stats;            // 統計情報
+    std::mutex m_mutex;                         // 全てのメンバを保護する
+    std::condition_variable m_createdCondition; // 作成中の項目の作成が終わったことを通知する
+
+public:
+    // コンストラクタ
+    PipelineStateCacheTable()
+        : m_publishedCount(0)
+        , m_stats()
+    {
+    }
+
+    // コピーは禁止
+    PipelineStateCacheTable(const PipelineStateCacheTable&) = delete;
+    PipelineStateCacheTable& operator=(const PipelineStateCacheTable&) = delete;
+
+    // 指定したハッシュ値のパイプラインステートを取得します。
+    //   ・見つかった場合は参照カウントを1増やして返します。 見つからなかった場合(作成中の場合を含む)は nullptr を返します。
+    PipelineState* Find(uint64_t hash)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pipelineStates.find(hash);
+        if ((it == m_pipelineStates.end()) || !it->second)
+        {
+            return nullptr;
+        }
+        it->second->AddRef();
+        return it->second;
+    }
+
+    // 作成済みのパイプラインステートを追加します。 (テーブルが参照を1つ持ちます)
+    void Add(uint64_t hash, PipelineState* pipelineState)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        assert(m_pipelineStates.find(hash) == m_pipelineStates.end());
+        pipelineState->AddRef();
+        m_pipelineStates[hash] = pipelineState;
+        m_publishedCount++;
+    }
+
+    // 指定したハッシュ値のパイプラインステートを取得するか、作成中の項目を予約します。
+    //   ・見つかった場合は、参照カウントを1増やして返します。 (isCreator は false)
+    //   ・他のスレッドが作成中の場合は、その完了を待ちます。
+    //   ・見つからなかった場合は、作成中の項目を予約して nullptr を返します。 (isCreator は true)
+    //     呼び出し元はパイプラインステートを作成して、成功しても失敗しても必ず Publish() してください。
+    //      第1引数 : [in] ハッシュ値
+    //      第2引数 : [out] 呼び出し元が作成する必要がある場合は true
+    PipelineState* Acquire(uint64_t hash, bool& isCreator)
+    {
+        isCreator = false;
+
+        // (作成に失敗して項目が消えた場合は、待っていたスレッドが作成し直す)
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            auto it = m_pipelineStates.find(hash);
+            if (it == m_pipelineStates.end())
+            {
+                m_pipelineStates[hash] = nullptr;
+                isCreator = true;
+                return nullptr;
+            }
+            if (it->second)
+            {
+                m_stats.hitCount++;
+                it->second->AddRef();
+                return it->second;
+            }
+            m_createdCondition.wait(lock);
+        }
+    }
+
+    // Acquire() で予約した項目に、作成したパイプラインステートを入れて、完了を待っているスレッドに知らせます。
+    //   ・成功した場合は、テーブルも参照を1つ持ちます。 (呼び出し元の参照はそのまま呼び出し元のもの)
+    //   ・失敗した場合(nullptr)は予約を取り消し、待っているスレッドのどれかに作成し直させます。
+    //      第1引数 : [in] ハッシュ値
+    //      第2引数 : [in] 作成したパイプラインステート (失敗した場合は nullptr)
+    //      第3引数 : [in] パイプラインライブラリから読み込んだ場合は true (コンパイルした場合は false)
+    void Publish(uint64_t hash, PipelineState* pipelineState, bool isLoadedFromLibrary)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_pipelineStates.find(hash);
+            assert((it != m_pipelineStates.end()) && !it->second);
+            if (!pipelineState)
+            {
+                m_pipelineStates.erase(it);
+            }
+            else
+            {
+                if (isLoadedFromLibrary)
+                {
+                    m_stats.libraryHitCount++;
+                }
+                else
+                {
+                    m_stats.compileCount++;
+                }
+                pipelineState->AddRef();
+                it->second = pipelineState;
+                m_publishedCount++;
+            }
+        }
+        m_createdCondition.notify_all();
+    }
+
+    // テーブルが持つ全ての参照を解放します。 (作成中の項目が無い時に呼び出してください)
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& pair : m_pipelineStates)
+        {
+            if (pair.second)
+            {
+                pair.second->Release();
+            }
+        }
+        m_pipelineStates.clear();
+        m_publishedCount = 0;
+    }
+
+    // 統計情報を取得します。
+    PipelineStateCacheStats GetStats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        PipelineStateCacheStats stats = m_stats;
+        stats.entryCount = m_publishedCount;
+        return stats;
+    }
+};
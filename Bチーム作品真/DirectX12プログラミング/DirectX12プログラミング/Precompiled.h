@@ -72,7 +72,9 @@
 // システム
 #include "TypeInfo.h"					// このゲームエンジン内で主要なクラスを表す数値
 #include "Object.h"						// このゲームエンジン内の主要なクラスの基底
+#include "Handle.h"						// 破棄済みのオブジェクトを検出できる弱い参照
 #include "ReferenceCounter.h"			// オブジェクトの寿命管理 (参照カウント方式)
+#include "JobSystem.h"					// ワーカースレッドによるジョブの並列実行
 
 // 数学
 #include "Mathf.h"						// 数学における定数や変換処理などを定義
@@ -82,15 +84,23 @@
 #include "Vector3.h"					// 3次元ベクトル
 #include "Vector4.h"					// 4次元ベクトル
 #include "Matrix4x4.h"					// 4x4行列
+#include "Bounds.h"						// バウンディングボックス (AABB)
 
 // グラフィックスエンジン
 #include "PIX.h"                        // D3D12グラフィックスアナライザー (デバッグ用)
+#include "Rhi.h"						// RHI (描画処理とグラフィックスAPIの間に挟むインターフェイス)
+#include "D3D12Rhi.h"					// RHIの D3D12 の実装
+#include "NullRhi.h"					// RHIのヌル実装 (GPUを使わずにコマンドを記録して数える)
 #include "GraphicsEngine.h"				// 2D・3Dグラフィックスエンジン
 #include "FrameResources.h"				// フレームごとに使用するリソース
+#include "DescriptorAllocator.h"		// シェーダーから見えるディスクリプタヒープ (永続領域 + フレーム毎の一時領域)
+#include "GpuTimeline.h"				// コマンドキューとフェンスの組 (単調増加するフェンス値)
+#include "FrameScheduler.h"				// 最大 N フレームをGPUの完了を待たずに処理するスケジューラー
 #include "RootSignatureBuilder.h"		// ルートシグネチャ (ビルダーパターン)
 #include "RootParameter.h"				// ルートパラメーター
 #include "StaticSampler.h"				// スタティックサンプラー
 #include "PipelineStateBuilder.h"		// グラフィックスパイプラインステート (ビルダーパターン)
+#include "PipelineStateCache.h"			// パイプラインステートキャッシュ (同じ詳細情報のパイプラインステートを共有する)
 #include "RenderTargetBlend.h"			// レンダーターゲットカラーブレンディング
 
 // バッファリソース
@@ -98,6 +108,7 @@
 #include "VertexBuffer.h"				// 頂点バッファ
 #include "IndexBuffer.h"				// インデックスバッファ
 #include "ConstantBuffer.h"				// 定数バッファ
+#include "UploadAllocator.h"			// フレーム毎の定数データの確保先 (線形アロケーター)
 #include "DepthStencilFormat.h"			// 深度ステンシルフォーマット
 #include "DepthStencil.h"				// 深度ステンシルバッファ
 
@@ -107,11 +118,19 @@
 #include "TextureWrapMode.h"			// テクスチャの(u,v,w)におけるラップモード
 #include "Texture.h"					// 「2次元テクスチャ」と「レンダーテクスチャ」の基底クラス
 #include "Texture2D.h"					// 2次元テクスチャ
+#include "AssetArchiveFormat.h"			// アセットアーカイブのファイル形式とパスの検索 (アセットパッカーと共有する)
+#include "AssetArchive.h"				// アセットアーカイブ (1つにまとめたアセットをメモリマップして読み出す)
+#include "AssetCache.h"					// アセットキャッシュ (パスをキーにしてロード済みのアセットを共有する)
+#include "StagingRing.h"				// フェンス値で領域を返却するリングアロケーター
+#include "TextureUploadQueue.h"			// ステージングリング経由でコピーキューにテクスチャのコピーを送る
+#include "TextureStreamer.h"			// テクスチャのデコードとアップロードを非同期に行う (完了まではプレースホルダー)
 #include "RenderTextureDescriptor.h"	// レンダーテクスチャ詳細情報
 #include "RenderTexture.h"				// レンダーテクスチャ
 
 // シェーダー
 #include "ShaderBytecode.h"				// シェーダーバイトコード
+#include "ShaderCacheKey.h"				// シェーダーキャッシュのキーの計算 (シェーダークッカーと共有する)
+#include "ShaderCache.h"				// シェーダーキャッシュ (コンパイル済みのシェーダーを共有し、ファイルに保存する)
 #include "ShaderReflection.h"			// シェーダーリフレクション (メタ情報)
 
 // その他
@@ -1,5 +1,7 @@
 ﻿#include "PuyoPuyo.MainScene.h"
 #include "PuyoPuyo.PlayerController.h"
+#include <chrono>
+#include <random>
 
 namespace PuyoPuyo
 {
@@ -10,6 +12,9 @@ namespace PuyoPuyo
 
     void MainScene::LoadAssets()
 	{
+        // ロード時間の計測開始
+        const std::chrono::steady_clock::time_point loadStartTime = std::chrono::steady_clock::now();
+
         // シーンルートのゲームオブジェクトを作成
         m_sceneRoot = new GameObject("シーンルート");
 
@@ -19,19 +24,25 @@ namespace PuyoPuyo
         // 背景を作成
         CreateBackground(m_sceneRoot->GetTransform());
 
+        // 組ぷよを決める乱数の種 (全プレイヤーで共有し、各プレイヤーがプレイヤーインデックスと混ぜて使う)
+        const uint32_t randomSeed = std::random_device()();
+        printf("[情報] 乱数の種 : %u\n", randomSeed);
+
         // 1Pの追加
         GameObject* player1 = new GameObject("1P");
+        const GameObject* frame1P;
         {
             PlayerController* playerController = player1->AddComponent<PlayerController>();
-            playerController->Create(PlayerIndex::One, m_sceneRoot->GetTransform());
+            playerController->Create(PlayerIndex::One, randomSeed, m_sceneRoot->GetTransform());
             m_playerControllers.push_back(playerController);
+            frame1P = playerController->GetFrame();
         }
 
-        // 2Pの追加
+        // 2Pの追加 (フレームは1Pのものを複製して作る)
         GameObject* player2 = new GameObject("2P");
         {
             PlayerController* playerController = player2->AddComponent<PlayerController>();
-            playerController->Create(PlayerIndex::Two, m_sceneRoot->GetTransform());
+            playerController->Create(PlayerIndex::Two, randomSeed, m_sceneRoot->GetTransform(), frame1P);
             m_playerControllers.push_back(playerController);
         }
 
@@ -41,6 +52,11 @@ namespace PuyoPuyo
             assert(0);
         }
 
+        // ロード時間を出力する
+        const std::chrono::steady_clock::time_point loadEndTime = std::chrono::steady_clock::now();
+        const double loadTime = std::chrono::duration<double, std::milli>(loadEndTime - loadStartTime).count();
+        printf("[成功] ぷよぷよ「メイン画面」のロード (%.3fミリ秒)\n", loadTime);
+
         // 背景音(BGM)の再生
         //PlaySound("Assets/PuyoPuyo/BGM/bgm_es38_heppoko.wav", nullptr, SND_ASYNC | SND_FILENAME | SND_LOOP);
         System::Instance().PlaySharedBGM(System::BackgroundMusicID::es38_heppoko);
@@ -86,6 +102,9 @@ namespace PuyoPuyo
 	{
         Scene::Update();
 
+        // プレイヤーが予約した効果音をメインスレッドで再生する
+        System::Instance().FlushSharedSE();
+
 	}
 
 
@@ -12,6 +12,7 @@ namespace PuyoPuyo
 		//---------------------------------------------------------------------------------------------------------------------------------------------
 		m_playerIndex = PlayerIndex::One;
 		m_rotationAxis = nullptr;
+		m_frame = nullptr;
 		m_state = State::Controllable;
 		m_chainCount = 0;
 	}
@@ -282,11 +283,16 @@ namespace PuyoPuyo
 	}
 
 
-	void PlayerController::Create(PlayerIndex playerIndex, Transform* parent)
+	void PlayerController::Create(PlayerIndex playerIndex, uint32_t randomSeed, Transform* parent, const GameObject* framePrefab)
 	{
 		assert(parent);
 		m_playerIndex = playerIndex;
 
+		// 乱数生成器を初期化する
+		// (ワーカースレッドで更新されるので、スレッド毎に状態を持つ rand() は使わない)
+		std::seed_seq seedSequence{ randomSeed, (uint32_t)playerIndex };
+		m_random.seed(seedSequence);
+
 		// フィールド回転軸
 		m_rotationAxis = new GameObject("フィールド回転軸");
 		m_rotationAxis->GetTransform()->SetParent(parent->GetTransform());
@@ -304,12 +310,12 @@ namespace PuyoPuyo
 		{
 		case PlayerIndex::One:
 			m_rotationAxis->GetTransform()->SetLocalPosition(472, 198, 0);
-			CreateFrame1P(m_rotationAxis->GetTransform());
+			m_frame = CreateFrame1P(m_rotationAxis->GetTransform());
 			break;
 
 		case PlayerIndex::Two:
 			m_rotationAxis->GetTransform()->SetLocalPosition(1920 - 472, 198, 0);
-			CreateFrame2P(m_rotationAxis->GetTransform());
+			m_frame = CreateFrame2P(m_rotationAxis->GetTransform(), framePrefab);
 			break;
 
 		default:
@@ -324,43 +330,72 @@ namespace PuyoPuyo
 	}
 
 
-	void PlayerController::CreateFrame1P(Transform* parent)
+	GameObject* PlayerController::CreateFrame1P(Transform* parent)
 	{
 		// 各種テクスチャのロード
 		Texture2D* frameTexture = Texture2D::FromFile(L"Assets/PuyoPuyo/Textures/puyo/puyo2P/puyo2P.tzip/win_field_puyo_d4444.png");
 		Texture2D* nextPieceTexture = Texture2D::FromFile(L"Assets/PuyoPuyo/Textures/puyo/puyo2P/puyo2P.tzip/pla_next_d4444.png");
 		Texture2D* namePlateTexture = Texture2D::FromFile(L"Assets/PuyoPuyo/Textures/puyo/puyo2P/puyo2P.tzip/pla_username_d4444.png");
 
+		// 部品をまとめる親 (2Pはこれを丸ごと複製する)
+		GameObject* frame = new GameObject("1P枠");
+		frame->GetTransform()->SetParent(parent, false);
+		Transform* frameTransform = frame->GetTransform();
+
 		// 1P
-		GameObject::CreateWithSprite("1P枠上部", frameTexture, Rect(5, 4, 436, 52), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217, 724, 0), parent);
-		GameObject::CreateWithSprite("1P枠左上", frameTexture, Rect(451, 4, 25, 356), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217, 372, 0), parent);
-		GameObject::CreateWithSprite("1P枠左下", frameTexture, Rect(571, 4, 25, 364), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217, 8, 0), parent);
-		GameObject::CreateWithSprite("1P枠右上", frameTexture, Rect(476, 4, 25, 356), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 + 417, 372, 0), parent);
-		GameObject::CreateWithSprite("1P枠右下", frameTexture, Rect(596, 4, 25, 364), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 + 417, 8, 0), parent);
-		GameObject::CreateWithSprite("1P枠下部", frameTexture, Rect(5, 64, 436, 64), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217, -56, 0), parent);
-		GameObject::CreateWithSprite("1Pネクスト背景", nextPieceTexture, Rect(330, 4, 160, 300), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 + 438, 446, 0), parent);
-		GameObject::CreateWithSprite("1Pネクスト枠", nextPieceTexture, Rect(0, 4, 160, 306), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 + 440, 438, 0), parent);
-		GameObject::CreateWithSprite("1Pネームプレート", namePlateTexture, Rect(0, 0, 560, 64), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 - 61, -128, 0), parent);
+		GameObject::CreateWithSprite("枠上部", frameTexture, Rect(5, 4, 436, 52), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217, 724, 0), frameTransform);
+		GameObject::CreateWithSprite("枠左上", frameTexture, Rect(451, 4, 25, 356), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217, 372, 0), frameTransform);
+		GameObject::CreateWithSprite("枠左下", frameTexture, Rect(571, 4, 25, 364), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217, 8, 0), frameTransform);
+		GameObject::CreateWithSprite("枠右上", frameTexture, Rect(476, 4, 25, 356), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 + 417, 372, 0), frameTransform);
+		GameObject::CreateWithSprite("枠右下", frameTexture, Rect(596, 4, 25, 364), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 + 417, 8, 0), frameTransform);
+		GameObject::CreateWithSprite("枠下部", frameTexture, Rect(5, 64, 436, 64), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217, -56, 0), frameTransform);
+		GameObject::CreateWithSprite("ネクスト背景", nextPieceTexture, Rect(330, 4, 160, 300), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 + 438, 446, 0), frameTransform);
+		GameObject::CreateWithSprite("ネクスト枠", nextPieceTexture, Rect(0, 4, 160, 306), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 + 440, 438, 0), frameTransform);
+		GameObject::CreateWithSprite("ネームプレート", namePlateTexture, Rect(0, 0, 560, 64), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 - 61, -128, 0), frameTransform);
+		return frame;
 	}
 
 
-	void PlayerController::CreateFrame2P(Transform* parent)
+	GameObject* PlayerController::CreateFrame2P(Transform* parent, const GameObject* framePrefab)
 	{
-		// 各種テクスチャのロード
-		Texture2D* frameTexture = Texture2D::FromFile(L"Assets/PuyoPuyo/Textures/puyo/puyo2P/puyo2P.tzip/win_field_puyo_d4444.png");
-		Texture2D* nextPieceTexture = Texture2D::FromFile(L"Assets/PuyoPuyo/Textures/puyo/puyo2P/puyo2P.tzip/pla_next_d4444.png");
-		Texture2D* namePlateTexture = Texture2D::FromFile(L"Assets/PuyoPuyo/Textures/puyo/puyo2P/puyo2P.tzip/pla_username_d4444.png");
+		// 1Pフレームを複製する (コンポーネントとスプライトの参照ごと1回の走査で複製される)
+		GameObject* frame = framePrefab ? Object::Instantiate(*framePrefab, parent, false) : CreateFrame1P(parent);
+		frame->SetName("2P枠");
 
-		// 2P
-		GameObject::CreateWithSprite("2P枠上部", frameTexture, Rect(5, 4 + 136, 436, 52), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217, 724, 0), parent);
-		GameObject::CreateWithSprite("2P枠左上", frameTexture, Rect(451 + 60, 4, 25, 356), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217, 372, 0), parent);
-		GameObject::CreateWithSprite("2P枠左下", frameTexture, Rect(571 + 60, 4, 25, 364), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217, 8, 0), parent);
-		GameObject::CreateWithSprite("2P枠右上", frameTexture, Rect(476 + 60, 4, 25, 356), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 + 417, 372, 0), parent);
-		GameObject::CreateWithSprite("2P枠右下", frameTexture, Rect(596 + 60, 4, 25, 364), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 + 417, 8, 0), parent);
-		GameObject::CreateWithSprite("2P枠下部", frameTexture, Rect(5, 64 + 136, 436, 64), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217, -56, 0), parent);
-		GameObject::CreateWithSprite("2Pネクスト背景", nextPieceTexture, Rect(330 + 160, 4, 160, 300), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 - 165, 446, 0), parent);
-		GameObject::CreateWithSprite("2Pネクスト枠", nextPieceTexture, Rect(0 + 160, 4, 160, 306), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 - 167, 438, 0), parent);
-		GameObject::CreateWithSprite("2Pネームプレート", namePlateTexture, Rect(0, 0, 560, 64), Vector2(0.0f, 0.0f), 1.0f, Vector3(-217 - 61, -128, 0), parent);
+		// 2P用の絵は、同じテクスチャの中で1P用の絵からずらした位置にある
+		struct FramePart
+		{
+			const char* name;		// 部品の名前
+			float		offsetX;	// 1P用の矩形からのずれ
+			float		offsetY;
+			float		positionX;	// 2P用のX座標 (0の場合は1Pと同じ)
+		};
+		static const FramePart framePartsFor2P[] =
+		{
+			{ "枠上部",			0,		136,	0 },
+			{ "枠左上",			60,		0,		0 },
+			{ "枠左下",			60,		0,		0 },
+			{ "枠右上",			60,		0,		0 },
+			{ "枠右下",			60,		0,		0 },
+			{ "枠下部",			0,		136,	0 },
+			{ "ネクスト背景",	160,	0,		-217 - 165 },
+			{ "ネクスト枠",		160,	0,		-217 - 167 },
+		};
+		for (const FramePart& part : framePartsFor2P)
+		{
+			Transform* partTransform = frame->GetTransform()->Find(part.name);
+			assert(partTransform);
+			SpriteRenderer* spriteRenderer = partTransform->GetGameObject()->GetComponent<SpriteRenderer>();
+			const Sprite* sprite = spriteRenderer->GetSprite();
+			const Rect& rect = sprite->GetTextureRect();
+			spriteRenderer->SetSprite(Sprite::Create(sprite->GetTexture(), Rect(rect.x + part.offsetX, rect.y + part.offsetY, rect.width, rect.height), sprite->GetPivot(), sprite->GetPixelsPerUnit()));
+			if (part.positionX != 0)
+			{
+				const DirectX::XMFLOAT3 position = partTransform->GetLocalPosition();
+				partTransform->SetLocalPosition(part.positionX, position.y, position.z);
+			}
+		}
+		return frame;
 	}
 
 
@@ -433,6 +468,12 @@ namespace PuyoPuyo
 	}
 
 
+	int PlayerController::Random(int n)
+	{
+		return std::uniform_int_distribution<int>(0, n - 1)(m_random);
+	}
+
+
 	void PlayerController::PlacePuyoOnField(int xInCells, int yInCells, PuyoType puyoType)
 	{
 		m_field[yInCells][xInCells].SetType(puyoType);
@@ -3,6 +3,7 @@
 #include "PuyoPuyo.PuyoPiece.h"
 #include "PuyoPuyo.System.h"
 #include <vector>
+#include <random>
 
 namespace PuyoPuyo
 {
@@ -38,6 +39,7 @@ namespace PuyoPuyo
 		// ここにメンバ変数を宣言する
 		PlayerIndex	m_playerIndex;									// プレイヤーインデックス
 		GameObject* m_rotationAxis;									// 回転軸
+		GameObject* m_frame;										// フレーム (枠・ネクスト・ネームプレートをまとめた親)
 		State		m_state;										// ゲームの進行状態
 		Puyo		m_field[System::CellNumY][System::CellNumX];	// フィールド
 		Puyo		m_floating[System::MaxNumFloatings];			// 浮いているぷよ配列
@@ -46,6 +48,7 @@ namespace PuyoPuyo
 		PuyoPiece	m_nextPiece[2];									// 次に落ちてくる組ぷよ
 		bool        m_searched[System::CellNumY][System::CellNumX];	// 探索済みか？
 		int			m_chainCount;									// 連鎖数
+		std::mt19937 m_random;										// 組ぷよを決める乱数生成器 (プレイヤー毎に持つので、並列に更新しても干渉しない)
 		friend class Scene;											// シーンクラスは友達
 		friend class GameObject;									// ゲームオブジェクトクラスは友達
 		friend class PuyoPiece;										// 組ぷよクラスは友達
@@ -82,15 +85,25 @@ namespace PuyoPuyo
 		void UpdateOnWin();
 
 	public:
+		// プレイヤー同士は互いのデータに触れないので、ワーカースレッドで並列に更新してもよい。
+		static bool AllowParallelUpdate() { return true; }
+
 		// プレイヤーを作成します。
-		void Create(PlayerIndex playerIndex, Transform* parent);
+		//		・乱数の種はゲーム毎に1つ決めて全プレイヤーに渡します。 (プレイヤーインデックスと混ぜるので、プレイヤー毎に別の組ぷよの列になります)
+		//		・2Pの場合は、framePrefab に1Pのフレームを渡すと、それを Instantiate() で複製してフレームを作ります。
+		void Create(PlayerIndex playerIndex, uint32_t randomSeed, Transform* parent, const GameObject* framePrefab = nullptr);
+
+		// フレームを取得します。 (他のプレイヤーを作成する時に framePrefab として渡せます)
+		const GameObject* GetFrame() const { return m_frame; }
 
 	private:
 		// 1Pフレームを作成します。
-		void CreateFrame1P(Transform* parent);
+		GameObject* CreateFrame1P(Transform* parent);
 
 		// 2Pフレームを作成します。
-		void CreateFrame2P(Transform* parent);
+		//		・1Pフレーム(framePrefab)を Instantiate() で複製して、2P用の矩形のスプライトとネクストの位置に差し替えます。
+		//		・framePrefab が nullptr の場合は、1Pフレームを作成してから差し替えます。
+		GameObject* CreateFrame2P(Transform* parent, const GameObject* framePrefab);
 
 		// フィールドを作成します。
 		void CreateField(Transform* parent);
@@ -105,6 +118,9 @@ namespace PuyoPuyo
 		// このプレイヤーを初期化します。
 		void Reset();
 
+		// 0 以上 n 未満の乱数を返します。
+		int Random(int n);
+
 		// フィールド上の指定した位置にぷよを置きます。
 		void PlacePuyoOnField(int xInCells, int yInCells, PuyoType puyoType);
 
@@ -62,7 +62,7 @@ namespace PuyoPuyo
 	void PuyoPiece::ResetRandomly()
 	{
 		// ぷよ何体で構成されているか？ (2～4)
-		m_num = 2 + rand() % 3;
+		m_num = 2 + m_player->Random(3);
 
 		// 3×3マス全てを None で埋めておく
 		//
@@ -87,8 +87,8 @@ namespace PuyoPuyo
 			//	1 □●□
 			//	0 □□□
 			//	   0 1 2
-			m_puyos[2][1].SetType((PuyoType)(rand() % 5));		// ランダムに決定
-			m_puyos[1][1].SetType((PuyoType)(rand() % 5));		// ランダムに決定
+			m_puyos[2][1].SetType((PuyoType)m_player->Random(5));		// ランダムに決定
+			m_puyos[1][1].SetType((PuyoType)m_player->Random(5));		// ランダムに決定
 			break;
 
 		case 3:
@@ -96,9 +96,9 @@ namespace PuyoPuyo
 			//	1 □●●
 			//	0 □□□
 			//	   0 1 2
-			m_puyos[2][1].SetType((PuyoType)(rand() % 5));		// ランダムに決定
+			m_puyos[2][1].SetType((PuyoType)m_player->Random(5));		// ランダムに決定
 			m_puyos[1][1].SetType(m_puyos[2][1].GetType());		// 上と同色
-			m_puyos[1][2].SetType((PuyoType)(rand() % 5));		// ランダムに決定
+			m_puyos[1][2].SetType((PuyoType)m_player->Random(5));		// ランダムに決定
 			break;
 
 		case 4:
@@ -106,9 +106,9 @@ namespace PuyoPuyo
 			//	1 □●●
 			//	0 □□□
 			//	   0 1 2
-			m_puyos[2][1].SetType((PuyoType)(rand() % 5));		// ランダムに決定
+			m_puyos[2][1].SetType((PuyoType)m_player->Random(5));		// ランダムに決定
 			m_puyos[1][1].SetType(m_puyos[2][1].GetType());		// 上と同色
-			m_puyos[2][2].SetType((PuyoType)(rand() % 5));		// ランダムに決定
+			m_puyos[2][2].SetType((PuyoType)m_player->Random(5));		// ランダムに決定
 			m_puyos[1][2].SetType(m_puyos[2][2].GetType());		// 上と同色
 			m_isBig = (m_puyos[2][1].GetType() == m_puyos[2][2].GetType());	// 全て同色なら大ぷよ
 			break;
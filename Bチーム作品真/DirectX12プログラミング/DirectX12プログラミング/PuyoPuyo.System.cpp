@@ -23,6 +23,7 @@ namespace PuyoPuyo
 
 
     System::System()
+        : m_pendingSE(0)
     {
 
     }
@@ -65,16 +66,29 @@ namespace PuyoPuyo
         // ぷよぷよ「メイン画面」の作成
         MainScene* mainScene = new MainScene();
 
-        // ぷよぷよ「メイン画面」をアクティブなシーンとして設定する
-        SceneManager::SetActiveScene(mainScene);
-
-        // ぷよぷよ「メイン画面」のアセットをロードする
-        mainScene->LoadAssets();
+        // ぷよぷよ「メイン画面」をアクティブなシーンとして設定し、アセットをロードする
+        SceneManager::LoadScene(mainScene);
     }
 
     void System::PlaySharedSE(SoundEffectID id)
     {
-        PlayAudio(m_sharedSE[(size_t)id]);
+        // MCIはスレッドセーフではないので、ここでは再生予約だけを行う。
+        // (同じフレームで同じ効果音が複数回予約された場合は1回だけ再生される)
+        m_pendingSE |= 1u << (uint32_t)id;
+    }
+
+    void System::FlushSharedSE()
+    {
+        // 予約を取り出すと同時に空にする
+        const uint32_t pendingSE = m_pendingSE.exchange(0);
+
+        for (size_t i = 0; i < (size_t)SoundEffectID::MaxNumSoundEffects; i++)
+        {
+            if (pendingSE & (1u << i))
+            {
+                PlayAudio(m_sharedSE[i]);
+            }
+        }
     }
 
     void System::PlaySharedBGM(BackgroundMusicID id)
@@ -2,6 +2,7 @@
 #include "PuyoPuyo.PuyoType.h"
 #include "Audio.h"
 #include <vector>
+#include <atomic>
 
 namespace PuyoPuyo
 {
@@ -55,6 +56,7 @@ namespace PuyoPuyo
 		Sprite* m_puyoSprites[5];			// ぷよスプライト配列
 		WORD m_sharedSE[(size_t)SoundEffectID::MaxNumSoundEffects];				// 共有する効果音
 		WORD m_sharedBGM[(size_t)BackgroundMusicID::MaxNumBackgroundMusics];	// 共有する背景音
+		std::atomic<uint32_t> m_pendingSE;										// 再生待ちの効果音 (効果音IDのビットの集合)
 
 	private:
 		// コンストラクタ
@@ -83,8 +85,13 @@ namespace PuyoPuyo
 		void Run();
 
 		// 共有効果音を再生します。
+		//		・ワーカースレッドからも呼び出せるように、ここでは再生予約だけを行います。
+		//		・実際の再生は FlushSharedSE() でメインスレッドからまとめて行います。
 		void PlaySharedSE(SoundEffectID id);
 
+		// 再生予約されている共有効果音を全て再生します。 (メインスレッド専用)
+		void FlushSharedSE();
+
 		// 共有背景音を再生します。
 		void PlaySharedBGM(BackgroundMusicID id);
 
@@ -7,14 +7,22 @@ ReferenceCounter::ReferenceCounter()
 }
 
 
+ReferenceCounter::ReferenceCounter(const ReferenceCounter&)
+    : m_referenceCount(1)
+{
+}
+
+
 ULONG __stdcall ReferenceCounter::Release()
 {
-    if (--m_referenceCount == 0L)
+    // 減らした後の値を使うこと (メンバを読み直すと、他のスレッドの増減が混ざる)
+    const ULONG referenceCount = --m_referenceCount;
+    if (referenceCount == 0L)
     {
         delete this;
         return 0;
     }
 
-    return m_referenceCount;
+    return referenceCount;
 }
 
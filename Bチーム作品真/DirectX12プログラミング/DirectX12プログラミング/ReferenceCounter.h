@@ -1,27 +1,36 @@
 ﻿#pragma once
 #include <wrl.h>
+#include <atomic>
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // 参照カウントクラス
 // 
 //      ・比較的に長い寿命を持つオブジェクトの基底クラス。
 //      ・そのオブジェクトの参照数を記録して破棄のタイミング(寿命)を管理する。
+//      ・参照カウントはアトミックに増減するので、別々のスレッドから AddRef() と Release() を呼び出せる。
+//        (アセットキャッシュのテクスチャは、ロード中のスレッドとメインスレッドの両方から参照される)
 //---------------------------------------------------------------------------------------------------------------------------------------------
 class ReferenceCounter : public IUnknown
 {
 private:
     // 参照カウント
-    ULONG m_referenceCount;
+    std::atomic<ULONG> m_referenceCount;
 
 public:
     // コンストラクタ
     ReferenceCounter();
 
+    // コピーコンストラクタ (参照カウントはコピーせず、新しいオブジェクトとして 1 から始めます)
+    ReferenceCounter(const ReferenceCounter&);
+
+    // コピー代入演算子 (参照カウントはコピーしません)
+    ReferenceCounter& operator=(const ReferenceCounter&) { return *this; }
+
     // 仮想デストラクタ
     virtual ~ReferenceCounter() = default;
 
     // オブジェクトの参照カウントを取得します。
-    ULONG GetReferenceCount() const { return m_referenceCount; }
+    ULONG GetReferenceCount() const { return m_referenceCount.load(); }
 
 
     //----------------------------------------------------------------------------------------------------------
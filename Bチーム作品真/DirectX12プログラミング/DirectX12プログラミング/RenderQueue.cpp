@@ -0,0 +1,105 @@
+﻿#include "RenderQueue.h"
+#include <cstring>
+
+
+// 値を指定した範囲に収める
+static int Clamp(int value, int min, int max)
+{
+    return (value < min) ? min : ((value > max) ? max : value);
+}
+
+
+uint64_t RenderQueue::MakeSortKey(const SortKeyDesc& desc)
+{
+    // 符号付きの値は下限が 0 になるようにずらす
+    const uint64_t camera = desc.cameraIndex & 0xF;
+    const uint64_t layer = (uint64_t)(Clamp(desc.sortingLayer, -128, 127) + 128);
+    const uint64_t order = (uint64_t)(Clamp(desc.sortingOrder, -32768, 32767) + 32768);
+    const uint64_t pipeline = desc.pipelineIndex & 0x7;
+    const uint64_t texture = desc.textureIndex & 0xFFF;
+
+    // 深度を20ビットに量子化する
+    const float depth = (desc.depth < 0.0f) ? 0.0f : ((desc.depth > 1.0f) ? 1.0f : desc.depth);
+    const uint64_t quantizedDepth = (uint64_t)(depth * (float)0xFFFFF);
+
+    uint64_t key = (camera << 60) | (layer << 52) | (order << 36);
+    if (desc.isTransparent)
+    {
+        // 奥から手前へ並ぶように、深度を反転する
+        // (ステートで並べ替えると、同じ深度で重なっているものの前後が入れ替わってしまうので、深度の次は積んだ順番にする)
+        const uint64_t sequence = (desc.sequence < 0x7FFF) ? desc.sequence : 0x7FFF;
+        key |= (uint64_t)1 << 35;
+        key |= (0xFFFFF - quantizedDepth) << 15;
+        key |= sequence;
+    }
+    else
+    {
+        key |= (pipeline << 32) | (texture << 20) | quantizedDepth;
+    }
+    return key;
+}
+
+
+void RenderQueue::Sort()
+{
+    const uint32_t count = GetCount();
+    if (count < 2)
+    {
+        return;
+    }
+
+    // 全ての桁のヒストグラムを1回の走査でまとめて作る
+    uint32_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+    for (const Packet& packet : m_packets)
+    {
+        const uint64_t key = packet.sortKey;
+        for (int digit = 0; digit < 8; digit++)
+        {
+            histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+        }
+    }
+
+    m_scratch.resize(count);
+    Packet* src = m_packets.data();
+    Packet* dst = m_scratch.data();
+
+    // 下位の桁から順番に、安定な計数ソートを繰り返す
+    for (int digit = 0; digit < 8; digit++)
+    {
+        uint32_t* histogram = histograms[digit];
+
+        // 全てのキーでこの桁が同じ値なら並びは変わらないので省略する
+        // (カメラ番号やソーティングレイヤーなど、殆ど使われない桁は大抵ここで省略される)
+        const uint32_t firstDigit = (uint32_t)(src[0].sortKey >> (digit * 8)) & 0xFF;
+        if (histogram[firstDigit] == count)
+        {
+            continue;
+        }
+
+        // ヒストグラムを書き込み開始位置に変換する
+        uint32_t offset = 0;
+        for (int i = 0; i < 256; i++)
+        {
+            const uint32_t n = histogram[i];
+            histogram[i] = offset;
+            offset += n;
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint32_t value = (uint32_t)(src[i].sortKey >> (digit * 8)) & 0xFF;
+            dst[histogram[value]++] = src[i];
+        }
+
+        Packet* temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    // 並べ替え結果が作業用配列の方に入っている場合は入れ替える
+    if (src != m_packets.data())
+    {
+        m_packets.swap(m_scratch);
+    }
+}
@@ -0,0 +1,81 @@
+﻿#pragma once
+#include <vector>
+#include <cstdint>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// レンダーキュークラス
+//
+//      ・レンダラーが描画を依頼する時に積む「描画パケット」を並べ替えるクラス。
+//      ・描画パケットは「64ビットのソートキー」と「依頼元が自由に使える32ビットの値」の組で、キューはその中身を知らない。
+//      ・ソートキーの上位ビットほど優先される。
+//          63-60 : カメラ番号                  (4ビット)
+//          59-52 : ソーティングレイヤー        (8ビット)
+//          51-36 : レイヤー内の順序            (16ビット)
+//          35    : 半透明なら 1                (1ビット。同じ順序の中では不透明が先に描画される)
+//          34- 0 : 不透明 = パイプライン(3) テクスチャ(12) 深度(20)  …ステートの切り替えを減らし、その中では手前から奥へ
+//                  半透明 = 深度(20) 積んだ順番(15)                …奥から手前へ (深度は反転して格納する)
+//      ・半透明は重なり順が描画結果に表れるので、ステートでは並べ替えない。
+//        深度が等しければ積んだ順番(スプライトなら階層順)のまま描画される。 (全てが z = 0 の2Dゲームではこれが重なり順になる)
+//      ・LSD基数ソート(8ビット×最大8パス)で並べ替える。全てのキーで同じ値になる桁のパスは省略する。
+//      ・基数ソートは安定なので、キーが等しいパケットは積んだ順番のまま並ぶ。
+//        (積んだ順番が15ビットに収まらない場合は最大値に飽和させるが、その後も安定ソートで順番が保たれる)
+//      ・パケットの配列はフレームを跨いで使い回すので、容量が足りている限りメモリの確保は行わない。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class RenderQueue
+{
+public:
+    // 描画パケット
+    struct Packet
+    {
+        uint64_t sortKey;       // ソートキー
+        uint32_t payload;       // 依頼元が自由に使える値 (描画する物の添え字など)
+        uint32_t reserved;      // 未使用 (8バイト境界に揃える為)
+    };
+
+    // ソートキーの作成に使う値
+    struct SortKeyDesc
+    {
+        uint32_t cameraIndex;   // カメラ番号 (0 ～ 15)
+        int sortingLayer;       // ソーティングレイヤー (-128 ～ 127)
+        int sortingOrder;       // レイヤー内の順序 (-32768 ～ 32767)
+        bool isTransparent;     // 半透明の場合は true
+        float depth;            // 正規化された深度 (0.0f がカメラの前方クリッピング平面、1.0f が後方クリッピング平面)
+        uint32_t pipelineIndex; // パイプラインステートの番号 (下位3ビットのみ使用。不透明のみ)
+        uint32_t textureIndex;  // テクスチャの番号 (下位12ビットのみ使用。不透明のみ)
+        uint32_t sequence;      // 積んだ順番 (半透明のみ。 0x7FFF より大きい値は 0x7FFF に飽和させます)
+    };
+
+private:
+    std::vector<Packet> m_packets;      // 積まれた描画パケットの配列 (Sort() の後は並べ替え済み)
+    std::vector<Packet> m_scratch;      // 基数ソートの作業用配列
+
+public:
+    // ソートキーを作成します。 (範囲外の値は範囲内に収めます)
+    static uint64_t MakeSortKey(const SortKeyDesc& desc);
+
+    // ソートキーが半透明を表している場合は true を返します。
+    static bool IsTransparent(uint64_t sortKey) { return (sortKey >> 35) & 1; }
+
+    // 描画パケットを積みます。
+    void Submit(uint64_t sortKey, uint32_t payload)
+    {
+        Packet packet;
+        packet.sortKey = sortKey;
+        packet.payload = payload;
+        packet.reserved = 0;
+        m_packets.push_back(packet);
+    }
+
+    // 積まれた描画パケットをソートキーの昇順に並べ替えます。
+    void Sort();
+
+    // 積まれた描画パケットを全て取り除きます。 (配列の容量は残します)
+    void Clear() { m_packets.clear(); }
+
+    // 描画パケットの配列を取得します。
+    const std::vector<Packet>& GetPackets() const { return m_packets; }
+
+    // 描画パケットの数を取得します。
+    uint32_t GetCount() const { return (uint32_t)m_packets.size(); }
+};
@@ -60,6 +60,21 @@ const RenderTargetBlend RenderTargetBlend::NonPremultiplied
 	ColorWriteEnable::All
 );
 
+// 乗算済みアルファ
+const RenderTargetBlend RenderTargetBlend::PremultipliedAlpha
+(
+	true,
+	false,
+	BlendFactor::One,
+	BlendFactor::InverseSourceAlpha,
+	BlendOperation::Add,
+	BlendFactor::One,
+	BlendFactor::InverseSourceAlpha,
+	BlendOperation::Add,
+	LogicOperation::Noop,
+	ColorWriteEnable::All
+);
+
 
 RenderTargetBlend::RenderTargetBlend()
 	: RenderTargetBlend(Opaque)
@@ -88,6 +88,7 @@ public:
     static const RenderTargetBlend AlphaBlend;
     static const RenderTargetBlend Additive;
     static const RenderTargetBlend NonPremultiplied;
+    static const RenderTargetBlend PremultipliedAlpha;
 
 public:
     bool                    BlendEnable;
@@ -1,13 +1,61 @@
 ﻿#include "Renderer.h"
+#include "GameObject.h"
+#include "Transform.h"
+#include "Scene.h"
+#include "SpatialGrid.h"
+#include "Material.h"
+#include <cmath>
+#include <cassert>
+
+using namespace DirectX;
 
 
 Renderer::Renderer()
     : m_isEnabled(true)
-    , m_isVisible(true)
+    , m_isBoundsDirty(false)
     , m_sortingLayerID(0)
     , m_sortingOrder(0)
+    , m_renderOrder(0)
+    , m_visibleFrameCount(0)
+{
+    m_gridEntry.renderer = this;
+    m_gridEntry.hasBounds = false;
+    m_gridEntry.cellIndex = SpatialGrid::InvalidCellIndex;
+    m_gridEntry.slot = 0;
+}
+
+
+Renderer::Renderer(const Renderer& original)
+    : Component(original)
+    , m_isEnabled(original.m_isEnabled)
+    , m_isBoundsDirty(false)
+    , m_sortingLayerID(original.m_sortingLayerID)
+    , m_sortingOrder(original.m_sortingOrder)
+    , m_renderOrder(0)
+    , m_visibleFrameCount(0)
 {
+    m_gridEntry.renderer = this;
+    m_gridEntry.hasBounds = false;
+    m_gridEntry.cellIndex = SpatialGrid::InvalidCellIndex;
+    m_gridEntry.slot = 0;
+
+    // マテリアルはレンダラー毎に保持する
+    for (const Material* material : original.m_materials)
+    {
+        m_materials.push_back(new Material(*material));
+    }
 
+    // 空間グリッドへの登録は OnAttach() で行われる
+}
+
+
+Renderer::~Renderer()
+{
+    for (Material* material : m_materials)
+    {
+        delete material;
+    }
+    m_materials.clear();
 }
 
 
@@ -18,5 +66,93 @@ const TypeInfo& Renderer::GetTypeInfo()
 }
 
 
+void Renderer::OnAttach()
+{
+    // 次回の描画前にバウンディングボックスを計算して、空間グリッドに登録してもらう
+    SetBoundsDirty();
+}
+
+
+void Renderer::OnDetach()
+{
+    // 所属するシーンの空間グリッドから削除する
+    GetGameObject()->GetScene()->m_rendererGrid->Remove(&m_gridEntry);
+}
+
+
+void Renderer::SetMaterial(const Material* material)
+{
+    assert(material);
+
+    // 最初のマテリアルを複製に置き換える
+    if (m_materials.empty())
+    {
+        m_materials.push_back(new Material(*material));
+    }
+    else
+    {
+        delete m_materials[0];
+        m_materials[0] = new Material(*material);
+    }
+}
+
+
+void Renderer::SetMaterials(const std::vector<Material*>& materials)
+{
+    for (Material* material : m_materials)
+    {
+        delete material;
+    }
+    m_materials.clear();
+
+    for (const Material* material : materials)
+    {
+        m_materials.push_back(new Material(*material));
+    }
+}
 
 
+bool Renderer::IsVisible() const
+{
+    return m_visibleFrameCount == GetGameObject()->GetScene()->GetRenderFrameCount();
+}
+
+
+bool Renderer::GetLocalBounds(Bounds& localBounds) const
+{
+    // バウンディングボックスを持たないので、常に描画する
+    return false;
+}
+
+
+void Renderer::SetBoundsDirty()
+{
+    GetGameObject()->GetScene()->SetRendererBoundsDirty(this);
+}
+
+
+void Renderer::UpdateBounds()
+{
+    m_isBoundsDirty = false;
+
+    Bounds localBounds;
+    m_gridEntry.hasBounds = GetLocalBounds(localBounds);
+    if (!m_gridEntry.hasBounds)
+    {
+        return;
+    }
+
+    // ボックスの中心を変換し、各軸方向の大きさは「行列の各要素の絶対値」で変換する。
+    // (回転したボックスを包む、各軸に平行なボックスになる)
+    const XMFLOAT4X4 m = GetGameObject()->GetTransform()->GetLocalToWorldMatrix();
+    const Vector3& c = localBounds.center;
+    const Vector3& e = localBounds.extents;
+    m_gridEntry.bounds.center = Vector3(
+        c.x * m._11 + c.y * m._21 + c.z * m._31 + m._41,
+        c.x * m._12 + c.y * m._22 + c.z * m._32 + m._42,
+        c.x * m._13 + c.y * m._23 + c.z * m._33 + m._43);
+    m_gridEntry.bounds.extents = Vector3(
+        e.x * fabsf(m._11) + e.y * fabsf(m._21) + e.z * fabsf(m._31),
+        e.x * fabsf(m._12) + e.y * fabsf(m._22) + e.z * fabsf(m._32),
+        e.x * fabsf(m._13) + e.y * fabsf(m._23) + e.z * fabsf(m._33));
+}
@@ -1,5 +1,7 @@
 ﻿#pragma once
 #include "Component.h"
+#include "Bounds.h"
+#include "SpatialGrid.h"
 #include <vector>
 
 enum class ShadowCastingMode
@@ -23,7 +25,6 @@ enum class ReflectionProbeUsage
 
 // 前方宣言
 class Material;
-class Bounds;
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // レンダラークラス
@@ -38,17 +39,38 @@ class Renderer : public Component
 private:
     std::vector<Material*>	m_materials;		// レンダリング時に参照されるマテリアルの配列
 	bool					m_isEnabled;		// レンダリングが有効な場合は true
-	bool					m_isVisible;		// カメラにレンダラーが表示されている場合は true
+	bool					m_isBoundsDirty;	// バウンディングボックスの再計算待ちの場合は true
     int						m_sortingLayerID;	// ソート時に使用されるレイヤーのID
     int						m_sortingOrder;		// ソート時に使用される順序を表す値
+	uint32_t				m_renderOrder;		// 階層順(深さ優先)の通し番号 (カリング後の描画順に使う)
+	uint32_t				m_visibleFrameCount;// 最後にカメラの視錐台の中にあった時の、シーンの描画回数
+	SpatialGridEntry		m_gridEntry;		// 空間グリッドの項目 (ワールド空間でのバウンディングボックスと、空間グリッド内での登録位置)
     friend class GameObject;					// ゲームオブジェクトクラスは友達
+	friend class Scene;							// シーンクラスは友達
+	friend class Camera;						// カメラクラスは友達
 
 protected:
     // コンストラクタ
 	Renderer();
 
-    // 仮想デストラクタ
-    virtual ~Renderer() = default;
+	// コピーコンストラクタ (マテリアルは複製し、空間グリッドへの登録はコピーしません)
+	Renderer(const Renderer& original);
+
+    // 仮想デストラクタ (保持しているマテリアルを破棄します)
+    virtual ~Renderer();
+
+	// モデル空間でのバウンディングボックスを取得します。
+	//   ・バウンディングボックスを持たない(常に描画する)場合は false を返します。
+	//   ・カリングの対象にしたいレンダラーは継承先のクラスでオーバーライドしてください。
+	virtual bool GetLocalBounds(Bounds& localBounds) const;
+
+	// モデル空間でのバウンディングボックスが変化したことを所属するシーンに通知します。
+	//   ・次回の描画前にワールド空間のバウンディングボックスが再計算されます。
+	void SetBoundsDirty();
+
+private:
+	// ワールド空間のバウンディングボックスを再計算します。
+	void UpdateBounds();
 
 public:
     // このデータ型の情報を返します。
@@ -57,14 +79,28 @@ public:
     // このインスタンスのデータ型の情報を返します。
     virtual const TypeInfo& GetTypeInfoOfInstance() const { return GetTypeInfo(); }
 
+    // GameObjectのコンポーネントテーブル内での、このデータ型の添え字
+    static constexpr ComponentTypeIndex TypeIndex = ComponentTypeIndex::Renderer;
+
+    // このデータ型と全ての基底クラスを表すビットマスク
+    static constexpr uint32_t TypeMask = Component::TypeMask | ToComponentTypeMask(TypeIndex);
+
+	// Component::OnAttach()をオーバーライドします。
+	void OnAttach() override;
+
+	// Component::OnDetach()をオーバーライドします。
+	void OnDetach() override;
+
 	// レンダラーのバウンディングボリューム(読み取り専用)
-	const Bounds& GetBounds() const;
+	//   ・ワールド空間での値です。所属するシーンの描画前に更新されます。
+	const Bounds& GetBounds() const { return m_gridEntry.bounds; }
 
 	// レンダラーが静的にバッチ処理されている場合はtrueを返します(読み取り専用)
 	bool IsPartOfStaticBatch() const;
 
 	// カメラにレンダラーが表示されている場合は true を返します (読み取り専用)
-	bool IsVisible() const { return m_isVisible; }
+	//   ・直前の描画で、いずれかのカメラの視錐台の中にあった場合に true になります。
+	bool IsVisible() const;
 
 	// レンダリングが有効な場合は true を設定します。
 	void SetEnabled(bool enabled) { m_isEnabled = enabled; }
@@ -126,14 +162,15 @@ public:
 	void SetMaterial(const Material* material);
 
 	// このレンダラーで使用する最初のマテリアルを取得します。
-	const Material* GetMaterial() const { return m_materials[0]; }
+	// (マテリアルが設定されていない場合は nullptr を返します)
+	const Material* GetMaterial() const { return m_materials.empty() ? nullptr : m_materials[0]; }
 
 	// このレンダラーで使用するマテリアルを設定します。
 	// (引数で指定されたマテリアルを全て複製してレンダラーが保持します)
 	void SetMaterials(const std::vector<Material*>& materials);
 
 	// このレンダラーで使用するマテリアルを取得します。
-	const std::vector<Material*>& GetMaterials() const;
+	const std::vector<Material*>& GetMaterials() const { return m_materials; }
 
 	// 共有マテリアルを設定します
 	// (非推奨！この共有マテリアルを変更すると、他のオブジェクトが使用していた場合にその外観も変更されます。
@@ -151,10 +188,11 @@ public:
 
 	// レンダラーの Sorting Layer のユニークIDを取得します
 	// デフォルト値は常に0です
-	int GetSortingLayerID() const;
+	int GetSortingLayerID() const { return m_sortingLayerID; }
 
 	// レンダラーの Sorting Layer のユニークIDを設定します
-	void SetSortingLayerID(int id);
+	// (描画順のソートキーには -128 ～ 127 の範囲で反映されます)
+	void SetSortingLayerID(int id) { m_sortingLayerID = id; }
 
 	// レンダラーの Sorting Layer の名前を取得します
 	void SetSortingLayerName(const std::string& layerName);
@@ -163,10 +201,11 @@ public:
 	const std::string& GetSortingLayerName() const;
 
 	// Sorting Layerによるレンダラーのオーダー順を設定します
-	void SetSortingOrder(int order);
+	// (描画順のソートキーには -32768 ～ 32767 の範囲で反映されます)
+	void SetSortingOrder(int order) { m_sortingOrder = order; }
 
 	// Sorting Layerによるレンダラーのオーダー順を取得します
-	int GetSortingOrder() const;
+	int GetSortingOrder() const { return m_sortingOrder; }
 
 	// このレンダラー用にライトプローブが使用される場合はtrueを指定します
 	void SetUseLightProbes(bool enable);
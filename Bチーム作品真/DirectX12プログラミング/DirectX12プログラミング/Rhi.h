@@ -0,0 +1,294 @@
+﻿#pragma once
+#include <cstdint>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ※注意
+//
+//  RHI (Render Hardware Interface) は、描画処理とグラフィックスAPIの間に挟む薄い層。
+//  このヘッダーは Windows や D3D12 のヘッダーに依存しないこと。 (標準ライブラリのみを使用する)
+//  (D3D12 の実装は D3D12Rhi.h、GPUを使わずに記録だけを行う実装は NullRhi.h にある)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// パイプラインステート、ルートシグネチャ、ディスクリプタヒープ、リソース(バッファとテクスチャ)のハンドル
+// (中身は各実装が決める。 D3D12 の実装では ID3D12PipelineState* などをそのまま使う)
+struct RhiPipelineState;
+struct RhiRootSignature;
+struct RhiDescriptorHeap;
+struct RhiResource;
+
+
+// CPUから見えるディスクリプタ (レンダーターゲットビューや深度ステンシルビュー)
+struct RhiCpuDescriptor
+{
+    uint64_t ptr;
+};
+
+
+// GPUから見えるディスクリプタ (ディスクリプタテーブルの先頭)
+struct RhiGpuDescriptor
+{
+    uint64_t ptr;
+};
+
+
+// 頂点バッファビュー
+struct RhiVertexBufferView
+{
+    uint64_t gpuAddress;                // 頂点バッファのGPU仮想アドレス
+    uint32_t sizeInBytes;               // 頂点バッファのサイズ (単位はバイト)
+    uint32_t strideInBytes;             // 1頂点のサイズ (単位はバイト)
+};
+
+
+// インデックスバッファビュー
+struct RhiIndexBufferView
+{
+    uint64_t gpuAddress;                // インデックスバッファのGPU仮想アドレス
+    uint32_t sizeInBytes;               // インデックスバッファのサイズ (単位はバイト)
+    bool is32Bit;                       // インデックスが32ビットの場合は true (16ビットの場合は false)
+};
+
+
+// ビューポート
+struct RhiViewport
+{
+    float x;
+    float y;
+    float width;
+    float height;
+    float minDepth;
+    float maxDepth;
+};
+
+
+// 矩形 (シザー矩形)
+struct RhiRect
+{
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+};
+
+
+// プリミティブトポロジー
+enum class RhiPrimitiveTopology : uint8_t
+{
+    PointList,
+    LineList,
+    LineStrip,
+    TriangleList,
+    TriangleStrip,
+};
+
+
+// リソースの状態 (リソースバリアで遷移させる)
+enum class RhiResourceState : uint8_t
+{
+    Common,
+    Present,
+    RenderTarget,
+    DepthWrite,
+    CopySource,
+    CopyDestination,
+    VertexAndConstantBuffer,
+    IndexBuffer,
+    PixelShaderResource,
+};
+
+
+// テクスチャのサブリソース1つ分の、バッファ上での配置 (D3D12_PLACED_SUBRESOURCE_FOOTPRINT と同じ意味)
+struct RhiPlacedFootprint
+{
+    uint64_t offset;                    // バッファの先頭からの位置 (単位はバイト。 512バイト境界)
+    uint32_t format;                    // ピクセルフォーマット (DXGI_FORMAT の値)
+    uint32_t width;                     // 幅 (単位はピクセル)
+    uint32_t height;                    // 高さ (単位はピクセル)
+    uint32_t depth;                     // 深さ
+    uint32_t rowPitch;                  // 1行のバイト数 (256バイト境界)
+};
+
+
+// アップロード用のメモリから切り出した領域
+struct RhiUploadAllocation
+{
+    void* cpuAddress;                   // CPUから書き込む為のアドレス
+    uint64_t gpuAddress;                // GPU仮想アドレス
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// RHIコマンドリストクラス
+//
+//      ・描画コマンドを記録するインターフェイス。
+//      ・レンダラーやカメラは ID3D12GraphicsCommandList ではなくこのインターフェイス越しにコマンドを記録する。
+//      ・引数の意味は ID3D12GraphicsCommandList の同名のメソッドに合わせている。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class RhiCommandList
+{
+public:
+    // 仮想デストラクタ
+    virtual ~RhiCommandList() = default;
+
+    // パイプラインステートを設定します。
+    virtual void SetPipelineState(RhiPipelineState* pipelineState) = 0;
+
+    // グラフィックスパイプライン用ルートシグネチャを設定します。
+    virtual void SetGraphicsRootSignature(RhiRootSignature* rootSignature) = 0;
+
+    // シェーダーから見えるディスクリプタヒープを設定します。
+    virtual void SetDescriptorHeap(RhiDescriptorHeap* descriptorHeap) = 0;
+
+    // ルートパラメーターに定数バッファのGPU仮想アドレスを設定します。
+    virtual void SetGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t gpuAddress) = 0;
+
+    // ルートパラメーターにディスクリプタテーブルの先頭を設定します。
+    virtual void SetGraphicsRootDescriptorTable(uint32_t rootParameterIndex, RhiGpuDescriptor baseDescriptor) = 0;
+
+    // プリミティブトポロジーを設定します。
+    virtual void IASetPrimitiveTopology(RhiPrimitiveTopology primitiveTopology) = 0;
+
+    // 頂点バッファを設定します。
+    virtual void IASetVertexBuffer(uint32_t slot, const RhiVertexBufferView& view) = 0;
+
+    // インデックスバッファを設定します。
+    virtual void IASetIndexBuffer(const RhiIndexBufferView& view) = 0;
+
+    // ビューポートを設定します。
+    virtual void RSSetViewport(const RhiViewport& viewport) = 0;
+
+    // シザー矩形を設定します。
+    virtual void RSSetScissorRect(const RhiRect& rect) = 0;
+
+    // レンダーターゲットと深度ステンシルを設定します。
+    virtual void OMSetRenderTarget(RhiCpuDescriptor renderTargetView, RhiCpuDescriptor depthStencilView) = 0;
+
+    // レンダーターゲットを単色で塗りつぶします。
+    virtual void ClearRenderTargetView(RhiCpuDescriptor renderTargetView, const float color[4]) = 0;
+
+    // 深度ステンシルを指定した値で塗りつぶします。
+    virtual void ClearDepthStencilView(RhiCpuDescriptor depthStencilView, float depth, uint8_t stencil) = 0;
+
+    // インデックスバッファを使わずに描画します。
+    virtual void DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) = 0;
+
+    // インデックスバッファを使って描画します。
+    virtual void DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) = 0;
+
+    // リソースの状態を遷移させます。
+    virtual void ResourceBarrier(RhiResource* resource, RhiResourceState stateBefore, RhiResourceState stateAfter) = 0;
+
+    // バッファの一部を別のバッファにコピーします。
+    virtual void CopyBufferRegion(RhiResource* destination, uint64_t destinationOffset, RhiResource* source, uint64_t sourceOffset, uint64_t numBytes) = 0;
+
+    // バッファに配置したピクセルデータを、テクスチャのサブリソースにコピーします。
+    //   ・destinationY はコピー先の上端の行(単位はピクセル)です。 (サブリソースを行のまとまりに分けてコピーする場合に使います)
+    virtual void CopyBufferToTexture(RhiResource* destination, uint32_t destinationSubresource, uint32_t destinationY, RhiResource* source, const RhiPlacedFootprint& footprint) = 0;
+
+    // マップしたままのアップロード用バッファに、CPUから書き込んだバイト数を伝えます。
+    // (コマンドは記録しません。 計測用の実装がアップロード量を数える為に使います)
+    virtual void NotifyUpload(uint64_t numBytes) = 0;
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// RHIコマンドコンテキストクラス
+//
+//      ・1フレーム分の描画に必要なもの(コマンドリスト、アップロード用のメモリ、描画先)をまとめたインターフェイス。
+//      ・D3D12 の実装はフレームリソース(FrameResources)。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class RhiCommandContext
+{
+public:
+    // 仮想デストラクタ
+    virtual ~RhiCommandContext() = default;
+
+    // メインスレッドが現在記録しているコマンドリストを取得します。
+    //   ・並列記録の後は ContinueCommandList() で新しいコマンドリストに切り替わるので、使う度に取得し直してください。
+    virtual RhiCommandList* GetCommandList() = 0;
+
+    // 追加のコマンドリストを1つ取り出し、記録できる状態にして、キューに送る順番の末尾に加えます。
+    //   ・取り出しはメインスレッドで行い、記録は別のスレッドで行ってもかまいません。
+    virtual RhiCommandList* AcquireCommandList() = 0;
+
+    // 追加のコマンドリストを1つ取り出し、メインスレッドのコマンドリストをそれに切り替えます。
+    //   ・デフォルトのグラフィックスステートは設定済みの状態で返します。
+    virtual RhiCommandList* ContinueCommandList() = 0;
+
+    // コマンドリストにデフォルトのグラフィックスステート(パイプラインステート、ルートシグネチャ、ディスクリプタヒープ)を設定します。
+    virtual void ApplyDefaultGraphicsState(RhiCommandList* commandList) const = 0;
+
+    // このフレームで使うアップロード用のメモリから領域を切り出します。 (アラインメントは定数バッファと同じ256バイト)
+    //   ・確保した領域はこのフレームのGPU処理が完了するまで有効です。
+    virtual RhiUploadAllocation AllocateUploadMemory(uint64_t size) = 0;
+
+    // 描画先のレンダーターゲットビューを取得します。
+    virtual RhiCpuDescriptor GetRenderTargetView() const = 0;
+
+    // 描画先の深度ステンシルビューを取得します。
+    virtual RhiCpuDescriptor GetDepthStencilView() const = 0;
+
+    // 描画先の幅(単位はピクセル)を取得します。
+    virtual uint32_t GetRenderTargetWidth() const = 0;
+
+    // 描画先の高さ(単位はピクセル)を取得します。
+    virtual uint32_t GetRenderTargetHeight() const = 0;
+
+    // 記録中のフレームの通し番号を取得します。 (フレーム毎に増える。 フレーム毎の使用量を数え直す目印に使う)
+    virtual uint64_t GetFrameNumber() const = 0;
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// GPUタイムラインクラス
+//
+//      ・コマンドキューとフェンスの組を抽象化したインターフェイス。
+//      ・シグナルする度にフェンス値が1ずつ増える。(「完了済みの値 + 1」ではなく、キュー毎に単調増加する)
+//      ・フェンス値 N の完了を待てば、それ以前にキューに送った全ての処理の完了を待ったことになる。
+//      ・フレームスケジューラーはこのインターフェイス越しにGPUと同期するので、
+//        GPUの無い環境でも、遅延を真似たタイムラインに差し替えてスケジューリングを確かめられる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class GpuTimeline
+{
+public:
+    // 仮想デストラクタ
+    virtual ~GpuTimeline() = default;
+
+    // これまでにキューに送った処理の後ろにシグナルを追加し、そのフェンス値を返します。
+    virtual uint64_t Signal() = 0;
+
+    // GPUが到達したフェンス値を取得します。
+    virtual uint64_t GetCompletedValue() = 0;
+
+    // GPUが指定したフェンス値に到達するまで、CPUを待機させます。
+    virtual void WaitForValue(uint64_t value) = 0;
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// RHIコピーキュークラス
+//
+//      ・コピー専用のコマンドキューを抽象化したインターフェイス。 (描画用のキューとは別に、並行して動く)
+//      ・コマンドリストに記録したコピーを Submit() でまとめてキューに送り、完了はGPUタイムラインのフェンス値で確かめる。
+//      ・コピーキューのコマンドリストでは、コピー以外のコマンドを記録しないこと。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class RhiCopyQueue
+{
+public:
+    // 仮想デストラクタ
+    virtual ~RhiCopyQueue() = default;
+
+    // 記録中のコマンドリストを取得します。 (記録中でなければ、新しく記録を始めます)
+    virtual RhiCommandList* GetCommandList() = 0;
+
+    // 記録したコマンドをキューに送り、その完了を表すフェンス値を返します。
+    virtual uint64_t Submit() = 0;
+
+    // このキューのGPUタイムラインを取得します。
+    virtual GpuTimeline* GetTimeline() = 0;
+};
@@ -58,14 +58,14 @@ public:
 class DescriptorRange : public D3D12_DESCRIPTOR_RANGE1
 {
 public:
-    DescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE rangeType, UINT baseShaderRegister, UINT numDescriptors, UINT registerSpace = 0, UINT offsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND)
+    DescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE rangeType, UINT baseShaderRegister, UINT numDescriptors, UINT registerSpace = 0, UINT offsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND, D3D12_DESCRIPTOR_RANGE_FLAGS flags = D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE)
     {
         this->RangeType = rangeType;
         this->BaseShaderRegister = baseShaderRegister;
         this->NumDescriptors = numDescriptors;
         this->RegisterSpace = registerSpace;
         this->OffsetInDescriptorsFromTableStart = offsetInDescriptorsFromTableStart;
-        this->Flags = D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE;
+        this->Flags = flags;
     }
 };
 
@@ -3,6 +3,7 @@
 #include "RootParameter.h"
 #include "StaticSampler.h"
 #include "GraphicsEngine.h"
+#include "PipelineStateCache.h"
 
 
 RootSignatureBuilder::RootSignatureBuilder()
@@ -99,6 +100,9 @@ void RootSignatureBuilder::End(ID3D12RootSignature** ppD3D12RootSignature)
         assert(0);
     }
     printf("[成功] ルートシグネチャの作成 (アドレス: 0x%p)\n", *ppD3D12RootSignature);
+
+    // パイプラインステートキャッシュのハッシュ値は、アドレスではなくシリアライズされた中身から計算する
+    PipelineStateCache::RegisterRootSignature(*ppD3D12RootSignature, blobWithRootSignature->GetBufferPointer(), blobWithRootSignature->GetBufferSize());
     blobWithRootSignature->Release();
 
     m_isBegun = false;
@@ -2,9 +2,18 @@
 #include "GameObject.h"
 #include "Camera.h"
 #include "GraphicsEngine.h"
-#include "ConstantBuffer.h"
+#include "Rhi.h"
 #include "Mathf.h"
-#include "FrameResources.h"
+#include "TransformSystem.h"
+#include "Transform.h"
+#include "JobSystem.h"
+#include "MemoryPool.h"
+#include "MonoBehaviour.h"
+#include "Renderer.h"
+#include "SpatialGrid.h"
+#include <atomic>
+#include <algorithm>
+#include <cassert>
 
 // フレーム毎に更新される予定の定数たち
 struct Scene::ConstantBufferLayoutForCamera
@@ -13,10 +22,80 @@ struct Scene::ConstantBufferLayoutForCamera
     DirectX::XMFLOAT4X4 projMatrix;
 };
 
+// 静的メンバ変数の実体を宣言
+uint32_t Scene::s_numComponentPoolIndices = 0;
+
+// レンダラーの空間グリッドのセルの大きさ
+// (一般的なスプライトが数個から数十個入る程度の大きさにしておく)
+static constexpr float RendererGridCellSize = 256.0f;
+
+
 Scene::Scene()
-    : m_isUpdating(false)
+    : m_componentCount(0)
+    , m_updatedComponentCount(0)
+    , m_renderFrameCount(0)
+    , m_isUpdateOrderDirty(false)
+    , m_isUpdating(false)
+    , m_isUpdatingInParallel(false)
+    , m_memoryPoolHeir(nullptr)
+    , m_startTime(std::chrono::steady_clock::now())
 {
-    m_constantBufferForCamera = new ConstantBuffer(sizeof(ConstantBufferLayoutForCamera), nullptr, nullptr);
+    m_transformSystem = new TransformSystem();
+    m_gameObjectPool = new MemoryPool(sizeof(GameObject), alignof(GameObject));
+    m_rendererGrid = new SpatialGrid(RendererGridCellSize);
+}
+
+
+Scene::~Scene()
+{
+    // 全てのゲームオブジェクトを集める
+    std::vector<GameObject*> allGameObjects;
+    CollectAllGameObjects(allGameObjects);
+
+    // Transformをどの順番で破棄してもよいように、トランスフォームシステムとの関連を先に切っておく
+    m_transformSystem->Clear();
+
+    // 全てのゲームオブジェクトを破棄する (所有しているコンポーネントも破棄される)
+    // (参照カウントに関係なく破棄するので、シーンの外から参照を持ち続けてはいけない)
+    for (GameObject* gameObject : allGameObjects)
+    {
+        delete gameObject;
+    }
+    m_rootGameObjects.clear();
+    m_allCameras.clear();
+    m_destroyQueue.Clear();
+    m_gameObjectsByName.clear();
+    m_childrenByName.clear();
+    m_dirtyBoundsRenderers.clear();
+    assert(m_componentCount == 0);
+    assert(m_rendererGrid->GetCount() == 0);
+
+    delete m_rendererGrid;
+    m_rendererGrid = nullptr;
+
+    // メモリプールごとまとめて解放する
+    // (別のシーンに移動したゲームオブジェクトやコンポーネントが使っているメモリプールは、移動先のシーンに引き継ぐ)
+    std::vector<MemoryPool*> pools = m_adoptedPools;
+    pools.insert(pools.end(), m_componentPools.begin(), m_componentPools.end());
+    pools.push_back(m_gameObjectPool);
+    for (MemoryPool* pool : pools)
+    {
+        if (pool && (pool->GetNumUsedBlocks() > 0))
+        {
+            assert(m_memoryPoolHeir && (m_memoryPoolHeir != this));
+            m_memoryPoolHeir->m_adoptedPools.push_back(pool);
+        }
+        else
+        {
+            delete pool;
+        }
+    }
+    m_adoptedPools.clear();
+    m_componentPools.clear();
+    m_gameObjectPool = nullptr;
+
+    delete m_transformSystem;
+    m_transformSystem = nullptr;
 }
 
 void Scene::LoadAssets()
@@ -27,21 +106,100 @@ void Scene::LoadAssets()
 void Scene::AddNewGameObject(GameObject* newGameObject)
 {
     AddRootGameObject(newGameObject);
+    AddToNameIndex(newGameObject);
+    SetUpdateOrderDirty();
+}
 
-    if (m_isUpdating)
+void Scene::AddRootGameObject(GameObject* rootGameObject)
+{
+    // 後で O(1) で削除できるように位置を覚えておく
+    rootGameObject->m_rootIterator = m_rootGameObjects.insert(m_rootGameObjects.end(), rootGameObject);
+}
+
+void Scene::RemoveRootGameObject(GameObject* rootGameObject)
+{
+    m_rootGameObjects.erase(rootGameObject->m_rootIterator);
+}
+
+// 子Transformの索引のキーを作る。
+// (親のハンドル格納位置は生存しているオブジェクト間で重複しないので、名前のIDと合わせれば一意になる)
+static uint64_t MakeChildNameKey(const Transform* parent, uint32_t nameID)
+{
+    const uint32_t parentIndex = parent ? parent->GetHandleIndex() : UINT32_MAX;
+    return ((uint64_t)parentIndex << 32) | nameID;
+}
+
+void Scene::AddToNameIndex(GameObject* gameObject)
+{
+    assert(!gameObject->m_isInNameIndex);
+
+    // 後で O(1) で削除できるように位置を覚えておく
+    Transform* transform = gameObject->GetTransform();
+    gameObject->m_nameIterator = m_gameObjectsByName.emplace(gameObject->m_nameID, gameObject);
+    gameObject->m_childNameIterator = m_childrenByName.emplace(MakeChildNameKey(transform->GetParent(), gameObject->m_nameID), transform);
+    gameObject->m_isInNameIndex = true;
+}
+
+void Scene::RemoveFromNameIndex(GameObject* gameObject)
+{
+    if (!gameObject->m_isInNameIndex)
     {
-        m_allTransforms.push_back(newGameObject->GetTransform());
+        return;
     }
+
+    m_gameObjectsByName.erase(gameObject->m_nameIterator);
+    m_childrenByName.erase(gameObject->m_childNameIterator);
+    gameObject->m_isInNameIndex = false;
 }
 
-void Scene::AddRootGameObject(GameObject* rootGameObject)
+void Scene::ReindexParent(GameObject* gameObject)
 {
-    m_rootGameObjects.push_back(rootGameObject);
+    if (!gameObject->m_isInNameIndex)
+    {
+        return;
+    }
+
+    Transform* transform = gameObject->GetTransform();
+    m_childrenByName.erase(gameObject->m_childNameIterator);
+    gameObject->m_childNameIterator = m_childrenByName.emplace(MakeChildNameKey(transform->GetParent(), gameObject->m_nameID), transform);
 }
 
-void Scene::RemoveRootGameObject(GameObject* rootGameObject)
+Transform* Scene::FindChildByName(const Transform* parent, uint32_t nameID) const
 {
-    m_rootGameObjects.remove(rootGameObject);
+    auto range = m_childrenByName.equal_range(MakeChildNameKey(parent, nameID));
+    if (range.first == range.second)
+    {
+        return nullptr;
+    }
+
+    // 同じ名前の兄弟がいなければ、索引で見つかったものを返す (ほとんどの場合はこちら)
+    if (std::next(range.first) == range.second)
+    {
+        return range.first->second;
+    }
+
+    // 同じ名前の兄弟が複数いる場合は、索引内の順番は不定なので、子の順番で最初のものを返す
+    if (parent)
+    {
+        for (Transform* child : parent->GetChildren())
+        {
+            if (child->GetGameObject()->m_nameID == nameID)
+            {
+                return child;
+            }
+        }
+    }
+    else
+    {
+        for (GameObject* rootGameObject : m_rootGameObjects)
+        {
+            if (rootGameObject->m_nameID == nameID)
+            {
+                return rootGameObject->GetTransform();
+            }
+        }
+    }
+    return nullptr;
 }
 
 void Scene::AddCamera(Camera* camera)
@@ -55,6 +213,398 @@ void Scene::RemoveCamera(Camera* camera)
 }
 
 
+void Scene::OnComponentAdded(Component* component)
+{
+    // 並列更新中にワーカースレッドからコンポーネントを追加することはできない
+    assert(!m_isUpdatingInParallel);
+
+    m_componentCount++;
+    SetUpdateOrderDirty();
+
+    // オーバーライドされているコールバック関数の呼び出しリストにだけ登録する
+    if (component->m_callbackFlags)
+    {
+        MonoBehaviour* monoBehaviour = component->AsMonoBehaviour();
+        if (component->m_callbackFlags & MonoBehaviour::OnPreCullCallback)
+        {
+            m_onPreCullBehaviours.push_back(monoBehaviour);
+        }
+        if (component->m_callbackFlags & MonoBehaviour::OnPreRenderCallback)
+        {
+            m_onPreRenderBehaviours.push_back(monoBehaviour);
+        }
+        if (component->m_callbackFlags & MonoBehaviour::OnPostRenderCallback)
+        {
+            m_onPostRenderBehaviours.push_back(monoBehaviour);
+        }
+    }
+
+    // Update()実行中に追加されたコンポーネントは、とりあえず末尾に追加して今回のUpdate()でも更新する。
+    // (正しい階層順には次回のUpdate()で並べ直される)
+    if (m_isUpdating)
+    {
+        m_updateOrder.push_back(component);
+    }
+}
+
+
+void Scene::OnComponentRemoved(Component* component)
+{
+    // Update()実行中に削除されると、更新順リストに削除済みのコンポーネントが残ってしまう
+    assert(!m_isUpdating);
+
+    m_componentCount--;
+    SetUpdateOrderDirty();
+
+    // コールバック関数の呼び出しリストから削除する
+    // (オーバーライドしているスクリプトは少ないので、リストは短い)
+    if (component->m_callbackFlags)
+    {
+        MonoBehaviour* monoBehaviour = component->AsMonoBehaviour();
+        for (std::vector<MonoBehaviour*>* behaviours : { &m_onPreCullBehaviours, &m_onPreRenderBehaviours, &m_onPostRenderBehaviours })
+        {
+            auto it = std::find(behaviours->begin(), behaviours->end(), monoBehaviour);
+            if (it != behaviours->end())
+            {
+                behaviours->erase(it);
+            }
+        }
+    }
+}
+
+
+MemoryPool& Scene::GetComponentPool(uint32_t poolIndex, size_t blockSize, size_t alignment)
+{
+    if (poolIndex >= m_componentPools.size())
+    {
+        m_componentPools.resize(poolIndex + 1, nullptr);
+    }
+
+    // このシーンで初めて使うデータ型の場合はメモリプールを作成する
+    if (!m_componentPools[poolIndex])
+    {
+        m_componentPools[poolIndex] = new MemoryPool(blockSize, alignment);
+    }
+
+    return *m_componentPools[poolIndex];
+}
+
+
+void Scene::CollectAllGameObjects(std::vector<GameObject*>& allGameObjects)
+{
+    for (GameObject* rootGameObject : m_rootGameObjects)
+    {
+        m_traverseStack.push_back(rootGameObject->GetTransform());
+        while (!m_traverseStack.empty())
+        {
+            Transform* transform = m_traverseStack.back();
+            m_traverseStack.pop_back();
+            allGameObjects.push_back(transform->GetGameObject());
+
+            for (Transform* child : transform->GetChildren())
+            {
+                m_traverseStack.push_back(child);
+            }
+        }
+    }
+}
+
+
+void Scene::PrintMemoryPoolStatistics() const
+{
+    printf("ゲームオブジェクト     : %u個 (確保 %u回, スラブ %u個, ブロック %zuバイト)\n",
+        m_gameObjectPool->GetNumUsedBlocks(),
+        m_gameObjectPool->GetNumAllocations(),
+        m_gameObjectPool->GetNumSlabs(),
+        m_gameObjectPool->GetBlockSize());
+
+    uint32_t numComponents = 0;
+    uint32_t numSlabs = 0;
+    for (const MemoryPool* componentPool : m_componentPools)
+    {
+        if (componentPool)
+        {
+            numComponents += componentPool->GetNumUsedBlocks();
+            numSlabs += componentPool->GetNumSlabs();
+            printf("  コンポーネント       : %u個 (確保 %u回, スラブ %u個, ブロック %zuバイト)\n",
+                componentPool->GetNumUsedBlocks(),
+                componentPool->GetNumAllocations(),
+                componentPool->GetNumSlabs(),
+                componentPool->GetBlockSize());
+        }
+    }
+
+    printf("コンポーネント合計     : %u個 (スラブ %u個)\n", numComponents, numSlabs);
+}
+
+
+void Scene::RebuildUpdateOrder()
+{
+    // clear()は確保済みのメモリを解放しないので、階層構造が変化しない限りメモリ確保は発生しない。
+    m_updateOrder.clear();
+    m_parallelUpdateOrder.clear();
+    uint32_t renderOrder = 0;
+
+    // ルートゲームオブジェクトから順番に深さ優先で走査する。
+    // (再帰呼び出しの代わりにスタックを使う)
+    for (GameObject* rootGameObject : m_rootGameObjects)
+    {
+        m_traverseStack.push_back(rootGameObject->GetTransform());
+        while (!m_traverseStack.empty())
+        {
+            Transform* transform = m_traverseStack.back();
+            m_traverseStack.pop_back();
+
+            for (Component* component : transform->GetGameObject()->m_components)
+            {
+                // レンダラーはカリング後にこの順番で描画する
+                if (component->m_typeMask & ToComponentTypeMask(Renderer::TypeIndex))
+                {
+                    static_cast<Renderer*>(component)->m_renderOrder = renderOrder++;
+                }
+
+                if (component->m_allowsParallelUpdate)
+                {
+                    m_parallelUpdateOrder.push_back(component);
+                }
+                else
+                {
+                    m_updateOrder.push_back(component);
+                }
+            }
+
+            // 子リストの順番通りに取り出せるように、逆順に積む
+            const std::list<Transform*>& children = transform->GetChildren();
+            for (auto it = children.rbegin(); it != children.rend(); ++it)
+            {
+                m_traverseStack.push_back(*it);
+            }
+        }
+    }
+    assert(m_updateOrder.size() + m_parallelUpdateOrder.size() == m_componentCount);
+
+    m_isUpdateOrderDirty = false;
+}
+
+
+double Scene::GetTime() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+
+void Scene::ScheduleDestroy(Object* object, float time)
+{
+    assert(object);
+
+    // 並列更新中にワーカースレッドから予約することはできない
+    assert(!m_isUpdatingInParallel);
+
+    m_destroyQueue.Schedule(Handle<Object>(object), GetTime() + (time > 0.0f ? time : 0.0f));
+}
+
+
+void Scene::ProcessDestroyQueue()
+{
+    // 今回のフレームで破棄する時刻を過ぎたものを、早い順に取り出して破棄する
+    // (親ごと破棄された場合や、重複して予約された場合は既に破棄されているので、取り出しても何もしない)
+    m_destroyQueue.Process(GetTime(), [](Object& object) { Object::DestroyImmediate(object, true); });
+}
+
+
+void Scene::DestroyGameObjectImmediate(GameObject* gameObject)
+{
+    // Update()実行中に破棄すると、更新順リストに破棄済みのコンポーネントが残ってしまう
+    // (Update()の中では Object::Destroy() を使うこと)
+    assert(!m_isUpdating);
+    assert(gameObject->m_scene == this);
+
+    // 親の子リスト、またはルートゲームオブジェクトリストから切り離す (どちらも O(1))
+    Transform* transform = gameObject->GetTransform();
+    if (Transform* parent = transform->m_parent)
+    {
+        parent->m_children.erase(transform->m_siblingIterator);
+        transform->m_parent = nullptr;
+    }
+    else
+    {
+        RemoveRootGameObject(gameObject);
+    }
+
+    // 子孫を全て集める (深さ優先なので、親は必ず子よりも前に並ぶ)
+    m_destroyingGameObjects.clear();
+    m_traverseStack.push_back(transform);
+    while (!m_traverseStack.empty())
+    {
+        Transform* current = m_traverseStack.back();
+        m_traverseStack.pop_back();
+        m_destroyingGameObjects.push_back(current->GetGameObject());
+
+        for (Transform* child : current->GetChildren())
+        {
+            m_traverseStack.push_back(child);
+        }
+    }
+
+    // 子から順番に破棄する。
+    // (破棄する時には子が残っていないので、トランスフォームシステムの親子関係が壊れない)
+    for (auto it = m_destroyingGameObjects.rbegin(); it != m_destroyingGameObjects.rend(); ++it)
+    {
+        GameObject* destroying = *it;
+        Transform* destroyingTransform = destroying->GetTransform();
+        if (Transform* parent = destroyingTransform->m_parent)
+        {
+            parent->m_children.erase(destroyingTransform->m_siblingIterator);
+            destroyingTransform->m_parent = nullptr;
+        }
+        RemoveFromNameIndex(destroying);
+        delete destroying;
+    }
+    m_destroyingGameObjects.clear();
+
+    SetUpdateOrderDirty();
+}
+
+
+void Scene::MoveRootGameObject(GameObject* rootGameObject, Scene* destination)
+{
+    // Update()実行中に移動すると、更新順リストに移動済みのコンポーネントが残ってしまう
+    assert(!m_isUpdating && !destination->m_isUpdating);
+    assert((rootGameObject->m_scene == this) && (destination != this));
+    assert(!rootGameObject->GetTransform()->GetParent());
+
+    RemoveRootGameObject(rootGameObject);
+
+    // 子孫を全て集める (深さ優先なので、親は必ず子よりも前に並ぶ)
+    std::vector<GameObject*> movingGameObjects;
+    m_traverseStack.push_back(rootGameObject->GetTransform());
+    while (!m_traverseStack.empty())
+    {
+        Transform* current = m_traverseStack.back();
+        m_traverseStack.pop_back();
+        movingGameObjects.push_back(current->GetGameObject());
+
+        for (Transform* child : current->GetChildren())
+        {
+            m_traverseStack.push_back(child);
+        }
+    }
+
+    // このシーンの索引、カメラリスト、空間グリッドから外す
+    for (GameObject* gameObject : movingGameObjects)
+    {
+        RemoveFromNameIndex(gameObject);
+        for (Component* component : gameObject->m_components)
+        {
+            OnComponentRemoved(component);
+            if (component != gameObject->m_transform)
+            {
+                component->OnDetach();
+            }
+        }
+    }
+
+    // 親から順番に移動先のシーンに登録する
+    // (Transformのデータは OnAttach() で作り直さずに、ローカルの姿勢と親子関係を保ったまま移す)
+    const uint32_t rendererMask = ToComponentTypeMask(Renderer::TypeIndex);
+    for (GameObject* gameObject : movingGameObjects)
+    {
+        gameObject->m_scene = destination;
+        gameObject->m_transform->MoveToSystem(destination->m_transformSystem);
+        for (Component* component : gameObject->m_components)
+        {
+            if (component != gameObject->m_transform)
+            {
+                // このシーンで再計算待ちだったレンダラーも、移動先のシーンで改めて再計算待ちにする
+                if (component->m_typeMask & rendererMask)
+                {
+                    static_cast<Renderer*>(component)->m_isBoundsDirty = false;
+                }
+                component->OnAttach();
+            }
+            destination->OnComponentAdded(component);
+        }
+        destination->AddToNameIndex(gameObject);
+    }
+    destination->AddRootGameObject(rootGameObject);
+    destination->SetUpdateOrderDirty();
+
+    // 移動したゲームオブジェクトとコンポーネントの破棄の予約を、残り時間を保ったまま引き継ぐ
+    std::vector<const Object*> movedObjects;
+    for (GameObject* gameObject : movingGameObjects)
+    {
+        movedObjects.push_back(gameObject);
+        movedObjects.insert(movedObjects.end(), gameObject->m_components.begin(), gameObject->m_components.end());
+    }
+    const double now = GetTime();
+    m_destroyQueue.RemoveIf([&](Object& object, double destroyTime)
+    {
+        if (std::find(movedObjects.begin(), movedObjects.end(), &object) == movedObjects.end())
+        {
+            return false;
+        }
+        destination->ScheduleDestroy(&object, (float)std::max(0.0, destroyTime - now));
+        return true;
+    });
+
+    // このシーンの破棄時に、使用中のメモリプールを移動先に引き継ぐ
+    m_memoryPoolHeir = destination;
+}
+
+
+void Scene::SetRendererBoundsDirty(Renderer* renderer)
+{
+    std::lock_guard<std::mutex> lock(m_dirtyBoundsMutex);
+
+    // 既に再計算待ちの場合は何もしない
+    if (renderer->m_isBoundsDirty)
+    {
+        return;
+    }
+
+    renderer->m_isBoundsDirty = true;
+    m_dirtyBoundsRenderers.push_back(Handle<Renderer>(renderer));
+}
+
+
+void Scene::UpdateRendererBounds()
+{
+    // 古くなったワールド変換行列をまとめて再計算する
+    m_transformSystem->UpdateWorldMatrices();
+
+    // 行列が変化したゲームオブジェクトに付いているレンダラーは、バウンディングボックスの再計算が必要
+    // (動いていないレンダラーには触れないので、静止しているスプライトが多いほど速い)
+    const uint32_t rendererMask = ToComponentTypeMask(Renderer::TypeIndex);
+    for (Transform* transform : m_transformSystem->GetChangedTransforms())
+    {
+        GameObject* gameObject = transform->GetGameObject();
+        if (!(gameObject->m_componentMask & rendererMask))
+        {
+            continue;
+        }
+
+        for (Component* component : gameObject->m_components)
+        {
+            if (component->m_typeMask & rendererMask)
+            {
+                SetRendererBoundsDirty(static_cast<Renderer*>(component));
+            }
+        }
+    }
+
+    for (const Handle<Renderer>& handle : m_dirtyBoundsRenderers)
+    {
+        // 再計算待ちの間に破棄されたレンダラーは無視する
+        if (Renderer* renderer = handle.Get())
+        {
+            renderer->UpdateBounds();
+            m_rendererGrid->Update(&renderer->m_gridEntry);
+        }
+    }
+    m_dirtyBoundsRenderers.clear();
+}
+
+
 void Scene::Traverse(const std::function<void(Transform*)>& visitor)
 {
     for (GameObject* rootGameObject : m_rootGameObjects)
@@ -66,27 +616,74 @@ void Scene::Traverse(const std::function<void(Transform*)>& visitor)
 
 void Scene::Update()
 {
-    m_allTransforms.clear();
-
-    static const std::function<void(Transform*)> visitor = [this](Transform* transform) { m_allTransforms.push_back(transform); };
-    Traverse(visitor);
+    // 階層構造が変化した場合のみ更新順リストを作り直す
+    if (m_isUpdateOrderDirty)
+    {
+        RebuildUpdateOrder();
+    }
 
     m_isUpdating = true;
-    for (size_t i = 0; i < m_allTransforms.size(); i++)
+    m_updatedComponentCount = 0;
+
+    // 並列に更新できるコンポーネントを、先にワーカースレッドで更新する。
+    // (1スレッドあたり4バッチ程度に分割して、処理の重さの偏りをワークスティーリングで均す)
+    if (!m_parallelUpdateOrder.empty())
+    {
+        JobSystem& jobSystem = JobSystem::Instance();
+        const uint32_t count = (uint32_t)m_parallelUpdateOrder.size();
+        const uint32_t batchSize = std::max(1u, count / (jobSystem.GetNumThreads() * 4));
+        std::atomic<uint32_t> updatedCount(0);
+
+        m_isUpdatingInParallel = true;
+        jobSystem.ParallelFor(count, batchSize, [this, &updatedCount](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                m_parallelUpdateOrder[i]->Update();
+            }
+            updatedCount += end - begin;
+        });
+        m_isUpdatingInParallel = false;
+
+        m_updatedComponentCount += updatedCount;
+    }
+
+    // 残りのコンポーネントをメインスレッドで階層順に1回ずつ更新する。
+    // (Update()中にコンポーネントが追加されると末尾に追加されるので、イテレーターではなく添え字で回す)
+    for (size_t i = 0; i < m_updateOrder.size(); i++)
     {
-        m_allTransforms[i]->GetGameObject()->Update();
+        m_updateOrder[i]->Update();
+        m_updatedComponentCount++;
     }
     m_isUpdating = false;
+
+    // 全てのコンポーネントがちょうど1回ずつ更新されたはず
+    assert(m_updatedComponentCount == m_componentCount);
+
+    // フレームの終わりに、破棄を予約されたオブジェクトをまとめて破棄する
+    ProcessDestroyQueue();
+
+    // 古くなったワールド変換行列は、Render()の最初にバウンディングボックスと一緒にまとめて再計算する。
+    // (Update()の後で動かされたゲームオブジェクトも、正しい位置でカリングできるようにする為)
 }
 
 
 void Scene::Render()
 {
-    // フレームリソースセットの取得
-    FrameResources* currentFrameResources = GraphicsEngine::Instance().GetCurrentFrameResources();
+    // コマンドコンテキストの取得 (通常は現在のフレームリソース)
+    RhiCommandContext* commandContext = GraphicsEngine::Instance().GetCurrentCommandContext();
+
+    // 描画回数を数える (レンダラーが今回の描画でカメラに映ったかどうかの判定に使う)
+    m_renderFrameCount++;
+
+    // 階層構造が変化していれば、描画順(階層順)を決め直す
+    if (m_isUpdateOrderDirty)
+    {
+        RebuildUpdateOrder();
+    }
 
-    // コマンドリストの取得
-    ID3D12GraphicsCommandList* commandList = currentFrameResources->GetCommandList();
+    // カリングの前に、全てのレンダラーのバウンディングボックスを最新にしておく
+    UpdateRendererBounds();
 
     for (Camera* camera : m_allCameras)
     {
@@ -95,16 +692,21 @@ void Scene::Render()
         // 行列データの場合は「転置」してから書き込もう。
         // (C/C++側は「行優先行列」、シェーダー側は「列優先行列」である為)
         // 
-        ConstantBufferLayoutForCamera* mapped = (ConstantBufferLayoutForCamera*)m_constantBufferForCamera->Map();
+        // カメラ毎に現フレーム用のアップロード用のメモリから切り出すので、
+        // 他のカメラや、GPUがまだ読んでいる前のフレームの内容を上書きしない。
+        // 
+        const RhiUploadAllocation allocation = commandContext->AllocateUploadMemory(sizeof(ConstantBufferLayoutForCamera));
+        ConstantBufferLayoutForCamera* mapped = (ConstantBufferLayoutForCamera*)allocation.cpuAddress;
         Mathf::Transpose(mapped->viewMatrix, camera->GetViewMatrix());
         Mathf::Transpose(mapped->projMatrix, camera->GetProjMatrix());
-        m_constantBufferForCamera->Unmap();
 
         // 定数バッファをルートパラメーター0番にバインド
-        commandList->SetGraphicsRootConstantBufferView(0, m_constantBufferForCamera->GetBufferViewDesc().BufferLocation);
+        // (前のカメラのスプライトを並列記録した場合はコマンドリストが切り替わっているので、カメラ毎に取得し直す)
+        RhiCommandList* commandList = commandContext->GetCommandList();
+        commandList->SetGraphicsRootConstantBufferView(0, allocation.gpuAddress);
 
         // カメラによるレンダリング
-        camera->Render(currentFrameResources);
+        camera->Render(commandContext, allocation.gpuAddress);
     }
 }
 
@@ -1,12 +1,26 @@
 ﻿#pragma once
 #include <list>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
 #include <functional>
+#include <chrono>
+#include <mutex>
 #include <DirectXMath.h>
+#include "Handle.h"
+#include "DestroyQueue.h"
 
 // 前方宣言
 class GameObject;
+class Component;
+class Transform;
 class Camera;
-class ConstantBuffer;
+class TransformSystem;
+class MemoryPool;
+class Object;
+class MonoBehaviour;
+class Renderer;
+class SpatialGrid;
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // シーンクラス
@@ -19,16 +33,44 @@ class ConstantBuffer;
 class Scene
 {
 private:
-    std::list<GameObject*> m_rootGameObjects;   // ルートゲームオブジェクトリスト
-    std::list<Camera*> m_allCameras;            // カメラコンポーネントリスト
-    ConstantBuffer* m_constantBufferForCamera;  // 定数バッファ
-    std::vector<Transform*> m_allTransforms;    // 作業用
-    bool m_isUpdating;                          // Update()実行中は true
-
-    struct ConstantBufferLayoutForCamera;       // 定数バッファレイアウト構造体
-    friend class GameObject;                    // GameObjectクラスは友達
-    friend class Transform;                     // Transformクラスは友達
-    friend class Camera;                        // Cameraクラスは友達
+    std::list<GameObject*> m_rootGameObjects;       // ルートゲームオブジェクトリスト
+    std::list<Camera*> m_allCameras;                // カメラコンポーネントリスト
+    TransformSystem* m_transformSystem;             // このシーンに所属する全てのTransformのデータ
+    MemoryPool* m_gameObjectPool;                   // ゲームオブジェクト用のメモリプール
+    std::vector<MemoryPool*> m_componentPools;      // コンポーネントのデータ型毎のメモリプール
+    std::vector<MemoryPool*> m_adoptedPools;        // 破棄された他のシーンから引き継いだメモリプール (移動してきたゲームオブジェクトとコンポーネントが使っている)
+    Scene* m_memoryPoolHeir;                        // ゲームオブジェクトの移動先のシーン (破棄時に、使用中のメモリプールを引き継ぐ)
+    static uint32_t s_numComponentPoolIndices;      // 割り当て済みのメモリプール番号の数
+    std::vector<Component*> m_updateOrder;          // メインスレッドで更新するコンポーネントを階層順(深さ優先)に並べたリスト
+    std::vector<Component*> m_parallelUpdateOrder;  // ワーカースレッドで並列に更新するコンポーネントのリスト
+    std::vector<Transform*> m_traverseStack;        // 作業用
+    std::vector<GameObject*> m_destroyingGameObjects;   // 作業用 (まとめて破棄するゲームオブジェクト)
+    std::vector<std::pair<const Transform*, Transform*>> m_cloneStack;  // 作業用 (複製するTransformと、複製の親)
+    std::unordered_multimap<uint32_t, GameObject*> m_gameObjectsByName; // 名前検索用の索引 (名前のID → ゲームオブジェクト)
+    std::unordered_multimap<uint64_t, Transform*> m_childrenByName;     // 名前検索用の索引 (親と名前のID → 子Transform)
+    std::vector<MonoBehaviour*> m_onPreCullBehaviours;      // OnPreCull()をオーバーライドしているスクリプトのリスト
+    std::vector<MonoBehaviour*> m_onPreRenderBehaviours;    // OnPreRender()をオーバーライドしているスクリプトのリスト
+    std::vector<MonoBehaviour*> m_onPostRenderBehaviours;   // OnPostRender()をオーバーライドしているスクリプトのリスト
+    SpatialGrid* m_rendererGrid;                    // レンダラーのバウンディングボックスの空間索引 (カリング用)
+    std::vector<Handle<Renderer>> m_dirtyBoundsRenderers;   // バウンディングボックスの再計算待ちのレンダラーのリスト
+    std::mutex m_dirtyBoundsMutex;                  // 再計算待ちリストの排他制御 (並列更新中にも追加される為)
+    std::vector<Renderer*> m_visibleRenderers;      // 作業用 (カメラに映るレンダラー)
+    uint32_t m_componentCount;                      // このシーンに所属するコンポーネントの数
+    uint32_t m_updatedComponentCount;               // 直前のUpdate()で更新したコンポーネントの数
+    uint32_t m_renderFrameCount;                    // このシーンを描画した回数
+    bool m_isUpdateOrderDirty;                      // 更新順リストを作り直す必要がある場合は true
+    bool m_isUpdating;                              // Update()実行中は true
+    bool m_isUpdatingInParallel;                    // 並列更新中は true
+    std::chrono::steady_clock::time_point m_startTime;  // このシーンが作成された時刻
+
+    DestroyQueue m_destroyQueue;                    // 破棄予約リスト (破棄する時刻が早い順に取り出す)
+
+    struct ConstantBufferLayoutForCamera;           // 定数バッファレイアウト構造体
+    friend class GameObject;                        // GameObjectクラスは友達
+    friend class Transform;                         // Transformクラスは友達
+    friend class Camera;                            // Cameraクラスは友達
+    friend class Renderer;                          // Rendererクラスは友達
+    friend class SceneManager;                      // SceneManagerクラスは友達
 
 private:
     // 新規ゲームオブジェクトとしてこのシーンに追加します。
@@ -52,6 +94,62 @@ private:
     // カメラをこのシーンから削除します。
     void RemoveCamera(Camera* camera);
 
+    // コンポーネントが追加されたことをこのシーンに通知します。
+    void OnComponentAdded(Component* component);
+
+    // コンポーネントが削除されたことをこのシーンに通知します。
+    void OnComponentRemoved(Component* component);
+
+    // 階層構造が変化したので、次回のUpdate()で更新順リストを作り直すようにします。
+    void SetUpdateOrderDirty() { m_isUpdateOrderDirty = true; }
+
+    // コンポーネントのデータ型に、新しいメモリプール番号を割り当てます。
+    static uint32_t AllocateComponentPoolIndex() { return s_numComponentPoolIndices++; }
+
+    // 指定した番号のメモリプールを取得します。 (まだ無い場合は作成します)
+    MemoryPool& GetComponentPool(uint32_t poolIndex, size_t blockSize, size_t alignment);
+
+    // このシーンに所属する全てのゲームオブジェクトを階層順に集めます。
+    void CollectAllGameObjects(std::vector<GameObject*>& allGameObjects);
+
+    // 全てのコンポーネントを階層順に並べ直して、更新順リストを作り直します。
+    //      ・並列に更新できるコンポーネントは別のリストに振り分けます。
+    void RebuildUpdateOrder();
+
+    // 名前検索用の索引にゲームオブジェクトを登録します。
+    void AddToNameIndex(GameObject* gameObject);
+
+    // 名前検索用の索引からゲームオブジェクトを削除します。
+    void RemoveFromNameIndex(GameObject* gameObject);
+
+    // 親が変わったゲームオブジェクトを、名前検索用の索引に新しい親の子として登録し直します。
+    void ReindexParent(GameObject* gameObject);
+
+    // 指定した親(nullptrの場合はルート)の子から、指定した名前のIDを持つTransformを検索します。
+    //      ・同じ名前の兄弟が複数いる場合は、子の順番で最初のものを返します。
+    Transform* FindChildByName(const Transform* parent, uint32_t nameID) const;
+
+    // 指定したゲームオブジェクトを親またはルートゲームオブジェクトリストから切り離し、子孫ごとまとめて破棄します。
+    void DestroyGameObjectImmediate(GameObject* gameObject);
+
+    // 指定したルートゲームオブジェクトを、子孫とコンポーネントごと別のシーンに移動します。 (SceneManager::LoadScene()から呼ばれます)
+    //      ・ゲームオブジェクトとコンポーネントのアドレスは変わらないので、ポインターやハンドルはそのまま使えます。
+    //      ・メモリはこのシーンのメモリプールに残るので、このシーンの破棄時に使用中のメモリプールを移動先に引き継ぎます。
+    //      ・破棄の予約も、残り時間を保ったまま移動先に引き継ぎます。
+    void MoveRootGameObject(GameObject* rootGameObject, Scene* destination);
+
+    // 破棄する時刻を過ぎたオブジェクトを全て破棄します。
+    //      ・全てのコンポーネントの更新が終わった後に呼び出されます。
+    void ProcessDestroyQueue();
+
+    // レンダラーのバウンディングボックスを再計算待ちにします。
+    //      ・並列更新中にワーカースレッドから呼び出しても安全です。
+    void SetRendererBoundsDirty(Renderer* renderer);
+
+    // 古くなったワールド変換行列をまとめて再計算し、
+    // 行列が変化したレンダラーと再計算待ちのレンダラーのバウンディングボックスを更新して、空間グリッドに反映します。
+    void UpdateRendererBounds();
+
     // このシーンに所属する全てのゲームオブジェクトを走査します。
     void Traverse(const std::function<void (Transform*)>& visitor);
 
@@ -59,6 +157,38 @@ public:
     // コンストラクタ
     Scene();
 
+    // 仮想デストラクタ
+    //      ・このシーンに所属する全てのゲームオブジェクトとコンポーネントを破棄し、メモリプールごとまとめて解放します。
+    //      ・シーンの破棄後にゲームオブジェクトやコンポーネントを参照してはいけません。
+    virtual ~Scene();
+
+    // このシーンに所属する全てのTransformのデータを管理するトランスフォームシステムを取得します。
+    TransformSystem* GetTransformSystem() const { return m_transformSystem; }
+
+    // このシーンに所属するコンポーネントの数を取得します。
+    uint32_t GetComponentCount() const { return m_componentCount; }
+
+    // このシーンが作成されてからの経過時間(秒)を取得します。
+    double GetTime() const;
+
+    // 指定したオブジェクトを time 秒後のフレームの終わりに破棄するように予約します。
+    //      ・Update()の中から呼び出しても安全です。
+    //      ・同じオブジェクトを複数回予約しても、破棄されるのは1回だけです。
+    void ScheduleDestroy(Object* object, float time);
+
+    // 破棄を予約されているオブジェクトの数を取得します。
+    uint32_t GetDestroyQueueCount() const { return m_destroyQueue.GetCount(); }
+
+    // メモリプールの使用状況をコンソールに出力します。
+    void PrintMemoryPoolStatistics() const;
+
+    // 直前のUpdate()で更新したコンポーネントの数を取得します。
+    //      ・全てのコンポーネントは1フレームに1回だけ更新されるので、GetComponentCount()と一致します。
+    uint32_t GetUpdatedComponentCount() const { return m_updatedComponentCount; }
+
+    // このシーンを描画した回数を取得します。
+    uint32_t GetRenderFrameCount() const { return m_renderFrameCount; }
+
     // アセットをロードします。
     // (継承先でオーバーライドしてください)
     virtual void LoadAssets();
@@ -1,4 +1,73 @@
 ﻿#include "SceneManager.h"
+#include "Scene.h"
+#include "GameObject.h"
+#include "Transform.h"
+#include <cstdio>
+#include <cassert>
 
+// 静的メンバ変数の実体を宣言
 Scene* SceneManager::s_activeScene = nullptr;
+std::vector<Handle<GameObject>> SceneManager::s_dontDestroyOnLoadObjects;
 
+
+void SceneManager::AddDontDestroyOnLoad(GameObject* rootGameObject)
+{
+	// 同じゲームオブジェクトを重複して登録しない
+	for (const Handle<GameObject>& handle : s_dontDestroyOnLoadObjects)
+	{
+		if (handle.Get() == rootGameObject)
+		{
+			return;
+		}
+	}
+	s_dontDestroyOnLoadObjects.push_back(Handle<GameObject>(rootGameObject));
+}
+
+
+void SceneManager::LoadScene(Scene* scene)
+{
+	assert(scene && (scene != s_activeScene));
+
+	Scene* previousScene = s_activeScene;
+	s_activeScene = scene;
+
+	// 破棄しないゲームオブジェクトを、子孫ごと新しいシーンに移動する
+	if (previousScene)
+	{
+		auto it = s_dontDestroyOnLoadObjects.begin();
+		while (it != s_dontDestroyOnLoadObjects.end())
+		{
+			GameObject* gameObject = it->Get();
+
+			// 破棄済みのものは登録を解除する
+			if (!gameObject)
+			{
+				it = s_dontDestroyOnLoadObjects.erase(it);
+				continue;
+			}
+
+			// 後から他のゲームオブジェクトの子にされたものは、親の一部として扱う (親ごと破棄される)
+			if (gameObject->GetTransform()->GetParent())
+			{
+				printf("[警告] %s はルートゲームオブジェクトではなくなったので、DontDestroyOnLoad() を解除します\n", gameObject->GetName().c_str());
+				it = s_dontDestroyOnLoadObjects.erase(it);
+				continue;
+			}
+
+			if (gameObject->GetScene() == previousScene)
+			{
+				previousScene->MoveRootGameObject(gameObject, scene);
+			}
+			++it;
+		}
+	}
+
+	// 新しいシーンのアセットをロードしてから、前のシーンを破棄する
+	// (前のシーンと共有しているアセットは、アセットキャッシュから再利用される)
+	scene->LoadAssets();
+	if (previousScene)
+	{
+		previousScene->UnloadAssets();
+		delete previousScene;
+	}
+}
@@ -1,19 +1,28 @@
 ﻿#pragma once
+#include <vector>
+#include "Handle.h"
 
 // 前方宣言
 class Scene;
+class GameObject;
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // シーン管理クラス
 // 
 //      ・全てのシーンの寿命や遷移を管理する。
 //      ・モノステートパターンで実装されている(全てのメンバがstatic)。
+//      ・DontDestroyOnLoad() されたルートゲームオブジェクトを覚えておき、シーンのロード時に新しいシーンへ移動する。
 //        
 //---------------------------------------------------------------------------------------------------------------------------------------------
 class SceneManager
 {
 private:
 	static Scene* s_activeScene;	// 現在アクティブなシーン
+	static std::vector<Handle<GameObject>> s_dontDestroyOnLoadObjects;	// シーンのロード時に破棄しないルートゲームオブジェクト (破棄されたものは無効になる)
+	friend class GameObject;		// GameObjectクラスは友達
+
+	// シーンのロード時に破棄しないルートゲームオブジェクトとして登録します。 (GameObject::DontDestroyOnLoad()から呼ばれます)
+	static void AddDontDestroyOnLoad(GameObject* rootGameObject);
 
 public:
 	// 現在アクティブなシーンを取得します。
@@ -21,5 +30,11 @@ public:
 
 	// 現在アクティブなシーンを設定します。
 	static void SetActiveScene(Scene* scene) { s_activeScene = scene; }
+
+	// 新しいシーンをロードして、アクティブなシーンにします。
+	//      ・DontDestroyOnLoad() されたルートゲームオブジェクトを、子孫ごと新しいシーンに移動してから
+	//        新しいシーンのアセットをロードし、それまでアクティブだったシーンはアセットをアンロードして破棄します。
+	//      ・Update()の中では使用できません。 (フレームの間に呼び出してください)
+	static void LoadScene(Scene* scene);
 };
 
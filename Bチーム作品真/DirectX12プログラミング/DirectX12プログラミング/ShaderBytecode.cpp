@@ -21,6 +21,13 @@ ShaderBytecode::ShaderBytecode(const wchar_t* path, const char* shaderProfile, c
 }
 
 
+ShaderBytecode::ShaderBytecode(ID3DBlob* shaderBytecode)
+    : m_shaderBytecode(shaderBytecode)
+{
+    assert(m_shaderBytecode);
+}
+
+
 ShaderBytecode::~ShaderBytecode()
 {
     if (m_shaderBytecode)
@@ -22,6 +22,9 @@ public:
     //      第2引数 : [in] シェーダープロファイルを表す文字列
     //      第3引数 : [in] シェーダーのエントリーポイント関数名
     ShaderBytecode(const wchar_t* path, const char* shaderProfile, const char* entryPointName);
+    // コンストラクタ (コンパイル済みのシェーダーバイトコードの参照を引き継ぎます)
+    //      第1引数 : [in] コンパイル済みのシェーダーバイトコード
+    ShaderBytecode(ID3DBlob* shaderBytecode);
 
     // 仮想デストラクタ
     virtual ~ShaderBytecode();
@@ -0,0 +1,312 @@
+﻿#include "ShaderCache.h"
+#include "ShaderBytecode.h"
+#include "JobSystem.h"
+#include <d3dcompiler.h>
+#include <filesystem>
+#include <chrono>
+#include <cstdio>
+#include <cassert>
+
+// 静的メンバ変数の実体を宣言
+std::unordered_map<uint64_t, ShaderBytecode*> ShaderCache::s_shaders;
+std::wstring ShaderCache::s_cacheDirectory = L"Assets/ShaderCache";
+ShaderCacheStats ShaderCache::s_stats = {};
+std::mutex ShaderCache::s_mutex;
+
+
+// D3D_SHADER_MACRO の配列をキーの計算に使う形式に変換する
+static std::vector<ShaderDefine> ConvertFrom(const D3D_SHADER_MACRO* defines)
+{
+    std::vector<ShaderDefine> result;
+    for (const D3D_SHADER_MACRO* define = defines; define && define->Name; define++)
+    {
+        result.push_back({ define->Name, define->Definition ? define->Definition : "" });
+    }
+    return result;
+}
+
+
+void ShaderCache::SetCacheDirectory(const wchar_t* cacheDirectory)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_cacheDirectory = cacheDirectory;
+}
+
+
+ShaderBytecode* ShaderCache::Load(const wchar_t* path, const char* shaderProfile, const char* entryPointName, const D3D_SHADER_MACRO* defines)
+{
+    const ShaderRequest request = { path, shaderProfile, entryPointName, defines };
+    ShaderBytecode* shader;
+    LoadInParallel(1, &request, &shader);
+    return shader;
+}
+
+
+void ShaderCache::LoadInParallel(uint32_t count, const ShaderRequest* requests, ShaderBytecode** shaders)
+{
+    // 全ての要求のキーを計算する
+    // (ファイルが読み込めずにキーが計算できなかったものは、キャッシュを使わずにコンパイルする)
+    std::vector<uint64_t> keys(count);
+    std::vector<uint8_t> hasKeys(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        hasKeys[i] = ShaderCacheKey::Compute(requests[i].path, requests[i].shaderProfile, requests[i].entryPointName, ConvertFrom(requests[i].defines), &keys[i]);
+    }
+
+    // 読み込み済みのものは共有する
+    // (同じ要求が複数ある場合は、最初のものだけを読み込んで後から共有する)
+    std::vector<uint32_t> missIndices;
+    std::vector<uint32_t> duplicateIndices;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            shaders[i] = nullptr;
+            if (hasKeys[i])
+            {
+                auto it = s_shaders.find(keys[i]);
+                if (it != s_shaders.end())
+                {
+                    s_stats.memoryHitCount++;
+                    it->second->AddRef();
+                    shaders[i] = it->second;
+                    continue;
+                }
+
+                bool isDuplicate = false;
+                for (uint32_t missIndex : missIndices)
+                {
+                    if (hasKeys[missIndex] && (keys[missIndex] == keys[i]))
+                    {
+                        isDuplicate = true;
+                        break;
+                    }
+                }
+                if (isDuplicate)
+                {
+                    duplicateIndices.push_back(i);
+                    continue;
+                }
+            }
+            missIndices.push_back(i);
+        }
+    }
+
+    // 読み込まれていないものを、キャッシュファイルから読み込むかコンパイルする
+    // (コンパイルには時間が掛かるので、2つ以上ある場合は並列に処理する)
+    if (missIndices.size() >= 2)
+    {
+        JobSystem::Instance().ParallelFor((uint32_t)missIndices.size(), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t j = begin; j < end; j++)
+            {
+                const uint32_t i = missIndices[j];
+                shaders[i] = LoadOrCompile(requests[i], hasKeys[i] != 0, keys[i]);
+            }
+        });
+    }
+    else
+    {
+        for (uint32_t i : missIndices)
+        {
+            shaders[i] = LoadOrCompile(requests[i], hasKeys[i] != 0, keys[i]);
+        }
+    }
+
+    // 新しく読み込んだものをキャッシュに追加して、重複していた要求にも渡す
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (uint32_t i : missIndices)
+    {
+        if (!hasKeys[i] || !shaders[i])
+        {
+            continue;
+        }
+
+        // 別のスレッドが先に同じシェーダーを追加していた場合は、そちらを使う
+        auto it = s_shaders.find(keys[i]);
+        if (it != s_shaders.end())
+        {
+            shaders[i]->Release();
+            it->second->AddRef();
+            shaders[i] = it->second;
+            continue;
+        }
+
+        // キャッシュも参照を1つ持つ
+        shaders[i]->AddRef();
+        s_shaders[keys[i]] = shaders[i];
+    }
+    for (uint32_t i : duplicateIndices)
+    {
+        auto it = s_shaders.find(keys[i]);
+        if (it != s_shaders.end())
+        {
+            s_stats.memoryHitCount++;
+            it->second->AddRef();
+            shaders[i] = it->second;
+        }
+    }
+}
+
+
+ShaderBytecode* ShaderCache::LoadOrCompile(const ShaderRequest& request, bool hasKey, uint64_t key)
+{
+    // キャッシュファイルがあれば、コンパイルせずに済む
+    const ShaderBytecodeFormat format = ShaderCacheKey::GetBytecodeFormat(request.shaderProfile);
+    if (hasKey)
+    {
+        if (ID3DBlob* shaderBytecode = ReadCacheFile(key, format))
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            s_stats.fileHitCount++;
+            printf("[成功] シェーダーキャッシュファイルの読み込み (%ls, %s)\n", request.path, ShaderCacheKey::MakeFileName(key).c_str());
+            return new ShaderBytecode(shaderBytecode);
+        }
+    }
+
+    // D3DCompileFromFile() は DXBC しか出力できないので、DXIL はシェーダークッカーで作成したものを使うしかない
+    if (format != ShaderBytecodeFormat::Dxbc)
+    {
+        printf("[失敗] シェーダーモデル 6.0 以降のシェーダーはコンパイルできません。 シェーダークッカーでキャッシュファイルを作成してください (%ls, %s)\n", request.path, request.shaderProfile);
+        assert(0);
+        return nullptr;
+    }
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    ID3DBlob* shaderBytecode;
+    ID3DBlob* errorMessage;
+    if (FAILED(D3DCompileFromFile(request.path, request.defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, request.entryPointName, request.shaderProfile, 0, 0, &shaderBytecode, &errorMessage)))
+    {
+        printf("[失敗] シェーダーのコンパイル (%ls)\n", request.path);
+        if (errorMessage)
+        {
+            printf("%s\n", (const char*)errorMessage->GetBufferPointer());
+            errorMessage->Release();
+        }
+        assert(0);
+        return nullptr;
+    }
+    const double compileMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_stats.compileCount++;
+        s_stats.compileMilliseconds += compileMilliseconds;
+    }
+    printf("[成功] シェーダーのコンパイル (%ls, %.2f ms)\n", request.path, compileMilliseconds);
+
+    // 次回の起動時にコンパイルを省けるように、キャッシュファイルに書き出しておく
+    if (hasKey)
+    {
+        WriteCacheFile(key, format, shaderBytecode);
+    }
+    return new ShaderBytecode(shaderBytecode);
+}
+
+
+ID3DBlob* ShaderCache::ReadCacheFile(uint64_t key, ShaderBytecodeFormat format)
+{
+    std::filesystem::path path;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        path = std::filesystem::path(s_cacheDirectory) / ShaderCacheKey::MakeFileName(key);
+    }
+
+    FILE* file;
+    if (_wfopen_s(&file, path.wstring().c_str(), L"rb") != 0)
+    {
+        return nullptr;
+    }
+
+    // 別のバージョンで書き出されたファイルや、壊れたファイルは使わない
+    ShaderCacheFileHeader header;
+    if ((fread(&header, sizeof(header), 1, file) != 1) ||
+        (header.magic != ShaderCacheKey::FileMagic) || (header.version != ShaderCacheKey::FileVersion) ||
+        (header.key != key) || (header.format != format) || (header.bytecodeSize == 0))
+    {
+        printf("[警告] シェーダーキャッシュファイルが使用できません (%ls)\n", path.wstring().c_str());
+        fclose(file);
+        return nullptr;
+    }
+
+    ID3DBlob* shaderBytecode;
+    if (FAILED(D3DCreateBlob((SIZE_T)header.bytecodeSize, &shaderBytecode)))
+    {
+        fclose(file);
+        return nullptr;
+    }
+    if (fread(shaderBytecode->GetBufferPointer(), 1, (size_t)header.bytecodeSize, file) != header.bytecodeSize)
+    {
+        printf("[警告] シェーダーキャッシュファイルが使用できません (%ls)\n", path.wstring().c_str());
+        shaderBytecode->Release();
+        fclose(file);
+        return nullptr;
+    }
+    fclose(file);
+    return shaderBytecode;
+}
+
+
+void ShaderCache::WriteCacheFile(uint64_t key, ShaderBytecodeFormat format, ID3DBlob* shaderBytecode)
+{
+    std::filesystem::path directory;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        directory = s_cacheDirectory;
+    }
+    std::error_code errorCode;
+    std::filesystem::create_directories(directory, errorCode);
+    const std::filesystem::path path = directory / ShaderCacheKey::MakeFileName(key);
+
+    FILE* file;
+    if (_wfopen_s(&file, path.wstring().c_str(), L"wb") != 0)
+    {
+        printf("[警告] シェーダーキャッシュファイルを書き込み用に開けませんでした (%ls)\n", path.wstring().c_str());
+        return;
+    }
+
+    ShaderCacheFileHeader header;
+    header.magic = ShaderCacheKey::FileMagic;
+    header.version = ShaderCacheKey::FileVersion;
+    header.key = key;
+    header.bytecodeSize = shaderBytecode->GetBufferSize();
+    header.format = format;
+    header.reserved = 0;
+    const bool succeeded =
+        (fwrite(&header, sizeof(header), 1, file) == 1) &&
+        (fwrite(shaderBytecode->GetBufferPointer(), 1, shaderBytecode->GetBufferSize(), file) == shaderBytecode->GetBufferSize());
+    fclose(file);
+
+    // 書きかけのファイルを残すと次回の読み込みで失敗するので消しておく
+    if (!succeeded)
+    {
+        printf("[警告] シェーダーキャッシュファイルの書き込み (%ls)\n", path.wstring().c_str());
+        std::filesystem::remove(path, errorCode);
+    }
+}
+
+
+void ShaderCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (auto& pair : s_shaders)
+    {
+        pair.second->Release();
+    }
+    s_shaders.clear();
+}
+
+
+ShaderCacheStats ShaderCache::GetStats()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_stats;
+}
+
+
+void ShaderCache::PrintStats()
+{
+    const ShaderCacheStats stats = GetStats();
+    printf("[情報] シェーダーキャッシュ : 共有 %u 回 / キャッシュファイルから読み込み %u 回 / コンパイル %u 回 (%.2f ms)\n",
+        stats.memoryHitCount, stats.fileHitCount, stats.compileCount, stats.compileMilliseconds);
+}
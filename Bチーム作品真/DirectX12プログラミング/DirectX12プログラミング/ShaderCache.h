@@ -0,0 +1,87 @@
+﻿#pragma once
+#include "ShaderCacheKey.h"
+#include <d3dcommon.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+// 前方宣言
+class ShaderBytecode;
+
+// シェーダーの読み込み要求
+struct ShaderRequest
+{
+    const wchar_t* path;                // シェーダーが記述されたHLSLファイルへのパス
+    const char* shaderProfile;          // シェーダープロファイルを表す文字列
+    const char* entryPointName;         // シェーダーのエントリーポイント関数名
+    const D3D_SHADER_MACRO* defines;    // マクロ定義の配列 (Name が nullptr の要素で終わる。 不要な場合は nullptr)
+};
+
+
+// シェーダーキャッシュの統計情報
+struct ShaderCacheStats
+{
+    uint32_t memoryHitCount;            // 読み込み済みのシェーダーが見つかった回数
+    uint32_t fileHitCount;              // シェーダーキャッシュファイルから読み込めた回数
+    uint32_t compileCount;              // どちらにも無かったのでコンパイルした回数
+    double compileMilliseconds;         // コンパイルに掛かった時間の合計 (単位はミリ秒。 並列にコンパイルした分も足し合わせる)
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// シェーダーキャッシュクラス
+//
+//      ・コンパイル済みのシェーダーバイトコードを ShaderCacheKey で計算したキーで共有するクラス。
+//      ・同じキーで要求された場合は、参照カウントを1増やして読み込み済みのシェーダーを返す。
+//      ・読み込まれていない場合は、キャッシュディレクトリにある「キーの16進数表記.cso」を読み込む。
+//        無い場合(またはキーが一致しない場合)だけ D3DCompileFromFile() でコンパイルし、結果をキャッシュディレクトリに書き出す。
+//      ・キャッシュファイルはシェーダークッカー(Tools/ShaderCooker)で事前に作成しておくこともできる。
+//        シェーダークッカーは DXC で DXIL を出力するので、シェーダーモデル 6.0 以降のプロファイルで要求したものだけが読み込まれる。
+//      ・D3DCompileFromFile() はシェーダーモデル 5.1 までしかコンパイルできないので、
+//        6.0 以降のプロファイルはシェーダークッカーで事前に作成しておく必要がある。 (無い場合は失敗する)
+//      ・モノステートパターンで実装されている(全てのメンバがstatic)。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class ShaderCache
+{
+private:
+    static std::unordered_map<uint64_t, ShaderBytecode*> s_shaders;     // キー → 読み込み済みのシェーダー
+    static std::wstring s_cacheDirectory;           // キャッシュディレクトリへのパス
+    static ShaderCacheStats s_stats;                // 統計情報
+    static std::mutex s_mutex;                      // 全てのメンバを保護する
+
+private:
+    // 読み込み済みでないシェーダーを、キャッシュファイルから読み込むかコンパイルして作成します。
+    // 失敗した場合は nullptr を返します。
+    static ShaderBytecode* LoadOrCompile(const ShaderRequest& request, bool hasKey, uint64_t key);
+
+    // キャッシュファイルからシェーダーバイトコードを読み込みます。 (無い場合やキーか形式が一致しない場合は nullptr を返します)
+    static ID3DBlob* ReadCacheFile(uint64_t key, ShaderBytecodeFormat format);
+
+    // シェーダーバイトコードをキャッシュファイルに書き出します。
+    static void WriteCacheFile(uint64_t key, ShaderBytecodeFormat format, ID3DBlob* shaderBytecode);
+
+public:
+    // キャッシュディレクトリを設定します。 (既定値は "Assets/ShaderCache")
+    static void SetCacheDirectory(const wchar_t* cacheDirectory);
+
+    // シェーダーを読み込みます。
+    //   ・呼び出し元は、受け取ったシェーダーが不要になったら Release() してください。
+    static ShaderBytecode* Load(const wchar_t* path, const char* shaderProfile, const char* entryPointName, const D3D_SHADER_MACRO* defines = nullptr);
+
+    // 複数のシェーダーをまとめて読み込みます。
+    //   ・コンパイルが必要なものは、ジョブシステムで並列にコンパイルします。
+    //   ・shaders[i] には requests[i] に対応するシェーダーが格納されます。
+    static void LoadInParallel(uint32_t count, const ShaderRequest* requests, ShaderBytecode** shaders);
+
+    // キャッシュが持つ全ての参照を解放します。
+    static void Clear();
+
+    // 統計情報を取得します。
+    static ShaderCacheStats GetStats();
+
+    // 統計情報をコンソールに出力します。
+    static void PrintStats();
+};
@@ -0,0 +1,202 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ※注意
+//
+//  このヘッダーはゲーム本体とシェーダークッカー(Tools/ShaderCooker)の両方から使われる。
+//  Windows や D3D12 のヘッダーに依存しないこと。 (標準ライブラリのみを使用する)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// シェーダーのプリプロセッサマクロ定義
+struct ShaderDefine
+{
+    std::string name;                   // マクロ名
+    std::string value;                  // 定義値
+};
+
+
+// シェーダーバイトコードの形式
+// (シェーダーモデル 5.x 以前は FXC(D3DCompile) が出力する DXBC、6.0 以降は DXC が出力する DXIL)
+enum class ShaderBytecodeFormat : uint32_t
+{
+    Dxbc = 0,                           // DXBC (FXC でコンパイルしたもの)
+    Dxil = 1,                           // DXIL (DXC でコンパイルしたもの)
+};
+
+
+// シェーダーキャッシュファイルの先頭に置かれるヘッダー
+struct ShaderCacheFileHeader
+{
+    uint32_t magic;                     // ファイル識別子 (ShaderCacheKey::FileMagic)
+    uint32_t version;                   // ファイル形式のバージョン (ShaderCacheKey::FileVersion)
+    uint64_t key;                       // シェーダーキャッシュのキー
+    uint64_t bytecodeSize;              // ヘッダーに続くシェーダーバイトコードのサイズ(単位はバイト)
+    ShaderBytecodeFormat format;        // シェーダーバイトコードの形式 (キーにも混ぜてあるが、読み込み時に念の為に確かめる)
+    uint32_t reserved;                  // 予約 (0)
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// シェーダーキャッシュキークラス
+//
+//      ・シェーダーキャッシュのキー(64ビットのハッシュ値)を計算するクラス。
+//      ・キーは「ソースファイルと、そこから #include "..." で読み込まれる全てのファイルの中身」
+//        「シェーダープロファイル」「エントリーポイント関数名」「マクロ定義」から計算する。
+//      ・ファイルの中身は改行コードの '\r' を取り除いてから計算する。 (チェックアウトした環境によって改行コードが変わっても同じキーになる)
+//      ・シェーダープロファイルから決まるバイトコードの形式(DXBC か DXIL か)もキーに混ぜる。
+//        (同じソースでも、FXC の DXBC と DXC の DXIL が同じキーのファイルを取り合わないようにする)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class ShaderCacheKey
+{
+public:
+    static constexpr uint32_t FileMagic = 0x43444853;   // 'S' 'H' 'D' 'C'
+    static constexpr uint32_t FileVersion = 2;
+
+private:
+    // FNV-1a (64ビット) の定数
+    static constexpr uint64_t FnvOffsetBasis = 14695981039346656037ULL;
+    static constexpr uint64_t FnvPrime = 1099511628211ULL;
+
+    // バイト列をハッシュ値に混ぜます。
+    static uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= FnvPrime;
+        }
+        return hash;
+    }
+
+    // 文字列をハッシュ値に混ぜます。 (長さも混ぜるので、連結した結果が同じ文字列同士でも区別されます)
+    static uint64_t HashString(uint64_t hash, const std::string& string)
+    {
+        const uint64_t length = string.size();
+        hash = HashBytes(hash, &length, sizeof(length));
+        return HashBytes(hash, string.data(), string.size());
+    }
+
+    // ファイルの中身とインクルードしているファイルの中身をハッシュ値に混ぜます。
+    // (同じファイルは2回以上混ぜません。読み込めないファイルがあった場合は false を返します)
+    static bool HashFile(uint64_t& hash, const std::filesystem::path& path, std::vector<std::filesystem::path>& visitedPaths)
+    {
+        const std::filesystem::path normalizedPath = path.lexically_normal();
+        for (const std::filesystem::path& visitedPath : visitedPaths)
+        {
+            if (visitedPath == normalizedPath)
+            {
+                return true;
+            }
+        }
+        visitedPaths.push_back(normalizedPath);
+
+        std::ifstream file(normalizedPath, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+        std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        // 改行コードを '\n' に揃える
+        std::string normalizedSource;
+        normalizedSource.reserve(source.size());
+        for (char c : source)
+        {
+            if (c != '\r')
+            {
+                normalizedSource += c;
+            }
+        }
+        hash = HashString(hash, normalizedSource);
+
+        // #include "..." を探して、インクルードしているファイルも混ぜる
+        // (パスはインクルードしている側のファイルからの相対パス)
+        size_t lineBegin = 0;
+        while (lineBegin < normalizedSource.size())
+        {
+            size_t lineEnd = normalizedSource.find('\n', lineBegin);
+            if (lineEnd == std::string::npos)
+            {
+                lineEnd = normalizedSource.size();
+            }
+
+            size_t i = normalizedSource.find_first_not_of(" \t", lineBegin);
+            if ((i < lineEnd) && (normalizedSource[i] == '#'))
+            {
+                i = normalizedSource.find_first_not_of(" \t", i + 1);
+                if ((i < lineEnd) && (normalizedSource.compare(i, 7, "include") == 0))
+                {
+                    const size_t nameBegin = normalizedSource.find('"', i + 7);
+                    const size_t nameEnd = (nameBegin < lineEnd) ? normalizedSource.find('"', nameBegin + 1) : std::string::npos;
+                    if (nameEnd < lineEnd)
+                    {
+                        const std::string includeName = normalizedSource.substr(nameBegin + 1, nameEnd - nameBegin - 1);
+                        if (!HashFile(hash, normalizedPath.parent_path() / includeName, visitedPaths))
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+            lineBegin = lineEnd + 1;
+        }
+        return true;
+    }
+
+public:
+    // シェーダープロファイル(例: "vs_5_1")から、コンパイル結果のバイトコードの形式を取得します。
+    // (シェーダーモデルのメジャーバージョンが 6 以上なら DXIL、それ以外は DXBC)
+    static ShaderBytecodeFormat GetBytecodeFormat(const std::string& shaderProfile)
+    {
+        const size_t separator = shaderProfile.find('_');
+        if ((separator == std::string::npos) || (separator + 1 >= shaderProfile.size()))
+        {
+            return ShaderBytecodeFormat::Dxbc;
+        }
+        const char majorVersion = shaderProfile[separator + 1];
+        return ((majorVersion >= '6') && (majorVersion <= '9')) ? ShaderBytecodeFormat::Dxil : ShaderBytecodeFormat::Dxbc;
+    }
+
+    // シェーダーキャッシュのキーを計算します。
+    // ソースファイルまたはインクルードしているファイルが読み込めなかった場合は false を返します。
+    static bool Compute(const std::filesystem::path& sourcePath, const std::string& shaderProfile, const std::string& entryPointName, const std::vector<ShaderDefine>& defines, uint64_t* key)
+    {
+        uint64_t hash = FnvOffsetBasis;
+        const ShaderBytecodeFormat format = GetBytecodeFormat(shaderProfile);
+        hash = HashBytes(hash, &FileVersion, sizeof(FileVersion));
+        hash = HashBytes(hash, &format, sizeof(format));
+        hash = HashString(hash, shaderProfile);
+        hash = HashString(hash, entryPointName);
+        for (const ShaderDefine& define : defines)
+        {
+            hash = HashString(hash, define.name);
+            hash = HashString(hash, define.value);
+        }
+
+        std::vector<std::filesystem::path> visitedPaths;
+        if (!HashFile(hash, sourcePath, visitedPaths))
+        {
+            return false;
+        }
+        *key = hash;
+        return true;
+    }
+
+    // キーからシェーダーキャッシュのファイル名を作成します。 (キーの16進数表記 + ".cso")
+    static std::string MakeFileName(uint64_t key)
+    {
+        char fileName[32];
+        snprintf(fileName, sizeof(fileName), "%016llx.cso", (unsigned long long)key);
+        return fileName;
+    }
+};
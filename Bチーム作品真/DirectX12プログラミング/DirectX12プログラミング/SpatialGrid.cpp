@@ -0,0 +1,168 @@
+﻿#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+// セルの位置から、セルの索引のキーを作る
+static uint64_t MakeCellKey(int32_t x, int32_t y)
+{
+    return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+}
+
+
+SpatialGrid::SpatialGrid(float cellSize)
+    : m_cellSize(cellSize)
+    , m_count(0)
+{
+    assert(cellSize > 0.0f);
+}
+
+
+int32_t SpatialGrid::ToCellCoordinate(float position) const
+{
+    // 極端に遠い位置でも整数に変換できるように、範囲を制限しておく
+    const float cell = floorf(position / m_cellSize);
+    return (int32_t)std::clamp(cell, -1.0e9f, 1.0e9f);
+}
+
+
+uint32_t SpatialGrid::GetOrCreateCell(int32_t x, int32_t y)
+{
+    auto result = m_cellIndices.emplace(MakeCellKey(x, y), (uint32_t)m_cells.size());
+    if (result.second)
+    {
+        Cell cell;
+        cell.x = x;
+        cell.y = y;
+        m_cells.push_back(std::move(cell));
+    }
+    return result.first->second;
+}
+
+
+std::vector<SpatialGridEntry*>& SpatialGrid::GetList(uint32_t cellIndex)
+{
+    if (cellIndex == LargeCellIndex)
+    {
+        return m_largeEntries;
+    }
+    if (cellIndex == UnboundedCellIndex)
+    {
+        return m_unboundedEntries;
+    }
+    return m_cells[cellIndex].entries;
+}
+
+
+void SpatialGrid::Update(SpatialGridEntry* entry)
+{
+    // 新しく登録するリストを決める
+    uint32_t newCellIndex = UnboundedCellIndex;
+    if (entry->hasBounds)
+    {
+        const Bounds& bounds = entry->bounds;
+        const float halfCellSize = m_cellSize * 0.5f;
+        if ((bounds.extents.x <= halfCellSize) && (bounds.extents.y <= halfCellSize))
+        {
+            newCellIndex = GetOrCreateCell(ToCellCoordinate(bounds.center.x), ToCellCoordinate(bounds.center.y));
+        }
+        else
+        {
+            newCellIndex = LargeCellIndex;
+        }
+    }
+
+    // 同じリストに留まる場合は何もしなくてよい (殆どの移動はこれで済む)
+    if (newCellIndex == entry->cellIndex)
+    {
+        return;
+    }
+
+    Remove(entry);
+
+    std::vector<SpatialGridEntry*>& entries = GetList(newCellIndex);
+    entry->cellIndex = newCellIndex;
+    entry->slot = (uint32_t)entries.size();
+    entries.push_back(entry);
+    m_count++;
+}
+
+
+void SpatialGrid::Remove(SpatialGridEntry* entry)
+{
+    if (entry->cellIndex == InvalidCellIndex)
+    {
+        return;
+    }
+
+    // 末尾の項目を削除する位置に移動させる
+    std::vector<SpatialGridEntry*>& entries = GetList(entry->cellIndex);
+    const uint32_t slot = entry->slot;
+    assert(entries[slot] == entry);
+
+    SpatialGridEntry* last = entries.back();
+    entries[slot] = last;
+    last->slot = slot;
+    entries.pop_back();
+
+    entry->cellIndex = InvalidCellIndex;
+    entry->slot = 0;
+    m_count--;
+}
+
+
+void SpatialGrid::Query(const Bounds& area, std::vector<Renderer*>& results) const
+{
+    // セルに登録されているレンダラーはセルからセルの大きさの半分までしかはみ出さないので、
+    // 検索範囲をその分だけ広げれば、重なる可能性のあるセルを全て調べられる。
+    const float halfCellSize = m_cellSize * 0.5f;
+    const int32_t minX = ToCellCoordinate(area.center.x - area.extents.x - halfCellSize);
+    const int32_t minY = ToCellCoordinate(area.center.y - area.extents.y - halfCellSize);
+    const int32_t maxX = ToCellCoordinate(area.center.x + area.extents.x + halfCellSize);
+    const int32_t maxY = ToCellCoordinate(area.center.y + area.extents.y + halfCellSize);
+
+    // 検索範囲のセル数が使用中のセル数よりも多い場合は、使用中のセルを全て調べた方が速い
+    const uint64_t numCellsInArea = (uint64_t)((int64_t)maxX - minX + 1) * (uint64_t)((int64_t)maxY - minY + 1);
+    if (numCellsInArea > m_cells.size())
+    {
+        for (const Cell& cell : m_cells)
+        {
+            if ((minX <= cell.x) && (cell.x <= maxX) && (minY <= cell.y) && (cell.y <= maxY))
+            {
+                QueryList(cell.entries, area, results);
+            }
+        }
+    }
+    else
+    {
+        for (int32_t y = minY; y <= maxY; y++)
+        {
+            for (int32_t x = minX; x <= maxX; x++)
+            {
+                auto it = m_cellIndices.find(MakeCellKey(x, y));
+                if (it != m_cellIndices.end())
+                {
+                    QueryList(m_cells[it->second].entries, area, results);
+                }
+            }
+        }
+    }
+
+    // 大きなレンダラーは数が少ないので全て調べる
+    QueryList(m_largeEntries, area, results);
+}
+
+
+void SpatialGrid::QueryList(const std::vector<SpatialGridEntry*>& entries, const Bounds& area, std::vector<Renderer*>& results)
+{
+    for (const SpatialGridEntry* entry : entries)
+    {
+        // XY平面上で重なっているかどうかだけを調べる (Z方向はカメラの視錐台で判定する)
+        const Bounds& bounds = entry->bounds;
+        if ((fabsf(bounds.center.x - area.center.x) <= bounds.extents.x + area.extents.x) &&
+            (fabsf(bounds.center.y - area.center.y) <= bounds.extents.y + area.extents.y))
+        {
+            results.push_back(entry->renderer);
+        }
+    }
+}
@@ -0,0 +1,97 @@
+﻿#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "Bounds.h"
+
+// 前方宣言
+class Renderer;
+
+
+// 空間グリッドに登録する項目
+//      ・レンダラーが1つずつ持ち、空間グリッドは項目へのポインターをリストに入れる。
+//      ・空間グリッドはレンダラーの中身に触れないので、このヘッダーは Windows や D3D12 のヘッダーに依存しないこと。 (テストでも使う)
+struct SpatialGridEntry
+{
+    Renderer* renderer;     // この項目を持つレンダラー (検索結果として返す)
+    Bounds bounds;          // ワールド空間でのバウンディングボックス
+    bool hasBounds;         // バウンディングボックスを持つ場合は true (false の場合はカリングされない)
+    uint32_t cellIndex;     // 登録されているリスト (セルの添え字、または LargeCellIndex などの特別な値)
+    uint32_t slot;          // リスト内での格納位置
+};
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// 空間グリッドクラス
+//
+//      ・シーン内のレンダラーを、ワールド空間のバウンディングボックスの位置で索引付けするクラス。(カリングのブロードフェーズ)
+//      ・XY平面を一定サイズのセルに区切り、各レンダラーはバウンディングボックスの中心が入るセルに1つだけ登録される。
+//      ・セルの大きさの半分よりも大きくはみ出すレンダラーは登録しないので、
+//        検索範囲をセルの大きさの半分だけ広げれば取りこぼしが無い。(いわゆるルーズグリッド)
+//      ・セルに収まらない大きなレンダラーや、バウンディングボックスを持たないレンダラーは別のリストで管理する。
+//      ・レンダラーは自分が登録されているリストと格納位置を項目(SpatialGridEntry)に覚えているので、移動や削除は O(1) で行える。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class SpatialGrid
+{
+public:
+    static constexpr uint32_t InvalidCellIndex = UINT32_MAX;        // どこにも登録されていない
+    static constexpr uint32_t LargeCellIndex = UINT32_MAX - 1;      // セルに収まらない大きなレンダラーのリストに登録されている
+    static constexpr uint32_t UnboundedCellIndex = UINT32_MAX - 2;  // バウンディングボックスを持たないレンダラーのリストに登録されている
+
+private:
+    // セル
+    struct Cell
+    {
+        int32_t x;                          // セルの位置 (X方向)
+        int32_t y;                          // セルの位置 (Y方向)
+        std::vector<SpatialGridEntry*> entries; // このセルに中心があるレンダラーの項目のリスト
+    };
+
+    float m_cellSize;                                   // セルの大きさ (ワールド空間での一辺の長さ)
+    std::vector<Cell> m_cells;                          // 使用中のセルの配列 (一度作られたセルは削除しない)
+    std::unordered_map<uint64_t, uint32_t> m_cellIndices;   // セルの位置 → セルの配列内での添え字
+    std::vector<SpatialGridEntry*> m_largeEntries;      // セルに収まらない大きなレンダラーの項目のリスト
+    std::vector<SpatialGridEntry*> m_unboundedEntries;  // バウンディングボックスを持たないレンダラーの項目のリスト (カリングしない)
+    uint32_t m_count;                                   // 登録されているレンダラーの数
+
+public:
+    // コンストラクタ
+    SpatialGrid(float cellSize);
+
+    // コピーは禁止
+    SpatialGrid(const SpatialGrid&) = delete;
+    SpatialGrid& operator=(const SpatialGrid&) = delete;
+
+    // セルの大きさを取得します。
+    float GetCellSize() const { return m_cellSize; }
+
+    // 登録されているレンダラーの数を取得します。
+    uint32_t GetCount() const { return m_count; }
+
+    // 項目を現在のバウンディングボックスの位置に登録します。
+    //      ・既に登録されている場合は移動します。 (同じセルに留まる場合は何もしません)
+    void Update(SpatialGridEntry* entry);
+
+    // 項目の登録を解除します。 (登録されていない場合は何もしません)
+    void Remove(SpatialGridEntry* entry);
+
+    // XY平面上で、指定した範囲とバウンディングボックスが重なるレンダラーを results に追加します。
+    //      ・バウンディングボックスを持たないレンダラーは含まれません。 (GetUnboundedEntries()で取得してください)
+    void Query(const Bounds& area, std::vector<Renderer*>& results) const;
+
+    // バウンディングボックスを持たないレンダラーの項目のリストを取得します。
+    const std::vector<SpatialGridEntry*>& GetUnboundedEntries() const { return m_unboundedEntries; }
+
+private:
+    // 指定した位置が入るセルの位置を計算します。
+    int32_t ToCellCoordinate(float position) const;
+
+    // 指定した位置のセルを取得します。 (まだ無い場合は作成します)
+    uint32_t GetOrCreateCell(int32_t x, int32_t y);
+
+    // 指定したセルの添え字に対応する項目のリストを取得します。
+    std::vector<SpatialGridEntry*>& GetList(uint32_t cellIndex);
+
+    // リスト内の、XY平面上で指定した範囲とバウンディングボックスが重なるレンダラーを results に追加します。
+    static void QueryList(const std::vector<SpatialGridEntry*>& entries, const Bounds& area, std::vector<Renderer*>& results);
+};
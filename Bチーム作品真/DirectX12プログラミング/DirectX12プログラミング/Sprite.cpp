@@ -1,6 +1,4 @@
 ﻿#include "Sprite.h"
-#include "VertexBuffer.h"
-#include "IndexBuffer.h"
 #include "Rect.h"
 #include "Vector2.h"
 #include <cassert>
@@ -17,21 +15,11 @@ Sprite* Sprite::Create(Texture2D* texture, const Rect& rect, const Vector2& pivo
 }
 
 
-// 頂点1個分を表す構造体
-struct Sprite::SpriteVertex
-{
-    float x, y;
-    float u, v;
-};
-
-
 Sprite::Sprite(Texture2D* texture, const Rect& rect, const Vector2& pivot, float pixelsPerUnit)
     : m_texture(texture)
     , m_textureRect(rect)
     , m_pivot(pivot)
     , m_pixelsPerUnit(pixelsPerUnit)
-    , m_vertexBuffer(nullptr)
-    , m_indexBuffer(nullptr)
 {
     assert(m_texture);
     assert(m_pixelsPerUnit > 0.0f);
@@ -71,14 +59,6 @@ Sprite::Sprite(Texture2D* texture, const Rect& rect, const Vector2& pivot, float
 
 Sprite::~Sprite()
 {
-    // 頂点バッファを解放
-    if (m_vertexBuffer)
-        m_vertexBuffer->Release();
-
-    // インデックスバッファを解放
-    if (m_indexBuffer)
-        m_indexBuffer->Release();
-
     // テクスチャを解放
     if (m_texture)
         m_texture->Release();
@@ -92,14 +72,6 @@ void Sprite::OverrideGeometry(uint16_t numVertices, const Vector2 vertices[], ui
     assert(numTriangles > 0);
     assert(triangles);
 
-    // 頂点バッファの破棄
-    if (m_vertexBuffer)
-        m_vertexBuffer->Release();
-
-    // インデックスバッファの破棄
-    if (m_indexBuffer)
-        m_indexBuffer->Release();
-
     // 頂点配列から境界矩形を求める
     Vector2 boundingMin(Vector2::PositiveInfinity);
     Vector2 boundingMax(Vector2::NegativeInfinity);
@@ -133,27 +105,11 @@ void Sprite::OverrideGeometry(uint16_t numVertices, const Vector2 vertices[], ui
         m_uv[i].y = (m_textureRect.y + m_textureRect.height * internalRatioY) / texH;
     }
 
-    SpriteVertex* spriteVertices = new SpriteVertex[numVertices];
-    for (uint16_t i = 0; i < numVertices; i++)
-    {
-        spriteVertices[i].x = vertices[i].x;
-        spriteVertices[i].y = vertices[i].y;
-        spriteVertices[i].u = m_uv[i].x;
-        spriteVertices[i].v = m_uv[i].y;
-    }
-
-    // 頂点バッファの作成 (ビデオメモリ上)
-    m_vertexBuffer = new VertexBuffer(sizeof(SpriteVertex), numVertices, spriteVertices);
-    delete[] spriteVertices;
-
-    // インデックスバッファの作成 (ビデオメモリ上)
-    m_indexBuffer = new IndexBuffer(IndexFormat::UInt16, numTriangles, triangles);
-
-    // システムメモリ上にも保存しておく
+    // 頂点配列を保存しておく (スプライトバッチが描画時に読む)
     m_vertices.resize(numVertices);
     memcpy(&m_vertices[0], vertices, sizeof(vertices[0]) * numVertices);
 
-    // システムメモリ上にも保存しておく
+    // インデックス配列を保存しておく (スプライトバッチが描画時に読む)
     m_triangles.resize(numTriangles);
     memcpy(&m_triangles[0], triangles, sizeof(triangles[0]) * numTriangles);
 }
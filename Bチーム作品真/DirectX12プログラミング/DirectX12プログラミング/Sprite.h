@@ -5,8 +5,6 @@
 #include <vector>
 
 // 前方宣言
-class VertexBuffer;
-class IndexBuffer;
 class Rect;
 class Vector2;
 
@@ -16,6 +14,8 @@ class Vector2;
 //      ・主に2D開発時に利用されるクラス。
 //      ・2Dスプライト生成時にサイズとテクスチャを決定する。
 //      ・2Dスプライト生成後にサイズやテクスチャを変更することはできない。
+//      ・頂点とインデックスはシステムメモリ上にだけ持つ。 (GPUリソースは作らない)
+//        描画時にスプライトバッチ(SpriteRendererBatch)がワールド空間に変換して、フレーム毎の頂点リングバッファに書き込む。
 //        
 //---------------------------------------------------------------------------------------------------------------------------------------------
 class Sprite : public Object
@@ -29,9 +29,6 @@ private:
     std::vector<uint16_t>   m_triangles;        // 頂点インデックス配列
     std::vector<Vector2>    m_uv;               // テクスチャ座標配列
     std::vector<Vector2>    m_vertices;         // 頂点配列
-    VertexBuffer*           m_vertexBuffer;     // 頂点バッファ
-    IndexBuffer*            m_indexBuffer;      // インデックスバッファ
-    struct SpriteVertex;                        // スプライト用頂点レイアウト構造体
 
 private:
     // コンストラクタ
@@ -53,6 +50,9 @@ public:
     // このスプライトで使用するテクスチャを取得します
     Texture2D* GetTexture() const { return m_texture; }
 
+    // このスプライトにマッピングされるテクスチャ上の矩形領域を取得します。
+    const Rect& GetTextureRect() const { return m_textureRect; }
+
     // ピボットを取得します。
     const Vector2& GetPivot() const { return m_pivot; }
 
@@ -73,11 +73,5 @@ public:
 
     // 既存のスプライトメッシュを上書き作成します。
     void OverrideGeometry(const std::vector<Vector2>& vertices, const std::vector<uint16_t>& triangles);
-
-    // 頂点バッファを取得します
-    VertexBuffer* GetVertexBuffer() const { return m_vertexBuffer; }
-
-    // インデックスバッファを取得します
-    IndexBuffer* GetIndexBuffer() const { return m_indexBuffer; }
 };
 
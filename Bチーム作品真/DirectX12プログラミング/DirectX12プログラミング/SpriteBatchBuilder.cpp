@@ -0,0 +1,170 @@
+﻿#include "SpriteBatchBuilder.h"
+#include <cstring>
+
+
+void SpriteBatchBuilder::SortItems(const std::vector<SpriteBatchItem>& items, const float viewDepthColumn[4], float nearClipPlane, float farClipPlane, RenderQueue& renderQueue)
+{
+    renderQueue.Clear();
+
+    // ビュー空間の深度を 0.0f(前方クリッピング平面) ～ 1.0f(後方クリッピング平面) に正規化する
+    const float depthScale = 1.0f / (farClipPlane - nearClipPlane);
+
+    // レンダーキューはカメラ毎に空にするので、カメラ番号は常に0
+    RenderQueue::SortKeyDesc desc;
+    desc.cameraIndex = 0;
+
+    for (uint32_t i = 0; i < (uint32_t)items.size(); i++)
+    {
+        const SpriteBatchItem& item = items[i];
+
+        // 行ベクトル × 行列なので、ビュー空間のz成分は3列目との内積
+        const float* c = item.boundsCenter;
+        const float viewDepth = c[0] * viewDepthColumn[0] + c[1] * viewDepthColumn[1] + c[2] * viewDepthColumn[2] + viewDepthColumn[3];
+
+        desc.sortingLayer = item.sortingLayer;
+        desc.sortingOrder = item.sortingOrder;
+        desc.isTransparent = item.isTransparent;
+        desc.depth = (viewDepth - nearClipPlane) * depthScale;
+        desc.pipelineIndex = item.pipelineIndex;
+        desc.textureIndex = item.textureIndex;
+        desc.sequence = i;
+        renderQueue.Submit(RenderQueue::MakeSortKey(desc), i);
+    }
+
+    // 半透明のスプライトは、深度が等しければ Push() された順番(階層順)のまま並ぶ
+    renderQueue.Sort();
+}
+
+
+void SpriteBatchBuilder::BuildDrawCommands(const std::vector<SpriteBatchItem>& items, const RenderQueue::Packet* packets, uint32_t count, RhiPipelineState* const* pipelineStates,
+    SpriteBatchVertex* vertices, uint32_t* indices, uint32_t& vertexLocation, uint32_t& indexLocation, std::vector<SpriteBatchDrawCommand>& drawCommands)
+{
+    for (uint32_t packetIndex = 0; packetIndex < count; packetIndex++)
+    {
+        const SpriteBatchItem& item = items[packets[packetIndex].payload];
+        RhiPipelineState* pipelineState = pipelineStates[item.pipelineIndex];
+
+        // 頂点をワールド空間に変換して書き込む (スプライトの頂点は z = 0 の平面上にある)
+        // (アップロードヒープは書き込み専用で使うこと。読み出すと非常に遅い)
+        const float (*m)[4] = item.localToWorld;
+        SpriteBatchVertex* dst = vertices + vertexLocation;
+        for (uint32_t i = 0; i < item.vertexCount; i++)
+        {
+            const float x = item.vertices[i * 2 + 0];
+            const float y = item.vertices[i * 2 + 1];
+            dst[i].position[0] = x * m[0][0] + y * m[1][0] + m[3][0];
+            dst[i].position[1] = x * m[0][1] + y * m[1][1] + m[3][1];
+            dst[i].position[2] = x * m[0][2] + y * m[1][2] + m[3][2];
+            memcpy(dst[i].color, item.color, sizeof(dst[i].color));
+            dst[i].texcoord[0] = item.texcoords[i * 2 + 0];
+            dst[i].texcoord[1] = item.texcoords[i * 2 + 1];
+            dst[i].textureIndex = item.textureIndex;
+        }
+
+        // インデックスは頂点バッファの先頭からの位置にしておく (ドローコールをまとめてもずれない)
+        uint32_t* dstIndices = indices + indexLocation;
+        for (uint32_t i = 0; i < item.indexCount; i++)
+        {
+            dstIndices[i] = vertexLocation + item.triangles[i];
+        }
+
+        // 同じパイプラインステートが続く場合は、直前のドローコールにまとめる (テクスチャは頂点毎に選ぶので違ってもよい)
+        SpriteBatchDrawCommand* last = drawCommands.empty() ? nullptr : &drawCommands.back();
+        if (last && (last->pipelineState == pipelineState) && (last->startIndexLocation + last->indexCount == indexLocation))
+        {
+            last->indexCount += item.indexCount;
+            last->spriteCount++;
+        }
+        else
+        {
+            SpriteBatchDrawCommand drawCommand;
+            drawCommand.pipelineState = pipelineState;
+            drawCommand.startIndexLocation = indexLocation;
+            drawCommand.indexCount = item.indexCount;
+            drawCommand.spriteCount = 1;
+            drawCommands.push_back(drawCommand);
+        }
+
+        vertexLocation += item.vertexCount;
+        indexLocation += item.indexCount;
+    }
+}
+
+
+uint32_t SpriteBatchBuilder::ComputeNumRecordingJobs(uint32_t count, uint32_t numThreads)
+{
+    // コマンドリストを増やすとキューに送る数も増えるので、少ない場合は分けない
+    const uint32_t numJobs = count / MinSpritesPerRecordingJob;
+    return (numJobs < numThreads) ? numJobs : numThreads;
+}
+
+
+void SpriteBatchBuilder::SplitRecordingJobs(const std::vector<SpriteBatchItem>& items, const RenderQueue::Packet* packets, uint32_t count, uint32_t numJobs,
+    uint32_t vertexLocation, uint32_t indexLocation, std::vector<SpriteBatchRecordingJob>& jobs)
+{
+    jobs.resize(numJobs);
+
+    uint32_t packetIndex = 0;
+    for (uint32_t jobIndex = 0; jobIndex < numJobs; jobIndex++)
+    {
+        SpriteBatchRecordingJob& job = jobs[jobIndex];
+        job.firstPacket = packetIndex;
+        job.packetCount = (uint32_t)((uint64_t)count * (jobIndex + 1) / numJobs) - packetIndex;
+        job.vertexLocation = vertexLocation;
+        job.indexLocation = indexLocation;
+        job.commandList = nullptr;
+        job.drawCommands.clear();
+
+        for (uint32_t i = 0; i < job.packetCount; i++)
+        {
+            const SpriteBatchItem& item = items[packets[packetIndex + i].payload];
+            vertexLocation += item.vertexCount;
+            indexLocation += item.indexCount;
+        }
+        packetIndex += job.packetCount;
+    }
+}
+
+
+void SpriteBatchBuilder::SetupCommandList(RhiCommandList* commandList, const RhiCommandContext* commandContext, const RhiViewport& viewport, const RhiRect& scissorRect, uint64_t cameraConstantBuffer)
+{
+    // パイプラインステート、ルートシグネチャ、共有ディスクリプタヒープ
+    commandContext->ApplyDefaultGraphicsState(commandList);
+
+    // ビューポートとシザー矩形、レンダーターゲットはカメラの Render() と同じものにする
+    commandList->RSSetViewport(viewport);
+    commandList->RSSetScissorRect(scissorRect);
+    commandList->OMSetRenderTarget(commandContext->GetRenderTargetView(), commandContext->GetDepthStencilView());
+
+    // カメラの定数バッファをルートパラメーター0番にバインド
+    commandList->SetGraphicsRootConstantBufferView(0, cameraConstantBuffer);
+}
+
+
+void SpriteBatchBuilder::SubmitDrawCommands(RhiCommandList* commandList, const std::vector<SpriteBatchDrawCommand>& drawCommands, const RhiVertexBufferView& vertexBufferView, const RhiIndexBufferView& indexBufferView, RhiGpuDescriptor textureTable)
+{
+    if (drawCommands.empty())
+    {
+        return;
+    }
+
+    commandList->IASetVertexBuffer(0, vertexBufferView);
+    commandList->IASetIndexBuffer(indexBufferView);
+    commandList->IASetPrimitiveTopology(RhiPrimitiveTopology::TriangleList);
+
+    // テクスチャのディスクリプタテーブルは永続領域の先頭に1回設定するだけでよい
+    commandList->SetGraphicsRootDescriptorTable(3, textureTable);
+
+    // 直前のドローコールと異なるステートだけを設定し直す
+    RhiPipelineState* currentPipelineState = nullptr;
+    for (const SpriteBatchDrawCommand& drawCommand : drawCommands)
+    {
+        if (drawCommand.pipelineState != currentPipelineState)
+        {
+            commandList->SetPipelineState(drawCommand.pipelineState);
+            currentPipelineState = drawCommand.pipelineState;
+        }
+
+        commandList->DrawIndexedInstanced(drawCommand.indexCount, 1, drawCommand.startIndexLocation, 0, 0);
+    }
+}
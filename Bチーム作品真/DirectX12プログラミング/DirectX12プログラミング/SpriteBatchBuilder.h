@@ -0,0 +1,145 @@
+﻿#pragma once
+#include <vector>
+#include <cstdint>
+#include "RenderQueue.h"
+#include "Rhi.h"
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ※注意
+//
+//  スプライトバッチのうち、並べ替えと頂点の書き込み、ドローコールの組み立てだけを取り出したもの。
+//  描画順やドローコール数をGPUの無い環境でも確かめられるように、ヌルRHIと組み合わせてテストする。
+//  このヘッダーは Windows や D3D12 のヘッダーに依存しないこと。 (標準ライブラリのみを使用する)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// スプライトの描画に使用される頂点 (入力レイアウトと同じ並び。 40バイト)
+struct SpriteBatchVertex
+{
+    float position[3];                  // ワールド空間座標
+    float color[4];                     // スプライトカラー
+    float texcoord[2];                  // テクスチャ座標
+    uint32_t textureIndex;              // テクスチャ配列の添え字 (共有ディスクリプタヒープ内でのSRVの番号)
+};
+
+
+// 描画待ちのスプライト
+//   ・スプライトの形状は Push() した時点のものを指すだけで、コピーはしない。 (Render() が終わるまで変更しないこと)
+struct SpriteBatchItem
+{
+    float localToWorld[4][4];           // ローカル空間からワールド空間への変換行列 (行ベクトル × 行列)
+    float boundsCenter[3];              // ワールド空間でのバウンディングボックスの中心 (深度の計算に使う)
+    const float* vertices;              // ローカル空間の頂点座標 (x, y の組が vertexCount 個)
+    const float* texcoords;             // テクスチャ座標 (u, v の組が vertexCount 個)
+    const uint16_t* triangles;          // 三角形リストのインデックス
+    uint32_t vertexCount;               // 頂点数
+    uint32_t indexCount;                // インデックス数
+    float color[4];                     // スプライトカラー
+    int sortingLayer;                   // ソーティングレイヤー
+    int sortingOrder;                   // レイヤー内の順序
+    bool isTransparent;                 // 半透明の場合は true
+    uint32_t pipelineIndex;             // 描画に使うパイプラインステートの番号
+    uint32_t textureIndex;              // テクスチャの番号 (共有ディスクリプタヒープ内でのSRVの番号)
+};
+
+
+// 1回のドローコールで描画するスプライトのまとまり
+struct SpriteBatchDrawCommand
+{
+    RhiPipelineState* pipelineState;    // パイプラインステート
+    uint32_t startIndexLocation;        // インデックスバッファ内の開始位置
+    uint32_t indexCount;                // インデックス数
+    uint32_t spriteCount;               // まとめられたスプライトの数
+};
+
+
+// 並列に記録する、1つのコマンドリスト分の区間
+struct SpriteBatchRecordingJob
+{
+    uint32_t firstPacket;                               // 区間の先頭の描画パケットの位置
+    uint32_t packetCount;                               // 区間の描画パケットの数
+    uint32_t vertexLocation;                            // 区間の最初の頂点の、頂点バッファ内での位置
+    uint32_t indexLocation;                             // 区間の最初のインデックスの、インデックスバッファ内での位置
+    RhiCommandList* commandList;                        // 記録先のコマンドリスト
+    std::vector<SpriteBatchDrawCommand> drawCommands;   // 区間のドローコール
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// スプライトバッチビルダークラス
+//
+//      ・描画待ちのスプライトをレンダーキューで並べ替え、頂点とインデックスを書き込んでドローコールのリストを作る。
+//      ・同じパイプラインステートが連続するスプライトは、テクスチャが違っても1回のドローコールにまとめる。
+//        (テクスチャは頂点に持たせた番号でシェーダーが選ぶので、ドローコールを分ける必要が無い)
+//      ・書き込み先や記録先を引数で受け取るので、GPUのバッファやコマンドリストが無くても使える。
+//      ・全てのメンバ関数は静的で、状態を持たない。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class SpriteBatchBuilder
+{
+public:
+    static constexpr uint32_t MinSpritesPerRecordingJob = 4096;     // 並列記録する場合の、1つのコマンドリストに記録する最小のスプライト数
+
+    // 描画待ちのスプライトのソートキーを作成し、レンダーキューで並べ替えます。
+    //   ・描画パケットの値には、スプライトの添え字が入ります。
+    //   ・半透明のスプライトは、深度が等しければ配列の順番(Push()した順番)のまま並びます。
+    //      第1引数 : [in] 描画待ちのスプライト (Push()した順番)
+    //      第2引数 : [in] ビュー行列の3列目 (_13, _23, _33, _43。 ワールド空間の位置との内積がビュー空間の深度になる)
+    //      第3引数 : [in] カメラの前方クリッピング平面までの距離
+    //      第4引数 : [in] カメラの後方クリッピング平面までの距離
+    //      第5引数 : [out] 並べ替えた結果を格納するレンダーキュー (空にしてから積みます)
+    static void SortItems(const std::vector<SpriteBatchItem>& items, const float viewDepthColumn[4], float nearClipPlane, float farClipPlane, RenderQueue& renderQueue);
+
+    // 並べ替え済みのスプライトの頂点とインデックスを書き込み、ドローコールのリストに追加します。
+    //   ・同じパイプラインステートが連続する場合は直前のドローコールにまとめます。
+    //   ・別々の区間であれば、複数のスレッドから同時に呼び出せます。
+    //      第1引数 : [in] 描画待ちのスプライト
+    //      第2引数 : [in] 並べ替え済みの描画パケット
+    //      第3引数 : [in] 描画パケットの数
+    //      第4引数 : [in] パイプラインステートの番号から、パイプラインステートを引く配列
+    //      第5引数 : [out] 頂点の書き込み先
+    //      第6引数 : [out] インデックスの書き込み先
+    //      第7引数 : [in/out] 次に書き込む頂点の、頂点バッファ内での位置
+    //      第8引数 : [in/out] 次に書き込むインデックスの、インデックスバッファ内での位置
+    //      第9引数 : [out] ドローコールの追加先
+    static void BuildDrawCommands(const std::vector<SpriteBatchItem>& items, const RenderQueue::Packet* packets, uint32_t count, RhiPipelineState* const* pipelineStates,
+        SpriteBatchVertex* vertices, uint32_t* indices, uint32_t& vertexLocation, uint32_t& indexLocation, std::vector<SpriteBatchDrawCommand>& drawCommands);
+
+    // 並列に記録する区間の数を決めます。
+    //   ・1つの区間が MinSpritesPerRecordingJob 個以上になり、スレッド数を超えない数を返します。
+    //   ・2未満の場合は、並列に記録せずに1つのコマンドリストに積んだ方が速いことを表します。
+    //      第1引数 : [in] 描画するスプライトの数
+    //      第2引数 : [in] メインスレッドを含むスレッド数
+    static uint32_t ComputeNumRecordingJobs(uint32_t count, uint32_t numThreads);
+
+    // 並べ替え済みのスプライトを、描画順にほぼ同じ数のスプライトの区間に分けます。
+    //   ・各区間の頂点とインデックスの書き込み位置を先頭から順番に決めるので、区間同士で書き込み先は重なりません。
+    //   ・記録先のコマンドリストは nullptr にします。 (呼び出し元が記録する順番に取り出して設定してください)
+    //      第1引数 : [in] 描画待ちのスプライト
+    //      第2引数 : [in] 並べ替え済みの描画パケット
+    //      第3引数 : [in] 描画パケットの数
+    //      第4引数 : [in] 区間の数
+    //      第5引数 : [in] 最初の頂点の、頂点バッファ内での位置
+    //      第6引数 : [in] 最初のインデックスの、インデックスバッファ内での位置
+    //      第7引数 : [out] 区間の格納先 (区間の数に合わせて大きさを変えます。 ドローコールの配列の容量は使い回します)
+    static void SplitRecordingJobs(const std::vector<SpriteBatchItem>& items, const RenderQueue::Packet* packets, uint32_t count, uint32_t numJobs,
+        uint32_t vertexLocation, uint32_t indexLocation, std::vector<SpriteBatchRecordingJob>& jobs);
+
+    // 新しく記録を始めたコマンドリストに、カメラの描画に必要なステートを設定します。
+    //   ・パイプラインステート、ルートシグネチャ、共有ディスクリプタヒープはコマンドコンテキストの既定のものにします。
+    //      第1引数 : [in] 記録先のコマンドリスト
+    //      第2引数 : [in] 描画中のコマンドコンテキスト (既定のステートとレンダーターゲットを取得します)
+    //      第3引数 : [in] カメラのビューポート
+    //      第4引数 : [in] カメラのシザー矩形
+    //      第5引数 : [in] カメラの定数バッファ (ルートパラメーター0番にバインドします)
+    static void SetupCommandList(RhiCommandList* commandList, const RhiCommandContext* commandContext, const RhiViewport& viewport, const RhiRect& scissorRect, uint64_t cameraConstantBuffer);
+
+    // ドローコールのリストをコマンドリストに積みます。
+    //   ・直前のドローコールと異なるパイプラインステートだけを設定し直します。
+    //      第1引数 : [in] 記録先のコマンドリスト
+    //      第2引数 : [in] ドローコールのリスト
+    //      第3引数 : [in] 頂点バッファビュー
+    //      第4引数 : [in] インデックスバッファビュー
+    //      第5引数 : [in] テクスチャのディスクリプタテーブルの先頭 (ルートパラメーター3番に設定します)
+    static void SubmitDrawCommands(RhiCommandList* commandList, const std::vector<SpriteBatchDrawCommand>& drawCommands, const RhiVertexBufferView& vertexBufferView, const RhiIndexBufferView& indexBufferView, RhiGpuDescriptor textureTable);
+};
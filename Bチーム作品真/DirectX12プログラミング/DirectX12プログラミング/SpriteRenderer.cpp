@@ -1,14 +1,9 @@
 ﻿#include "SpriteRenderer.h"
 #include "GameObject.h"
 #include "Transform.h"
-#include "GraphicsEngine.h"
-#include "ConstantBuffer.h"
-#include "FrameResources.h"
 #include "Sprite.h"
-#include "VertexBuffer.h"
-#include "IndexBuffer.h"
+#include "SpriteRendererBatch.h"
 #include "Color.h"
-#include "Mathf.h"
 
 const TypeInfo& SpriteRenderer::GetTypeInfo()
 {
@@ -17,22 +12,21 @@ const TypeInfo& SpriteRenderer::GetTypeInfo()
 }
 
 
-// 定数バッファのレイアウト
-struct SpriteRenderer::ConstantBufferLayout
-{
-    DirectX::XMFLOAT4X4 world;
-    Color   spriteColor;
-};
-
-
 SpriteRenderer::SpriteRenderer()
     : m_sprite(nullptr)
     , m_spriteColor(Color::White)
     , m_isFlippedX(false)
     , m_isFlippedY(false)
 {
-    // 定数バッファの作成
-    m_constantBuffer = new ConstantBuffer(sizeof(ConstantBufferLayout));
+}
+
+SpriteRenderer::SpriteRenderer(const SpriteRenderer& original)
+    : Renderer(original)
+    , m_sprite(original.m_sprite)
+    , m_spriteColor(original.m_spriteColor)
+    , m_isFlippedX(original.m_isFlippedX)
+    , m_isFlippedY(original.m_isFlippedY)
+{
 }
 
 SpriteRenderer::~SpriteRenderer()
@@ -43,6 +37,33 @@ SpriteRenderer::~SpriteRenderer()
 void SpriteRenderer::SetSprite(Sprite* sprite)
 {
     m_sprite = sprite;
+
+    // スプライトの大きさが変わるかもしれないので、バウンディングボックスを再計算してもらう
+    SetBoundsDirty();
+}
+
+bool SpriteRenderer::GetLocalBounds(Bounds& localBounds) const
+{
+    // スプライトが設定されていない場合は何も描画しないので、大きさ0のボックスにしておく
+    localBounds = Bounds();
+    if (!m_sprite || m_sprite->GetVertices().empty())
+    {
+        return true;
+    }
+
+    // 頂点はモデル空間のXY平面上にある
+    const std::vector<Vector2>& vertices = m_sprite->GetVertices();
+    Vector3 min(vertices[0].x, vertices[0].y, 0.0f);
+    Vector3 max = min;
+    for (const Vector2& vertex : vertices)
+    {
+        min.x = (vertex.x < min.x) ? vertex.x : min.x;
+        min.y = (vertex.y < min.y) ? vertex.y : min.y;
+        max.x = (vertex.x > max.x) ? vertex.x : max.x;
+        max.y = (vertex.y > max.y) ? vertex.y : max.y;
+    }
+    localBounds.SetMinMax(min, max);
+    return true;
 }
 
 void SpriteRenderer::SetColor(const Color& color)
@@ -65,51 +86,6 @@ void SpriteRenderer::Render()
     if (!m_sprite)
         return;
 
-    // このスプライトレンダラーの所有者であるゲームオブジェクトを取得
-    const GameObject* owner = GetGameObject();
-
-    // Transformコンポーネントを取得
-    const Transform* transform = owner->GetTransform();
-
-    // ワールド変換行列を取得する
-    const DirectX::XMFLOAT4X4 localToWorldMatrix = transform->GetLocalToWorldMatrix();
-
-    // 定数バッファに「(転置した)ワールド変換行列」と「スプライトカラー」を書き込む
-    ConstantBufferLayout* mapped = (ConstantBufferLayout*)m_constantBuffer->Map();
-    Mathf::Transpose(mapped->world, localToWorldMatrix);
-    mapped->spriteColor = m_spriteColor;
-    m_constantBuffer->Unmap();
-
-    // 現フレーム用のリソースセットを取得する
-    FrameResources* frameResources = GraphicsEngine::Instance().GetCurrentFrameResources();
-
-    // 現フレーム用のコマンドリストを取得する
-    ID3D12GraphicsCommandList* commandList = frameResources->GetCommandList();
-
-    // 頂点バッファビュー配列を設定する
-    const D3D12_VERTEX_BUFFER_VIEW vertexBufferViews[] =
-    {
-        m_sprite->GetVertexBuffer()->GetVertexBufferView(),
-    };
-    commandList->IASetVertexBuffers(0, _countof(vertexBufferViews), vertexBufferViews);
-
-    // インデックスバッファビューを設定する
-    commandList->IASetIndexBuffer(&m_sprite->GetIndexBuffer()->GetIndexBufferView());
-
-    // プリミティブトポロジーを設定する
-    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
- 
-    // ルートパラメーターに従って定数バッファを設定する
-    commandList->SetGraphicsRootConstantBufferView(1, m_constantBuffer->GetNativeResource()->GetGPUVirtualAddress());
-
-    ID3D12DescriptorHeap* const DesciptorHeaps[] = { m_sprite->GetTexture()->GetDescriptorHeap() };
-    commandList->SetDescriptorHeaps(_countof(DesciptorHeaps), DesciptorHeaps);
-    commandList->SetGraphicsRootDescriptorTable(3, m_sprite->GetTexture()->GetDescriptorHeap()->GetGPUDescriptorHandleForHeapStart());
-
-    // ドローコール
-    commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
-
-
+    // 頂点の変換と描画はスプライトバッチがまとめて行う
+    SpriteRendererBatch::Push(this);
 }
-
-
@@ -5,7 +5,6 @@
 
 // 前方宣言
 class Sprite;
-class ConstantBuffer;
 class Color;
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
@@ -13,6 +12,7 @@ class Color;
 //
 //   ・スプライト1個をレンダリングするのに必要なリソースや機能を持ったクラス。
 //   ・レンダリング時のオプション機能として「スプライトカラー」「上下反転」「左右反転」等が指定できる。
+//   ・実際の描画はスプライトバッチがまとめて行う。
 // 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 class SpriteRenderer : public Renderer
@@ -22,20 +22,24 @@ private:
     Color m_spriteColor;                // スプライトカラー
     bool m_isFlippedX;                  // テクスチャを左右反転したい場合は true
     bool m_isFlippedY;                  // テクスチャを上下反転したい場合は true
-    ConstantBuffer* m_constantBuffer;   // 定数バッファ
-    struct ConstantBufferLayout;        // 定数バッファレイアウト
     friend class GameObject;            // ゲームオブジェクトクラスは友達
 
 private:
     // コンストラクタ
     SpriteRenderer();
 
+    // コピーコンストラクタ (スプライトは共有します)
+    SpriteRenderer(const SpriteRenderer& original);
+
     // 仮想デストラクタ
     virtual ~SpriteRenderer();
 
-    // Component::Render()のオーバーライド
+    // Component::Render()のオーバーライド (スプライトバッチに描画を依頼します)
     void Render() override;
 
+    // Renderer::GetLocalBounds()のオーバーライド (スプライトの頂点を包むボックスを返します)
+    bool GetLocalBounds(Bounds& localBounds) const override;
+
 public:
     // このデータ型の情報を返します。
     static const TypeInfo& GetTypeInfo();
@@ -43,6 +47,12 @@ public:
     // このインスタンスのデータ型の情報を返します。
     virtual const TypeInfo& GetTypeInfoOfInstance() const { return GetTypeInfo(); }
 
+    // GameObjectのコンポーネントテーブル内での、このデータ型の添え字
+    static constexpr ComponentTypeIndex TypeIndex = ComponentTypeIndex::SpriteRenderer;
+
+    // このデータ型と全ての基底クラスを表すビットマスク
+    static constexpr uint32_t TypeMask = Renderer::TypeMask | ToComponentTypeMask(TypeIndex);
+
     // レンダリング対象となるスプライトを設定します。
     void SetSprite(Sprite* sprite);
 
@@ -1,80 +1,71 @@
 ﻿#include "Precompiled.h"
 #include "SpriteRendererBatch.h"
 
-
-// スプライトの描画に使用される頂点を表す構造体
-struct SpriteRendererBatch::SpriteVertex
-{
-    DirectX::XMFLOAT3 position;
-    Color color;
-    DirectX::XMFLOAT2 texcoord;
-};
+using namespace DirectX;
 
 
-// 頂点シェーダーで使用される定数バッファを表す構造体
-struct SpriteRendererBatch::ConstantBufferForSprite
-{
-    DirectX::XMFLOAT4X4 worldMatrix;
-    Color color;
-};
-
-
-// 頂点シェーダーで使用される定数バッファを表す構造体
-struct SpriteRendererBatch::ConstantBufferForCamera
-{
-    DirectX::XMFLOAT4X4 viewMatrix;
-    DirectX::XMFLOAT4X4 projMatrix;
-};
+// 頂点は入力レイアウトと同じ並びであること
+static_assert(sizeof(SpriteBatchVertex) == 40, "SpriteBatchVertex のサイズが入力レイアウトと一致しません");
+static_assert(sizeof(Vector2) == sizeof(float) * 2, "Vector2 は float の組として SpriteBatchBuilder に渡します");
+static_assert(sizeof(Color) == sizeof(float) * 4, "Color は float[4] として SpriteBatchBuilder に渡します");
 
 
 // 静的メンバ変数の実体を宣言
 SpriteRendererBatch::Resources* SpriteRendererBatch::s_resources = nullptr;
 
 
-void SpriteRendererBatch::CreateCommandListBundle()
+void SpriteRendererBatch::LoadAssets(uint32_t maxVerticesPerFrame)
 {
-    ID3D12Device* d3d12Device = GraphicsEngine::Instance().GetD3D12Device();
+    assert(!s_resources);
+    assert(maxVerticesPerFrame > 0);
+    s_resources = new Resources();
 
-    // コマンドアロケーターの作成
-    ID3D12CommandAllocator* d3d12CommandAllocator;
-    if (FAILED(d3d12Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_ID3D12CommandAllocator, (void**)&d3d12CommandAllocator)))
+    // 頂点シェーダーとピクセルシェーダー (シェーダーキャッシュに無いものだけを並列にコンパイルする)
+    static const D3D_SHADER_MACRO premultipliedDefines[] =
     {
-        printf("[失敗] スプライトバッチ用コマンドアロケーターの作成\n");
-    }
-    printf("[成功] スプライトバッチ用コマンドアロケーターの作成 (アドレス: 0x%p)\n", d3d12CommandAllocator);
-
-
-    // コマンドリストバンドルの作成
-    ID3D12GraphicsCommandList* d3d12GraphicsCommandList;
-    if (FAILED(d3d12Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, d3d12CommandAllocator, nullptr, IID_ID3D12GraphicsCommandList, (void**)&d3d12GraphicsCommandList)))
+        { "PREMULTIPLIED_ALPHA", "1" },
+        { nullptr, nullptr },
+    };
+    static const ShaderRequest shaderRequests[] =
     {
-        printf("[失敗] スプライトバッチ用コマンドリストバンドルの作成\n");
-    }
-    printf("[成功] スプライトバッチ用コマンドリストバンドルの作成 (アドレス: 0x%p)\n", d3d12GraphicsCommandList);
-}
-
-
-void SpriteRendererBatch::CreateDescriptorHeap()
-{
-}
-
-
-void SpriteRendererBatch::LoadAssets()
-{
-    assert(!s_resources);
-    s_resources = new Resources();
-    s_resources->vertexBufer = new VertexBuffer(sizeof(SpriteVertex), 1024);                                    // 頂点バッファ
-    s_resources->vertexShader = new ShaderBytecode(L"Assets/Shader/SpriteRendererVS.hlsl", "vs_5_1", "main");   // 頂点シェーダー
-    s_resources->pixelShader = new ShaderBytecode(L"Assets/Shader/SpriteRendererPS.hlsl", "ps_5_1", "main");    // ピクセルシェーダー
-    s_resources->constantBufferForSprite = new ConstantBuffer(sizeof(ConstantBufferForSprite) * 180);           // 定数バッファ
-    s_resources->constantBufferForCamera = new ConstantBuffer(sizeof(ConstantBufferForCamera) * 1);             // 定数バッファ
+        { L"Assets/Shader/SpriteBatchVS.hlsl", "vs_5_1", "main", nullptr },
+        { L"Assets/Shader/SpriteBatchPS.hlsl", "ps_5_1", "main", nullptr },
+        { L"Assets/Shader/SpriteBatchPS.hlsl", "ps_5_1", "main", premultipliedDefines },
+    };
+    ShaderBytecode* shaders[_countof(shaderRequests)];
+    ShaderCache::LoadInParallel(_countof(shaderRequests), shaderRequests, shaders);
+    s_resources->vertexShader = shaders[0];
+    s_resources->pixelShader = shaders[1];
+    s_resources->premultipliedPixelShader = shaders[2];
+
+    // 頂点リングバッファとインデックスリングバッファ (毎フレーム書き換えるのでマップしたままにしておく)
+    // (全てのフレームリソース分の大きさを持ち、GPUが前のフレームの頂点を読んでいる間に、次のフレームの頂点を上書きしないようにする)
+    s_resources->maxVerticesPerFrame = maxVerticesPerFrame;
+    s_resources->maxIndicesPerFrame = maxVerticesPerFrame * 3 / 2;
+    s_resources->ringBufferVertexCount = s_resources->maxVerticesPerFrame * GraphicsEngine::NumFrameResources;
+    s_resources->ringBufferIndexCount = s_resources->maxIndicesPerFrame * GraphicsEngine::NumFrameResources;
+    s_resources->vertexBuffer = new VertexBuffer(sizeof(SpriteBatchVertex), s_resources->ringBufferVertexCount, nullptr, nullptr, true);
+    s_resources->indexBuffer = new IndexBuffer(IndexFormat::UInt32, s_resources->ringBufferIndexCount, nullptr, nullptr, true);
+    s_resources->mappedVertices = (SpriteBatchVertex*)s_resources->vertexBuffer->Map();
+    s_resources->mappedIndices = (uint32_t*)s_resources->indexBuffer->Map();
+    s_resources->vertexHead = 0;
+    s_resources->indexHead = 0;
+    s_resources->frameVertexCount = 0;
+    s_resources->frameIndexCount = 0;
+    s_resources->currentCommandContext = nullptr;
+    s_resources->currentFrameNumber = 0;
+    s_resources->hasReportedOverflow = false;
 
     //---------------------------------------------------------------------------------------------------------------------------------------------
     // ルートシグネチャの作成
+    //
+    //  メインのルートシグネチャと全く同じ定義にしておく。
+    //  (定義が同じなら切り替えずに済むので、カメラの定数バッファなどのバインドがそのまま使える)
     //---------------------------------------------------------------------------------------------------------------------------------------------
     static const DescriptorRange descriptorRange[] =
     {
-        DescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 1, 0, D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND),
+        DescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, DescriptorAllocator::DefaultNumPersistentDescriptors, 0, D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND,
+            D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE),
     };
 
     RootSignatureBuilder rootSignatureBuilder;
@@ -88,11 +79,13 @@ void SpriteRendererBatch::LoadAssets()
 
     //---------------------------------------------------------------------------------------------------------------------------------------------
     // 入力レイアウト (英: Input Layout)
+    //---------------------------------------------------------------------------------------------------------------------------------------------
     static const D3D12_INPUT_ELEMENT_DESC InputElementDescs[] =
     {
         { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT,    0,  0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
         { "VCOLOR",   0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
         { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,       0, 28, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXINDEX", 0, DXGI_FORMAT_R32_UINT,           0, 36, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
     };
 
     //---------------------------------------------------------------------------------------------------------------------------------------------
@@ -104,102 +97,243 @@ void SpriteRendererBatch::LoadAssets()
     pipelineStateBuilder.IASetInputElementDescs(_countof(InputElementDescs), InputElementDescs);
     pipelineStateBuilder.VSSetShader(s_resources->vertexShader);
     pipelineStateBuilder.PSSetShader(s_resources->pixelShader);
-    pipelineStateBuilder.BSSetAlphaToCoverageEnable(true);
-    pipelineStateBuilder.BSSetRenderTargetBlend(0, RenderTargetBlend::NonPremultiplied);
     pipelineStateBuilder.OMSetNumRenderTargets(1);
     pipelineStateBuilder.OMSetRenderTargetFormat(0, RenderTargetFormat::R8G8B8A8_UNorm);
     pipelineStateBuilder.OMSetDepthStencilFormat(DepthStencilFormat::Depth32);
-    pipelineStateBuilder.End(&s_resources->pipelineState);
 
-    CreateCommandListBundle();
-    CreateDescriptorHeap();
+    // 不透明なスプライト用 (ブレンドせずに深度を書き込む)
+    pipelineStateBuilder.BSSetAlphaToCoverageEnable(false);
+    pipelineStateBuilder.BSSetRenderTargetBlend(0, RenderTargetBlend::Opaque);
+    pipelineStateBuilder.End(&s_resources->opaquePipelineState);
 
+    // 半透明なスプライト用 (メインのパイプラインステートと同じ設定)
+    pipelineStateBuilder.BSSetAlphaToCoverageEnable(true);
+    pipelineStateBuilder.BSSetRenderTargetBlend(0, RenderTargetBlend::AlphaBlend);
+    pipelineStateBuilder.End(&s_resources->transparentPipelineState);
 
-    // CBV/SRV用ディスクリプタヒープの作成
-    // シェーダーリソースビュー(SRV)の作成 
+    // 乗算済みアルファのテクスチャを使う半透明なスプライト用 (色はピクセルシェーダーで頂点カラーのアルファも乗算済みにする)
+    pipelineStateBuilder.PSSetShader(s_resources->premultipliedPixelShader);
+    pipelineStateBuilder.BSSetRenderTargetBlend(0, RenderTargetBlend::PremultipliedAlpha);
+    pipelineStateBuilder.End(&s_resources->premultipliedPipelineState);
 }
 
 
-void SpriteRendererBatch::SortOpaqueGeometry()
+void SpriteRendererBatch::SortGeometry(const Camera* camera)
 {
-
+    // ビュー空間の深度は、ワールド空間の位置とビュー行列の3列目との内積
+    const DirectX::XMFLOAT4X4& viewMatrix = camera->GetViewMatrix();
+    const float viewDepthColumn[4] = { viewMatrix._13, viewMatrix._23, viewMatrix._33, viewMatrix._43 };
+    SpriteBatchBuilder::SortItems(s_resources->geometries, viewDepthColumn, camera->GetNearClipPlane(), camera->GetFarClipPlane(), s_resources->renderQueue);
 }
 
 
-void SpriteRendererBatch::SortTransparentGeometry()
+void SpriteRendererBatch::BuildDrawCommands(const RenderQueue::Packet* packets, uint32_t count, uint32_t& vertexLocation, uint32_t& indexLocation, std::vector<DrawCommand>& drawCommands)
 {
-
+    RhiPipelineState* const pipelineStates[NumPipelines] = { ToRhi(s_resources->opaquePipelineState), ToRhi(s_resources->transparentPipelineState), ToRhi(s_resources->premultipliedPipelineState) };
+    SpriteBatchBuilder::BuildDrawCommands(s_resources->geometries, packets, count, pipelineStates, s_resources->mappedVertices, s_resources->mappedIndices, vertexLocation, indexLocation, drawCommands);
 }
 
 
-void SpriteRendererBatch::RenderOpaqueGeometry()
+bool SpriteRendererBatch::AllocateRingBuffer(uint32_t vertexCount, uint32_t indexCount, uint32_t& vertexLocation, uint32_t& indexLocation)
 {
-    for (SpriteRenderer* renderer : s_resources->opaqueGeometries)
+    // 末尾に収まらない場合は先頭に折り返す (飛ばした分も現在のフレームで使用したことにする)
+    const uint32_t vertexSkip = (s_resources->vertexHead + vertexCount > s_resources->ringBufferVertexCount) ? s_resources->ringBufferVertexCount - s_resources->vertexHead : 0;
+    const uint32_t indexSkip = (s_resources->indexHead + indexCount > s_resources->ringBufferIndexCount) ? s_resources->ringBufferIndexCount - s_resources->indexHead : 0;
+
+    // 1フレームで使える量を超える場合は、GPUが読んでいる最中の領域を上書きしてしまうので確保できない
+    if ((s_resources->frameVertexCount + vertexSkip + vertexCount > s_resources->maxVerticesPerFrame) ||
+        (s_resources->frameIndexCount + indexSkip + indexCount > s_resources->maxIndicesPerFrame))
     {
+        return false;
     }
-}
 
-
-void SpriteRendererBatch::RenderTransparentGeometry()
-{
-    for (SpriteRenderer* renderer : s_resources->transparentGeometries)
+    if (vertexSkip)
     {
-
+        s_resources->vertexHead = 0;
     }
+    if (indexSkip)
+    {
+        s_resources->indexHead = 0;
+    }
+
+    vertexLocation = s_resources->vertexHead;
+    indexLocation = s_resources->indexHead;
+    s_resources->vertexHead += vertexCount;
+    s_resources->indexHead += indexCount;
+    s_resources->frameVertexCount += vertexSkip + vertexCount;
+    s_resources->frameIndexCount += indexSkip + indexCount;
+    return true;
 }
 
 
-void SpriteRendererBatch::Render()
+void SpriteRendererBatch::SubmitDrawCommands(RhiCommandList* commandList, const std::vector<DrawCommand>& drawCommands)
 {
+    // テクスチャのディスクリプタテーブルは共有ディスクリプタヒープの永続領域の先頭
+    SpriteBatchBuilder::SubmitDrawCommands(commandList, drawCommands,
+        ToRhi(s_resources->vertexBuffer->GetVertexBufferView()),
+        ToRhi(s_resources->indexBuffer->GetIndexBufferView()),
+        ToRhi(GraphicsEngine::Instance().GetDescriptorAllocator()->GetGPUHandle(0)));
+}
 
 
+void SpriteRendererBatch::SetupCommandList(RhiCommandList* commandList, const RhiCommandContext* commandContext, const Camera* camera, uint64_t cameraConstantBuffer)
+{
+    SpriteBatchBuilder::SetupCommandList(commandList, commandContext, camera->ComputeViewport(commandContext), camera->ComputeScissorRect(commandContext), cameraConstantBuffer);
+}
 
 
+void SpriteRendererBatch::RecordInParallel(RhiCommandContext* commandContext, const Camera* camera, uint64_t cameraConstantBuffer, uint32_t count, uint32_t numJobs, uint32_t vertexLocation, uint32_t indexLocation)
+{
+    const std::vector<RenderQueue::Packet>& packets = s_resources->renderQueue.GetPackets();
+    std::vector<RecordingJob>& jobs = s_resources->recordingJobs;
 
+    // 描画順をほぼ同じ数のスプライトの区間に分け、各区間の書き込み位置を先頭から順番に決めておく
+    // (コマンドリストの取り出しはメインスレッドで行い、取り出した順番にキューに送られる)
+    SpriteBatchBuilder::SplitRecordingJobs(s_resources->geometries, packets.data(), count, numJobs, vertexLocation, indexLocation, jobs);
+    for (RecordingJob& job : jobs)
+    {
+        job.commandList = commandContext->AcquireCommandList();
+    }
 
+    // 区間毎に頂点の書き込みとコマンドの記録を並列に行う
+    // (区間同士で書き込み先が重ならないので、排他制御はいらない)
+    JobSystem::Instance().ParallelFor(numJobs, 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t jobIndex = begin; jobIndex < end; jobIndex++)
+        {
+            RecordingJob& job = jobs[jobIndex];
+            uint32_t jobVertexLocation = job.vertexLocation;
+            uint32_t jobIndexLocation = job.indexLocation;
+            BuildDrawCommands(packets.data() + job.firstPacket, job.packetCount, jobVertexLocation, jobIndexLocation, job.drawCommands);
+            job.commandList->NotifyUpload((uint64_t)(jobVertexLocation - job.vertexLocation) * sizeof(SpriteBatchVertex) + (uint64_t)(jobIndexLocation - job.indexLocation) * sizeof(uint32_t));
+
+            SetupCommandList(job.commandList, commandContext, camera, cameraConstantBuffer);
+            SubmitDrawCommands(job.commandList, job.drawCommands);
+        }
+    });
+
+    // 発行したドローコールを描画順に並べておく
+    for (const RecordingJob& job : jobs)
+    {
+        s_resources->drawCommands.insert(s_resources->drawCommands.end(), job.drawCommands.begin(), job.drawCommands.end());
+    }
 
+    // メインスレッドの記録は、並列記録したコマンドリストの後ろに続ける
+    commandContext->ContinueCommandList();
+}
 
 
+void SpriteRendererBatch::Render(RhiCommandContext* commandContext, const Camera* camera, uint64_t cameraConstantBuffer)
+{
+    s_resources->drawCommands.clear();
 
-    // 不透過スプライトの描画
-    if (!s_resources->opaqueGeometries.empty())
+    // フレームが切り替わったら、1フレームで使える量を数え直す
+    if ((s_resources->currentCommandContext != commandContext) || (s_resources->currentFrameNumber != commandContext->GetFrameNumber()))
     {
-        SortOpaqueGeometry();
-        RenderOpaqueGeometry();
+        s_resources->currentCommandContext = commandContext;
+        s_resources->currentFrameNumber = commandContext->GetFrameNumber();
+        s_resources->frameVertexCount = 0;
+        s_resources->frameIndexCount = 0;
     }
 
-    // 透過スプライトの描画
-    if (!s_resources->transparentGeometries.empty())
+    SortGeometry(camera);
+
+    const std::vector<RenderQueue::Packet>& packets = s_resources->renderQueue.GetPackets();
+    uint32_t count = (uint32_t)packets.size();
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    for (const SpriteBatchItem& item : s_resources->geometries)
     {
-        SortTransparentGeometry();
-        RenderTransparentGeometry();
+        vertexCount += item.vertexCount;
+        indexCount += item.indexCount;
     }
-}
 
+    // 全てのスプライトを連続した領域に書き込む。確保できない場合は、収まるまで描画順の後ろから諦める
+    uint32_t vertexLocation = 0;
+    uint32_t indexLocation = 0;
+    while ((count > 0) && !AllocateRingBuffer(vertexCount, indexCount, vertexLocation, indexLocation))
+    {
+        if (!s_resources->hasReportedOverflow)
+        {
+            printf("[警告] スプライトバッチのリングバッファが足りないので、一部のスプライトを描画しません\n");
+            s_resources->hasReportedOverflow = true;
+        }
+        count--;
+        const SpriteBatchItem& item = s_resources->geometries[packets[count].payload];
+        vertexCount -= item.vertexCount;
+        indexCount -= item.indexCount;
+    }
 
-void SpriteRendererBatch::Push(SpriteRenderer* spriteRenderer)
-{
-    const Material* material = spriteRenderer->GetMaterial();
-
-    // 不透過
-    if (true /*material->GetRenderingMode() == RenderingMode::Opaque*/)
+    // スプライトが十分に多い場合だけ並列に記録する
+    // (コマンドリストを増やすとキューに送る数も増えるので、少ない場合はメインスレッドのコマンドリストにそのまま積む)
+    const uint32_t numJobs = SpriteBatchBuilder::ComputeNumRecordingJobs(count, JobSystem::Instance().GetNumThreads());
+    if (numJobs >= 2)
     {
-        s_resources->opaqueGeometries.push_back(spriteRenderer);
+        RecordInParallel(commandContext, camera, cameraConstantBuffer, count, numJobs, vertexLocation, indexLocation);
     }
     else
     {
-        s_resources->transparentGeometries.push_back(spriteRenderer);
+        RhiCommandList* commandList = commandContext->GetCommandList();
+        BuildDrawCommands(packets.data(), count, vertexLocation, indexLocation, s_resources->drawCommands);
+        commandList->NotifyUpload((uint64_t)vertexCount * sizeof(SpriteBatchVertex) + (uint64_t)indexCount * sizeof(uint32_t));
+        SubmitDrawCommands(commandList, s_resources->drawCommands);
     }
+
+    s_resources->geometries.clear();
 }
 
 
-void SpriteRendererBatch::UnloadAssets()
+void SpriteRendererBatch::Push(SpriteRenderer* spriteRenderer)
 {
+    // テクスチャが無いスプライトは描画できない
+    Texture2D* texture = spriteRenderer->GetSprite()->GetTexture();
+    if (!texture)
+    {
+        return;
+    }
 
-
-
-
-
+    // マテリアルが設定されていない場合は半透明として扱う
+    const Material* material = spriteRenderer->GetMaterial();
+    const Sprite* sprite = spriteRenderer->GetSprite();
+
+    // 描画に必要な値はここで取り出しておく
+    // (変換行列もメインスレッドでコピーしておくので、並列記録するワーカーはレンダラーに触れない)
+    SpriteBatchItem item;
+    const XMFLOAT4X4 localToWorld = spriteRenderer->GetTransform()->GetLocalToWorldMatrix();
+    memcpy(item.localToWorld, localToWorld.m, sizeof(item.localToWorld));
+    const Vector3& center = spriteRenderer->GetBounds().center;
+    item.boundsCenter[0] = center.x;
+    item.boundsCenter[1] = center.y;
+    item.boundsCenter[2] = center.z;
+    item.vertices = (const float*)sprite->GetVertices().data();
+    item.texcoords = (const float*)sprite->GetUV().data();
+    item.triangles = sprite->GetTriangles().data();
+    item.vertexCount = (uint32_t)sprite->GetVertices().size();
+    item.indexCount = (uint32_t)sprite->GetTriangles().size();
+    memcpy(item.color, spriteRenderer->GetColor().components, sizeof(item.color));
+    item.sortingLayer = spriteRenderer->GetSortingLayerID();
+    item.sortingOrder = spriteRenderer->GetSortingOrder();
+    item.isTransparent = !material || (material->GetRenderingMode() != RenderingMode::Opaque);
+    item.pipelineIndex = !item.isTransparent ? OpaquePipeline : texture->IsPremultipliedAlpha() ? PremultipliedPipeline : TransparentPipeline;
+    item.textureIndex = texture->GetDescriptorIndex();
+    s_resources->geometries.push_back(item);
 }
 
 
+void SpriteRendererBatch::UnloadAssets()
+{
+    assert(s_resources);
+    s_resources->vertexBuffer->Unmap();
+    s_resources->indexBuffer->Unmap();
+    s_resources->vertexBuffer->Release();
+    s_resources->indexBuffer->Release();
+    s_resources->premultipliedPipelineState->Release();
+    s_resources->transparentPipelineState->Release();
+    s_resources->opaquePipelineState->Release();
+    s_resources->rootSignature->Release();
+    s_resources->vertexShader->Release();
+    s_resources->pixelShader->Release();
+    s_resources->premultipliedPixelShader->Release();
+    delete s_resources;
+    s_resources = nullptr;
+}
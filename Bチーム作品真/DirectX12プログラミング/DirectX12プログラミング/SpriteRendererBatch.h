@@ -1,47 +1,133 @@
 ﻿#pragma once
-#include "Object.h"
+#include <d3d12.h>
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+#include "RenderQueue.h"
+#include "Rhi.h"
+#include "SpriteBatchBuilder.h"
 
+// 前方宣言
+class Camera;
+class SpriteRenderer;
+class VertexBuffer;
+class IndexBuffer;
+class ShaderBytecode;
+class Texture2D;
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // スプライトの一括描画
 //
-//   ・現在このクラスは実装途中です。
-//   ・現在このクラスは使用できません。
+//   ・カメラに映っているスプライトレンダラーを集めて、少ないドローコールでまとめて描画するクラス。
+//   ・スプライトの頂点はCPUでワールド空間に変換し、フレーム毎に書き換える頂点リングバッファに書き込む。
+//   ・並べ替えとドローコールの組み立ては SpriteBatchBuilder に任せ、このクラスはGPUのバッファとパイプラインステートを管理する。
+//   ・描画順はレンダーキューのソートキー(ソーティングレイヤー → レイヤー内の順序 → 不透明/半透明 → 深度とステート)で決まる。
+//     (半透明のスプライトはステートで並べ替えず、深度が等しければ階層順のまま描画するので、2Dゲームの重なり順は変わらない)
+//   ・テクスチャは共有ディスクリプタヒープの番号を頂点に持たせてシェーダーで選ぶ(バインドレス)ので、
+//     並べ替えた結果、同じパイプラインステートが連続するスプライトはテクスチャが違っても1回のドローコールにまとめる。
+//   ・スプライトが多い場合は、並べ替え済みの描画順を連続した区間に分け、区間毎に別のコマンドリストへ並列に記録する。
+//     コマンドリストは区間の順番にキューに送るので、ワーカーの数や完了順に関係なく描画結果は同じになる。
+//   ・モノステートパターンで実装されている(全てのメンバがstatic)。
 // 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 class SpriteRendererBatch
 {
+public:
+    static constexpr uint32_t DefaultMaxVerticesPerFrame = 65536;               // 既定の、1フレームで書き込める頂点数 (四角形16384個分)
+
+    // 1回のドローコールで描画するスプライトのまとまり
+    using DrawCommand = SpriteBatchDrawCommand;
+
 private:
-    struct ConstantBufferForSprite;
-    struct ConstantBufferForCamera;
-    struct SpriteVertex;
+    // パイプラインステートの番号 (ソートキーに格納される)
+    enum PipelineIndex
+    {
+        OpaquePipeline,
+        TransparentPipeline,
+        PremultipliedPipeline,
+        NumPipelines,
+    };
+
+    // 別のコマンドリストに記録する描画順の区間
+    using RecordingJob = SpriteBatchRecordingJob;
 
     struct Resources
     {
-        std::vector<SpriteRenderer*> opaqueGeometries;
-        std::vector<SpriteRenderer*> transparentGeometries;
-        VertexBuffer* vertexBufer;
-        ShaderBytecode* vertexShader;
-        ShaderBytecode* pixelShader;
-        ID3D12PipelineState* pipelineState;
-        ID3D12RootSignature* rootSignature;
-        ConstantBuffer* constantBufferForSprite;
-        ConstantBuffer* constantBufferForCamera;
+        std::vector<SpriteBatchItem> geometries;        // 描画待ちのスプライト (Push()した順番)
+        RenderQueue renderQueue;                        // 描画待ちのスプライトを並べ替えるレンダーキュー
+        std::vector<DrawCommand> drawCommands;          // 直前の Render() で発行したドローコール
+        std::vector<RecordingJob> recordingJobs;        // 並列記録する区間
+        VertexBuffer* vertexBuffer;                     // 頂点リングバッファ (アップロードヒープ上)
+        IndexBuffer* indexBuffer;                       // インデックスリングバッファ (アップロードヒープ上)
+        SpriteBatchVertex* mappedVertices;              // 頂点リングバッファへの書き込み用アドレス (マップしたまま使う)
+        uint32_t* mappedIndices;                        // インデックスリングバッファへの書き込み用アドレス (マップしたまま使う)
+        uint32_t vertexHead;                            // 頂点リングバッファの次の書き込み位置
+        uint32_t indexHead;                             // インデックスリングバッファの次の書き込み位置
+        uint32_t maxVerticesPerFrame;                   // 1フレームで書き込める頂点数
+        uint32_t maxIndicesPerFrame;                    // 1フレームで書き込めるインデックス数 (四角形なら頂点4個につき6個)
+        uint32_t ringBufferVertexCount;                 // 頂点リングバッファの頂点数 (全てのフレームリソース分)
+        uint32_t ringBufferIndexCount;                  // インデックスリングバッファのインデックス数 (全てのフレームリソース分)
+        uint32_t frameVertexCount;                      // 現在のフレームで使用した頂点数 (折り返しで飛ばした分を含む)
+        uint32_t frameIndexCount;                       // 現在のフレームで使用したインデックス数 (折り返しで飛ばした分を含む)
+        const RhiCommandContext* currentCommandContext; // 現在のフレームのコマンドコンテキスト (フレームの切り替わりの検出用)
+        uint64_t currentFrameNumber;                    // 現在のフレームの通し番号 (フレームの切り替わりの検出用)
+        ShaderBytecode* vertexShader;                   // 頂点シェーダー
+        ShaderBytecode* pixelShader;                    // ピクセルシェーダー
+        ShaderBytecode* premultipliedPixelShader;       // 乗算済みアルファのテクスチャ用のピクセルシェーダー
+        ID3D12RootSignature* rootSignature;             // ルートシグネチャ (パイプラインステートの作成にのみ使う)
+        ID3D12PipelineState* opaquePipelineState;       // 不透明なスプライト用のパイプラインステート
+        ID3D12PipelineState* transparentPipelineState;  // 半透明なスプライト用のパイプラインステート
+        ID3D12PipelineState* premultipliedPipelineState;    // 乗算済みアルファのテクスチャを使う半透明なスプライト用のパイプラインステート
+        bool hasReportedOverflow;                       // リングバッファが溢れたことを報告済みの場合は true
     };
     static Resources* s_resources;
 
-
 private:
-    static void CreateCommandListBundle();
-    static void CreateDescriptorHeap();
-    static void SortOpaqueGeometry();
-    static void SortTransparentGeometry();
-    static void RenderOpaqueGeometry();
-    static void RenderTransparentGeometry();
+    // 描画待ちのスプライトのソートキーを作成し、レンダーキューで並べ替えます。
+    static void SortGeometry(const Camera* camera);
+
+    // 並べ替え済みのスプライトの頂点とインデックスをリングバッファに書き込み、ドローコールのリストに追加します。
+    //   ・別々の区間であれば、複数のスレッドから同時に呼び出せます。
+    static void BuildDrawCommands(const RenderQueue::Packet* packets, uint32_t count, uint32_t& vertexLocation, uint32_t& indexLocation, std::vector<DrawCommand>& drawCommands);
+
+    // 頂点リングバッファとインデックスリングバッファから、連続した領域を確保します。
+    //   ・現在のフレームで使える残りの領域が足りない場合は false を返します。
+    static bool AllocateRingBuffer(uint32_t vertexCount, uint32_t indexCount, uint32_t& vertexLocation, uint32_t& indexLocation);
+
+    // 発行するドローコールのリストをコマンドリストに積みます。
+    static void SubmitDrawCommands(RhiCommandList* commandList, const std::vector<DrawCommand>& drawCommands);
+
+    // 新しく記録を始めたコマンドリストに、カメラの描画に必要なステートを設定します。
+    static void SetupCommandList(RhiCommandList* commandList, const RhiCommandContext* commandContext, const Camera* camera, uint64_t cameraConstantBuffer);
+
+    // 並べ替え済みの描画順を区間に分け、区間毎に別のコマンドリストへ並列に記録します。
+    //   ・メインスレッドのコマンドリストは、記録したコマンドリストの後ろに続く新しいものに切り替わります。
+    static void RecordInParallel(RhiCommandContext* commandContext, const Camera* camera, uint64_t cameraConstantBuffer, uint32_t count, uint32_t numJobs, uint32_t vertexLocation, uint32_t indexLocation);
 
 public:
-    static void LoadAssets();
+    // スプライトバッチで使用するシェーダーやバッファを作成します。
+    //   ・1フレームで書き込める頂点数を超えた分のスプライトは描画されません。 (描画順の後ろから諦めます)
+    //      第1引数 : [in] 1フレームで書き込める頂点数 (リングバッファはこの全てのフレームリソース分の大きさになります)
+    static void LoadAssets(uint32_t maxVerticesPerFrame = DefaultMaxVerticesPerFrame);
+
+    // カメラに映っているスプライトレンダラーを描画待ちにします。
+    //   ・マテリアルのレンダリングモードが不透明の場合は不透明、それ以外は半透明として扱います。
     static void Push(SpriteRenderer* spriteRenderer);
-    static void Render();
+
+    // 描画待ちのスプライトを並べ替えて、まとめて描画します。
+    //   ・カメラが全てのレンダラーを Push() し終わった後に呼び出してください。
+    //   ・ルートシグネチャはメインのものと同じ定義なので、カメラの定数バッファ(ルートパラメーター0番)はそのまま使われます。
+    //   ・パイプラインステートはスプライトバッチのものに切り替わったままになります。
+    //   ・共有ディスクリプタヒープは、フレームの先頭で設定済みである必要があります。
+    //   ・並列記録した場合は、メインスレッドのコマンドリストが新しいものに切り替わります。(RhiCommandContext::GetCommandList()で取得し直すこと)
+    //      第1引数 : [in] 描画中のコマンドコンテキスト
+    //      第2引数 : [in] 描画中のカメラ (深度の計算やビューポートの設定に使います)
+    //      第3引数 : [in] ルートパラメーター0番にバインド済みのカメラの定数バッファ
+    static void Render(RhiCommandContext* commandContext, const Camera* camera, uint64_t cameraConstantBuffer);
+
+    // スプライトバッチで使用したシェーダーやバッファを解放します。
     static void UnloadAssets();
+
+    // 直前の Render() で発行したドローコールのリストを取得します。
+    static const std::vector<DrawCommand>& GetDrawCommands() { return s_resources->drawCommands; }
 };
@@ -0,0 +1,106 @@
+﻿#include "StagingRing.h"
+#include <cassert>
+
+
+StagingRing::StagingRing(uint64_t capacity)
+    : m_capacity(capacity)
+    , m_head(0)
+    , m_tail(0)
+    , m_usedBytes(0)
+    , m_unsubmittedBytes(0)
+    , m_peakUsedBytes(0)
+{
+    assert(capacity > 0);
+}
+
+
+bool StagingRing::Allocate(uint64_t size, uint64_t alignment, uint64_t* offset)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    assert(offset);
+
+    if (size == 0 || size > m_capacity)
+    {
+        return false;
+    }
+
+    // 全て返却済みなら先頭から使い直す (末尾を捨てずに済む)
+    if (m_usedBytes == 0)
+    {
+        m_head = 0;
+        m_tail = 0;
+    }
+
+    const uint64_t start = (m_head + alignment - 1) & ~(alignment - 1);
+    uint64_t newHead;
+    uint64_t consumedBytes;
+    if (m_head >= m_tail && m_usedBytes < m_capacity)
+    {
+        // 使用中の領域より後ろ(バッファの末尾まで)に収まるか？
+        if (start + size <= m_capacity)
+        {
+            newHead = start + size;
+            consumedBytes = newHead - m_head;
+            *offset = start;
+        }
+        // 末尾の残りを捨てて、先頭から使用中の領域の手前までに収まるか？
+        else if (size <= m_tail)
+        {
+            newHead = size;
+            consumedBytes = (m_capacity - m_head) + size;
+            *offset = 0;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    else
+    {
+        // 先頭に折り返しているので、使用中の領域の手前までに収まるか？
+        if (m_head < m_tail && start + size <= m_tail)
+        {
+            newHead = start + size;
+            consumedBytes = newHead - m_head;
+            *offset = start;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    m_head = (newHead == m_capacity) ? 0 : newHead;
+    m_usedBytes += consumedBytes;
+    m_unsubmittedBytes += consumedBytes;
+    if (m_peakUsedBytes < m_usedBytes)
+    {
+        m_peakUsedBytes = m_usedBytes;
+    }
+    return true;
+}
+
+
+void StagingRing::Submit(uint64_t fenceValue)
+{
+    if (m_unsubmittedBytes == 0)
+    {
+        return;
+    }
+    assert(m_submissions.empty() || m_submissions.back().fenceValue <= fenceValue);
+
+    m_submissions.push_back({ fenceValue, m_head, m_unsubmittedBytes });
+    m_unsubmittedBytes = 0;
+}
+
+
+void StagingRing::Retire(uint64_t completedFenceValue)
+{
+    while (!m_submissions.empty() && m_submissions.front().fenceValue <= completedFenceValue)
+    {
+        const Submission& submission = m_submissions.front();
+        m_tail = submission.endOffset;
+        m_usedBytes -= submission.numBytes;
+        m_submissions.pop_front();
+    }
+}
@@ -0,0 +1,64 @@
+﻿#pragma once
+#include <cstdint>
+#include <deque>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ステージングリングクラス
+//
+//      ・アップロード用のバッファ(永続的にマップしたままのバッファ)を、先頭から順番に切り出して使い回すリングアロケーター。
+//      ・切り出した領域は Submit() でフェンス値と組にしておき、GPUがそのフェンス値に到達したら Retire() で古い順に返却する。
+//      ・バッファの末尾に収まらない場合は、末尾の残りを捨てて先頭から切り出す。
+//      ・オフセットを管理するだけで、メモリそのものは持たない。(GPUの無い環境でも動かせる)
+//      ・メインスレッドなど、1つのスレッドからだけ使うこと。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class StagingRing
+{
+private:
+    // 送った領域
+    struct Submission
+    {
+        uint64_t fenceValue;            // 完了を表すフェンス値
+        uint64_t endOffset;             // 送った時点の m_head (ここまでが返却される)
+        uint64_t numBytes;              // 前回の Submit() から使ったバイト数 (捨てた末尾とアラインメントの隙間を含む)
+    };
+
+    uint64_t m_capacity;                // バッファのサイズ (単位はバイト)
+    uint64_t m_head;                    // 次に切り出す位置
+    uint64_t m_tail;                    // 使用中の領域の先頭
+    uint64_t m_usedBytes;               // 使用中のバイト数 (送ってない領域を含む)
+    uint64_t m_unsubmittedBytes;        // 前回の Submit() から使ったバイト数
+    uint64_t m_peakUsedBytes;           // 使用中のバイト数の最大値
+    std::deque<Submission> m_submissions;   // 送った順に並んだ、完了を待っている領域
+
+public:
+    // コンストラクタ
+    //      第1引数 : [in] バッファのサイズ (単位はバイト)
+    explicit StagingRing(uint64_t capacity);
+
+    // 領域を切り出します。
+    //   ・空きが足りない場合は false を返します。 (古い領域が Retire() されるまで待ってから、やり直してください)
+    //      第1引数 : [in] サイズ (単位はバイト)
+    //      第2引数 : [in] アラインメント (2のべき乗)
+    //      第3引数 :[out] バッファの先頭からの位置
+    //       戻り値 :      成否を表すbool型の値
+    bool Allocate(uint64_t size, uint64_t alignment, uint64_t* offset);
+
+    // 前回の Submit() から切り出した領域を、指定したフェンス値の完了後に返却するようにします。
+    void Submit(uint64_t fenceValue);
+
+    // 完了したフェンス値までに送った領域を返却します。
+    void Retire(uint64_t completedFenceValue);
+
+    // バッファのサイズを取得します。
+    uint64_t GetCapacity() const { return m_capacity; }
+
+    // 使用中のバイト数を取得します。
+    uint64_t GetUsedBytes() const { return m_usedBytes; }
+
+    // 使用中のバイト数の最大値を取得します。
+    uint64_t GetPeakUsedBytes() const { return m_peakUsedBytes; }
+
+    // 完了を待っている Submit() の数を取得します。
+    uint32_t GetNumPendingSubmissions() const { return (uint32_t)m_submissions.size(); }
+};
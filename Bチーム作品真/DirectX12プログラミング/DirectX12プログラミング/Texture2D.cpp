@@ -1,235 +1,194 @@
 ﻿#include "Texture2D.h"
 #include "GraphicsEngine.h"
-#include "FrameResources.h"
+#include "AssetCache.h"
+#include "DescriptorAllocator.h"
+#include "TextureStreamer.h"
+#include "AssetArchive.h"
 #include "./External/Include/DirectXTex/DirectXTex.h"
+#include <filesystem>
 
 
-static void MemcpySubresource(const D3D12_MEMCPY_DEST* destination, const D3D12_SUBRESOURCE_DATA* source, size_t rowSizeInBytes, uint32_t numRows, uint32_t numSlices)
+// 静的メンバ変数の実体を宣言
+std::wstring Texture2D::s_cookedDirectory = L"Assets/CookedTextures";
+
+
+Texture2D::Texture2D()
+    : m_format(TextureFormat::RGBA32)
+    , m_nativeTexture(nullptr)
+    , m_descriptorIndex(DescriptorAllocator::InvalidIndex)
+    , m_isReady(false)
+    , m_isCached(false)
+    , m_isPremultipliedAlpha(false)
 {
-    for (uint32_t z = 0; z < numSlices; ++z)
-    {
-        auto destSlice = static_cast<uint8_t*>(destination->pData) + destination->SlicePitch * z;
-        auto srcSlice = static_cast<const uint8_t*>(source->pData) + source->SlicePitch * z;
 
-        for (uint32_t y = 0; y < numRows; ++y)
-        {
-            memcpy(destSlice + destination->RowPitch * y, srcSlice + source->RowPitch * y, rowSizeInBytes);
-        }
-    }
 }
 
 
-static uint64_t UpdateSubresources(
-    ID3D12GraphicsCommandList* commandList,
-    ID3D12Resource* destResource,
-    ID3D12Resource* intermediateResource,
-    uint32_t firstSubresource,
-    uint32_t numSubresources,
-    uint64_t requiredSize,
-    const D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
-    const uint32_t* numRows,
-    const uint64_t* rowSizesInBytes,
-    const D3D12_SUBRESOURCE_DATA* sourceData) noexcept
+Texture2D::~Texture2D()
 {
-    D3D12_RESOURCE_DESC intermediateDesc = intermediateResource->GetDesc();
-    if (intermediateDesc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
-    {
-        printf("[失敗] UpdateSubresources() : 指定された中間バッファは D3D12_RESOURCE_DIMENSION_BUFFER で作成されてません\n");
-        return 0;
-    }
+    if (m_descriptorIndex != DescriptorAllocator::InvalidIndex)
+        GraphicsEngine::Instance().GetDescriptorAllocator()->FreePersistent(m_descriptorIndex);
 
-    if (intermediateDesc.Width < requiredSize + layouts[0].Offset)
-    {
-        printf("[失敗] UpdateSubresources() : 指定された中間バッファは必要サイズを満たしていません\n");
-        return 0;
-    }
+    // GPUが処理中のフレームで使っているかもしれないので、完了を待ってから解放する
+    if (m_nativeTexture)
+        GraphicsEngine::Instance().ReleaseAfterGpuCompletion(m_nativeTexture);
+}
 
-    D3D12_RESOURCE_DESC destinationDesc = destResource->GetDesc();
-    if ((destinationDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) && (firstSubresource != 0 || numSubresources != 1))
-    {
-        printf("[失敗] UpdateSubresources() : 指定された転送先バッファは複数のサブリソースに対応していません\n");
-        return 0;
-    }
 
+Texture2D* Texture2D::FromFile(const wchar_t* textureFilePath)
+{
+    return AssetCache::LoadTexture2D(textureFilePath);
+}
 
-    uint8_t* mappedPointer;
-    if (FAILED(intermediateResource->Map(0, nullptr, (void**)&mappedPointer)))
-    {
-        printf("[失敗] UpdateSubresources() : 指定された中間バッファのマッピングに失敗しました\n");
-        return 0;
-    }
 
-    for (uint32_t i = 0; i < numSubresources; ++i)
-    {
-        if (rowSizesInBytes[i] > SIZE_T(-1))
-            return 0;
-
-        D3D12_MEMCPY_DEST memcpyDest;
-        memcpyDest.pData = mappedPointer + layouts[i].Offset;
-        memcpyDest.RowPitch = layouts[i].Footprint.RowPitch;
-        memcpyDest.SlicePitch = SIZE_T(layouts[i].Footprint.RowPitch) * SIZE_T(numRows[i]);
-        MemcpySubresource(&memcpyDest, &sourceData[i], static_cast<SIZE_T>(rowSizesInBytes[i]), numRows[i], layouts[i].Footprint.Depth);
-    }
-    intermediateResource->Unmap(0, nullptr);
+ULONG __stdcall Texture2D::Release()
+{
+    // 破棄される前に読んでおく
+    const bool isCached = m_isCached;
 
-    if (destinationDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    const ULONG referenceCount = Texture::Release();
+    if (isCached && (referenceCount == 1))
     {
-        commandList->CopyBufferRegion(destResource, 0, intermediateResource, layouts[0].Offset, layouts[0].Footprint.Width);
+        AssetCache::OnTextureUnused(this);
     }
-    else
-    {
-        for (uint32_t i = 0; i < numSubresources; ++i)
-        {
-            // コピー先
-            D3D12_TEXTURE_COPY_LOCATION destCopy;
-            destCopy.pResource = destResource;
-            destCopy.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-            destCopy.SubresourceIndex = i + firstSubresource;
-
-            // コピー元
-            D3D12_TEXTURE_COPY_LOCATION sourceCopy;
-            sourceCopy.pResource = intermediateResource;
-            sourceCopy.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-            sourceCopy.PlacedFootprint = layouts[i];
-
-            // テクスチャ全体をコピー
-            commandList->CopyTextureRegion(&destCopy, 0, 0, 0, &sourceCopy, nullptr);
-        }
-    }
-
-    return requiredSize;
+    return referenceCount;
 }
 
 
-Texture2D::Texture2D()
-    : m_format(TextureFormat::RGBA32)
-    , m_nativeTexture(nullptr)
-    , m_descriptorHeap(nullptr)
+// DXGI_FORMAT からピクセルフォーマットを取得する
+static TextureFormat GetTextureFormat(DXGI_FORMAT format)
 {
+    switch (format)
+    {
+        case DXGI_FORMAT_BC1_UNORM:
+            return TextureFormat::BC1;
+
+        case DXGI_FORMAT_BC3_UNORM:
+            return TextureFormat::BC3;
+
+        case DXGI_FORMAT_BC7_UNORM:
+            return TextureFormat::BC7;
 
+        default:
+            return TextureFormat::RGBA32;
+    }
 }
 
 
-Texture2D::~Texture2D()
+void Texture2D::SetCookedDirectory(const wchar_t* cookedDirectory)
 {
-    if (m_descriptorHeap)
-        m_descriptorHeap->Release();
-
-    if (m_nativeTexture)
-        m_nativeTexture->Release();
+    s_cookedDirectory = cookedDirectory;
 }
 
 
-ID3D12Resource* Texture2D::CreateIntermediateBuffer(ID3D12Device* d3d12Device, uint64_t byteWidth)
+std::wstring Texture2D::MakeCookedFilePath(const wchar_t* textureFilePath)
 {
-    // これから作成するリソースのメモリ種別と書き込み方法に関する詳細情報
-    D3D12_HEAP_PROPERTIES heapProp;
-    memset(&heapProp, 0, sizeof(heapProp));
-    heapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
-    heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-    heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-    heapProp.CreationNodeMask = 1;
-    heapProp.VisibleNodeMask = 1;
-
-    // これから作成するリソースの詳細情報
-    D3D12_RESOURCE_DESC desc;
-    memset(&desc, 0, sizeof(desc));
-    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;   // テクスチャ以外のバッファの場合は D3D12_RESOURCE_DIMENSION_BUFFER を指定する。
-    desc.Alignment = 0;                                 // アラインメント(単位はバイト)
-    desc.Width = byteWidth;                             // リソースのサイズ(単位はバイト)
-    desc.Height = 1;                                    // リソースが2Dまたは3Dテクスチャの場合の「高さ」。(バッファの場合は必ず 1 を指定する)
-    desc.DepthOrArraySize = 1;                          // リソースがテクスチャの場合の「深さ」または「配列の要素数」。(バッファの場合は必ず 1 を指定する)
-    desc.MipLevels = 1;                                 // リソースがテクスチャの場合の「ミップレベル数」。(バッファの場合は必ず 1 を指定する)
-    desc.Format = DXGI_FORMAT_UNKNOWN;                  // リソースがテクスチャの場合の「カラーフォーマット」。(バッファの場合は必ず DXGI_FORMAT_UNKNOWN を指定する)
-    desc.SampleDesc.Count = 1;                          // マルチサンプリング数
-    desc.SampleDesc.Quality = 0;                        // マルチサンプリング品質
-    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;       // D3D12_TEXTURE_LAYOUT_UNKNOWN または D3D12_TEXTURE_LAYOUT_ROW_MAJOR を指定する。
-    desc.Flags = D3D12_RESOURCE_FLAG_NONE;              // その他のフラグ
-
-    ID3D12Resource* intermediate;
-    if (FAILED(d3d12Device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_ID3D12Resource, (void**)&intermediate)))
+    // "Assets/" からの相対パスを、変換済みのテクスチャを置くディレクトリの下に付け替える
+    const std::filesystem::path sourcePath = std::filesystem::path(textureFilePath).lexically_normal();
+    const std::filesystem::path relativePath = sourcePath.lexically_relative(L"Assets");
+    if (relativePath.empty() || (*relativePath.begin() == L"..") || (_wcsicmp(sourcePath.extension().wstring().c_str(), L".dds") == 0))
     {
-        assert(0);
-        return nullptr;
+        return std::wstring();
     }
-
-    return intermediate;
+    return (std::filesystem::path(s_cookedDirectory) / relativePath).replace_extension(L".dds").wstring();
 }
 
 
-Texture2D* Texture2D::FromFile(const wchar_t* textureFilePath, ID3D12GraphicsCommandList* commandList)
+std::wstring Texture2D::FindCookedFile(const wchar_t* textureFilePath)
 {
-    // 画像ファイルフォーマットごとにロードを試みる
-    DirectX::TexMetadata texMetadata;
-    DirectX::ScratchImage scratchImage;
+    const std::wstring cookedPath = MakeCookedFilePath(textureFilePath);
+    if (cookedPath.empty())
+    {
+        return std::wstring();
+    }
 
-    // WIC (Windows Imaging Componentの略)
-    // Windowsで一般的に用いられている画像フォーマット(.bmp  .png  .jpg  .gif  .tiff)
-    if (FAILED(DirectX::LoadFromWICFile(textureFilePath, DirectX::WIC_FLAGS_IGNORE_SRGB, &texMetadata, scratchImage)))
+    // 元の画像ファイルを変換後に書き換えた場合は、古い .dds を使わない (元の画像ファイルが無い場合は .dds を使う)
+    std::error_code errorCode;
+    const std::filesystem::file_time_type cookedTime = std::filesystem::last_write_time(cookedPath, errorCode);
+    if (errorCode)
     {
-        // DirectXの独自形式ファイル (.dds)
-        if (FAILED(DirectX::LoadFromDDSFile(textureFilePath, DirectX::DDS_FLAGS_FORCE_RGB, &texMetadata, scratchImage)))
-        {
-            // TGA形式ファイル (.tga)
-            if (FAILED(DirectX::LoadFromTGAFile(textureFilePath, DirectX::TGA_FLAGS_NONE, &texMetadata, scratchImage)))
-            {
-                // HDR形式ファイル (.hdr)
-                if (FAILED(DirectX::LoadFromHDRFile(textureFilePath, &texMetadata, scratchImage)))
-                {
-                    assert(0);
-                    return nullptr;
-                }
-            }
-        }
+        return std::wstring();
+    }
+    const std::filesystem::file_time_type sourceTime = std::filesystem::last_write_time(textureFilePath, errorCode);
+    if (!errorCode && (sourceTime > cookedTime))
+    {
+        printf("[警告] 変換済みのテクスチャが古いので、元の画像ファイルを読み込みます (%ls)\n", textureFilePath);
+        return std::wstring();
     }
+    return cookedPath;
+}
 
-    // Direct3D12デバイスを取得する
-    ID3D12Device* d3d12Device = GraphicsEngine::Instance().GetD3D12Device();
 
-    // 対象となる画像に合致するテクスチャリソースを作成する
-    ID3D12Resource* d3d12Resource;
-    if (FAILED(DirectX::CreateTextureEx(d3d12Device, texMetadata, D3D12_RESOURCE_FLAG_NONE, false, &d3d12Resource)))
+Texture2D* Texture2D::LoadFromFile(const wchar_t* textureFilePath)
+{
+    // アセットアーカイブの中を、変換済みの .dds → 元の画像ファイルの順に探す
+    // (見つかった場合はファイルを開かず、マップしたメモリからそのまま読む)
+    std::wstring cookedFilePath = MakeCookedFilePath(textureFilePath);
+    std::span<const std::byte> fileData;
+    if (!cookedFilePath.empty())
     {
-        assert(0);
+        fileData = AssetArchive::Find(cookedFilePath.c_str());
+    }
+    if (fileData.empty())
+    {
+        fileData = AssetArchive::Find(textureFilePath);
+        cookedFilePath.clear();
     }
 
-    // 全サブリソース情報を取得する
-    std::vector<D3D12_SUBRESOURCE_DATA> subresources;
-    if (FAILED(DirectX::PrepareUpload(d3d12Device, scratchImage.GetImages(), scratchImage.GetImageCount(), texMetadata, subresources)))
+    // アーカイブに無ければ、変換済みの .dds があれば元の画像ファイルの代わりに読み込む
+    if (fileData.empty())
     {
-        assert(0);
+        cookedFilePath = FindCookedFile(textureFilePath);
     }
+    const wchar_t* loadFilePath = cookedFilePath.empty() ? textureFilePath : cookedFilePath.c_str();
 
-    const D3D12_RESOURCE_DESC destResourceDesc = d3d12Resource->GetDesc();
+    // 画像ファイルのヘッダーだけを読む (デコードはワーカースレッドで行う)
+    DirectX::TexMetadata texMetadata;
+    const bool hasMetadata = fileData.empty() ? TextureStreamer::ReadMetadata(loadFilePath, &texMetadata) : TextureStreamer::ReadMetadata(fileData, &texMetadata);
+    if (!hasMetadata)
+    {
+        printf("[失敗] 画像ファイルの読み込み (%ls)\n", textureFilePath);
+        assert(0);
+        return nullptr;
+    }
 
-    static constexpr UINT MaxSubresources = 128;
+    // Direct3D12デバイスを取得する
+    ID3D12Device* d3d12Device = GraphicsEngine::Instance().GetD3D12Device();
 
-    // 占有領域情報(フットプリント)を取得
-    UINT numRows[MaxSubresources];
-    UINT64 rowSizeInBytes[MaxSubresources];
-    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[MaxSubresources];
-    UINT64 requiredIntermediateBufferSize;
-    d3d12Device->GetCopyableFootprints(&destResourceDesc, 0, (UINT)subresources.size(), 0, layouts, numRows, rowSizeInBytes, &requiredIntermediateBufferSize);
+    // これから作成するリソースのメモリ種別
+    D3D12_HEAP_PROPERTIES heapProp;
+    memset(&heapProp, 0, sizeof(heapProp));
+    heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+    heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heapProp.CreationNodeMask = 1;
+    heapProp.VisibleNodeMask = 1;
 
-    if (!commandList)
+    // 対象となる画像に合致するテクスチャリソースの詳細情報
+    // (TEX_DIMENSION の値は D3D12_RESOURCE_DIMENSION と同じ)
+    D3D12_RESOURCE_DESC destResourceDesc;
+    memset(&destResourceDesc, 0, sizeof(destResourceDesc));
+    destResourceDesc.Dimension = (D3D12_RESOURCE_DIMENSION)texMetadata.dimension;
+    destResourceDesc.Alignment = 0;
+    destResourceDesc.Width = texMetadata.width;
+    destResourceDesc.Height = (UINT)texMetadata.height;
+    destResourceDesc.DepthOrArraySize = (UINT16)((texMetadata.dimension == DirectX::TEX_DIMENSION_TEXTURE3D) ? texMetadata.depth : texMetadata.arraySize);
+    destResourceDesc.MipLevels = (UINT16)texMetadata.mipLevels;
+    destResourceDesc.Format = texMetadata.format;
+    destResourceDesc.SampleDesc.Count = 1;
+    destResourceDesc.SampleDesc.Quality = 0;
+    destResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    destResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    // COMMON 状態で作成しておけば、コピーキューでも描画用のキューでもバリア無しで使える
+    ID3D12Resource* d3d12Resource;
+    if (FAILED(d3d12Device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &destResourceDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_ID3D12Resource, (void**)&d3d12Resource)))
     {
-        commandList = GraphicsEngine::Instance().GetCurrentFrameResources()->GetCommandList();
+        printf("[失敗] テクスチャリソースの作成 (%ls)\n", textureFilePath);
+        assert(0);
+        return nullptr;
     }
 
-    // 中間バッファの作成
-    ID3D12Resource* intermediateBuffer = CreateIntermediateBuffer(d3d12Device, requiredIntermediateBufferSize);
-    UpdateSubresources(commandList, d3d12Resource, intermediateBuffer, 0, (uint32_t)subresources.size(), requiredIntermediateBufferSize, layouts, numRows, rowSizeInBytes, subresources.data());
-
-    D3D12_RESOURCE_BARRIER barrier;
-    memset(&barrier, 0, sizeof(barrier));
-    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    barrier.Transition.pResource = d3d12Resource;
-    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    commandList->ResourceBarrier(1, &barrier);
-
     // シェーダーリソースビュー
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc;
     memset(&srvDesc, 0, sizeof(srvDesc));
@@ -293,33 +252,49 @@ Texture2D* Texture2D::FromFile(const wchar_t* textureFilePath, ID3D12GraphicsCom
             break;
     }
 
-    D3D12_DESCRIPTOR_HEAP_DESC descHeapDesc;
-    memset(&descHeapDesc, 0, sizeof(descHeapDesc));
-    descHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    descHeapDesc.NumDescriptors = 1;
-    descHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    descHeapDesc.NodeMask = 0;
-
-    ID3D12DescriptorHeap* descriptorHeap;
-    if (FAILED(d3d12Device->CreateDescriptorHeap(&descHeapDesc, IID_ID3D12DescriptorHeap, (void**)&descriptorHeap)))
+    // 共有ディスクリプタヒープの永続領域にSRVを作成する
+    DescriptorAllocator* descriptorAllocator = GraphicsEngine::Instance().GetDescriptorAllocator();
+    // (永続領域が一杯ならロードは失敗にする。リリースビルドでもヒープの外にSRVを書き込まないこと)
+    const uint32_t descriptorIndex = descriptorAllocator->AllocatePersistent();
+    if (descriptorIndex == DescriptorAllocator::InvalidIndex)
     {
-        assert(0);
+        printf("[失敗] テクスチャのディスクリプタの確保 (%ls)\n", textureFilePath);
+        d3d12Resource->Release();
+        return nullptr;
     }
-
-    d3d12Device->CreateShaderResourceView(d3d12Resource, &srvDesc, descriptorHeap->GetCPUDescriptorHandleForHeapStart());
+    d3d12Device->CreateShaderResourceView(d3d12Resource, &srvDesc, descriptorAllocator->GetCPUHandle(descriptorIndex));
 
     Texture2D* product = new Texture2D();
     product->m_dimension = TextureDimension::Tex2D;
     product->m_width = (int)destResourceDesc.Width;
     product->m_height = (int)destResourceDesc.Height;
-    product->m_format = TextureFormat::RGBA32;
+    product->m_format = GetTextureFormat(texMetadata.format);
     product->m_filterMode = FilterMode::Point;
     product->m_anisoLevel = 0;
     product->m_isReadable = false;
     product->m_mipMapBias = 0.0f;
     product->m_nativeTexture = d3d12Resource;
-    product->m_descriptorHeap = descriptorHeap;
+    product->m_descriptorIndex = descriptorIndex;
+    product->m_isPremultipliedAlpha = (texMetadata.GetAlphaMode() == DirectX::TEX_ALPHA_MODE_PREMULTIPLIED);
+
+    // アップロードが完了するまでテクスチャを生かしておく (完了の通知はメインスレッドで受け取る)
+    product->AddRef();
+    GraphicsEngine::Instance().GetTextureStreamer()->LoadAsync(loadFilePath, fileData, d3d12Resource, [product](bool succeeded)
+    {
+        product->m_isReady.store(succeeded, std::memory_order_release);
+        product->Release();
+    });
     return product;
 }
 
 
+uint32_t Texture2D::GetDescriptorIndex() const
+{
+    if (!IsReady())
+    {
+        return GraphicsEngine::Instance().GetTextureStreamer()->GetPlaceholderDescriptorIndex();
+    }
+    return m_descriptorIndex;
+}
+
+
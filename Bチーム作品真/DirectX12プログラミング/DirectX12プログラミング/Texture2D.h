@@ -1,16 +1,26 @@
 ﻿#pragma once
 #include "Texture.h"
 #include <d3d12.h>
+#include <cstdint>
+#include <atomic>
+#include <string>
 
 enum class TextureFormat
 {
     RGBA32,
+    BC1,                                        // ブロック圧縮 (4ビット/ピクセル)
+    BC3,                                        // ブロック圧縮 (8ビット/ピクセル。 アルファ付き)
+    BC7,                                        // ブロック圧縮 (8ビット/ピクセル。 高品質)
 };
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // 2Dテクスチャクラス
 // 
 //      ・2D/3Dゲームにおいて最もよく利用されるタイプのテクスチャ。
+//      ・画像のデコードとアップロードはテクスチャストリーマーが非同期に行い、完了するまではプレースホルダーとして描画される。
+//      ・テクスチャクッカー(Tools/TextureCooker)で変換済みの .dds があれば、元の画像ファイルの代わりにそちらを読み込む。
+//        (ブロック圧縮とミップマップが済んでいるので、デコードが要らず、VRAMも小さくなる)
+//      ・アセットアーカイブがマウントされている場合は、個別のファイルより先にアーカイブの中を探す。
 // 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 class Texture2D : public Texture
@@ -18,7 +28,13 @@ class Texture2D : public Texture
 private:
     TextureFormat           m_format;
     ID3D12Resource*         m_nativeTexture;
-    ID3D12DescriptorHeap*   m_descriptorHeap;
+    uint32_t                m_descriptorIndex;  // 共有ディスクリプタヒープ内でのSRVの番号
+    std::atomic<bool>       m_isReady;          // アップロードが完了している場合は true
+    bool                    m_isCached;         // アセットキャッシュに登録されている場合は true
+    bool                    m_isPremultipliedAlpha; // 色にアルファが乗算済みの場合は true
+    friend class AssetCache;                    // AssetCacheクラスは友達
+
+    static std::wstring     s_cookedDirectory;  // 変換済みのテクスチャを置くディレクトリへのパス
 
 protected:
     // コンストラクタ
@@ -27,12 +43,29 @@ protected:
     // 仮想デストラクタ
     virtual ~Texture2D() override;
 
-    // 中間バッファを作成します。
-    static ID3D12Resource* CreateIntermediateBuffer(ID3D12Device* d3d12Device, uint64_t byteWidth);
+    // 画像ファイルのヘッダーからテクスチャを作成し、デコードとアップロードを要求します。 (アセットキャッシュを経由しません)
+    static Texture2D* LoadFromFile(const wchar_t* textureFilePath);
+
+    // 画像ファイルを変換した .dds のパスを作成します。 (ファイルがあるかどうかは調べません。 "Assets/" 以下でない場合は空文字列を返します)
+    static std::wstring MakeCookedFilePath(const wchar_t* textureFilePath);
+
+    // 画像ファイルを変換した .dds のパスを取得します。 (変換済みのファイルが無いか、元の画像ファイルより古い場合は空文字列を返します)
+    static std::wstring FindCookedFile(const wchar_t* textureFilePath);
 
 public:
+    // 変換済みのテクスチャを置くディレクトリを設定します。 (既定値は "Assets/CookedTextures")
+    //   ・"Assets/" 以下の画像ファイルは、このディレクトリ以下の同じ相対パスの .dds に置き換えて読み込みます。
+    static void SetCookedDirectory(const wchar_t* cookedDirectory);
+
     // 画像ファイルをロードしてテクスチャを作成します。
-    static Texture2D* FromFile(const wchar_t* textureFilePath, ID3D12GraphicsCommandList* commandList = nullptr);
+    //   ・同じファイルを既にロード済みの場合は、アセットキャッシュから同じテクスチャを返します。
+    //   ・受け取ったテクスチャが不要になったら Release() してください。
+    //   ・画像のデコードとアップロードは非同期に行われます。 完了するまでは IsReady() が false を返し、透明なプレースホルダーとして描画されます。
+    static Texture2D* FromFile(const wchar_t* textureFilePath);
+
+    // オブジェクトの参照カウントをデクリメント(1だけ減少)します。
+    // アセットキャッシュ以外の参照が無くなった場合は、キャッシュに未使用になったことを通知します。
+    ULONG __stdcall Release() override;
 
     // ピクセルフォーマットを取得します。
     TextureFormat GetFormat() const { return m_format; }
@@ -40,6 +73,14 @@ public:
     // テクスチャリソースへのネイティブポインタを取得します。
     void* GetNativeTexturePtr() const override { return m_nativeTexture; }
 
-    // ディスクリプタヒープを取得します。
-    ID3D12DescriptorHeap* GetDescriptorHeap() const { return m_descriptorHeap; }
+    // 色にアルファが乗算済みの場合は true を返します。 (テクスチャクッカーで premultiplied を指定して変換したテクスチャ)
+    bool IsPremultipliedAlpha() const { return m_isPremultipliedAlpha; }
+
+    // アップロードが完了して、画像が描画できる場合は true を返します。
+    bool IsReady() const { return m_isReady.load(std::memory_order_acquire); }
+
+    // 共有ディスクリプタヒープ内でのSRVの番号を取得します。
+    // (シェーダーのテクスチャ配列の添え字としてそのまま使えます)
+    //   ・アップロードが完了するまでは、プレースホルダーテクスチャのSRVの番号を返します。
+    uint32_t GetDescriptorIndex() const;
 };
@@ -0,0 +1,408 @@
+﻿#include "TextureStreamer.h"
+#include "TextureUploadQueue.h"
+#include "D3D12Rhi.h"
+#include "GraphicsEngine.h"
+#include "DescriptorAllocator.h"
+#include "./External/Include/DirectXTex/DirectXTex.h"
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+
+
+// 画像ファイルのロードに使うフラグ (ヘッダーの読み込みとデコードで同じものを使う)
+static constexpr DirectX::WIC_FLAGS WicFlags = DirectX::WIC_FLAGS_IGNORE_SRGB;
+static constexpr DirectX::DDS_FLAGS DdsFlags = DirectX::DDS_FLAGS_FORCE_RGB;
+static constexpr DirectX::TGA_FLAGS TgaFlags = DirectX::TGA_FLAGS_NONE;
+
+
+// 画像ファイルをデコードする (ファイルフォーマットごとにロードを試みる)
+static bool DecodeImageFile(const wchar_t* textureFilePath, DirectX::TexMetadata* metadata, DirectX::ScratchImage* scratchImage)
+{
+    // DirectXの独自形式ファイル (.dds)
+    // (WIC も .dds を読めるが、ブロック圧縮を展開してミップマップを捨ててしまうので、先に試す)
+    if (SUCCEEDED(DirectX::LoadFromDDSFile(textureFilePath, DdsFlags, metadata, *scratchImage)))
+        return true;
+
+    // WIC (Windows Imaging Componentの略)
+    // Windowsで一般的に用いられている画像フォーマット(.bmp  .png  .jpg  .gif  .tiff)
+    if (SUCCEEDED(DirectX::LoadFromWICFile(textureFilePath, WicFlags, metadata, *scratchImage)))
+        return true;
+
+    // TGA形式ファイル (.tga)
+    if (SUCCEEDED(DirectX::LoadFromTGAFile(textureFilePath, TgaFlags, metadata, *scratchImage)))
+        return true;
+
+    // HDR形式ファイル (.hdr)
+    if (SUCCEEDED(DirectX::LoadFromHDRFile(textureFilePath, metadata, *scratchImage)))
+        return true;
+
+    return false;
+}
+
+
+// メモリ上の画像ファイルの中身をデコードする (DecodeImageFile() と同じ順番でロードを試みる)
+static bool DecodeImageMemory(std::span<const std::byte> fileData, DirectX::TexMetadata* metadata, DirectX::ScratchImage* scratchImage)
+{
+    if (SUCCEEDED(DirectX::LoadFromDDSMemory(fileData.data(), fileData.size(), DdsFlags, metadata, *scratchImage)))
+        return true;
+
+    if (SUCCEEDED(DirectX::LoadFromWICMemory(fileData.data(), fileData.size(), WicFlags, metadata, *scratchImage)))
+        return true;
+
+    if (SUCCEEDED(DirectX::LoadFromTGAMemory(fileData.data(), fileData.size(), TgaFlags, metadata, *scratchImage)))
+        return true;
+
+    if (SUCCEEDED(DirectX::LoadFromHDRMemory(fileData.data(), fileData.size(), metadata, *scratchImage)))
+        return true;
+
+    return false;
+}
+
+
+// DX10拡張ヘッダーを持つ .dds (テクスチャクッカーの出力) は変換が要らないので、サブリソースがファイルの中身を直接指すようにする (コピーしない)
+//   ・ピクセルデータはヘッダーの直後に「配列要素 → ミップレベル」の順で隙間なく並んでいるので、D3D12のサブリソース番号と同じ順番になる。
+static bool MapDdsMemory(std::span<const std::byte> fileData, DirectX::TexMetadata* metadata, std::vector<D3D12_SUBRESOURCE_DATA>& subresources)
+{
+    static constexpr size_t FourCCOffset = 84;                  // マジック(4) + DDS_HEADER 内での ddspf.fourCC の位置(80)
+    static constexpr size_t PixelDataOffset = 4 + 124 + 20;     // マジック + DDS_HEADER + DDS_HEADER_DXT10
+
+    if ((fileData.size() < PixelDataOffset) || (memcmp(fileData.data() + FourCCOffset, "DX10", 4) != 0))
+        return false;
+
+    if (FAILED(DirectX::GetMetadataFromDDSMemory(fileData.data(), fileData.size(), DdsFlags, *metadata)) || (metadata->dimension != DirectX::TEX_DIMENSION_TEXTURE2D))
+        return false;
+
+    const std::byte* pixels = fileData.data() + PixelDataOffset;
+    const std::byte* end = fileData.data() + fileData.size();
+    subresources.clear();
+    for (size_t item = 0; item < metadata->arraySize; item++)
+    {
+        for (size_t mipLevel = 0; mipLevel < metadata->mipLevels; mipLevel++)
+        {
+            size_t rowPitch, slicePitch;
+            const size_t width = (std::max)(metadata->width >> mipLevel, (size_t)1);
+            const size_t height = (std::max)(metadata->height >> mipLevel, (size_t)1);
+            if (FAILED(DirectX::ComputePitch(metadata->format, width, height, rowPitch, slicePitch)) || ((size_t)(end - pixels) < slicePitch))
+                return false;
+
+            subresources.push_back({ pixels, (LONG_PTR)rowPitch, (LONG_PTR)slicePitch });
+            pixels += slicePitch;
+        }
+    }
+    return true;
+}
+
+
+bool TextureStreamer::ReadMetadata(const wchar_t* textureFilePath, DirectX::TexMetadata* metadata)
+{
+    // DecodeImageFile() と同じ順番で、ヘッダーだけを読む
+    if (SUCCEEDED(DirectX::GetMetadataFromDDSFile(textureFilePath, DdsFlags, *metadata)))
+        return true;
+
+    if (SUCCEEDED(DirectX::GetMetadataFromWICFile(textureFilePath, WicFlags, *metadata)))
+        return true;
+
+    if (SUCCEEDED(DirectX::GetMetadataFromTGAFile(textureFilePath, TgaFlags, *metadata)))
+        return true;
+
+    if (SUCCEEDED(DirectX::GetMetadataFromHDRFile(textureFilePath, *metadata)))
+        return true;
+
+    return false;
+}
+
+
+bool TextureStreamer::ReadMetadata(std::span<const std::byte> fileData, DirectX::TexMetadata* metadata)
+{
+    // DecodeImageMemory() と同じ順番で、ヘッダーだけを読む
+    if (SUCCEEDED(DirectX::GetMetadataFromDDSMemory(fileData.data(), fileData.size(), DdsFlags, *metadata)))
+        return true;
+
+    if (SUCCEEDED(DirectX::GetMetadataFromWICMemory(fileData.data(), fileData.size(), WicFlags, *metadata)))
+        return true;
+
+    if (SUCCEEDED(DirectX::GetMetadataFromTGAMemory(fileData.data(), fileData.size(), TgaFlags, *metadata)))
+        return true;
+
+    if (SUCCEEDED(DirectX::GetMetadataFromHDRMemory(fileData.data(), fileData.size(), *metadata)))
+        return true;
+
+    return false;
+}
+
+
+// コピー先のテクスチャに合わせて、アップロードの要求にサブリソースの配置を設定する
+static void SetFootprints(ID3D12Device* d3d12Device, ID3D12Resource* destination, uint32_t numSubresources, TextureUploadRequest* request)
+{
+    const D3D12_RESOURCE_DESC desc = destination->GetDesc();
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(numSubresources);
+    request->numRows.resize(numSubresources);
+    request->rowSizesInBytes.resize(numSubresources);
+    d3d12Device->GetCopyableFootprints(&desc, 0, numSubresources, 0, layouts.data(), request->numRows.data(), request->rowSizesInBytes.data(), &request->totalBytes);
+
+    request->footprints.resize(numSubresources);
+    for (uint32_t i = 0; i < numSubresources; i++)
+    {
+        RhiPlacedFootprint& footprint = request->footprints[i];
+        footprint.offset = layouts[i].Offset;
+        footprint.format = (uint32_t)layouts[i].Footprint.Format;
+        footprint.width = layouts[i].Footprint.Width;
+        footprint.height = layouts[i].Footprint.Height;
+        footprint.depth = layouts[i].Footprint.Depth;
+        footprint.rowPitch = layouts[i].Footprint.RowPitch;
+    }
+}
+
+
+TextureStreamer::TextureStreamer(ID3D12Device* d3d12Device, uint64_t stagingBufferSize)
+    : m_d3d12Device(d3d12Device)
+    , m_copyQueue(nullptr)
+    , m_stagingBuffer(nullptr)
+    , m_stagingMemory(nullptr)
+    , m_stagingBufferSize(stagingBufferSize)
+    , m_uploadQueue(nullptr)
+    , m_placeholderTexture(nullptr)
+    , m_placeholderDescriptorIndex(DescriptorAllocator::InvalidIndex)
+{
+    m_copyQueue = new D3D12RhiCopyQueue(d3d12Device);
+
+    // ステージングバッファ (アップロードヒープ)
+    D3D12_HEAP_PROPERTIES heapProp;
+    memset(&heapProp, 0, sizeof(heapProp));
+    heapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+    heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heapProp.CreationNodeMask = 1;
+    heapProp.VisibleNodeMask = 1;
+
+    D3D12_RESOURCE_DESC desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    desc.Alignment = 0;
+    desc.Width = stagingBufferSize;
+    desc.Height = 1;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_UNKNOWN;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    if (FAILED(d3d12Device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_ID3D12Resource, (void**)&m_stagingBuffer)))
+    {
+        printf("[失敗] テクスチャのステージングバッファの作成\n");
+        assert(0);
+    }
+
+    // CPUは書き込むだけなので、読み込む範囲は空にしておく (アプリケーションの終了までマップしたままにする)
+    const D3D12_RANGE readRange = { 0, 0 };
+    if (FAILED(m_stagingBuffer->Map(0, &readRange, &m_stagingMemory)))
+    {
+        printf("[失敗] テクスチャのステージングバッファのマップ\n");
+        assert(0);
+    }
+
+    m_uploadQueue = new TextureUploadQueue(m_copyQueue, ToRhi(m_stagingBuffer), m_stagingMemory, stagingBufferSize);
+    CreatePlaceholderTexture();
+}
+
+
+TextureStreamer::~TextureStreamer()
+{
+    WaitForAll();
+    delete m_uploadQueue;
+
+    // コピーキューはGPU処理の完了を待ってから解放されるので、その後ならステージングバッファを解放できる
+    delete m_copyQueue;
+    m_stagingBuffer->Unmap(0, nullptr);
+    m_stagingBuffer->Release();
+
+    // プレースホルダーテクスチャは描画に使っているかもしれないので、完了を待ってから解放する
+    GraphicsEngine::Instance().GetDescriptorAllocator()->FreePersistent(m_placeholderDescriptorIndex);
+    GraphicsEngine::Instance().ReleaseAfterGpuCompletion(m_placeholderTexture);
+}
+
+
+void TextureStreamer::CreatePlaceholderTexture()
+{
+    D3D12_HEAP_PROPERTIES heapProp;
+    memset(&heapProp, 0, sizeof(heapProp));
+    heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+    heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heapProp.CreationNodeMask = 1;
+    heapProp.VisibleNodeMask = 1;
+
+    // 1x1の透明なテクスチャ
+    D3D12_RESOURCE_DESC desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Alignment = 0;
+    desc.Width = 1;
+    desc.Height = 1;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    if (FAILED(m_d3d12Device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_ID3D12Resource, (void**)&m_placeholderTexture)))
+    {
+        printf("[失敗] プレースホルダーテクスチャの作成\n");
+        assert(0);
+    }
+
+    // 共有ディスクリプタヒープの永続領域にSRVを作成する
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    memset(&srvDesc, 0, sizeof(srvDesc));
+    srvDesc.Format = desc.Format;
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MostDetailedMip = 0;
+    srvDesc.Texture2D.MipLevels = 1;
+    srvDesc.Texture2D.PlaneSlice = 0;
+    srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+
+    DescriptorAllocator* descriptorAllocator = GraphicsEngine::Instance().GetDescriptorAllocator();
+    m_placeholderDescriptorIndex = descriptorAllocator->AllocatePersistent();
+    if (m_placeholderDescriptorIndex == DescriptorAllocator::InvalidIndex)
+    {
+        printf("[失敗] プレースホルダーテクスチャのディスクリプタの確保\n");
+        assert(0);
+        return;
+    }
+    m_d3d12Device->CreateShaderResourceView(m_placeholderTexture, &srvDesc, descriptorAllocator->GetCPUHandle(m_placeholderDescriptorIndex));
+
+    // 他のテクスチャと同じ経路でアップロードして、完了を待つ
+    static const uint32_t TransparentPixel = 0x00000000;
+    TextureUploadRequest request;
+    request.destination = ToRhi(m_placeholderTexture);
+    SetFootprints(m_d3d12Device, m_placeholderTexture, 1, &request);
+    request.subresources.push_back({ &TransparentPixel, sizeof(TransparentPixel), sizeof(TransparentPixel) });
+    m_uploadQueue->Enqueue(std::move(request));
+    m_uploadQueue->WaitForAll();
+}
+
+
+void TextureStreamer::ExecuteDecodeJob(void* userData, uint32_t begin, uint32_t end)
+{
+    DecodeJob* job = (DecodeJob*)userData;
+
+    TextureUploadRequest request;
+    request.destination = ToRhi(job->destination);
+    request.totalBytes = 0;
+    request.onCompleted = std::move(job->onCompleted);
+
+    // ピクセルデータはステージングバッファに書き込むまで、アップロードの要求に持たせておく
+    // (ファイルの中身を直接指す場合は、アセットアーカイブが持っているので要らない)
+    std::shared_ptr<DirectX::ScratchImage> scratchImage;
+    DirectX::TexMetadata metadata;
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+    bool decoded = !job->fileData.empty() && MapDdsMemory(job->fileData, &metadata, subresources);
+    if (!decoded)
+    {
+        scratchImage = std::make_shared<DirectX::ScratchImage>();
+        decoded = (job->fileData.empty() ? DecodeImageFile(job->textureFilePath.c_str(), &metadata, scratchImage.get()) : DecodeImageMemory(job->fileData, &metadata, scratchImage.get()))
+            && SUCCEEDED(DirectX::PrepareUpload(job->streamer->m_d3d12Device, scratchImage->GetImages(), scratchImage->GetImageCount(), metadata, subresources));
+    }
+    if (decoded)
+    {
+        // ヘッダーから作成したテクスチャと、デコードした結果が食い違っていないか確かめる
+        const D3D12_RESOURCE_DESC desc = job->destination->GetDesc();
+        if ((desc.Width == metadata.width) && (desc.Height == metadata.height) && (desc.Format == metadata.format) && (desc.MipLevels == metadata.mipLevels))
+        {
+            SetFootprints(job->streamer->m_d3d12Device, job->destination, (uint32_t)subresources.size(), &request);
+            for (const D3D12_SUBRESOURCE_DATA& subresource : subresources)
+            {
+                request.subresources.push_back({ subresource.pData, (uint64_t)subresource.RowPitch, (uint64_t)subresource.SlicePitch });
+            }
+            request.sourceOwner = scratchImage;
+        }
+    }
+
+    // 失敗した場合もピクセルデータが空の要求を追加して、メインスレッドに通知してもらう
+    if (request.subresources.empty())
+    {
+        printf("[失敗] テクスチャのデコード (%ls)\n", job->textureFilePath.c_str());
+    }
+    job->streamer->m_uploadQueue->Enqueue(std::move(request));
+    delete job;
+}
+
+
+void TextureStreamer::LoadAsync(const wchar_t* textureFilePath, std::span<const std::byte> fileData, ID3D12Resource* destination, std::function<void(bool)>&& onCompleted)
+{
+    DecodeJob* job = new DecodeJob();
+    job->streamer = this;
+    job->textureFilePath = textureFilePath;
+    job->fileData = fileData;
+    job->destination = destination;
+    job->onCompleted = std::move(onCompleted);
+
+    const JobHandle handle = JobSystem::Instance().Schedule(ExecuteDecodeJob, job);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_decodeJobHandles.push_back(handle);
+}
+
+
+void TextureStreamer::Update()
+{
+    // 完了したデコードジョブのハンドルを取り除く
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        JobSystem& jobSystem = JobSystem::Instance();
+        size_t numRunningJobs = 0;
+        for (const JobHandle& handle : m_decodeJobHandles)
+        {
+            if (!jobSystem.IsCompleted(handle))
+            {
+                m_decodeJobHandles[numRunningJobs++] = handle;
+            }
+        }
+        m_decodeJobHandles.resize(numRunningJobs);
+    }
+
+    m_uploadQueue->Update();
+}
+
+
+void TextureStreamer::WaitForAll()
+{
+    // 待っている間に他のスレッドが追加したデコードジョブも待つ
+    for (;;)
+    {
+        std::vector<JobHandle> handles;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            handles.swap(m_decodeJobHandles);
+        }
+        if (handles.empty())
+        {
+            break;
+        }
+
+        for (const JobHandle& handle : handles)
+        {
+            JobSystem::Instance().Wait(handle);
+        }
+    }
+
+    // デコードが済んだ要求を全てアップロードして、完了を通知する
+    m_uploadQueue->WaitForAll();
+}
+
+
+void TextureStreamer::PrintStats() const
+{
+    const TextureUploadQueueStats& stats = m_uploadQueue->GetStats();
+    printf("[情報] テクスチャストリーマー : 完了 %u 枚 / 失敗 %u 枚 / コピーキューへの送信 %u 回 / アップロード %.2f MB\n",
+        stats.completedCount, stats.failedCount, stats.submitCount, stats.uploadedBytes / (1024.0 * 1024.0));
+    printf("[情報] テクスチャストリーマー : ステージングバッファの最大使用量 %.2f / %.2f MB\n",
+        stats.peakStagingBytes / (1024.0 * 1024.0), m_stagingBufferSize / (1024.0 * 1024.0));
+}
@@ -0,0 +1,104 @@
+﻿#pragma once
+#include "JobSystem.h"
+#include <d3d12.h>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+
+// 前方宣言
+namespace DirectX { struct TexMetadata; }
+class D3D12RhiCopyQueue;
+class TextureUploadQueue;
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// テクスチャストリーマークラス
+//
+//      ・画像ファイルのデコードをワーカースレッドで行い、コピーキューでテクスチャにアップロードするクラス。
+//      ・ステージングバッファはアップロードヒープのバッファ1つを永続的にマップしたまま、リングバッファとして使い回す。
+//        (テクスチャ毎に中間バッファを作成しない)
+//      ・コピーは描画用のコマンドリストとは別のコピーキューで行うので、描画を止めない。
+//      ・テクスチャは COMMON 状態で作成しておく。コピーキューで COPY_DEST に暗黙的に昇格し、コピーの完了後に COMMON に戻り、
+//        描画用のキューで PIXEL_SHADER_RESOURCE に暗黙的に昇格するので、リソースバリアは要らない。
+//      ・アップロードが完了するまでは、1x1の透明なプレースホルダーテクスチャを代わりに使う。
+//      ・アセットアーカイブ内のファイルはマップしたメモリからデコードする。 DX10拡張ヘッダーを持つ .dds はデコードも要らないので、
+//        マップしたメモリからステージングバッファに直接書き込む。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class TextureStreamer
+{
+public:
+    static constexpr uint64_t DefaultStagingBufferSize = 32 * 1024 * 1024;    // 既定のステージングバッファのサイズ
+
+private:
+    // デコードジョブに渡すデータ
+    struct DecodeJob
+    {
+        TextureStreamer* streamer;                  // 要求を追加するストリーマー
+        std::wstring textureFilePath;               // 画像ファイルのパス
+        std::span<const std::byte> fileData;        // 画像ファイルの中身 (空の場合は textureFilePath から読み込む)
+        ID3D12Resource* destination;                // コピー先のテクスチャ
+        std::function<void(bool)> onCompleted;      // 完了時にメインスレッドから呼ばれる関数
+    };
+
+    ID3D12Device* m_d3d12Device;                    // D3D12デバイス
+    D3D12RhiCopyQueue* m_copyQueue;                 // コピーキュー
+    ID3D12Resource* m_stagingBuffer;                // ステージングバッファ (アップロードヒープ)
+    void* m_stagingMemory;                          // ステージングバッファをマップしたアドレス
+    uint64_t m_stagingBufferSize;                   // ステージングバッファのサイズ (単位はバイト)
+    TextureUploadQueue* m_uploadQueue;              // アップロードの順番待ちと完了の通知
+    ID3D12Resource* m_placeholderTexture;           // プレースホルダーテクスチャ
+    uint32_t m_placeholderDescriptorIndex;          // プレースホルダーテクスチャのSRVの番号
+    std::vector<JobHandle> m_decodeJobHandles;      // 完了していないデコードジョブ
+    std::mutex m_mutex;                             // m_decodeJobHandles を保護する
+
+private:
+    // デコードジョブのジョブ関数です。
+    static void ExecuteDecodeJob(void* userData, uint32_t begin, uint32_t end);
+
+    // プレースホルダーテクスチャを作成し、アップロードの完了を待ちます。
+    void CreatePlaceholderTexture();
+
+public:
+    // コンストラクタ
+    //      第1引数 : [in] D3D12デバイス
+    //      第2引数 : [in] ステージングバッファのサイズ (単位はバイト。 これより大きいテクスチャは、行のまとまりに分けて複数フレームでアップロードします)
+    TextureStreamer(ID3D12Device* d3d12Device, uint64_t stagingBufferSize = DefaultStagingBufferSize);
+
+    // デストラクタ
+    ~TextureStreamer();
+
+    // コピーは禁止
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // 画像ファイルのヘッダーだけを読んで、テクスチャの情報を取得します。
+    //       戻り値 : 成否を表すbool型の値
+    static bool ReadMetadata(const wchar_t* textureFilePath, DirectX::TexMetadata* metadata);
+
+    // メモリ上の画像ファイルの中身から、ヘッダーだけを読んでテクスチャの情報を取得します。
+    //       戻り値 : 成否を表すbool型の値
+    static bool ReadMetadata(std::span<const std::byte> fileData, DirectX::TexMetadata* metadata);
+
+    // ワーカースレッドで画像ファイルをデコードして、テクスチャにアップロードします。
+    //   ・テクスチャは COMMON 状態で作成し、完了の通知を受けるまで解放しないでください。
+    //   ・完了の通知(引数は成否)は、コピーの完了後に Update() の中からメインスレッドで呼ばれます。
+    //   ・fileData が空でない場合はファイルを開かずにそのメモリからデコードします。 (textureFilePath はログにのみ使います)
+    //     メモリはアップロードが完了するまで有効にしておいてください。 (アセットアーカイブのメモリを想定しています)
+    void LoadAsync(const wchar_t* textureFilePath, std::span<const std::byte> fileData, ID3D12Resource* destination, std::function<void(bool)>&& onCompleted);
+
+    // 完了したアップロードを通知し、デコードが終わったテクスチャをコピーキューに送ります。 (メインスレッドから毎フレーム呼び出してください)
+    void Update();
+
+    // 全てのデコードとアップロードが完了するまで待機します。 (メインスレッドから呼び出してください)
+    void WaitForAll();
+
+    // プレースホルダーテクスチャのSRVの番号を取得します。
+    uint32_t GetPlaceholderDescriptorIndex() const { return m_placeholderDescriptorIndex; }
+
+    // 統計情報をコンソールに出力します。
+    void PrintStats() const;
+};
@@ -0,0 +1,288 @@
+﻿#include "TextureUploadQueue.h"
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+
+// 要求を行のまとまりに分けて書き込めるかどうかを調べます。
+//   ・深さのあるサブリソース(3Dテクスチャ)は、スライスの途中で分けられないので扱いません。
+//   ・1行でもステージングバッファに収まらない場合は、分けても書き込めません。
+static bool CanUploadInRows(const TextureUploadRequest& request, uint64_t stagingCapacity)
+{
+    for (const RhiPlacedFootprint& footprint : request.footprints)
+    {
+        if (footprint.depth != 1 || footprint.rowPitch > stagingCapacity)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+TextureUploadQueue::TextureUploadQueue(RhiCopyQueue* copyQueue, RhiResource* stagingBuffer, void* stagingMemory, uint64_t stagingCapacity, uint64_t maxBytesPerUpdate)
+    : m_copyQueue(copyQueue)
+    , m_stagingBuffer(stagingBuffer)
+    , m_stagingMemory((uint8_t*)stagingMemory)
+    , m_stagingRing(stagingCapacity)
+    , m_maxBytesPerUpdate(maxBytesPerUpdate)
+    , m_lastFenceValue(0)
+{
+    assert(copyQueue);
+    assert(stagingMemory);
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+void TextureUploadQueue::Enqueue(TextureUploadRequest&& request)
+{
+    assert(request.subresources.empty() || request.subresources.size() == request.footprints.size());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pendingRequests.push_back(std::move(request));
+}
+
+
+void TextureUploadQueue::RetireCompletedUploads()
+{
+    const uint64_t completedFenceValue = m_copyQueue->GetTimeline()->GetCompletedValue();
+    m_stagingRing.Retire(completedFenceValue);
+
+    while (!m_inFlightUploads.empty() && m_inFlightUploads.front().fenceValue <= completedFenceValue)
+    {
+        // 通知先が新しい要求を追加するかもしれないので、取り出してから呼び出す
+        std::function<void(bool)> onCompleted = std::move(m_inFlightUploads.front().onCompleted);
+        m_inFlightUploads.pop_front();
+        m_stats.completedCount++;
+        if (onCompleted)
+        {
+            onCompleted(true);
+        }
+    }
+}
+
+
+void TextureUploadQueue::FailFrontUpload()
+{
+    // 通知先が新しい要求を追加するかもしれないので、取り出してから呼び出す
+    std::function<void(bool)> onCompleted = std::move(m_waitingUploads.front().request.onCompleted);
+    m_waitingUploads.pop_front();
+    m_stats.failedCount++;
+    if (onCompleted)
+    {
+        onCompleted(false);
+    }
+}
+
+
+void TextureUploadQueue::RecordUpload(RhiCommandList* commandList, const TextureUploadRequest& request, uint64_t stagingOffset)
+{
+    for (size_t i = 0; i < request.footprints.size(); i++)
+    {
+        const RhiPlacedFootprint& footprint = request.footprints[i];
+        const TextureUploadSubresource& source = request.subresources[i];
+        const uint32_t numRows = request.numRows[i];
+        const size_t rowSizeInBytes = (size_t)request.rowSizesInBytes[i];
+
+        // ステージングバッファの行ピッチ(256バイト境界)に合わせて、1行ずつ書き込む
+        uint8_t* destination = m_stagingMemory + stagingOffset + footprint.offset;
+        for (uint32_t z = 0; z < footprint.depth; z++)
+        {
+            uint8_t* destinationSlice = destination + (uint64_t)footprint.rowPitch * numRows * z;
+            const uint8_t* sourceSlice = (const uint8_t*)source.data + source.slicePitch * z;
+            for (uint32_t y = 0; y < numRows; y++)
+            {
+                memcpy(destinationSlice + (uint64_t)footprint.rowPitch * y, sourceSlice + source.rowPitch * y, rowSizeInBytes);
+            }
+        }
+
+        RhiPlacedFootprint placedFootprint = footprint;
+        placedFootprint.offset += stagingOffset;
+        commandList->CopyBufferToTexture(request.destination, (uint32_t)i, 0, m_stagingBuffer, placedFootprint);
+    }
+
+    commandList->NotifyUpload(request.totalBytes);
+    m_stats.uploadedBytes += request.totalBytes;
+}
+
+
+bool TextureUploadQueue::RecordUploadInRows(RhiCommandList** commandList, WaitingUpload* upload, uint64_t* writtenBytes)
+{
+    const TextureUploadRequest& request = upload->request;
+    while (upload->nextSubresource < request.footprints.size())
+    {
+        const uint32_t i = upload->nextSubresource;
+        const RhiPlacedFootprint& footprint = request.footprints[i];
+        const TextureUploadSubresource& source = request.subresources[i];
+        const uint32_t numRows = request.numRows[i];
+        const size_t rowSizeInBytes = (size_t)request.rowSizesInBytes[i];
+
+        // 1回の転送量の上限までの行を書き込む (この Update() で最初に書き込む場合は、上限が1行より小さくても1行は書き込む)
+        const uint64_t remainingBytes = (*writtenBytes < m_maxBytesPerUpdate) ? m_maxBytesPerUpdate - *writtenBytes : 0;
+        uint32_t rowCount = (uint32_t)std::min<uint64_t>(numRows - upload->nextRow, std::min(remainingBytes, m_stagingRing.GetCapacity()) / footprint.rowPitch);
+        if (rowCount == 0)
+        {
+            if (*writtenBytes > 0)
+            {
+                return false;
+            }
+            rowCount = 1;
+        }
+
+        // ステージングリングの空きが足りなければ、行を減らして空いている分だけ書き込む
+        uint64_t stagingOffset;
+        while (!m_stagingRing.Allocate((uint64_t)footprint.rowPitch * rowCount, FootprintAlignment, &stagingOffset))
+        {
+            rowCount /= 2;
+            if (rowCount == 0)
+            {
+                return false;
+            }
+        }
+
+        if (!*commandList)
+        {
+            *commandList = m_copyQueue->GetCommandList();
+        }
+
+        uint8_t* destination = m_stagingMemory + stagingOffset;
+        const uint8_t* sourceRows = (const uint8_t*)source.data + source.rowPitch * upload->nextRow;
+        for (uint32_t y = 0; y < rowCount; y++)
+        {
+            memcpy(destination + (uint64_t)footprint.rowPitch * y, sourceRows + source.rowPitch * y, rowSizeInBytes);
+        }
+
+        // ブロック圧縮フォーマットは4ピクセルの高さが1行になる (最後のまとまりはテクスチャの下端で止める)
+        const uint32_t pixelsPerRow = (numRows < footprint.height) ? 4 : 1;
+        const uint32_t destinationY = pixelsPerRow * upload->nextRow;
+        RhiPlacedFootprint placedFootprint = footprint;
+        placedFootprint.offset = stagingOffset;
+        placedFootprint.height = std::min(pixelsPerRow * rowCount, footprint.height - destinationY);
+        (*commandList)->CopyBufferToTexture(request.destination, i, destinationY, m_stagingBuffer, placedFootprint);
+
+        const uint64_t numBytes = (uint64_t)footprint.rowPitch * rowCount;
+        (*commandList)->NotifyUpload(numBytes);
+        m_stats.uploadedBytes += numBytes;
+        *writtenBytes += numBytes;
+
+        upload->nextRow += rowCount;
+        if (upload->nextRow == numRows)
+        {
+            upload->nextRow = 0;
+            upload->nextSubresource++;
+        }
+    }
+    return true;
+}
+
+
+void TextureUploadQueue::Update()
+{
+    RetireCompletedUploads();
+
+    // 届いた要求を、メインスレッドだけが触る待ち行列に移す
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (!m_pendingRequests.empty())
+        {
+            m_waitingUploads.push_back({ std::move(m_pendingRequests.front()), 0, 0 });
+            m_pendingRequests.pop_front();
+        }
+    }
+
+    RhiCommandList* commandList = nullptr;
+    const size_t firstRecordedUpload = m_inFlightUploads.size();
+    uint64_t writtenBytes = 0;
+    while (!m_waitingUploads.empty())
+    {
+        WaitingUpload& upload = m_waitingUploads.front();
+        TextureUploadRequest& request = upload.request;
+
+        // デコードに失敗した要求は失敗として完了させる
+        if (request.subresources.empty())
+        {
+            FailFrontUpload();
+            continue;
+        }
+
+        // ステージングバッファに収まらない要求は、行のまとまりに分けて書き込む (書き終わるまで後の要求は待たせる)
+        if (request.totalBytes > m_stagingRing.GetCapacity())
+        {
+            if (!CanUploadInRows(request, m_stagingRing.GetCapacity()))
+            {
+                printf("[失敗] テクスチャのアップロード : ステージングバッファの容量不足で、分けても書き込めない (要求: %llu バイト, 容量: %llu バイト)\n",
+                    (unsigned long long)request.totalBytes, (unsigned long long)m_stagingRing.GetCapacity());
+                FailFrontUpload();
+                continue;
+            }
+            if (!RecordUploadInRows(&commandList, &upload, &writtenBytes))
+            {
+                break;
+            }
+            m_inFlightUploads.push_back({ 0, std::move(request.onCompleted) });
+            m_waitingUploads.pop_front();
+            continue;
+        }
+
+        // 1回の転送量の上限を超える場合は次の Update() に回す (少なくとも1つは書き込む)
+        if (writtenBytes > 0 && writtenBytes + request.totalBytes > m_maxBytesPerUpdate)
+        {
+            break;
+        }
+
+        // ステージングリングに空きが無ければ、送ったコピーが完了するのを待つ (届いた順番は崩さない)
+        uint64_t stagingOffset;
+        if (!m_stagingRing.Allocate(request.totalBytes, FootprintAlignment, &stagingOffset))
+        {
+            break;
+        }
+
+        if (!commandList)
+        {
+            commandList = m_copyQueue->GetCommandList();
+        }
+        RecordUpload(commandList, request, stagingOffset);
+        writtenBytes += request.totalBytes;
+
+        // ピクセルデータはステージングバッファに書き込んだので、ここで手放す
+        m_inFlightUploads.push_back({ 0, std::move(request.onCompleted) });
+        m_waitingUploads.pop_front();
+    }
+
+    if (commandList)
+    {
+        const uint64_t fenceValue = m_copyQueue->Submit();
+        m_stagingRing.Submit(fenceValue);
+        m_lastFenceValue = fenceValue;
+        for (size_t i = firstRecordedUpload; i < m_inFlightUploads.size(); i++)
+        {
+            m_inFlightUploads[i].fenceValue = fenceValue;
+        }
+        m_stats.submitCount++;
+    }
+    m_stats.peakStagingBytes = m_stagingRing.GetPeakUsedBytes();
+}
+
+
+void TextureUploadQueue::WaitForAll()
+{
+    while (HasPendingUploads())
+    {
+        Update();
+
+        // 最後に送ったコピーの完了を待てば、それまでに送った要求も全て完了する
+        // (分けて書き込んでいる途中の要求は、ステージングリングが空くまで次の Update() で書き込めないことがある)
+        if (m_lastFenceValue > 0)
+        {
+            m_copyQueue->GetTimeline()->WaitForValue(m_lastFenceValue);
+        }
+    }
+}
+
+
+bool TextureUploadQueue::HasPendingUploads()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_pendingRequests.empty() || !m_waitingUploads.empty() || !m_inFlightUploads.empty();
+}
@@ -0,0 +1,145 @@
+﻿#pragma once
+#include "Rhi.h"
+#include "StagingRing.h"
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <mutex>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ※注意
+//
+//  このヘッダーは Windows や D3D12 のヘッダーに依存しないこと。 (標準ライブラリとRHIのみを使用する)
+//  ヌルRHIのコピーキューと、CPUのメモリをステージングバッファの代わりに渡せば、GPUの無い環境でも動かせる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// アップロードするサブリソース1つ分のピクセルデータ (D3D12_SUBRESOURCE_DATA と同じ意味)
+struct TextureUploadSubresource
+{
+    const void* data;                   // ピクセルデータの先頭
+    uint64_t rowPitch;                  // 1行のバイト数
+    uint64_t slicePitch;                // 1スライス(深さ1つ分)のバイト数
+};
+
+
+// テクスチャのアップロードの要求
+struct TextureUploadRequest
+{
+    RhiResource* destination;                               // コピー先のテクスチャ (アップロードが完了するまで解放しないこと)
+    std::vector<RhiPlacedFootprint> footprints;             // サブリソース毎の配置 (offset はこのテクスチャの先頭から数える)
+    std::vector<uint32_t> numRows;                          // サブリソース毎の行数
+    std::vector<uint64_t> rowSizesInBytes;                  // サブリソース毎の1行のバイト数 (隙間を含まない)
+    std::vector<TextureUploadSubresource> subresources;     // サブリソース毎のピクセルデータ (空の場合はデコードに失敗したことを表す)
+    uint64_t totalBytes;                                    // ステージングバッファに必要なバイト数
+    std::shared_ptr<void> sourceOwner;                      // ピクセルデータの持ち主 (ステージングバッファへの書き込みが終わると解放する)
+    std::function<void(bool)> onCompleted;                  // 完了時にメインスレッドから呼ばれる関数 (引数は成否)
+};
+
+
+// テクスチャアップロードキューの統計情報
+struct TextureUploadQueueStats
+{
+    uint32_t completedCount;            // アップロードが完了したテクスチャの数
+    uint32_t failedCount;               // 失敗したテクスチャの数
+    uint32_t submitCount;               // コピーキューに送った回数
+    uint64_t uploadedBytes;             // ステージングバッファに書き込んだバイト数
+    uint64_t peakStagingBytes;          // ステージングバッファの使用量の最大値
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// テクスチャアップロードキュークラス
+//
+//      ・デコード済みのピクセルデータを、ステージングリング経由でコピーキューからテクスチャにコピーするクラス。
+//      ・Enqueue() はどのスレッドからでも呼び出せる。 (デコードを行うワーカースレッドから呼び出す)
+//      ・Update() はメインスレッドから毎フレーム呼び出す。
+//          1. GPUが完了したフェンス値までの要求を完了させ、ステージングリングの領域を返却する。
+//          2. 届いた順に、ステージングリングに空きがある限り(1回の転送量の上限まで)ピクセルデータを書き込み、コピーを記録する。
+//          3. 記録したコピーをまとめてコピーキューに送り、そのフェンス値を覚えておく。
+//      ・ステージングリングより大きい要求は、サブリソースを行のまとまりに分けて、複数回の Update() に渡って書き込む。
+//        (後の要求は追い越さない。 完了の通知は最後のまとまりのコピーが完了した後)
+//      ・完了の通知はフェンスの完了をCPUが確かめた後なので、通知を受けてから記録した描画は必ずコピーの後に実行される。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class TextureUploadQueue
+{
+public:
+    static constexpr uint64_t FootprintAlignment = 512;                 // テクスチャの配置のアラインメント (D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT)
+    static constexpr uint64_t DefaultMaxBytesPerUpdate = 8 * 1024 * 1024;   // 既定の、1回の Update() で書き込むバイト数の上限
+
+private:
+    // ステージングリングの空きを待っている要求
+    struct WaitingUpload
+    {
+        TextureUploadRequest request;               // 要求
+        uint32_t nextSubresource;                   // 次に書き込むサブリソース (分けて書き込む場合のみ使う)
+        uint32_t nextRow;                           // 次に書き込む行 (分けて書き込む場合のみ使う)
+    };
+
+    // コピーキューに送った要求
+    struct InFlightUpload
+    {
+        uint64_t fenceValue;                        // 完了を表すフェンス値
+        std::function<void(bool)> onCompleted;      // 完了時に呼ぶ関数
+    };
+
+    RhiCopyQueue* m_copyQueue;                      // コピーを送るキュー (所有しない)
+    RhiResource* m_stagingBuffer;                   // ステージングバッファ (所有しない)
+    uint8_t* m_stagingMemory;                       // ステージングバッファをマップしたアドレス
+    StagingRing m_stagingRing;                      // ステージングバッファの割り当て
+    uint64_t m_maxBytesPerUpdate;                   // 1回の Update() で書き込むバイト数の上限
+    std::deque<TextureUploadRequest> m_pendingRequests;     // Enqueue() された要求 (m_mutex で保護する)
+    std::deque<WaitingUpload> m_waitingUploads;     // ステージングリングの空きを待っている要求 (メインスレッドのみ)
+    std::deque<InFlightUpload> m_inFlightUploads;   // コピーの完了を待っている要求 (送った順)
+    uint64_t m_lastFenceValue;                      // 最後にコピーキューに送ったフェンス値
+    TextureUploadQueueStats m_stats;                // 統計情報
+    std::mutex m_mutex;                             // m_pendingRequests を保護する
+
+private:
+    // 完了したフェンス値までの要求を完了させます。
+    void RetireCompletedUploads();
+
+    // 先頭の待っている要求を、失敗として完了させます。
+    void FailFrontUpload();
+
+    // 要求のピクセルデータをステージングバッファに書き込み、コピーを記録します。
+    void RecordUpload(RhiCommandList* commandList, const TextureUploadRequest& request, uint64_t stagingOffset);
+
+    // ステージングリングより大きい要求のピクセルデータを、行のまとまり毎に書き込めるだけ書き込み、コピーを記録します。
+    //      第1引数 : [in/out] コピーを記録するコマンドリスト (nullptr の場合は、最初に書き込む時にコピーキューから取得します)
+    //      第2引数 : [in/out] 要求 (書き込んだ位置を進めます)
+    //      第3引数 : [in/out] この Update() で書き込んだバイト数
+    //       戻り値 :      全て書き込んだ場合は true
+    bool RecordUploadInRows(RhiCommandList** commandList, WaitingUpload* upload, uint64_t* writtenBytes);
+
+public:
+    // コンストラクタ
+    //      第1引数 : [in] コピーを送るキュー
+    //      第2引数 : [in] ステージングバッファ (コピー元としてコマンドに記録します)
+    //      第3引数 : [in] ステージングバッファをマップしたアドレス (マップしたままにしておくこと)
+    //      第4引数 : [in] ステージングバッファのサイズ (単位はバイト)
+    //      第5引数 : [in] 1回の Update() で書き込むバイト数の上限 (少なくとも1つの要求は書き込みます)
+    TextureUploadQueue(RhiCopyQueue* copyQueue, RhiResource* stagingBuffer, void* stagingMemory, uint64_t stagingCapacity, uint64_t maxBytesPerUpdate = DefaultMaxBytesPerUpdate);
+
+    // コピーは禁止
+    TextureUploadQueue(const TextureUploadQueue&) = delete;
+    TextureUploadQueue& operator=(const TextureUploadQueue&) = delete;
+
+    // アップロードの要求を追加します。 (どのスレッドからでも呼び出せます)
+    void Enqueue(TextureUploadRequest&& request);
+
+    // 完了したアップロードを通知し、新しいアップロードをコピーキューに送ります。 (メインスレッドから呼び出してください)
+    void Update();
+
+    // 追加済みの全ての要求が完了するまで待機します。 (メインスレッドから呼び出してください)
+    void WaitForAll();
+
+    // 完了していない要求がある場合は true を返します。
+    bool HasPendingUploads();
+
+    // 統計情報を取得します。
+    const TextureUploadQueueStats& GetStats() const { return m_stats; }
+};
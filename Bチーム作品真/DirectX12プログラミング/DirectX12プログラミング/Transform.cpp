@@ -2,6 +2,7 @@
 #include "GameObject.h"
 #include "SceneManager.h"
 #include "Scene.h"
+#include "NameTable.h"
 
 const TypeInfo& Transform::GetTypeInfo()
 {
@@ -12,24 +13,81 @@ const TypeInfo& Transform::GetTypeInfo()
 
 Transform::Transform()
     : m_parent(nullptr)
-    , m_localScale(1, 1, 1)
-    , m_localRotation(0, 0, 0, 1)
-    , m_localPosition(0, 0, 0)
+    , m_system(nullptr)
+    , m_index(0)
 {
-    // 単位行列で初期化
-    //  | 1  0  0  0 |
-    //  | 0  1  0  0 |
-    //  | 0  0  1  0 |
-    //  | 0  0  0  1 |
-    DirectX::XMStoreFloat4x4(&m_localToWorldMatrix, DirectX::XMMatrixIdentity());
-    DirectX::XMStoreFloat4x4(&m_worldToLocalMatrix, DirectX::XMMatrixIdentity());
+}
+
+
+Transform::Transform(const Transform& original)
+    : Component(original)
+    , m_parent(nullptr)
+    , m_system(nullptr)
+    , m_index(0)
+{
+}
+
+
+Transform::~Transform()
+{
+    // トランスフォームシステムからデータを削除する
+    if (m_system)
+    {
+        m_system->Remove(m_index);
+    }
+}
+
+
+void Transform::OnAttach()
+{
+    // 所属するシーンのトランスフォームシステムにデータの格納場所を確保する。
+    // (スケール(1,1,1)、向き(0,0,0,1)、位置(0,0,0)、単位行列で初期化される)
+    m_system = GetGameObject()->GetScene()->GetTransformSystem();
+    m_index = m_system->Add(this);
+}
+
+
+void Transform::MoveToSystem(TransformSystem* system)
+{
+    assert(!m_parent || (m_parent->m_system == system));
+
+    // 削除すると参照が無効になるので、先にコピーしておく
+    const DirectX::XMFLOAT3 localScale = GetLocalScale();
+    const DirectX::XMFLOAT4 localRotation = GetLocalRotation();
+    const DirectX::XMFLOAT3 localPosition = GetLocalPosition();
+
+    // 子はまだ移す前の格納位置にいるので、削除による格納位置の付け替えは正しく行われる
+    m_system->Remove(m_index);
+
+    // 親は先に追加されているので、末尾に追加すれば「親が子よりも前」の並び順は崩れない
+    m_system = system;
+    m_index = system->Add(this);
+    system->m_localScales[m_index] = localScale;
+    system->m_localRotations[m_index] = localRotation;
+    system->m_localPositions[m_index] = localPosition;
+
+    // 親を付け替えて、行列は次回の再計算で求める (子も移す時に同じように再計算待ちになる)
+    system->SetParent(m_index, m_parent ? (int32_t)m_parent->m_index : -1);
+}
+
+
+void Transform::LinkToParent(Transform* parent)
+{
+    assert(!m_parent && parent && (parent->m_system == m_system));
+
+    m_siblingIterator = parent->m_children.insert(parent->m_children.end(), this);
+    m_parent = parent;
+    m_system->SetParent(m_index, (int32_t)parent->m_index);
 }
 
 
 void Transform::SetParent(Transform* parent, bool worldPositionStay)
 {
+    // 別のシーンのTransformを親にすることはできない
+    assert(!parent || (parent->m_system == m_system));
+
     // ワールド変換行列を取得する。
-    const DirectX::XMFLOAT4X4& localToWorldMatrix = this->GetLocalToWorldMatrix();
+    const DirectX::XMFLOAT4X4 localToWorldMatrix = this->GetLocalToWorldMatrix();
 
     // ワールド変換行列から「ワールド空間内での位置」を抜き出す。
     //
@@ -46,16 +104,17 @@ void Transform::SetParent(Transform* parent, bool worldPositionStay)
     );
 
     // 既に親がいる場合は、新しい親に切り替える
+    // (DetachChild()を呼ぶとルートゲームオブジェクトとして登録されてしまうので、子リストから外すだけにする)
     if (m_parent)
     {
-        m_parent->DetachChild(this);
+        m_parent->m_children.erase(m_siblingIterator);
     }
 
     // 新しい親が nullptr でない場合は、
-    // その親の子として自分を登録する。
+    // その親の子として自分を登録する。 (後で O(1) で削除できるように位置を覚えておく)
     if (parent)
     {
-        parent->m_children.push_back(this);
+        m_siblingIterator = parent->m_children.insert(parent->m_children.end(), this);
     }
 
     Transform* before = m_parent;
@@ -80,7 +139,7 @@ void Transform::SetParent(Transform* parent, bool worldPositionStay)
         if (m_parent)
         {
             // 「ワールド空間での位置」を「新しい親の空間から見た位置」に逆変換する。
-            const DirectX::XMFLOAT4X4& worldToLocalMatrix = m_parent->GetWorldToLocalMatrix();
+            const DirectX::XMFLOAT4X4 worldToLocalMatrix = m_parent->GetWorldToLocalMatrix();
 
             // 「保存用の行列」⇒「計算用の行列」に変換する
             const DirectX::XMMATRIX inverse = DirectX::XMLoadFloat4x4(&worldToLocalMatrix);
@@ -89,14 +148,23 @@ void Transform::SetParent(Transform* parent, bool worldPositionStay)
             const DirectX::XMVECTOR localPosition = DirectX::XMVector3TransformCoord(worldPosition, inverse);
 
             // 「計算用のベクトル」⇒「保存用のベクトル」に変換する
-            DirectX::XMStoreFloat3(&m_localPosition, localPosition);
+            DirectX::XMStoreFloat3(&m_system->m_localPositions[m_index], localPosition);
         }
         else
         {
             // 親がいなくなった場合は、「ワールド空間での位置」と「ローカル空間での位置」は一致する。
-            DirectX::XMStoreFloat3(&m_localPosition, worldPosition);
+            DirectX::XMStoreFloat3(&m_system->m_localPositions[m_index], worldPosition);
         }
     }
+
+    // トランスフォームシステムにも新しい親を教える (自分と子孫の行列は再計算が必要になる)
+    m_system->SetParent(m_index, m_parent ? (int32_t)m_parent->m_index : -1);
+
+    // 名前検索用の索引も新しい親の子として登録し直す
+    GetGameObject()->GetScene()->ReindexParent(GetGameObject());
+
+    // 階層構造が変化したのでシーンの更新順も変わる
+    GetGameObject()->GetScene()->SetUpdateOrderDirty();
 }
 
 void Transform::DetachChild(Transform* child)
@@ -109,14 +177,17 @@ void Transform::DetachChild(Transform* child)
         assert(0);  // 他人の子だ！
     }
 
-    // 指定された子をリストから削除する
-    m_children.remove(child);
+    // 指定された子をリストから削除する (覚えておいた位置を使うので O(1))
+    m_children.erase(child->m_siblingIterator);
 
     // お前の親はいなくなったぞ
     child->m_parent = nullptr;
+    m_system->SetParent(child->m_index, -1);
 
     // 親がいなくなったのでルートゲームオブジェクトとしてシーンに追加する
     child->GetGameObject()->GetScene()->AddRootGameObject(child->GetGameObject());
+    child->GetGameObject()->GetScene()->ReindexParent(child->GetGameObject());
+    child->GetGameObject()->GetScene()->SetUpdateOrderDirty();
 }
 
 void Transform::DetachChildren()
@@ -125,212 +196,192 @@ void Transform::DetachChildren()
     for (Transform* child : m_children)
     {
         child->m_parent = nullptr;
+        m_system->SetParent(child->m_index, -1);
 
         // 親がいなくなったのでルートゲームオブジェクトとしてシーンに追加する
         child->GetGameObject()->GetScene()->AddRootGameObject(child->GetGameObject());
+        child->GetGameObject()->GetScene()->ReindexParent(child->GetGameObject());
     }
 
     // 全ての子をリストから削除する
     m_children.clear();
+
+    // 階層構造が変化したのでシーンの更新順も変わる
+    GetGameObject()->GetScene()->SetUpdateOrderDirty();
 }
 
 void Transform::SetLocalScale(const DirectX::XMFLOAT3& localScale)
 {
-    m_localScale = localScale;
+    m_system->m_localScales[m_index] = localScale;
+    m_system->SetDirty(m_index);
 }
 
 void Transform::SetLocalScale(float x, float y, float z)
 {
-    m_localScale.x = x;
-    m_localScale.y = y;
-    m_localScale.z = z;
+    SetLocalScale(DirectX::XMFLOAT3(x, y, z));
 }
 
 void Transform::SetLocalRotation(const DirectX::XMFLOAT4& localRotation)
 {
-    m_localRotation = localRotation;
+    m_system->m_localRotations[m_index] = localRotation;
+    m_system->SetDirty(m_index);
 }
 
 void Transform::SetLocalPosition(const DirectX::XMFLOAT3& localPosition)
 {
-    m_localPosition = localPosition;
+    m_system->m_localPositions[m_index] = localPosition;
+    m_system->SetDirty(m_index);
 }
 
 void Transform::SetLocalPosition(float x, float y, float z)
 {
-    m_localPosition.x = x;
-    m_localPosition.y = y;
-    m_localPosition.z = z;
+    SetLocalPosition(DirectX::XMFLOAT3(x, y, z));
+}
+
+void Transform::SetRotation(const DirectX::XMFLOAT4& rotation)
+{
+    if (!m_parent)
+    {
+        SetLocalRotation(rotation);
+        return;
+    }
+
+    // 親のワールド変換行列から、親のワールド空間での向きを抜き出す
+    const DirectX::XMFLOAT4X4 parentLocalToWorldMatrix = m_parent->GetLocalToWorldMatrix();
+    DirectX::XMVECTOR parentScale, parentRotation, parentPosition;
+    DirectX::XMMatrixDecompose(&parentScale, &parentRotation, &parentPosition, DirectX::XMLoadFloat4x4(&parentLocalToWorldMatrix));
+
+    // 「ワールド空間での向き」=「ローカルの向き」×「親の向き」なので、親の向きの逆を掛けて打ち消す
+    DirectX::XMFLOAT4 localRotation;
+    DirectX::XMStoreFloat4(&localRotation, DirectX::XMQuaternionMultiply(DirectX::XMLoadFloat4(&rotation), DirectX::XMQuaternionInverse(parentRotation)));
+    SetLocalRotation(localRotation);
+}
+
+void Transform::SetPosition(const DirectX::XMFLOAT3& position)
+{
+    if (!m_parent)
+    {
+        SetLocalPosition(position);
+        return;
+    }
+
+    // 「親の空間から見た位置」=「ワールド空間での位置」×「親の逆行列」
+    const DirectX::XMFLOAT4X4 parentWorldToLocalMatrix = m_parent->GetWorldToLocalMatrix();
+    DirectX::XMFLOAT3 localPosition;
+    DirectX::XMStoreFloat3(&localPosition, DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&position), DirectX::XMLoadFloat4x4(&parentWorldToLocalMatrix)));
+    SetLocalPosition(localPosition);
 }
 
 void Transform::Translate(const DirectX::XMFLOAT3& deltaPosition)
 {
-    m_localPosition.x += deltaPosition.x;
-    m_localPosition.y += deltaPosition.y;
-    m_localPosition.z += deltaPosition.z;
+    Translate(deltaPosition.x, deltaPosition.y, deltaPosition.z);
 }
 
 void Transform::Translate(float dx, float dy, float dz)
 {
-    m_localPosition.x += dx;
-    m_localPosition.y += dy;
-    m_localPosition.z += dz;
+    DirectX::XMFLOAT3& localPosition = m_system->m_localPositions[m_index];
+    localPosition.x += dx;
+    localPosition.y += dy;
+    localPosition.z += dz;
+    m_system->SetDirty(m_index);
 }
 
 
-static int SplitPath(std::string_view tokens[256], const char* path)
+bool Transform::NextPathToken(const char*& path, std::string_view& token)
 {
-    int i = 0;
-
-    //  "./"は除外する。
-    // "../"は不正なパス。
-    if (path[0] == '.')
+    // 連続する '/' は1つとみなす
+    while (*path == '/')
     {
-        assert(path[1] == '/');
-        i = 2;
+        path++;
     }
 
-    int numTokens = 0;
-    int startIndex = i;
-    while (path[i])
+    if (*path == '\0')
     {
-        if (path[i] == '/')
-        {
-            std::string_view token{ &path[startIndex], (std::string_view::size_type)(i - startIndex) };
-            tokens[numTokens++] = token;
-            startIndex = i + 1;
-        }
-        i++;
+        return false;
     }
 
-    if (i > startIndex)
+    const char* begin = path;
+    while ((*path != '\0') && (*path != '/'))
     {
-        std::string_view token{ &path[startIndex], (std::string_view::size_type)(i - startIndex) };
-        tokens[numTokens++] = token;
+        path++;
     }
-
-    return numTokens;
+    token = std::string_view(begin, (std::string_view::size_type)(path - begin));
+    return true;
 }
 
 
 Transform* Transform::Find(const char* name) const
 {
-    std::string_view tokens[256];
-
-    // セパレーター文字 '/' で区切る
-    const int numTokens = SplitPath(tokens, name);
-
-    Transform* current = (Transform*)this;
-    for (int i = 0; i < numTokens; i++)
+    //  "./"は除外する。
+    // "../"は不正なパス。
+    if (name[0] == '.')
     {
-        current = current->GetChildByName(tokens[i]);
-        if (!current)
-            break;
+        assert(name[1] == '/');
+        name += 2;
     }
 
-    if (current == this)
+    Transform* found = FindDescendant(name);
+    if (found == this)
         return nullptr;
     else
-        return current;
+        return found;
 }
 
 
-Transform* Transform::GetChildByName(const std::string_view& name) const
+Transform* Transform::FindDescendant(const char* path) const
 {
-    for (Transform* child : m_children)
+    const Scene* scene = GetGameObject()->GetScene();
+
+    const Transform* current = this;
+    std::string_view token;
+    while (NextPathToken(path, token))
     {
-        const char* childName = child->GetName().c_str();
-        if (!_strnicmp(childName, name.data(), name.size()))
+        // 一度も使われたことのない名前であれば、その名前の子はいない
+        const uint32_t nameID = NameTable::Find(token);
+        if (nameID == NameTable::InvalidID)
+        {
+            return nullptr;
+        }
+
+        current = scene->FindChildByName(current, nameID);
+        if (!current)
         {
-            return child;
+            return nullptr;
         }
     }
-    return nullptr;
+    return const_cast<Transform*>(current);
 }
 
 
-void Transform::UpdateMatrices() const
+Transform* Transform::GetChildByName(const std::string_view& name) const
 {
-    // 「自分のローカル変換行列」を取得する。
-    const DirectX::XMMATRIX localMatrix = GetLocalMatrix();
-
-    // 「自分のワールド変換行列」を格納する変数
-    DirectX::XMMATRIX localToWorldMatrix;
-
-    if (m_parent)
-    {
-        // 親Transformがいる場合・・・
-
-        // 「親のワールド変換行列」を取得する
-        const DirectX::XMMATRIX parentLocalToWorld = DirectX::XMLoadFloat4x4(&m_parent->GetLocalToWorldMatrix());
-
-        // 「自分のワールド変換行列」 = 「自分のローカル変換行列」 × 「親のワールド変換行列」
-        localToWorldMatrix = DirectX::XMMatrixMultiply(localMatrix, parentLocalToWorld);
-    }
-    else
+    const uint32_t nameID = NameTable::Find(name);
+    if (nameID == NameTable::InvalidID)
     {
-        // 親Transformがいない場合・・・
-
-        // 「自分のワールド変換行列」 = 「自分のローカル変換行列」
-        localToWorldMatrix = localMatrix;
+        return nullptr;
     }
-
-    // 「自分のワールド変換行列」の逆行列を計算する。
-    const DirectX::XMMATRIX worldToLocalMatrix = DirectX::XMMatrixInverse(nullptr, localToWorldMatrix);
-
-    // 「計算用変数」の値を変換して「保存用変数」に格納する
-    DirectX::XMStoreFloat4x4(&m_localToWorldMatrix, localToWorldMatrix);
-    DirectX::XMStoreFloat4x4(&m_worldToLocalMatrix, worldToLocalMatrix);
+    return GetGameObject()->GetScene()->FindChildByName(this, nameID);
 }
 
 
-const DirectX::XMMATRIX Transform::GetLocalMatrix() const
+DirectX::XMFLOAT4X4 Transform::GetLocalToWorldMatrix() const
 {
-    // ① スケーリング行列の作成
-    //  | sx   0   0  0 |
-    //  |  0  sy   0  0 |
-    //  |  0   0  sz  0 |
-    //  |  0   0   0  1 |
-    //
-    // DirectX::XMMatrixScaling(X軸方向のスケール値, Y軸方向のスケール値, Z軸方向のスケール値);
-    const DirectX::XMMATRIX scaling = DirectX::XMMatrixScaling(m_localScale.x, m_localScale.y, m_localScale.z);
-
-    // ② 回転行列の作成
-    //  | r  r  r  0 |
-    //  | r  r  r  0 |
-    //  | r  r  r  0 |
-    //  | 0  0  0  1 |
-    //
-    // DirectX::XMMatrixRotationQuaternion(四元数)
-    const DirectX::XMMATRIX rotation = DirectX::XMMatrixRotationQuaternion(DirectX::XMLoadFloat4(&m_localRotation));
-
-    // ③ 平行移動行列の作成
-    //  |  1   0   0  0 |
-    //  |  0   1   0  0 |
-    //  |  0   0   1  0 |
-    //  | tx  ty  tz  1 |
-    //
-    // DirectX::XMMatrixTranslation(位置X, 位置Y, 位置Z);
-    const DirectX::XMMATRIX translation = DirectX::XMMatrixTranslation(m_localPosition.x, m_localPosition.y, m_localPosition.z);
-
-    // ④ 行列を合成(①×②×③)
-    // 
-    // DirectX::XMMatrixMultiply(前から掛ける行列, 後ろから掛ける行列);
-    return DirectX::XMMatrixMultiply(DirectX::XMMatrixMultiply(scaling, rotation), translation);
+    m_system->UpdateWorldMatrix(m_index);
+    return m_system->m_localToWorldMatrices[m_index];
 }
 
 
-const DirectX::XMFLOAT4X4& Transform::GetLocalToWorldMatrix() const
+DirectX::XMFLOAT4X4 Transform::GetWorldToLocalMatrix() const
 {
-    UpdateMatrices();
-    return m_localToWorldMatrix;
+    m_system->UpdateWorldToLocalMatrix(m_index);
+    return m_system->m_worldToLocalMatrices[m_index];
 }
 
 
-const DirectX::XMFLOAT4X4& Transform::GetWorldToLocalMatrix() const
+uint32_t Transform::GetVersion() const
 {
-    UpdateMatrices();
-    return m_worldToLocalMatrix;
+    m_system->UpdateWorldMatrix(m_index);
+    return m_system->m_hierarchy.GetVersion(m_index);
 }
 
 
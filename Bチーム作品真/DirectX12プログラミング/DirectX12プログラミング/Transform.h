@@ -1,7 +1,9 @@
 ﻿#pragma once
 #include "Component.h"
+#include "TransformSystem.h"
 #include <DirectXMath.h>
 #include <list>
+#include <string_view>
 #include <functional>
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
@@ -13,6 +15,8 @@
 //      ・「ワールド変換行列の逆行列」を取得することができます。
 //      ・0または1個の親Transformを持ちます。
 //      ・0個以上の子Transformを持ちます。
+//      ・スケール、向き、位置、変換行列はシーンのTransformSystemの配列に格納されています。
+//        (このクラスはその格納位置を持つハンドルです)
 // 
 //---------------------------------------------------------------------------------------------------------------------------------------------
 class Transform : public Component
@@ -20,18 +24,36 @@ class Transform : public Component
 private:
     std::list<Transform*> m_children;                   // 子Transformへの参照のリスト
     Transform* m_parent;                                // 親Transformへの参照
-    DirectX::XMFLOAT3 m_localScale;                     // スケール(x,y,z)
-    DirectX::XMFLOAT4 m_localRotation;                  // 向き(x,y,z,w)
-    DirectX::XMFLOAT3 m_localPosition;                  // 位置(x,y,z)
-    mutable DirectX::XMFLOAT4X4 m_localToWorldMatrix;   // [ローカル → ワールド]変換行列
-    mutable DirectX::XMFLOAT4X4 m_worldToLocalMatrix;   // [ワールド → ローカル]変換行列
+    std::list<Transform*>::iterator m_siblingIterator;  // 親の子Transformリスト内での位置 (親を持つ場合のみ有効)
+    TransformSystem* m_system;                          // データを格納しているトランスフォームシステムへの参照
+    uint32_t m_index;                                   // トランスフォームシステム内でのデータの格納位置
     friend class GameObject;                            // ゲームオブジェクトクラスは友達
     friend class Scene;                                 // シーンクラスは友達
+    friend class TransformSystem;                       // トランスフォームシステムクラスは友達
 
 private:
     // コンストラクタ
     Transform();
 
+    // コピーコンストラクタ
+    //      ・親子関係はコピーしません。 (トランスフォームシステムへの登録は OnAttach() で行われます)
+    Transform(const Transform& original);
+
+    // デストラクタ
+    ~Transform();
+
+    // Component::OnAttach()をオーバーライドします。
+    void OnAttach() override;
+
+    // 親を持たないこのTransformを、指定した親の子リストの末尾に直接繋ぎます。
+    //      ・ルートゲームオブジェクトリストとシーンの更新順は変更しないので、呼び出し側で整合性を保ってください。
+    void LinkToParent(Transform* parent);
+
+    // データを別のトランスフォームシステムに移します。 (ゲームオブジェクトを別のシーンに移動する時に使います)
+    //      ・ローカルのスケール、向き、位置と親子関係はそのまま保たれます。
+    //      ・親は先に移しておいてください。 (子孫は親の後に、親から順番に移してください)
+    void MoveToSystem(TransformSystem* system);
+
 public:
     // このデータ型の情報を返します。
     static const TypeInfo& GetTypeInfo();
@@ -39,6 +61,12 @@ public:
     // このインスタンスのデータ型の情報を返します。
     virtual const TypeInfo& GetTypeInfoOfInstance() const { return GetTypeInfo(); }
 
+    // GameObjectのコンポーネントテーブル内での、このデータ型の添え字
+    static constexpr ComponentTypeIndex TypeIndex = ComponentTypeIndex::Transform;
+
+    // このデータ型と全ての基底クラスを表すビットマスク
+    static constexpr uint32_t TypeMask = Component::TypeMask | ToComponentTypeMask(TypeIndex);
+
     // 親Transformを設定します。
     // (worldPositionStay == true)の場合、このTransformのワールド空間での位置が保たれます。
     // (worldPositionStay == false)の場合、親空間内での相対位置になる為、ワールド空間での位置が保たれません。
@@ -69,13 +97,13 @@ public:
     void SetLocalScale(float x, float y, float z);
 
     // スケールを取得します。
-    const DirectX::XMFLOAT3& GetLocalScale() const { return m_localScale; }
+    const DirectX::XMFLOAT3& GetLocalScale() const { return m_system->m_localScales[m_index]; }
 
     // 向きを設定します。
     void SetLocalRotation(const DirectX::XMFLOAT4& localRotation);
 
     // 向きを取得します。
-    const DirectX::XMFLOAT4& GetLocalRotation() const { return m_localRotation; }
+    const DirectX::XMFLOAT4& GetLocalRotation() const { return m_system->m_localRotations[m_index]; }
 
     // 位置を設定します。
     void SetLocalPosition(const DirectX::XMFLOAT3& localPosition);
@@ -84,7 +112,14 @@ public:
     void SetLocalPosition(float x, float y, float z);
 
     // 位置を取得します。
-    const DirectX::XMFLOAT3& GetLocalPosition() const { return m_localPosition; }
+    //      ・新しいTransformが追加されると配列が再確保されるので、戻り値の参照を保持し続けないでください。
+    const DirectX::XMFLOAT3& GetLocalPosition() const { return m_system->m_localPositions[m_index]; }
+
+    // ワールド空間での向きを設定します。 (親の向きを打ち消したローカルの向きに変換して設定します)
+    void SetRotation(const DirectX::XMFLOAT4& rotation);
+
+    // ワールド空間での位置を設定します。 (親の空間から見た位置に変換して設定します)
+    void SetPosition(const DirectX::XMFLOAT3& position);
 
     // 平行移動します。
     void Translate(const DirectX::XMFLOAT3& deltaPosition);
@@ -93,25 +128,35 @@ public:
     void Translate(float dx, float dy, float dz);
 
     // [ローカル → ワールド]変換行列を取得します。
-    const DirectX::XMFLOAT4X4& GetLocalToWorldMatrix() const;
+    //      ・行列の格納位置はTransformの追加や並べ替えで変わるので、参照ではなくコピーを返します。
+    DirectX::XMFLOAT4X4 GetLocalToWorldMatrix() const;
 
     // [ワールド → ローカル]変換行列を取得します。
-    const DirectX::XMFLOAT4X4& GetWorldToLocalMatrix() const;
+    //      ・行列の格納位置はTransformの追加や並べ替えで変わるので、参照ではなくコピーを返します。
+    DirectX::XMFLOAT4X4 GetWorldToLocalMatrix() const;
+
+    // [ローカル → ワールド]変換行列のバージョン番号を取得します。
+    //      ・行列が再計算される度に値が変わるので、行列から求めた値をキャッシュする場合に使用します。
+    uint32_t GetVersion() const;
 
     // 指定した名前を持つ子Transformを検索します。
     //      ・引数name に '/' の文字が含まれている場合は、パス名のように階層を走査します。
+    //      ・名前は大文字と小文字(ASCIIのみ)を区別せずに、全体が一致するものを探します。
+    //      ・同じ名前の子が複数ある場合は、子の順番で最初のものを返します。
     //      ・子Transformが見つからない場合は nullptr を返します。
     Transform* Find(const char* name) const;
 
 private:
-    // 指定した名前のを持つ子Transformを検索します。(この関数は直接の子のみが対象です)
+    // 指定した名前を持つ子Transformを検索します。(この関数は直接の子のみが対象です)
     Transform* GetChildByName(const std::string_view& name) const;
 
-    // 各種行列を再計算します。
-    void UpdateMatrices() const;
+    // パスを '/' で区切って辿り、子孫のTransformを検索します。
+    //      ・パスの各部分はシーンの索引で検索するので、子の数に関係なくパスの長さに比例した時間で済みます。
+    Transform* FindDescendant(const char* path) const;
 
-    // ローカル行列(スケーリング×回転×平行移動)を取得します。
-    const DirectX::XMMATRIX GetLocalMatrix() const;
+    // パスの先頭から '/' で区切られた名前を1つ取り出し、path を次の名前の位置に進めます。
+    //      ・名前が残っていない場合は false を返します。
+    static bool NextPathToken(const char*& path, std::string_view& token);
 
     // 
     void Traverse(const std::function<void(Transform*)>& visitor);
@@ -0,0 +1,172 @@
+﻿#include "TransformHierarchy.h"
+
+
+TransformHierarchy::TransformHierarchy()
+    : m_isOrderDirty(false)
+{
+}
+
+
+uint32_t TransformHierarchy::Add()
+{
+    const uint32_t index = GetCount();
+
+    // 新しい要素は親を持たないので、末尾に追加しても「親が子よりも前」の並び順は崩れない。
+    m_parentIndices.push_back(-1);
+    m_versions.push_back(0);
+    m_parentVersions.push_back(0);
+    m_inverseVersions.push_back(0);
+    m_stateFlags.push_back(0);
+    return index;
+}
+
+
+void TransformHierarchy::Remove(uint32_t index)
+{
+    assert(index < GetCount());
+
+    // 末尾の要素を削除する位置に移動させる
+    const uint32_t lastIndex = GetCount() - 1;
+    if (index != lastIndex)
+    {
+        m_parentIndices[index] = m_parentIndices[lastIndex];
+        m_versions[index] = m_versions[lastIndex];
+        m_parentVersions[index] = m_parentVersions[lastIndex];
+        m_inverseVersions[index] = m_inverseVersions[lastIndex];
+        m_stateFlags[index] = m_stateFlags[lastIndex];
+
+        // 親よりも前に移動してしまった場合は並べ替えが必要
+        if (m_parentIndices[index] >= (int32_t)index)
+        {
+            m_isOrderDirty = true;
+        }
+    }
+
+    m_parentIndices.pop_back();
+    m_versions.pop_back();
+    m_parentVersions.pop_back();
+    m_inverseVersions.pop_back();
+    m_stateFlags.pop_back();
+}
+
+
+void TransformHierarchy::Clear()
+{
+    m_parentIndices.clear();
+    m_versions.clear();
+    m_parentVersions.clear();
+    m_inverseVersions.clear();
+    m_stateFlags.clear();
+    m_isOrderDirty = false;
+}
+
+
+void TransformHierarchy::SetParent(uint32_t index, int32_t parentIndex)
+{
+    m_parentIndices[index] = parentIndex;
+
+    // 親が自分よりも後ろにいる場合は並べ替えが必要
+    // (子孫は自分よりも後ろにいるので、親が自分よりも前にいれば子孫よりも前にいることになる)
+    if (parentIndex > (int32_t)index)
+    {
+        m_isOrderDirty = true;
+    }
+
+    // 親が変わったので、自分の行列は再計算が必要 (子孫は自分のバージョン番号が変わることで再計算される)
+    SetDirty(index);
+}
+
+
+void TransformHierarchy::OnParentMoved(uint32_t index, uint32_t parentIndex)
+{
+    m_parentIndices[index] = (int32_t)parentIndex;
+
+    // 子よりも後ろに移動してしまった場合は並べ替えが必要
+    if (parentIndex > index)
+    {
+        m_isOrderDirty = true;
+    }
+}
+
+
+void TransformHierarchy::SortParentBeforeChild()
+{
+    const uint32_t count = GetCount();
+
+    // 親毎に子の格納位置をまとめる (子は格納位置の順番に並ぶ)
+    //   ・まず m_childOffsets[親] に子の数を数え、累積して「親の子の範囲の終わり」にする。
+    //   ・後ろから詰めていくと、m_childOffsets[親] は「親の子の範囲の始まり」になる。
+    m_childOffsets.assign(count + 1, 0);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (m_parentIndices[i] >= 0)
+        {
+            m_childOffsets[m_parentIndices[i]]++;
+        }
+    }
+    uint32_t childCount = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        childCount += m_childOffsets[i];
+        m_childOffsets[i] = childCount;
+    }
+    m_childOffsets[count] = childCount;
+    m_childIndices.resize(childCount);
+    for (uint32_t i = count; i-- > 0; )
+    {
+        if (m_parentIndices[i] >= 0)
+        {
+            m_childIndices[--m_childOffsets[m_parentIndices[i]]] = i;
+        }
+    }
+
+    // 親を持たない要素から順番に深さ優先で走査する。
+    // (同じ部分木のデータが連続して並ぶようになる)
+    m_sortedIndices.clear();
+    m_sortedIndices.reserve(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (m_parentIndices[i] >= 0)
+        {
+            continue;
+        }
+
+        m_traverseStack.push_back(i);
+        while (!m_traverseStack.empty())
+        {
+            const uint32_t index = m_traverseStack.back();
+            m_traverseStack.pop_back();
+            m_sortedIndices.push_back(index);
+
+            // 子を格納位置の順番通りに取り出せるように、逆順に積む
+            for (uint32_t c = m_childOffsets[index + 1]; c-- > m_childOffsets[index]; )
+            {
+                m_traverseStack.push_back(m_childIndices[c]);
+            }
+        }
+    }
+    assert(m_sortedIndices.size() == count);
+
+    m_newIndices.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        m_newIndices[m_sortedIndices[i]] = i;
+    }
+
+    Reorder(m_parentIndices);
+    Reorder(m_versions);
+    Reorder(m_parentVersions);
+    Reorder(m_inverseVersions);
+    Reorder(m_stateFlags);
+
+    // 親の格納位置も新しい位置に付け替える
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (m_parentIndices[i] >= 0)
+        {
+            m_parentIndices[i] = (int32_t)m_newIndices[m_parentIndices[i]];
+        }
+    }
+
+    m_isOrderDirty = false;
+}
@@ -0,0 +1,225 @@
+﻿#pragma once
+#include <vector>
+#include <cstdint>
+#include <cassert>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// トランスフォーム階層クラス
+//
+//      ・TransformSystem のうち、行列の計算以外(親子関係、並び順、行列が古いかどうかの判定)を受け持つクラス。
+//      ・各要素は「親の格納位置」と「ワールド変換行列のバージョン番号」を持つ。
+//          ・ローカルのスケール、向き、位置か親が変わった要素には、再計算が必要な印を付ける。 (子孫には伝えない)
+//          ・ワールド変換行列を計算した時の親のバージョン番号を覚えておき、親のバージョン番号と違っていれば、
+//            自分の行列も古くなっていると判定する。 (親が再計算されると、子孫は順番に古いと判定される)
+//          ・逆行列は、計算した時の自分のバージョン番号を覚えておき、必要になった時に古ければ再計算する。
+//      ・配列の並び順は「親が必ず子よりも前」になるように保つ。 崩れた場合は SortParentBeforeChild() で並べ替える。
+//      ・行列そのものは呼び出し元が持ち、計算は引数で渡された関数に任せる。
+//        (DirectXMath やTransformクラスに依存しないので、Toolsのテストとベンチマークでもビルドできる)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class TransformHierarchy
+{
+private:
+    // 要素の状態を表すフラグ
+    enum StateFlags : uint8_t
+    {
+        LocalChanged = 0x01,                // ローカルのスケール、向き、位置か親が変わった (ワールド変換行列の再計算が必要)
+        WorldMatrixChanged = 0x02,          // 前回の UpdateWorldMatrices() からワールド変換行列が変化した
+    };
+
+    std::vector<int32_t> m_parentIndices;   // 親の格納位置 (親がいない場合は -1)
+    std::vector<uint32_t> m_versions;       // ワールド変換行列を再計算した回数
+    std::vector<uint32_t> m_parentVersions; // ワールド変換行列を計算した時の、親のバージョン番号
+    std::vector<uint32_t> m_inverseVersions;// 逆行列を計算した時の、自分のバージョン番号
+    std::vector<uint8_t> m_stateFlags;      // 要素の状態 (StateFlagsの組み合わせ)
+    std::vector<uint32_t> m_sortedIndices;  // 並べ替え用の作業配列 (m_sortedIndices[新しい位置] = 古い位置)
+    std::vector<uint32_t> m_newIndices;     // 並べ替え用の作業配列 (m_newIndices[古い位置] = 新しい位置)
+    std::vector<uint32_t> m_childOffsets;   // 並べ替え用の作業配列 (各要素の子が m_childIndices のどこから始まるか)
+    std::vector<uint32_t> m_childIndices;   // 並べ替え用の作業配列 (親毎にまとめた子の格納位置)
+    std::vector<uint32_t> m_traverseStack;  // 並べ替え用の作業配列
+    std::vector<uint8_t> m_reorderVisited;  // 並べ替え用の作業配列 (巡回置換で移動済みの要素)
+    bool m_isOrderDirty;                    // 「親が子よりも前」の並び順が崩れている場合は true
+
+public:
+    // コンストラクタ
+    TransformHierarchy();
+
+    // 要素の数を取得します。
+    uint32_t GetCount() const { return (uint32_t)m_parentIndices.size(); }
+
+    // 親の格納位置を取得します。 (親がいない場合は -1)
+    int32_t GetParentIndex(uint32_t index) const { return m_parentIndices[index]; }
+
+    // ワールド変換行列のバージョン番号を取得します。 (行列が古い場合は、UpdateWorldMatrix() の後に取得してください)
+    uint32_t GetVersion(uint32_t index) const { return m_versions[index]; }
+
+    // 「親が子よりも前」の並び順が崩れている場合は true を返します。
+    bool IsOrderDirty() const { return m_isOrderDirty; }
+
+    // 親を持たない要素を末尾に追加し、格納位置を返します。 (単位行列で計算済みの状態になります)
+    uint32_t Add();
+
+    // 指定した位置の要素を削除します。
+    //      ・末尾の要素を削除した位置に移動します。 移動した要素の子の親の格納位置は、呼び出し元が OnParentMoved() で付け替えてください。
+    void Remove(uint32_t index);
+
+    // 全ての要素を削除します。
+    void Clear();
+
+    // 指定した位置の要素の親を設定し、ワールド変換行列を再計算が必要な状態にします。
+    void SetParent(uint32_t index, int32_t parentIndex);
+
+    // 親の格納位置だけが変わったことを教えます。 (親は同じなので、行列は再計算しません)
+    void OnParentMoved(uint32_t index, uint32_t parentIndex);
+
+    // ローカルのスケール、向き、位置が変わったので、ワールド変換行列を再計算が必要な状態にします。
+    //      ・子孫には印を付けません。 子孫は親のバージョン番号が変わったことで、古くなったと判定されます。
+    void SetDirty(uint32_t index) { m_stateFlags[index] |= LocalChanged; }
+
+    // 「親が子よりも前」かつ、同じ部分木の要素が連続して並ぶように並べ替えます。
+    //      ・呼び出し元が持つ配列も、直後に Reorder() で同じ順番に並べ替えてください。
+    void SortParentBeforeChild();
+
+    // 配列の要素を、直前の SortParentBeforeChild() と同じ順番に、その場で並べ替えます。
+    //      ・並べ替えを巡回置換に分けて、巡回毎に要素を1つだけ退避して順番にずらすので、新しい配列は確保しません。
+    template<typename T>
+    void Reorder(std::vector<T>& values);
+
+    // 指定した位置のワールド変換行列が古ければ、(古い祖先も含めて)再計算します。
+    //      ・computeWorldMatrix(index, parentIndex) で行列を計算します。 (親の行列は計算済みです。親がいない場合は parentIndex が -1)
+    //      ・祖先を辿ってバージョン番号を比べるので、階層の深さに比例した時間が掛かります。
+    template<typename ComputeWorldMatrix>
+    void UpdateWorldMatrix(uint32_t index, ComputeWorldMatrix&& computeWorldMatrix);
+
+    // 指定した位置のワールド変換行列と、その逆行列が古ければ再計算します。
+    //      ・computeWorldToLocalMatrix(index) で逆行列を計算します。 (ワールド変換行列は計算済みです)
+    template<typename ComputeWorldMatrix, typename ComputeWorldToLocalMatrix>
+    void UpdateWorldToLocalMatrix(uint32_t index, ComputeWorldMatrix&& computeWorldMatrix, ComputeWorldToLocalMatrix&& computeWorldToLocalMatrix);
+
+    // 古くなっている全てのワールド変換行列を、配列の先頭から順番に再計算します。
+    //      ・並び順が崩れていないこと。 (先に SortParentBeforeChild() を呼び出してください)
+    //      ・前回呼び出した時から行列が変化した要素(個別に再計算されたものも含む)について、onChanged(index) を呼び出します。
+    template<typename ComputeWorldMatrix, typename OnChanged>
+    void UpdateWorldMatrices(ComputeWorldMatrix&& computeWorldMatrix, OnChanged&& onChanged);
+
+private:
+    // 指定した位置のワールド変換行列が古い場合は true を返します。 (親の行列は最新であること)
+    bool IsWorldMatrixStale(uint32_t index) const;
+
+    // 指定した位置のワールド変換行列を再計算したことを記録します。
+    void OnWorldMatrixUpdated(uint32_t index);
+};
+
+
+inline bool TransformHierarchy::IsWorldMatrixStale(uint32_t index) const
+{
+    if (m_stateFlags[index] & LocalChanged)
+    {
+        return true;
+    }
+
+    // 親が再計算された後なら、親のバージョン番号が変わっている
+    const int32_t parentIndex = m_parentIndices[index];
+    return (parentIndex >= 0) && (m_versions[parentIndex] != m_parentVersions[index]);
+}
+
+
+inline void TransformHierarchy::OnWorldMatrixUpdated(uint32_t index)
+{
+    const int32_t parentIndex = m_parentIndices[index];
+    m_parentVersions[index] = (parentIndex >= 0) ? m_versions[parentIndex] : 0;
+    m_versions[index]++;
+    m_stateFlags[index] = WorldMatrixChanged;
+}
+
+
+template<typename T>
+void TransformHierarchy::Reorder(std::vector<T>& values)
+{
+    const uint32_t count = (uint32_t)values.size();
+    assert(count == m_sortedIndices.size());
+    m_reorderVisited.assign(count, 0);
+    for (uint32_t start = 0; start < count; start++)
+    {
+        if (m_reorderVisited[start])
+        {
+            continue;
+        }
+
+        // start から始まる巡回を辿り、1つ後ろの古い位置にある要素を順番に前に移す
+        T first = values[start];
+        uint32_t current = start;
+        for (;;)
+        {
+            m_reorderVisited[current] = 1;
+            const uint32_t oldIndex = m_sortedIndices[current];
+            if (oldIndex == start)
+            {
+                values[current] = first;
+                break;
+            }
+            values[current] = values[oldIndex];
+            current = oldIndex;
+        }
+    }
+}
+
+
+template<typename ComputeWorldMatrix>
+void TransformHierarchy::UpdateWorldMatrix(uint32_t index, ComputeWorldMatrix&& computeWorldMatrix)
+{
+    // 親の行列が古い場合は先に再計算する
+    const int32_t parentIndex = m_parentIndices[index];
+    if (parentIndex >= 0)
+    {
+        UpdateWorldMatrix((uint32_t)parentIndex, computeWorldMatrix);
+    }
+
+    // 自分も親も前回計算した時から何も変わっていなければ再計算しない
+    if (IsWorldMatrixStale(index))
+    {
+        computeWorldMatrix(index, parentIndex);
+        OnWorldMatrixUpdated(index);
+    }
+}
+
+
+template<typename ComputeWorldMatrix, typename ComputeWorldToLocalMatrix>
+void TransformHierarchy::UpdateWorldToLocalMatrix(uint32_t index, ComputeWorldMatrix&& computeWorldMatrix, ComputeWorldToLocalMatrix&& computeWorldToLocalMatrix)
+{
+    UpdateWorldMatrix(index, computeWorldMatrix);
+
+    // 逆行列は必要になるまで計算しない
+    if (m_inverseVersions[index] != m_versions[index])
+    {
+        computeWorldToLocalMatrix(index);
+        m_inverseVersions[index] = m_versions[index];
+    }
+}
+
+
+template<typename ComputeWorldMatrix, typename OnChanged>
+void TransformHierarchy::UpdateWorldMatrices(ComputeWorldMatrix&& computeWorldMatrix, OnChanged&& onChanged)
+{
+    assert(!m_isOrderDirty);
+
+    const uint32_t count = GetCount();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        // 親は必ず自分よりも前にいるので、親の行列は計算済み
+        if (IsWorldMatrixStale(i))
+        {
+            assert(m_parentIndices[i] < (int32_t)i);
+            computeWorldMatrix(i, m_parentIndices[i]);
+            OnWorldMatrixUpdated(i);
+        }
+
+        // 行列が変化した要素を知らせる
+        // (前回から今回までの間に UpdateWorldMatrix() で個別に再計算されたものも含む)
+        if (m_stateFlags[i] & WorldMatrixChanged)
+        {
+            onChanged(i);
+            m_stateFlags[i] &= (uint8_t)~WorldMatrixChanged;
+        }
+    }
+}
@@ -0,0 +1,184 @@
+﻿#include "TransformSystem.h"
+#include "Transform.h"
+#include <cassert>
+
+using namespace DirectX;
+
+
+TransformSystem::TransformSystem()
+{
+}
+
+
+uint32_t TransformSystem::Add(Transform* transform)
+{
+    // 新しいTransformは親を持たないので、末尾に追加しても「親が子よりも前」の並び順は崩れない。
+    const uint32_t index = m_hierarchy.Add();
+    m_transforms.push_back(transform);
+    m_localScales.push_back(XMFLOAT3(1, 1, 1));
+    m_localRotations.push_back(XMFLOAT4(0, 0, 0, 1));
+    m_localPositions.push_back(XMFLOAT3(0, 0, 0));
+
+    // 単位行列で初期化
+    XMFLOAT4X4A identity;
+    XMStoreFloat4x4A(&identity, XMMatrixIdentity());
+    m_localToWorldMatrices.push_back(identity);
+    m_worldToLocalMatrices.push_back(identity);
+    return index;
+}
+
+
+void TransformSystem::Remove(uint32_t index)
+{
+    assert(index < GetCount());
+
+    // 末尾の要素を削除する位置に移動させる
+    const uint32_t lastIndex = GetCount() - 1;
+    m_hierarchy.Remove(index);
+    if (index != lastIndex)
+    {
+        m_transforms[index] = m_transforms[lastIndex];
+        m_localScales[index] = m_localScales[lastIndex];
+        m_localRotations[index] = m_localRotations[lastIndex];
+        m_localPositions[index] = m_localPositions[lastIndex];
+        m_localToWorldMatrices[index] = m_localToWorldMatrices[lastIndex];
+        m_worldToLocalMatrices[index] = m_worldToLocalMatrices[lastIndex];
+
+        // 移動したTransformと、その子に新しい格納位置を教える
+        Transform* moved = m_transforms[index];
+        moved->m_index = index;
+        for (Transform* child : moved->GetChildren())
+        {
+            m_hierarchy.OnParentMoved(child->m_index, index);
+        }
+    }
+
+    m_transforms.pop_back();
+    m_localScales.pop_back();
+    m_localRotations.pop_back();
+    m_localPositions.pop_back();
+    m_localToWorldMatrices.pop_back();
+    m_worldToLocalMatrices.pop_back();
+}
+
+
+void TransformSystem::Clear()
+{
+    // Transformのデストラクタからデータを削除しに来ないようにする
+    for (Transform* transform : m_transforms)
+    {
+        transform->m_system = nullptr;
+    }
+
+    m_hierarchy.Clear();
+    m_transforms.clear();
+    m_localScales.clear();
+    m_localRotations.clear();
+    m_localPositions.clear();
+    m_localToWorldMatrices.clear();
+    m_worldToLocalMatrices.clear();
+    m_changedTransforms.clear();
+}
+
+
+void TransformSystem::SetParent(uint32_t index, int32_t parentIndex)
+{
+    // 親が変わったので、自分の行列は再計算が必要 (子孫は自分の再計算に合わせて再計算される)
+    m_hierarchy.SetParent(index, parentIndex);
+}
+
+
+void TransformSystem::ComputeWorldMatrix(uint32_t index, int32_t parentIndex)
+{
+    // 「自分のワールド変換行列」 = 「自分のローカル変換行列」
+    XMMATRIX localToWorldMatrix = GetLocalMatrix(index);
+
+    if (parentIndex >= 0)
+    {
+        // 「自分のワールド変換行列」 = 「自分のローカル変換行列」 × 「親のワールド変換行列」
+        localToWorldMatrix = XMMatrixMultiply(localToWorldMatrix, XMLoadFloat4x4A(&m_localToWorldMatrices[parentIndex]));
+    }
+
+    XMStoreFloat4x4A(&m_localToWorldMatrices[index], localToWorldMatrix);
+}
+
+
+void TransformSystem::UpdateWorldMatrix(uint32_t index)
+{
+    // 自分か祖先の行列が古い場合だけ、古いものを親から順番に再計算する
+    m_hierarchy.UpdateWorldMatrix(index, [this](uint32_t i, int32_t parentIndex) { ComputeWorldMatrix(i, parentIndex); });
+}
+
+
+void TransformSystem::UpdateWorldToLocalMatrix(uint32_t index)
+{
+    // 逆行列は必要になるまで計算しない
+    m_hierarchy.UpdateWorldToLocalMatrix(index,
+        [this](uint32_t i, int32_t parentIndex) { ComputeWorldMatrix(i, parentIndex); },
+        [this](uint32_t i)
+        {
+            const XMMATRIX localToWorldMatrix = XMLoadFloat4x4A(&m_localToWorldMatrices[i]);
+            XMStoreFloat4x4A(&m_worldToLocalMatrices[i], XMMatrixInverse(nullptr, localToWorldMatrix));
+        });
+}
+
+
+void TransformSystem::UpdateWorldMatrices()
+{
+    // 「親が子よりも前」の並び順が崩れていれば、先に並べ替える
+    if (m_hierarchy.IsOrderDirty())
+    {
+        SortParentBeforeChild();
+    }
+
+    // 行列は1つずつ、DirectXMath の XMMATRIX (4要素のSIMDレジスタ4本) で計算する。
+    // (複数の行列を1本のレジスタにまとめて計算するバッチ処理ではない。
+    //  親の行列を先に計算しておく必要があるので、並び順の通りに1回なめるだけの単純なループにしている)
+    // (前回から今回までの間に UpdateWorldMatrix() で個別に再計算されたものも、変化したTransformとして集める)
+    m_changedTransforms.clear();
+    m_hierarchy.UpdateWorldMatrices(
+        [this](uint32_t i, int32_t parentIndex) { ComputeWorldMatrix(i, parentIndex); },
+        [this](uint32_t i) { m_changedTransforms.push_back(m_transforms[i]); });
+}
+
+
+XMMATRIX XM_CALLCONV TransformSystem::GetLocalMatrix(uint32_t index) const
+{
+    const XMMATRIX rotationMatrix = XMMatrixRotationQuaternion(XMLoadFloat4(&m_localRotations[index]));
+    const XMVECTOR scale = XMLoadFloat3(&m_localScales[index]);
+
+    // 「スケーリング行列 × 回転行列」は、回転行列の各行をそれぞれの軸のスケールで拡大したものと同じなので、
+    // 行列の掛け算の代わりに、行毎のベクトルの掛け算で求める。
+    XMMATRIX localMatrix;
+    localMatrix.r[0] = XMVectorMultiply(rotationMatrix.r[0], XMVectorSplatX(scale));
+    localMatrix.r[1] = XMVectorMultiply(rotationMatrix.r[1], XMVectorSplatY(scale));
+    localMatrix.r[2] = XMVectorMultiply(rotationMatrix.r[2], XMVectorSplatZ(scale));
+
+    // 平行移動行列を掛ける代わりに4行目を直接書き換える (w成分だけ 1 にする)
+    //  |  1   0   0  0 |
+    //  |  0   1   0  0 |
+    //  |  0   0   1  0 |
+    //  | tx  ty  tz  1 |
+    localMatrix.r[3] = XMVectorSelect(g_XMIdentityR3, XMLoadFloat3(&m_localPositions[index]), g_XMSelect1110);
+    return localMatrix;
+}
+
+
+void TransformSystem::SortParentBeforeChild()
+{
+    // 親子関係から新しい並び順を求め、全ての配列を同じ順番に並べ替える
+    m_hierarchy.SortParentBeforeChild();
+    m_hierarchy.Reorder(m_transforms);
+    m_hierarchy.Reorder(m_localScales);
+    m_hierarchy.Reorder(m_localRotations);
+    m_hierarchy.Reorder(m_localPositions);
+    m_hierarchy.Reorder(m_localToWorldMatrices);
+    m_hierarchy.Reorder(m_worldToLocalMatrices);
+
+    // 各Transformに新しい格納位置を教える
+    const uint32_t count = GetCount();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        m_transforms[i]->m_index = i;
+    }
+}
@@ -0,0 +1,82 @@
+﻿#pragma once
+#include "TransformHierarchy.h"
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+// 前方宣言
+class Transform;
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// トランスフォームシステム
+//
+//      ・シーン内の全てのTransformのデータ(スケール、向き、位置、親、変換行列)を配列で一括管理するクラス。
+//      ・データは種類毎に連続した配列に格納される。(いわゆるSoA: Structure of Arrays)
+//      ・配列の並び順は「親が必ず子よりも前」になるように保たれる。
+//      ・その為、配列を先頭から1回なめるだけで、全ての古いワールド変換行列を再計算することができる。
+//      ・親子関係、並び順、行列が古いかどうかの判定は TransformHierarchy が受け持ち、このクラスは行列の計算を受け持つ。
+//      ・Transformクラスはこの配列の格納位置を持つだけのハンドルとして振る舞います。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class TransformSystem
+{
+private:
+    TransformHierarchy m_hierarchy;                                 // 親子関係と並び順、行列のバージョン番号
+    std::vector<Transform*> m_transforms;                           // 各要素に対応するTransformへの参照
+    std::vector<DirectX::XMFLOAT3> m_localScales;                   // スケール(x,y,z)
+    std::vector<DirectX::XMFLOAT4> m_localRotations;                // 向き(x,y,z,w)
+    std::vector<DirectX::XMFLOAT3> m_localPositions;                // 位置(x,y,z)
+    std::vector<DirectX::XMFLOAT4X4A> m_localToWorldMatrices;       // [ローカル → ワールド]変換行列
+    std::vector<DirectX::XMFLOAT4X4A> m_worldToLocalMatrices;       // [ワールド → ローカル]変換行列
+    std::vector<Transform*> m_changedTransforms;                    // 直前の UpdateWorldMatrices() で集めた、行列が変化したTransform
+    friend class Transform;                                         // Transformクラスは友達
+
+public:
+    // コンストラクタ
+    TransformSystem();
+
+    // 管理しているTransformの数を取得します。
+    uint32_t GetCount() const { return (uint32_t)m_transforms.size(); }
+
+    // 全てのTransformとの関連を切り、全てのデータを削除します。
+    //      ・シーンの破棄時に、Transformを任意の順番で破棄できるようにする為に使います。
+    void Clear();
+
+    // 古くなっている全てのワールド変換行列を一括で再計算します。
+    //      ・配列の先頭から順番に処理するので、親の行列は必ず子よりも先に計算済みになります。
+    //      ・行列は1つずつ XMMATRIX で計算します。 (複数の行列をまとめて計算するバッチ処理ではありません)
+    //      ・前回呼び出した時から行列が変化したTransform(個別に再計算されたものも含む)を集めます。
+    void UpdateWorldMatrices();
+
+    // 直前の UpdateWorldMatrices() で集めた、ワールド変換行列が変化したTransformのリストを取得します。
+    //      ・Transformが破棄されると宙ぶらりんになるので、UpdateWorldMatrices() の直後に使ってください。
+    const std::vector<Transform*>& GetChangedTransforms() const { return m_changedTransforms; }
+
+private:
+    // Transformを追加し、データの格納位置を返します。
+    uint32_t Add(Transform* transform);
+
+    // 指定した位置のTransformを削除します。
+    void Remove(uint32_t index);
+
+    // 指定した位置のTransformの親を設定します。
+    void SetParent(uint32_t index, int32_t parentIndex);
+
+    // 指定した位置のTransformの変換行列を再計算が必要な状態にします。 (子孫は親の再計算に合わせて再計算されます)
+    void SetDirty(uint32_t index) { m_hierarchy.SetDirty(index); }
+
+    // 指定した位置のワールド変換行列が古ければ再計算します。
+    void UpdateWorldMatrix(uint32_t index);
+
+    // 指定した位置のワールド変換行列の逆行列が古ければ再計算します。
+    void UpdateWorldToLocalMatrix(uint32_t index);
+
+    // 指定した位置のローカル行列(スケーリング×回転×平行移動)を取得します。
+    DirectX::XMMATRIX XM_CALLCONV GetLocalMatrix(uint32_t index) const;
+
+    // 指定した位置のワールド変換行列を計算します。 (親の行列は計算済みであること)
+    void ComputeWorldMatrix(uint32_t index, int32_t parentIndex);
+
+    // 「親が子よりも前」になるように配列を並べ替えます。
+    void SortParentBeforeChild();
+};
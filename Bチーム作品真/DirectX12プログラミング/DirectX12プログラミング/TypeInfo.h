@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include <string>
+#include <cstdint>
 
 // このゲームエンジン内で使用するデータ型を表す数値
 enum class TypeID
@@ -29,6 +30,30 @@ enum class TypeID
 };
 
 
+// コンポーネントのデータ型を表す連番
+//      ・GameObjectが持つコンポーネントテーブルの添え字として使う。
+//      ・基底クラスも含めた所有状況を32ビットのビットマスクで表すので、最大32種類まで。
+//      ・独自の連番を持たないスクリプトは MonoBehaviour として扱われる。
+enum class ComponentTypeIndex : uint32_t
+{
+    Component,
+    Transform,
+    Behaviour,
+    Camera,
+    MonoBehaviour,
+    Renderer,
+    SpriteRenderer,
+    AxisRenderer,
+    GridLinesRenderer,
+
+    MaxNumComponentTypes,
+};
+static_assert((uint32_t)ComponentTypeIndex::MaxNumComponentTypes <= 32, "コンポーネントの種類が多すぎます。");
+
+// コンポーネントのデータ型の連番をビットマスクに変換します。
+constexpr uint32_t ToComponentTypeMask(ComponentTypeIndex typeIndex) { return 1u << (uint32_t)typeIndex; }
+
+
 //---------------------------------------------------------------------------------------------------------------------------------------------
 // データ型に関する情報クラス
 // 
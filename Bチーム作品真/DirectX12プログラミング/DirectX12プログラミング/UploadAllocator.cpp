@@ -0,0 +1,70 @@
+﻿#include "UploadAllocator.h"
+#include "ConstantBuffer.h"
+#include <cstdio>
+#include <cassert>
+
+
+UploadAllocator::UploadAllocator(uint64_t capacity)
+    : m_allocator(capacity)
+    , m_pages()
+{
+    if (!AddPage(capacity))
+    {
+        assert(0);
+    }
+}
+
+
+UploadAllocator::~UploadAllocator()
+{
+    for (Page& page : m_pages)
+    {
+        page.buffer->Unmap();
+        page.buffer->Release();
+    }
+}
+
+
+UploadAllocator::Allocation UploadAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    assert((alignment & (alignment - 1)) == 0);
+
+    const LinearPageAllocator::Location location = m_allocator.Allocate(size, alignment);
+
+    // ページが追加されたら実体を作る
+    while (m_pages.size() < m_allocator.GetNumPages())
+    {
+        const uint64_t capacity = m_allocator.GetPageCapacity((uint32_t)m_pages.size());
+        if (capacity > UINT32_MAX || !AddPage(capacity))
+        {
+            printf("[失敗] アップロードアロケーターのページの作成 (要求: %llu バイト)\n", size);
+            assert(0);
+            return Allocation{ nullptr, 0 };
+        }
+        printf("[情報] アップロードアロケーターのページを追加しました (%u ページ, 合計 %llu バイト)\n", (uint32_t)m_pages.size(), m_allocator.GetCapacity());
+    }
+
+    const Page& page = m_pages[location.pageIndex];
+    Allocation allocation;
+    allocation.cpuAddress = page.mappedData + location.offset;
+    allocation.gpuAddress = page.gpuAddress + location.offset;
+    return allocation;
+}
+
+
+bool UploadAllocator::AddPage(uint64_t capacity)
+{
+    // 定数バッファと同じくアップロードヒープ上に作られるので、マップしたまま使える
+    // (バッファの先頭は64KiB境界に揃うので、ページの先頭から切り出した領域もアラインメントを満たす)
+    Page page;
+    page.buffer = new ConstantBuffer((uint32_t)capacity);
+    page.mappedData = (uint8_t*)page.buffer->Map();
+    if (page.mappedData == nullptr)
+    {
+        page.buffer->Release();
+        return false;
+    }
+    page.gpuAddress = page.buffer->GetNativeResource()->GetGPUVirtualAddress();
+    m_pages.push_back(page);
+    return true;
+}
@@ -0,0 +1,79 @@
+﻿#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include <vector>
+#include "LinearPageAllocator.h"
+
+// 前方宣言
+class ConstantBuffer;
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// アップロードアロケータークラス
+//
+//      ・1フレームの間だけ使う定数データなどを、大きなアップロードヒープバッファから先頭から順番に切り出して配るクラス。
+//      ・フレームリソース毎に1つ持ち、そのフレームのGPU処理の完了を待った後に Reset() で先頭に戻す。
+//        (GPUが読み終わるまで書き換えないので、前のフレームの内容を上書きしてしまうことはない)
+//      ・バッファは作成時にマップしたままにしておくので、確保の度に Map()/Unmap() する必要はない。
+//      ・確保した領域のGPU仮想アドレスは、そのまま SetGraphicsRootConstantBufferView() に渡せる。
+//      ・バッファに収まらない場合は、同じサイズのバッファ(ページ)を追加して続きを切り出す。
+//        追加したページは Reset() の後も残して使い回すので、ページが増えるのは使用量が初めて増えたフレームだけ。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class UploadAllocator
+{
+public:
+    static constexpr uint64_t DefaultCapacity = 1024 * 1024;                                    // 既定の1ページのサイズ (256バイトの定数バッファなら4096個分)
+    static constexpr uint64_t ConstantBufferAlignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT; // 定数バッファのアラインメント (256バイト)
+
+    // 確保した領域
+    struct Allocation
+    {
+        void* cpuAddress;                       // CPUから書き込む為のアドレス
+        D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;   // GPU仮想アドレス
+    };
+
+private:
+    // ページ
+    struct Page
+    {
+        ConstantBuffer* buffer;                 // アップロードヒープバッファ
+        uint8_t* mappedData;                    // バッファの先頭の、CPUから書き込む為のアドレス
+        D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;   // バッファの先頭のGPU仮想アドレス
+    };
+
+    LinearPageAllocator m_allocator;            // ページ内の位置の管理
+    std::vector<Page> m_pages;                  // ページの実体 (m_allocator のページと同じ順番)
+
+public:
+    // コンストラクタ (指定したサイズのアップロードヒープバッファを1ページ作成し、マップしたままにします)
+    UploadAllocator(uint64_t capacity = DefaultCapacity);
+
+    // デストラクタ
+    ~UploadAllocator();
+
+    // コピーは禁止
+    UploadAllocator(const UploadAllocator&) = delete;
+    UploadAllocator& operator=(const UploadAllocator&) = delete;
+
+    // 指定したサイズの領域を切り出します。
+    //      第1引数 : [in] サイズ (単位はバイト)
+    //      第2引数 : [in] アラインメント (2のべき乗。既定値は定数バッファのアラインメント)
+    //       戻り値 :      確保した領域 (ページの作成に失敗した場合だけ、cpuAddress が nullptr になります)
+    Allocation Allocate(uint64_t size, uint64_t alignment = ConstantBufferAlignment);
+
+    // 全ての領域を未使用に戻します。 (GPUがこのフレームの処理を完了した後に呼び出してください)
+    void Reset() { m_allocator.Reset(); }
+
+    // 全てのページのサイズの合計(単位はバイト)を取得します。
+    uint64_t GetCapacity() const { return m_allocator.GetCapacity(); }
+
+    // 使用中のサイズ(単位はバイト)を取得します。
+    uint64_t GetUsedSize() const { return m_allocator.GetUsedBytes(); }
+
+    // ページの数を取得します。
+    uint32_t GetNumPages() const { return (uint32_t)m_pages.size(); }
+
+private:
+    // ページを作成し、マップしたままにします。
+    bool AddPage(uint64_t capacity);
+};
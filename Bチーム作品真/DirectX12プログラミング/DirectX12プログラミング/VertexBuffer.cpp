@@ -1,12 +1,13 @@
 ﻿#include "VertexBuffer.h"
 #include <cassert>
 
-VertexBuffer::VertexBuffer(uint32_t vertexStride, uint32_t vertexCount, const void* initialData, ID3D12GraphicsCommandList* commandList)
+VertexBuffer::VertexBuffer(uint32_t vertexStride, uint32_t vertexCount, const void* initialData, ID3D12GraphicsCommandList* commandList, bool isDynamic)
     : BufferResource()
     , m_stride(vertexStride)
     , m_count(vertexCount)
 {
-    if (!CreateResource(BufferResourceType::VertexBuffer, (uint64_t)m_stride * m_count, initialData, commandList))
+    const BufferResourceType type = isDynamic ? BufferResourceType::DynamicVertexBuffer : BufferResourceType::VertexBuffer;
+    if (!CreateResource(type, (uint64_t)m_stride * m_count, initialData, commandList))
     {
         assert(0);
     }
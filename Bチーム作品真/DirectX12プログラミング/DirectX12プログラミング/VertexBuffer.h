@@ -21,7 +21,8 @@ public:
     //   第2引数 : [in] 頂点数
     //   第3引数 : [in] 初期化データ(不使用の場合は nullptr)
     //   第4引数 : [in] コピー時に使用されるコマンドリスト
-    VertexBuffer(uint32_t vertexStride, uint32_t vertexCount, const void* initialData = nullptr, ID3D12GraphicsCommandList* commandList = nullptr);
+    //   第5引数 : [in] CPUから毎フレーム書き換える場合は true (アップロードヒープ上に作成され、Map()で書き込んだ内容がそのままGPUから見える)
+    VertexBuffer(uint32_t vertexStride, uint32_t vertexCount, const void* initialData = nullptr, ID3D12GraphicsCommandList* commandList = nullptr, bool isDynamic = false);
 
     // 仮想デストラクタ
     virtual ~VertexBuffer() = default;
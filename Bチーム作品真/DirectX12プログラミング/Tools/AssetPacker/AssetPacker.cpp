@@ -0,0 +1,207 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// アセットパッカー
+//
+//      ・指定したディレクトリ以下の全てのファイルを、1つのアセットアーカイブ(.pak)にまとめるツール。
+//      ・ファイル形式とパスの正規化・ハッシュ値の計算は、ゲーム本体のアセットアーカイブ(AssetArchive)と同じ AssetArchiveFormat.h をそのまま使う。
+//      ・パスは指定したとおり(カレントディレクトリからの相対パス)に記録するので、ゲームの作業ディレクトリで実行すること。
+//      ・目次はパスのハッシュ値の順に並べるが、ファイルの中身はパスの順に並べる。
+//        (同じディレクトリのファイルはまとめてロードされることが多いので、アーカイブ内でも近くに置いて先読みが効くようにする)
+//
+//  使い方:
+//      AssetPacker <出力ファイル> <ディレクトリ>...
+//      (例: ゲームの作業ディレクトリで AssetPacker Assets.pak Assets)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "AssetArchiveFormat.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+
+// アーカイブに入れるファイル
+struct PackedFile
+{
+    std::filesystem::path sourcePath;   // ファイルへのパス
+    std::string normalizedPath;         // 正規化したパス (アーカイブに記録する)
+    AssetArchiveEntry entry;            // 目次の項目
+};
+
+
+// 値を alignment の倍数に切り上げる
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+
+// 指定したディレクトリ以下のファイルを集める
+static bool CollectFiles(const std::filesystem::path& directory, const std::filesystem::path& outputPath, std::vector<PackedFile>& files)
+{
+    std::error_code errorCode;
+    for (auto iterator = std::filesystem::recursive_directory_iterator(directory, errorCode); !errorCode && iterator != std::filesystem::recursive_directory_iterator(); iterator.increment(errorCode))
+    {
+        if (!iterator->is_regular_file())
+        {
+            continue;
+        }
+
+        // 書き出し中のアーカイブ自身は入れない
+        if (std::filesystem::equivalent(iterator->path(), outputPath, errorCode))
+        {
+            errorCode.clear();
+            continue;
+        }
+        errorCode.clear();
+
+        PackedFile file;
+        file.sourcePath = iterator->path();
+        file.normalizedPath = AssetArchiveFormat::NormalizePath(iterator->path().generic_string());
+        memset(&file.entry, 0, sizeof(file.entry));
+        file.entry.pathHash = AssetArchiveFormat::ComputePathHash(file.normalizedPath);
+        file.entry.size = iterator->file_size();
+        files.push_back(file);
+    }
+    if (errorCode)
+    {
+        printf("[失敗] ディレクトリを読み込めませんでした (%s)\n", directory.string().c_str());
+        return false;
+    }
+    return true;
+}
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        printf("使い方: AssetPacker <出力ファイル> <ディレクトリ>...\n");
+        return 1;
+    }
+    const std::filesystem::path outputPath = argv[1];
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<PackedFile> files;
+    for (int i = 2; i < argc; i++)
+    {
+        if (!CollectFiles(argv[i], outputPath, files))
+        {
+            return 1;
+        }
+    }
+
+    // ファイルの中身はパスの順に並べる
+    std::sort(files.begin(), files.end(), [](const PackedFile& a, const PackedFile& b) { return a.normalizedPath < b.normalizedPath; });
+    for (size_t i = 1; i < files.size(); i++)
+    {
+        if (files[i - 1].normalizedPath == files[i].normalizedPath)
+        {
+            printf("[失敗] 正規化すると同じパスになるファイルがあります (%s, %s)\n", files[i - 1].sourcePath.string().c_str(), files[i].sourcePath.string().c_str());
+            return 1;
+        }
+    }
+
+    // パス文字列表とファイルの中身の配置を決める
+    std::string pathTable;
+    for (PackedFile& file : files)
+    {
+        file.entry.pathOffset = (uint32_t)pathTable.size();
+        file.entry.pathLength = (uint32_t)file.normalizedPath.size();
+        pathTable += file.normalizedPath;
+    }
+
+    AssetArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = AssetArchiveFormat::FileMagic;
+    header.version = AssetArchiveFormat::FileVersion;
+    header.entryCount = (uint32_t)files.size();
+    header.tocOffset = sizeof(AssetArchiveHeader);
+    header.pathTableOffset = header.tocOffset + files.size() * sizeof(AssetArchiveEntry);
+    header.pathTableSize = pathTable.size();
+
+    uint64_t offset = AlignUp(header.pathTableOffset + header.pathTableSize, AssetArchiveFormat::DataAlignment);
+    for (PackedFile& file : files)
+    {
+        file.entry.offset = offset;
+        offset = AlignUp(offset + file.entry.size, AssetArchiveFormat::DataAlignment);
+    }
+    header.fileSize = offset;
+
+    // 目次はハッシュ値の順に並べる (ハッシュ値が同じ場合はパスの順)
+    std::vector<const PackedFile*> toc;
+    for (const PackedFile& file : files)
+    {
+        toc.push_back(&file);
+    }
+    std::sort(toc.begin(), toc.end(), [](const PackedFile* a, const PackedFile* b)
+    {
+        return (a->entry.pathHash != b->entry.pathHash) ? (a->entry.pathHash < b->entry.pathHash) : (a->normalizedPath < b->normalizedPath);
+    });
+
+    // アーカイブの書き出し
+    // (途中で失敗したファイルが残らないように、一時ファイルに書き出してから名前を変える)
+    std::filesystem::path temporaryPath = outputPath;
+    temporaryPath += ".tmp";
+    bool succeeded = true;
+    {
+        std::ofstream output(temporaryPath, std::ios::binary);
+        output.write((const char*)&header, sizeof(header));
+        for (const PackedFile* file : toc)
+        {
+            output.write((const char*)&file->entry, sizeof(file->entry));
+        }
+        output.write(pathTable.data(), (std::streamsize)pathTable.size());
+
+        std::vector<char> buffer;
+        for (const PackedFile& file : files)
+        {
+            std::ifstream input(file.sourcePath, std::ios::binary);
+            buffer.resize((size_t)file.entry.size);
+            if (!input.read(buffer.data(), (std::streamsize)buffer.size()))
+            {
+                printf("[失敗] %s を読み込めませんでした\n", file.sourcePath.string().c_str());
+                succeeded = false;
+                break;
+            }
+
+            // 前のファイルの末尾から4KiB境界までを0で埋める
+            const uint64_t position = (uint64_t)output.tellp();
+            const std::vector<char> padding((size_t)(file.entry.offset - position), 0);
+            output.write(padding.data(), (std::streamsize)padding.size());
+            output.write(buffer.data(), (std::streamsize)buffer.size());
+        }
+
+        const uint64_t position = (uint64_t)output.tellp();
+        const std::vector<char> padding((size_t)(header.fileSize - position), 0);
+        output.write(padding.data(), (std::streamsize)padding.size());
+        succeeded = succeeded && (bool)output;
+    }
+
+    std::error_code errorCode;
+    if (succeeded)
+    {
+        std::filesystem::rename(temporaryPath, outputPath, errorCode);
+        succeeded = !errorCode;
+    }
+    if (!succeeded)
+    {
+        std::filesystem::remove(temporaryPath, errorCode);
+        printf("[失敗] %s の書き込み\n", outputPath.string().c_str());
+        return 1;
+    }
+
+    uint64_t payloadBytes = 0;
+    for (const PackedFile& file : files)
+    {
+        payloadBytes += file.entry.size;
+    }
+    const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    printf("[情報] %s : %zu 個 / %.2f MB (アラインメントの隙間 %.2f MB) / %.2f ms\n", outputPath.string().c_str(), files.size(),
+        header.fileSize / (1024.0 * 1024.0), (header.fileSize - payloadBytes) / (1024.0 * 1024.0), milliseconds);
+    return 0;
+}
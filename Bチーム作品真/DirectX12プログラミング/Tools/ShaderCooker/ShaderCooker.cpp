@@ -0,0 +1,402 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// シェーダークッカー
+//
+//      ・シェーダーリストに書かれた全てのシェーダーを DXC でコンパイルし、シェーダーキャッシュファイルを作成するツール。
+//      ・キャッシュファイルの名前と中身は、ゲーム本体のシェーダーキャッシュ(ShaderCache)が読み込む形式と同じ。
+//        (キーの計算には ShaderCacheKey.h をそのまま使う)
+//      ・キーが一致するキャッシュファイルが既にあるシェーダーはコンパイルしない。
+//      ・コンパイルは論理コア数と同じ数のスレッドで並列に行う。
+//      ・DXC (libdxcompiler.so) は実行時に dlopen() で読み込む。
+//        DXIL に署名する為に、同じディレクトリに libdxil.so も置いておくこと。
+//
+//  使い方:
+//      ShaderCooker <シェーダーリスト> <出力ディレクトリ> [--dxc <libdxcompiler.soへのパス>]
+//
+//  シェーダーリストの書式 (1行に1シェーダー。 '#' から行末まではコメント):
+//      <HLSLファイルへのパス(シェーダーリストからの相対パス)> <シェーダープロファイル> <エントリーポイント関数名> [マクロ名=定義値 ...]
+//
+//  ※DXC はシェーダーモデル 6.0 以降にしか対応していないので、5.x のプロファイル(例: vs_5_1)は 6.0 (例: vs_6_0) でコンパイルする。
+//    キーは実際にコンパイルしたプロファイル(6.0)とバイトコードの形式(DXIL)で計算する。
+//    ゲーム本体が 5.x のプロファイルで要求した場合は、FXC で DXBC にコンパイルした別のキーのファイルが使われる。
+//    (クックしたものを使うには、ゲーム本体からも 6.0 以降のプロファイルで要求すること)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "ShaderCacheKey.h"
+#include "dxc/dxcapi.h"
+#include <dlfcn.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+
+// シェーダーリストの1行分
+struct ShaderEntry
+{
+    std::filesystem::path path;         // HLSLファイルへのパス
+    std::string shaderProfile;          // シェーダープロファイル
+    std::string entryPointName;         // エントリーポイント関数名
+    std::vector<ShaderDefine> defines;  // マクロ定義
+    uint32_t lineNumber;                // シェーダーリスト内での行番号
+};
+
+
+// 処理結果
+enum class CookResult
+{
+    UpToDate,                           // キャッシュファイルが最新なのでコンパイルしなかった
+    Compiled,                           // コンパイルしてキャッシュファイルを書き出した
+    Failed,                             // 失敗した
+};
+
+
+static DxcCreateInstanceProc s_dxcCreateInstance = nullptr;     // DXC のインスタンス作成関数
+static std::mutex s_printMutex;                                 // コンソール出力が混ざらないようにする
+
+
+// ASCII文字列をワイド文字列に変換する (DXC の引数用)
+static std::wstring Widen(const std::string& string)
+{
+    return std::wstring(string.begin(), string.end());
+}
+
+
+// DXC に渡すシェーダープロファイルを取得する (シェーダーモデル 5.x は 6.0 に置き換える)
+static std::string GetDxcShaderProfile(const std::string& shaderProfile)
+{
+    const size_t separator = shaderProfile.find('_');
+    if ((separator != std::string::npos) && (shaderProfile.compare(separator + 1, 1, "5") == 0))
+    {
+        return shaderProfile.substr(0, separator) + "_6_0";
+    }
+    return shaderProfile;
+}
+
+
+// シェーダーリストを読み込む
+static bool ReadShaderList(const std::filesystem::path& listPath, std::vector<ShaderEntry>& entries)
+{
+    std::ifstream file(listPath);
+    if (!file)
+    {
+        printf("[失敗] シェーダーリストを開けませんでした (%s)\n", listPath.string().c_str());
+        return false;
+    }
+
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+
+        // Visual Studio で保存すると先頭に UTF-8 の BOM が付くので取り除く
+        if ((lineNumber == 1) && (line.compare(0, 3, "\xEF\xBB\xBF") == 0))
+        {
+            line.erase(0, 3);
+        }
+
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+
+        std::istringstream stream(line);
+        std::string path;
+        if (!(stream >> path))
+        {
+            continue;
+        }
+
+        ShaderEntry entry;
+        entry.path = listPath.parent_path() / path;
+        entry.lineNumber = lineNumber;
+        if (!(stream >> entry.shaderProfile >> entry.entryPointName))
+        {
+            printf("[失敗] シェーダーリストの %u 行目の書式が正しくありません\n", lineNumber);
+            return false;
+        }
+
+        std::string define;
+        while (stream >> define)
+        {
+            const size_t equal = define.find('=');
+            if (equal == std::string::npos)
+            {
+                entry.defines.push_back({ define, "1" });
+            }
+            else
+            {
+                entry.defines.push_back({ define.substr(0, equal), define.substr(equal + 1) });
+            }
+        }
+
+        // 置き換えたプロファイルで作成したファイルは、ゲーム本体が元のプロファイルで要求しても使われない
+        const std::string dxcShaderProfile = GetDxcShaderProfile(entry.shaderProfile);
+        if (dxcShaderProfile != entry.shaderProfile)
+        {
+            printf("[警告] シェーダーリストの %u 行目の %s は %s でコンパイルします (ゲーム本体からも %s で要求しないと使われません)\n",
+                lineNumber, entry.shaderProfile.c_str(), dxcShaderProfile.c_str(), dxcShaderProfile.c_str());
+        }
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+
+// キーが一致するキャッシュファイルが既にある場合は true を返す
+static bool IsUpToDate(const std::filesystem::path& outputPath, uint64_t key, ShaderBytecodeFormat format)
+{
+    std::ifstream file(outputPath, std::ios::binary);
+    ShaderCacheFileHeader header;
+    if (!file.read((char*)&header, sizeof(header)))
+    {
+        return false;
+    }
+    return (header.magic == ShaderCacheKey::FileMagic) && (header.version == ShaderCacheKey::FileVersion) && (header.key == key) && (header.format == format) && (header.bytecodeSize > 0);
+}
+
+
+// 1つのシェーダーをコンパイルしてキャッシュファイルを書き出す
+static CookResult CookShader(const ShaderEntry& entry, const std::filesystem::path& outputDirectory, IDxcCompiler3* compiler, IDxcIncludeHandler* includeHandler)
+{
+    // キーは実際にコンパイルするプロファイルで計算する (DXC の出力は常に DXIL)
+    const std::string shaderProfile = GetDxcShaderProfile(entry.shaderProfile);
+    const ShaderBytecodeFormat format = ShaderCacheKey::GetBytecodeFormat(shaderProfile);
+    uint64_t key = 0;
+    if (!ShaderCacheKey::Compute(entry.path, shaderProfile, entry.entryPointName, entry.defines, &key))
+    {
+        std::lock_guard<std::mutex> lock(s_printMutex);
+        printf("[失敗] %s (またはインクルードしているファイル)を読み込めませんでした\n", entry.path.string().c_str());
+        return CookResult::Failed;
+    }
+
+    const std::filesystem::path outputPath = outputDirectory / ShaderCacheKey::MakeFileName(key);
+    if (IsUpToDate(outputPath, key, format))
+    {
+        return CookResult::UpToDate;
+    }
+
+    // ソースファイルの読み込み
+    std::ifstream file(entry.path, std::ios::binary);
+    const std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // 引数の作成 (インクルードファイルはソースファイルと同じディレクトリから探す)
+    std::vector<std::wstring> arguments;
+    arguments.push_back(Widen(entry.path.filename().string()));
+    arguments.push_back(L"-E");
+    arguments.push_back(Widen(entry.entryPointName));
+    arguments.push_back(L"-T");
+    arguments.push_back(Widen(shaderProfile));
+    arguments.push_back(L"-I");
+    arguments.push_back(Widen(entry.path.parent_path().string()));
+    for (const ShaderDefine& define : entry.defines)
+    {
+        arguments.push_back(L"-D");
+        arguments.push_back(Widen(define.name + "=" + define.value));
+    }
+    std::vector<LPCWSTR> argumentPointers;
+    for (const std::wstring& argument : arguments)
+    {
+        argumentPointers.push_back(argument.c_str());
+    }
+
+    DxcBuffer sourceBuffer;
+    sourceBuffer.Ptr = source.data();
+    sourceBuffer.Size = source.size();
+    sourceBuffer.Encoding = DXC_CP_ACP;
+
+    IDxcResult* result = nullptr;
+    HRESULT status = E_FAIL;
+    if (SUCCEEDED(compiler->Compile(&sourceBuffer, argumentPointers.data(), (UINT32)argumentPointers.size(), includeHandler, __uuidof(IDxcResult), (void**)&result)))
+    {
+        result->GetStatus(&status);
+    }
+
+    if (FAILED(status))
+    {
+        std::lock_guard<std::mutex> lock(s_printMutex);
+        printf("[失敗] %s (%s, %s) のコンパイル\n", entry.path.string().c_str(), entry.shaderProfile.c_str(), entry.entryPointName.c_str());
+        IDxcBlobUtf8* errors = nullptr;
+        if (result && SUCCEEDED(result->GetOutput(DXC_OUT_ERRORS, __uuidof(IDxcBlobUtf8), (void**)&errors, nullptr)) && errors)
+        {
+            printf("%s\n", errors->GetStringPointer());
+            errors->Release();
+        }
+        if (result)
+        {
+            result->Release();
+        }
+        return CookResult::Failed;
+    }
+
+    IDxcBlob* object = nullptr;
+    const HRESULT outputStatus = result->GetOutput(DXC_OUT_OBJECT, __uuidof(IDxcBlob), (void**)&object, nullptr);
+    result->Release();
+    if (FAILED(outputStatus) || !object || object->GetBufferSize() == 0)
+    {
+        std::lock_guard<std::mutex> lock(s_printMutex);
+        printf("[失敗] %s (%s, %s) のバイトコードを取得できませんでした\n", entry.path.string().c_str(), entry.shaderProfile.c_str(), entry.entryPointName.c_str());
+        if (object)
+        {
+            object->Release();
+        }
+        return CookResult::Failed;
+    }
+
+    // キャッシュファイルの書き出し
+    // (途中で失敗したファイルが残らないように、一時ファイルに書き出してから名前を変える)
+    ShaderCacheFileHeader header;
+    header.magic = ShaderCacheKey::FileMagic;
+    header.version = ShaderCacheKey::FileVersion;
+    header.key = key;
+    header.bytecodeSize = object->GetBufferSize();
+    header.format = format;
+    header.reserved = 0;
+
+    std::filesystem::path temporaryPath = outputPath;
+    temporaryPath += ".tmp";
+    bool succeeded;
+    {
+        std::ofstream output(temporaryPath, std::ios::binary);
+        output.write((const char*)&header, sizeof(header));
+        output.write((const char*)object->GetBufferPointer(), (std::streamsize)object->GetBufferSize());
+        succeeded = (bool)output;
+    }
+    object->Release();
+
+    std::error_code errorCode;
+    if (succeeded)
+    {
+        std::filesystem::rename(temporaryPath, outputPath, errorCode);
+        succeeded = !errorCode;
+    }
+
+    std::lock_guard<std::mutex> lock(s_printMutex);
+    if (!succeeded)
+    {
+        std::filesystem::remove(temporaryPath, errorCode);
+        printf("[失敗] %s の書き込み\n", outputPath.string().c_str());
+        return CookResult::Failed;
+    }
+    printf("[成功] %s (%s, %s) → %s\n", entry.path.string().c_str(), shaderProfile.c_str(), entry.entryPointName.c_str(), outputPath.filename().string().c_str());
+    return CookResult::Compiled;
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> positionalArguments;
+    std::string dxcLibraryPath = "libdxcompiler.so";
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--dxc") == 0) && (i + 1 < argc))
+        {
+            dxcLibraryPath = argv[++i];
+        }
+        else
+        {
+            positionalArguments.push_back(argv[i]);
+        }
+    }
+    if (positionalArguments.size() != 2)
+    {
+        printf("使い方: ShaderCooker <シェーダーリスト> <出力ディレクトリ> [--dxc <libdxcompiler.soへのパス>]\n");
+        return 1;
+    }
+    const std::filesystem::path listPath = positionalArguments[0];
+    const std::filesystem::path outputDirectory = positionalArguments[1];
+
+    std::vector<ShaderEntry> entries;
+    if (!ReadShaderList(listPath, entries))
+    {
+        return 1;
+    }
+
+    // DXC の読み込み
+    void* dxcLibrary = dlopen(dxcLibraryPath.c_str(), RTLD_NOW);
+    if (!dxcLibrary)
+    {
+        printf("[失敗] DXC を読み込めませんでした (%s)\n", dlerror());
+        return 1;
+    }
+    s_dxcCreateInstance = (DxcCreateInstanceProc)dlsym(dxcLibrary, "DxcCreateInstance");
+    if (!s_dxcCreateInstance)
+    {
+        printf("[失敗] DxcCreateInstance が見つかりませんでした\n");
+        return 1;
+    }
+
+    std::error_code errorCode;
+    std::filesystem::create_directories(outputDirectory, errorCode);
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    // 論理コア数と同じ数のスレッドで、シェーダーリストの先頭から順番に取り出して処理する
+    // (DXC のインスタンスはスレッド間で共有できないので、スレッド毎に作成する)
+    std::atomic<uint32_t> nextIndex(0);
+    std::atomic<uint32_t> numCompiled(0);
+    std::atomic<uint32_t> numUpToDate(0);
+    std::atomic<uint32_t> numFailed(0);
+    auto worker = [&]()
+    {
+        IDxcUtils* utils = nullptr;
+        IDxcCompiler3* compiler = nullptr;
+        IDxcIncludeHandler* includeHandler = nullptr;
+        if (FAILED(s_dxcCreateInstance(CLSID_DxcUtils, __uuidof(IDxcUtils), (void**)&utils)) ||
+            FAILED(s_dxcCreateInstance(CLSID_DxcCompiler, __uuidof(IDxcCompiler3), (void**)&compiler)) ||
+            FAILED(utils->CreateDefaultIncludeHandler(&includeHandler)))
+        {
+            std::lock_guard<std::mutex> lock(s_printMutex);
+            printf("[失敗] DXC のインスタンスの作成\n");
+            numFailed++;
+        }
+        else
+        {
+            for (uint32_t i = nextIndex++; i < entries.size(); i = nextIndex++)
+            {
+                switch (CookShader(entries[i], outputDirectory, compiler, includeHandler))
+                {
+                case CookResult::UpToDate:  numUpToDate++; break;
+                case CookResult::Compiled:  numCompiled++; break;
+                case CookResult::Failed:    numFailed++; break;
+                }
+            }
+        }
+
+        if (includeHandler) includeHandler->Release();
+        if (compiler) compiler->Release();
+        if (utils) utils->Release();
+    };
+
+    uint32_t numThreads = std::thread::hardware_concurrency();
+    if (numThreads == 0)
+    {
+        numThreads = 1;
+    }
+    if (numThreads > entries.size())
+    {
+        numThreads = (uint32_t)entries.size();
+    }
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < numThreads; i++)
+    {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    printf("[情報] コンパイル %u 個 / 最新 %u 個 / 失敗 %u 個 (%u スレッド, %.2f ms)\n",
+        numCompiled.load(), numUpToDate.load(), numFailed.load(), numThreads, milliseconds);
+    return (numFailed > 0) ? 1 : 0;
+}
@@ -0,0 +1,193 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// アセットアーカイブのベンチマーク
+//
+//      ・ぷよぷよ「メイン画面」の LoadAssets() がロードするテクスチャを、個別のファイルとアセットアーカイブから読み、時間を比べる。
+//        (Texture2D::LoadFromFile() と同じく、個別のファイルは変換済みの .dds を探してから開き、アーカイブは目次から探す)
+//      ・コールドはページキャッシュから追い出した直後の1回目、ウォームは続けて読んだ場合の平均。
+//      ・画像のデコードとテクスチャの作成は含まない。 (ファイルを読み終えるまでの時間だけを計る)
+//      ・アーカイブは AssetArchive と同じくファイル全体をマップし、中身のページに触れて読み込ませる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "AssetArchiveFormat.h"
+#include "Test.h"
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+
+// LoadAssets() がロードするテクスチャ (PuyoPuyo.MainScene.cpp / PuyoPuyo.PlayerController.cpp / PuyoPuyo.System.cpp)
+static const char* const TextureFiles[] =
+{
+    "Assets/PuyoPuyo/Textures/ingame_bg/bg_0001.tzip/stg_puzzlearena_night01_bc3.png",
+    "Assets/PuyoPuyo/Textures/ingame_bg/bg_0001.tzip/stg_puzzlearena_night02_bc3.png",
+    "Assets/PuyoPuyo/Textures/puyo/field_bg2p/field_bg2p_arl.tzip/field_arl.png",
+    "Assets/PuyoPuyo/Textures/puyo/puyo2P/puyo2P.tzip/pla_next_d4444.png",
+    "Assets/PuyoPuyo/Textures/puyo/puyo2P/puyo2P.tzip/pla_username_d4444.png",
+    "Assets/PuyoPuyo/Textures/puyo/puyo2P/puyo2P.tzip/win_field_puyo_d4444.png",
+    "Assets/PuyoPuyo/Textures/puyo/puyo2P/puyo_aqua.png",
+};
+static const size_t NumTextureFiles = sizeof(TextureFiles) / sizeof(TextureFiles[0]);
+
+
+// ファイルをページキャッシュから追い出す
+static void EvictFromPageCache(const std::filesystem::path& path)
+{
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file >= 0)
+    {
+        fdatasync(file);
+        posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+        close(file);
+    }
+}
+
+
+// 個別のファイルから全てのテクスチャを読み、読んだバイト数を返す
+static uint64_t LoadLooseFiles(const std::filesystem::path& directory, std::vector<std::vector<uint8_t>>& contents)
+{
+    uint64_t totalBytes = 0;
+    for (size_t i = 0; i < NumTextureFiles; i++)
+    {
+        // 変換済みの .dds は無いので、探すだけで見つからない
+        const std::filesystem::path relativePath = std::filesystem::path(TextureFiles[i]).lexically_relative("Assets");
+        std::error_code errorCode;
+        TEST_CHECK(!std::filesystem::exists((directory / "Assets/CookedTextures" / relativePath).replace_extension(".dds"), errorCode));
+
+        // ファイル全体を1回で読む
+        std::ifstream input(directory / TextureFiles[i], std::ios::binary | std::ios::ate);
+        contents[i].resize((size_t)input.tellg());
+        input.seekg(0);
+        input.read((char*)contents[i].data(), (std::streamsize)contents[i].size());
+        TEST_CHECK(input.good());
+        totalBytes += contents[i].size();
+    }
+    return totalBytes;
+}
+
+
+// アーカイブをマップして全てのテクスチャを探し、中身のページに触れて読み込ませる (読んだバイト数を返す)
+//   ・expectedContents を指定した場合は、中身が個別のファイルと同じことも確かめる。 (計測する場合は指定しない)
+static uint64_t LoadFromArchive(const std::filesystem::path& archivePath, const std::vector<std::vector<uint8_t>>* expectedContents)
+{
+    const int file = open(archivePath.c_str(), O_RDONLY);
+    TEST_CHECK(file >= 0);
+    if (file < 0)
+    {
+        return 0;
+    }
+    const uint64_t archiveSize = (uint64_t)lseek(file, 0, SEEK_END);
+    void* mappedView = mmap(nullptr, (size_t)archiveSize, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    TEST_CHECK(mappedView != MAP_FAILED);
+    if (mappedView == MAP_FAILED)
+    {
+        return 0;
+    }
+
+    const uint8_t* archive = (const uint8_t*)mappedView;
+    uint64_t totalBytes = 0;
+    TEST_CHECK(AssetArchiveFormat::Validate(archive, archiveSize));
+    for (size_t i = 0; i < NumTextureFiles; i++)
+    {
+        const AssetArchiveEntry* entry = AssetArchiveFormat::FindEntry(archive, AssetArchiveFormat::NormalizePath(TextureFiles[i]));
+        TEST_CHECK(entry != nullptr);
+        if (!entry)
+        {
+            continue;
+        }
+
+        // ページ毎に1バイト読めば、そのページはファイルから読み込まれる
+        volatile uint8_t sum = 0;
+        for (uint64_t offset = 0; offset < entry->size; offset += 4096)
+        {
+            sum += archive[entry->offset + offset];
+        }
+        if (expectedContents)
+        {
+            const std::vector<uint8_t>& expected = (*expectedContents)[i];
+            TEST_CHECK((entry->size == expected.size()) && (memcmp(archive + entry->offset, expected.data(), expected.size()) == 0));
+        }
+        totalBytes += entry->size;
+    }
+
+    munmap(mappedView, (size_t)archiveSize);
+    return totalBytes;
+}
+
+
+// 関数の実行時間 (ミリ秒) を計る
+template<typename Function>
+static double Measure(const Function& function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+int main()
+{
+    const uint32_t numWarmRuns = 50;
+
+    // テクスチャを一時ディレクトリに写して、アセットパッカーでアーカイブにまとめる
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "AssetArchiveBenchmark";
+    std::filesystem::remove_all(directory);
+    for (size_t i = 0; i < NumTextureFiles; i++)
+    {
+        const std::filesystem::path path = directory / TextureFiles[i];
+        std::filesystem::create_directories(path.parent_path());
+        std::filesystem::copy_file(std::filesystem::path(ENGINE_SOURCE_DIR) / TextureFiles[i], path);
+    }
+    const std::filesystem::path previousDirectory = std::filesystem::current_path();
+    std::filesystem::current_path(directory);
+    const int exitCode = std::system("\"" ASSET_PACKER_PATH "\" Assets.pak Assets > /dev/null");
+    std::filesystem::current_path(previousDirectory);
+    TEST_CHECK(exitCode == 0);
+    const std::filesystem::path archivePath = directory / "Assets.pak";
+
+    // コールド (ページキャッシュから追い出した直後)
+    std::vector<std::vector<uint8_t>> contents(NumTextureFiles);
+    uint64_t looseBytes = 0;
+    uint64_t archiveBytes = 0;
+    for (size_t i = 0; i < NumTextureFiles; i++)
+    {
+        EvictFromPageCache(directory / TextureFiles[i]);
+    }
+    EvictFromPageCache(archivePath);
+    const double coldLooseMilliseconds = Measure([&]() { looseBytes = LoadLooseFiles(directory, contents); });
+    const double coldArchiveMilliseconds = Measure([&]() { archiveBytes = LoadFromArchive(archivePath, nullptr); });
+    TEST_CHECK(looseBytes == archiveBytes);
+    TEST_CHECK(LoadFromArchive(archivePath, &contents) == looseBytes);
+
+    // ウォーム (ページキャッシュに載っている)
+    const double warmLooseMilliseconds = Measure([&]()
+    {
+        for (uint32_t i = 0; i < numWarmRuns; i++)
+        {
+            LoadLooseFiles(directory, contents);
+        }
+    }) / numWarmRuns;
+    const double warmArchiveMilliseconds = Measure([&]()
+    {
+        for (uint32_t i = 0; i < numWarmRuns; i++)
+        {
+            LoadFromArchive(archivePath, nullptr);
+        }
+    }) / numWarmRuns;
+
+    printf("[情報] テクスチャ %zu 枚 / %.2f MB\n", NumTextureFiles, looseBytes / (1024.0 * 1024.0));
+    printf("[情報] %10s %14s %14s\n", "", "個別のファイル", "アーカイブ");
+    printf("[情報] %10s %11.3f ms %11.3f ms\n", "コールド", coldLooseMilliseconds, coldArchiveMilliseconds);
+    printf("[情報] %10s %11.3f ms %11.3f ms\n", "ウォーム", warmLooseMilliseconds, warmArchiveMilliseconds);
+
+    std::filesystem::remove_all(directory);
+    return TestResult("AssetArchiveBenchmark");
+}
@@ -0,0 +1,193 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// アセットアーカイブのテスト
+//
+//      ・パスの正規化(区切り文字・"."・".."・英字の大文字小文字)と、FNV-1a 64ビットのハッシュ値を確かめる。
+//      ・アセットパッカー(Tools/AssetPacker)で一時ディレクトリのファイルをアーカイブにまとめ、
+//        大文字や '\' を含むパスで全てのファイルが見つかり、中身が4KiB境界に元のとおり置かれていることを確かめる。
+//      ・ヘッダーや目次を壊したアーカイブを Validate() が拒否し、ハッシュ値が同じ項目はパス文字列で見分けることを確かめる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "AssetArchiveFormat.h"
+#include "Test.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+
+
+// アーカイブに入れるファイル
+struct TestFile
+{
+    const char* path;                   // アセットパッカーに渡すディレクトリからのパス
+    const char* query;                  // ゲームから探す時のパス (正規化する前)
+    size_t size;                        // 中身のサイズ
+};
+
+static const TestFile TestFiles[] =
+{
+    { "Assets/Stage(B)/Back1.jpg", "Assets\\Stage(B)\\BACK1.JPG", 5000 },
+    { "Assets/Sprite/Player.png", "./Assets/Sprite/../Sprite/Player.png", 4096 },
+    { "Assets/テクスチャ/A.dds", "ASSETS/テクスチャ/a.DDS", 1 },
+    { "Assets/Empty.txt", "assets//empty.txt", 0 },
+};
+
+
+// ファイルの中身 (ファイル毎に違う並びにする)
+static std::string MakeContents(size_t fileIndex, size_t size)
+{
+    std::string contents(size, '\0');
+    for (size_t i = 0; i < size; i++)
+    {
+        contents[i] = (char)(fileIndex * 37 + i * 11);
+    }
+    return contents;
+}
+
+
+// パスの正規化
+static void TestNormalizePath()
+{
+    TEST_CHECK(AssetArchiveFormat::NormalizePath("Assets\\Stage(B)\\Back1.JPG") == "assets/stage(b)/back1.jpg");
+    TEST_CHECK(AssetArchiveFormat::NormalizePath("./a/./b/../c") == "a/c");
+    TEST_CHECK(AssetArchiveFormat::NormalizePath("../a/b/../../..") == "");
+    TEST_CHECK(AssetArchiveFormat::NormalizePath("a//b/") == "a/b");
+    TEST_CHECK(AssetArchiveFormat::NormalizePath("") == "");
+
+    // 英字以外(UTF-8の複数バイト文字など)はそのまま
+    TEST_CHECK(AssetArchiveFormat::NormalizePath("Assets/テクスチャ/A.DDS") == "assets/テクスチャ/a.dds");
+}
+
+
+// FNV-1a 64ビットの既知の値
+static void TestPathHash()
+{
+    TEST_CHECK(AssetArchiveFormat::ComputePathHash("") == 0xCBF29CE484222325ULL);
+    TEST_CHECK(AssetArchiveFormat::ComputePathHash("a") == 0xAF63DC4C8601EC8CULL);
+    TEST_CHECK(AssetArchiveFormat::ComputePathHash("foobar") == 0x85944171F73967E8ULL);
+}
+
+
+// アセットパッカーでアーカイブを作成し、中身を読み込みます。
+static std::vector<uint8_t> PackTestFiles(const std::filesystem::path& directory)
+{
+    for (size_t i = 0; i < sizeof(TestFiles) / sizeof(TestFiles[0]); i++)
+    {
+        const std::filesystem::path path = directory / std::filesystem::u8path(TestFiles[i].path);
+        std::filesystem::create_directories(path.parent_path());
+        const std::string contents = MakeContents(i, TestFiles[i].size);
+        std::ofstream(path, std::ios::binary).write(contents.data(), (std::streamsize)contents.size());
+    }
+
+    // パスはアセットパッカーに渡したとおりに記録されるので、作業ディレクトリを変えて実行する
+    const std::filesystem::path previousDirectory = std::filesystem::current_path();
+    std::filesystem::current_path(directory);
+    const int exitCode = std::system("\"" ASSET_PACKER_PATH "\" Test.pak Assets");
+    std::filesystem::current_path(previousDirectory);
+    TEST_CHECK(exitCode == 0);
+
+    std::ifstream input(directory / "Test.pak", std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+
+
+// アセットパッカーで作ったアーカイブから全てのファイルが見つかること
+static void TestPackedArchive(const std::vector<uint8_t>& archive)
+{
+    TEST_CHECK(AssetArchiveFormat::Validate(archive.data(), archive.size()));
+    if (!AssetArchiveFormat::Validate(archive.data(), archive.size()))
+    {
+        return;
+    }
+
+    const AssetArchiveHeader* header = (const AssetArchiveHeader*)archive.data();
+    TEST_CHECK(header->entryCount == sizeof(TestFiles) / sizeof(TestFiles[0]));
+    TEST_CHECK(header->fileSize % AssetArchiveFormat::DataAlignment == 0);
+
+    for (size_t i = 0; i < sizeof(TestFiles) / sizeof(TestFiles[0]); i++)
+    {
+        const AssetArchiveEntry* entry = AssetArchiveFormat::FindEntry(archive.data(), AssetArchiveFormat::NormalizePath(TestFiles[i].query));
+        TEST_CHECK(entry != nullptr);
+        if (!entry)
+        {
+            continue;
+        }
+        TEST_CHECK(entry->offset % AssetArchiveFormat::DataAlignment == 0);
+        TEST_CHECK(entry->size == TestFiles[i].size);
+        TEST_CHECK(std::string((const char*)archive.data() + entry->offset, (size_t)entry->size) == MakeContents(i, TestFiles[i].size));
+    }
+
+    // 入っていないファイルと、正規化していないパスは見つからない
+    TEST_CHECK(AssetArchiveFormat::FindEntry(archive.data(), "assets/sprite/enemy.png") == nullptr);
+    TEST_CHECK(AssetArchiveFormat::FindEntry(archive.data(), "Assets/Sprite/Player.png") == nullptr);
+}
+
+
+// 壊れたアーカイブを拒否すること
+static void TestCorruptedArchive(const std::vector<uint8_t>& archive)
+{
+    const uint64_t tocOffset = ((const AssetArchiveHeader*)archive.data())->tocOffset;
+
+    // 壊したコピーを作って確かめる
+    auto isValidAfter = [&](auto corrupt)
+    {
+        std::vector<uint8_t> copy = archive;
+        corrupt(copy, (AssetArchiveHeader*)copy.data(), (AssetArchiveEntry*)(copy.data() + tocOffset));
+        return AssetArchiveFormat::Validate(copy.data(), copy.size());
+    };
+
+    TEST_CHECK(!AssetArchiveFormat::Validate(archive.data(), sizeof(AssetArchiveHeader) - 1));
+    TEST_CHECK(!AssetArchiveFormat::Validate(archive.data(), archive.size() - 1));
+    TEST_CHECK(!isValidAfter([](std::vector<uint8_t>&, AssetArchiveHeader* header, AssetArchiveEntry*) { header->magic ^= 1; }));
+    TEST_CHECK(!isValidAfter([](std::vector<uint8_t>&, AssetArchiveHeader* header, AssetArchiveEntry*) { header->version++; }));
+    TEST_CHECK(!isValidAfter([](std::vector<uint8_t>&, AssetArchiveHeader* header, AssetArchiveEntry*) { header->entryCount = 0x10000000; }));
+    TEST_CHECK(!isValidAfter([](std::vector<uint8_t>&, AssetArchiveHeader* header, AssetArchiveEntry*) { header->pathTableSize += header->fileSize; }));
+    TEST_CHECK(!isValidAfter([](std::vector<uint8_t>&, AssetArchiveHeader* header, AssetArchiveEntry* entries) { entries[0].offset = header->fileSize; entries[0].size = 1; }));
+    TEST_CHECK(!isValidAfter([](std::vector<uint8_t>&, AssetArchiveHeader* header, AssetArchiveEntry* entries) { entries[1].pathOffset = (uint32_t)header->pathTableSize; }));
+    TEST_CHECK(!isValidAfter([](std::vector<uint8_t>&, AssetArchiveHeader*, AssetArchiveEntry* entries) { std::swap(entries[0], entries[1]); }));
+
+    // 途中で切れたファイルは、ヘッダーのファイルサイズと合わない
+    TEST_CHECK(!isValidAfter([](std::vector<uint8_t>& copy, AssetArchiveHeader*, AssetArchiveEntry*) { copy.resize(copy.size() - AssetArchiveFormat::DataAlignment); }));
+}
+
+
+// ハッシュ値が同じ項目は、パス文字列を比べて見分けること
+static void TestHashCollision(const std::vector<uint8_t>& archive)
+{
+    std::vector<uint8_t> copy = archive;
+    const AssetArchiveHeader* header = (const AssetArchiveHeader*)copy.data();
+    AssetArchiveEntry* entries = (AssetArchiveEntry*)(copy.data() + header->tocOffset);
+    const char* pathTable = (const char*)copy.data() + header->pathTableOffset;
+
+    // 先頭の項目のハッシュ値を2番目と同じにする (並び順は崩れない)
+    entries[0].pathHash = entries[1].pathHash;
+    TEST_CHECK(AssetArchiveFormat::Validate(copy.data(), copy.size()));
+
+    // 2番目のパスで探すと、先に並ぶ先頭の項目はパスが違うので飛ばされる
+    const std::string secondPath(pathTable + entries[1].pathOffset, entries[1].pathLength);
+    TEST_CHECK(AssetArchiveFormat::FindEntry(copy.data(), secondPath) == &entries[1]);
+}
+
+
+int main()
+{
+    TestNormalizePath();
+    TestPathHash();
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "AssetArchiveTest";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    const std::vector<uint8_t> archive = PackTestFiles(directory);
+    TEST_CHECK(archive.size() >= sizeof(AssetArchiveHeader));
+    if (archive.size() >= sizeof(AssetArchiveHeader))
+    {
+        TestPackedArchive(archive);
+        TestCorruptedArchive(archive);
+        TestHashCollision(archive);
+    }
+
+    std::filesystem::remove_all(directory);
+    return TestResult("AssetArchiveTest");
+}
@@ -0,0 +1,319 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// アセットキャッシュテーブルのテスト
+//
+//      ・ヒットとミスの数、ロードに失敗した項目のやり直しを確かめる。
+//      ・未使用のアセットが、メモリ予算を超えている間だけ、最後に使われたのが古い順(LRU)に追い出されることを確かめる。
+//      ・メモリ予算が 0 なら、最後の Release() ですぐに追い出されて破棄されることを確かめる。
+//      ・別々のスレッドから同時に要求してもロードは1回だけで、取得と解放を繰り返しても参照カウントが狂わないことを確かめる。
+//      ・アセットには、Texture2D と同じように最後の Release() でテーブルに通知する偽物を使う。 (GPUは使わない)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "AssetCacheTable.h"
+#include "Test.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+
+// 偽物のアセット
+class FakeAsset
+{
+private:
+    std::atomic<uint32_t> m_referenceCount;     // 参照カウント (ReferenceCounter と同じく 1 から始まる)
+    AssetCacheTable<FakeAsset>* m_table;        // 登録したテーブル (未登録なら nullptr)
+
+public:
+    static std::atomic<int> s_liveCount;        // 破棄されていない偽物のアセットの数
+
+public:
+    FakeAsset()
+        : m_referenceCount(1)
+        , m_table(nullptr)
+    {
+        s_liveCount++;
+    }
+
+    ~FakeAsset()
+    {
+        s_liveCount--;
+    }
+
+    // テーブルに登録したことにします。 (Texture2D の m_isCached に相当)
+    void SetTable(AssetCacheTable<FakeAsset>* table) { m_table = table; }
+
+    uint32_t GetReferenceCount() const { return m_referenceCount.load(); }
+
+    uint32_t AddRef() { return ++m_referenceCount; }
+
+    // Texture2D::Release() と同じく、テーブルの参照だけになったら未使用を通知する
+    uint32_t Release()
+    {
+        AssetCacheTable<FakeAsset>* table = m_table;
+        const uint32_t referenceCount = --m_referenceCount;
+        if (referenceCount == 0)
+        {
+            delete this;
+        }
+        else if (table && (referenceCount == 1))
+        {
+            table->OnAssetUnused(this);
+        }
+        return referenceCount;
+    }
+};
+
+std::atomic<int> FakeAsset::s_liveCount(0);
+
+
+// テーブルからアセットを取得し、無ければロードしたことにする
+static FakeAsset* Load(AssetCacheTable<FakeAsset>& table, const wchar_t* key, uint64_t residentBytes)
+{
+    bool isLoader = false;
+    FakeAsset* asset = table.Acquire(key, isLoader);
+    if (!isLoader)
+    {
+        return asset;
+    }
+
+    asset = new FakeAsset();
+    asset->SetTable(&table);
+    table.Publish(key, asset, residentBytes, 1.0);
+    return asset;
+}
+
+
+// ヒットとミスの数
+static void TestHitAndMiss()
+{
+    {
+        AssetCacheTable<FakeAsset> table;
+        table.SetMemoryBudget(1024);
+
+        FakeAsset* a = Load(table, L"a", 100);
+        FakeAsset* b = Load(table, L"b", 100);
+        FakeAsset* a2 = Load(table, L"a", 100);
+        TEST_CHECK(a == a2);
+        TEST_CHECK(a != b);
+        TEST_CHECK(a->GetReferenceCount() == 3);       // テーブル + 呼び出し元2つ
+
+        AssetCacheStats stats = table.GetStats();
+        TEST_CHECK(stats.missCount == 2);
+        TEST_CHECK(stats.hitCount == 1);
+        TEST_CHECK(stats.entryCount == 2);
+        TEST_CHECK(stats.unusedEntryCount == 0);
+        TEST_CHECK(stats.residentBytes == 200);
+        TEST_CHECK(stats.savedDecodeMilliseconds == 1.0);
+
+        // 予算内なので、未使用になっても残る
+        a->Release();
+        a->Release();
+        b->Release();
+        stats = table.GetStats();
+        TEST_CHECK(stats.unusedEntryCount == 2);
+        TEST_CHECK(stats.evictionCount == 0);
+        TEST_CHECK(FakeAsset::s_liveCount == 2);
+
+        // 未使用から戻ってもヒット
+        FakeAsset* a3 = Load(table, L"a", 100);
+        TEST_CHECK(a3 == a);
+        TEST_CHECK(table.GetStats().hitCount == 2);
+        TEST_CHECK(table.GetStats().unusedEntryCount == 1);
+        a3->Release();
+
+        table.Clear();
+        stats = table.GetStats();
+        TEST_CHECK(stats.entryCount == 0);
+        TEST_CHECK(stats.residentBytes == 0);
+        TEST_CHECK(stats.evictionCount == 2);
+    }
+    TEST_CHECK(FakeAsset::s_liveCount == 0);
+}
+
+
+// ロードに失敗した場合は、次に要求された時にやり直す
+static void TestFailedLoad()
+{
+    AssetCacheTable<FakeAsset> table;
+    bool isLoader = false;
+    TEST_CHECK(table.Acquire(L"broken", isLoader) == nullptr);
+    TEST_CHECK(isLoader);
+    table.Publish(L"broken", nullptr, 0, 0.0);
+    TEST_CHECK(table.GetStats().entryCount == 0);
+    TEST_CHECK(table.GetStats().missCount == 0);
+
+    TEST_CHECK(table.Acquire(L"broken", isLoader) == nullptr);
+    TEST_CHECK(isLoader);
+    table.Publish(L"broken", nullptr, 0, 0.0);
+}
+
+
+// 未使用のアセットは、予算を超えている間だけ古い順に追い出される
+static void TestLruEviction()
+{
+    AssetCacheTable<FakeAsset> table;
+    table.SetMemoryBudget(250);
+
+    FakeAsset* a = Load(table, L"a", 100);
+    FakeAsset* b = Load(table, L"b", 100);
+    FakeAsset* c = Load(table, L"c", 100);
+
+    // 使用中のアセットは、予算を超えていても追い出されない
+    TEST_CHECK(table.GetStats().residentBytes == 300);
+    TEST_CHECK(table.GetStats().evictionCount == 0);
+
+    // a → b → c の順に未使用にすると、最初に未使用になった a が追い出される
+    a->Release();
+    TEST_CHECK(table.GetStats().evictionCount == 1);
+    TEST_CHECK(FakeAsset::s_liveCount == 2);
+    b->Release();
+    c->Release();
+    TEST_CHECK(table.GetStats().evictionCount == 1);
+    TEST_CHECK(table.GetStats().residentBytes == 200);
+
+    // b を使うと c の方が古くなるので、予算を減らすと c が先に追い出される
+    FakeAsset* b2 = Load(table, L"b", 100);
+    TEST_CHECK(b2 == b);
+    b2->Release();
+    table.SetMemoryBudget(150);
+    TEST_CHECK(table.GetStats().evictionCount == 2);
+    TEST_CHECK(table.GetStats().entryCount == 1);
+
+    bool isLoader = false;
+    FakeAsset* stillCached = table.Acquire(L"b", isLoader);
+    TEST_CHECK(!isLoader && stillCached == b);
+    stillCached->Release();
+    FakeAsset* reloaded = table.Acquire(L"c", isLoader);
+    TEST_CHECK(isLoader && reloaded == nullptr);
+    table.Publish(L"c", nullptr, 0, 0.0);
+
+    table.Clear();
+    TEST_CHECK(FakeAsset::s_liveCount == 0);
+}
+
+
+// メモリ予算が 0 なら、最後の Release() ですぐに追い出される
+static void TestEvictOnLastRelease()
+{
+    AssetCacheTable<FakeAsset> table;
+    FakeAsset* a = Load(table, L"a", 100);
+    FakeAsset* a2 = Load(table, L"a", 100);
+
+    a->Release();
+    TEST_CHECK(table.GetStats().entryCount == 1);
+    TEST_CHECK(FakeAsset::s_liveCount == 1);
+
+    a2->Release();
+    const AssetCacheStats stats = table.GetStats();
+    TEST_CHECK(stats.entryCount == 0);
+    TEST_CHECK(stats.unusedEntryCount == 0);
+    TEST_CHECK(stats.evictionCount == 1);
+    TEST_CHECK(stats.residentBytes == 0);
+    TEST_CHECK(FakeAsset::s_liveCount == 0);
+}
+
+
+// 同時に要求されたアセットのロードは1回だけ
+static void TestConcurrentLoad()
+{
+    AssetCacheTable<FakeAsset> table;
+    table.SetMemoryBudget(1024);
+
+    bool isLoader = false;
+    TEST_CHECK(table.Acquire(L"shared", isLoader) == nullptr);
+    TEST_CHECK(isLoader);
+
+    // ロード中に要求したスレッドは、Publish() されるまで待つ
+    const uint32_t numWaiters = 4;
+    std::vector<FakeAsset*> results(numWaiters, nullptr);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < numWaiters; i++)
+    {
+        threads.emplace_back([&table, &results, i]()
+        {
+            bool isWaiterLoader = true;
+            results[i] = table.Acquire(L"shared", isWaiterLoader);
+            TEST_CHECK(!isWaiterLoader);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    FakeAsset* asset = new FakeAsset();
+    asset->SetTable(&table);
+    table.Publish(L"shared", asset, 100, 1.0);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (FakeAsset* result : results)
+    {
+        TEST_CHECK(result == asset);
+    }
+    const AssetCacheStats stats = table.GetStats();
+    TEST_CHECK(stats.missCount == 1);
+    TEST_CHECK(stats.hitCount == numWaiters);
+    TEST_CHECK(asset->GetReferenceCount() == 2 + numWaiters);
+
+    for (FakeAsset* result : results)
+    {
+        result->Release();
+    }
+    asset->Release();
+    TEST_CHECK(table.GetStats().unusedEntryCount == 1);
+    table.Clear();
+    TEST_CHECK(FakeAsset::s_liveCount == 0);
+}
+
+
+// 複数のスレッドが取得と解放を繰り返しても、参照カウントと統計情報が狂わない
+//   ・メモリ予算が 0 なので、最後の Release() と別のスレッドの取得が頻繁にぶつかる。
+static void TestConcurrentAcquireRelease()
+{
+    AssetCacheTable<FakeAsset> table;
+    const uint32_t numThreads = 4;
+    const uint32_t numIterations = 20000;
+    static const wchar_t* const keys[] = { L"a", L"b", L"c" };
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([&table, t]()
+        {
+            for (uint32_t i = 0; i < numIterations; i++)
+            {
+                FakeAsset* asset = Load(table, keys[(i + t) % 3], 64);
+                FakeAsset* again = Load(table, keys[(i + t) % 3], 64);
+                TEST_CHECK(asset == again);
+                again->Release();
+                asset->Release();
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    // 全ての参照が解放されたので、全て追い出されて破棄されている
+    const AssetCacheStats stats = table.GetStats();
+    TEST_CHECK(stats.entryCount == 0);
+    TEST_CHECK(stats.unusedEntryCount == 0);
+    TEST_CHECK(stats.residentBytes == 0);
+    TEST_CHECK(stats.hitCount + stats.missCount == numThreads * numIterations * 2);
+    TEST_CHECK(stats.evictionCount == stats.missCount);
+    TEST_CHECK(FakeAsset::s_liveCount == 0);
+    printf("[情報] 取得 %u 回 : ヒット %u 回 / ミス %u 回 / 追い出し %u 回\n", stats.hitCount + stats.missCount, stats.hitCount, stats.missCount, stats.evictionCount);
+}
+
+
+int main()
+{
+    TestHitAndMiss();
+    TestFailedLoad();
+    TestLruEviction();
+    TestEvictOnLastRelease();
+    TestConcurrentLoad();
+    TestConcurrentAcquireRelease();
+    return TestResult("AssetCacheTableTest");
+}
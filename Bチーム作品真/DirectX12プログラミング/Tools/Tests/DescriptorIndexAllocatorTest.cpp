@@ -0,0 +1,78 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// ディスクリプタ番号アロケーターのテスト
+//
+//      ・永続領域の番号は小さい順に配られ、一杯になると InvalidIndex を返すことを確かめる。
+//      ・解放した番号は、同じフレームが次に BeginFrame() されるまで再利用されないことを確かめる。
+//      ・一時領域はフレーム毎の区画から切り出され、BeginFrame() で空に戻ることを確かめる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "DescriptorIndexAllocator.h"
+#include "Test.h"
+
+
+// 永続領域の確保と容量不足
+static void TestPersistentExhaustion()
+{
+    DescriptorIndexAllocator allocator(4, 2, 2);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        TEST_CHECK(allocator.AllocatePersistent() == i);
+    }
+    TEST_CHECK(allocator.GetNumUsedPersistentDescriptors() == 4);
+    TEST_CHECK(allocator.AllocatePersistent() == DescriptorIndexAllocator::InvalidIndex);
+    TEST_CHECK(allocator.GetNumUsedPersistentDescriptors() == 4);
+
+    // InvalidIndex の解放は何もしない
+    allocator.FreePersistent(DescriptorIndexAllocator::InvalidIndex);
+    allocator.BeginFrame(1);
+    allocator.BeginFrame(0);
+    TEST_CHECK(allocator.AllocatePersistent() == DescriptorIndexAllocator::InvalidIndex);
+}
+
+
+// 解放した番号は、GPUがそのフレームを終えるまで再利用しない
+static void TestDeferredReuse()
+{
+    DescriptorIndexAllocator allocator(2, 2, 2);
+    allocator.BeginFrame(0);
+    const uint32_t a = allocator.AllocatePersistent();
+    const uint32_t b = allocator.AllocatePersistent();
+    allocator.FreePersistent(a);
+    TEST_CHECK(allocator.AllocatePersistent() == DescriptorIndexAllocator::InvalidIndex);
+
+    // 別のフレームを始めても、フレーム0で解放した番号はまだ使えない
+    allocator.BeginFrame(1);
+    TEST_CHECK(allocator.AllocatePersistent() == DescriptorIndexAllocator::InvalidIndex);
+
+    // フレーム0が再び始まれば使える
+    allocator.BeginFrame(0);
+    TEST_CHECK(allocator.AllocatePersistent() == a);
+    TEST_CHECK(b != a);
+}
+
+
+// 一時領域はフレーム毎の区画に並ぶ
+static void TestTransient()
+{
+    DescriptorIndexAllocator allocator(8, 4, 3);
+    TEST_CHECK(allocator.GetNumDescriptors() == 8 + 4 * 3);
+
+    allocator.BeginFrame(0);
+    TEST_CHECK(allocator.AllocateTransient(3) == 8);
+    TEST_CHECK(allocator.AllocateTransient(1) == 11);
+    TEST_CHECK(allocator.AllocateTransient(1) == DescriptorIndexAllocator::InvalidIndex);
+    TEST_CHECK(allocator.GetNumUsedTransientDescriptors() == 4);
+
+    allocator.BeginFrame(2);
+    TEST_CHECK(allocator.GetNumUsedTransientDescriptors() == 0);
+    TEST_CHECK(allocator.AllocateTransient(4) == 8 + 4 * 2);
+}
+
+
+int main()
+{
+    TestPersistentExhaustion();
+    TestDeferredReuse();
+    TestTransient();
+    return TestResult("DescriptorIndexAllocatorTest");
+}
@@ -0,0 +1,194 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// 破棄予約キューのストレステスト
+//
+//      ・1秒あたり10万個のオブジェクトを作成し、0～0.5秒後に破棄するように予約することを、60fpsで10秒間(シミュレーション上の時間)続ける。
+//      ・オブジェクトはゲームオブジェクトと同じくメモリプールから確保し、ハンドルテーブルに登録する。
+//      ・親1つと子3つの部分木を作り、親を破棄すると子もまとめて破棄する。 一部の子は個別にも予約するので、親ごと破棄された後の予約や、
+//        重複した予約が、古いハンドルとして無視されることも確かめる。
+//      ・メモリプールのスラブ数とハンドルテーブルの格納位置の数が、同時に生存していた数の最大値で頭打ちになる(作成した総数に比例して
+//        増え続けない)ことを確かめる。
+//      ・本物の Object は Windows のヘッダーに依存するので、ハンドルテーブルへの登録と解除だけを行う代役を使う。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "DestroyQueue.h"
+#include "MemoryPool.h"
+#include "Test.h"
+#include <random>
+#include <vector>
+#include <chrono>
+#include <new>
+
+
+// Object の代役 (コンストラクタで登録し、デストラクタで登録を解除する)
+class Object
+{
+private:
+    uint32_t m_handleIndex;
+
+public:
+    Object() : m_handleIndex(HandleTable::Register(this)) {}
+    virtual ~Object() { HandleTable::Unregister(m_handleIndex); }
+    uint32_t GetHandleIndex() const { return m_handleIndex; }
+};
+
+
+// ゲームオブジェクトの代役 (親1つと子3つの部分木を作る)
+class FakeGameObject : public Object
+{
+public:
+    static constexpr uint32_t NumChildren = 3;
+
+    FakeGameObject* parent = nullptr;                   // 親 (親がいない場合は nullptr)
+    FakeGameObject* children[NumChildren] = {};         // 子 (破棄された子は nullptr)
+    uint32_t siblingIndex = 0;                          // 親の子配列内での位置 (親から O(1) で切り離す為)
+
+    static MemoryPool* s_pool;                          // 確保に使うメモリプール
+    static uint32_t s_liveCount;                        // 生存している数
+
+    static FakeGameObject* Create()
+    {
+        s_liveCount++;
+        return new (s_pool->Allocate()) FakeGameObject();
+    }
+
+    // 親から切り離し、子孫ごと破棄する (子から順番に破棄する)
+    static void Destroy(FakeGameObject* gameObject)
+    {
+        if (gameObject->parent)
+        {
+            gameObject->parent->children[gameObject->siblingIndex] = nullptr;
+            gameObject->parent = nullptr;
+        }
+        for (FakeGameObject*& child : gameObject->children)
+        {
+            if (child)
+            {
+                child->parent = nullptr;
+                Destroy(child);
+                child = nullptr;
+            }
+        }
+        gameObject->~FakeGameObject();
+        s_pool->Free(gameObject);
+        s_liveCount--;
+    }
+};
+
+MemoryPool* FakeGameObject::s_pool = nullptr;
+uint32_t FakeGameObject::s_liveCount = 0;
+
+
+int main()
+{
+    const uint32_t framesPerSecond = 60;
+    const uint32_t numSeconds = 10;
+    const uint32_t objectsPerSecond = 100000;
+    const uint32_t treesPerFrame = objectsPerSecond / (FakeGameObject::NumChildren + 1) / framesPerSecond;
+    const double frameTime = 1.0 / framesPerSecond;
+
+    MemoryPool pool(sizeof(FakeGameObject), alignof(FakeGameObject));
+    FakeGameObject::s_pool = &pool;
+    DestroyQueue destroyQueue;
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> lifeTime(0.0, 0.5);
+    std::uniform_int_distribution<uint32_t> percent(0, 99);
+
+    uint64_t createdCount = 0;
+    uint64_t destroyedCount = 0;
+    uint64_t scheduledCount = 0;
+    uint32_t maxQueueCount = 0;
+    uint32_t maxLiveCount = 0;
+    uint32_t slabCountAt2Seconds = 0;
+    bool areOldHandlesInvalid = true;
+    std::vector<Handle<Object>> destroyedHandles;
+
+    const auto start = std::chrono::steady_clock::now();
+    double now = 0.0;
+    for (uint32_t frame = 0; frame < framesPerSecond * numSeconds; frame++)
+    {
+        // 部分木を作成して、破棄を予約する
+        for (uint32_t i = 0; i < treesPerFrame; i++)
+        {
+            FakeGameObject* root = FakeGameObject::Create();
+            for (uint32_t c = 0; c < FakeGameObject::NumChildren; c++)
+            {
+                FakeGameObject* child = FakeGameObject::Create();
+                child->parent = root;
+                child->siblingIndex = c;
+                root->children[c] = child;
+
+                // 10% の子は個別にも予約する (親より先に破棄される場合と、親ごと破棄された後に取り出される場合がある)
+                if (percent(random) < 10)
+                {
+                    destroyQueue.Schedule(Handle<Object>(child), now + lifeTime(random));
+                    scheduledCount++;
+                }
+            }
+            createdCount += FakeGameObject::NumChildren + 1;
+
+            destroyQueue.Schedule(Handle<Object>(root), now + lifeTime(random));
+            scheduledCount++;
+
+            // 5% の親は重複して予約する (2回目は無視される)
+            if (percent(random) < 5)
+            {
+                destroyQueue.Schedule(Handle<Object>(root), now + lifeTime(random));
+                scheduledCount++;
+            }
+        }
+        maxLiveCount = std::max(maxLiveCount, FakeGameObject::s_liveCount);
+        maxQueueCount = std::max(maxQueueCount, destroyQueue.GetCount());
+
+        // フレームの終わりに、時刻を過ぎたものを破棄する
+        const uint32_t liveCountBefore = FakeGameObject::s_liveCount;
+        destroyQueue.Process(now, [&destroyedHandles](Object& object)
+        {
+            if (destroyedHandles.size() < 1000)
+            {
+                destroyedHandles.push_back(Handle<Object>(&object));
+            }
+            FakeGameObject::Destroy(static_cast<FakeGameObject*>(&object));
+        });
+        destroyedCount += liveCountBefore - FakeGameObject::s_liveCount;
+        now += frameTime;
+
+        if (frame + 1 == framesPerSecond * 2)
+        {
+            slabCountAt2Seconds = pool.GetNumSlabs();
+        }
+
+        // 破棄されたオブジェクトのハンドルは、格納位置が再利用された後も無効のまま
+        for (const Handle<Object>& handle : destroyedHandles)
+        {
+            areOldHandlesInvalid = areOldHandlesInvalid && !handle;
+        }
+    }
+    const double elapsedMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    TEST_CHECK(createdCount == (uint64_t)treesPerFrame * (FakeGameObject::NumChildren + 1) * framesPerSecond * numSeconds);
+    TEST_CHECK(areOldHandlesInvalid);
+    TEST_CHECK(destroyedHandles.size() == 1000);
+
+    // 生存数は「1秒あたりの作成数 × 平均の寿命(0.25秒)」程度で頭打ちになる
+    TEST_CHECK(maxLiveCount < objectsPerSecond / 2);
+
+    // 100万個作っても、スラブは最大生存数の分だけ、ハンドルの格納位置は最大生存数と同じ数しか増えない
+    const uint32_t blocksPerSlab = (uint32_t)(MemoryPool::SlabSize / pool.GetBlockSize()) - 1;
+    const uint32_t maxSlabCount = (maxLiveCount + blocksPerSlab - 1) / blocksPerSlab + 1;
+    TEST_CHECK(pool.GetNumSlabs() <= maxSlabCount);
+    TEST_CHECK(HandleTable::GetSlotCount() <= maxLiveCount);
+
+    // 残りを全て破棄すると、全てのブロックがプールに戻り、予約も空になる
+    destroyQueue.Process(1.0e9, [](Object& object) { FakeGameObject::Destroy(static_cast<FakeGameObject*>(&object)); });
+    TEST_CHECK(FakeGameObject::s_liveCount == 0);
+    TEST_CHECK(pool.GetNumUsedBlocks() == 0);
+    TEST_CHECK(destroyQueue.GetCount() == 0);
+
+    printf("[情報] %u 秒間 (%u fps) : 作成 %llu 個 / フレーム内で破棄 %llu 個 / 予約 %llu 回 / 実時間 %.1f ms\n",
+        numSeconds, framesPerSecond, (unsigned long long)createdCount, (unsigned long long)destroyedCount, (unsigned long long)scheduledCount, elapsedMilliseconds);
+    printf("[情報] 最大生存数 %u 個 / 最大予約数 %u 個 / ハンドルの格納位置 %u 個\n", maxLiveCount, maxQueueCount, HandleTable::GetSlotCount());
+    printf("[情報] スラブ : 2秒後 %u 枚 → 10秒後 %u 枚 (%u KB。 上限 %u 枚)\n",
+        slabCountAt2Seconds, pool.GetNumSlabs(), (uint32_t)(pool.GetNumSlabs() * MemoryPool::SlabSize / 1024), maxSlabCount);
+    return TestResult("DestroyQueueStressTest");
+}
@@ -0,0 +1,179 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// フレームスケジューラーのテスト
+//
+//      ・CPUとGPUの処理時間を真似た(仮想の時計で動く)GPUタイムラインを使い、フレームスケジューラーの待ち方を確かめる。
+//      ・フレームリソースを再利用する前に、そのフレームリソースの前回のフェンス値だけを待つことを確かめる。
+//      ・同時に処理中にできるフレーム数を増やすと、CPUとGPUが重なってフレーム時間が短くなることを確かめる。
+//      ・ヌルRHIのGPUタイムライン(すぐに完了する)では、一度も待たないことを確かめる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "FrameScheduler.h"
+#include "NullRhi.h"
+#include "Test.h"
+#include <vector>
+#include <algorithm>
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// 遅延を真似たGPUタイムライン
+//
+//      ・Execute() で送った処理は、GPUが前の処理を終えてから順番に実行される。
+//      ・Signal() のフェンス値は、それまでに送った処理が全て終わった時刻に完了する。
+//      ・時刻は仮想の時計(ミリ秒)で、WaitForValue() は待った分だけ時計を進める。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class SimulatedGpuTimeline : public GpuTimeline
+{
+private:
+    double m_queueEndTime;                      // これまでに送った処理が全て終わる時刻
+    std::vector<double> m_completionTimes;      // フェンス値毎の完了時刻 (添え字はフェンス値 - 1)
+    double m_now;                               // CPUの現在時刻
+    std::vector<uint64_t> m_waitedValues;       // WaitForValue() で待ったフェンス値
+
+public:
+    SimulatedGpuTimeline() : m_queueEndTime(0.0), m_now(0.0) { }
+
+    // 指定した時間のかかるGPU処理をキューに送ります。 (ExecuteCommandLists() の代わり)
+    void Execute(double milliseconds) { m_queueEndTime = std::max(m_now, m_queueEndTime) + milliseconds; }
+
+    // CPUの処理の分だけ時計を進めます。
+    void Advance(double milliseconds) { m_now += milliseconds; }
+
+    // CPUの現在時刻を取得します。
+    double GetNow() const { return m_now; }
+
+    // WaitForValue() で待ったフェンス値を取得します。
+    const std::vector<uint64_t>& GetWaitedValues() const { return m_waitedValues; }
+
+    // GpuTimeline の実装
+    uint64_t Signal() override
+    {
+        m_completionTimes.push_back(std::max(m_now, m_queueEndTime));
+        return m_completionTimes.size();
+    }
+
+    uint64_t GetCompletedValue() override
+    {
+        uint64_t value = 0;
+        while (value < m_completionTimes.size() && m_completionTimes[value] <= m_now)
+        {
+            value++;
+        }
+        return value;
+    }
+
+    void WaitForValue(uint64_t value) override
+    {
+        m_waitedValues.push_back(value);
+        if (value > 0)
+        {
+            m_now = std::max(m_now, m_completionTimes[value - 1]);
+        }
+    }
+};
+
+
+// 指定した条件でフレームを回し、1フレームあたりの時間(ミリ秒)を返す
+static double RunFrames(uint32_t numFramesInFlight, double cpuMilliseconds, double gpuMilliseconds, uint32_t numFrames, uint64_t* stallCount)
+{
+    SimulatedGpuTimeline timeline;
+    FrameScheduler scheduler(&timeline, numFramesInFlight);
+    for (uint32_t i = 0; i < numFrames; i++)
+    {
+        scheduler.BeginFrame();
+        timeline.Advance(cpuMilliseconds);
+        timeline.Execute(gpuMilliseconds);
+        scheduler.EndFrame();
+    }
+    scheduler.WaitForIdle();
+    *stallCount = scheduler.GetStallCount();
+    return timeline.GetNow() / numFrames;
+}
+
+
+// フレームリソースの前回のフェンス値だけを待つこと
+static void TestWaitsOnlyForOwnFrame()
+{
+    SimulatedGpuTimeline timeline;
+    FrameScheduler scheduler(&timeline, 3);
+
+    // 最初の3フレームは、まだ使っていないフレームリソースなので待たない (リセットも不要)
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        TEST_CHECK(scheduler.GetFrameIndex() == i);
+        TEST_CHECK(!scheduler.BeginFrame());
+        timeline.Advance(1.0);
+        timeline.Execute(10.0);
+        scheduler.EndFrame();
+    }
+    TEST_CHECK(timeline.GetWaitedValues().empty());
+
+    // 4フレーム目はフレームリソース0を再利用するので、フレーム0のフェンス値(1)だけを待つ
+    TEST_CHECK(scheduler.GetFrameIndex() == 0);
+    TEST_CHECK(scheduler.BeginFrame());
+    TEST_CHECK(timeline.GetWaitedValues().size() == 1 && timeline.GetWaitedValues()[0] == 1);
+    TEST_CHECK(timeline.GetNow() == 11.0);
+    TEST_CHECK(scheduler.GetStallCount() == 1);
+    timeline.Advance(1.0);
+    timeline.Execute(10.0);
+    scheduler.EndFrame();
+    TEST_CHECK(scheduler.GetFrameCount() == 4);
+
+    // WaitForIdle() は全ての処理(4フレーム分)の完了を待つ
+    scheduler.WaitForIdle();
+    TEST_CHECK(timeline.GetCompletedValue() == timeline.GetWaitedValues().back());
+    TEST_CHECK(timeline.GetNow() == 41.0);
+}
+
+
+// 同時に処理中にできるフレーム数を増やすと、CPUとGPUが重なること
+static void TestFramesInFlightOverlap()
+{
+    const uint32_t numFrames = 100;
+    uint64_t stallCount;
+
+    // CPU 8ms / GPU 8ms : 1フレームだとCPUとGPUが交互に動くので約16ms、2フレーム以上なら約8ms
+    const double single = RunFrames(1, 8.0, 8.0, numFrames, &stallCount);
+    printf("[情報] CPU 8ms / GPU 8ms, N = 1 : %.2f ms/フレーム (待ち %llu 回)\n", single, (unsigned long long)stallCount);
+    TEST_CHECK(single > 15.9 && single < 16.1);
+    TEST_CHECK(stallCount == numFrames - 1);
+
+    for (uint32_t n = 2; n <= 4; n++)
+    {
+        const double overlapped = RunFrames(n, 8.0, 8.0, numFrames, &stallCount);
+        printf("[情報] CPU 8ms / GPU 8ms, N = %u : %.2f ms/フレーム (待ち %llu 回)\n", n, overlapped, (unsigned long long)stallCount);
+        TEST_CHECK(overlapped < 8.2);
+        TEST_CHECK(stallCount == 0);
+    }
+
+    // GPU律速 (CPU 4ms / GPU 12ms) : フレーム数を増やしてもGPUの時間より短くはならず、待ちが起きる
+    const double gpuBound = RunFrames(3, 4.0, 12.0, numFrames, &stallCount);
+    printf("[情報] CPU 4ms / GPU 12ms, N = 3 : %.2f ms/フレーム (待ち %llu 回)\n", gpuBound, (unsigned long long)stallCount);
+    TEST_CHECK(gpuBound >= 12.0 && gpuBound < 12.5);
+    TEST_CHECK(stallCount > 0);
+}
+
+
+// ヌルRHIのGPUタイムラインでは待たないこと
+static void TestNullTimelineNeverStalls()
+{
+    NullGpuTimeline timeline;
+    FrameScheduler scheduler(&timeline, 2);
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        TEST_CHECK(scheduler.BeginFrame() == (i >= 2));
+        scheduler.EndFrame();
+    }
+    scheduler.WaitForIdle();
+    TEST_CHECK(scheduler.GetStallCount() == 0);
+    TEST_CHECK(scheduler.GetFrameCount() == 10);
+}
+
+
+int main()
+{
+    TestWaitsOnlyForOwnFrame();
+    TestFramesInFlightOverlap();
+    TestNullTimelineNeverStalls();
+    return TestResult("FrameSchedulerTest");
+}
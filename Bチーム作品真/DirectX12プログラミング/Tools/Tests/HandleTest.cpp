@@ -0,0 +1,142 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// ハンドルのテスト
+//
+//      ・破棄済みのオブジェクトをハンドルで検出できること、格納位置を再利用しても古いハンドルが新しいオブジェクトを指さないことを確かめる。
+//      ・本物の Object は Windows のヘッダーに依存するので、ハンドルテーブルへの登録と解除だけを行う代役を使う。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "Handle.h"
+#include "Test.h"
+#include <vector>
+
+
+// Object の代役 (コンストラクタで登録し、デストラクタで登録を解除する)
+class Object
+{
+private:
+    uint32_t m_handleIndex;
+
+public:
+    Object() : m_handleIndex(HandleTable::Register(this)) {}
+    virtual ~Object() { HandleTable::Unregister(m_handleIndex); }
+    uint32_t GetHandleIndex() const { return m_handleIndex; }
+};
+
+// 派生クラス (Handle<T> は Object* から T* に変換して返す)
+class Derived : public Object
+{
+public:
+    int value = 0;
+};
+
+
+// 生存している間は参照先が得られ、破棄されると nullptr になること
+static void TestResolveAndInvalidate()
+{
+    Derived* object = new Derived();
+    object->value = 42;
+
+    const Handle<Derived> handle(object);
+    TEST_CHECK(handle.Get() == object);
+    TEST_CHECK((bool)handle);
+    TEST_CHECK(handle->value == 42);
+
+    const Handle<Object> baseHandle(object);
+    TEST_CHECK(baseHandle.Get() == object);
+
+    delete object;
+    TEST_CHECK(handle.Get() == nullptr);
+    TEST_CHECK(!handle);
+    TEST_CHECK(baseHandle.Get() == nullptr);
+}
+
+
+// 何も参照していないハンドルは nullptr を返し、nullptr から作成したハンドルと等しいこと
+static void TestNullHandle()
+{
+    const Handle<Derived> empty;
+    TEST_CHECK(empty.Get() == nullptr);
+    TEST_CHECK(empty == Handle<Derived>(nullptr));
+}
+
+
+// 格納位置が再利用されても、古いハンドルは新しいオブジェクトを指さないこと
+static void TestSlotReuse()
+{
+    Derived* first = new Derived();
+    const uint32_t index = first->GetHandleIndex();
+    const Handle<Derived> oldHandle(first);
+    delete first;
+
+    // 最後に空いた格納位置が最初に再利用される
+    Derived* second = new Derived();
+    TEST_CHECK(second->GetHandleIndex() == index);
+
+    const Handle<Derived> newHandle(second);
+    TEST_CHECK(oldHandle.Get() == nullptr);
+    TEST_CHECK(newHandle.Get() == second);
+    TEST_CHECK(oldHandle != newHandle);
+    delete second;
+}
+
+
+// 多数のオブジェクトを作成と破棄を繰り返しても、生存しているものだけが参照できること
+static void TestManyObjects()
+{
+    std::vector<Derived*> objects;
+    std::vector<Handle<Derived>> handles;
+    for (int i = 0; i < 1000; i++)
+    {
+        objects.push_back(new Derived());
+        objects.back()->value = i;
+        handles.push_back(Handle<Derived>(objects.back()));
+    }
+
+    // 偶数番目だけ破棄して、同じ数だけ作り直す (空いた格納位置が再利用される)
+    for (int i = 0; i < 1000; i += 2)
+    {
+        delete objects[i];
+        objects[i] = nullptr;
+    }
+    std::vector<Derived*> replacements;
+    for (int i = 0; i < 500; i++)
+    {
+        replacements.push_back(new Derived());
+    }
+
+    for (int i = 0; i < 1000; i++)
+    {
+        if (i % 2 == 0)
+        {
+            TEST_CHECK(handles[i].Get() == nullptr);
+        }
+        else
+        {
+            TEST_CHECK(handles[i].Get() == objects[i]);
+            TEST_CHECK(handles[i]->value == i);
+        }
+    }
+
+    for (Derived* object : objects)
+    {
+        delete object;
+    }
+    for (Derived* object : replacements)
+    {
+        delete object;
+    }
+    for (const Handle<Derived>& handle : handles)
+    {
+        TEST_CHECK(handle.Get() == nullptr);
+    }
+}
+
+
+int main()
+{
+    TestResolveAndInvalidate();
+    TestNullHandle();
+    TestSlotReuse();
+    TestManyObjects();
+    return TestResult("HandleTest");
+}
@@ -0,0 +1,111 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// ジョブシステムのベンチマーク
+//
+//      ・10000個の振る舞い(位置と速度を持ち、毎フレーム少しの計算をする合成の Update)を ParallelFor() で更新し、
+//        スレッド数を 1, 2, 4, 8 と変えて1フレームあたりの時間を比べる。
+//      ・どのスレッド数でも、1スレッドで更新した結果と完全に一致することを確かめる。
+//      ・論理コア数より多いスレッド数も計るので、コア数が少ない環境では速くならない。 (論理コア数も出力する)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "JobSystem.h"
+#include "Test.h"
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+
+// 合成の振る舞い
+struct SyntheticBehaviour
+{
+    float positionX;
+    float positionY;
+    float velocityX;
+    float velocityY;
+    float phase;
+};
+
+
+// 1つの振る舞いの Update (画面の端で跳ね返り、揺らぎを加える)
+static void UpdateBehaviour(SyntheticBehaviour& behaviour, float deltaTime)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        behaviour.phase += deltaTime;
+        behaviour.velocityX += std::sin(behaviour.phase) * 0.01f;
+        behaviour.velocityY += std::cos(behaviour.phase * 1.3f) * 0.01f;
+    }
+    behaviour.positionX += behaviour.velocityX * deltaTime;
+    behaviour.positionY += behaviour.velocityY * deltaTime;
+    if (behaviour.positionX < 0.0f || behaviour.positionX > 1920.0f)
+    {
+        behaviour.velocityX = -behaviour.velocityX;
+    }
+    if (behaviour.positionY < 0.0f || behaviour.positionY > 1080.0f)
+    {
+        behaviour.velocityY = -behaviour.velocityY;
+    }
+}
+
+
+// 振る舞いの初期状態を作る
+static std::vector<SyntheticBehaviour> MakeBehaviours(uint32_t count)
+{
+    std::vector<SyntheticBehaviour> behaviours(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        behaviours[i] = { (float)(i % 1920), (float)(i % 1080), (float)(i % 7) - 3.0f, (float)(i % 5) - 2.0f, (float)i * 0.001f };
+    }
+    return behaviours;
+}
+
+
+int main()
+{
+    const uint32_t numBehaviours = 10000;
+    const uint32_t numFrames = 100;
+    const uint32_t batchSize = 64;
+    const float deltaTime = 1.0f / 60.0f;
+
+    printf("[情報] 振る舞い %u 個 / %u フレーム / 論理コア数 %u\n", numBehaviours, numFrames, std::thread::hardware_concurrency());
+    printf("[情報] %8s %16s %10s\n", "スレッド", "1フレーム", "1スレッド比");
+
+    std::vector<SyntheticBehaviour> reference;
+    double singleThreadMilliseconds = 0.0;
+    for (uint32_t numThreads : { 1u, 2u, 4u, 8u })
+    {
+        JobSystem::CreateSingletonInstance(numThreads);
+
+        std::vector<SyntheticBehaviour> behaviours = MakeBehaviours(numBehaviours);
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < numFrames; frame++)
+        {
+            JobSystem::Instance().ParallelFor(numBehaviours, batchSize, [&](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    UpdateBehaviour(behaviours[i], deltaTime);
+                }
+            });
+        }
+        const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / numFrames;
+
+        JobSystem::DestroySingletonInstance();
+
+        // 振る舞い同士は独立しているので、スレッド数に関係なく同じ結果になる
+        if (numThreads == 1)
+        {
+            reference = behaviours;
+            singleThreadMilliseconds = milliseconds;
+        }
+        bool same = true;
+        for (uint32_t i = 0; i < numBehaviours; i++)
+        {
+            same = same && (behaviours[i].positionX == reference[i].positionX) && (behaviours[i].positionY == reference[i].positionY);
+        }
+        TEST_CHECK(same);
+
+        printf("[情報] %8u %13.3f ms %9.2fx\n", numThreads, milliseconds, singleThreadMilliseconds / milliseconds);
+    }
+    return TestResult("JobSystemBenchmark");
+}
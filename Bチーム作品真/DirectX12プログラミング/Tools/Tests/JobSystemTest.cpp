@@ -0,0 +1,207 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// ジョブシステムのテスト
+//
+//      ・ParallelFor() が範囲の全ての要素をちょうど1回ずつ処理することを、件数とバッチサイズを変えて確かめる。
+//      ・依存先を指定したジョブ(継続ジョブ)が、依存先の完了後に順番どおり実行されることを確かめる。
+//      ・未完了ジョブ数カウンター(1024個のリングバッファ)が一周して再利用されても、古いハンドルが完了済みに見えることを確かめる。
+//      ・メインスレッドが積んだジョブを、他のワーカースレッドが盗んで実行することを確かめる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "JobSystem.h"
+#include "Test.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+
+// 全ての要素をちょうど1回ずつ処理すること
+static void TestParallelForCoverage()
+{
+    for (uint32_t count : { 0u, 1u, 63u, 64u, 65u, 10007u })
+    {
+        for (uint32_t batchSize : { 0u, 1u, 7u, 64u, 100000u })
+        {
+            std::vector<std::atomic<uint32_t>> visitCounts(count);
+            for (std::atomic<uint32_t>& visitCount : visitCounts)
+            {
+                visitCount = 0;
+            }
+
+            std::atomic<uint32_t> maxRange(0);
+            JobSystem::Instance().ParallelFor(count, batchSize, [&](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    visitCounts[i]++;
+                }
+
+                // 1回に渡される範囲はバッチサイズ以下
+                uint32_t range = end - begin;
+                uint32_t previous = maxRange;
+                while (previous < range && !maxRange.compare_exchange_weak(previous, range)) { }
+            });
+
+            bool isExactlyOnce = true;
+            for (const std::atomic<uint32_t>& visitCount : visitCounts)
+            {
+                isExactlyOnce = isExactlyOnce && (visitCount == 1);
+            }
+            TEST_CHECK(isExactlyOnce);
+            TEST_CHECK(maxRange <= std::max(batchSize, 1u));
+        }
+    }
+}
+
+
+// 依存先の完了後に、順番どおり実行されること
+static void TestContinuations()
+{
+    struct Sequence
+    {
+        std::atomic<uint32_t> next;
+        uint32_t order[3];
+    };
+    Sequence sequence;
+    sequence.next = 0;
+
+    // 3つのジョブを数珠つなぎにする (自分の番号を、実行された順番の位置に書く)
+    const JobFunction jobFunctions[3] =
+    {
+        [](void* userData, uint32_t, uint32_t) { Sequence* s = (Sequence*)userData; std::this_thread::sleep_for(std::chrono::milliseconds(5)); s->order[s->next++] = 0; },
+        [](void* userData, uint32_t, uint32_t) { Sequence* s = (Sequence*)userData; s->order[s->next++] = 1; },
+        [](void* userData, uint32_t, uint32_t) { Sequence* s = (Sequence*)userData; s->order[s->next++] = 2; },
+    };
+    const JobHandle first = JobSystem::Instance().Schedule(jobFunctions[0], &sequence);
+    const JobHandle second = JobSystem::Instance().Schedule(jobFunctions[1], &sequence, first);
+    const JobHandle third = JobSystem::Instance().Schedule(jobFunctions[2], &sequence, second);
+    JobSystem::Instance().Wait(third);
+
+    TEST_CHECK(JobSystem::Instance().IsCompleted(first));
+    TEST_CHECK(JobSystem::Instance().IsCompleted(second));
+    TEST_CHECK(sequence.next == 3);
+    TEST_CHECK(sequence.order[0] == 0 && sequence.order[1] == 1 && sequence.order[2] == 2);
+
+    // 並列処理の後に、その結果を使う並列処理を続ける
+    struct Data
+    {
+        std::vector<uint32_t> squares;
+        std::vector<uint32_t> sums;
+    };
+    Data data;
+    data.squares.resize(5000, 0);
+    data.sums.resize(5000, 0);
+    const JobHandle squares = JobSystem::Instance().ScheduleParallelFor([](void* userData, uint32_t begin, uint32_t end)
+    {
+        Data* d = (Data*)userData;
+        for (uint32_t i = begin; i < end; i++)
+        {
+            d->squares[i] = i * i;
+        }
+    }, &data, 5000, 32);
+    const JobHandle sums = JobSystem::Instance().ScheduleParallelFor([](void* userData, uint32_t begin, uint32_t end)
+    {
+        Data* d = (Data*)userData;
+        for (uint32_t i = begin; i < end; i++)
+        {
+            d->sums[i] = d->squares[i] + i;
+        }
+    }, &data, 5000, 32, squares);
+    JobSystem::Instance().Wait(sums);
+
+    bool isCorrect = true;
+    for (uint32_t i = 0; i < 5000; i++)
+    {
+        isCorrect = isCorrect && (data.sums[i] == i * i + i);
+    }
+    TEST_CHECK(isCorrect);
+
+    // 完了済みのジョブに依存するジョブは、すぐに実行可能になる
+    std::atomic<uint32_t> counter(0);
+    const JobHandle afterCompleted = JobSystem::Instance().Schedule([](void* userData, uint32_t, uint32_t) { (*(std::atomic<uint32_t>*)userData)++; }, &counter, third);
+    JobSystem::Instance().Wait(afterCompleted);
+    TEST_CHECK(counter == 1);
+}
+
+
+// カウンターのリングバッファが一周しても、古いハンドルは完了済みに見えること
+static void TestCounterReuse()
+{
+    TEST_CHECK(JobSystem::Instance().IsCompleted(JobHandle()));
+
+    std::atomic<uint32_t> counter(0);
+    const JobFunction increment = [](void* userData, uint32_t, uint32_t) { (*(std::atomic<uint32_t>*)userData)++; };
+    const JobHandle oldest = JobSystem::Instance().Schedule(increment, &counter);
+    JobSystem::Instance().Wait(oldest);
+
+    // 1024個のカウンターを3周させる (同時に使うのは1つだけ)
+    for (uint32_t i = 0; i < 3 * 1024; i++)
+    {
+        const JobHandle handle = JobSystem::Instance().Schedule(increment, &counter);
+        JobSystem::Instance().Wait(handle);
+        TEST_CHECK(JobSystem::Instance().IsCompleted(handle));
+    }
+    TEST_CHECK(counter == 1 + 3 * 1024);
+
+    // 同じ格納位置が再利用されていても、古いハンドルは完了済みに見える
+    TEST_CHECK(JobSystem::Instance().IsCompleted(oldest));
+
+    // 未完了のジョブは、同じ格納位置を使う古いハンドルとは区別される
+    std::atomic<bool> release(false);
+    const JobHandle blocked = JobSystem::Instance().Schedule([](void* userData, uint32_t, uint32_t)
+    {
+        while (!*(std::atomic<bool>*)userData)
+        {
+            std::this_thread::yield();
+        }
+    }, &release);
+    TEST_CHECK(JobSystem::Instance().IsCompleted(oldest));
+    release = true;
+    JobSystem::Instance().Wait(blocked);
+    TEST_CHECK(JobSystem::Instance().IsCompleted(blocked));
+}
+
+
+// メインスレッドが積んだジョブを、他のワーカースレッドが盗んで実行すること
+static void TestWorkStealing()
+{
+    std::vector<std::thread::id> threadIds(64);
+    JobSystem::Instance().ParallelFor(64, 1, [&](uint32_t begin, uint32_t end)
+    {
+        // 少し眠って、他のワーカースレッドが盗む時間を作る
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        for (uint32_t i = begin; i < end; i++)
+        {
+            threadIds[i] = std::this_thread::get_id();
+        }
+    });
+
+    std::sort(threadIds.begin(), threadIds.end());
+    const size_t numThreadsUsed = std::unique(threadIds.begin(), threadIds.end()) - threadIds.begin();
+    TEST_CHECK(numThreadsUsed > 1);
+    TEST_CHECK(numThreadsUsed <= JobSystem::Instance().GetNumThreads());
+}
+
+
+int main()
+{
+    // 論理コア数に関係なく、ワークスティーリングが起きるように4スレッドにする
+    JobSystem::CreateSingletonInstance(4);
+    TEST_CHECK(JobSystem::Instance().GetNumThreads() == 4);
+
+    TestParallelForCoverage();
+    TestContinuations();
+    TestCounterReuse();
+    TestWorkStealing();
+
+    JobSystem::DestroySingletonInstance();
+
+    // メインスレッドだけでも同じように動く
+    JobSystem::CreateSingletonInstance(1);
+    TestParallelForCoverage();
+    TestContinuations();
+    JobSystem::DestroySingletonInstance();
+
+    return TestResult("JobSystemTest");
+}
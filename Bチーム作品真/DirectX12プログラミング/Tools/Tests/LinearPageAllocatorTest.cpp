@@ -0,0 +1,100 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// 線形ページアロケーターのテスト
+//
+//      ・1ページに収まる間は、アラインメントを守って先頭から順番に切り出すことを確かめる。
+//      ・収まらない場合はページを追加し、ページより大きな要求には大きなページを追加することを確かめる。
+//      ・Reset() の後は追加したページを使い回し、ページが増えないことを確かめる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "LinearPageAllocator.h"
+#include "Test.h"
+
+
+// 1ページの中で順番に切り出すこと
+static void TestSinglePage()
+{
+    LinearPageAllocator allocator(1024);
+    LinearPageAllocator::Location a = allocator.Allocate(100, 256);
+    LinearPageAllocator::Location b = allocator.Allocate(100, 256);
+    LinearPageAllocator::Location c = allocator.Allocate(10, 4);
+    TEST_CHECK(a.pageIndex == 0 && a.offset == 0);
+    TEST_CHECK(b.pageIndex == 0 && b.offset == 256);
+    TEST_CHECK(c.pageIndex == 0 && c.offset == 356);
+    TEST_CHECK(allocator.GetNumPages() == 1);
+    TEST_CHECK(allocator.GetUsedBytes() == 366);
+
+    // ページの末尾までぴったり使える
+    LinearPageAllocator::Location d = allocator.Allocate(1024 - 368, 4);
+    TEST_CHECK(d.pageIndex == 0 && d.offset == 368);
+    TEST_CHECK(allocator.GetNumPages() == 1);
+}
+
+
+// 収まらない場合はページを追加すること
+static void TestOverflowAddsPages()
+{
+    LinearPageAllocator allocator(1024);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        LinearPageAllocator::Location location = allocator.Allocate(256, 256);
+        TEST_CHECK(location.pageIndex == 0 && location.offset == i * 256);
+    }
+
+    // 1ページ目は一杯なので2ページ目の先頭から
+    LinearPageAllocator::Location next = allocator.Allocate(256, 256);
+    TEST_CHECK(next.pageIndex == 1 && next.offset == 0);
+    TEST_CHECK(allocator.GetNumPages() == 2);
+    TEST_CHECK(allocator.GetCapacity() == 2048);
+
+    // ページより大きな要求は、ページサイズの倍数に切り上げたページに入る
+    LinearPageAllocator::Location large = allocator.Allocate(3000, 256);
+    TEST_CHECK(large.pageIndex == 2 && large.offset == 0);
+    TEST_CHECK(allocator.GetPageCapacity(2) == 3072);
+
+    // 大きなページの残りも続けて使う
+    LinearPageAllocator::Location rest = allocator.Allocate(16, 16);
+    TEST_CHECK(rest.pageIndex == 2 && rest.offset == 3008);
+    TEST_CHECK(allocator.GetNumPages() == 3);
+}
+
+
+// Reset() の後は追加したページを使い回すこと
+static void TestResetReusesPages()
+{
+    LinearPageAllocator allocator(1024);
+    for (int frame = 0; frame < 3; frame++)
+    {
+        allocator.Reset();
+        TEST_CHECK(allocator.GetUsedBytes() == 0);
+
+        // 1フレームに 10 * 256 バイト使うと3ページ必要
+        for (uint32_t i = 0; i < 10; i++)
+        {
+            LinearPageAllocator::Location location = allocator.Allocate(256, 256);
+            TEST_CHECK(location.pageIndex == i / 4 && location.offset == (i % 4) * 256);
+        }
+        TEST_CHECK(allocator.GetNumPages() == 3);
+    }
+
+    // 使い回すページに収まらない大きな要求は、収まるページまで飛ばす (足りなければ追加する)
+    allocator.Reset();
+    LinearPageAllocator::Location large = allocator.Allocate(2048, 256);
+    TEST_CHECK(large.pageIndex == 3 && large.offset == 0);
+    TEST_CHECK(allocator.GetNumPages() == 4);
+    TEST_CHECK(allocator.GetUsedBytes() == 3 * 1024 + 2048);
+
+    // 次のフレームでは、追加した大きなページを使い回す
+    allocator.Reset();
+    LinearPageAllocator::Location reused = allocator.Allocate(2048, 256);
+    TEST_CHECK(reused.pageIndex == 3 && reused.offset == 0);
+    TEST_CHECK(allocator.GetNumPages() == 4);
+}
+
+
+int main()
+{
+    TestSinglePage();
+    TestOverflowAddsPages();
+    TestResetReusesPages();
+    return TestResult("LinearPageAllocatorTest");
+}
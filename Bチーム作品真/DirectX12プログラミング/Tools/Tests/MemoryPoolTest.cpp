@@ -0,0 +1,120 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// メモリプールのテスト
+//
+//      ・ブロックのアラインメント、プールの逆引き、フリーリストの再利用、スラブを跨ぐ確保を確かめる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "MemoryPool.h"
+#include "Test.h"
+#include <set>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+
+// 確保したブロックがアラインメントに揃っていて、確保したプールを逆引きできること
+static void TestAlignmentAndOwnership()
+{
+    MemoryPool pool16(24, 16);
+    MemoryPool pool64(40, 64);
+    TEST_CHECK(pool16.GetBlockSize() == 32);
+    TEST_CHECK(pool64.GetBlockSize() == 64);
+
+    for (int i = 0; i < 100; i++)
+    {
+        void* a = pool16.Allocate();
+        void* b = pool64.Allocate();
+        TEST_CHECK(((uintptr_t)a % 16) == 0);
+        TEST_CHECK(((uintptr_t)b % 64) == 0);
+        TEST_CHECK(MemoryPool::FromPointer(a) == &pool16);
+        TEST_CHECK(MemoryPool::FromPointer(b) == &pool64);
+    }
+    TEST_CHECK(pool16.GetNumUsedBlocks() == 100);
+    TEST_CHECK(pool64.GetNumUsedBlocks() == 100);
+}
+
+
+// ポインターより小さいブロックでも、未使用ブロックの管理情報が収まる大きさになること
+static void TestTinyBlocks()
+{
+    MemoryPool pool(1, 1);
+    TEST_CHECK(pool.GetBlockSize() >= sizeof(void*));
+
+    void* a = pool.Allocate();
+    void* b = pool.Allocate();
+    TEST_CHECK((uintptr_t)b - (uintptr_t)a == pool.GetBlockSize());
+}
+
+
+// 返却したブロックが次の確保で再利用され、統計情報が正しく数えられること
+static void TestFreeListReuse()
+{
+    MemoryPool pool(48, 8);
+    void* a = pool.Allocate();
+    void* b = pool.Allocate();
+    TEST_CHECK(a != b);
+
+    // 同じスラブの中では、アドレスの小さい順に配られる
+    TEST_CHECK((uintptr_t)a < (uintptr_t)b);
+
+    // 最後に返却したブロックが最初に再利用される
+    pool.Free(a);
+    TEST_CHECK(pool.GetNumUsedBlocks() == 1);
+    TEST_CHECK(pool.Allocate() == a);
+
+    pool.Free(b);
+    pool.Free(a);
+    TEST_CHECK(pool.GetNumUsedBlocks() == 0);
+    TEST_CHECK(pool.GetNumAllocations() == 3);
+    TEST_CHECK(pool.GetNumSlabs() == 1);
+}
+
+
+// 1つのスラブに入りきらない数のブロックを確保すると、スラブが追加され、全てのブロックが重ならないこと
+static void TestMultipleSlabs()
+{
+    const size_t blockSize = 256;
+    MemoryPool pool(blockSize, 16);
+
+    const size_t count = MemoryPool::SlabSize / blockSize * 5;
+    std::vector<void*> blocks;
+    std::set<uintptr_t> addresses;
+    for (size_t i = 0; i < count; i++)
+    {
+        void* block = pool.Allocate();
+        blocks.push_back(block);
+        addresses.insert((uintptr_t)block);
+
+        // ブロックの中身を書き潰しても、他のブロックやスラブの管理情報を壊さないこと
+        memset(block, 0xCD, blockSize);
+    }
+    TEST_CHECK(addresses.size() == count);
+    TEST_CHECK(pool.GetNumSlabs() >= 5);
+    for (void* block : blocks)
+    {
+        TEST_CHECK(MemoryPool::FromPointer(block) == &pool);
+    }
+
+    // 全て返却しても、スラブは解放せずに残しておく
+    const uint32_t numSlabs = pool.GetNumSlabs();
+    for (void* block : blocks)
+    {
+        pool.Free(block);
+    }
+    TEST_CHECK(pool.GetNumUsedBlocks() == 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        pool.Allocate();
+    }
+    TEST_CHECK(pool.GetNumSlabs() == numSlabs);
+}
+
+
+int main()
+{
+    TestAlignmentAndOwnership();
+    TestTinyBlocks();
+    TestFreeListReuse();
+    TestMultipleSlabs();
+    return TestResult("MemoryPoolTest");
+}
@@ -0,0 +1,72 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// 名前テーブルのテスト
+//
+//      ・大文字と小文字(ASCIIのみ)を区別しないこと、Shift-JIS(CP932)の2バイト文字の2バイト目を英字とみなさないことを確かめる。
+//      ・CP932の文字列はバイト列で書く。 (テストのソースファイルの文字コードに左右されないように)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "NameTable.h"
+#include "Hash.h"
+#include "Test.h"
+#include <string>
+
+
+// ASCIIの大文字と小文字は同じIDになり、最初に登録された綴りが残ること
+static void TestCaseInsensitive()
+{
+    const uint32_t player = NameTable::Intern("Player");
+    TEST_CHECK(NameTable::Intern("player") == player);
+    TEST_CHECK(NameTable::Intern("PLAYER") == player);
+    TEST_CHECK(NameTable::Find("pLaYeR") == player);
+    TEST_CHECK(NameTable::GetName(player) == "Player");
+
+    TEST_CHECK(NameTable::Intern("Player2") != player);
+    TEST_CHECK(NameTable::Find("Enemy") == NameTable::InvalidID);
+}
+
+
+// Shift-JISの2バイト文字の2バイト目が英字と同じ値でも、別の文字として区別されること
+static void TestShiftJISTrailBytes()
+{
+    // "ア" (0x83 0x41) と "ャ" (0x83 0x61) は、2バイト目だけ見ると 'A' と 'a'
+    const std::string katakanaA = "\x83\x41";
+    const std::string katakanaSmallYa = "\x83\x61";
+    TEST_CHECK(ComputeCaseInsensitiveHash(katakanaA.data(), katakanaA.size()) != ComputeCaseInsensitiveHash(katakanaSmallYa.data(), katakanaSmallYa.size()));
+
+    const uint32_t a = NameTable::Intern(katakanaA);
+    const uint32_t ya = NameTable::Intern(katakanaSmallYa);
+    TEST_CHECK(a != ya);
+    TEST_CHECK(NameTable::Find(katakanaA) == a);
+    TEST_CHECK(NameTable::Find(katakanaSmallYa) == ya);
+
+    // "ぷよA" と "ぷよa" は、2バイト文字の後ろの1バイト文字だけを小文字にして比較するので同じIDになる
+    // ("ぷ" = 0x82 0xD5, "よ" = 0x82 0xE6)
+    const uint32_t puyoUpper = NameTable::Intern("\x82\xD5\x82\xE6" "A");
+    TEST_CHECK(NameTable::Find("\x82\xD5\x82\xE6" "a") == puyoUpper);
+
+    // 0x81～0x9F の範囲の他の1バイト目や、0xE0～0xFC の1バイト目も2バイト文字として扱う
+    TEST_CHECK(NameTable::Intern("\x98\x40") != NameTable::Intern("\x98\x60"));
+    TEST_CHECK(NameTable::Intern("\xE0\x5A") != NameTable::Intern("\xE0\x7A"));
+
+    // 半角カナ(0xA1～0xDF)は1バイト文字なので、次のバイトは普通の文字として小文字にする
+    TEST_CHECK(NameTable::Intern("\xB1" "B") == NameTable::Intern("\xB1" "b"));
+}
+
+
+// 末尾が2バイト文字の1バイト目だけで終わっていても、範囲外を読まずに扱えること
+static void TestTruncatedLeadByte()
+{
+    const std::string truncated = "A\x83";
+    const uint32_t id = NameTable::Intern(truncated);
+    TEST_CHECK(NameTable::Find("a\x83") == id);
+    TEST_CHECK(NameTable::GetName(id) == truncated);
+}
+
+
+int main()
+{
+    TestCaseInsensitive();
+    TestShiftJISTrailBytes();
+    TestTruncatedLeadByte();
+    return TestResult("NameTableTest");
+}
@@ -0,0 +1,272 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// ヌルRHIのテスト
+//
+//      ・コマンドリストが、ドローコール・ステート設定・バリア・コピーを正しく数え、冗長なステート設定を見分けることを確かめる。
+//      ・コマンドストリームが「種類 | 引数の語数 << 8」の語と引数の語の列になっていることを確かめる。
+//      ・コマンドコンテキストが、コマンドリストを記録した順番に並べ、フレーム毎に統計情報とアップロード用のメモリを戻すことを確かめる。
+//      ・コピーキューのGPUタイムラインが、調べる度に1つずつ完了することを確かめる。
+//      ・パイプラインステートなどのハンドルは中身を見ないので、区別できる適当な値を使う。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "NullRhi.h"
+#include "Test.h"
+#include <cstring>
+#include <vector>
+
+
+// 区別できるだけの見せかけのハンドル
+static RhiPipelineState* const PipelineStateA = (RhiPipelineState*)(uintptr_t)0x1000;
+static RhiPipelineState* const PipelineStateB = (RhiPipelineState*)(uintptr_t)0x2000;
+static RhiRootSignature* const RootSignatureA = (RhiRootSignature*)(uintptr_t)0x3000;
+static RhiRootSignature* const RootSignatureB = (RhiRootSignature*)(uintptr_t)0x4000;
+static RhiDescriptorHeap* const DescriptorHeap = (RhiDescriptorHeap*)(uintptr_t)0x5000;
+static RhiResource* const ResourceA = (RhiResource*)(uintptr_t)0x6000;
+static RhiResource* const ResourceB = (RhiResource*)(uintptr_t)0x7000;
+
+
+// ドローコールと頂点の数、冗長なステート設定の検出
+static void TestCommandListCounts()
+{
+    NullRhiCommandList commandList;
+    commandList.SetPipelineState(PipelineStateA);
+    commandList.SetPipelineState(PipelineStateA);                       // 冗長
+    commandList.SetPipelineState(PipelineStateB);
+    commandList.SetGraphicsRootSignature(RootSignatureA);
+    commandList.SetGraphicsRootConstantBufferView(0, 0x10000);
+    commandList.SetGraphicsRootConstantBufferView(0, 0x10000);          // 冗長
+    commandList.SetGraphicsRootSignature(RootSignatureB);               // ルートパラメーターは未設定に戻る
+    commandList.SetGraphicsRootConstantBufferView(0, 0x10000);
+    commandList.IASetPrimitiveTopology(RhiPrimitiveTopology::TriangleList);
+    commandList.IASetPrimitiveTopology(RhiPrimitiveTopology::TriangleList); // 冗長
+
+    RhiVertexBufferView vertexBuffer = { 0x20000, 4096, 32 };
+    commandList.IASetVertexBuffer(0, vertexBuffer);
+    commandList.IASetVertexBuffer(0, vertexBuffer);                     // 冗長
+    vertexBuffer.gpuAddress += 4096;
+    commandList.IASetVertexBuffer(0, vertexBuffer);
+
+    const RhiViewport viewport = { 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f };
+    commandList.RSSetViewport(viewport);
+    commandList.RSSetViewport(viewport);                                // 冗長
+
+    commandList.DrawIndexedInstanced(6, 100, 0, 0, 0);
+    commandList.DrawInstanced(3, 1, 0, 0);
+
+    const NullRhiStats& stats = commandList.GetStats();
+    TEST_CHECK(stats.drawCount == 2);
+    TEST_CHECK(stats.vertexCount == 603);
+    TEST_CHECK(stats.stateChangeCount == 15);
+    TEST_CHECK(stats.redundantStateChangeCount == 5);
+    TEST_CHECK(stats.pipelineStateChangeCount == 2);
+    TEST_CHECK(stats.commandCount == 17);
+    TEST_CHECK(stats.streamBytes == commandList.GetStream().size() * sizeof(uint32_t));
+
+    commandList.Reset();
+    TEST_CHECK(commandList.GetStream().empty());
+    TEST_CHECK(commandList.GetStats().commandCount == 0);
+
+    // 空に戻した後は、同じステートでも冗長ではない
+    commandList.SetPipelineState(PipelineStateB);
+    TEST_CHECK(commandList.GetStats().redundantStateChangeCount == 0);
+    TEST_CHECK(commandList.GetStats().pipelineStateChangeCount == 1);
+}
+
+
+// コマンドストリームの書式と、クリア・バリア・コピーの数
+static void TestCommandStream()
+{
+    NullRhiCommandList commandList;
+    const float color[4] = { 0.0f, 0.5f, 1.0f, 1.0f };
+    commandList.ClearRenderTargetView({ 1 }, color);
+    commandList.ClearDepthStencilView({ 2 }, 1.0f, 0);
+    commandList.ResourceBarrier(ResourceA, RhiResourceState::CopyDestination, RhiResourceState::PixelShaderResource);
+    commandList.CopyBufferRegion(ResourceA, 0, ResourceB, 256, 1000);
+
+    RhiPlacedFootprint footprint;
+    memset(&footprint, 0, sizeof(footprint));
+    footprint.width = 64;
+    footprint.height = 32;
+    footprint.depth = 1;
+    footprint.rowPitch = 256;
+    commandList.CopyBufferToTexture(ResourceA, 0, 0, ResourceB, footprint);
+    commandList.DrawInstanced(4, 2, 0, 0);
+    commandList.NotifyUpload(512);
+
+    const NullRhiStats& stats = commandList.GetStats();
+    TEST_CHECK(stats.clearCount == 2);
+    TEST_CHECK(stats.barrierCount == 1);
+    TEST_CHECK(stats.copyCount == 2);
+    TEST_CHECK(stats.copyBytes == 1000 + 256 * 32);
+    TEST_CHECK(stats.uploadBytes == 512);
+    TEST_CHECK(stats.stateChangeCount == 0);
+
+    // 先頭の語を辿って、記録した順番の種類が読めること
+    const std::vector<uint32_t>& stream = commandList.GetStream();
+    const NullRhiOpcode expected[] =
+    {
+        NullRhiOpcode::ClearRenderTargetView,
+        NullRhiOpcode::ClearDepthStencilView,
+        NullRhiOpcode::ResourceBarrier,
+        NullRhiOpcode::CopyBufferRegion,
+        NullRhiOpcode::CopyBufferToTexture,
+        NullRhiOpcode::DrawInstanced,
+    };
+    size_t position = 0;
+    for (NullRhiOpcode opcode : expected)
+    {
+        TEST_CHECK(position < stream.size());
+        if (position >= stream.size())
+        {
+            return;
+        }
+        TEST_CHECK((NullRhiOpcode)(stream[position] & 0xFF) == opcode);
+        position += 1 + (stream[position] >> 8);
+    }
+    TEST_CHECK(position == stream.size());
+
+    // DrawInstanced の引数 (頂点数, インスタンス数, ...)
+    TEST_CHECK(stream[stream.size() - 4] == 4);
+    TEST_CHECK(stream[stream.size() - 3] == 2);
+}
+
+
+// コマンドリストの並び順と、フレーム毎の統計情報
+static void TestCommandContext()
+{
+    NullRhiCommandContext context(1280, 720);
+    context.SetDefaultGraphicsState(PipelineStateA, RootSignatureA, DescriptorHeap);
+    TEST_CHECK(context.GetFrameNumber() == 1);
+    TEST_CHECK(context.GetSubmitCommandLists().size() == 1);
+
+    RhiCommandList* mainCommandList = context.GetCommandList();
+    context.ApplyDefaultGraphicsState(mainCommandList);
+    mainCommandList->DrawInstanced(3, 1, 0, 0);
+
+    // 並列記録の分を取り出した後、メインスレッドは続きのコマンドリストに切り替わる
+    RhiCommandList* worker0 = context.AcquireCommandList();
+    RhiCommandList* worker1 = context.AcquireCommandList();
+    worker1->DrawInstanced(6, 1, 0, 0);
+    worker0->DrawInstanced(6, 1, 0, 0);
+    RhiCommandList* continued = context.ContinueCommandList();
+    TEST_CHECK(context.GetCommandList() == continued);
+    continued->SetPipelineState(PipelineStateA);                       // 設定済みなので冗長
+
+    const std::vector<NullRhiCommandList*>& submitCommandLists = context.GetSubmitCommandLists();
+    TEST_CHECK(submitCommandLists.size() == 4);
+    TEST_CHECK((RhiCommandList*)submitCommandLists[0] == mainCommandList);
+    TEST_CHECK((RhiCommandList*)submitCommandLists[1] == worker0);
+    TEST_CHECK((RhiCommandList*)submitCommandLists[2] == worker1);
+    TEST_CHECK((RhiCommandList*)submitCommandLists[3] == continued);
+
+    NullRhiStats stats = context.GetStats();
+    TEST_CHECK(stats.commandListCount == 4);
+    TEST_CHECK(stats.drawCount == 3);
+    TEST_CHECK(stats.vertexCount == 15);
+    TEST_CHECK(stats.pipelineStateChangeCount == 2);
+    TEST_CHECK(stats.redundantStateChangeCount == 1);
+
+    // 次のフレームでは、コマンドリストを使い回して数え直す
+    context.BeginFrame();
+    TEST_CHECK(context.GetFrameNumber() == 2);
+    TEST_CHECK(context.GetSubmitCommandLists().size() == 1);
+    TEST_CHECK(context.GetCommandList() == mainCommandList);
+    TEST_CHECK(context.AcquireCommandList() == worker0);
+    stats = context.GetStats();
+    TEST_CHECK(stats.commandListCount == 2);
+    TEST_CHECK(stats.commandCount == 0);
+    TEST_CHECK(stats.drawCount == 0);
+}
+
+
+// アップロード用のメモリのアラインメント、ページの追加、フレーム毎の再利用
+static void TestUploadMemory()
+{
+    const uint64_t capacity = 4096;
+    NullRhiCommandContext context(64, 64, capacity);
+
+    const RhiUploadAllocation first = context.AllocateUploadMemory(100);
+    const RhiUploadAllocation second = context.AllocateUploadMemory(100);
+    TEST_CHECK(first.gpuAddress == NullRhiCommandContext::UploadGpuAddressBase);
+    TEST_CHECK(second.gpuAddress == first.gpuAddress + NullRhiCommandContext::UploadAlignment);
+    TEST_CHECK((uint8_t*)second.cpuAddress == (uint8_t*)first.cpuAddress + NullRhiCommandContext::UploadAlignment);
+    memset(first.cpuAddress, 0xAB, 100);
+    memset(second.cpuAddress, 0xCD, 100);
+
+    // 入りきらない分は、次のページ(見せかけのGPU仮想アドレスも別の範囲)から切り出す
+    const RhiUploadAllocation large = context.AllocateUploadMemory(capacity);
+    TEST_CHECK(large.gpuAddress == NullRhiCommandContext::UploadGpuAddressBase + (1ULL << 32));
+    memset(large.cpuAddress, 0xEF, (size_t)capacity);
+    const RhiUploadAllocation huge = context.AllocateUploadMemory(capacity * 3);
+    TEST_CHECK(huge.gpuAddress == NullRhiCommandContext::UploadGpuAddressBase + (2ULL << 32));
+    memset(huge.cpuAddress, 0x12, (size_t)(capacity * 3));
+
+    // ページを追加しても、先に切り出した領域は動かない
+    TEST_CHECK(((uint8_t*)first.cpuAddress)[99] == 0xAB);
+    TEST_CHECK(((uint8_t*)second.cpuAddress)[0] == 0xCD);
+    TEST_CHECK(context.GetStats().uploadBytes == 200 + capacity * 4);
+
+    // 次のフレームは先頭のページから切り出し直す
+    context.BeginFrame();
+    TEST_CHECK(context.GetStats().uploadBytes == 0);
+    const RhiUploadAllocation reused = context.AllocateUploadMemory(16);
+    TEST_CHECK(reused.gpuAddress == NullRhiCommandContext::UploadGpuAddressBase);
+    TEST_CHECK(reused.cpuAddress == first.cpuAddress);
+}
+
+
+// コピーキューのGPUタイムラインと統計情報
+static void TestCopyQueue()
+{
+    NullRhiCopyQueue copyQueue;
+    GpuTimeline* timeline = copyQueue.GetTimeline();
+    TEST_CHECK(timeline->GetCompletedValue() == 0);
+
+    copyQueue.GetCommandList()->CopyBufferRegion(ResourceA, 0, ResourceB, 0, 100);
+    const uint64_t first = copyQueue.Submit();
+    copyQueue.GetCommandList()->CopyBufferRegion(ResourceA, 100, ResourceB, 100, 200);
+    copyQueue.GetCommandList()->ResourceBarrier(ResourceA, RhiResourceState::CopyDestination, RhiResourceState::PixelShaderResource);
+    const uint64_t second = copyQueue.Submit();
+    const uint64_t third = copyQueue.Submit();
+    TEST_CHECK((first == 1) && (second == 2) && (third == 3));
+
+    // 送った後のコマンドリストは空に戻っている
+    TEST_CHECK(static_cast<NullRhiCommandList*>(copyQueue.GetCommandList())->GetStream().empty());
+
+    // 調べる度に1つずつ完了する (調べた時点の値を返してから進む)
+    TEST_CHECK(timeline->GetCompletedValue() == 0);
+    TEST_CHECK(timeline->GetCompletedValue() == 1);
+    timeline->WaitForValue(3);
+    TEST_CHECK(timeline->GetCompletedValue() == 3);
+    TEST_CHECK(timeline->GetCompletedValue() == 3);
+
+    const NullRhiStats& stats = copyQueue.GetStats();
+    TEST_CHECK(stats.commandListCount == 3);
+    TEST_CHECK(stats.copyCount == 2);
+    TEST_CHECK(stats.copyBytes == 300);
+    TEST_CHECK(stats.barrierCount == 1);
+}
+
+
+// すぐに完了するGPUタイムライン
+static void TestNullGpuTimeline()
+{
+    NullGpuTimeline timeline;
+    TEST_CHECK(timeline.GetCompletedValue() == 0);
+    const uint64_t value = timeline.Signal();
+    TEST_CHECK(value == 1);
+    TEST_CHECK(timeline.GetCompletedValue() == value);
+    timeline.WaitForValue(value);
+    TEST_CHECK(timeline.Signal() == 2);
+}
+
+
+int main()
+{
+    TestCommandListCounts();
+    TestCommandStream();
+    TestCommandContext();
+    TestUploadMemory();
+    TestCopyQueue();
+    TestNullGpuTimeline();
+    return TestResult("NullRhiTest");
+}
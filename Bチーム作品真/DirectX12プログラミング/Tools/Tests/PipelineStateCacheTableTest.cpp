@@ -0,0 +1,404 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// パイプラインステートキャッシュテーブルのテスト
+//
+//      ・同じ詳細情報からは同じハッシュ値になり、ブレンド・レンダーターゲットのフォーマット・シェーダーの中身・ルートシグネチャの
+//        シリアライズ済みデータのどれかが変わればハッシュ値も変わることを確かめる。
+//      ・作成中の項目があれば、別のスレッドは作成せずに完了を待ち、同じパイプラインステートを受け取ることを確かめる。
+//      ・統計情報の項目数には、作成中の項目が含まれないことを確かめる。
+//      ・詳細情報は D3D12_GRAPHICS_PIPELINE_STATE_DESC と同じ名前のメンバを持つ偽物を使う。 (GPUは使わない)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "PipelineStateCacheTable.h"
+#include "Test.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+
+// D3D12_GRAPHICS_PIPELINE_STATE_DESC と同じ名前のメンバを持つ偽物
+struct FakeShaderBytecode
+{
+    const void* pShaderBytecode;
+    size_t BytecodeLength;
+};
+
+struct FakeInputElementDesc
+{
+    const char* SemanticName;
+    uint32_t SemanticIndex;
+    uint32_t Format;
+    uint32_t InputSlot;
+    uint32_t AlignedByteOffset;
+    uint32_t InputSlotClass;
+    uint32_t InstanceDataStepRate;
+};
+
+struct FakeRenderTargetBlendDesc
+{
+    int BlendEnable;
+    int LogicOpEnable;
+    uint32_t SrcBlend;
+    uint32_t DestBlend;
+    uint32_t BlendOp;
+    uint32_t SrcBlendAlpha;
+    uint32_t DestBlendAlpha;
+    uint32_t BlendOpAlpha;
+    uint32_t LogicOp;
+    uint8_t RenderTargetWriteMask;
+};
+
+struct FakeStencilOpDesc
+{
+    uint32_t StencilFailOp;
+    uint32_t StencilDepthFailOp;
+    uint32_t StencilPassOp;
+    uint32_t StencilFunc;
+};
+
+struct FakePipelineStateDesc
+{
+    FakeShaderBytecode VS, PS, DS, HS, GS;
+    struct { int AlphaToCoverageEnable; int IndependentBlendEnable; FakeRenderTargetBlendDesc RenderTarget[8]; } BlendState;
+    uint32_t SampleMask;
+    struct
+    {
+        uint32_t FillMode, CullMode;
+        int FrontCounterClockwise;
+        int DepthBias;
+        float DepthBiasClamp, SlopeScaledDepthBias;
+        int DepthClipEnable, MultisampleEnable, AntialiasedLineEnable;
+        uint32_t ForcedSampleCount, ConservativeRaster;
+    } RasterizerState;
+    struct
+    {
+        int DepthEnable;
+        uint32_t DepthWriteMask, DepthFunc;
+        int StencilEnable;
+        uint8_t StencilReadMask, StencilWriteMask;
+        FakeStencilOpDesc FrontFace, BackFace;
+    } DepthStencilState;
+    struct { const FakeInputElementDesc* pInputElementDescs; uint32_t NumElements; } InputLayout;
+    uint32_t IBStripCutValue;
+    uint32_t PrimitiveTopologyType;
+    uint32_t NumRenderTargets;
+    uint32_t RTVFormats[8];
+    uint32_t DSVFormat;
+    struct { uint32_t Count, Quality; } SampleDesc;
+    uint32_t NodeMask;
+    uint32_t Flags;
+};
+
+
+// スプライト描画用のパイプラインステートに近い詳細情報を作る
+static const uint8_t VertexShaderBytes[] = { 0x44, 0x58, 0x42, 0x43, 0x01, 0x02, 0x03, 0x04 };
+static const uint8_t PixelShaderBytes[] = { 0x44, 0x58, 0x42, 0x43, 0x05, 0x06, 0x07, 0x08 };
+static const FakeInputElementDesc InputElements[] =
+{
+    { "POSITION", 0, 6, 0, 0, 0, 0 },
+    { "COLOR", 0, 2, 0, 12, 0, 0 },
+    { "TEXCOORD", 0, 16, 0, 28, 0, 0 },
+};
+
+static FakePipelineStateDesc MakeDesc()
+{
+    FakePipelineStateDesc desc = {};
+    desc.VS = { VertexShaderBytes, sizeof(VertexShaderBytes) };
+    desc.PS = { PixelShaderBytes, sizeof(PixelShaderBytes) };
+    desc.BlendState.RenderTarget[0] = { 1, 0, 5, 6, 1, 2, 1, 1, 4, 0x0F };
+    desc.SampleMask = 0xFFFFFFFF;
+    desc.RasterizerState.FillMode = 3;
+    desc.RasterizerState.CullMode = 1;
+    desc.RasterizerState.DepthClipEnable = 1;
+    desc.DepthStencilState.DepthFunc = 2;
+    desc.InputLayout = { InputElements, 3 };
+    desc.PrimitiveTopologyType = 3;
+    desc.NumRenderTargets = 1;
+    desc.RTVFormats[0] = 28;
+    desc.SampleDesc.Count = 1;
+    return desc;
+}
+
+
+// 偽物のパイプラインステート
+class FakePipelineState
+{
+private:
+    std::atomic<uint32_t> m_referenceCount;     // 参照カウント (COMと同じく 1 から始まる)
+
+public:
+    static std::atomic<int> s_liveCount;        // 破棄されていない偽物のパイプラインステートの数
+
+public:
+    FakePipelineState()
+        : m_referenceCount(1)
+    {
+        s_liveCount++;
+    }
+
+    ~FakePipelineState()
+    {
+        s_liveCount--;
+    }
+
+    uint32_t GetReferenceCount() const { return m_referenceCount.load(); }
+
+    uint32_t AddRef() { return ++m_referenceCount; }
+
+    uint32_t Release()
+    {
+        const uint32_t referenceCount = --m_referenceCount;
+        if (referenceCount == 0)
+        {
+            delete this;
+        }
+        return referenceCount;
+    }
+};
+
+std::atomic<int> FakePipelineState::s_liveCount(0);
+
+
+// 同じ詳細情報は同じハッシュ値、どこかが変われば違うハッシュ値
+static void TestHash()
+{
+    const uint8_t rootSignatureBlob[] = { 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00 };
+    const uint64_t rootSignatureHash = PipelineStateHash::ComputeRootSignatureHash(rootSignatureBlob, sizeof(rootSignatureBlob));
+
+    // 別々に作った同じ内容の詳細情報 (シェーダーは別のバッファに置いても、中身が同じなら同じハッシュ値)
+    const FakePipelineStateDesc base = MakeDesc();
+    FakePipelineStateDesc same = MakeDesc();
+    std::vector<uint8_t> copiedVertexShader(VertexShaderBytes, VertexShaderBytes + sizeof(VertexShaderBytes));
+    same.VS.pShaderBytecode = copiedVertexShader.data();
+    const uint64_t baseHash = PipelineStateHash::Compute(base, rootSignatureHash);
+    TEST_CHECK(baseHash == PipelineStateHash::Compute(same, rootSignatureHash));
+
+    // ルートシグネチャも、別のバッファにある同じ中身なら同じハッシュ値
+    std::vector<uint8_t> copiedBlob(rootSignatureBlob, rootSignatureBlob + sizeof(rootSignatureBlob));
+    TEST_CHECK(rootSignatureHash == PipelineStateHash::ComputeRootSignatureHash(copiedBlob.data(), copiedBlob.size()));
+
+    // 独立したブレンドが無効な間は、[1]以降のブレンド設定は使われないので、ハッシュ値も変わらない
+    FakePipelineStateDesc unusedBlend = MakeDesc();
+    unusedBlend.BlendState.RenderTarget[1].BlendEnable = 1;
+    TEST_CHECK(baseHash == PipelineStateHash::Compute(unusedBlend, rootSignatureHash));
+
+    // ブレンド
+    FakePipelineStateDesc blend = MakeDesc();
+    blend.BlendState.RenderTarget[0].DestBlend = 2;
+    TEST_CHECK(baseHash != PipelineStateHash::Compute(blend, rootSignatureHash));
+    FakePipelineStateDesc blendDisabled = MakeDesc();
+    blendDisabled.BlendState.RenderTarget[0].BlendEnable = 0;
+    TEST_CHECK(baseHash != PipelineStateHash::Compute(blendDisabled, rootSignatureHash));
+
+    // レンダーターゲットのフォーマットと数
+    FakePipelineStateDesc renderTargetFormat = MakeDesc();
+    renderTargetFormat.RTVFormats[0] = 29;
+    TEST_CHECK(baseHash != PipelineStateHash::Compute(renderTargetFormat, rootSignatureHash));
+    FakePipelineStateDesc renderTargetCount = MakeDesc();
+    renderTargetCount.NumRenderTargets = 2;
+    renderTargetCount.RTVFormats[1] = 28;
+    TEST_CHECK(baseHash != PipelineStateHash::Compute(renderTargetCount, rootSignatureHash));
+
+    // シェーダーの中身 (長さが同じで、1バイトだけ違う)
+    std::vector<uint8_t> changedPixelShader(PixelShaderBytes, PixelShaderBytes + sizeof(PixelShaderBytes));
+    changedPixelShader.back() ^= 0x80;
+    FakePipelineStateDesc shaderBytes = MakeDesc();
+    shaderBytes.PS.pShaderBytecode = changedPixelShader.data();
+    TEST_CHECK(baseHash != PipelineStateHash::Compute(shaderBytes, rootSignatureHash));
+
+    // 頂点シェーダーとピクセルシェーダーを入れ替えた場合
+    FakePipelineStateDesc swappedShaders = MakeDesc();
+    swappedShaders.VS = base.PS;
+    swappedShaders.PS = base.VS;
+    TEST_CHECK(baseHash != PipelineStateHash::Compute(swappedShaders, rootSignatureHash));
+
+    // ルートシグネチャのシリアライズ済みデータ
+    copiedBlob[4] = 0x03;
+    const uint64_t changedRootSignatureHash = PipelineStateHash::ComputeRootSignatureHash(copiedBlob.data(), copiedBlob.size());
+    TEST_CHECK(rootSignatureHash != changedRootSignatureHash);
+    TEST_CHECK(baseHash != PipelineStateHash::Compute(base, changedRootSignatureHash));
+
+    // 入力レイアウトのセマンティック名 (ポインターではなく文字列の中身)
+    FakeInputElementDesc changedElements[3] = { InputElements[0], InputElements[1], InputElements[2] };
+    changedElements[1].SemanticName = "NORMAL";
+    FakePipelineStateDesc semantic = MakeDesc();
+    semantic.InputLayout.pInputElementDescs = changedElements;
+    TEST_CHECK(baseHash != PipelineStateHash::Compute(semantic, rootSignatureHash));
+}
+
+
+// Find() と Add() と、統計情報の項目数
+static void TestFindAndAdd()
+{
+    PipelineStateCacheTable<FakePipelineState> table;
+    TEST_CHECK(table.Find(1) == nullptr);
+
+    FakePipelineState* pipelineState = new FakePipelineState();
+    table.Add(1, pipelineState);
+    TEST_CHECK(pipelineState->GetReferenceCount() == 2);    // テーブル + 呼び出し元
+
+    FakePipelineState* found = table.Find(1);
+    TEST_CHECK(found == pipelineState);
+    TEST_CHECK(pipelineState->GetReferenceCount() == 3);
+    found->Release();
+    TEST_CHECK(table.GetStats().entryCount == 1);
+
+    // 作成中の項目は Find() では見つからず、項目数にも含まれない
+    bool isCreator = false;
+    TEST_CHECK(table.Acquire(2, isCreator) == nullptr);
+    TEST_CHECK(isCreator);
+    TEST_CHECK(table.Find(2) == nullptr);
+    TEST_CHECK(table.GetStats().entryCount == 1);
+
+    FakePipelineState* created = new FakePipelineState();
+    table.Publish(2, created, true);
+    PipelineStateCacheStats stats = table.GetStats();
+    TEST_CHECK(stats.entryCount == 2);
+    TEST_CHECK(stats.libraryHitCount == 1);
+    TEST_CHECK(stats.compileCount == 0);
+
+    // 作成に失敗した項目は消えて、次の Acquire() で作成し直す
+    TEST_CHECK(table.Acquire(3, isCreator) == nullptr);
+    TEST_CHECK(isCreator);
+    table.Publish(3, nullptr, false);
+    TEST_CHECK(table.GetStats().entryCount == 2);
+    TEST_CHECK(table.Acquire(3, isCreator) == nullptr);
+    TEST_CHECK(isCreator);
+    table.Publish(3, nullptr, false);
+
+    stats = table.GetStats();
+    TEST_CHECK(stats.entryCount == 2);
+    TEST_CHECK(stats.hitCount == 0);
+    TEST_CHECK(stats.compileCount == 0);
+
+    table.Clear();
+    TEST_CHECK(table.GetStats().entryCount == 0);
+    created->Release();
+    pipelineState->Release();
+    TEST_CHECK(FakePipelineState::s_liveCount == 0);
+}
+
+
+// 作成中の項目があれば、別のスレッドは作成せずに完了を待つ
+static void TestInFlightBlocksSecondCreate()
+{
+    PipelineStateCacheTable<FakePipelineState> table;
+    std::atomic<uint32_t> createCount(0);
+
+    bool isCreator = false;
+    TEST_CHECK(table.Acquire(42, isCreator) == nullptr);
+    TEST_CHECK(isCreator);
+    createCount++;
+
+    // 作成中に要求したスレッドは、Publish() されるまで戻らない
+    const uint32_t numWaiters = 4;
+    std::atomic<uint32_t> returnedCount(0);
+    std::vector<FakePipelineState*> results(numWaiters, nullptr);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < numWaiters; i++)
+    {
+        threads.emplace_back([&table, &results, &createCount, &returnedCount, i]()
+        {
+            bool isWaiterCreator = false;
+            results[i] = table.Acquire(42, isWaiterCreator);
+            if (isWaiterCreator)
+            {
+                createCount++;
+            }
+            returnedCount++;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    TEST_CHECK(returnedCount == 0);
+
+    FakePipelineState* pipelineState = new FakePipelineState();
+    table.Publish(42, pipelineState, false);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    TEST_CHECK(createCount == 1);
+    for (FakePipelineState* result : results)
+    {
+        TEST_CHECK(result == pipelineState);
+    }
+    const PipelineStateCacheStats stats = table.GetStats();
+    TEST_CHECK(stats.compileCount == 1);
+    TEST_CHECK(stats.hitCount == numWaiters);
+    TEST_CHECK(stats.entryCount == 1);
+    TEST_CHECK(pipelineState->GetReferenceCount() == 2 + numWaiters);
+
+    for (FakePipelineState* result : results)
+    {
+        result->Release();
+    }
+    table.Clear();
+    pipelineState->Release();
+    TEST_CHECK(FakePipelineState::s_liveCount == 0);
+}
+
+
+// 作成に失敗した場合は、待っていたスレッドのどれか1つだけが作成し直す
+static void TestFailedCreateWakesOneCreator()
+{
+    PipelineStateCacheTable<FakePipelineState> table;
+
+    bool isCreator = false;
+    TEST_CHECK(table.Acquire(7, isCreator) == nullptr);
+    TEST_CHECK(isCreator);
+
+    const uint32_t numWaiters = 3;
+    std::atomic<uint32_t> createCount(0);
+    std::vector<FakePipelineState*> results(numWaiters, nullptr);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < numWaiters; i++)
+    {
+        threads.emplace_back([&table, &results, &createCount, i]()
+        {
+            bool isWaiterCreator = false;
+            FakePipelineState* result = table.Acquire(7, isWaiterCreator);
+            if (isWaiterCreator)
+            {
+                // 作成し直したスレッドが、他のスレッドに配る
+                createCount++;
+                result = new FakePipelineState();
+                table.Publish(7, result, false);
+            }
+            results[i] = result;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    table.Publish(7, nullptr, false);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    TEST_CHECK(createCount == 1);
+    for (FakePipelineState* result : results)
+    {
+        TEST_CHECK(result && (result == results[0]));
+    }
+    const PipelineStateCacheStats stats = table.GetStats();
+    TEST_CHECK(stats.compileCount == 1);
+    TEST_CHECK(stats.hitCount == numWaiters - 1);
+    TEST_CHECK(stats.entryCount == 1);
+
+    for (FakePipelineState* result : results)
+    {
+        result->Release();
+    }
+    table.Clear();
+    TEST_CHECK(FakePipelineState::s_liveCount == 0);
+}
+
+
+int main()
+{
+    TestHash();
+    TestFindAndAdd();
+    TestInFlightBlocksSecondCreate();
+    TestFailedCreateWakesOneCreator();
+    return TestResult("PipelineStateCacheTableTest");
+}
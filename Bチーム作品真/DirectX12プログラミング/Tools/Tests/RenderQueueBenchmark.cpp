@@ -0,0 +1,113 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// レンダーキューのベンチマーク
+//
+//      ・スプライトと同じ作り方のソートキー(ソーティングレイヤー、順序、深度、ステート、積んだ順番)を積み、
+//        レンダーキューの基数ソートと std::stable_sort() / std::sort() の時間を比べる。
+//      ・パケットの配列はフレームを跨いで使い回す想定なので、計測前に1回並べ替えて容量を確保しておく。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "RenderQueue.h"
+#include "Test.h"
+#include <random>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+
+// スプライトのようなソートキーを count 個作る
+static std::vector<uint64_t> MakeSpriteKeys(uint32_t count, float transparentRatio, std::mt19937& random)
+{
+    std::uniform_int_distribution<int> layer(0, 3);
+    std::uniform_int_distribution<int> order(-5, 5);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> pipeline(0, 2);
+    std::uniform_int_distribution<uint32_t> texture(0, 63);
+
+    std::vector<uint64_t> keys(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        RenderQueue::SortKeyDesc desc;
+        desc.cameraIndex = 0;
+        desc.sortingLayer = layer(random);
+        desc.sortingOrder = order(random);
+        desc.isTransparent = unit(random) < transparentRatio;
+        desc.depth = unit(random);
+        desc.pipelineIndex = pipeline(random);
+        desc.textureIndex = texture(random);
+        desc.sequence = i;
+        keys[i] = RenderQueue::MakeSortKey(desc);
+    }
+    return keys;
+}
+
+
+// 1回あたりの平均時間 (ミリ秒) を計る
+template<typename Function>
+static double Measure(uint32_t repeat, Function function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < repeat; i++)
+    {
+        function();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+}
+
+
+int main()
+{
+    std::mt19937 random(1);
+    const uint32_t repeat = 20;
+    const auto byKey = [](const RenderQueue::Packet& a, const RenderQueue::Packet& b) { return a.sortKey < b.sortKey; };
+
+    printf("[情報] %8s %8s %14s %18s %14s\n", "個数", "半透明", "基数ソート", "std::stable_sort", "std::sort");
+    for (uint32_t count : { 1000u, 10000u, 50000u, 100000u })
+    {
+        for (float transparentRatio : { 0.0f, 1.0f })
+        {
+            const std::vector<uint64_t> keys = MakeSpriteKeys(count, transparentRatio, random);
+
+            RenderQueue queue;
+            const auto submitAll = [&]()
+            {
+                queue.Clear();
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    queue.Submit(keys[i], i);
+                }
+            };
+            submitAll();
+            queue.Sort();
+            const std::vector<RenderQueue::Packet> unsorted = [&]()
+            {
+                submitAll();
+                return queue.GetPackets();
+            }();
+
+            const double radixMilliseconds = Measure(repeat, [&]() { submitAll(); queue.Sort(); });
+            const double submitMilliseconds = Measure(repeat, submitAll);
+
+            std::vector<RenderQueue::Packet> work;
+            const double stableMilliseconds = Measure(repeat, [&]() { work = unsorted; std::stable_sort(work.begin(), work.end(), byKey); });
+            const double copyMilliseconds = Measure(repeat, [&]() { work = unsorted; });
+            const double unstableMilliseconds = Measure(repeat, [&]() { work = unsorted; std::sort(work.begin(), work.end(), byKey); });
+
+            // 結果は std::stable_sort() と一致すること
+            submitAll();
+            queue.Sort();
+            work = unsorted;
+            std::stable_sort(work.begin(), work.end(), byKey);
+            bool same = true;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                same = same && (queue.GetPackets()[i].payload == work[i].payload);
+            }
+            TEST_CHECK(same);
+
+            // 積む時間とコピーの時間は差し引いて、並べ替えだけの時間を出す
+            printf("[情報] %8u %7.0f%% %11.3f ms %15.3f ms %11.3f ms\n", count, transparentRatio * 100.0f,
+                radixMilliseconds - submitMilliseconds, stableMilliseconds - copyMilliseconds, unstableMilliseconds - copyMilliseconds);
+        }
+    }
+    return TestResult("RenderQueueBenchmark");
+}
@@ -0,0 +1,178 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// レンダーキューのテスト
+//
+//      ・ソートキーの優先順位(カメラ → ソーティングレイヤー → レイヤー内の順序 → 不透明/半透明 → 深度とステート)を確かめる。
+//      ・半透明は深度が等しければ積んだ順番(階層順)のまま並び、パイプラインやテクスチャで入れ替わらないことを確かめる。
+//      ・基数ソートの結果が std::stable_sort() と一致することを確かめる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "RenderQueue.h"
+#include "Test.h"
+#include <random>
+#include <vector>
+#include <algorithm>
+
+
+// 既定値のソートキーの作成に使う値を返す
+static RenderQueue::SortKeyDesc MakeDesc()
+{
+    RenderQueue::SortKeyDesc desc;
+    desc.cameraIndex = 0;
+    desc.sortingLayer = 0;
+    desc.sortingOrder = 0;
+    desc.isTransparent = true;
+    desc.depth = 0.5f;
+    desc.pipelineIndex = 0;
+    desc.textureIndex = 0;
+    desc.sequence = 0;
+    return desc;
+}
+
+
+// 上位の項目ほど優先されること
+static void TestKeyPriority()
+{
+    RenderQueue::SortKeyDesc a = MakeDesc();
+    RenderQueue::SortKeyDesc b = MakeDesc();
+
+    // ソーティングレイヤーは、レイヤー内の順序や深度よりも優先される
+    a.sortingLayer = -1;
+    a.sortingOrder = 100;
+    a.depth = 0.0f;
+    b.sortingLayer = 0;
+    b.sortingOrder = -100;
+    b.depth = 1.0f;
+    TEST_CHECK(RenderQueue::MakeSortKey(a) < RenderQueue::MakeSortKey(b));
+
+    // 同じ順序の中では、不透明が半透明よりも先
+    a = MakeDesc();
+    b = MakeDesc();
+    a.isTransparent = false;
+    a.depth = 1.0f;
+    b.depth = 0.0f;
+    TEST_CHECK(RenderQueue::MakeSortKey(a) < RenderQueue::MakeSortKey(b));
+    TEST_CHECK(!RenderQueue::IsTransparent(RenderQueue::MakeSortKey(a)));
+    TEST_CHECK(RenderQueue::IsTransparent(RenderQueue::MakeSortKey(b)));
+
+    // 半透明は奥から手前へ
+    a = MakeDesc();
+    b = MakeDesc();
+    a.depth = 0.9f;
+    b.depth = 0.1f;
+    TEST_CHECK(RenderQueue::MakeSortKey(a) < RenderQueue::MakeSortKey(b));
+
+    // 不透明はステート(パイプライン → テクスチャ)でまとめて、その中では手前から奥へ
+    a = MakeDesc();
+    b = MakeDesc();
+    a.isTransparent = b.isTransparent = false;
+    a.pipelineIndex = 0;
+    a.depth = 0.9f;
+    b.pipelineIndex = 1;
+    b.depth = 0.1f;
+    TEST_CHECK(RenderQueue::MakeSortKey(a) < RenderQueue::MakeSortKey(b));
+    b.pipelineIndex = 0;
+    TEST_CHECK(RenderQueue::MakeSortKey(b) < RenderQueue::MakeSortKey(a));
+
+    // 範囲外の値は範囲内に収める
+    a = MakeDesc();
+    b = MakeDesc();
+    a.sortingLayer = -1000;
+    b.sortingLayer = -128;
+    TEST_CHECK(RenderQueue::MakeSortKey(a) == RenderQueue::MakeSortKey(b));
+    a.depth = -1.0f;
+    b.depth = 0.0f;
+    a.sortingLayer = b.sortingLayer = 0;
+    TEST_CHECK(RenderQueue::MakeSortKey(a) == RenderQueue::MakeSortKey(b));
+}
+
+
+// 半透明は深度が等しければ、パイプラインやテクスチャが違っても積んだ順番のまま並ぶこと
+// (全てのスプライトが z = 0 の2Dゲームで、階層順の重なり順が保たれる)
+static void TestTransparentKeepsSubmissionOrder()
+{
+    RenderQueue queue;
+    const uint32_t count = 1000;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        RenderQueue::SortKeyDesc desc = MakeDesc();
+        desc.pipelineIndex = (count - i) % 3;
+        desc.textureIndex = (i * 7919) % 4096;
+        desc.sequence = i;
+        queue.Submit(RenderQueue::MakeSortKey(desc), i);
+    }
+    queue.Sort();
+
+    const std::vector<RenderQueue::Packet>& packets = queue.GetPackets();
+    bool inOrder = true;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        inOrder = inOrder && (packets[i].payload == i);
+    }
+    TEST_CHECK(inOrder);
+
+    // 積んだ順番が15ビットに収まらなくても、飽和した後は安定ソートで順番が保たれる
+    queue.Clear();
+    const uint32_t manyCount = 50000;
+    for (uint32_t i = 0; i < manyCount; i++)
+    {
+        RenderQueue::SortKeyDesc desc = MakeDesc();
+        desc.sortingOrder = (i < manyCount / 2) ? 1 : 0;
+        desc.textureIndex = i % 4096;
+        desc.sequence = i;
+        queue.Submit(RenderQueue::MakeSortKey(desc), i);
+    }
+    queue.Sort();
+    inOrder = true;
+    for (uint32_t i = 0; i < manyCount; i++)
+    {
+        // 順序 0 の後半が先、順序 1 の前半が後で、それぞれの中は積んだ順番
+        const uint32_t expected = (i < manyCount / 2) ? (manyCount / 2 + i) : (i - manyCount / 2);
+        inOrder = inOrder && (queue.GetPackets()[i].payload == expected);
+    }
+    TEST_CHECK(inOrder);
+}
+
+
+// 乱数のキーで、基数ソートの結果が std::stable_sort() と一致すること
+static void TestMatchesStableSort()
+{
+    std::mt19937_64 random(42);
+    RenderQueue queue;
+    for (int round = 0; round < 20; round++)
+    {
+        queue.Clear();
+        std::vector<RenderQueue::Packet> expected;
+        const uint32_t count = 1 + (uint32_t)(random() % 5000);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            // 桁によっては全てのキーで同じ値になるように、ラウンド毎にマスクを変える (省略されるパスを含める)
+            const uint64_t mask = (round % 2 == 0) ? ~0ull : 0x0000FFFF00FF0F00ull;
+            const uint64_t key = random() & mask & ((round % 3 == 0) ? 0xFFull : ~0ull);
+            queue.Submit(key, i);
+
+            RenderQueue::Packet packet;
+            packet.sortKey = key;
+            packet.payload = i;
+            packet.reserved = 0;
+            expected.push_back(packet);
+        }
+        queue.Sort();
+        std::stable_sort(expected.begin(), expected.end(), [](const RenderQueue::Packet& a, const RenderQueue::Packet& b) { return a.sortKey < b.sortKey; });
+
+        bool same = (queue.GetCount() == count);
+        for (uint32_t i = 0; same && (i < count); i++)
+        {
+            same = (queue.GetPackets()[i].sortKey == expected[i].sortKey) && (queue.GetPackets()[i].payload == expected[i].payload);
+        }
+        TEST_CHECK(same);
+    }
+}
+
+
+int main()
+{
+    TestKeyPriority();
+    TestTransparentKeepsSubmissionOrder();
+    TestMatchesStableSort();
+    return TestResult("RenderQueueTest");
+}
@@ -0,0 +1,100 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// シェーダーキャッシュのキーのテスト
+//
+//      ・シェーダーモデルからバイトコードの形式(DXBC / DXIL)が正しく決まり、形式が違えば別のキーになることを確かめる。
+//        (シェーダークッカーの DXIL とゲーム本体の DXBC が同じキャッシュファイルを取り合わないように)
+//      ・インクルードしているファイルの中身がキーに反映され、改行コードの違いは反映されないことを確かめる。
+//      ・ソースファイルは一時ディレクトリに作成する。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "ShaderCacheKey.h"
+#include "Test.h"
+#include <fstream>
+#include <filesystem>
+
+
+// 一時ディレクトリにファイルを書き出す
+static void WriteFile(const std::filesystem::path& path, const std::string& text)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+}
+
+
+// キーを計算する (読み込めなかった場合は 0 を返す)
+static uint64_t ComputeKey(const std::filesystem::path& path, const std::string& shaderProfile, const std::vector<ShaderDefine>& defines = {})
+{
+    uint64_t key = 0;
+    TEST_CHECK(ShaderCacheKey::Compute(path, shaderProfile, "main", defines, &key));
+    return key;
+}
+
+
+// シェーダーモデル 6.0 以降は DXIL、それ以外は DXBC になること
+static void TestBytecodeFormat()
+{
+    TEST_CHECK(ShaderCacheKey::GetBytecodeFormat("vs_5_1") == ShaderBytecodeFormat::Dxbc);
+    TEST_CHECK(ShaderCacheKey::GetBytecodeFormat("ps_5_0") == ShaderBytecodeFormat::Dxbc);
+    TEST_CHECK(ShaderCacheKey::GetBytecodeFormat("ps_4_0_level_9_3") == ShaderBytecodeFormat::Dxbc);
+    TEST_CHECK(ShaderCacheKey::GetBytecodeFormat("vs_6_0") == ShaderBytecodeFormat::Dxil);
+    TEST_CHECK(ShaderCacheKey::GetBytecodeFormat("cs_6_6") == ShaderBytecodeFormat::Dxil);
+    TEST_CHECK(ShaderCacheKey::GetBytecodeFormat("lib_6_3") == ShaderBytecodeFormat::Dxil);
+    TEST_CHECK(ShaderCacheKey::GetBytecodeFormat("") == ShaderBytecodeFormat::Dxbc);
+    TEST_CHECK(ShaderCacheKey::GetBytecodeFormat("vs_") == ShaderBytecodeFormat::Dxbc);
+}
+
+
+// プロファイル(と形式)やマクロ定義が違えば別のキーになり、同じなら同じキーになること
+static void TestKeyInputs(const std::filesystem::path& directory)
+{
+    const std::filesystem::path path = directory / "Sprite.hlsl";
+    WriteFile(path, "float4 main() : SV_POSITION { return 0; }\n");
+
+    const uint64_t dxbc = ComputeKey(path, "vs_5_1");
+    const uint64_t dxil = ComputeKey(path, "vs_6_0");
+    TEST_CHECK(dxbc != 0);
+    TEST_CHECK(dxbc != dxil);
+    TEST_CHECK(ComputeKey(path, "vs_5_1") == dxbc);
+    TEST_CHECK(ComputeKey(path, "vs_5_1", { { "PREMULTIPLIED_ALPHA", "1" } }) != dxbc);
+
+    uint64_t key;
+    TEST_CHECK(!ShaderCacheKey::Compute(directory / "Missing.hlsl", "vs_5_1", "main", {}, &key));
+}
+
+
+// インクルードしているファイルの変更はキーに反映され、改行コードの違いは反映されないこと
+static void TestIncludedFiles(const std::filesystem::path& directory)
+{
+    const std::filesystem::path path = directory / "Batch.hlsl";
+    const std::filesystem::path includePath = directory / "Common.hlsli";
+    WriteFile(path, "#include \"Common.hlsli\"\nfloat4 main() : SV_TARGET { return Tint; }\n");
+    WriteFile(includePath, "static const float4 Tint = 1;\n");
+    const uint64_t original = ComputeKey(path, "ps_5_1");
+
+    WriteFile(includePath, "static const float4 Tint = 0.5;\n");
+    const uint64_t modified = ComputeKey(path, "ps_5_1");
+    TEST_CHECK(modified != original);
+
+    WriteFile(path, "#include \"Common.hlsli\"\r\nfloat4 main() : SV_TARGET { return Tint; }\r\n");
+    WriteFile(includePath, "static const float4 Tint = 0.5;\r\n");
+    TEST_CHECK(ComputeKey(path, "ps_5_1") == modified);
+
+    std::filesystem::remove(includePath);
+    uint64_t key;
+    TEST_CHECK(!ShaderCacheKey::Compute(path, "ps_5_1", "main", {}, &key));
+}
+
+
+int main()
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "ShaderCacheKeyTest";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    TestBytecodeFormat();
+    TestKeyInputs(directory);
+    TestIncludedFiles(directory);
+
+    std::filesystem::remove_all(directory);
+    return TestResult("ShaderCacheKeyTest");
+}
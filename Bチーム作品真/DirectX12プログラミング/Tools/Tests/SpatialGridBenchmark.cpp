@@ -0,0 +1,105 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// 空間グリッドのベンチマーク
+//
+//      ・10万個のスプライトを画面64枚分の広さに散らばらせ、画面1枚分(1280x720)のカメラで毎フレーム検索する。
+//      ・全てのスプライトを総当たりで調べる場合と、空間グリッドで絞り込む場合の時間を比べる。
+//      ・毎フレーム1%のスプライトが動き、空間グリッドの登録を更新する時間も計る。
+//      ・実機の GPU やカメラの視錐台判定は含まない。 (CPU で候補を絞り込む部分だけ)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "SpatialGrid.h"
+#include "Test.h"
+#include <random>
+#include <vector>
+#include <chrono>
+#include <cmath>
+
+
+int main()
+{
+    const uint32_t numSprites = 100000;
+    const uint32_t numFrames = 200;
+    const float screenWidth = 1280.0f;
+    const float screenHeight = 720.0f;
+    const float worldWidth = screenWidth * 8.0f;
+    const float worldHeight = screenHeight * 8.0f;
+
+    std::mt19937 random(2024);
+    std::uniform_real_distribution<float> positionX(0.0f, worldWidth);
+    std::uniform_real_distribution<float> positionY(0.0f, worldHeight);
+    std::uniform_real_distribution<float> delta(-8.0f, 8.0f);
+
+    // シーンと同じセルの大きさ (Scene.cpp の RendererGridCellSize)
+    SpatialGrid grid(256.0f);
+    std::vector<SpatialGridEntry> entries(numSprites);
+    for (SpatialGridEntry& entry : entries)
+    {
+        entry.renderer = reinterpret_cast<Renderer*>(&entry);
+        entry.bounds = Bounds(Vector3(positionX(random), positionY(random), 0.0f), Vector3(64.0f, 64.0f, 0.0f));
+        entry.hasBounds = true;
+        entry.cellIndex = SpatialGrid::InvalidCellIndex;
+        entry.slot = 0;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto insertStart = Clock::now();
+    for (SpatialGridEntry& entry : entries)
+    {
+        grid.Update(&entry);
+    }
+    const double insertMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - insertStart).count();
+
+    double bruteForceMilliseconds = 0.0;
+    double gridMilliseconds = 0.0;
+    double updateMilliseconds = 0.0;
+    uint64_t totalVisible = 0;
+    std::vector<Renderer*> results;
+    results.reserve(numSprites);
+    for (uint32_t frame = 0; frame < numFrames; frame++)
+    {
+        // 1%のスプライトを動かして、登録を更新する
+        const auto updateStart = Clock::now();
+        for (uint32_t i = frame % 100; i < numSprites; i += 100)
+        {
+            SpatialGridEntry& entry = entries[i];
+            entry.bounds.center.x += delta(random);
+            entry.bounds.center.y += delta(random);
+            grid.Update(&entry);
+        }
+        updateMilliseconds += std::chrono::duration<double, std::milli>(Clock::now() - updateStart).count();
+
+        // カメラは世界を横切るように動く
+        const float cameraX = fmodf(frame * 37.0f, worldWidth - screenWidth) + screenWidth * 0.5f;
+        const float cameraY = fmodf(frame * 23.0f, worldHeight - screenHeight) + screenHeight * 0.5f;
+        const Bounds area(Vector3(cameraX, cameraY, 0.0f), Vector3(screenWidth, screenHeight, 0.0f));
+
+        // 総当たり
+        const auto bruteForceStart = Clock::now();
+        uint32_t bruteForceCount = 0;
+        for (const SpatialGridEntry& entry : entries)
+        {
+            if ((fabsf(entry.bounds.center.x - area.center.x) <= entry.bounds.extents.x + area.extents.x) &&
+                (fabsf(entry.bounds.center.y - area.center.y) <= entry.bounds.extents.y + area.extents.y))
+            {
+                bruteForceCount++;
+            }
+        }
+        bruteForceMilliseconds += std::chrono::duration<double, std::milli>(Clock::now() - bruteForceStart).count();
+
+        // 空間グリッド
+        const auto gridStart = Clock::now();
+        results.clear();
+        grid.Query(area, results);
+        gridMilliseconds += std::chrono::duration<double, std::milli>(Clock::now() - gridStart).count();
+
+        TEST_CHECK(results.size() == bruteForceCount);
+        totalVisible += results.size();
+    }
+
+    printf("[情報] スプライト %u 個 / カメラに映る数 平均 %.0f 個 / %u フレーム\n", numSprites, (double)totalVisible / numFrames, numFrames);
+    printf("[情報] 初回の登録           : %.3f ms\n", insertMilliseconds);
+    printf("[情報] 総当たり (1フレーム)   : %.3f ms\n", bruteForceMilliseconds / numFrames);
+    printf("[情報] 空間グリッド (1フレーム): %.3f ms\n", gridMilliseconds / numFrames);
+    printf("[情報] 1%%の移動の反映 (1フレーム): %.3f ms\n", updateMilliseconds / numFrames);
+    return TestResult("SpatialGridBenchmark");
+}
@@ -0,0 +1,177 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// 空間グリッドのテスト
+//
+//      ・乱数で配置したボックスを、全て調べた場合(総当たり)と同じ結果が検索で得られることを確かめる。
+//      ・登録、移動、削除を繰り返しても、リスト内の格納位置と登録数の整合性が保たれることを確かめる。
+//      ・レンダラーの中身には触れないので、項目の renderer には項目自身のアドレスを入れておき、検索結果から項目に戻す。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "SpatialGrid.h"
+#include "Test.h"
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+
+// 項目を初期化する
+static void InitEntry(SpatialGridEntry& entry, const Vector3& center, const Vector3& size)
+{
+    entry.renderer = reinterpret_cast<Renderer*>(&entry);
+    entry.bounds = Bounds(center, size);
+    entry.hasBounds = true;
+    entry.cellIndex = SpatialGrid::InvalidCellIndex;
+    entry.slot = 0;
+}
+
+
+// 総当たりで、XY平面上で指定した範囲と重なる項目を集める
+static std::vector<Renderer*> BruteForceQuery(const std::vector<SpatialGridEntry>& entries, const Bounds& area)
+{
+    std::vector<Renderer*> results;
+    for (const SpatialGridEntry& entry : entries)
+    {
+        if (entry.hasBounds && (entry.cellIndex != SpatialGrid::InvalidCellIndex) &&
+            (fabsf(entry.bounds.center.x - area.center.x) <= entry.bounds.extents.x + area.extents.x) &&
+            (fabsf(entry.bounds.center.y - area.center.y) <= entry.bounds.extents.y + area.extents.y))
+        {
+            results.push_back(entry.renderer);
+        }
+    }
+    std::sort(results.begin(), results.end());
+    return results;
+}
+
+
+// 空間グリッドで検索して、並べ替えた結果を返す
+static std::vector<Renderer*> GridQuery(const SpatialGrid& grid, const Bounds& area)
+{
+    std::vector<Renderer*> results;
+    grid.Query(area, results);
+    std::sort(results.begin(), results.end());
+    return results;
+}
+
+
+// 検索結果が総当たりと一致すること (セルを跨ぐもの、セルに収まらない大きなもの、負の座標を含む)
+static void TestQueryMatchesBruteForce()
+{
+    std::mt19937 random(12345);
+    std::uniform_real_distribution<float> position(-2000.0f, 2000.0f);
+    std::uniform_real_distribution<float> smallSize(1.0f, 200.0f);
+    std::uniform_real_distribution<float> largeSize(300.0f, 1500.0f);
+
+    SpatialGrid grid(256.0f);
+    std::vector<SpatialGridEntry> entries(2000);
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const float width = (i % 20 == 0) ? largeSize(random) : smallSize(random);
+        const float height = (i % 20 == 0) ? largeSize(random) : smallSize(random);
+        InitEntry(entries[i], Vector3(position(random), position(random), 0.0f), Vector3(width, height, 0.0f));
+        grid.Update(&entries[i]);
+    }
+    TEST_CHECK(grid.GetCount() == entries.size());
+
+    for (int i = 0; i < 200; i++)
+    {
+        const Bounds area(Vector3(position(random), position(random), 0.0f), Vector3(smallSize(random) * 8.0f, smallSize(random) * 5.0f, 0.0f));
+        TEST_CHECK(GridQuery(grid, area) == BruteForceQuery(entries, area));
+    }
+
+    // 全体を覆う範囲 (使用中のセルを全て調べる経路)
+    const Bounds everything(Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0e6f, 1.0e6f, 0.0f));
+    TEST_CHECK(GridQuery(grid, everything).size() == entries.size());
+}
+
+
+// 移動と削除を繰り返しても、検索結果と登録数が正しいこと
+static void TestUpdateAndRemove()
+{
+    std::mt19937 random(777);
+    std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> delta(-40.0f, 40.0f);
+
+    SpatialGrid grid(128.0f);
+    std::vector<SpatialGridEntry> entries(500);
+    for (SpatialGridEntry& entry : entries)
+    {
+        InitEntry(entry, Vector3(position(random), position(random), 0.0f), Vector3(32.0f, 32.0f, 0.0f));
+        grid.Update(&entry);
+    }
+
+    for (int frame = 0; frame < 50; frame++)
+    {
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            SpatialGridEntry& entry = entries[i];
+            if ((i + frame) % 7 == 0)
+            {
+                // 削除と再登録
+                grid.Remove(&entry);
+                TEST_CHECK(entry.cellIndex == SpatialGrid::InvalidCellIndex);
+                if (frame % 2 == 0)
+                {
+                    grid.Update(&entry);
+                }
+            }
+            else if (entry.cellIndex != SpatialGrid::InvalidCellIndex)
+            {
+                // 少しずつ移動する (殆どは同じセルに留まる)
+                entry.bounds.center.x += delta(random);
+                entry.bounds.center.y += delta(random);
+                grid.Update(&entry);
+            }
+        }
+
+        uint32_t registered = 0;
+        for (const SpatialGridEntry& entry : entries)
+        {
+            registered += (entry.cellIndex != SpatialGrid::InvalidCellIndex) ? 1 : 0;
+        }
+        TEST_CHECK(grid.GetCount() == registered);
+
+        const Bounds area(Vector3(position(random), position(random), 0.0f), Vector3(600.0f, 400.0f, 0.0f));
+        TEST_CHECK(GridQuery(grid, area) == BruteForceQuery(entries, area));
+    }
+
+    // 二重に削除しても何もしない
+    grid.Remove(&entries[0]);
+    grid.Remove(&entries[0]);
+    for (SpatialGridEntry& entry : entries)
+    {
+        grid.Remove(&entry);
+    }
+    TEST_CHECK(grid.GetCount() == 0);
+}
+
+
+// バウンディングボックスを持たない項目は検索結果に含まれず、別のリストで取得できること
+static void TestUnboundedEntries()
+{
+    SpatialGrid grid(64.0f);
+    SpatialGridEntry bounded, unbounded;
+    InitEntry(bounded, Vector3(0.0f, 0.0f, 0.0f), Vector3(10.0f, 10.0f, 0.0f));
+    InitEntry(unbounded, Vector3(0.0f, 0.0f, 0.0f), Vector3(10.0f, 10.0f, 0.0f));
+    unbounded.hasBounds = false;
+    grid.Update(&bounded);
+    grid.Update(&unbounded);
+
+    const std::vector<Renderer*> results = GridQuery(grid, Bounds(Vector3(0.0f, 0.0f, 0.0f), Vector3(100.0f, 100.0f, 0.0f)));
+    TEST_CHECK((results.size() == 1) && (results[0] == bounded.renderer));
+    TEST_CHECK((grid.GetUnboundedEntries().size() == 1) && (grid.GetUnboundedEntries()[0] == &unbounded));
+
+    // バウンディングボックスを持つようになったら、セルに移る
+    unbounded.hasBounds = true;
+    grid.Update(&unbounded);
+    TEST_CHECK(grid.GetUnboundedEntries().empty());
+    TEST_CHECK(GridQuery(grid, Bounds(Vector3(0.0f, 0.0f, 0.0f), Vector3(100.0f, 100.0f, 0.0f))).size() == 2);
+}
+
+
+int main()
+{
+    TestQueryMatchesBruteForce();
+    TestUpdateAndRemove();
+    TestUnboundedEntries();
+    return TestResult("SpatialGridTest");
+}
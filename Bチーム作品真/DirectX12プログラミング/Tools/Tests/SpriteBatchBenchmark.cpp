@@ -0,0 +1,288 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// スプライトバッチのベンチマーク
+//
+//      ・SpriteRendererBatch::Render() と同じ手順(カメラのステート設定 → 並べ替え → 頂点の書き込み → ドローコールの記録)で、
+//        ヌルRHIのコマンドコンテキストに1フレームを記録し、ドローコール数とCPU側のフレームの時間を計る。
+//      ・ビューポートとシザー矩形はカメラと同じ計算(CameraViewport)で求める。
+//      ・5万枚のスプライトを SpriteRendererBatch::RecordInParallel() と同じ手順で複数のコマンドリストに記録し、
+//        スレッド数毎のフレームの時間を比べる。 (論理コア数より多いスレッドは並列にならないので、コア数も出力する)
+//      ・GPUもウィンドウも使わないので、CIでもそのまま実行できる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "SpriteBatchBuilder.h"
+#include "SpriteBatchScene.h"
+#include "CameraViewport.h"
+#include "NullRhi.h"
+#include "JobSystem.h"
+#include "Test.h"
+#include <random>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+
+// 見せかけのカメラの定数バッファのアドレス
+static const uint64_t CameraConstantBuffer = 0x40000;
+
+// 1フレームの記録に使う作業用の配列 (フレームを跨いで使い回す)
+struct FrameResources
+{
+    RenderQueue renderQueue;
+    std::vector<SpriteBatchVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<SpriteBatchDrawCommand> drawCommands;
+    std::vector<SpriteBatchRecordingJob> recordingJobs;
+};
+
+
+// カメラ毎に、スプライトバッチの描画を1フレーム分記録する
+static void RecordFrame(NullRhiCommandContext& context, const std::vector<SpriteBatchItem>& items, const std::vector<Rect>& cameraRects, FrameResources& resources)
+{
+    context.BeginFrame();
+
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    for (const SpriteBatchItem& item : items)
+    {
+        vertexCount += item.vertexCount;
+        indexCount += item.indexCount;
+    }
+    resources.vertices.resize((size_t)vertexCount * cameraRects.size());
+    resources.indices.resize((size_t)indexCount * cameraRects.size());
+    const RhiVertexBufferView vertexBufferView = { 0x10000, (uint32_t)(resources.vertices.size() * sizeof(SpriteBatchVertex)), sizeof(SpriteBatchVertex) };
+    const RhiIndexBufferView indexBufferView = { 0x20000, (uint32_t)(resources.indices.size() * sizeof(uint32_t)), true };
+
+    uint32_t vertexLocation = 0;
+    uint32_t indexLocation = 0;
+    for (const Rect& cameraRect : cameraRects)
+    {
+        RhiCommandList* commandList = context.GetCommandList();
+        const RhiViewport viewport = CameraViewport::ComputeViewport(context.GetRenderTargetWidth(), context.GetRenderTargetHeight(), cameraRect);
+        const RhiRect scissorRect = CameraViewport::ComputeScissorRect(context.GetRenderTargetWidth(), context.GetRenderTargetHeight(), cameraRect);
+        SpriteBatchBuilder::SetupCommandList(commandList, &context, viewport, scissorRect, CameraConstantBuffer);
+
+        SpriteBatchBuilder::SortItems(items, ViewDepthColumn, NearClipPlane, FarClipPlane, resources.renderQueue);
+        resources.drawCommands.clear();
+        SpriteBatchBuilder::BuildDrawCommands(items, resources.renderQueue.GetPackets().data(), resources.renderQueue.GetCount(), PipelineStates,
+            resources.vertices.data(), resources.indices.data(), vertexLocation, indexLocation, resources.drawCommands);
+        commandList->NotifyUpload((uint64_t)vertexCount * sizeof(SpriteBatchVertex) + (uint64_t)indexCount * sizeof(uint32_t));
+        SpriteBatchBuilder::SubmitDrawCommands(commandList, resources.drawCommands, vertexBufferView, indexBufferView, { 0x30000 });
+    }
+}
+
+
+// 全画面のカメラ1つで、スプライトバッチの描画を1フレーム分記録する
+// (スプライトが十分に多ければ、区間に分けてジョブシステムのスレッドで並列に記録する)
+static void RecordFrameInParallel(NullRhiCommandContext& context, const std::vector<SpriteBatchItem>& items, FrameResources& resources)
+{
+    context.BeginFrame();
+
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    for (const SpriteBatchItem& item : items)
+    {
+        vertexCount += item.vertexCount;
+        indexCount += item.indexCount;
+    }
+    resources.vertices.resize(vertexCount);
+    resources.indices.resize(indexCount);
+    const RhiVertexBufferView vertexBufferView = { 0x10000, (uint32_t)(resources.vertices.size() * sizeof(SpriteBatchVertex)), sizeof(SpriteBatchVertex) };
+    const RhiIndexBufferView indexBufferView = { 0x20000, (uint32_t)(resources.indices.size() * sizeof(uint32_t)), true };
+    const Rect cameraRect(0.0f, 0.0f, 1.0f, 1.0f);
+    const RhiViewport viewport = CameraViewport::ComputeViewport(context.GetRenderTargetWidth(), context.GetRenderTargetHeight(), cameraRect);
+    const RhiRect scissorRect = CameraViewport::ComputeScissorRect(context.GetRenderTargetWidth(), context.GetRenderTargetHeight(), cameraRect);
+
+    SpriteBatchBuilder::SortItems(items, ViewDepthColumn, NearClipPlane, FarClipPlane, resources.renderQueue);
+    const RenderQueue::Packet* packets = resources.renderQueue.GetPackets().data();
+    const uint32_t count = resources.renderQueue.GetCount();
+    const uint32_t numJobs = SpriteBatchBuilder::ComputeNumRecordingJobs(count, JobSystem::Instance().GetNumThreads());
+    if (numJobs < 2)
+    {
+        RhiCommandList* commandList = context.GetCommandList();
+        uint32_t vertexLocation = 0;
+        uint32_t indexLocation = 0;
+        resources.drawCommands.clear();
+        SpriteBatchBuilder::BuildDrawCommands(items, packets, count, PipelineStates, resources.vertices.data(), resources.indices.data(), vertexLocation, indexLocation, resources.drawCommands);
+        commandList->NotifyUpload((uint64_t)vertexCount * sizeof(SpriteBatchVertex) + (uint64_t)indexCount * sizeof(uint32_t));
+        SpriteBatchBuilder::SetupCommandList(commandList, &context, viewport, scissorRect, CameraConstantBuffer);
+        SpriteBatchBuilder::SubmitDrawCommands(commandList, resources.drawCommands, vertexBufferView, indexBufferView, { 0x30000 });
+        return;
+    }
+
+    std::vector<SpriteBatchRecordingJob>& jobs = resources.recordingJobs;
+    SpriteBatchBuilder::SplitRecordingJobs(items, packets, count, numJobs, 0, 0, jobs);
+    for (SpriteBatchRecordingJob& job : jobs)
+    {
+        job.commandList = context.AcquireCommandList();
+    }
+    JobSystem::Instance().ParallelFor(numJobs, 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t jobIndex = begin; jobIndex < end; jobIndex++)
+        {
+            SpriteBatchRecordingJob& job = jobs[jobIndex];
+            uint32_t vertexLocation = job.vertexLocation;
+            uint32_t indexLocation = job.indexLocation;
+            SpriteBatchBuilder::BuildDrawCommands(items, packets + job.firstPacket, job.packetCount, PipelineStates,
+                resources.vertices.data(), resources.indices.data(), vertexLocation, indexLocation, job.drawCommands);
+            job.commandList->NotifyUpload((uint64_t)(vertexLocation - job.vertexLocation) * sizeof(SpriteBatchVertex) + (uint64_t)(indexLocation - job.indexLocation) * sizeof(uint32_t));
+            SpriteBatchBuilder::SetupCommandList(job.commandList, &context, viewport, scissorRect, CameraConstantBuffer);
+            SpriteBatchBuilder::SubmitDrawCommands(job.commandList, job.drawCommands, vertexBufferView, indexBufferView, { 0x30000 });
+        }
+    });
+    context.ContinueCommandList();
+}
+
+
+// 1フレームあたりの平均時間 (ミリ秒) を計る
+static double MeasureFrames(uint32_t numFrames, NullRhiCommandContext& context, const std::vector<SpriteBatchItem>& items, const std::vector<Rect>& cameraRects, FrameResources& resources)
+{
+    // 配列の容量を確保する為に、計測前に1回記録しておく
+    RecordFrame(context, items, cameraRects, resources);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < numFrames; i++)
+    {
+        RecordFrame(context, items, cameraRects, resources);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / numFrames;
+}
+
+
+// レイヤー、パイプラインステート、テクスチャ、深度がばらばらのスプライトを count 個作る
+static std::vector<SpriteBatchItem> MakeRandomScene(uint32_t count, std::mt19937& random)
+{
+    std::uniform_int_distribution<int> layer(0, 3);
+    std::uniform_int_distribution<int> pipeline(0, 2);
+    std::uniform_int_distribution<uint32_t> texture(0, 63);
+    std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+    std::uniform_real_distribution<float> depth(1.0f, 99.0f);
+
+    std::vector<SpriteBatchItem> items(count);
+    for (SpriteBatchItem& item : items)
+    {
+        item = MakeQuad(position(random), position(random), depth(random), layer(random), 0, (PipelineIndex)pipeline(random), texture(random));
+    }
+    return items;
+}
+
+
+// カメラのビューポートとシザー矩形
+static void TestCameraViewport()
+{
+    // 画面全体
+    const RhiViewport full = CameraViewport::ComputeViewport(1280, 720, Rect(0.0f, 0.0f, 1.0f, 1.0f));
+    TEST_CHECK(full.x == 0.0f && full.y == 0.0f && full.width == 1280.0f && full.height == 720.0f);
+    TEST_CHECK(full.minDepth == 0.0f && full.maxDepth == 1.0f);
+
+    // 画面分割の右半分 (シザー矩形の右下隅は、左上隅に幅と高さを足した位置)
+    const RhiViewport right = CameraViewport::ComputeViewport(1280, 720, Rect(0.5f, 0.0f, 0.5f, 1.0f));
+    const RhiRect rightScissor = CameraViewport::ComputeScissorRect(1280, 720, Rect(0.5f, 0.0f, 0.5f, 1.0f));
+    TEST_CHECK(right.x == 640.0f && right.width == 640.0f && right.height == 720.0f);
+    TEST_CHECK(rightScissor.left == 640 && rightScissor.top == 0 && rightScissor.right == 1280 && rightScissor.bottom == 720);
+}
+
+
+// スレッド数を変えながら、5万枚のスプライトの1フレームの時間を計る
+static void TestWorkerScaling()
+{
+    const uint32_t numSprites = 50000;
+    const uint32_t numFrames = 20;
+
+    std::mt19937 random(2);
+    const std::vector<SpriteBatchItem> items = MakeRandomScene(numSprites, random);
+    NullRhiCommandContext context(1920, 1080);
+    context.SetDefaultGraphicsState(PipelineStates[TransparentPipeline], (RhiRootSignature*)(uintptr_t)0x5000, (RhiDescriptorHeap*)(uintptr_t)0x6000);
+    FrameResources resources;
+
+    printf("[情報] スプライト %u 枚 / %u フレーム / 論理コア数 %u\n", numSprites, numFrames, std::thread::hardware_concurrency());
+    printf("[情報] %8s %16s %10s %14s %12s\n", "スレッド", "1フレーム", "1スレッド比", "コマンドリスト", "ドローコール");
+
+    std::vector<SpriteBatchVertex> referenceVertices;
+    uint32_t referenceDrawCount = 0;
+    double singleThreadMilliseconds = 0.0;
+    for (uint32_t numThreads : { 1u, 2u, 4u, 8u })
+    {
+        JobSystem::CreateSingletonInstance(numThreads);
+
+        // 配列の容量を確保する為に、計測前に1回記録しておく
+        RecordFrameInParallel(context, items, resources);
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < numFrames; frame++)
+        {
+            RecordFrameInParallel(context, items, resources);
+        }
+        const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / numFrames;
+
+        JobSystem::DestroySingletonInstance();
+
+        // 区間毎の書き込み位置は描画順に決まるので、スレッド数に関係なく同じ頂点が書き込まれる
+        const NullRhiStats stats = context.GetStats();
+        if (numThreads == 1)
+        {
+            referenceVertices = resources.vertices;
+            referenceDrawCount = stats.drawCount;
+            singleThreadMilliseconds = milliseconds;
+        }
+        TEST_CHECK(memcmp(resources.vertices.data(), referenceVertices.data(), referenceVertices.size() * sizeof(SpriteBatchVertex)) == 0);
+        TEST_CHECK(stats.vertexCount == (uint64_t)numSprites * 6);
+
+        // 並列に記録する場合は、メインのコマンドリスト + 区間毎のコマンドリスト + 続きを記録するコマンドリスト
+        // (区間の境目でドローコールが分かれるだけなので、ドローコールは区間の数 - 1 までしか増えない)
+        TEST_CHECK(stats.commandListCount == ((numThreads == 1) ? 1u : numThreads + 2));
+        TEST_CHECK(stats.drawCount <= referenceDrawCount + numThreads - 1);
+
+        printf("[情報] %8u %13.3f ms %9.2fx %14u %12u\n", numThreads, milliseconds, singleThreadMilliseconds / milliseconds, stats.commandListCount, stats.drawCount);
+    }
+}
+
+
+int main()
+{
+    TestCameraViewport();
+
+    NullRhiCommandContext context(1280, 720);
+    context.SetDefaultGraphicsState(PipelineStates[TransparentPipeline], (RhiRootSignature*)(uintptr_t)0x5000, (RhiDescriptorHeap*)(uintptr_t)0x6000);
+    FrameResources resources;
+
+    // ぷよぷよの1フレーム (カメラ1つ)
+    const std::vector<SpriteBatchItem> puyoPuyo = MakePuyoPuyoFrame();
+    const std::vector<Rect> fullScreen = { Rect(0.0f, 0.0f, 1.0f, 1.0f) };
+    const double puyoPuyoMilliseconds = MeasureFrames(1000, context, puyoPuyo, fullScreen, resources);
+    NullRhiStats stats = context.GetStats();
+    NullRhiCommandContext::PrintStats(stats);
+    printf("[情報] ぷよぷよ : スプライト %u 枚 → ドローコール %u 回 / 1フレーム %.4f ms\n", (uint32_t)puyoPuyo.size(), stats.drawCount, puyoPuyoMilliseconds);
+
+    // 半透明と乗算済みの2回だけで、1枚1回にはならない
+    TEST_CHECK(stats.commandListCount == 1);
+    TEST_CHECK(stats.drawCount == 2);
+    TEST_CHECK(stats.vertexCount == (uint64_t)PuyoPuyoSpriteCount * 6);
+    TEST_CHECK(stats.pipelineStateChangeCount == 2);
+    TEST_CHECK(stats.uploadBytes == (uint64_t)PuyoPuyoSpriteCount * (4 * sizeof(SpriteBatchVertex) + 6 * sizeof(uint32_t)));
+
+    // 数百枚なら、CIの遅いマシンでも1フレームの記録は1ミリ秒に収まる (桁違いに遅くなっていないことだけを確かめる)
+    TEST_CHECK(puyoPuyoMilliseconds < 1.0);
+
+    // 同じスプライトを画面分割の2つのカメラで描画する (ドローコールはカメラ毎)
+    const std::vector<Rect> splitScreen = { Rect(0.0f, 0.0f, 0.5f, 1.0f), Rect(0.5f, 0.0f, 0.5f, 1.0f) };
+    const double splitScreenMilliseconds = MeasureFrames(1000, context, puyoPuyo, splitScreen, resources);
+    stats = context.GetStats();
+    printf("[情報] ぷよぷよ(画面分割) : ドローコール %u 回 / 1フレーム %.4f ms\n", stats.drawCount, splitScreenMilliseconds);
+    TEST_CHECK(stats.drawCount == 4);
+    TEST_CHECK(stats.vertexCount == (uint64_t)PuyoPuyoSpriteCount * 6 * 2);
+
+    // ステートがばらばらの大量のスプライト
+    // (不透明はステート順に並ぶのでまとまるが、半透明は深度順なので、パイプラインが切り替わる所でドローコールが分かれる)
+    std::mt19937 random(1);
+    const std::vector<SpriteBatchItem> randomScene = MakeRandomScene(20000, random);
+    const double randomSceneMilliseconds = MeasureFrames(50, context, randomScene, fullScreen, resources);
+    stats = context.GetStats();
+    NullRhiCommandContext::PrintStats(stats);
+    printf("[情報] ばらばら : スプライト %u 枚 → ドローコール %u 回 / 1フレーム %.3f ms\n", (uint32_t)randomScene.size(), stats.drawCount, randomSceneMilliseconds);
+    TEST_CHECK(stats.drawCount < randomScene.size());
+    TEST_CHECK(stats.vertexCount == (uint64_t)randomScene.size() * 6);
+
+    TestWorkerScaling();
+
+    return TestResult("SpriteBatchBenchmark");
+}
@@ -0,0 +1,185 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// スプライトバッチビルダーのテスト
+//
+//      ・ぷよぷよの1フレーム相当のスプライトが、1枚1回ではなく数回のドローコールにまとまることを確かめる。
+//      ・並び順(ソーティングレイヤー → 不透明はステートと手前から奥 → 半透明は奥から手前、深度が等しければ積んだ順番)を確かめる。
+//      ・同じパイプラインステートのスプライトは、テクスチャが違っても1回のドローコールにまとまることを確かめる。
+//      ・頂点がワールド空間に変換され、インデックスが頂点バッファの先頭からの位置になることを確かめる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "SpriteBatchBuilder.h"
+#include "SpriteBatchScene.h"
+#include "NullRhi.h"
+#include "Test.h"
+#include <vector>
+
+
+// 並べ替えてからドローコールを組み立てる
+static void Build(const std::vector<SpriteBatchItem>& items, RenderQueue& renderQueue, std::vector<SpriteBatchVertex>& vertices, std::vector<uint32_t>& indices, std::vector<SpriteBatchDrawCommand>& drawCommands)
+{
+    SpriteBatchBuilder::SortItems(items, ViewDepthColumn, NearClipPlane, FarClipPlane, renderQueue);
+
+    vertices.resize(items.size() * 4);
+    indices.resize(items.size() * 6);
+    drawCommands.clear();
+    uint32_t vertexLocation = 0;
+    uint32_t indexLocation = 0;
+    SpriteBatchBuilder::BuildDrawCommands(items, renderQueue.GetPackets().data(), renderQueue.GetCount(), PipelineStates, vertices.data(), indices.data(), vertexLocation, indexLocation, drawCommands);
+    TEST_CHECK(vertexLocation == items.size() * 4);
+    TEST_CHECK(indexLocation == items.size() * 6);
+}
+
+
+// ぷよぷよの1フレーム相当 (2人分の盤面)
+static void TestPuyoPuyoFrame()
+{
+    const std::vector<SpriteBatchItem> items = MakePuyoPuyoFrame();
+
+    RenderQueue renderQueue;
+    std::vector<SpriteBatchVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<SpriteBatchDrawCommand> drawCommands;
+    Build(items, renderQueue, vertices, indices, drawCommands);
+
+    // 1枚1回なら 248 回のドローコールが、パイプラインステートの数まで減る
+    TEST_CHECK(items.size() == 248);
+    TEST_CHECK(drawCommands.size() == 2);
+    if (drawCommands.size() == 2)
+    {
+        TEST_CHECK(drawCommands[0].pipelineState == PipelineStates[TransparentPipeline]);
+        TEST_CHECK(drawCommands[0].spriteCount == 244);
+        TEST_CHECK(drawCommands[0].startIndexLocation == 0);
+        TEST_CHECK(drawCommands[0].indexCount == 244 * 6);
+        TEST_CHECK(drawCommands[1].pipelineState == PipelineStates[PremultipliedPipeline]);
+        TEST_CHECK(drawCommands[1].spriteCount == 4);
+        TEST_CHECK(drawCommands[1].startIndexLocation == 244 * 6);
+    }
+
+    // 同じレイヤーと順序の半透明は、積んだ順番(階層順)のまま並ぶ
+    const std::vector<RenderQueue::Packet>& packets = renderQueue.GetPackets();
+    TEST_CHECK(packets[0].payload == 4);
+    TEST_CHECK(packets[1].payload == 5);
+    for (uint32_t i = 1; i < (uint32_t)packets.size(); i++)
+    {
+        const SpriteBatchItem& previous = items[packets[i - 1].payload];
+        const SpriteBatchItem& current = items[packets[i].payload];
+        const bool isSameOrder = (previous.sortingLayer == current.sortingLayer) && (previous.sortingOrder == current.sortingOrder);
+        TEST_CHECK((previous.sortingLayer < current.sortingLayer) || (previous.sortingLayer == current.sortingLayer && previous.sortingOrder <= current.sortingOrder));
+        TEST_CHECK(!isSameOrder || (packets[i - 1].payload < packets[i].payload));
+    }
+
+    // ヌルRHIに記録すると、ドローコール2回とパイプラインステートの切り替え2回になる
+    NullRhiCommandList commandList;
+    const RhiVertexBufferView vertexBufferView = { 0x10000, (uint32_t)(vertices.size() * sizeof(SpriteBatchVertex)), sizeof(SpriteBatchVertex) };
+    const RhiIndexBufferView indexBufferView = { 0x20000, (uint32_t)(indices.size() * sizeof(uint32_t)), true };
+    SpriteBatchBuilder::SubmitDrawCommands(&commandList, drawCommands, vertexBufferView, indexBufferView, { 0x30000 });
+    const NullRhiStats& stats = commandList.GetStats();
+    TEST_CHECK(stats.drawCount == 2);
+    TEST_CHECK(stats.vertexCount == 248 * 6);
+    TEST_CHECK(stats.pipelineStateChangeCount == 2);
+    TEST_CHECK(stats.redundantStateChangeCount == 0);
+    printf("[情報] スプライト %u 枚 → ドローコール %u 回\n", (uint32_t)items.size(), stats.drawCount);
+}
+
+
+// 並び順
+static void TestSortOrder()
+{
+    std::vector<SpriteBatchItem> items;
+    items.push_back(MakeQuad(0.0f, 0.0f, 10.0f, 0, 0, OpaquePipeline, 5));          // 0: 不透明、テクスチャ5
+    items.push_back(MakeQuad(0.0f, 0.0f, 50.0f, 0, 0, OpaquePipeline, 3));          // 1: 不透明、テクスチャ3、奥
+    items.push_back(MakeQuad(0.0f, 0.0f, 20.0f, 0, 0, OpaquePipeline, 3));          // 2: 不透明、テクスチャ3、手前
+    items.push_back(MakeQuad(0.0f, 0.0f, 10.0f, 0, 0, TransparentPipeline, 1));     // 3: 半透明、手前
+    items.push_back(MakeQuad(0.0f, 0.0f, 50.0f, 0, 0, TransparentPipeline, 9));     // 4: 半透明、奥
+    items.push_back(MakeQuad(0.0f, 0.0f, 50.0f, 0, 0, PremultipliedPipeline, 2));   // 5: 半透明、奥 (4 の後に積んだ)
+    items.push_back(MakeQuad(0.0f, 0.0f, 90.0f, -1, 0, TransparentPipeline, 7));    // 6: 後ろのレイヤー
+
+    RenderQueue renderQueue;
+    std::vector<SpriteBatchVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<SpriteBatchDrawCommand> drawCommands;
+    Build(items, renderQueue, vertices, indices, drawCommands);
+
+    // 後ろのレイヤー → 不透明(テクスチャ順、同じテクスチャは手前から奥) → 半透明(奥から手前、同じ深度は積んだ順番)
+    static const uint32_t expected[] = { 6, 2, 1, 0, 4, 5, 3 };
+    const std::vector<RenderQueue::Packet>& packets = renderQueue.GetPackets();
+    TEST_CHECK(packets.size() == sizeof(expected) / sizeof(expected[0]));
+    for (uint32_t i = 0; i < (uint32_t)packets.size() && i < sizeof(expected) / sizeof(expected[0]); i++)
+    {
+        TEST_CHECK(packets[i].payload == expected[i]);
+    }
+
+    // 半透明 → 不透明 → 半透明 → 乗算済み → 半透明 の5回 (並びが飛んだ所では同じパイプラインでもまとめない)
+    TEST_CHECK(drawCommands.size() == 5);
+    if (drawCommands.size() == 5)
+    {
+        TEST_CHECK(drawCommands[0].pipelineState == PipelineStates[TransparentPipeline] && drawCommands[0].spriteCount == 1);
+        TEST_CHECK(drawCommands[1].pipelineState == PipelineStates[OpaquePipeline] && drawCommands[1].spriteCount == 3);
+        TEST_CHECK(drawCommands[2].pipelineState == PipelineStates[TransparentPipeline] && drawCommands[2].spriteCount == 1);
+        TEST_CHECK(drawCommands[3].pipelineState == PipelineStates[PremultipliedPipeline] && drawCommands[3].spriteCount == 1);
+        TEST_CHECK(drawCommands[4].pipelineState == PipelineStates[TransparentPipeline] && drawCommands[4].spriteCount == 1);
+    }
+}
+
+
+// 頂点の変換とインデックスの位置、区間を分けた場合のまとめ方
+static void TestVerticesAndMerge()
+{
+    std::vector<SpriteBatchItem> items;
+    items.push_back(MakeQuad(10.0f, 20.0f, 3.0f, 0, 0, TransparentPipeline, 11));
+    items.push_back(MakeQuad(0.0f, 0.0f, 3.0f, 0, 0, TransparentPipeline, 12));
+
+    // 1枚目は2倍に拡大する
+    items[0].localToWorld[0][0] = 2.0f;
+    items[0].localToWorld[1][1] = 2.0f;
+    items[0].color[3] = 0.5f;
+
+    RenderQueue renderQueue;
+    SpriteBatchBuilder::SortItems(items, ViewDepthColumn, NearClipPlane, FarClipPlane, renderQueue);
+    TEST_CHECK(renderQueue.GetPackets()[0].payload == 0);
+
+    // 頂点バッファの途中から書き込む
+    std::vector<SpriteBatchVertex> vertices(100);
+    std::vector<uint32_t> indices(100);
+    std::vector<SpriteBatchDrawCommand> drawCommands;
+    uint32_t vertexLocation = 40;
+    uint32_t indexLocation = 60;
+    SpriteBatchBuilder::BuildDrawCommands(items, renderQueue.GetPackets().data(), 2, PipelineStates, vertices.data(), indices.data(), vertexLocation, indexLocation, drawCommands);
+    TEST_CHECK(vertexLocation == 48);
+    TEST_CHECK(indexLocation == 72);
+
+    // (0.5, -0.5) × 2 + (10, 20, 3)
+    const SpriteBatchVertex& v = vertices[43];
+    TEST_CHECK(v.position[0] == 11.0f && v.position[1] == 19.0f && v.position[2] == 3.0f);
+    TEST_CHECK(v.color[3] == 0.5f);
+    TEST_CHECK(v.texcoord[0] == 1.0f && v.texcoord[1] == 1.0f);
+    TEST_CHECK(v.textureIndex == 11);
+    TEST_CHECK(vertices[44].position[0] == -0.5f && vertices[44].textureIndex == 12);
+
+    // インデックスは頂点バッファの先頭からの位置
+    TEST_CHECK(indices[60] == 40 && indices[65] == 43);
+    TEST_CHECK(indices[66] == 44 && indices[71] == 47);
+
+    // テクスチャが違っても1回にまとまる
+    TEST_CHECK(drawCommands.size() == 1);
+    TEST_CHECK(drawCommands[0].startIndexLocation == 60);
+    TEST_CHECK(drawCommands[0].indexCount == 12);
+    TEST_CHECK(drawCommands[0].spriteCount == 2);
+
+    // インデックスが続いていない(別の区間に書き込んだ)場合はまとめない
+    uint32_t nextVertexLocation = 80;
+    uint32_t nextIndexLocation = 80;
+    SpriteBatchBuilder::BuildDrawCommands(items, renderQueue.GetPackets().data() + 1, 1, PipelineStates, vertices.data(), indices.data(), nextVertexLocation, nextIndexLocation, drawCommands);
+    TEST_CHECK(drawCommands.size() == 2);
+    TEST_CHECK(drawCommands[1].startIndexLocation == 80);
+    TEST_CHECK(indices[80] == 80);
+}
+
+
+int main()
+{
+    TestPuyoPuyoFrame();
+    TestSortOrder();
+    TestVerticesAndMerge();
+    return TestResult("SpriteBatchBuilderTest");
+}
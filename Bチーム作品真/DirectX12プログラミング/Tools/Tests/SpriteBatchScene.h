@@ -0,0 +1,122 @@
+﻿#pragma once
+#include "SpriteBatchBuilder.h"
+#include <cstring>
+#include <vector>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// スプライトバッチのテストとベンチマークで使う、描画待ちのスプライトの組
+//
+//      ・四角形のスプライトと、ぷよぷよの1フレーム相当(2人分の盤面)のスプライトを作る。
+//      ・パイプラインステートなどのハンドルは中身を見ないので、区別できる適当な値を使う。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// パイプラインステートの番号 (SpriteRendererBatch と同じ並び)
+enum PipelineIndex
+{
+    OpaquePipeline,
+    TransparentPipeline,
+    PremultipliedPipeline,
+};
+
+// 区別できるだけの見せかけのハンドル
+static RhiPipelineState* const PipelineStates[] =
+{
+    (RhiPipelineState*)(uintptr_t)0x1000,
+    (RhiPipelineState*)(uintptr_t)0x2000,
+    (RhiPipelineState*)(uintptr_t)0x3000,
+};
+
+// 四角形のスプライトの形状 (中心が原点の 1 × 1)
+static const float QuadVertices[] = { -0.5f, 0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f };
+static const float QuadTexcoords[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+static const uint16_t QuadTriangles[] = { 0, 1, 2, 2, 1, 3 };
+
+// 単位行列のビューの3列目 (ワールド空間の z がそのまま深度になる)
+static const float ViewDepthColumn[4] = { 0.0f, 0.0f, 1.0f, 0.0f };
+static const float NearClipPlane = 0.0f;
+static const float FarClipPlane = 100.0f;
+
+// ぷよぷよの1フレーム相当のスプライトの数
+static const uint32_t PuyoPuyoSpriteCount = 248;
+static const uint32_t PuyoPuyoEffectCount = 4;
+
+
+// 位置 (x, y, z) に置いた四角形のスプライトを作る
+inline SpriteBatchItem MakeQuad(float x, float y, float z, int sortingLayer, int sortingOrder, PipelineIndex pipelineIndex, uint32_t textureIndex)
+{
+    SpriteBatchItem item;
+    memset(&item, 0, sizeof(item));
+    item.localToWorld[0][0] = 1.0f;
+    item.localToWorld[1][1] = 1.0f;
+    item.localToWorld[2][2] = 1.0f;
+    item.localToWorld[3][0] = x;
+    item.localToWorld[3][1] = y;
+    item.localToWorld[3][2] = z;
+    item.localToWorld[3][3] = 1.0f;
+    item.boundsCenter[0] = x;
+    item.boundsCenter[1] = y;
+    item.boundsCenter[2] = z;
+    item.vertices = QuadVertices;
+    item.texcoords = QuadTexcoords;
+    item.triangles = QuadTriangles;
+    item.vertexCount = 4;
+    item.indexCount = 6;
+    for (float& c : item.color)
+    {
+        c = 1.0f;
+    }
+    item.sortingLayer = sortingLayer;
+    item.sortingOrder = sortingOrder;
+    item.isTransparent = (pipelineIndex != OpaquePipeline);
+    item.pipelineIndex = pipelineIndex;
+    item.textureIndex = textureIndex;
+    return item;
+}
+
+
+// ぷよぷよの1フレーム相当 (2人分の盤面)
+//   ・背景、盤面の背景と枠、積まれたぷよ、操作中と次のぷよは全て半透明のスプライトで、テクスチャだけが違う。
+//   ・連鎖のエフェクトは乗算済みアルファのテクスチャを使い、最前面のレイヤーに置く。 (先に Push() しても、レイヤーで最後に並ぶ)
+inline std::vector<SpriteBatchItem> MakePuyoPuyoFrame()
+{
+    std::vector<SpriteBatchItem> items;
+
+    // 連鎖のエフェクト
+    for (uint32_t i = 0; i < PuyoPuyoEffectCount; i++)
+    {
+        items.push_back(MakeQuad(i * 32.0f, 100.0f, 0.0f, 3, 0, PremultipliedPipeline, 40));
+    }
+
+    // 背景
+    items.push_back(MakeQuad(0.0f, 0.0f, 0.0f, 0, 0, TransparentPipeline, 1));
+    items.push_back(MakeQuad(0.0f, 0.0f, 0.0f, 0, 1, TransparentPipeline, 2));
+
+    for (int player = 0; player < 2; player++)
+    {
+        const float left = player * 400.0f;
+
+        // 盤面の背景と、9枚の枠
+        items.push_back(MakeQuad(left, 0.0f, 0.0f, 1, 0, TransparentPipeline, 3));
+        for (int i = 0; i < 9; i++)
+        {
+            items.push_back(MakeQuad(left + i * 16.0f, 0.0f, 0.0f, 1, 1, TransparentPipeline, 4 + i));
+        }
+
+        // 6 × 14 の盤面に積まれたぷよ (色毎に別のテクスチャ)
+        for (int y = 0; y < 14; y++)
+        {
+            for (int x = 0; x < 6; x++)
+            {
+                items.push_back(MakeQuad(left + x * 32.0f, y * 32.0f, 0.0f, 2, 0, TransparentPipeline, 20 + (x + y) % 5));
+            }
+        }
+
+        // 操作中のぷよと、次と次の次のぷよ (3 × 3 が3つ)
+        for (int i = 0; i < 27; i++)
+        {
+            items.push_back(MakeQuad(left + (i % 3) * 32.0f, 500.0f + (i / 3) * 32.0f, 0.0f, 2, 1, TransparentPipeline, 20 + i % 5));
+        }
+    }
+    return items;
+}
@@ -0,0 +1,110 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// ステージングリングのテスト
+//
+//      ・アラインメントを守って先頭から順番に切り出し、空きが足りない場合は失敗することを確かめる。
+//      ・Submit() したフェンス値が完了するまで領域を返却せず、Retire() で古い順に返却することを確かめる。
+//      ・末尾に収まらない場合は、末尾の残りを捨てて先頭から切り出す(捨てた分も返却まで使用中になる)ことを確かめる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "StagingRing.h"
+#include "Test.h"
+
+
+// 順番に切り出し、空きが足りない場合は失敗すること
+static void TestAllocate()
+{
+    StagingRing ring(4096);
+    uint64_t a, b, c;
+    TEST_CHECK(ring.Allocate(100, 512, &a) && a == 0);
+    TEST_CHECK(ring.Allocate(100, 512, &b) && b == 512);
+    TEST_CHECK(ring.Allocate(10, 4, &c) && c == 612);
+    TEST_CHECK(ring.GetUsedBytes() == 622);
+
+    // 残りより大きい要求と、容量より大きい要求と、0バイトの要求は失敗する
+    uint64_t offset = 0;
+    TEST_CHECK(!ring.Allocate(4096 - 622 + 1, 1, &offset));
+    TEST_CHECK(!ring.Allocate(8192, 1, &offset));
+    TEST_CHECK(!ring.Allocate(0, 1, &offset));
+    TEST_CHECK(ring.GetUsedBytes() == 622);
+
+    // 末尾までぴったり使える
+    TEST_CHECK(ring.Allocate(4096 - 622, 1, &offset) && offset == 622);
+    TEST_CHECK(ring.GetUsedBytes() == 4096);
+    TEST_CHECK(!ring.Allocate(1, 1, &offset));
+}
+
+
+// フェンス値が完了するまで返却しないこと
+static void TestRetireByFence()
+{
+    StagingRing ring(4096);
+    uint64_t offset;
+    TEST_CHECK(ring.Allocate(2048, 512, &offset));
+    ring.Submit(1);
+    TEST_CHECK(ring.Allocate(1024, 512, &offset) && offset == 2048);
+    ring.Submit(2);
+    TEST_CHECK(ring.GetNumPendingSubmissions() == 2);
+
+    // 切り出していなければ Submit() しても何も積まない
+    ring.Submit(3);
+    TEST_CHECK(ring.GetNumPendingSubmissions() == 2);
+
+    // 完了していないフェンス値の領域は返却されない
+    ring.Retire(0);
+    TEST_CHECK(ring.GetUsedBytes() == 3072);
+
+    // 古い順に返却される
+    ring.Retire(1);
+    TEST_CHECK(ring.GetUsedBytes() == 1024);
+    TEST_CHECK(ring.GetNumPendingSubmissions() == 1);
+    ring.Retire(2);
+    TEST_CHECK(ring.GetUsedBytes() == 0);
+    TEST_CHECK(ring.GetNumPendingSubmissions() == 0);
+
+    // 全て返却された後は先頭から使い直す
+    TEST_CHECK(ring.Allocate(100, 512, &offset) && offset == 0);
+    TEST_CHECK(ring.GetPeakUsedBytes() == 3072);
+}
+
+
+// 末尾に収まらない場合は先頭に折り返すこと
+static void TestWrapAround()
+{
+    StagingRing ring(4096);
+    uint64_t offset;
+    TEST_CHECK(ring.Allocate(1536, 512, &offset) && offset == 0);
+    ring.Submit(1);
+    TEST_CHECK(ring.Allocate(1536, 512, &offset) && offset == 1536);
+    ring.Submit(2);
+    ring.Retire(1);
+    TEST_CHECK(ring.GetUsedBytes() == 1536);
+
+    // 末尾の残り(1024バイト)には収まらないので、先頭から切り出す
+    TEST_CHECK(ring.Allocate(1536, 512, &offset) && offset == 0);
+    TEST_CHECK(ring.GetUsedBytes() == 1536 + 1024 + 1536);
+    ring.Submit(3);
+
+    // 折り返した後は、使用中の領域の手前までしか使えない
+    TEST_CHECK(!ring.Allocate(1, 1, &offset));
+
+    // 捨てた末尾の分は、折り返した領域と一緒に返却される
+    ring.Retire(2);
+    TEST_CHECK(ring.GetUsedBytes() == 1024 + 1536);
+    TEST_CHECK(ring.Allocate(1536, 512, &offset) && offset == 1536);
+    ring.Submit(4);
+    TEST_CHECK(ring.GetUsedBytes() == 4096);
+    TEST_CHECK(ring.GetPeakUsedBytes() == 4096);
+
+    ring.Retire(4);
+    TEST_CHECK(ring.GetUsedBytes() == 0);
+    TEST_CHECK(ring.GetNumPendingSubmissions() == 0);
+}
+
+
+int main()
+{
+    TestAllocate();
+    TestRetireByFence();
+    TestWrapAround();
+    return TestResult("StagingRingTest");
+}
@@ -0,0 +1,40 @@
+﻿#pragma once
+#include <cstdio>
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// テスト用の簡易マクロ
+//
+//      ・TEST_CHECK() の条件が偽なら、ファイル名と行番号を [失敗] として出力し、失敗した数を数える。
+//      ・main() は最後に TestResult() の戻り値を返すこと。 (1つでも失敗していれば 1 になり、ctest が失敗として扱う)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// これまでに失敗したチェックの数を取得します。
+inline int& TestFailureCount()
+{
+    static int count = 0;
+    return count;
+}
+
+// 条件が偽なら失敗として記録します。 (テストは中断せずに続けます)
+#define TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            printf("[失敗] %s(%d): %s\n", __FILE__, __LINE__, #condition); \
+            TestFailureCount()++; \
+        } \
+    } while (0)
+
+// テストの結果を出力して、main() の戻り値を返します。
+inline int TestResult(const char* testName)
+{
+    if (TestFailureCount() > 0)
+    {
+        printf("[失敗] %s : %d 個のチェックが失敗しました\n", testName, TestFailureCount());
+        return 1;
+    }
+    printf("[成功] %s\n", testName);
+    return 0;
+}
@@ -0,0 +1,458 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// テクスチャアップロードキューのテスト
+//
+//      ・ヌルRHIのコピーキューと、CPUのメモリをステージングバッファの代わりに使う。
+//      ・要求が届いた順に、コピーのフェンス値が完了してから完了を通知することを確かめる。
+//      ・1回の Update() の転送量の上限と、ステージングリングの空きを待つことを確かめる。
+//      ・ステージングリングより大きいテクスチャが、行のまとまりに分けて複数回の Update() で書き込まれ、
+//        コピー先の行が重ならずに全ての行を覆い、ステージングバッファに正しいピクセルデータが書き込まれることを確かめる。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "TextureUploadQueue.h"
+#include "NullRhi.h"
+#include "Test.h"
+#include <cstring>
+#include <vector>
+#include <map>
+#include <memory>
+
+
+// 区別できるだけの見せかけのテクスチャ
+static RhiResource* const TextureA = (RhiResource*)(uintptr_t)0x1000;
+static RhiResource* const TextureB = (RhiResource*)(uintptr_t)0x2000;
+static RhiResource* const TextureC = (RhiResource*)(uintptr_t)0x3000;
+static RhiResource* const StagingBuffer = (RhiResource*)(uintptr_t)0x4000;
+
+static constexpr uint32_t FormatR8G8B8A8 = 28;     // DXGI_FORMAT_R8G8B8A8_UNORM
+static constexpr uint32_t FormatBC7 = 98;          // DXGI_FORMAT_BC7_UNORM
+
+
+// テクスチャの行の並び (ステージングバッファの中身を確かめる為に覚えておく)
+struct TextureLayout
+{
+    uint32_t pixelsPerRow;                  // 1行の高さ (ブロック圧縮を真似る場合は4)
+    std::vector<uint32_t> rowSizesInBytes;  // サブリソース毎の1行のバイト数
+};
+static std::map<RhiResource*, TextureLayout> s_textureLayouts;
+
+
+// テクスチャ・サブリソース・行・列から決まるピクセルデータの値
+static uint8_t PixelValue(RhiResource* texture, uint32_t subresource, uint32_t row, uint32_t column)
+{
+    return (uint8_t)(((uintptr_t)texture >> 12) * 13 + subresource * 31 + row * 7 + column);
+}
+
+
+// アップロードの要求を作成します。 (ピクセルデータは要求に持たせます)
+//   ・blockCompressed が true の場合は、4x4ピクセルを16バイトにするブロック圧縮フォーマットを真似ます。
+static TextureUploadRequest MakeRequest(RhiResource* texture, uint32_t width, uint32_t height, uint32_t numMips, bool blockCompressed, std::function<void(bool)> onCompleted)
+{
+    TextureLayout layout;
+    layout.pixelsPerRow = blockCompressed ? 4 : 1;
+
+    TextureUploadRequest request;
+    request.destination = texture;
+    request.totalBytes = 0;
+    uint64_t offset = 0;
+    uint64_t sourceBytes = 0;
+    for (uint32_t mip = 0; mip < numMips; mip++)
+    {
+        const uint32_t mipWidth = (width >> mip) > 0 ? (width >> mip) : 1;
+        const uint32_t mipHeight = (height >> mip) > 0 ? (height >> mip) : 1;
+        const uint32_t numRows = (mipHeight + layout.pixelsPerRow - 1) / layout.pixelsPerRow;
+        const uint32_t rowSize = blockCompressed ? (mipWidth + 3) / 4 * 16 : mipWidth * 4;
+
+        RhiPlacedFootprint footprint;
+        footprint.offset = (offset + 511) & ~511ull;
+        footprint.format = blockCompressed ? FormatBC7 : FormatR8G8B8A8;
+        footprint.width = mipWidth;
+        footprint.height = mipHeight;
+        footprint.depth = 1;
+        footprint.rowPitch = (rowSize + 255) & ~255u;
+        request.footprints.push_back(footprint);
+        request.numRows.push_back(numRows);
+        request.rowSizesInBytes.push_back(rowSize);
+        layout.rowSizesInBytes.push_back(rowSize);
+
+        // 最後の行は隙間を含まない (GetCopyableFootprints() と同じ)
+        request.totalBytes = footprint.offset + (uint64_t)footprint.rowPitch * (numRows - 1) + rowSize;
+        offset = request.totalBytes;
+        sourceBytes += (uint64_t)rowSize * numRows;
+    }
+
+    // ピクセルデータ (隙間無く詰める)
+    std::shared_ptr<std::vector<uint8_t>> pixels = std::make_shared<std::vector<uint8_t>>((size_t)sourceBytes);
+    uint8_t* data = pixels->data();
+    for (uint32_t mip = 0; mip < numMips; mip++)
+    {
+        const uint32_t rowSize = (uint32_t)request.rowSizesInBytes[mip];
+        request.subresources.push_back({ data, rowSize, (uint64_t)rowSize * request.numRows[mip] });
+        for (uint32_t y = 0; y < request.numRows[mip]; y++)
+        {
+            for (uint32_t x = 0; x < rowSize; x++)
+            {
+                *data++ = PixelValue(texture, mip, y, x);
+            }
+        }
+    }
+    request.sourceOwner = pixels;
+    request.onCompleted = std::move(onCompleted);
+
+    s_textureLayouts[texture] = layout;
+    return request;
+}
+
+
+// 記録されたテクスチャへのコピー1つ分
+struct RecordedCopy
+{
+    RhiResource* destination;
+    uint32_t subresource;
+    uint32_t destinationY;
+    uint64_t offset;
+    uint32_t height;
+    uint32_t rowPitch;
+    uint32_t submitIndex;                   // 何回目の Submit() で送られたか
+    bool isDataCorrect;                     // 送った時点のステージングバッファの中身が正しかったか
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// 記録するコピーキュー
+//
+//      ・Submit() の度に、コマンドストリームからテクスチャへのコピーを読み取り、ステージングバッファの中身を確かめて記録する。
+//      ・GPUタイムラインはすぐに完了する。
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+class RecordingCopyQueue : public RhiCopyQueue
+{
+private:
+    NullRhiCommandList m_commandList;
+    NullGpuTimeline m_timeline;
+    const uint8_t* m_stagingMemory;
+    uint32_t m_submitCount;
+
+public:
+    std::vector<RecordedCopy> copies;
+
+    explicit RecordingCopyQueue(const uint8_t* stagingMemory) : m_stagingMemory(stagingMemory), m_submitCount(0) { }
+
+    RhiCommandList* GetCommandList() override { return &m_commandList; }
+    GpuTimeline* GetTimeline() override { return &m_timeline; }
+
+    uint64_t Submit() override
+    {
+        const std::vector<uint32_t>& stream = m_commandList.GetStream();
+        for (size_t position = 0; position < stream.size(); position += 1 + (stream[position] >> 8))
+        {
+            if ((NullRhiOpcode)(stream[position] & 0xFF) != NullRhiOpcode::CopyBufferToTexture)
+            {
+                continue;
+            }
+            const uint32_t* words = &stream[position + 1];
+            RecordedCopy copy;
+            copy.destination = (RhiResource*)(uintptr_t)(words[0] | ((uint64_t)words[1] << 32));
+            copy.subresource = words[2];
+            copy.destinationY = words[3];
+            copy.offset = words[6] | ((uint64_t)words[7] << 32);
+            copy.height = words[10];
+            copy.rowPitch = words[12];
+            copy.submitIndex = m_submitCount;
+
+            // ステージングバッファの各行が、コピー先の行のピクセルデータと一致すること
+            const TextureLayout& layout = s_textureLayouts[copy.destination];
+            const uint32_t firstRow = copy.destinationY / layout.pixelsPerRow;
+            const uint32_t numRows = (copy.height + layout.pixelsPerRow - 1) / layout.pixelsPerRow;
+            copy.isDataCorrect = true;
+            for (uint32_t y = 0; y < numRows; y++)
+            {
+                const uint8_t* row = m_stagingMemory + copy.offset + (uint64_t)copy.rowPitch * y;
+                for (uint32_t x = 0; x < layout.rowSizesInBytes[copy.subresource]; x++)
+                {
+                    if (row[x] != PixelValue(copy.destination, copy.subresource, firstRow + y, x))
+                    {
+                        copy.isDataCorrect = false;
+                    }
+                }
+            }
+            copies.push_back(copy);
+        }
+        m_commandList.Reset();
+        m_submitCount++;
+        return m_timeline.Signal();
+    }
+};
+
+
+// 指定したテクスチャへのコピーが、サブリソース毎に上から順に全ての行を重ならずに覆っていることを確かめます。
+static void CheckCopiesCoverTexture(const std::vector<RecordedCopy>& copies, RhiResource* texture, uint32_t height, uint32_t numMips)
+{
+    for (uint32_t mip = 0; mip < numMips; mip++)
+    {
+        const uint32_t mipHeight = (height >> mip) > 0 ? (height >> mip) : 1;
+        uint32_t nextY = 0;
+        for (const RecordedCopy& copy : copies)
+        {
+            if (copy.destination != texture || copy.subresource != mip)
+            {
+                continue;
+            }
+            TEST_CHECK(copy.destinationY == nextY);
+            TEST_CHECK(copy.isDataCorrect);
+            TEST_CHECK(copy.offset % TextureUploadQueue::FootprintAlignment == 0);
+            nextY = copy.destinationY + copy.height;
+        }
+        TEST_CHECK(nextY == mipHeight);
+    }
+}
+
+
+// フェンス値が完了してから、届いた順に完了を通知すること
+static void TestCompletesAfterFence()
+{
+    std::vector<uint8_t> stagingMemory(1024 * 1024);
+    NullRhiCopyQueue copyQueue;
+    TextureUploadQueue uploadQueue(&copyQueue, StagingBuffer, stagingMemory.data(), stagingMemory.size());
+
+    std::vector<RhiResource*> completed;
+    uploadQueue.Enqueue(MakeRequest(TextureA, 64, 64, 3, false, [&](bool succeeded) { TEST_CHECK(succeeded); completed.push_back(TextureA); }));
+    uploadQueue.Enqueue(MakeRequest(TextureB, 32, 32, 1, false, [&](bool succeeded) { TEST_CHECK(succeeded); completed.push_back(TextureB); }));
+    TEST_CHECK(uploadQueue.HasPendingUploads());
+
+    // 1回目で両方を送る
+    uploadQueue.Update();
+    TEST_CHECK(uploadQueue.GetStats().submitCount == 1);
+    TEST_CHECK(copyQueue.GetStats().copyCount == 4);
+    TEST_CHECK(completed.empty());
+
+    // ヌルRHIのコピーキューは、調べた次の回に完了する
+    uploadQueue.Update();
+    TEST_CHECK(completed.empty());
+    uploadQueue.Update();
+    TEST_CHECK(completed.size() == 2);
+    TEST_CHECK(completed.size() == 2 && completed[0] == TextureA && completed[1] == TextureB);
+    TEST_CHECK(!uploadQueue.HasPendingUploads());
+
+    const TextureUploadQueueStats& stats = uploadQueue.GetStats();
+    TEST_CHECK(stats.completedCount == 2);
+    TEST_CHECK(stats.failedCount == 0);
+    TEST_CHECK(stats.submitCount == 1);
+    TEST_CHECK(stats.uploadedBytes == copyQueue.GetStats().uploadBytes);
+}
+
+
+// 1回の Update() で書き込むバイト数の上限を守ること
+static void TestMaxBytesPerUpdate()
+{
+    std::vector<uint8_t> stagingMemory(1024 * 1024);
+    RecordingCopyQueue copyQueue(stagingMemory.data());
+    TextureUploadQueue uploadQueue(&copyQueue, StagingBuffer, stagingMemory.data(), stagingMemory.size(), 40000);
+
+    // 64x64 の RGBA は 16KB なので、1回に2つまで
+    uint32_t completedCount = 0;
+    RhiResource* const textures[] = { TextureA, TextureB, TextureC };
+    for (RhiResource* texture : textures)
+    {
+        uploadQueue.Enqueue(MakeRequest(texture, 64, 64, 1, false, [&](bool succeeded) { completedCount += succeeded ? 1 : 0; }));
+    }
+    uploadQueue.Update();
+    TEST_CHECK(copyQueue.copies.size() == 2);
+    uploadQueue.Update();
+    TEST_CHECK(copyQueue.copies.size() == 3);
+    TEST_CHECK(completedCount == 2);
+    uploadQueue.Update();
+    TEST_CHECK(completedCount == 3);
+
+    for (const RecordedCopy& copy : copyQueue.copies)
+    {
+        TEST_CHECK(copy.isDataCorrect);
+    }
+
+    // 上限より大きい要求も、最初の1つなら書き込む
+    uploadQueue.Enqueue(MakeRequest(TextureA, 128, 128, 1, false, [&](bool succeeded) { completedCount += succeeded ? 1 : 0; }));
+    uploadQueue.Update();
+    TEST_CHECK(copyQueue.copies.size() == 4);
+    TEST_CHECK(copyQueue.copies.back().height == 128);
+    uploadQueue.WaitForAll();
+    TEST_CHECK(completedCount == 4);
+}
+
+
+// ステージングリングに空きが無ければ、届いた順番を崩さずに待つこと
+static void TestWaitsForStagingSpace()
+{
+    std::vector<uint8_t> stagingMemory(40000);
+    NullRhiCopyQueue copyQueue;
+    TextureUploadQueue uploadQueue(&copyQueue, StagingBuffer, stagingMemory.data(), stagingMemory.size());
+
+    std::vector<RhiResource*> completed;
+    RhiResource* const textures[] = { TextureA, TextureB, TextureC };
+    for (RhiResource* texture : textures)
+    {
+        uploadQueue.Enqueue(MakeRequest(texture, 64, 64, 1, false, [&completed, texture](bool succeeded) { TEST_CHECK(succeeded); completed.push_back(texture); }));
+    }
+
+    // 16KB が2つ入ると3つ目は入らない
+    uploadQueue.Update();
+    TEST_CHECK(copyQueue.GetStats().copyCount == 2);
+
+    // コピーが完了していないので、3つ目はまだ送れない
+    uploadQueue.Update();
+    TEST_CHECK(copyQueue.GetStats().copyCount == 2);
+    TEST_CHECK(uploadQueue.GetStats().submitCount == 1);
+    TEST_CHECK(completed.empty());
+
+    // 完了して領域が返却されると、3つ目を送る
+    uploadQueue.Update();
+    TEST_CHECK(completed.size() == 2);
+    TEST_CHECK(copyQueue.GetStats().copyCount == 3);
+    TEST_CHECK(uploadQueue.GetStats().submitCount == 2);
+    TEST_CHECK(uploadQueue.GetStats().peakStagingBytes <= stagingMemory.size());
+
+    uploadQueue.WaitForAll();
+    TEST_CHECK(completed.size() == 3 && completed[2] == TextureC);
+}
+
+
+// デコードに失敗した要求と、分けても書き込めない要求は失敗として完了すること
+static void TestFailedRequests()
+{
+    std::vector<uint8_t> stagingMemory(4096);
+    NullRhiCopyQueue copyQueue;
+    TextureUploadQueue uploadQueue(&copyQueue, StagingBuffer, stagingMemory.data(), stagingMemory.size());
+
+    std::vector<bool> results;
+    TextureUploadRequest decodeFailed;
+    decodeFailed.destination = TextureA;
+    decodeFailed.totalBytes = 0;
+    decodeFailed.onCompleted = [&](bool succeeded) { results.push_back(succeeded); };
+    uploadQueue.Enqueue(std::move(decodeFailed));
+
+    // 3Dテクスチャはスライスの途中で分けられない
+    TextureUploadRequest volume = MakeRequest(TextureB, 64, 64, 1, false, [&](bool succeeded) { results.push_back(succeeded); });
+    volume.footprints[0].depth = 2;
+    uploadQueue.Enqueue(std::move(volume));
+
+    // 1行がステージングバッファより大きい
+    uploadQueue.Enqueue(MakeRequest(TextureC, 2048, 2, 1, false, [&](bool succeeded) { results.push_back(succeeded); }));
+
+    // 後ろの要求は成功する
+    uploadQueue.Enqueue(MakeRequest(TextureA, 16, 16, 1, false, [&](bool succeeded) { results.push_back(succeeded); }));
+
+    uploadQueue.WaitForAll();
+    TEST_CHECK(results.size() == 4);
+    TEST_CHECK(results.size() == 4 && !results[0] && !results[1] && !results[2] && results[3]);
+    TEST_CHECK(uploadQueue.GetStats().failedCount == 3);
+    TEST_CHECK(uploadQueue.GetStats().completedCount == 1);
+    TEST_CHECK(copyQueue.GetStats().copyCount == 1);
+}
+
+
+// ステージングリングより大きいテクスチャを、行のまとまりに分けて複数回の Update() で書き込むこと
+static void TestOversizedTextureInRows()
+{
+    // 256x300 の RGBA (ミップマップ2段) は約 380KB、ステージングバッファは 64KB、1回の上限は 16KB
+    std::vector<uint8_t> stagingMemory(64 * 1024);
+    RecordingCopyQueue copyQueue(stagingMemory.data());
+    TextureUploadQueue uploadQueue(&copyQueue, StagingBuffer, stagingMemory.data(), stagingMemory.size(), 16 * 1024);
+
+    std::vector<RhiResource*> completed;
+    uploadQueue.Enqueue(MakeRequest(TextureA, 256, 300, 2, false, [&](bool succeeded) { TEST_CHECK(succeeded); completed.push_back(TextureA); }));
+    uploadQueue.Enqueue(MakeRequest(TextureB, 16, 16, 1, false, [&](bool succeeded) { TEST_CHECK(succeeded); completed.push_back(TextureB); }));
+
+    // 最初の Update() では 16KB (16行) だけ書き込み、後ろの要求は追い越さない
+    uploadQueue.Update();
+    TEST_CHECK(copyQueue.copies.size() == 1);
+    TEST_CHECK(copyQueue.copies.size() == 1 && copyQueue.copies[0].height == 16);
+    TEST_CHECK(completed.empty());
+
+    uploadQueue.WaitForAll();
+    TEST_CHECK(completed.size() == 2 && completed[0] == TextureA && completed[1] == TextureB);
+    CheckCopiesCoverTexture(copyQueue.copies, TextureA, 300, 2);
+    CheckCopiesCoverTexture(copyQueue.copies, TextureB, 16, 1);
+
+    // どの Update() も上限を超えて書き込まない
+    std::vector<uint64_t> bytesPerSubmit;
+    for (const RecordedCopy& copy : copyQueue.copies)
+    {
+        if (bytesPerSubmit.size() <= copy.submitIndex)
+        {
+            bytesPerSubmit.resize(copy.submitIndex + 1, 0);
+        }
+        bytesPerSubmit[copy.submitIndex] += (uint64_t)copy.rowPitch * copy.height;
+    }
+    for (uint64_t bytes : bytesPerSubmit)
+    {
+        TEST_CHECK(bytes <= 16 * 1024);
+    }
+
+    // 行を分けて書き込んだバイト数は、行ピッチ x 行数の合計
+    const uint64_t textureABytes = 1024 * 300 + 512 * 150;
+    TEST_CHECK(uploadQueue.GetStats().uploadedBytes == textureABytes + 256 * 15 + 64);
+    TEST_CHECK(uploadQueue.GetStats().completedCount == 2);
+    TEST_CHECK(uploadQueue.GetStats().failedCount == 0);
+}
+
+
+// ブロック圧縮フォーマットは4ピクセルの高さを1行として分けること
+static void TestOversizedBlockCompressedTexture()
+{
+    // 16x18 の BC7 は5行 (最後の行は2ピクセル分)。 ステージングバッファには2行しか入らない
+    std::vector<uint8_t> stagingMemory(512);
+    RecordingCopyQueue copyQueue(stagingMemory.data());
+    TextureUploadQueue uploadQueue(&copyQueue, StagingBuffer, stagingMemory.data(), stagingMemory.size());
+
+    bool isCompleted = false;
+    uploadQueue.Enqueue(MakeRequest(TextureA, 16, 18, 1, true, [&](bool succeeded) { isCompleted = succeeded; }));
+    uploadQueue.WaitForAll();
+
+    TEST_CHECK(isCompleted);
+    TEST_CHECK(copyQueue.copies.size() == 3);
+    if (copyQueue.copies.size() == 3)
+    {
+        TEST_CHECK(copyQueue.copies[0].destinationY == 0 && copyQueue.copies[0].height == 8);
+        TEST_CHECK(copyQueue.copies[1].destinationY == 8 && copyQueue.copies[1].height == 8);
+        TEST_CHECK(copyQueue.copies[2].destinationY == 16 && copyQueue.copies[2].height == 2);
+    }
+    CheckCopiesCoverTexture(copyQueue.copies, TextureA, 18, 1);
+}
+
+
+// GPUの完了が遅れても、ステージングリングの空きに合わせて書き込み、最後まで完了すること
+static void TestOversizedTextureWithSlowQueue()
+{
+    std::vector<uint8_t> stagingMemory(64 * 1024);
+    NullRhiCopyQueue copyQueue;
+    TextureUploadQueue uploadQueue(&copyQueue, StagingBuffer, stagingMemory.data(), stagingMemory.size());
+
+    bool isCompleted = false;
+    uploadQueue.Enqueue(MakeRequest(TextureA, 512, 512, 1, false, [&](bool succeeded) { isCompleted = succeeded; }));
+
+    // 1回目はステージングリング全体 (32行) を書き込み、完了するまで続きは書き込めない
+    uploadQueue.Update();
+    TEST_CHECK(copyQueue.GetStats().copyBytes == 64 * 1024);
+    uploadQueue.Update();
+    TEST_CHECK(copyQueue.GetStats().copyBytes == 64 * 1024);
+
+    for (uint32_t i = 0; i < 100 && !isCompleted; i++)
+    {
+        uploadQueue.Update();
+    }
+    TEST_CHECK(isCompleted);
+    TEST_CHECK(copyQueue.GetStats().copyBytes == 2048 * 512);
+    TEST_CHECK(uploadQueue.GetStats().peakStagingBytes == 64 * 1024);
+    TEST_CHECK(!uploadQueue.HasPendingUploads());
+}
+
+
+int main()
+{
+    TestCompletesAfterFence();
+    TestMaxBytesPerUpdate();
+    TestWaitsForStagingSpace();
+    TestFailedRequests();
+    TestOversizedTextureInRows();
+    TestOversizedBlockCompressedTexture();
+    TestOversizedTextureWithSlowQueue();
+    return TestResult("TextureUploadQueueTest");
+}
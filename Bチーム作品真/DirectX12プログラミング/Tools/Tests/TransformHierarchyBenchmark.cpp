@@ -0,0 +1,185 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// トランスフォーム階層のベンチマーク
+//
+//      ・1万個の要素を深さ8段の木に並べ、毎フレーム5%の要素を動かす。
+//      ・毎フレーム「動いた要素の一括再計算」と「全ての要素のワールド変換行列の取得(描画と同じ)」を行い、時間を計る。
+//      ・比較として、取得の度に祖先を全て辿って行列を掛け直す場合(バージョン番号を使う前の Transform と同じ)の時間も計る。
+//      ・行列は DirectXMath の代わりに、同じ掛け算の順番の4x4行列を使う。 (結果が一致することも確かめる)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "TransformHierarchy.h"
+#include "Test.h"
+#include <random>
+#include <vector>
+#include <chrono>
+#include <cmath>
+
+
+// 4x4行列 (行ベクトル × 行列 の順番で変換する。 DirectXMath と同じ)
+struct Matrix
+{
+    float m[4][4];
+};
+
+// a × b を計算する
+static Matrix Multiply(const Matrix& a, const Matrix& b)
+{
+    Matrix result;
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            result.m[row][column] = a.m[row][0] * b.m[0][column] + a.m[row][1] * b.m[1][column] + a.m[row][2] * b.m[2][column] + a.m[row][3] * b.m[3][column];
+        }
+    }
+    return result;
+}
+
+// z軸回りの回転と平行移動から、ローカル変換行列を作る
+static Matrix MakeLocalMatrix(float angle, float x, float y)
+{
+    const float c = cosf(angle);
+    const float s = sinf(angle);
+    return Matrix{ { { c, s, 0, 0 }, { -s, c, 0, 0 }, { 0, 0, 1, 0 }, { x, y, 0, 1 } } };
+}
+
+
+// 各段の要素の数 (合計 1万個、深さ 8段)
+static const uint32_t LevelSizes[] = { 10, 30, 90, 270, 810, 1500, 2800, 4490 };
+static const uint32_t NumLevels = sizeof(LevelSizes) / sizeof(LevelSizes[0]);
+
+
+int main()
+{
+    const uint32_t numFrames = 200;
+    std::mt19937 random(2024);
+    std::uniform_real_distribution<float> angle(-0.5f, 0.5f);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+
+    // 各段の要素の親を、1つ上の段から選ぶ
+    TransformHierarchy hierarchy;
+    std::vector<Matrix> localMatrices;
+    uint32_t levelBegin = 0;
+    uint32_t count = 0;
+    for (uint32_t level = 0; level < NumLevels; level++)
+    {
+        std::uniform_int_distribution<uint32_t> parent(levelBegin, (count > 0) ? count - 1 : 0);
+        levelBegin = count;
+        for (uint32_t i = 0; i < LevelSizes[level]; i++)
+        {
+            const uint32_t index = hierarchy.Add();
+            localMatrices.push_back(MakeLocalMatrix(angle(random), position(random), position(random)));
+            if (level > 0)
+            {
+                hierarchy.SetParent(index, (int32_t)parent(random));
+            }
+            hierarchy.SetDirty(index);
+            count++;
+        }
+    }
+    TEST_CHECK(count == 10000);
+    TEST_CHECK(!hierarchy.IsOrderDirty());
+
+    std::vector<Matrix> worldMatrices(count);
+    uint32_t computeCount = 0;
+    auto computeWorldMatrix = [&](uint32_t index, int32_t parentIndex)
+    {
+        worldMatrices[index] = (parentIndex >= 0) ? Multiply(localMatrices[index], worldMatrices[parentIndex]) : localMatrices[index];
+        computeCount++;
+    };
+    uint32_t changedCount = 0;
+    auto onChanged = [&](uint32_t) { changedCount++; };
+    hierarchy.UpdateWorldMatrices(computeWorldMatrix, onChanged);
+
+    // 毎フレーム動かす要素 (5%)
+    const uint32_t numMoving = count / 20;
+    std::uniform_int_distribution<uint32_t> movingIndex(0, count - 1);
+    std::vector<std::vector<uint32_t>> movingPerFrame(numFrames);
+    for (std::vector<uint32_t>& moving : movingPerFrame)
+    {
+        for (uint32_t i = 0; i < numMoving; i++)
+        {
+            moving.push_back(movingIndex(random));
+        }
+    }
+
+    // バージョン番号で古い行列だけを再計算する場合
+    uint64_t totalComputeCount = 0;
+    uint64_t totalChangedCount = 0;
+    float checksum = 0.0f;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < numFrames; frame++)
+    {
+        for (uint32_t index : movingPerFrame[frame])
+        {
+            localMatrices[index].m[3][0] += 0.01f;
+            hierarchy.SetDirty(index);
+        }
+
+        computeCount = 0;
+        changedCount = 0;
+        hierarchy.UpdateWorldMatrices(computeWorldMatrix, onChanged);
+        totalComputeCount += computeCount;
+        totalChangedCount += changedCount;
+
+        // 描画する時と同じように、全ての要素の行列を取得する (一括で再計算した直後なので、再計算は起きない)
+        for (uint32_t i = 0; i < count; i++)
+        {
+            hierarchy.UpdateWorldMatrix(i, computeWorldMatrix);
+            checksum += worldMatrices[i].m[3][0];
+        }
+        TEST_CHECK(computeCount == changedCount);
+    }
+    const double hierarchyMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / numFrames;
+
+    // 取得の度に祖先を全て辿って行列を掛け直す場合
+    std::vector<Matrix> naiveMatrices(count);
+    const auto naiveStart = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < numFrames; frame++)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            // 祖先から順番に掛ける為に、根まで辿ってから戻る
+            uint32_t chain[NumLevels];
+            uint32_t depth = 0;
+            for (int32_t j = (int32_t)i; j >= 0; j = hierarchy.GetParentIndex((uint32_t)j))
+            {
+                chain[depth++] = (uint32_t)j;
+            }
+            Matrix world = localMatrices[chain[depth - 1]];
+            for (uint32_t d = depth - 1; d-- > 0; )
+            {
+                world = Multiply(localMatrices[chain[d]], world);
+            }
+            naiveMatrices[i] = world;
+        }
+    }
+    const double naiveMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - naiveStart).count() / numFrames;
+
+    // 掛け算の順番が同じなので、結果は完全に一致する
+    bool isSame = true;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                isSame = isSame && (naiveMatrices[i].m[row][column] == worldMatrices[i].m[row][column]);
+            }
+        }
+    }
+    TEST_CHECK(isSame);
+
+    // 動いた要素の子孫も再計算されるので、動かした数よりは多いが、全体よりはずっと少ない
+    const double averageComputeCount = (double)totalComputeCount / numFrames;
+    TEST_CHECK(averageComputeCount >= numMoving * 0.9);
+    TEST_CHECK(averageComputeCount < count * 0.5);
+    TEST_CHECK(hierarchyMilliseconds < naiveMilliseconds);
+    TEST_CHECK(std::isfinite(checksum));
+
+    printf("[情報] 要素 %u 個 / 深さ %u 段 / 毎フレーム %u 個(5%%)を移動\n", count, NumLevels, numMoving);
+    printf("[情報] バージョン番号 : 1フレーム %.3f ms (再計算 平均 %.0f 個, 変化を通知 平均 %.0f 個)\n",
+        hierarchyMilliseconds, averageComputeCount, (double)totalChangedCount / numFrames);
+    printf("[情報] 毎回祖先を辿る : 1フレーム %.3f ms (%u 個の行列を毎回計算)\n", naiveMilliseconds, count);
+    return TestResult("TransformHierarchyBenchmark");
+}
@@ -0,0 +1,308 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// トランスフォーム階層のテスト
+//
+//      ・ローカルの値が変わった要素と、その子孫だけが再計算され、それ以外は再計算されないことを確かめる。
+//      ・個別に取得した場合は、古い祖先だけが親から順番に再計算されることを確かめる。
+//      ・逆行列は必要になった時に、ワールド変換行列が変わった後の1回だけ計算されることを確かめる。
+//      ・親子関係の変更と削除で崩れた並び順が、並べ替えで「親が子よりも前」に戻ることを確かめる。
+//      ・行列の代わりに、平行移動だけを表す3次元ベクトルを使う。 (DirectXMath は使わない)
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include "TransformHierarchy.h"
+#include "Test.h"
+#include <vector>
+
+
+// 平行移動だけを表す変換
+struct Translation
+{
+    float x, y, z;
+};
+
+// テスト用のシーン (TransformSystem と同じく、階層と同じ並び順の配列で値を持つ)
+struct TestScene
+{
+    TransformHierarchy hierarchy;
+    std::vector<Translation> localPositions;
+    std::vector<Translation> worldPositions;
+    std::vector<Translation> inversePositions;
+    std::vector<uint32_t> names;                // 要素を見分ける為の番号 (並べ替えや削除で格納位置が変わっても変わらない)
+    std::vector<uint32_t> computedNames;        // ワールド変換行列を計算した要素の番号 (計算した順番)
+    uint32_t inverseCount = 0;                  // 逆行列を計算した回数
+
+    uint32_t Add(uint32_t name, float x, float y, float z)
+    {
+        const uint32_t index = hierarchy.Add();
+        localPositions.push_back({ x, y, z });
+        worldPositions.push_back({ 0, 0, 0 });
+        inversePositions.push_back({ 0, 0, 0 });
+        names.push_back(name);
+        hierarchy.SetDirty(index);
+        return index;
+    }
+
+    uint32_t IndexOf(uint32_t name) const
+    {
+        for (uint32_t i = 0; i < (uint32_t)names.size(); i++)
+        {
+            if (names[i] == name)
+            {
+                return i;
+            }
+        }
+        return ~0u;
+    }
+
+    void ComputeWorld(uint32_t index, int32_t parentIndex)
+    {
+        Translation world = localPositions[index];
+        if (parentIndex >= 0)
+        {
+            world.x += worldPositions[parentIndex].x;
+            world.y += worldPositions[parentIndex].y;
+            world.z += worldPositions[parentIndex].z;
+        }
+        worldPositions[index] = world;
+        computedNames.push_back(names[index]);
+    }
+
+    void UpdateAll(std::vector<uint32_t>* changedNames = nullptr)
+    {
+        if (hierarchy.IsOrderDirty())
+        {
+            hierarchy.SortParentBeforeChild();
+            hierarchy.Reorder(localPositions);
+            hierarchy.Reorder(worldPositions);
+            hierarchy.Reorder(inversePositions);
+            hierarchy.Reorder(names);
+        }
+        hierarchy.UpdateWorldMatrices(
+            [this](uint32_t i, int32_t parentIndex) { ComputeWorld(i, parentIndex); },
+            [this, changedNames](uint32_t i) { if (changedNames) changedNames->push_back(names[i]); });
+    }
+
+    const Translation& GetWorld(uint32_t name)
+    {
+        const uint32_t index = IndexOf(name);
+        hierarchy.UpdateWorldMatrix(index, [this](uint32_t i, int32_t parentIndex) { ComputeWorld(i, parentIndex); });
+        return worldPositions[index];
+    }
+
+    const Translation& GetInverse(uint32_t name)
+    {
+        const uint32_t index = IndexOf(name);
+        hierarchy.UpdateWorldToLocalMatrix(index,
+            [this](uint32_t i, int32_t parentIndex) { ComputeWorld(i, parentIndex); },
+            [this](uint32_t i)
+            {
+                inversePositions[i] = { -worldPositions[i].x, -worldPositions[i].y, -worldPositions[i].z };
+                inverseCount++;
+            });
+        return inversePositions[index];
+    }
+
+    void Translate(uint32_t name, float dx)
+    {
+        const uint32_t index = IndexOf(name);
+        localPositions[index].x += dx;
+        hierarchy.SetDirty(index);
+    }
+
+    void SetParent(uint32_t name, uint32_t parentName)
+    {
+        hierarchy.SetParent(IndexOf(name), (int32_t)IndexOf(parentName));
+    }
+
+    // 全ての要素が「親が子よりも前」に並んでいれば true
+    bool IsParentBeforeChild() const
+    {
+        for (uint32_t i = 0; i < hierarchy.GetCount(); i++)
+        {
+            if (hierarchy.GetParentIndex(i) >= (int32_t)i)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+
+// 名前の一覧に指定した名前が含まれていれば true
+static bool Contains(const std::vector<uint32_t>& names, uint32_t name)
+{
+    for (uint32_t n : names)
+    {
+        if (n == name)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// 2本の木を作る
+//      1 ─┬─ 2 ── 3
+//          └─ 4
+//      5 ── 6
+static void MakeTwoTrees(TestScene& scene)
+{
+    for (uint32_t name = 1; name <= 6; name++)
+    {
+        scene.Add(name, (float)name, 0, 0);
+    }
+    scene.SetParent(2, 1);
+    scene.SetParent(3, 2);
+    scene.SetParent(4, 1);
+    scene.SetParent(6, 5);
+    scene.UpdateAll();
+}
+
+
+// 変化した要素と、その子孫だけが再計算される
+static void TestDirtyPropagation()
+{
+    TestScene scene;
+    MakeTwoTrees(scene);
+    TEST_CHECK(scene.computedNames.size() == 6);
+    TEST_CHECK(scene.GetWorld(3).x == 1 + 2 + 3);
+    TEST_CHECK(scene.GetWorld(6).x == 5 + 6);
+
+    // 何も変わっていなければ、何も再計算されない
+    scene.computedNames.clear();
+    std::vector<uint32_t> changed;
+    scene.UpdateAll(&changed);
+    TEST_CHECK(scene.computedNames.empty());
+    TEST_CHECK(changed.empty());
+
+    // 2 を動かすと、2 と子孫の 3 だけが再計算される
+    const uint32_t versionOf1 = scene.hierarchy.GetVersion(scene.IndexOf(1));
+    const uint32_t versionOf3 = scene.hierarchy.GetVersion(scene.IndexOf(3));
+    scene.Translate(2, 10);
+    scene.UpdateAll(&changed);
+    TEST_CHECK(scene.computedNames.size() == 2);
+    TEST_CHECK(Contains(scene.computedNames, 2) && Contains(scene.computedNames, 3));
+    TEST_CHECK(changed.size() == 2);
+    TEST_CHECK(scene.GetWorld(3).x == 1 + 12 + 3);
+    TEST_CHECK(scene.GetWorld(4).x == 1 + 4);
+    TEST_CHECK(scene.hierarchy.GetVersion(scene.IndexOf(1)) == versionOf1);
+    TEST_CHECK(scene.hierarchy.GetVersion(scene.IndexOf(3)) == versionOf3 + 1);
+
+    // 同じフレームに何度動かしても、再計算は1回だけ
+    scene.computedNames.clear();
+    scene.Translate(1, 1);
+    scene.Translate(1, 1);
+    scene.Translate(2, 1);
+    scene.UpdateAll();
+    TEST_CHECK(scene.computedNames.size() == 4);
+    TEST_CHECK(scene.GetWorld(3).x == 3 + 13 + 3);
+    TEST_CHECK(!Contains(scene.computedNames, 5) && !Contains(scene.computedNames, 6));
+}
+
+
+// 個別に取得すると、古い祖先だけが親から順番に再計算される
+static void TestLazyWorldMatrix()
+{
+    TestScene scene;
+    MakeTwoTrees(scene);
+
+    scene.computedNames.clear();
+    scene.Translate(1, 100);
+    TEST_CHECK(scene.GetWorld(3).x == 101 + 2 + 3);
+    TEST_CHECK(scene.computedNames == std::vector<uint32_t>({ 1, 2, 3 }));
+
+    // もう一度取得しても再計算されない
+    TEST_CHECK(scene.GetWorld(3).x == 101 + 2 + 3);
+    TEST_CHECK(scene.computedNames.size() == 3);
+
+    // 一括の再計算では、残りの 4 だけが再計算されるが、個別に再計算したものも変化したとして知らされる
+    std::vector<uint32_t> changed;
+    scene.UpdateAll(&changed);
+    TEST_CHECK(scene.computedNames == std::vector<uint32_t>({ 1, 2, 3, 4 }));
+    TEST_CHECK(changed.size() == 4);
+    TEST_CHECK(!Contains(changed, 5));
+}
+
+
+// 逆行列は必要になった時だけ計算する
+static void TestLazyInverse()
+{
+    TestScene scene;
+    MakeTwoTrees(scene);
+    TEST_CHECK(scene.inverseCount == 0);
+
+    TEST_CHECK(scene.GetInverse(3).x == -(1 + 2 + 3));
+    TEST_CHECK(scene.inverseCount == 1);
+    TEST_CHECK(scene.GetInverse(3).x == -(1 + 2 + 3));
+    TEST_CHECK(scene.inverseCount == 1);
+
+    // 祖先が動いて一括で再計算されても、逆行列は要求されるまで計算しない
+    scene.Translate(1, 5);
+    scene.UpdateAll();
+    TEST_CHECK(scene.inverseCount == 1);
+    TEST_CHECK(scene.GetInverse(3).x == -(6 + 2 + 3));
+    TEST_CHECK(scene.inverseCount == 2);
+
+    // ワールド変換行列が古いまま逆行列を要求すると、先にワールド変換行列が再計算される
+    scene.Translate(2, 1);
+    TEST_CHECK(scene.GetInverse(3).x == -(6 + 3 + 3));
+    TEST_CHECK(scene.inverseCount == 3);
+}
+
+
+// 親子関係の変更と削除で崩れた並び順を、並べ替えで戻す
+static void TestSortParentBeforeChild()
+{
+    TestScene scene;
+    MakeTwoTrees(scene);
+    TEST_CHECK(!scene.hierarchy.IsOrderDirty());
+
+    // 後ろにいる 6 を 1 の親にすると、並び順が崩れる
+    scene.SetParent(1, 6);
+    TEST_CHECK(scene.hierarchy.IsOrderDirty());
+    scene.computedNames.clear();
+    scene.UpdateAll();
+    TEST_CHECK(!scene.hierarchy.IsOrderDirty());
+    TEST_CHECK(scene.IsParentBeforeChild());
+    TEST_CHECK(scene.GetWorld(3).x == 5 + 6 + 1 + 2 + 3);
+    TEST_CHECK(scene.computedNames.size() == 4);
+
+    // 部分木は連続して並ぶ (5 6 1 2 3 4)
+    const uint32_t expected[] = { 5, 6, 1, 2, 3, 4 };
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        TEST_CHECK(scene.names[i] == expected[i]);
+    }
+
+    // 先頭の 5 を削除すると、末尾の 4 が先頭に移動して親の 1 よりも前になる
+    // (削除されるのは子を持たない要素。 5 の子の 6 は先に親から外す)
+    scene.hierarchy.SetParent(scene.IndexOf(6), -1);
+    const uint32_t removed = scene.IndexOf(5);
+    const uint32_t last = scene.hierarchy.GetCount() - 1;
+    scene.hierarchy.Remove(removed);
+    scene.localPositions[removed] = scene.localPositions[last];
+    scene.worldPositions[removed] = scene.worldPositions[last];
+    scene.inversePositions[removed] = scene.inversePositions[last];
+    scene.names[removed] = scene.names[last];
+    scene.localPositions.pop_back();
+    scene.worldPositions.pop_back();
+    scene.inversePositions.pop_back();
+    scene.names.pop_back();
+    TEST_CHECK(scene.hierarchy.IsOrderDirty());
+
+    scene.UpdateAll();
+    TEST_CHECK(scene.IsParentBeforeChild());
+    TEST_CHECK(scene.GetWorld(4).x == 6 + 1 + 4);
+    TEST_CHECK(scene.GetWorld(3).x == 6 + 1 + 2 + 3);
+}
+
+
+int main()
+{
+    TestDirtyPropagation();
+    TestLazyWorldMatrix();
+    TestLazyInverse();
+    TestSortParentBeforeChild();
+    return TestResult("TransformHierarchyTest");
+}
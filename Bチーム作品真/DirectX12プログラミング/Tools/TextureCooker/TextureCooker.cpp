@@ -0,0 +1,1170 @@
+﻿//---------------------------------------------------------------------------------------------------------------------------------------------
+// テクスチャクッカー
+//
+//      ・入力ディレクトリ以下の全ての画像ファイル(.png .jpg .jpeg)を、ミップマップ付きのブロック圧縮テクスチャ(.dds)に変換するツール。
+//      ・出力ファイルは入力ディレクトリと同じ階層に置き、拡張子だけを .dds に変える。
+//        ゲーム本体の Texture2D::FromFile() は、変換済みのファイルがあればそちらを読み込む。 (デコードが要らず、VRAMも小さくなる)
+//      ・圧縮形式はテクスチャリストで指定する。 指定が無い場合はファイル名の接尾辞から決める。
+//          _bc1                →  BC1
+//          _bc3, _d4444        →  BC3
+//          _bc7, _d8888        →  BC7
+//          (それ以外)          →  透明なピクセルがあれば BC3、無ければ BC1
+//        幅か高さが4の倍数でない画像はブロック圧縮できないので、R8G8B8A8 のまま出力する。
+//      ・ミップマップは1x1まで作成する。 乗算済みアルファにしない画像は、アルファで重み付けして縮小する。
+//        (透明なピクセルの色が、縮小したときに周りに滲み出さない)
+//      ・ソースファイルの中身と変換の設定から計算したキーを DDS ヘッダーの予約領域に書いておき、キーが一致するファイルは変換しない。
+//      ・変換は論理コア数と同じ数のスレッドで並列に行う。
+//
+//  使い方:
+//      TextureCooker <入力ディレクトリ> <出力ディレクトリ> [--list <テクスチャリスト>]
+//      (例: TextureCooker Assets Assets/CookedTextures --list Assets/TextureList.txt)
+//
+//  テクスチャリストの書式 (1行に1テクスチャ。 '#' から行末まではコメント。 空白を含むパスは "" で囲む):
+//      <画像ファイルへのパス(入力ディレクトリからの相対パス)> <auto | bc1 | bc3 | bc7 | rgba8> [premultiplied] [nomips]
+//
+//---------------------------------------------------------------------------------------------------------------------------------------------
+#include <png.h>
+#include <jpeglib.h>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <filesystem>
+
+
+// 出力するピクセルフォーマット
+enum class CookFormat
+{
+    Auto,                               // ファイル名の接尾辞と透明なピクセルの有無から決める
+    BC1,                                // BC1 (4ビット/ピクセル。 アルファは1ビット)
+    BC3,                                // BC3 (8ビット/ピクセル。 アルファは補間)
+    BC7,                                // BC7 (8ビット/ピクセル。 モード6のみを使う)
+    RGBA8,                              // R8G8B8A8 (32ビット/ピクセル。 圧縮しない)
+};
+
+
+// テクスチャ1つ分の変換の設定
+struct CookSettings
+{
+    CookFormat format;                  // 出力するピクセルフォーマット
+    bool premultipliedAlpha;            // 乗算済みアルファにする場合は true
+    bool generateMips;                  // ミップマップを作成する場合は true
+};
+
+
+// 変換するテクスチャ
+struct TextureEntry
+{
+    std::filesystem::path sourcePath;   // 画像ファイルへのパス
+    std::filesystem::path outputPath;   // 出力するDDSファイルへのパス
+    CookSettings settings;              // 変換の設定
+};
+
+
+// 8ビットRGBAの画像
+struct Image
+{
+    uint32_t width;                     // 幅 (単位はピクセル)
+    uint32_t height;                    // 高さ (単位はピクセル)
+    std::vector<uint8_t> pixels;        // ピクセルデータ (R, G, B, A の順)
+};
+
+
+// 処理結果
+enum class CookResult
+{
+    UpToDate,                           // DDSファイルが最新なので変換しなかった
+    Cooked,                             // 変換してDDSファイルを書き出した
+    Failed,                             // 失敗した
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// DDSファイルの形式 (DirectXTex の DDS.h と同じレイアウト)
+//---------------------------------------------------------------------------------------------------------------------------------------------
+struct DdsPixelFormat
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rBitMask;
+    uint32_t gBitMask;
+    uint32_t bBitMask;
+    uint32_t aBitMask;
+};
+
+struct DdsHeader
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];             // [0]: CookMagic, [1]: CookVersion, [2][3]: キー (下位, 上位)
+    DdsPixelFormat pixelFormat;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct DdsHeaderDx10
+{
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;                // 下位3ビットはアルファモード
+};
+
+static_assert(sizeof(DdsHeader) == 124, "DDS ヘッダーのサイズが正しくありません");
+static_assert(sizeof(DdsHeaderDx10) == 20, "DDS ヘッダー(DX10拡張)のサイズが正しくありません");
+
+static constexpr uint32_t DdsMagic = 0x20534444;                // 'D' 'D' 'S' ' '
+static constexpr uint32_t DdsFourCCDx10 = 0x30315844;           // 'D' 'X' '1' '0'
+static constexpr uint32_t DdsHeaderFlagsTexture = 0x00001007;   // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+static constexpr uint32_t DdsHeaderFlagsMipMap = 0x00020000;    // DDSD_MIPMAPCOUNT
+static constexpr uint32_t DdsHeaderFlagsPitch = 0x00000008;     // DDSD_PITCH
+static constexpr uint32_t DdsHeaderFlagsLinearSize = 0x00080000;    // DDSD_LINEARSIZE
+static constexpr uint32_t DdsPixelFormatFourCC = 0x00000004;    // DDPF_FOURCC
+static constexpr uint32_t DdsCapsTexture = 0x00001000;          // DDSCAPS_TEXTURE
+static constexpr uint32_t DdsCapsMipMap = 0x00400008;           // DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+static constexpr uint32_t DdsDimensionTexture2D = 3;            // DDS_DIMENSION_TEXTURE2D
+static constexpr uint32_t DdsAlphaModeStraight = 1;             // DDS_ALPHA_MODE_STRAIGHT
+static constexpr uint32_t DdsAlphaModePremultiplied = 2;        // DDS_ALPHA_MODE_PREMULTIPLIED
+static constexpr uint32_t DdsAlphaModeOpaque = 3;               // DDS_ALPHA_MODE_OPAQUE
+
+// DXGI_FORMAT の値
+static constexpr uint32_t DxgiFormatR8G8B8A8UNorm = 28;
+static constexpr uint32_t DxgiFormatBC1UNorm = 71;
+static constexpr uint32_t DxgiFormatBC3UNorm = 77;
+static constexpr uint32_t DxgiFormatBC7UNorm = 98;
+
+// 予約領域に書くクッカーの識別子とバージョン (エンコーダーを変えたらバージョンを上げて、全て変換し直す)
+static constexpr uint32_t CookMagic = 0x4B435854;               // 'T' 'X' 'C' 'K'
+static constexpr uint32_t CookVersion = 1;
+
+
+static std::mutex s_printMutex;                                 // コンソール出力が混ざらないようにする
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// キーの計算 (FNV-1a 64ビット)
+//---------------------------------------------------------------------------------------------------------------------------------------------
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+// ソースファイルの中身と変換の設定からキーを計算する
+static uint64_t ComputeKey(const std::vector<uint8_t>& sourceFile, const CookSettings& settings)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    hash = HashBytes(hash, &CookVersion, sizeof(CookVersion));
+    const uint8_t settingBytes[] = { (uint8_t)settings.format, (uint8_t)settings.premultipliedAlpha, (uint8_t)settings.generateMips };
+    hash = HashBytes(hash, settingBytes, sizeof(settingBytes));
+    return HashBytes(hash, sourceFile.data(), sourceFile.size());
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// 画像のデコード
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// PNGファイルをデコードする
+static bool DecodePng(const std::vector<uint8_t>& sourceFile, Image& image)
+{
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_memory(&png, sourceFile.data(), sourceFile.size()))
+    {
+        return false;
+    }
+
+    png.format = PNG_FORMAT_RGBA;
+    image.width = png.width;
+    image.height = png.height;
+    image.pixels.resize((size_t)PNG_IMAGE_SIZE(png));
+    if (!png_image_finish_read(&png, nullptr, image.pixels.data(), 0, nullptr))
+    {
+        png_image_free(&png);
+        return false;
+    }
+    return true;
+}
+
+
+// libjpeg のエラーで longjmp() する為のエラーマネージャー
+struct JpegErrorManager
+{
+    jpeg_error_mgr base;
+    jmp_buf jumpBuffer;
+};
+
+static void OnJpegError(j_common_ptr info)
+{
+    longjmp(((JpegErrorManager*)info->err)->jumpBuffer, 1);
+}
+
+
+// JPEGファイルをデコードする
+static bool DecodeJpeg(const std::vector<uint8_t>& sourceFile, Image& image)
+{
+    jpeg_decompress_struct info;
+    JpegErrorManager errorManager;
+    info.err = jpeg_std_error(&errorManager.base);
+    errorManager.base.error_exit = OnJpegError;
+    if (setjmp(errorManager.jumpBuffer))
+    {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, sourceFile.data(), (unsigned long)sourceFile.size());
+    jpeg_read_header(&info, TRUE);
+    info.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&info);
+
+    image.width = info.output_width;
+    image.height = info.output_height;
+    image.pixels.resize((size_t)image.width * image.height * 4);
+    std::vector<uint8_t> row((size_t)image.width * 3);
+    while (info.output_scanline < info.output_height)
+    {
+        const uint32_t y = info.output_scanline;
+        JSAMPROW rowPointer = row.data();
+        jpeg_read_scanlines(&info, &rowPointer, 1);
+
+        uint8_t* destination = &image.pixels[(size_t)y * image.width * 4];
+        for (uint32_t x = 0; x < image.width; x++)
+        {
+            destination[x * 4 + 0] = row[x * 3 + 0];
+            destination[x * 4 + 1] = row[x * 3 + 1];
+            destination[x * 4 + 2] = row[x * 3 + 2];
+            destination[x * 4 + 3] = 255;
+        }
+    }
+
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ミップマップの作成
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// 不透明でない(アルファが255未満の)ピクセルがある場合は true を返す
+static bool HasTransparentPixels(const Image& image)
+{
+    for (size_t i = 3; i < image.pixels.size(); i += 4)
+    {
+        if (image.pixels[i] != 255)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// 色にアルファを乗算する
+static void PremultiplyAlpha(Image& image)
+{
+    for (size_t i = 0; i < image.pixels.size(); i += 4)
+    {
+        const uint32_t alpha = image.pixels[i + 3];
+        for (size_t c = 0; c < 3; c++)
+        {
+            image.pixels[i + c] = (uint8_t)((image.pixels[i + c] * alpha + 127) / 255);
+        }
+    }
+}
+
+
+// 2x2ピクセルの平均で、幅と高さが半分(切り捨て、最小1)の画像を作成する
+//   ・幅か高さが奇数の場合は、端のピクセルを繰り返す。
+//   ・alphaWeighted が true の場合は、色をアルファで重み付けして平均する。 (乗算済みアルファでない画像用)
+static Image Downsample(const Image& source, bool alphaWeighted)
+{
+    Image destination;
+    destination.width = std::max(source.width / 2, 1u);
+    destination.height = std::max(source.height / 2, 1u);
+    destination.pixels.resize((size_t)destination.width * destination.height * 4);
+
+    for (uint32_t y = 0; y < destination.height; y++)
+    {
+        for (uint32_t x = 0; x < destination.width; x++)
+        {
+            const uint32_t x0 = std::min(x * 2, source.width - 1);
+            const uint32_t x1 = std::min(x * 2 + 1, source.width - 1);
+            const uint32_t y0 = std::min(y * 2, source.height - 1);
+            const uint32_t y1 = std::min(y * 2 + 1, source.height - 1);
+            const uint8_t* samples[4] =
+            {
+                &source.pixels[((size_t)y0 * source.width + x0) * 4],
+                &source.pixels[((size_t)y0 * source.width + x1) * 4],
+                &source.pixels[((size_t)y1 * source.width + x0) * 4],
+                &source.pixels[((size_t)y1 * source.width + x1) * 4],
+            };
+
+            uint32_t alphaSum = 0;
+            for (const uint8_t* sample : samples)
+            {
+                alphaSum += sample[3];
+            }
+
+            uint8_t* pixel = &destination.pixels[((size_t)y * destination.width + x) * 4];
+            for (size_t c = 0; c < 3; c++)
+            {
+                if (alphaWeighted && alphaSum > 0)
+                {
+                    uint32_t weightedSum = 0;
+                    for (const uint8_t* sample : samples)
+                    {
+                        weightedSum += sample[c] * sample[3];
+                    }
+                    pixel[c] = (uint8_t)((weightedSum + alphaSum / 2) / alphaSum);
+                }
+                else
+                {
+                    pixel[c] = (uint8_t)((samples[0][c] + samples[1][c] + samples[2][c] + samples[3][c] + 2) / 4);
+                }
+            }
+            pixel[3] = (uint8_t)((alphaSum + 2) / 4);
+        }
+    }
+    return destination;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// ブロック圧縮
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// 4x4ピクセルのブロック (画像の端からはみ出す部分は端のピクセルを繰り返す)
+struct Block
+{
+    uint8_t pixels[16][4];
+};
+
+
+static Block LoadBlock(const Image& image, uint32_t blockX, uint32_t blockY)
+{
+    Block block;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        const uint32_t x = std::min(blockX * 4 + (i % 4), image.width - 1);
+        const uint32_t y = std::min(blockY * 4 + (i / 4), image.height - 1);
+        memcpy(block.pixels[i], &image.pixels[((size_t)y * image.width + x) * 4], 4);
+    }
+    return block;
+}
+
+
+// 128ビットのブロックに下位ビットから順番に書き込む
+class BitWriter
+{
+private:
+    uint8_t* m_bytes;
+    uint32_t m_position;
+
+public:
+    explicit BitWriter(uint8_t* bytes) : m_bytes(bytes), m_position(0) { memset(bytes, 0, 16); }
+
+    void Write(uint32_t value, uint32_t numBits)
+    {
+        for (uint32_t i = 0; i < numBits; i++, m_position++)
+        {
+            if (value & (1u << i))
+            {
+                m_bytes[m_position / 8] |= (uint8_t)(1u << (m_position % 8));
+            }
+        }
+    }
+};
+
+
+// ピクセルの主軸(分散が最大の方向)を求め、主軸上の最小と最大の点を端点とする
+//   ・numChannels はRGBなら3、RGBAなら4。 mask が false のピクセルは無視する。
+static void FindEndpoints(const Block& block, const bool* mask, uint32_t numChannels, float endpoint0[4], float endpoint1[4])
+{
+    float mean[4] = { 0, 0, 0, 0 };
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        if (!mask[i]) continue;
+        for (uint32_t c = 0; c < numChannels; c++) mean[c] += block.pixels[i][c];
+        count++;
+    }
+    for (uint32_t c = 0; c < numChannels; c++) mean[c] /= (float)count;
+
+    // 共分散行列
+    float covariance[4][4] = {};
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        if (!mask[i]) continue;
+        for (uint32_t a = 0; a < numChannels; a++)
+        {
+            for (uint32_t b = 0; b < numChannels; b++)
+            {
+                covariance[a][b] += (block.pixels[i][a] - mean[a]) * (block.pixels[i][b] - mean[b]);
+            }
+        }
+    }
+
+    // べき乗法で最大固有値の固有ベクトルを求める
+    float axis[4] = { 1, 1, 1, 1 };
+    for (uint32_t iteration = 0; iteration < 8; iteration++)
+    {
+        float next[4] = { 0, 0, 0, 0 };
+        float length = 0;
+        for (uint32_t a = 0; a < numChannels; a++)
+        {
+            for (uint32_t b = 0; b < numChannels; b++) next[a] += covariance[a][b] * axis[b];
+            length += next[a] * next[a];
+        }
+        if (length < 1e-6f) break;
+        length = sqrtf(length);
+        for (uint32_t c = 0; c < numChannels; c++) axis[c] = next[c] / length;
+    }
+
+    float minProjection = 0, maxProjection = 0;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        if (!mask[i]) continue;
+        float projection = 0;
+        for (uint32_t c = 0; c < numChannels; c++) projection += (block.pixels[i][c] - mean[c]) * axis[c];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    for (uint32_t c = 0; c < numChannels; c++)
+    {
+        endpoint0[c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f);
+        endpoint1[c] = std::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f);
+    }
+}
+
+
+static uint32_t SquaredDistance(const uint8_t* a, const int32_t* b, uint32_t numChannels)
+{
+    uint32_t distance = 0;
+    for (uint32_t c = 0; c < numChannels; c++)
+    {
+        const int32_t difference = (int32_t)a[c] - b[c];
+        distance += (uint32_t)(difference * difference);
+    }
+    return distance;
+}
+
+
+static uint16_t PackRgb565(const float color[4])
+{
+    const uint32_t r = (uint32_t)(color[0] * 31.0f / 255.0f + 0.5f);
+    const uint32_t g = (uint32_t)(color[1] * 63.0f / 255.0f + 0.5f);
+    const uint32_t b = (uint32_t)(color[2] * 31.0f / 255.0f + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+
+static void UnpackRgb565(uint16_t packed, int32_t color[4])
+{
+    const int32_t r = (packed >> 11) & 31;
+    const int32_t g = (packed >> 5) & 63;
+    const int32_t b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+    color[3] = 255;
+}
+
+
+// BC1 の色ブロック(8バイト)を作成する
+//   ・allowPunchThrough が true の場合は、アルファが128未満のピクセルを透明(3色モードの添え字3)にする。 (BC1 用)
+//   ・false の場合は常に4色モードで作成する。 (BC3 の色ブロック用)
+static void EncodeColorBlock(const Block& block, bool allowPunchThrough, uint8_t* output)
+{
+    bool mask[16];
+    bool hasTransparent = false;
+    bool hasOpaque = false;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        mask[i] = !allowPunchThrough || (block.pixels[i][3] >= 128);
+        hasTransparent |= !mask[i];
+        hasOpaque |= mask[i];
+    }
+
+    uint16_t color0 = 0, color1 = 0;
+    if (hasOpaque)
+    {
+        float endpoint0[4], endpoint1[4];
+        FindEndpoints(block, mask, 3, endpoint0, endpoint1);
+        color0 = PackRgb565(endpoint0);
+        color1 = PackRgb565(endpoint1);
+    }
+
+    // 4色モードは color0 > color1、透明を含む3色モードは color0 <= color1 で表す
+    if (hasTransparent ? (color0 > color1) : (color0 < color1))
+    {
+        std::swap(color0, color1);
+    }
+    const bool isFourColorMode = !allowPunchThrough || (color0 > color1);
+
+    int32_t palette[4][4];
+    UnpackRgb565(color0, palette[0]);
+    UnpackRgb565(color1, palette[1]);
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        if (isFourColorMode)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    const uint32_t numColors = isFourColorMode ? 4 : 3;
+
+    uint32_t indices = 0;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        uint32_t bestIndex = 3;
+        if (mask[i])
+        {
+            uint32_t bestDistance = UINT32_MAX;
+            for (uint32_t index = 0; index < numColors; index++)
+            {
+                const uint32_t distance = SquaredDistance(block.pixels[i], palette[index], 3);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = index;
+                }
+            }
+        }
+        indices |= bestIndex << (i * 2);
+    }
+
+    output[0] = (uint8_t)(color0 & 0xFF);
+    output[1] = (uint8_t)(color0 >> 8);
+    output[2] = (uint8_t)(color1 & 0xFF);
+    output[3] = (uint8_t)(color1 >> 8);
+    memcpy(output + 4, &indices, 4);
+}
+
+
+// BC3 のアルファブロック(8バイト)を作成する (8段階の補間モードのみを使う)
+static void EncodeAlphaBlock(const Block& block, uint8_t* output)
+{
+    uint8_t alpha0 = 0, alpha1 = 255;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        alpha0 = std::max(alpha0, block.pixels[i][3]);
+        alpha1 = std::min(alpha1, block.pixels[i][3]);
+    }
+
+    int32_t palette[8];
+    palette[0] = alpha0;
+    palette[1] = alpha1;
+    for (int32_t i = 2; i < 8; i++)
+    {
+        palette[i] = ((8 - i) * alpha0 + (i - 1) * alpha1) / 7;
+    }
+
+    uint64_t indices = 0;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        uint32_t bestIndex = 0;
+        int32_t bestDistance = INT32_MAX;
+        for (uint32_t index = 0; (alpha0 > alpha1) ? (index < 8) : (index < 1); index++)
+        {
+            const int32_t distance = abs((int32_t)block.pixels[i][3] - palette[index]);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                bestIndex = index;
+            }
+        }
+        indices |= (uint64_t)bestIndex << (i * 3);
+    }
+
+    output[0] = alpha0;
+    output[1] = alpha1;
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        output[2 + i] = (uint8_t)(indices >> (i * 8));
+    }
+}
+
+
+// BC7 のブロック(16バイト)をモード6 (1サブセット、RGBA 7ビット+Pビットの端点、4ビットの添え字) で作成する
+static void EncodeBC7Block(const Block& block, uint8_t* output)
+{
+    static const int32_t Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    bool mask[16];
+    std::fill(mask, mask + 16, true);
+    float endpoints[2][4];
+    FindEndpoints(block, mask, 4, endpoints[0], endpoints[1]);
+
+    // 4通りのPビットの組み合わせを試して、誤差が最小のものを使う
+    // (不透明なブロックは、アルファが正確に255になる組み合わせ(両方1)だけを使う)
+    bool isOpaque = true;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        isOpaque &= (block.pixels[i][3] == 255);
+    }
+    uint32_t bestError = UINT32_MAX;
+    uint32_t bestQuantized[2][4] = {};
+    uint32_t bestPBits[2] = {};
+    uint32_t bestIndices[16] = {};
+    for (uint32_t pBitCombination = isOpaque ? 3 : 0; pBitCombination < 4; pBitCombination++)
+    {
+        const uint32_t pBits[2] = { pBitCombination & 1, pBitCombination >> 1 };
+        uint32_t quantized[2][4];
+        int32_t colors[2][4];
+        for (uint32_t e = 0; e < 2; e++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                const int32_t value = (int32_t)((endpoints[e][c] - (float)pBits[e]) / 2.0f + 0.5f);
+                quantized[e][c] = (uint32_t)std::clamp(value, 0, 127);
+                colors[e][c] = (int32_t)((quantized[e][c] << 1) | pBits[e]);
+            }
+        }
+
+        int32_t palette[16][4];
+        for (uint32_t index = 0; index < 16; index++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                palette[index][c] = ((64 - Weights[index]) * colors[0][c] + Weights[index] * colors[1][c] + 32) >> 6;
+            }
+        }
+
+        uint32_t error = 0;
+        uint32_t indices[16];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            uint32_t bestDistance = UINT32_MAX;
+            for (uint32_t index = 0; index < 16; index++)
+            {
+                const uint32_t distance = SquaredDistance(block.pixels[i], palette[index], 4);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    indices[i] = index;
+                }
+            }
+            error += bestDistance;
+        }
+
+        if (error < bestError)
+        {
+            bestError = error;
+            memcpy(bestQuantized, quantized, sizeof(quantized));
+            memcpy(bestPBits, pBits, sizeof(pBits));
+            memcpy(bestIndices, indices, sizeof(indices));
+        }
+    }
+
+    // 先頭のピクセルの添え字は最上位ビットを省略するので、0～7 になるように端点を入れ替える
+    if (bestIndices[0] & 8)
+    {
+        for (uint32_t c = 0; c < 4; c++) std::swap(bestQuantized[0][c], bestQuantized[1][c]);
+        std::swap(bestPBits[0], bestPBits[1]);
+        for (uint32_t i = 0; i < 16; i++) bestIndices[i] = 15 - bestIndices[i];
+    }
+
+    BitWriter writer(output);
+    writer.Write(1u << 6, 7);
+    for (uint32_t c = 0; c < 4; c++)
+    {
+        writer.Write(bestQuantized[0][c], 7);
+        writer.Write(bestQuantized[1][c], 7);
+    }
+    writer.Write(bestPBits[0], 1);
+    writer.Write(bestPBits[1], 1);
+    writer.Write(bestIndices[0], 3);
+    for (uint32_t i = 1; i < 16; i++)
+    {
+        writer.Write(bestIndices[i], 4);
+    }
+}
+
+
+// 1つのミップレベルを出力するピクセルフォーマットに変換して、末尾に追加する
+static void EncodeImage(const Image& image, CookFormat format, bool hasTransparentPixels, std::vector<uint8_t>& output)
+{
+    if (format == CookFormat::RGBA8)
+    {
+        output.insert(output.end(), image.pixels.begin(), image.pixels.end());
+        return;
+    }
+
+    const uint32_t blockSize = (format == CookFormat::BC1) ? 8 : 16;
+    const uint32_t numBlocksX = std::max((image.width + 3) / 4, 1u);
+    const uint32_t numBlocksY = std::max((image.height + 3) / 4, 1u);
+    size_t offset = output.size();
+    output.resize(offset + (size_t)numBlocksX * numBlocksY * blockSize);
+    for (uint32_t blockY = 0; blockY < numBlocksY; blockY++)
+    {
+        for (uint32_t blockX = 0; blockX < numBlocksX; blockX++, offset += blockSize)
+        {
+            const Block block = LoadBlock(image, blockX, blockY);
+            switch (format)
+            {
+            case CookFormat::BC1:
+                EncodeColorBlock(block, hasTransparentPixels, &output[offset]);
+                break;
+            case CookFormat::BC3:
+                EncodeAlphaBlock(block, &output[offset]);
+                EncodeColorBlock(block, false, &output[offset + 8]);
+                break;
+            default:
+                EncodeBC7Block(block, &output[offset]);
+                break;
+            }
+        }
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------
+// 変換
+//---------------------------------------------------------------------------------------------------------------------------------------------
+
+// ファイル名の接尾辞から出力するピクセルフォーマットを決める (接尾辞が無い場合は Auto を返す)
+static CookFormat GetFormatFromSuffix(const std::filesystem::path& sourcePath)
+{
+    static const std::pair<const char*, CookFormat> Suffixes[] =
+    {
+        { "_bc1", CookFormat::BC1 },
+        { "_bc3", CookFormat::BC3 },
+        { "_bc7", CookFormat::BC7 },
+        { "_d4444", CookFormat::BC3 },
+        { "_d8888", CookFormat::BC7 },
+    };
+
+    std::string stem = sourcePath.stem().string();
+    std::transform(stem.begin(), stem.end(), stem.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+    for (const auto& suffix : Suffixes)
+    {
+        const size_t length = strlen(suffix.first);
+        if (stem.size() >= length && stem.compare(stem.size() - length, length, suffix.first) == 0)
+        {
+            return suffix.second;
+        }
+    }
+    return CookFormat::Auto;
+}
+
+
+static const char* GetFormatName(CookFormat format)
+{
+    switch (format)
+    {
+    case CookFormat::BC1:   return "BC1";
+    case CookFormat::BC3:   return "BC3";
+    case CookFormat::BC7:   return "BC7";
+    case CookFormat::RGBA8: return "RGBA8";
+    default:                return "auto";
+    }
+}
+
+
+// テクスチャリストを読み込む (キーは入力ディレクトリからの相対パス)
+static bool ReadTextureList(const std::filesystem::path& listPath, std::map<std::filesystem::path, CookSettings>& settingsMap)
+{
+    std::ifstream file(listPath);
+    if (!file)
+    {
+        printf("[失敗] テクスチャリストを開けませんでした (%s)\n", listPath.string().c_str());
+        return false;
+    }
+
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+
+        // Visual Studio で保存すると先頭に UTF-8 の BOM が付くので取り除く
+        if ((lineNumber == 1) && (line.compare(0, 3, "\xEF\xBB\xBF") == 0))
+        {
+            line.erase(0, 3);
+        }
+
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+
+        std::istringstream stream(line);
+        std::string path;
+        if (!(stream >> std::quoted(path)))
+        {
+            continue;
+        }
+
+        CookSettings settings = { CookFormat::Auto, false, true };
+        std::string formatName;
+        if (!(stream >> formatName))
+        {
+            printf("[失敗] テクスチャリストの %u 行目の書式が正しくありません\n", lineNumber);
+            return false;
+        }
+        if (formatName == "bc1") settings.format = CookFormat::BC1;
+        else if (formatName == "bc3") settings.format = CookFormat::BC3;
+        else if (formatName == "bc7") settings.format = CookFormat::BC7;
+        else if (formatName == "rgba8") settings.format = CookFormat::RGBA8;
+        else if (formatName != "auto")
+        {
+            printf("[失敗] テクスチャリストの %u 行目: 不明なフォーマット (%s)\n", lineNumber, formatName.c_str());
+            return false;
+        }
+
+        std::string option;
+        while (stream >> option)
+        {
+            if (option == "premultiplied") settings.premultipliedAlpha = true;
+            else if (option == "nomips") settings.generateMips = false;
+            else
+            {
+                printf("[失敗] テクスチャリストの %u 行目: 不明なオプション (%s)\n", lineNumber, option.c_str());
+                return false;
+            }
+        }
+        settingsMap[std::filesystem::path(path).lexically_normal()] = settings;
+    }
+    return true;
+}
+
+
+// キーが一致するDDSファイルが既にある場合は true を返す
+static bool IsUpToDate(const std::filesystem::path& outputPath, uint64_t key)
+{
+    std::ifstream file(outputPath, std::ios::binary);
+    uint32_t magic;
+    DdsHeader header;
+    if (!file.read((char*)&magic, sizeof(magic)) || !file.read((char*)&header, sizeof(header)))
+    {
+        return false;
+    }
+    return (magic == DdsMagic) && (header.reserved1[0] == CookMagic) && (header.reserved1[1] == CookVersion) &&
+        (header.reserved1[2] == (uint32_t)key) && (header.reserved1[3] == (uint32_t)(key >> 32));
+}
+
+
+// 1つのテクスチャを変換してDDSファイルを書き出す
+static CookResult CookTexture(const TextureEntry& entry)
+{
+    std::ifstream file(entry.sourcePath, std::ios::binary);
+    const std::vector<uint8_t> sourceFile((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!file && !file.eof())
+    {
+        std::lock_guard<std::mutex> lock(s_printMutex);
+        printf("[失敗] %s を読み込めませんでした\n", entry.sourcePath.string().c_str());
+        return CookResult::Failed;
+    }
+
+    const uint64_t key = ComputeKey(sourceFile, entry.settings);
+    if (IsUpToDate(entry.outputPath, key))
+    {
+        return CookResult::UpToDate;
+    }
+
+    // デコード
+    Image image;
+    std::string extension = entry.sourcePath.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+    const bool decoded = (extension == ".png") ? DecodePng(sourceFile, image) : DecodeJpeg(sourceFile, image);
+    if (!decoded || image.width == 0 || image.height == 0)
+    {
+        std::lock_guard<std::mutex> lock(s_printMutex);
+        printf("[失敗] %s のデコード\n", entry.sourcePath.string().c_str());
+        return CookResult::Failed;
+    }
+
+    // 出力するピクセルフォーマットを決める
+    const bool hasTransparentPixels = HasTransparentPixels(image);
+    CookFormat format = entry.settings.format;
+    if (format == CookFormat::Auto)
+    {
+        format = GetFormatFromSuffix(entry.sourcePath);
+    }
+    if (format == CookFormat::Auto)
+    {
+        format = hasTransparentPixels ? CookFormat::BC3 : CookFormat::BC1;
+    }
+    if (format != CookFormat::RGBA8 && ((image.width % 4) != 0 || (image.height % 4) != 0))
+    {
+        std::lock_guard<std::mutex> lock(s_printMutex);
+        printf("[警告] %s は %ux%u なのでブロック圧縮できません (RGBA8 で出力します)\n", entry.sourcePath.string().c_str(), image.width, image.height);
+        format = CookFormat::RGBA8;
+    }
+
+    // 乗算済みアルファにしてから縮小すれば、重み付けは要らない
+    const bool premultipliedAlpha = entry.settings.premultipliedAlpha && hasTransparentPixels;
+    if (premultipliedAlpha)
+    {
+        PremultiplyAlpha(image);
+    }
+
+    // ミップマップを作成しながら、各ミップレベルを変換する
+    const uint32_t width = image.width;
+    const uint32_t height = image.height;
+    std::vector<uint8_t> pixelData;
+    uint32_t mipLevels = 1;
+    EncodeImage(image, format, hasTransparentPixels, pixelData);
+    while (entry.settings.generateMips && (image.width > 1 || image.height > 1))
+    {
+        image = Downsample(image, hasTransparentPixels && !premultipliedAlpha);
+        EncodeImage(image, format, hasTransparentPixels, pixelData);
+        mipLevels++;
+    }
+
+    // DDSファイルのヘッダー
+    DdsHeader header;
+    memset(&header, 0, sizeof(header));
+    header.size = sizeof(DdsHeader);
+    header.flags = DdsHeaderFlagsTexture | DdsHeaderFlagsMipMap;
+    header.height = height;
+    header.width = width;
+    header.mipMapCount = mipLevels;
+    header.reserved1[0] = CookMagic;
+    header.reserved1[1] = CookVersion;
+    header.reserved1[2] = (uint32_t)key;
+    header.reserved1[3] = (uint32_t)(key >> 32);
+    header.pixelFormat.size = sizeof(DdsPixelFormat);
+    header.pixelFormat.flags = DdsPixelFormatFourCC;
+    header.pixelFormat.fourCC = DdsFourCCDx10;
+    header.caps = DdsCapsTexture | ((mipLevels > 1) ? DdsCapsMipMap : 0);
+
+    DdsHeaderDx10 headerDx10;
+    memset(&headerDx10, 0, sizeof(headerDx10));
+    headerDx10.resourceDimension = DdsDimensionTexture2D;
+    headerDx10.arraySize = 1;
+    headerDx10.miscFlags2 = !hasTransparentPixels ? DdsAlphaModeOpaque : premultipliedAlpha ? DdsAlphaModePremultiplied : DdsAlphaModeStraight;
+    switch (format)
+    {
+    case CookFormat::BC1:
+        headerDx10.dxgiFormat = DxgiFormatBC1UNorm;
+        header.flags |= DdsHeaderFlagsLinearSize;
+        header.pitchOrLinearSize = (width / 4) * (height / 4) * 8;
+        break;
+    case CookFormat::BC3:
+    case CookFormat::BC7:
+        headerDx10.dxgiFormat = (format == CookFormat::BC3) ? DxgiFormatBC3UNorm : DxgiFormatBC7UNorm;
+        header.flags |= DdsHeaderFlagsLinearSize;
+        header.pitchOrLinearSize = (width / 4) * (height / 4) * 16;
+        break;
+    default:
+        headerDx10.dxgiFormat = DxgiFormatR8G8B8A8UNorm;
+        header.flags |= DdsHeaderFlagsPitch;
+        header.pitchOrLinearSize = width * 4;
+        break;
+    }
+
+    // DDSファイルの書き出し
+    // (途中で失敗したファイルが残らないように、一時ファイルに書き出してから名前を変える)
+    std::error_code errorCode;
+    std::filesystem::create_directories(entry.outputPath.parent_path(), errorCode);
+    std::filesystem::path temporaryPath = entry.outputPath;
+    temporaryPath += ".tmp";
+    bool succeeded;
+    {
+        std::ofstream output(temporaryPath, std::ios::binary);
+        output.write((const char*)&DdsMagic, sizeof(DdsMagic));
+        output.write((const char*)&header, sizeof(header));
+        output.write((const char*)&headerDx10, sizeof(headerDx10));
+        output.write((const char*)pixelData.data(), (std::streamsize)pixelData.size());
+        succeeded = (bool)output;
+    }
+    if (succeeded)
+    {
+        std::filesystem::rename(temporaryPath, entry.outputPath, errorCode);
+        succeeded = !errorCode;
+    }
+
+    std::lock_guard<std::mutex> lock(s_printMutex);
+    if (!succeeded)
+    {
+        std::filesystem::remove(temporaryPath, errorCode);
+        printf("[失敗] %s の書き込み\n", entry.outputPath.string().c_str());
+        return CookResult::Failed;
+    }
+    printf("[成功] %s → %s (%ux%u, %s, ミップ %u 段%s)\n", entry.sourcePath.string().c_str(), entry.outputPath.filename().string().c_str(),
+        width, height, GetFormatName(format), mipLevels, premultipliedAlpha ? ", 乗算済みアルファ" : "");
+    return CookResult::Cooked;
+}
+
+
+// 出力ディレクトリにあるDDSファイルのピクセルデータのバイト数と、同じ画像を R8G8B8A8 (ミップマップ無し) で持つ場合のバイト数を加算する
+static void AccumulateSizes(const std::filesystem::path& outputPath, uint64_t& cookedBytes, uint64_t& uncompressedBytes)
+{
+    std::ifstream file(outputPath, std::ios::binary);
+    uint32_t magic;
+    DdsHeader header;
+    if (!file.read((char*)&magic, sizeof(magic)) || !file.read((char*)&header, sizeof(header)))
+    {
+        return;
+    }
+
+    std::error_code errorCode;
+    const uintmax_t fileSize = std::filesystem::file_size(outputPath, errorCode);
+    const uint64_t headerSize = sizeof(magic) + sizeof(DdsHeader) + sizeof(DdsHeaderDx10);
+    if (!errorCode && fileSize > headerSize)
+    {
+        cookedBytes += fileSize - headerSize;
+        uncompressedBytes += (uint64_t)header.width * header.height * 4;
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> positionalArguments;
+    std::string listPath;
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--list") == 0) && (i + 1 < argc))
+        {
+            listPath = argv[++i];
+        }
+        else
+        {
+            positionalArguments.push_back(argv[i]);
+        }
+    }
+    if (positionalArguments.size() != 2)
+    {
+        printf("使い方: TextureCooker <入力ディレクトリ> <出力ディレクトリ> [--list <テクスチャリスト>]\n");
+        return 1;
+    }
+    const std::filesystem::path inputDirectory = positionalArguments[0];
+    const std::filesystem::path outputDirectory = positionalArguments[1];
+
+    std::map<std::filesystem::path, CookSettings> settingsMap;
+    if (!listPath.empty() && !ReadTextureList(listPath, settingsMap))
+    {
+        return 1;
+    }
+
+    // 入力ディレクトリ以下の画像ファイルを集める (並び順を固定する為にパスで並べ替える)
+    std::vector<TextureEntry> entries;
+    std::error_code errorCode;
+    for (auto iterator = std::filesystem::recursive_directory_iterator(inputDirectory, errorCode); !errorCode && iterator != std::filesystem::recursive_directory_iterator(); iterator.increment(errorCode))
+    {
+        if (!iterator->is_regular_file())
+        {
+            continue;
+        }
+
+        std::string extension = iterator->path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+        if (extension != ".png" && extension != ".jpg" && extension != ".jpeg")
+        {
+            continue;
+        }
+
+        const std::filesystem::path relativePath = iterator->path().lexically_relative(inputDirectory).lexically_normal();
+        TextureEntry entry;
+        entry.sourcePath = iterator->path();
+        entry.outputPath = (outputDirectory / relativePath).replace_extension(".dds");
+        const auto settings = settingsMap.find(relativePath);
+        entry.settings = (settings != settingsMap.end()) ? settings->second : CookSettings{ CookFormat::Auto, false, true };
+        entries.push_back(entry);
+    }
+    if (errorCode)
+    {
+        printf("[失敗] 入力ディレクトリを読み込めませんでした (%s)\n", inputDirectory.string().c_str());
+        return 1;
+    }
+    std::sort(entries.begin(), entries.end(), [](const TextureEntry& a, const TextureEntry& b) { return a.sourcePath < b.sourcePath; });
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    // 論理コア数と同じ数のスレッドで、先頭から順番に取り出して処理する
+    std::atomic<uint32_t> nextIndex(0);
+    std::atomic<uint32_t> numCooked(0);
+    std::atomic<uint32_t> numUpToDate(0);
+    std::atomic<uint32_t> numFailed(0);
+    auto worker = [&]()
+    {
+        for (uint32_t i = nextIndex++; i < entries.size(); i = nextIndex++)
+        {
+            switch (CookTexture(entries[i]))
+            {
+            case CookResult::UpToDate:  numUpToDate++; break;
+            case CookResult::Cooked:    numCooked++; break;
+            case CookResult::Failed:    numFailed++; break;
+            }
+        }
+    };
+
+    uint32_t numThreads = std::thread::hardware_concurrency();
+    if (numThreads == 0)
+    {
+        numThreads = 1;
+    }
+    if (numThreads > entries.size())
+    {
+        numThreads = std::max((uint32_t)entries.size(), 1u);
+    }
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < numThreads; i++)
+    {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    // 変換済みのテクスチャ全体で、無圧縮(ミップマップ無し)と比べたサイズ
+    uint64_t cookedBytes = 0;
+    uint64_t uncompressedBytes = 0;
+    for (const TextureEntry& entry : entries)
+    {
+        AccumulateSizes(entry.outputPath, cookedBytes, uncompressedBytes);
+    }
+
+    printf("[情報] 変換 %u 個 / 最新 %u 個 / 失敗 %u 個 (%u スレッド, %.2f ms)\n",
+        numCooked.load(), numUpToDate.load(), numFailed.load(), numThreads, milliseconds);
+    printf("[情報] ピクセルデータ %.2f MB (ミップマップ込み) / RGBA8 なら %.2f MB (ミップマップ無し)\n",
+        cookedBytes / (1024.0 * 1024.0), uncompressedBytes / (1024.0 * 1024.0));
+    return (numFailed > 0) ? 1 : 0;
+}